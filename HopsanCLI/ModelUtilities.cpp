@@ -30,6 +30,8 @@
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <iomanip>
+#include <limits>
 
 #include "ModelUtilities.h"
 #include "version_cli.h"
@@ -37,6 +39,9 @@
 
 #include "HopsanEssentials.h"
 #include "HopsanTypes.h"
+#include "HopsanCoreMacros.h"
+#include "CoreUtilities/SweepRunner.h"
+#include "CoreUtilities/SignalAnalysis.h"
 
 #ifdef USEHDF5
 #include "hopsanhdf5exporter.h"
@@ -439,6 +444,184 @@ hopsan::Port* getPortWithFullName(hopsan::ComponentSystem *pRootSystem, const st
     return nullptr;
 }
 
+//! @brief Create a log sink for streaming results during simulation, the format is selected by file extension
+//! @param [in] rFileName The file to stream to, .csv gives CSV, .h5 or .hdf5 gives HDF5 and anything else raw binary
+//! @param [in] rModelName The model name, stored as meta data in HDF5 files
+//! @returns A new log sink (owned by the caller) or nullptr if the format is not supported
+hopsan::LogSink *createResultsStreamSink(const std::string &rFileName, const std::string &rModelName)
+{
+    std::string ext;
+    const size_t dotPos = rFileName.rfind('.');
+    if (dotPos != std::string::npos) {
+        ext = rFileName.substr(dotPos+1);
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    }
+
+    if (ext == "csv") {
+        return new hopsan::CSVLogSink(rFileName.c_str());
+    }
+    else if (ext == "h5" || ext == "hdf5") {
+#ifdef USEHDF5
+        return new HopsanHDF5StreamWriter(rFileName.c_str(), rModelName.c_str(), std::string("HopsanCLI "+std::string(HOPSANCLIVERSION)).c_str());
+#else
+        printErrorMessage("HopsanCLI was built without HDF5 support");
+        return nullptr;
+#endif
+    }
+    HOPSAN_UNUSED(rModelName)
+    return new hopsan::RawLogSink(rFileName.c_str());
+}
+
+//! @brief Save the simulation profile of a system, the format is selected by file extension
+//! @param [in] pRootSystem The system to save the profile of, profiling must have been enabled before simulation
+//! @param [in] rFileName The file to save to, .json gives a JSON hierarchy, anything else a CSV file with folded stack paths
+//! @returns True if the file was written successfully
+bool saveProfileReport(const hopsan::ComponentSystem *pRootSystem, const std::string &rFileName)
+{
+    std::string ext;
+    const size_t dotPos = rFileName.rfind('.');
+    if (dotPos != std::string::npos) {
+        ext = rFileName.substr(dotPos+1);
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    }
+
+    std::ofstream file(rFileName.c_str());
+    if (!file.good()) {
+        printErrorMessage("Could not open: "+rFileName+" for writing");
+        return false;
+    }
+
+    const hopsan::ProfileEntry report = pRootSystem->getProfileReport();
+    if (ext == "json") {
+        file << hopsan::profileReportToJSON(report).c_str();
+    }
+    else {
+        file << hopsan::profileReportToCSV(report).c_str();
+    }
+    return file.good();
+}
+
+//! @brief Simulate all parameter cases in a CSV file, and save the final values of the requested variables
+//! @param [in] pHopsanEssentials The HopsanEssentials object to load the model with
+//! @param [in] rModelFile The model file
+//! @param [in] rParameterFile CSV file with parameter names on the first row and one case per following row
+//! @param [in] rVariables The full names of the variables to save
+//! @param [in] rResultsFile The CSV file to save results to, one row per case
+//! @param [in] rSimulationTime Simulation time as [hmf] or [start,ts,stop] or [ts,stop] or [stop], empty means use the model
+//! @param [in] numLogSamples Number of log samples, 0 means use the model
+//! @param [in] nThreads Number of worker threads, 0 means auto-detect
+//! @returns True if the sweep could be run and the results saved, even if some cases failed
+bool runParameterSweep(hopsan::HopsanEssentials *pHopsanEssentials, const std::string &rModelFile, const std::string &rParameterFile,
+                       const std::vector<std::string> &rVariables, const std::string &rResultsFile, const std::string &rSimulationTime,
+                       const size_t numLogSamples, const size_t nThreads)
+{
+    hopsan::SweepRunner sweep(pHopsanEssentials);
+    if (!sweep.loadModel(rModelFile.c_str())) {
+        printErrorMessage(sweep.getLastError().c_str());
+        return false;
+    }
+    if (!sweep.loadParameterTable(rParameterFile.c_str())) {
+        printErrorMessage(sweep.getLastError().c_str());
+        return false;
+    }
+
+    if (!rSimulationTime.empty() && rSimulationTime != "hmf") {
+        vector<string> simTime;
+        splitStringOnDelimiter(rSimulationTime, ',', simTime);
+        double startTime=0, timeStep=0, stopTime=0;
+        if (simTime.size() == 3) {
+            startTime = atof(simTime[0].c_str());
+            timeStep = atof(simTime[1].c_str());
+            stopTime = atof(simTime[2].c_str());
+        }
+        else if (simTime.size() == 2) {
+            timeStep = atof(simTime[0].c_str());
+            stopTime = atof(simTime[1].c_str());
+        }
+        else if (simTime.size() == 1) {
+            stopTime = atof(simTime[0].c_str());
+        }
+        sweep.setSimulationTime(startTime, timeStep, stopTime);
+    }
+    sweep.setNumLogSamples(numLogSamples);
+    sweep.setKeepTimeSeries(false);
+
+    std::vector<hopsan::HString> variables;
+    for (size_t v=0; v<rVariables.size(); ++v) {
+        variables.push_back(rVariables[v].c_str());
+    }
+    sweep.setResultVariables(variables);
+
+    cout << "Running parameter sweep with " << sweep.getNumCases() << " cases" << endl;
+    if (!sweep.run(nThreads)) {
+        printErrorMessage(sweep.getLastError().c_str());
+        return false;
+    }
+    if (sweep.getNumFailedCases() > 0) {
+        printWarningMessage(to_string(sweep.getNumFailedCases())+" of "+to_string(sweep.getNumCases())+" cases failed");
+    }
+
+    std::ofstream file(rResultsFile.c_str());
+    if (!file.good()) {
+        printErrorMessage("Could not open: "+rResultsFile+" for writing");
+        return false;
+    }
+    file << "case";
+    for (size_t p=0; p<sweep.getParameterNames().size(); ++p) {
+        file << "," << sweep.getParameterNames()[p].c_str();
+    }
+    for (size_t v=0; v<rVariables.size(); ++v) {
+        file << "," << rVariables[v];
+    }
+    file << ",status" << endl;
+    file << std::scientific << std::setprecision(std::numeric_limits<double>::digits10+1);
+    for (size_t c=0; c<sweep.getNumCases(); ++c) {
+        const hopsan::SweepCaseResult &rResult = sweep.getResult(c);
+        file << c;
+        for (size_t p=0; p<sweep.getCaseValues(c).size(); ++p) {
+            file << "," << sweep.getCaseValues(c)[p].c_str();
+        }
+        for (size_t v=0; v<rVariables.size(); ++v) {
+            file << ",";
+            if (rResult.success && !rResult.values[v].empty()) {
+                file << rResult.values[v].back();
+            }
+        }
+        file << "," << (rResult.success ? "ok" : "\"failed: "+std::string(rResult.errorMessage.c_str())+"\"") << endl;
+    }
+    return file.good();
+}
+
+//! @brief Translate a parallel algorithm name to the corresponding core enum
+//! @param [in] rName Algorithm name (apriori, taskpool, taskstealing, forkjoin, clusteredforkjoin or hybridbarrier)
+//! @param [out] rAlgorithm The parsed algorithm
+//! @returns True if the name was recognized, else false
+bool parseParallelAlgorithm(const std::string &rName, hopsan::ParallelAlgorithmT &rAlgorithm)
+{
+    if (rName == "apriori") {
+        rAlgorithm = hopsan::APrioriScheduling;
+    }
+    else if (rName == "taskpool") {
+        rAlgorithm = hopsan::TaskPoolAlgorithm;
+    }
+    else if (rName == "taskstealing") {
+        rAlgorithm = hopsan::TaskStealingAlgorithm;
+    }
+    else if (rName == "forkjoin") {
+        rAlgorithm = hopsan::ForkJoinAlgorithm;
+    }
+    else if (rName == "clusteredforkjoin") {
+        rAlgorithm = hopsan::ClusteredForkJoinAlgorithm;
+    }
+    else if (rName == "hybridbarrier") {
+        rAlgorithm = hopsan::APrioriHybridBarrierScheduling;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
 
 //! @brief Save results to HDF5 format
 //! @param [in] pRootSystem Pointer to component system
@@ -470,18 +653,20 @@ void saveResultsToHDF5(ComponentSystem *pRootSystem, const string &rFileName, co
     };
 
     auto addVariable = [&exporter, howMany](const ComponentSystem* pSystem, const Component* pComponent, const Port* pPort, size_t variableIndex) {
-        const vector< vector<double> > *pLogData = pPort->getLogDataVectorPtr();
+        const vector<double> *pLogData = pPort->getLogDataVariablePtr(variableIndex);
+        const size_t decimation = pPort->getLogDataDecimation(variableIndex);
         const size_t numLoggedSamples = pSystem->getNumActuallyLoggedSamples();
         if( (pLogData != nullptr) && !pLogData->empty() && (numLoggedSamples > 0)) {
+            // Decimated variables are held constant between their samples to match the time vector
             HVector<double> dataVector;
             if(howMany == Full) {
                 dataVector.reserve(numLoggedSamples);
                 for (size_t t=0; t < numLoggedSamples; ++t) {
-                    dataVector.append((*pLogData)[t][variableIndex]);
+                    dataVector.append((*pLogData)[t/decimation]);
                 }
             }
             else {
-                dataVector.append((*pLogData)[numLoggedSamples-1][variableIndex]);
+                dataVector.append((*pLogData)[(numLoggedSamples-1)/decimation]);
             }
 
             HString parentSystemNames = generateFullSubSystemHierarchyName(pSystem,".", false);
@@ -536,7 +721,8 @@ void saveResultsToCSV(ComponentSystem *pRootSystem, const string &rFileName, con
 
             auto addVariable = [&outfile, howMany](const ComponentSystem* pSystem, const Component* pComponent, const Port* pPort, size_t variableIndex) {
                 const NodeDataDescription& variable = *pPort->getNodeDataDescription(variableIndex);
-                const vector< vector<double> > *pLogData = pPort->getLogDataVectorPtr();
+                const vector<double> *pLogData = pPort->getLogDataVariablePtr(variableIndex);
+                const size_t decimation = pPort->getLogDataDecimation(variableIndex);
                 if( (pLogData != nullptr) && !pLogData->empty()) {
                     const HString fullVarName = generateFullSubSystemHierarchyName(pSystem,"$") + pComponent->getName() + "#" + pPort->getName() + "#" + variable.name;
                     if (howMany == Final) {
@@ -545,15 +731,12 @@ void saveResultsToCSV(ComponentSystem *pRootSystem, const string &rFileName, con
                     }
                     else if (howMany == Full)
                     {
-                        // Only write something if data has been logged (skip ports that are not logged)
-                        // We assume that the data vector has been cleared
-                        if (pPort->getLogDataVectorPtr()->size() > 0) {
-                            outfile << fullVarName.c_str() << "," << pPort->getVariableAlias(variableIndex).c_str() << "," << variable.unit.c_str();
-                            for (size_t t=0; t<pSystem->getNumActuallyLoggedSamples(); ++t) {
-                                outfile << "," << std::scientific << (*pLogData)[t][variableIndex];
-                            }
-                            outfile << endl;
+                        // Decimated variables are held constant between their samples to match the time vector
+                        outfile << fullVarName.c_str() << "," << pPort->getVariableAlias(variableIndex).c_str() << "," << variable.unit.c_str();
+                        for (size_t t=0; t<pSystem->getNumActuallyLoggedSamples(); ++t) {
+                            outfile << "," << std::scientific << (*pLogData)[t/decimation];
                         }
+                        outfile << endl;
                     }
                 }
             };
@@ -569,4 +752,79 @@ void saveResultsToCSV(ComponentSystem *pRootSystem, const string &rFileName, con
     }
 }
 
+//! @brief Save the power spectral density of logged results to CSV, one row per variable preceded by a frequency row per system
+//! @param [in] pRootSystem Pointer to component system
+//! @param [in] rFileName File name for output file
+//! @param [in] includeFilter list of full port names or variables names to include (excluding all others)
+//! @param [in] segmentLength Number of samples per Welch segment (with half overlap), 0 means that all logged samples are used as one segment
+void saveSpectraToCSV(ComponentSystem *pRootSystem, const string &rFileName, const std::vector<string>& includeFilter, const size_t segmentLength)
+{
+    if (pRootSystem)
+    {
+        ofstream outfile;
+        outfile.open(rFileName.c_str());
+        if (outfile.good()) {
+            SpectrumAnalyzer analyzer;
+            analyzer.setSegmentLength(segmentLength, segmentLength/2);
+            analyzer.setRemoveMean(true);
+            vector<double> frequency, spectrum, data;
+
+            // Logged samples are equidistant in time
+            auto sampleFrequency = [](ComponentSystem* pSystem) {
+                const vector<double> *pLogTimeVector = pSystem->getLogTimeVector();
+                const size_t numLoggedSamples = pSystem->getNumActuallyLoggedSamples();
+                if (numLoggedSamples < 2) {
+                    return 0.0;
+                }
+                return double(numLoggedSamples-1)/((*pLogTimeVector)[numLoggedSamples-1]-(*pLogTimeVector)[0]);
+            };
+
+            auto addFrequencyVariable = [&](ComponentSystem* pSystem) {
+                const size_t numLoggedSamples = pSystem->getNumActuallyLoggedSamples();
+                if (numLoggedSamples > 1) {
+                    // The frequencies only depend on the number of samples and the sample frequency
+                    if (analyzer.frequencies(numLoggedSamples, sampleFrequency(pSystem), frequency)) {
+                        outfile << generateFullSubSystemHierarchyName(pSystem,"$").c_str() << "Frequency,,Hz";
+                        for (size_t k=0; k<frequency.size(); ++k) {
+                            outfile << "," << std::scientific << frequency[k];
+                        }
+                        outfile << endl;
+                    }
+                }
+            };
+
+            auto addVariable = [&](const ComponentSystem* pSystem, const Component* pComponent, const Port* pPort, size_t variableIndex) {
+                const NodeDataDescription& variable = *pPort->getNodeDataDescription(variableIndex);
+                const vector<double> *pLogData = pPort->getLogDataVariablePtr(variableIndex);
+                const size_t decimation = pPort->getLogDataDecimation(variableIndex);
+                const size_t numLoggedSamples = pSystem->getNumActuallyLoggedSamples();
+                if( (pLogData != nullptr) && !pLogData->empty() && (numLoggedSamples > 1)) {
+                    // Decimated variables are held constant between their samples to match the time vector
+                    data.resize(numLoggedSamples);
+                    for (size_t t=0; t<numLoggedSamples; ++t) {
+                        data[t] = (*pLogData)[t/decimation];
+                    }
+                    if (!analyzer.spectrum(data, sampleFrequency(pComponent->getSystemParent()), SpectrumAnalyzer::PowerSpectralDensity, frequency, spectrum)) {
+                        printErrorMessage(string("Could not compute the spectrum: ")+analyzer.getLastError().c_str());
+                        return;
+                    }
+                    const HString fullVarName = generateFullSubSystemHierarchyName(pSystem,"$") + pComponent->getName() + "#" + pPort->getName() + "#" + variable.name;
+                    outfile << fullVarName.c_str() << "," << pPort->getVariableAlias(variableIndex).c_str() << ",(" << variable.unit.c_str() << ")^2/Hz";
+                    for (size_t k=0; k<spectrum.size(); ++k) {
+                        outfile << "," << std::scientific << spectrum[k];
+                    }
+                    outfile << endl;
+                }
+            };
+
+            saveResultsTo(pRootSystem, includeFilter, addFrequencyVariable, addVariable);
+        }
+        else {
+            printErrorMessage("Could not open: " + rFileName + " for writing!");
+        }
+
+        outfile.close();
+    }
+}
+
 
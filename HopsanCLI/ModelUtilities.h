@@ -35,6 +35,7 @@
 #include <vector>
 #include "core_cli.h"
 #include "HopsanEssentials.h"
+#include "CoreUtilities/LogSink.h"
 
 void printTsInfo(const hopsan::ComponentSystem* pSystem);
 void printSystemParams(hopsan::ComponentSystem* pSystem);
@@ -46,6 +47,7 @@ void printComponentHierarchy(hopsan::ComponentSystem *pSystem, std::string prefi
 enum SaveResults {Final, Full};
 void saveResultsToCSV(hopsan::ComponentSystem *pRootSystem, const std::string &rFileName, const SaveResults howMany, const std::vector<std::string>& includeFilter);
 void saveResultsToHDF5(hopsan::ComponentSystem *pRootSystem, const std::string &rFileName, const std::vector<std::string>& includeFilter, const SaveResults howMany);
+void saveSpectraToCSV(hopsan::ComponentSystem *pRootSystem, const std::string &rFileName, const std::vector<std::string>& includeFilter, const size_t segmentLength);
 
 void transposeCSVresults(const std::string &rFileName);
 void exportParameterValuesToCSV(const std::string &rFileName, hopsan::ComponentSystem* pSystem, std::string prefix="", std::ofstream *pFile=0);
@@ -62,6 +64,12 @@ hopsan::HString generateFullPortVariableName(const hopsan::Port *pPort, const si
 
 hopsan::Component *getComponentWithFullName(hopsan::ComponentSystem *pRootSystem, const std::string &fullComponentName);
 hopsan::Port* getPortWithFullName(hopsan::ComponentSystem *pRootSystem, const std::string &fullPortName);
+bool parseParallelAlgorithm(const std::string &rName, hopsan::ParallelAlgorithmT &rAlgorithm);
+hopsan::LogSink *createResultsStreamSink(const std::string &rFileName, const std::string &rModelName);
+bool saveProfileReport(const hopsan::ComponentSystem *pRootSystem, const std::string &rFileName);
+bool runParameterSweep(hopsan::HopsanEssentials *pHopsanEssentials, const std::string &rModelFile, const std::string &rParameterFile,
+                       const std::vector<std::string> &rVariables, const std::string &rResultsFile, const std::string &rSimulationTime,
+                       const size_t numLogSamples, const size_t nThreads);
 
 
 // ===== Template Help Function =====
@@ -123,7 +131,7 @@ void saveResultsTo(hopsan::ComponentSystem *pCurrentSystem, const std::vector<st
                     const hopsan::NodeDataDescription* pVariable = &pVariables->at(v);
 
                     // Create data vector
-                    const std::vector< std::vector<double> > *pLogData = pPort->getLogDataVectorPtr();
+                    const std::vector<double> *pLogData = pPort->getLogDataVariablePtr(v);
                     if(pLogData == nullptr || pLogData->empty()) {
                         continue;
                     }
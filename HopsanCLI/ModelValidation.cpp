@@ -118,16 +118,23 @@ bool exportHVCData(const string modelpath, const string baseFilePath, const std:
             std::string fullName = generateFullPortVariableName(rPorts[p], rDataIds[p]).c_str();
             writeStringAttribute(pVariableNode, "name", fullName );
 
+            // The time and data rows only contain the actually logged samples
+            const size_t nRows = rPorts[p]->getComponent()->getSystemParent()->getNumActuallyLoggedSamples();
+            if (nRows == 0)
+            {
+                continue;
+            }
+
             // Lookup if timevector has already been write to file, and at what row, if not then write and remember the row
             std::vector<double> *pLogTime = rPorts[p]->getLogTimeVectorPtr();
             if (savedTimeVectors.count(pLogTime) == 0)
             {
                 // Write time vector
-                for (size_t i=0; i<pLogTime->size()-1; ++i)
+                for (size_t i=0; i<nRows-1; ++i)
                 {
                     csvFile << std::scientific << (*pLogTime)[i] << ", ";
                 }
-                csvFile << std::scientific << (*pLogTime)[pLogTime->size()-1] << std::endl;
+                csvFile << std::scientific << (*pLogTime)[nRows-1] << std::endl;
                 csvTimeRow = csvRow;
                 savedTimeVectors.insert(std::pair<vector<double>*, size_t>(pLogTime, csvTimeRow));
                 ++csvRow;
@@ -142,21 +149,16 @@ bool exportHVCData(const string modelpath, const string baseFilePath, const std:
             appendValueNode(pVariableNode, "tolerance", to_string(tol));
 
             // Write data line to csv
-            std::vector< std::vector<double> > *pLogData = rPorts[p]->getLogDataVectorPtr();
+            const std::vector<double> *pLogData = rPorts[p]->getLogDataVariablePtr(rDataIds[p]);
             if (pLogData &&  pLogData->size() > 0)
             {
-                size_t nRows = pLogData->size();
-                size_t nCols = pLogData->front().size();
-                const size_t c = rDataIds[p];
-                if (rDataIds[p] < nCols)
+                const size_t decimation = rPorts[p]->getLogDataDecimation(rDataIds[p]);
+                for (size_t r=0; r<nRows-1; ++r)
                 {
-                    for (size_t r=0; r<nRows-1; ++r)
-                    {
-                        csvFile << std::scientific << (*pLogData)[r][c] << ", ";
-                    }
-                    csvFile << std::scientific << (*pLogData)[nRows-1][c] << std::endl;
-                    ++csvRow;
+                    csvFile << std::scientific << (*pLogData)[r/decimation] << ", ";
                 }
+                csvFile << std::scientific << (*pLogData)[(nRows-1)/decimation] << std::endl;
+                ++csvRow;
             }
         }
 
@@ -306,11 +308,17 @@ bool extractTestData(ComponentSystem *pRootSystem, string fullVarName, std::vect
         printErrorMessage("No such varaiable name: " + varName + " in: " + pPort->getNodeType().c_str());
         return false;
     }
-    vector< vector<double> > *pLogData = pPort->getLogDataVectorPtr();
+    const vector<double> *pLogData = pPort->getLogDataVariablePtr(dataId);
+    if (!pLogData)
+    {
+        printErrorMessage("Varaiable: " + varName + " has not been logged");
+        return false;
+    }
+    const size_t decimation = pPort->getLogDataDecimation(dataId);
     rvSim.reserve(rvTime.size());
     for(size_t i=0; i<rvTime.size(); ++i)
     {
-        rvSim.push_back(pLogData->at(i).at(dataId));
+        rvSim.push_back(pLogData->at(i/decimation));
     }
     return true;
 }
@@ -492,9 +500,18 @@ bool performModelTest(const std::string hvcFilePath)
                                     return false;
                                 }
 
+                                const std::vector<double> *pLogData = pPort->getLogDataVariablePtr(dataId);
+                                if (!pLogData)
+                                {
+                                    printErrorMessage("Variable: " + varname + " in: " + compName + "#" + portName + " is not logged");
+                                    return false;
+                                }
+                                // Decimated variables are held constant between their samples to match the time vector
+                                const size_t decimation = pPort->getLogDataDecimation(dataId);
+                                vTime.resize(pRootSystem->getNumActuallyLoggedSamples());
                                 for(size_t i=0; i<vTime.size(); ++i)
                                 {
-                                    vSim1.push_back(pRootSystem->getSubComponent(compName.c_str())->getPort(portName.c_str())->getLogDataVectorPtr()->at(i).at(dataId));
+                                    vSim1.push_back((*pLogData)[i/decimation]);
                                 }
 
                                 //Second simulation
@@ -510,9 +527,10 @@ bool performModelTest(const std::string hvcFilePath)
                                 }
                                 pRootSystem->finalize();
 
+                                pLogData = pPort->getLogDataVariablePtr(dataId);
                                 for(size_t i=0; i<vTime.size(); ++i)
                                 {
-                                    vSim2.push_back(pRootSystem->getSubComponent(compName.c_str())->getPort(portName.c_str())->getLogDataVectorPtr()->at(i).at(dataId));
+                                    vSim2.push_back((*pLogData)[i/decimation]);
                                 }
 
                                 // Print the messages if there were any errors or warnings
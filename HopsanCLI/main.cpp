@@ -31,6 +31,9 @@
 #include <string>
 #include <vector>
 #include <fstream>
+#include <ctime>
+#include <set>
+#include <memory>
 
 #include <tclap/CmdLine.h>
 
@@ -40,6 +43,7 @@
 #include "TicToc.hpp"
 #include "version_cli.h"
 #include "CoreUtilities/SaveRestoreSimulationPoint.h"
+#include "CoreUtilities/MultiThreadingUtilities.h"
 
 #include "CliUtilities.h"
 #include "ModelValidation.h"
@@ -48,6 +52,7 @@
 #ifdef USEOPS
 #include "OpsWorker.h"
 #include "OpsEvaluator.h"
+#include "OpsAsyncEvaluator.h"
 #include "OpsMessageHandler.h"
 #include "OpsWorkerNelderMead.h"
 #include "OpsWorkerComplexRF.h"
@@ -110,7 +115,7 @@ private:
     bool mSilent;
 };
 
-class OptimizationEvaluator : public Ops::Evaluator
+class OptimizationEvaluator : public Ops::AsyncEvaluator
 {
 public:
     OptimizationEvaluator(vector<ComponentSystem *> rootSystemPtrs,
@@ -122,6 +127,7 @@ public:
                           vector<double> parMax,
                           double startTime,
                           double stopTime)
+        : Ops::AsyncEvaluator(rootSystemPtrs.size())
     {
         mRootSystemPtrs = rootSystemPtrs;
         mParNames = parNames;
@@ -130,93 +136,59 @@ public:
         mObjWeights = objWeights;
         mParMin = parMin;
         mParMax = parMax;
-        mEvaulationCounter = 0;
         mStartTime = startTime;
         mStopTime = stopTime;
-    }
 
-    //! @todo Make evaluateAll... work in parallel
+        // Resolve the parameters once, so that setting them does not require any string parsing
+        mParameterHandles.resize(mRootSystemPtrs.size());
+        for(size_t m=0; m<mRootSystemPtrs.size(); ++m)
+        {
+            for(size_t i=0; i<mParNames.size(); ++i)
+            {
+                mParameterHandles[m].push_back(mRootSystemPtrs[m]->getParameterHandle(HString(mParNames[i].c_str())));
+            }
+        }
+    }
 
-    //void evaluateAllPoints();
-    void evaluateCandidate(size_t idx)
+protected:
+    //! @brief Simulates one candidate using one of the pre-loaded model copies
+    void evaluateCandidateWithModel(size_t idx, size_t modelIdx)
     {
+        ComponentSystem *pSystem = mRootSystemPtrs.at(modelIdx);
         for(size_t i=0; i<mpWorker->getNumberOfParameters(); ++i)
         {
             double par = mpWorker->getCandidateParameter(idx, i);
-            if(!mRootSystemPtrs.at(0)->setParameterValue(HString(mParNames[i].c_str()), HString(std::to_string(par).c_str())))
+            ParameterHandle &rHandle = mParameterHandles[modelIdx][i];
+            if(rHandle.isValid() ? !rHandle.set(par) : !pSystem->setParameterValue(HString(mParNames[i].c_str()), HString(std::to_string(par).c_str())))
             {
                 cout << "Error: Parameter " << mParNames[i] << " not found in model." << endl;
             }
         }
 
-        mRootSystemPtrs.at(0)->initialize(mStartTime,mStopTime);
-        mRootSystemPtrs.at(0)->simulate(mStopTime);
+        pSystem->initialize(mStartTime,mStopTime);
+        pSystem->simulate(mStopTime);
 
         double obj = 0.0;
         for(size_t i=0; i<mObjComps.size(); ++i)
         {
             int portId = 0;
-            Component *pComp = mRootSystemPtrs.at(0)->getSubComponent(mObjComps[i].c_str());
+            Component *pComp = pSystem->getSubComponent(mObjComps[i].c_str());
             Port *pPort = pComp->getPort(mObjPorts[i].c_str());
             double data = *pPort->getNodeDataPtr(portId);
             obj += mObjWeights[i]*data;
         }
         mpWorker->setCandidateObjectiveValue(idx, obj);
-
-        ++mEvaulationCounter;
     }
 
-    void evaluateAllCandidates()
-    {
-        for(size_t c=0; c<mpWorker->getNumberOfCandidates(); ++c)
-        {
-            for(size_t i=0; i<mpWorker->getNumberOfParameters(); ++i)
-            {
-                double par = mpWorker->getCandidateParameter(c, i);
-                if(!mRootSystemPtrs.at(c)->setParameterValue(HString(mParNames[i].c_str()), HString(std::to_string(par).c_str())))
-                {
-                    cout << "Error: Parameter " << mParNames[i] << " not found in model." << endl;
-                }
-            }
-        }
-
-        int  threads = mpWorker->getNumberOfCandidates();
-        if(threads == 1)
-        {
-            threads = -1;
-        }
-
-        gHopsanCore.getSimulationHandler()->initializeSystem(mStartTime,mStopTime,mRootSystemPtrs);
-        gHopsanCore.getSimulationHandler()->simulateSystem(mStartTime,mStopTime,threads,mRootSystemPtrs);
-
-        for(size_t c=0; c<mpWorker->getNumberOfCandidates(); ++c)
-        {
-            double obj = 0.0;
-            for(size_t i=0; i<mObjComps.size(); ++i)
-            {
-                int portId = 0;
-                Component *pComp = mRootSystemPtrs.at(c)->getSubComponent(mObjComps[i].c_str());
-                Port *pPort = pComp->getPort(mObjPorts[i].c_str());
-                double data = *pPort->getNodeDataPtr(portId);
-                obj += mObjWeights[i]*data;
-            }
-            mpWorker->setCandidateObjectiveValue(c, obj);
-            ++mEvaulationCounter;
-        }
-    }
-
-    size_t getNumberOfEvaluations() { return mEvaulationCounter; }
-
-    //void evaluateAllCandidates();
 private:
     vector<ComponentSystem *> mRootSystemPtrs;
+    vector<vector<ParameterHandle> > mParameterHandles;
     vector<string> mParNames;
     vector<string> mObjComps;
     vector<string> mObjPorts;
     vector<double> mObjWeights;
     vector<double> mParMin;
     vector<double> mParMax;
-    size_t mEvaulationCounter;
     double mStartTime;
     double mStopTime;
 };
@@ -246,15 +218,25 @@ int main(int argc, char *argv[])
         TCLAP::ValueArg<std::string> resultsCSVSortOption("", "resultsCSVSort", "Export results in columns or in rows: [rows, cols]", false, "rows", "string", cmd);
         TCLAP::ValueArg<std::string> resultsFinalCSVOption("", "resultsFinalCSV", "Export the results (only final values)", false, "", "Path to file", cmd);
         TCLAP::ValueArg<std::string> resultsFullCSVOption("", "resultsFullCSV", "Export the results (all logged data) to CSV", false, "", "Path to file", cmd);
+        TCLAP::ValueArg<std::string> resultsSpectrumCSVOption("", "resultsSpectrumCSV", "Export the power spectral density of the results (all logged data) to CSV", false, "", "Path to file", cmd);
+        TCLAP::ValueArg<std::string> spectrumSegmentOption("", "spectrumSegment", "Number of log samples per segment in the spectrum estimation with --resultsSpectrumCSV, segments overlap by half. 0 means all samples in one segment", false, "0", "integer", cmd);
         TCLAP::ValueArg<std::string> resultsFinalHDF5Option("", "resultsFinalHDF5", "Exeport the results (only final values) to HDF5", false, "", "Path to file", cmd);
         TCLAP::ValueArg<std::string> resultsFullHDF5Option("", "resultsFullHDF5", "Exeport the results (all logged data) to HDF5", false, "", "Path to file", cmd);
+        TCLAP::ValueArg<std::string> profileOption("", "profile", "Profile the simulation and save the time spent in each component (hierarchically) to file. Format by extension: .json or .csv (folded stack paths)", false, "", "Path to file", cmd);
+        TCLAP::ValueArg<std::string> resultsStreamOption("", "resultsStream", "Stream the results (all logged data) to file during simulation, keeping memory usage bounded. Format by extension: .csv, .h5/.hdf5 or raw binary", false, "", "Path to file", cmd);
         TCLAP::ValueArg<std::string> parameterExportOption("", "parameterExport", "CSV file with exported parameter values", false, "", "Path to file", cmd);
+        TCLAP::ValueArg<std::string> sweepOption("", "sweep", "Run a parameter sweep on the model given by -m. CSV file with full parameter names on the first row and one case per following row. Cases are run in parallel with the number of threads given by -p", false, "", "Path to file", cmd);
+        TCLAP::ValueArg<std::string> sweepVariablesOption("", "sweepVariables", "Variables to save the final values of in a parameter sweep. Can be a file (one full variable name per line) or coma separated list.", false, "", "string", cmd);
+        TCLAP::ValueArg<std::string> sweepResultsOption("", "sweepResults", "CSV file for the parameter sweep results, one row per case", false, "sweep_results.csv", "Path to file", cmd);
         TCLAP::ValueArg<std::string> parameterImportOption("", "parameterImport", "CSV file with parameter values to import", false, "", "Path to file", cmd);
         TCLAP::ValueArg<std::string> hvcTestOption("t","validate","Perform model validation based on HopsanValidationConfiguration",false,"","Path to .hvc file", cmd);
         TCLAP::ValueArg<std::string> nLogSamplesOption("l","numLogSamples","Set the number of log samples to store for the top-level system, (default: Use number in .hmf)",false,"","integer", cmd);
         TCLAP::ValueArg<std::string> logonlyOption("","logonly","If specified, log only given ports or variables. Can be a file (one full port/variable name per line) or coma separated list.",false,"","string", cmd);
         TCLAP::ValueArg<std::string> simulateOption("s","simulate","Specify simulation time as: [hmf] or [start,ts,stop] or [ts,stop] or [stop]",false,"","Comma separated string", cmd);
         TCLAP::ValueArg<std::string> parallelOption("p","parallel","Enable parallel simulation with specified number of threads. 0 threads  means auto-detect number of procssors.",false,"0","integer", cmd);
+        TCLAP::ValueArg<std::string> parallelAlgorithmOption("","parallelAlgorithm","The parallel scheduling algorithm to use with -p: [apriori, taskpool, taskstealing, forkjoin, clusteredforkjoin, hybridbarrier]",false,"apriori","string", cmd);
+        TCLAP::ValueArg<std::string> barrierSpinBudgetOption("","barrierSpinBudget","Number of spin iterations before a waiting thread is parked, used by the hybridbarrier and taskstealing algorithms",false,"","integer", cmd);
+        TCLAP::ValueArg<std::string> rescheduleThresholdOption("","rescheduleThreshold","Relative thread load imbalance (e.g. 0.2) that triggers rescheduling during simulation with the apriori and hybridbarrier algorithms, 0 disables",false,"","double", cmd);
         TCLAP::ValueArg<std::string> extLibsFileOption("","externalLibsFile","A text file containing the external libs to load",false,"","Path to file", cmd);
         TCLAP::MultiArg<std::string> extLibPathsOption("e","externalLib","Path to a .dll/.so/.dylib externalComponentLib. Can be given multiple times",false,"Path to file", cmd);
         TCLAP::MultiArg<std::string> optimizationOption("o","optScript","Optimization scripts",false,"Path to files", cmd);
@@ -442,6 +424,7 @@ int main(int argc, char *argv[])
             double F = 1.0;
             double CR = 0.5;
             bool printDebugFile = false;
+            bool asynchronous = false;
             bool silent = false;
 
             string line;
@@ -480,6 +463,10 @@ int main(int argc, char *argv[])
                 {
                     printDebugFile = true;
                 }
+                else if(words.size() == 1 && words[0] == "asynchronous")
+                {
+                    asynchronous = true;
+                }
                 else if(words.size() == 1 && words[0] == "silent")
                 {
                     silent = true;
@@ -684,6 +671,12 @@ int main(int argc, char *argv[])
                     }
                     pBaseWorker->setTolerance(tolerance);
                     pBaseWorker->setSamplingMethod(Ops::SamplingLatinHypercube);
+                    pBaseWorker->setUseAsynchronousEvaluation(asynchronous);
+                    if(asynchronous && (algorithm == "de" || algorithm == "pso"))
+                    {
+                        //Population based algorithms evaluate one candidate per point
+                        pBaseWorker->setNumberOfCandidates(nPoints);
+                    }
 
                     //Set algorithm-specific parameters
                     if(algorithm == "neldermead")
@@ -768,6 +761,11 @@ int main(int argc, char *argv[])
                     //Execute optimization
                     pBaseWorker->initialize();
                     pBaseWorker->run();
+                    if(!silent)
+                    {
+                        cout << "Evaluations: " << pEvaluator->getNumberOfEvaluations() << " ("
+                             << pEvaluator->getEvaluationsPerSecond() << " per second)" << endl;
+                    }
 
                     //Print results
                     if(printDebugFile)
@@ -806,7 +804,51 @@ int main(int argc, char *argv[])
         }
 #endif
 
-        if(hmfPathOption.isSet() && !createHvcTestOption.getValue() && !optimizationOption.isSet())
+        if(sweepOption.isSet() && hmfPathOption.isSet())
+        {
+            std::vector<std::string> sweepVariables;
+            auto file_or_list = sweepVariablesOption.getValue();
+            // Check if argument is a file, if so, read from it line-by-line
+            std::ifstream variable_name_file(file_or_list);
+            if (variable_name_file.is_open())
+            {
+                std::string line;
+                while(std::getline(variable_name_file, line))
+                {
+                    if (!line.empty())
+                    {
+                        sweepVariables.push_back(line);
+                    }
+                }
+            }
+            // Else read , separated string
+            else if (!file_or_list.empty())
+            {
+                splitStringOnDelimiter(file_or_list,',',sweepVariables);
+            }
+
+            size_t nSamples = 0;
+            if (nLogSamplesOption.isSet())
+            {
+                nSamples = size_t(atoi(nLogSamplesOption.getValue().c_str()));
+            }
+            size_t nThreads = 0;
+            if (parallelOption.isSet())
+            {
+                nThreads = size_t(atoi(parallelOption.getValue().c_str()));
+            }
+
+            TicToc sweepTimer("SweepTime");
+            returnSuccess = runParameterSweep(&gHopsanCore, hmfPathOption.getValue(), sweepOption.getValue(), sweepVariables,
+                                              destinationPath+sweepResultsOption.getValue(), simulateOption.getValue(), nSamples, nThreads);
+            sweepTimer.TocPrint();
+            if (returnSuccess)
+            {
+                cout << "Saved sweep results to file: " << destinationPath+sweepResultsOption.getValue() << endl;
+            }
+        }
+
+        if(hmfPathOption.isSet() && !createHvcTestOption.getValue() && !optimizationOption.isSet() && !sweepOption.isSet())
         {
             returnSuccess=false;
             printWaitingMessages(printDebugOption.getValue(), silentOption.getValue());
@@ -911,13 +953,46 @@ int main(int argc, char *argv[])
                         }
 
                         // Now disable all nodes and then enable the requested ones
+                        // If only individual variables are requested in a port, the other variables in that port are not logged
                         forEachPort(pRootSystem, [](hopsan::Port& port){port.setEnableLogging(false);});
+                        std::set<hopsan::Port*> wholePorts, variablePorts;
                         for (const auto& port_name : logOnlyPortsOrVariables)
                         {
                             hopsan::Port* pPort = getPortWithFullName(pRootSystem, port_name);
                             if (pPort)
                             {
-                                pPort->setEnableLogging(true);
+                                const size_t numVariables = pPort->getNumDataVariables();
+                                std::vector<std::string> nameParts;
+                                splitStringOnDelimiter(port_name, '#', nameParts);
+                                if (nameParts.size() == 3)
+                                {
+                                    const int dataId = pPort->getNodeDataIdFromName(nameParts[2].c_str());
+                                    if (dataId < 0)
+                                    {
+                                        printWarningMessage("Could not find variable: '"+port_name+"' when processing logonly input");
+                                    }
+                                    else if (wholePorts.count(pPort) == 0)
+                                    {
+                                        if (variablePorts.insert(pPort).second)
+                                        {
+                                            pPort->setEnableLogging(true);
+                                            for (size_t v=0; v<numVariables; ++v)
+                                            {
+                                                pPort->setEnableVariableLogging(v, false);
+                                            }
+                                        }
+                                        pPort->setEnableVariableLogging(size_t(dataId), true);
+                                    }
+                                }
+                                else
+                                {
+                                    wholePorts.insert(pPort);
+                                    pPort->setEnableLogging(true);
+                                    for (size_t v=0; v<numVariables; ++v)
+                                    {
+                                        pPort->setEnableVariableLogging(v, true);
+                                    }
+                                }
                             }
                             else
                             {
@@ -942,6 +1017,25 @@ int main(int argc, char *argv[])
                         pRootSystem->setKeepValuesAsStartValues(true);
                     }
 
+                    // Stream results to file during simulation, instead of keeping them in memory
+                    std::unique_ptr<hopsan::LogSink> pResultsStreamSink;
+                    if (resultsStreamOption.isSet())
+                    {
+                        cout << "Streaming results to file: " << destinationPath+resultsStreamOption.getValue() << endl;
+                        pResultsStreamSink.reset(createResultsStreamSink(destinationPath+resultsStreamOption.getValue(), pRootSystem->getName().c_str()));
+                        doSimulate = doSimulate && (pResultsStreamSink != nullptr);
+                        pRootSystem->setLogSink(pResultsStreamSink.get());
+                    }
+
+                    if (profileOption.isSet())
+                    {
+                        if (parallelOption.isSet())
+                        {
+                            printWarningMessage("Profiling only covers subsystems in multi-threaded simulations", silentOption.getValue());
+                        }
+                        pRootSystem->setProfilingEnabled(true);
+                    }
+
                     //! @todo maybe use simulation handler object instead
                     TicToc isoktimer("IsOkTime");
                     doSimulate = doSimulate && pRootSystem->checkModelBeforeSimulation();
@@ -962,19 +1056,46 @@ int main(int argc, char *argv[])
                     {
                         cout << "Simulating: " << startTime << " to " << stopTime << " with Ts: " << stepTime << "     Please Wait!" << endl;
                         TicToc simuTimer("SimulationTime");
+                        std::clock_t simuCpuStart = std::clock();
                         if(parallelOption.isSet()) {
                             int nThreads = atoi(parallelOption.getValue().c_str());
                             if(nThreads < 0) {
                                 printErrorMessage("Number of threads cannot be negative.");
                                 return -1;
                             }
-                            pRootSystem->simulateMultiThreaded(startTime, stopTime, nThreads);
+                            hopsan::ParallelAlgorithmT algorithm;
+                            if(!parseParallelAlgorithm(parallelAlgorithmOption.getValue(), algorithm)) {
+                                printErrorMessage("Unknown parallel algorithm: "+parallelAlgorithmOption.getValue());
+                                return -1;
+                            }
+                            if(barrierSpinBudgetOption.isSet()) {
+                                pRootSystem->setBarrierSpinBudget(size_t(atol(barrierSpinBudgetOption.getValue().c_str())));
+                            }
+                            if(rescheduleThresholdOption.isSet()) {
+                                pRootSystem->setRescheduleImbalanceThreshold(atof(rescheduleThresholdOption.getValue().c_str()));
+                            }
+                            pRootSystem->simulateMultiThreaded(startTime, stopTime, nThreads, false, algorithm);
+
+                            const std::vector<hopsan::ThreadLoadStatistics> threadLoad = pRootSystem->getThreadLoadStatistics();
+                            if(!silentOption.getValue() && !threadLoad.empty()) {
+                                for(size_t t=0; t<threadLoad.size(); ++t) {
+                                    cout << "Thread " << t << " busy: " << threadLoad[t].busyTime << " s, idle: " << threadLoad[t].idleTime << " s" << endl;
+                                }
+                                cout << "Adaptive reschedules: " << pRootSystem->getNumAdaptiveReschedules() << endl;
+                            }
                         }
                         else {
                             pRootSystem->simulate(stopTime);
                         }
 
                         simuTimer.TocPrint();
+                        cout << "SimulationCPUTime: " << double(std::clock()-simuCpuStart)/CLOCKS_PER_SEC << endl;
+
+                        if (profileOption.isSet())
+                        {
+                            cout << "Saving profile to file: " << destinationPath+profileOption.getValue() << endl;
+                            saveProfileReport(pRootSystem, destinationPath+profileOption.getValue());
+                        }
                     }
                     if (pRootSystem->wasSimulationAborted())
                     {
@@ -986,6 +1107,7 @@ int main(int argc, char *argv[])
                     }
 
                     pRootSystem->finalize();
+                    pRootSystem->setLogSink(nullptr);
                 }
 
                 printWaitingMessages(printDebugOption.getValue(), silentOption.getValue());
@@ -1033,6 +1155,12 @@ int main(int argc, char *argv[])
                     }
                 }
 
+                if (resultsSpectrumCSVOption.isSet())
+                {
+                    cout << "Saving result spectra to file: " << destinationPath+resultsSpectrumCSVOption.getValue() << endl;
+                    saveSpectraToCSV(pRootSystem, destinationPath+resultsSpectrumCSVOption.getValue(), logOnlyPortsOrVariables, size_t(atoi(spectrumSegmentOption.getValue().c_str())));
+                }
+
 
                 if(resultsFullHDF5Option.isSet()) {
                     cout << "Saving full results to file: " << destinationPath+resultsFullHDF5Option.getValue() << endl;
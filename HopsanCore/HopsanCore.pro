@@ -170,12 +170,20 @@ SOURCES += \
     $${PWD}/dependencies/indexingcsvparser/src/indexingcsvparser.cpp \
     src/Quantities.cpp \
     src/CoreUtilities/NumHopHelper.cpp \
+    src/CoreUtilities/NumHopBytecode.cpp \
     src/CoreUtilities/AliasHandler.cpp \
     src/CoreUtilities/ConnectionAssistant.cpp \
     src/CoreUtilities/SimulationHandler.cpp \
     src/CoreUtilities/MultiThreadingUtilities.cpp \
     src/CoreUtilities/StringUtilities.cpp \
-    src/CoreUtilities/SaveRestoreSimulationPoint.cpp
+    src/CoreUtilities/SaveRestoreSimulationPoint.cpp \
+    src/CoreUtilities/LogSink.cpp \
+    src/CoreUtilities/SimulationProfiler.cpp \
+    src/CoreUtilities/SweepRunner.cpp \
+    src/CoreUtilities/ModelBuilder.cpp \
+    src/CoreUtilities/RealtimeRunner.cpp \
+    src/CoreUtilities/SignalAnalysis.cpp \
+    src/CoreUtilities/SimulationState.cpp
 HEADERS += \
     include/win32dll.h \
     include/Port.h \
@@ -230,10 +238,18 @@ HEADERS += \
     include/HopsanCoreVersion.h \
     include/HopsanCoreGitVersion.h \
     include/CoreUtilities/NumHopHelper.h \
+    include/CoreUtilities/NumHopBytecode.h \
     include/CoreUtilities/ConnectionAssistant.h \
     include/CoreUtilities/AliasHandler.h \
     include/CoreUtilities/SimulationHandler.h \
-    include/CoreUtilities/SaveRestoreSimulationPoint.h
+    include/CoreUtilities/SaveRestoreSimulationPoint.h \
+    include/CoreUtilities/LogSink.h \
+    include/CoreUtilities/SimulationProfiler.h \
+    include/CoreUtilities/SweepRunner.h \
+    include/CoreUtilities/ModelBuilder.h \
+    include/CoreUtilities/RealtimeRunner.h \
+    include/CoreUtilities/SignalAnalysis.h \
+    include/CoreUtilities/SimulationState.h
 
 #DO NOT remove the commented line below, it will be autoreplaced by script
 #INTERNALCOMPLIB_FMI4C_DEPENDENCY#
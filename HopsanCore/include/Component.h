@@ -37,6 +37,7 @@
 #include "Node.h"
 #include "Port.h"
 #include "Parameters.h"
+#include "CoreUtilities/SimulationState.h"
 #include "win32dll.h"
 #include <map>
 #include <list>
@@ -164,6 +165,9 @@ public:
     void getParameterValue(const HString &rName, HString &rValue);
     void* getParameterDataPtr(const HString &rName);
     bool setParameterValue(const HString &rName, const HString &rValue, bool force=false);
+    ParameterHandle getParameterHandle(const HString &rName);
+    size_t getParameterGeneration() const;
+    void incrementParameterGeneration();
     bool checkParameters(HString &errParName);
     void evaluateParameters();
     bool evaluateParameter(const HString &rName, HString &rEvaluatedParameterValue, const HString &rType);
@@ -235,6 +239,13 @@ public:
     virtual void getResiduals(double * /*y*/, double* /*res*/);
     virtual void getJacobian(double * /*y*/, double* /*f*/, double* /*J*/);
 
+    // Simulation state
+    virtual void saveState(StateWriter &rWriter) const;
+    virtual bool restoreState(StateReader &rReader);
+    void registerStateVariable(double &rVariable);
+    void registerStateObject(ComponentStateObject *pObject);
+    void unRegisterStateObject(ComponentStateObject *pObject);
+
 protected:
     //==========Protected member functions==========
     // Constructor - Destructor
@@ -305,11 +316,14 @@ private:
     PortPtrMapT mPortPtrMap;
     std::vector<Port*> mPortPtrVector;
     double mMeasuredTime;
+    size_t mParameterGeneration;
     HopsanEssentials *mpHopsanEssentials;
     HopsanCoreMessageHandler *mpMessageHandler;
     std::vector<VariameterDescription> mVariameters;
     std::map<Port*, double**> mAutoSignalNodeDataPtrPorts;
     bool mIsDisabled;
+    std::vector<ComponentStateObject*> mStateObjects;
+    std::vector<double*> mStateVariables;
 };
 
 
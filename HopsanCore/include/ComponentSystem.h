@@ -43,10 +43,17 @@
 #include "Component.h"
 #include "CoreUtilities/SimulationHandler.h"
 #include "CoreUtilities/AliasHandler.h"
+#include "CoreUtilities/SimulationProfiler.h"
 
 namespace hopsan {
     class NumHopHelper;
     class ComponentSystemMultiThreadPrivates;
+    class ComponentSystemBulkConstruction;
+    class LogSink;
+    class LogSinkVariable;
+    class LogStreamer;
+    class ThreadLoadStatistics;
+    class ThreadLoadProfiler;
 
     class HOPSANCORE_DLLAPI ComponentSystem :public Component
     {
@@ -82,6 +89,11 @@ namespace hopsan {
         HString reserveUniqueName(const HString &rDesiredName, const UniqeNameEnumT type=UniqueReservedNameType);
         void unReserveUniqueName(const HString &rName);
 
+        // Bulk construction of large models
+        void beginBulkConstruction(const size_t expectedNumComponents=0);
+        void endBulkConstruction();
+        bool isInBulkConstruction() const;
+
         // System Parameter functions
         bool renameParameter(const HString &rOldName, const HString &rNewName);
         virtual std::list<HString> getModelAssets() const;
@@ -134,6 +146,17 @@ namespace hopsan {
         virtual void simulateMultiThreaded(const double startT, const double stopT, const size_t nDesiredThreads = 0, const bool noChanges=false, ParallelAlgorithmT algorithm=APrioriScheduling);
         void finalize();
 
+        // Simulation state snapshots
+        void saveState(StateWriter &rWriter) const;
+        bool restoreState(StateReader &rReader);
+        void saveSimulationState(std::vector<char> &rState) const;
+        bool restoreSimulationState(const std::vector<char> &rState);
+
+        // Profiling
+        void setProfilingEnabled(const bool enabled);
+        bool isProfilingEnabled() const;
+        ProfileEntry getProfileReport() const;
+
         bool simulateAndMeasureTime(const size_t nSteps);
         double getTotalMeasuredTime();
         void sortComponentVectorsByMeasuredTime();
@@ -141,7 +164,20 @@ namespace hopsan {
         void distributeQcomponents(std::vector< std::vector<Component*> > &rSplitQVector, size_t nThreads);
         void distributeSignalcomponents(std::vector< std::vector<Component*> > &rSplitSignalVector, size_t nThreads);
         void distributeNodePointers(std::vector< std::vector<Node*> > &rSplitNodeVector, size_t nThreads);
-        void reschedule(size_t nThreads);
+        void partitionCQcomponents(std::vector< std::vector<Component*> > &rSplitCVector, std::vector< std::vector<Component*> > &rSplitQVector, size_t nThreads);
+        void assignNodeOwnership(std::vector< std::vector<Node*> > &rSplitNodeVector, const std::vector< std::vector<Component*> > &rSplitSignalVector,
+                                 const std::vector< std::vector<Component*> > &rSplitCVector, const std::vector< std::vector<Component*> > &rSplitQVector);
+        void reschedule(size_t nThreads, bool measureTime=true);
+        size_t rebalanceThreads(const size_t maxMovesPerPhase);
+        void setBarrierSpinBudget(const size_t spinBudget);
+        size_t getBarrierSpinBudget() const;
+        void setProfilingSampleInterval(const size_t sampleInterval);
+        size_t getProfilingSampleInterval() const;
+        void setRescheduleImbalanceThreshold(const double threshold, const size_t checkInterval=1024);
+        double getRescheduleImbalanceThreshold() const;
+        std::vector<ThreadLoadStatistics> getThreadLoadStatistics() const;
+        size_t getNumAdaptiveReschedules() const;
+        size_t getNumExpandedSubsystems() const;
 
         // Set and get desired timestep
         void setDesiredTimestep(const double timestep);
@@ -159,6 +195,9 @@ namespace hopsan {
         void setLogStartTime(const double logStartTime);
         size_t getNumLogSamples() const;
         size_t getNumActuallyLoggedSamples() const;
+        void setLogSink(LogSink *pSink, const size_t chunkNumSamples=0);
+        LogSink *getLogSink() const;
+        bool isLogStreamed() const;
 
         // Stop a running initialization or simulation
         void stopSimulation(const HString &rReason);
@@ -206,6 +245,17 @@ namespace hopsan {
 //        void setLogSettingsSkipFactor(double factor, double start, double stop, double sampletime);
         void setupLogSlotsAndTs(const double simStartT, const double simStopT, const double simTs);
         void preAllocateLogSpace();
+        bool startLogStreaming();
+        void collectStreamedLogVariables(const HString &rSystemHierarchy, std::vector<LogSinkVariable> &rVariables, std::vector<const double*> &rValuePtrs);
+
+        // Profiling specific functions
+        void simulateProfiled(const double stopT);
+
+        // Multi-threading specific functions
+        void storeThreadLoadStatistics(const ThreadLoadProfiler &rProfiler);
+        bool isExpandableSubsystem(Component *pComponent) const;
+        void collectExpandedTasks(std::vector<Component*> &rSignalTasks, std::vector<Component*> &rCTasks, std::vector<Component*> &rQTasks,
+                                  std::vector<ComponentSystem*> &rExpandedSystems);
 
         // Add and Remove subcomponent ptrs from storage vectors
         void addSubComponentPtrToStorage(Component* pComponent);
@@ -216,6 +266,13 @@ namespace hopsan {
 
         bool sortComponentVector(std::vector<Component*> &rOldSignalVector);
 
+        // Node data arena specific functions
+        bool isNodeDataArenaPacked() const;
+        void packNodeDataArena();
+        void packNodeDataArena(const std::vector< std::vector<Component*> > &rComponentGroups);
+        void packNodeDataArena(const std::vector< std::vector<Node*> > &rNodeGroups);
+        void unpackNodeDataArena();
+
         // UniqueName specific functions
         HString determineUniquePortName(const HString &rPortname);
         HString determineUniqueComponentName(const HString &rName) const;
@@ -230,6 +287,8 @@ namespace hopsan {
         std::vector<Component*> mComponentCptrs;
         std::vector<Component*> mComponentUndefinedptrs;
         std::vector<Node*> mSubNodePtrs;
+        std::vector<Node*> mLoggedNodePtrs;
+        std::vector<double> mNodeDataArena;
 
         std::vector<Component*> mDisabledSptrs;
         std::vector<Component*> mDisabledQptrs;
@@ -237,6 +296,8 @@ namespace hopsan {
 
         typedef std::map<HString, UniqeNameEnumT> TakenNamesMapT;
         TakenNamesMapT mTakenNames;
+        typedef std::map<HString, size_t> TakenNameSuffixMapT;
+        mutable TakenNameSuffixMapT mTakenNameSuffixes;
 
 
         bool volatile mStopSimulation;
@@ -265,6 +326,19 @@ namespace hopsan {
         double mRequestedLogStartTime, mLogTimeDt;
         bool mEnableLogData;
         std::vector<double> mTimeStorage;
+
+        // Streaming log related variables
+        LogSink *mpLogSink;
+        size_t mLogSinkChunkNumSamples;
+        LogStreamer *mpLogStreamer;
+        std::vector<const double*> mStreamedLogValuePtrs;
+        bool mLogIsStreamed;
+
+        // Profiling related variables
+        SimulationProfiler *mpSimulationProfiler;
+
+        // Bulk construction book keeping, only allocated between beginBulkConstruction() and endBulkConstruction()
+        ComponentSystemBulkConstruction *mpBulkConstruction;
     };
 
 
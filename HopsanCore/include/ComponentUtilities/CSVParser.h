@@ -46,8 +46,16 @@ class IndexingCSVParser;
 
 namespace hopsan {
 
+// Forward declaration
+class CSVMemoryParser;
+
 //! @ingroup ComponentUtilityClasses
 //! @brief The CSV file parser utility
+//! @details Text and files are indexed directly in memory (files are memory mapped), numeric columns are parsed in
+//! parallel chunks for large files. The index and the parsed columns of files are cached in the process, keyed by
+//! path, size, modification time (with sub-second resolution) and file id (inode), so that repeated initialization
+//! does not parse the same file again. The cache is bounded to 256 MiB, least recently used files are dropped first.
+//! As with the stdio based parser, a decimal comma ("1,5") is accepted when the separator is not ','.
 class HOPSANCORE_DLLAPI CSVParserNG
 {
 public:
@@ -72,6 +80,8 @@ public:
 
     HString getErrorString() const;
 
+    static void clearCache();
+
     bool copyRow(const size_t rowIdx, std::vector<double> &rRow);
     bool copyRow(const size_t rowIdx, std::vector<long int> &rRow);
     bool copyColumn(const size_t columnIdx, std::vector<double> &rColumn);
@@ -81,6 +91,8 @@ public:
 
 protected:
     indcsvp::IndexingCSVParser *mpCsvParser;
+    CSVMemoryParser *mpMemoryParser;
+    bool mUseMemoryParser;
     HString mErrorString;
     bool mConvertDecimalSeparator;
 };
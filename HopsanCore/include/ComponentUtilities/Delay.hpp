@@ -35,13 +35,14 @@
 #define DELAY_HPP_INCLUDED
 
 #include "stddef.h"
+#include "CoreUtilities/SimulationState.h"
 
 namespace hopsan {
 
 //! @brief Delay template class, implementing a circular buffer containing values of specified type
 //! @ingroup ComponentUtilityClasses
 template<typename T>
-class DelayTemplate
+class DelayTemplate : public ComponentStateObject
 {
 public:
     DelayTemplate()
@@ -183,6 +184,49 @@ public:
         }
     }
 
+    //! @brief Write the buffer contents and positions to a state buffer
+    void saveState(StateWriter &rWriter) const
+    {
+        rWriter.writeSize(mSize);
+        if (mSize > 0)
+        {
+            rWriter.writeSize(mNewest);
+            rWriter.writeSize(mOldest);
+            rWriter.writeRaw(mpArray, mSize*sizeof(T));
+        }
+    }
+
+    //! @brief Restore the buffer contents and positions from a state buffer, the buffer is reallocated if the size differs
+    bool restoreState(StateReader &rReader)
+    {
+        size_t size=0;
+        if (!rReader.readSize(size))
+        {
+            return false;
+        }
+        if (size != mSize)
+        {
+            clear();
+            if (size > 0)
+            {
+                mpArray = new T[size];
+                mSize = size;
+            }
+        }
+        if (mSize > 0)
+        {
+            size_t newest=0, oldest=0;
+            if (!rReader.readSize(newest) || !rReader.readSize(oldest) || (newest >= mSize) || (oldest >= mSize) ||
+                !rReader.readRaw(mpArray, mSize*sizeof(T)))
+            {
+                return false;
+            }
+            mNewest = newest;
+            mOldest = oldest;
+        }
+        return true;
+    }
+
 
 private:
     size_t mSize, mNewest, mOldest;
@@ -35,11 +35,12 @@
 #define DOUBLEINTEGRATORWITHDAMPING_H_INCLUDED
 
 #include "win32dll.h"
+#include "CoreUtilities/SimulationState.h"
 
 namespace hopsan {
 
     //! @ingroup ComponentUtilityClasses
-    class HOPSANCORE_DLLAPI DoubleIntegratorWithDamping
+    class HOPSANCORE_DLLAPI DoubleIntegratorWithDamping : public ComponentStateObject
     {
     public:
         void initialize(double timestep, double w0, double u0=0.0, double y0=0.0, double sy0=0.0);
@@ -50,6 +51,8 @@ namespace hopsan {
         void redoIntegrate(double u);
         double valueFirst();
         double valueSecond();
+        void saveState(StateWriter &rWriter) const;
+        bool restoreState(StateReader &rReader);
 
     private:
         double mDelayU, mDelayY, mDelaySY;
@@ -35,11 +35,12 @@
 #define DOUBLEINTEGRATORWITHDAMPINGANDCOULUMBFRICTION_H_INCLUDED
 
 #include "win32dll.h"
+#include "CoreUtilities/SimulationState.h"
 
 namespace hopsan {
 
     //! @ingroup ComponentUtilityClasses
-    class HOPSANCORE_DLLAPI DoubleIntegratorWithDampingAndCoulombFriction
+    class HOPSANCORE_DLLAPI DoubleIntegratorWithDampingAndCoulombFriction : public ComponentStateObject
     {
     public:
         void initialize(double timestep, double w0, double Fs, double Fk, double u0, double y0, double sy0);
@@ -51,6 +52,8 @@ namespace hopsan {
         void redoIntegrate(double u);
         double valueFirst();
         double valueSecond();
+        void saveState(StateWriter &rWriter) const;
+        bool restoreState(StateReader &rReader);
 
     private:
         double mDelayU, mDelayY, mDelaySY;
@@ -47,13 +47,27 @@ class HOPSANCORE_DLLAPI EquationSystemSolver
 {
 public:
 
+    //! @brief Systems up to this size are solved with a fixed-size, allocation free, LU-decomposition
+    static const int MaxFixedSystemSize = 8;
+
     EquationSystemSolver(Component *pParentComponent, int n);
     EquationSystemSolver(Component *pParentComponent, int n, Matrix *pJacobian, Vec *pEquations, Vec *pVariables);
+    ~EquationSystemSolver();
+    void setReuseFactorization(bool reuse);
     void solve(Matrix &jacobian, Vec &equations, Vec &variables, int iteration);
     void solve(Matrix &jacobian, Vec &equations, Vec &variables);
     void solve();
 
 private:
+    typedef bool (*FixedFactorizeFunctionT)(const Matrix &rJacobian, double *pLU, int *pOrder);
+    typedef void (*FixedSolveFunctionT)(const double *pLU, const int *pOrder, const Vec &rEquations, Vec &rDelta);
+
+    // The solver owns its work memory, so it must not be copied
+    EquationSystemSolver(const EquationSystemSolver &);
+    EquationSystemSolver &operator=(const EquationSystemSolver &);
+
+    void calculateDelta(Matrix &jacobian, Vec &equations, bool reuseFactorization);
+
     Component *mpParentComponent;
     double mSystemEquationWeight[4];
     int *mpOrder;
@@ -64,6 +78,12 @@ private:
     Matrix *mpJacobian;
     Vec *mpEquations;
     Vec *mpVariables;
+
+    FixedFactorizeFunctionT mpFixedFactorize;
+    FixedSolveFunctionT mpFixedSolve;
+    double mFixedLU[MaxFixedSystemSize*MaxFixedSystemSize];
+    Matrix *mpLU;
+    bool mReuseFactorization;
 };
 
 
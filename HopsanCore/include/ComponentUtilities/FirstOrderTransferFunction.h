@@ -39,7 +39,7 @@
 
 namespace hopsan {
 
-    class HOPSANCORE_DLLAPI FirstOrderTransferFunction
+    class HOPSANCORE_DLLAPI FirstOrderTransferFunction : public ComponentStateObject
     {
     public:
         void initialize(double timestep, double num[2], double den[2], double u0=0.0, double y0=0.0, double min=-1.5E+300, double max=1.5E+300);
@@ -57,6 +57,8 @@ namespace hopsan {
         double delayedU() const;
         double delayedY() const;
         bool isSaturated() const;
+        void saveState(StateWriter &rWriter) const;
+        bool restoreState(StateReader &rReader);
 
     protected:
         double mValue;
@@ -77,7 +79,7 @@ namespace hopsan {
     };
 
 
-    class HOPSANCORE_DLLAPI FirstOrderTransferFunctionVariable
+    class HOPSANCORE_DLLAPI FirstOrderTransferFunctionVariable : public ComponentStateObject
     {
     public:
         void initialize(double *pTimestep, double num[2], double den[2], double u0=0.0, double y0=0.0, double min=-1.5E+300, double max=1.5E+300);
@@ -89,6 +91,8 @@ namespace hopsan {
         void recalculateCoefficients();
         double update(double u);
         double value();
+        void saveState(StateWriter &rWriter) const;
+        bool restoreState(StateReader &rReader);
 
     private:
         double mValue;
@@ -40,7 +40,7 @@
 namespace hopsan {
 
 //! @ingroup ComponentUtilityClasses
-class Integrator
+class Integrator : public ComponentStateObject
 {
 public:
     inline void initialize(const double timestep, const double u0=0.0, const double y0=0.0)
@@ -74,6 +74,19 @@ public:
         return mDelayY;
     }
 
+    //! @brief Write the integrator state to a state buffer
+    void saveState(StateWriter &rWriter) const
+    {
+        rWriter.writeDouble(mDelayU);
+        rWriter.writeDouble(mDelayY);
+    }
+
+    //! @brief Restore the integrator state from a state buffer
+    bool restoreState(StateReader &rReader)
+    {
+        return rReader.readDouble(mDelayU) && rReader.readDouble(mDelayY);
+    }
+
 protected:
     double mDelayU, mDelayY;
     double mTimeStep;
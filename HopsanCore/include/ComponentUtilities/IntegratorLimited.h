@@ -40,7 +40,7 @@
 
 namespace hopsan {
 
-    class HOPSANCORE_DLLAPI IntegratorLimited
+    class HOPSANCORE_DLLAPI IntegratorLimited : public ComponentStateObject
     {
     public:
         void initialize(double timestep, double u0=0.0, double y0=0.0, double min=-1.5E+300, double max=1.5E+300);
@@ -48,6 +48,8 @@ namespace hopsan {
         void setMinMax(double min, double max);
         double update(double u);
 	double value();
+        void saveState(StateWriter &rWriter) const;
+        bool restoreState(StateReader &rReader);
 
     private:
         double mDelayU, mDelayY;
@@ -36,6 +36,7 @@
 
 #include <vector>
 #include <cstring>
+#include <cmath>
 
 inline double interp1(const double x, const double i1, const double i2, const double v1, const double v2)
 {
@@ -60,6 +61,9 @@ public:
         mIndexData.clear(); mIndexData.resize(mNumDims);
         mNumSubDimDataElements.clear(); mNumSubDimDataElements.resize(mNumDims, 0);
         mIndexIncreasingOrDecreasing.clear(); mIndexIncreasingOrDecreasing.resize(mNumDims, Unknown);
+        mIndexIsEquidistant.clear(); mIndexIsEquidistant.resize(mNumDims, false);
+        mInvIndexStep.clear(); mInvIndexStep.resize(mNumDims, 0);
+        mLastIntervalIdx.clear(); mLastIntervalIdx.resize(mNumDims, 0);
         resetFirstLast();
     }
 
@@ -123,6 +127,7 @@ public:
                 }
 
                 isStrictlyInc = isStrictlyInc && (mIndexIncreasingOrDecreasing[d] == StrictlyIncreasing);
+                calcEquidistant(d);
             }
             return isStrictlyInc;
         }
@@ -150,6 +155,13 @@ public:
         return mIndexIncreasingOrDecreasing[d];
     }
 
+    //! @brief Check if the index data in a dimension is equidistant, in which case intervals are found by direct indexing
+    //! @note Determined by isDataOK()
+    bool isIndexEquidistant(size_t d) const
+    {
+        return mIndexIsEquidistant[d];
+    }
+
     void calcIncreasingOrDecreasing(int dim=-1)
     {
         size_t start, end;
@@ -322,36 +334,119 @@ public:
         return mIndexData[dim].size();
     }
 
+    //! @brief Find the start index of the interval containing x
+    //! @details Equidistant index data is indexed directly. Otherwise the search starts from the interval found in the
+    //! previous call, since inputs usually move smoothly between time steps, and falls back to a binary search.
     //! @note Assumes that x is within index range
+    //! @note The remembered interval makes concurrent lookups in the same table unsafe
     size_t findIndexAlongDim(const size_t dim, const double x) const
     {
-        return intervalHalfSubDiv(x, 0, mIndexData[dim].size()-1, dim);
+        const std::vector<double> &rIndexData = mIndexData[dim];
+        const size_t lastInterval = rIndexData.size()-2;
+        size_t idx;
+
+        if (mIndexIsEquidistant[dim])
+        {
+            const double t = (x-mIndexFirst[dim])*mInvIndexStep[dim];
+            idx = (t > 0) ? ((t < double(lastInterval)) ? size_t(t) : lastInterval) : 0;
+            // Correct for round-off, so that the result is the same as for the search below
+            while ((idx > 0) && (x <= rIndexData[idx]))
+            {
+                --idx;
+            }
+            while ((idx < lastInterval) && (x > rIndexData[idx+1]))
+            {
+                ++idx;
+            }
+            return idx;
+        }
+
+        idx = mLastIntervalIdx[dim];
+        if (idx > lastInterval)
+        {
+            idx = 0;
+        }
+
+        if (x > rIndexData[idx+1])
+        {
+            // Search upwards, check the next interval before doing a binary search in the rest
+            if ((idx+1 < lastInterval) && (x > rIndexData[idx+2]))
+            {
+                idx = intervalHalfSubDiv(x, idx+2, lastInterval+1, dim);
+            }
+            else
+            {
+                idx = idx+1;
+            }
+        }
+        else if ((idx > 0) && (x <= rIndexData[idx]))
+        {
+            // Search downwards, check the previous interval before doing a binary search in the rest
+            if ((idx > 1) && (x <= rIndexData[idx-1]))
+            {
+                idx = intervalHalfSubDiv(x, 0, idx-1, dim);
+            }
+            else
+            {
+                idx = idx-1;
+            }
+        }
+
+        mLastIntervalIdx[dim] = idx;
+        return idx;
     }
 
 protected:
-    size_t intervalHalfSubDiv(const double x, const size_t i1, const size_t iend, const size_t dim) const
+    //! @brief Binary search for the start index of the interval containing x, between index i1 and iend
+    size_t intervalHalfSubDiv(const double x, size_t i1, size_t iend, const size_t dim) const
     {
-        if (iend-i1 <= 1)
-        {
-            // When the two indexes are next to each other lets return the smallest one as the start row for interpolation
-            return i1;
-        }
-        else
+        const std::vector<double> &rIndexData = mIndexData[dim];
+        // When the two indexes are next to each other the smallest one is the start row for interpolation
+        while (iend-i1 > 1)
         {
             //Calc split index
-            size_t splitIdx = i1 + (iend - i1)/2; //Allow truncation
+            const size_t splitIdx = i1 + (iend - i1)/2; //Allow truncation
 
-            if (x <= mIndexData[dim][splitIdx])
+            if (x <= rIndexData[splitIdx])
             {
                 // Use lower half
-                return intervalHalfSubDiv(x, i1, splitIdx, dim);
+                iend = splitIdx;
             }
             else
             {
                 // Use higher half
-                return intervalHalfSubDiv(x, splitIdx, iend, dim);
+                i1 = splitIdx;
             }
         }
+        return i1;
+    }
+
+    //! @brief Check if the index data in a dimension is (strictly increasing and) equidistant
+    void calcEquidistant(const size_t dim)
+    {
+        mIndexIsEquidistant[dim] = false;
+        mInvIndexStep[dim] = 0;
+
+        const std::vector<double> &rIndexData = mIndexData[dim];
+        const size_t n = rIndexData.size();
+        if ((n < 2) || (mIndexIncreasingOrDecreasing[dim] != StrictlyIncreasing))
+        {
+            return;
+        }
+
+        const double step = (rIndexData[n-1]-rIndexData[0])/double(n-1);
+        // Small deviations are fine, since findIndexAlongDim() corrects the directly calculated index
+        const double tolerance = step*1e-6;
+        for (size_t i=1; i<n-1; ++i)
+        {
+            if (fabs(rIndexData[i]-(rIndexData[0]+double(i)*step)) > tolerance)
+            {
+                return;
+            }
+        }
+
+        mIndexIsEquidistant[dim] = true;
+        mInvIndexStep[dim] = 1.0/step;
     }
 
     size_t quickSortPartition( const size_t dim, const std::vector<double> &rIndexArray, const size_t left, const size_t right, const size_t pivotIndex)
@@ -496,6 +591,9 @@ protected:
     std::vector<double> mIndexFirst;
     std::vector<double> mIndexLast;
     std::vector<IncreasingEnumT> mIndexIncreasingOrDecreasing;
+    std::vector<bool> mIndexIsEquidistant;
+    std::vector<double> mInvIndexStep;
+    mutable std::vector<size_t> mLastIntervalIdx;
 
     std::vector< std::vector<double> > mIndexData;
     std::vector<double> mValueData;
@@ -537,6 +635,15 @@ public:
             return mValueData[idx] + (x - rIndexData[idx])*(mValueData[idx+1] -  mValueData[idx])/(rIndexData[idx+1] -  rIndexData[idx]);
         }
     }
+
+    //! @brief Interpolate n values at once, pY[i] = interpolate(pX[i])
+    void interpolate(const double *pX, double *pY, const size_t n) const
+    {
+        for (size_t i=0; i<n; ++i)
+        {
+            pY[i] = interpolate(pX[i]);
+        }
+    }
 };
 
 
@@ -577,6 +684,15 @@ public:
 
         return interp1(c, mIndexData[1][tl_c], mIndexData[1][tr_c], val_l, val_r);
     }
+
+    //! @brief Interpolate n values at once, pY[i] = interpolate(pR[i], pC[i])
+    void interpolate(const double *pR, const double *pC, double *pY, const size_t n) const
+    {
+        for (size_t i=0; i<n; ++i)
+        {
+            pY[i] = interpolate(pR[i], pC[i]);
+        }
+    }
 };
 
 
@@ -610,6 +726,15 @@ public:
         return interp1(p, mIndexData[2][pl], mIndexData[2][pl+1], vpl, vph);
     }
 
+    //! @brief Interpolate n values at once, pY[i] = interpolate(pR[i], pC[i], pP[i])
+    void interpolate(const double *pR, const double *pC, const double *pP, double *pY, const size_t n) const
+    {
+        for (size_t i=0; i<n; ++i)
+        {
+            pY[i] = interpolate(pR[i], pC[i], pP[i]);
+        }
+    }
+
 private:
     double interp2d(const size_t tl_r, const size_t tl_c, const size_t plane, const double r, const double c) const
     {
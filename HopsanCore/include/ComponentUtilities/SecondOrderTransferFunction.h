@@ -39,7 +39,7 @@
 
 namespace hopsan {
 
-    class HOPSANCORE_DLLAPI SecondOrderTransferFunction
+    class HOPSANCORE_DLLAPI SecondOrderTransferFunction : public ComponentStateObject
     {
     public:
         void initialize(double timestep, double num[3], double den[3], double u0=0.0, double y0=0.0, double min=-1.5E+300, double max=1.5E+300, double sy0=0.0);
@@ -59,6 +59,8 @@ namespace hopsan {
         double delayedY() const;
         double delayed2Y() const;
         bool isSaturated() const;
+        void saveState(StateWriter &rWriter) const;
+        bool restoreState(StateReader &rReader);
 
     private:
         double mValue;
@@ -71,7 +73,7 @@ namespace hopsan {
         Delay mBackupU, mBackupY;
     };
 
-    class HOPSANCORE_DLLAPI SecondOrderTransferFunctionVariable
+    class HOPSANCORE_DLLAPI SecondOrderTransferFunctionVariable : public ComponentStateObject
     {
     public:
         void initialize(double *pTimestep, double num[3], double den[3], double u0=0.0, double y0=0.0, double min=-1.5E+300, double max=1.5E+300);
@@ -83,6 +85,8 @@ namespace hopsan {
         double update(double u);
         double value();
         void recalculateCoefficients();
+        void saveState(StateWriter &rWriter) const;
+        bool restoreState(StateReader &rReader);
 
     private:
         double mValue;
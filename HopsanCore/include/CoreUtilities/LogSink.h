@@ -0,0 +1,163 @@
+/*-----------------------------------------------------------------------------
+
+ Copyright 2017 Hopsan Group
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+
+ The full license is available in the file LICENSE.
+ For details about the 'Hopsan Group' or information about Authors and
+ Contributors see the HOPSANGROUP and AUTHORS files that are located in
+ the Hopsan source code root directory.
+
+-----------------------------------------------------------------------------*/
+
+//!
+//! @file   LogSink.h
+//!
+//! @brief Contains the log sink interface and helpers for streaming log data to disk during simulation
+//!
+//$Id$
+
+#ifndef LOGSINK_H
+#define LOGSINK_H
+
+#include <cstddef>
+#include <vector>
+#include <fstream>
+#include "win32dll.h"
+#include "HopsanTypes.h"
+#include "CoreUtilities/MultiThreadingUtilities.h"
+
+#if defined(HOPSANCORE_USEMULTITHREADING)
+#include <deque>
+#endif
+
+namespace hopsan {
+
+//! @brief Describes one logged variable (one column) in a log sink
+class HOPSANCORE_DLLAPI LogSinkVariable
+{
+public:
+    HString systemHierarchy;    //!< Dot separated parent system names, empty for the top-level system
+    HString componentName;      //!< Empty for the time variable
+    HString portName;           //!< Empty for the time variable
+    HString variableName;
+    HString alias;
+    HString unit;
+    HString quantity;
+
+    HString getFullName(const char systemSeparator='$') const;
+};
+
+//! @brief Interface for receivers of log data streamed during simulation
+//! @details Samples are delivered in chunks, one row per sample, each row has one value per variable given to open()
+//! The first variable is always the time. All functions are called from the same (log writer) thread.
+class HOPSANCORE_DLLAPI LogSink
+{
+public:
+    virtual ~LogSink();
+    virtual bool open(const std::vector<LogSinkVariable> &rVariables) = 0;
+    virtual bool write(const double *pSamples, const size_t numSamples) = 0;
+    virtual bool close() = 0;
+    const HString &getLastError() const;
+
+protected:
+    HString mLastError;
+};
+
+//! @brief Log sink writing a CSV file with one column per variable and one row per sample
+class HOPSANCORE_DLLAPI CSVLogSink : public LogSink
+{
+public:
+    CSVLogSink(const HString &rFilePath);
+    bool open(const std::vector<LogSinkVariable> &rVariables);
+    bool write(const double *pSamples, const size_t numSamples);
+    bool close();
+
+private:
+    HString mFilePath;
+    std::ofstream mFile;
+    size_t mNumVariables;
+};
+
+//! @brief Log sink writing a raw binary file
+//! @details The file starts with a text header: the line "HOPSANRAWLOG 1", the number of variables, then one line per
+//! variable with "fullname,alias,unit,quantity" followed by an empty line. After the header, samples follow as rows of
+//! native (little endian on all supported platforms) 8 byte doubles.
+class HOPSANCORE_DLLAPI RawLogSink : public LogSink
+{
+public:
+    RawLogSink(const HString &rFilePath);
+    bool open(const std::vector<LogSinkVariable> &rVariables);
+    bool write(const double *pSamples, const size_t numSamples);
+    bool close();
+
+private:
+    HString mFilePath;
+    std::ofstream mFile;
+    size_t mNumVariables;
+};
+
+//! @brief Collects logged samples into fixed size chunks and hands full chunks to a log sink
+//! @details When multi-threading is available chunks are written from a background thread, with a fixed number of
+//! chunk buffers so that memory usage is bounded. If the writer falls behind, the simulation thread waits for a free buffer.
+class LogStreamer
+{
+public:
+    LogStreamer(LogSink *pSink, const size_t numVariables, const size_t chunkNumSamples);
+    ~LogStreamer();
+
+    bool start(const std::vector<LogSinkVariable> &rVariables);
+    //! @brief Get the row to fill in for the next sample, call commitSample() when done
+    inline double *nextSample()
+    {
+        return &(*mpCurrentBuffer)[mNumSamplesInChunk*mNumVariables];
+    }
+    void commitSample();
+    bool finish();
+    bool hasFailed() const;
+    HString getLastError() const;
+
+    static const size_t defaultChunkBytes = 4*1024*1024;
+
+private:
+    void writeChunk(std::vector<double> *pBuffer, const size_t numSamples);
+    void acquireBuffer();
+
+    LogSink *mpSink;
+    size_t mNumVariables;
+    size_t mChunkNumSamples;
+    size_t mNumSamplesInChunk;
+    std::vector< std::vector<double> > mBuffers;
+    std::vector<double> *mpCurrentBuffer;
+    bool mStarted;
+
+#if defined(HOPSANCORE_USEMULTITHREADING)
+    void writerLoop();
+
+    std::thread mWriterThread;
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::deque< std::pair<std::vector<double>*, size_t> > mWriteQueue;
+    std::vector< std::vector<double>* > mFreeBuffers;
+    bool mStopWriter;
+    std::atomic<bool> mFailed;
+#else
+    bool mFailed;
+#endif
+};
+
+}
+
+#endif // LOGSINK_H
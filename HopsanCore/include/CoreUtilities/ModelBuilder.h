@@ -0,0 +1,92 @@
+/*-----------------------------------------------------------------------------
+
+ Copyright 2017 Hopsan Group
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+
+ The full license is available in the file LICENSE.
+ For details about the 'Hopsan Group' or information about Authors and
+ Contributors see the HOPSANGROUP and AUTHORS files that are located in
+ the Hopsan source code root directory.
+
+-----------------------------------------------------------------------------*/
+
+
+
+//!
+//! @file   ModelBuilder.h
+//!
+//! @brief Contains the model builder, used to construct large models programmatically
+//!
+//$Id$
+
+#ifndef MODELBUILDER_H
+#define MODELBUILDER_H
+
+#include <cstddef>
+#include <vector>
+#include "win32dll.h"
+#include "HopsanTypes.h"
+
+namespace hopsan {
+
+// Forward declaration
+class Component;
+class ComponentSystem;
+
+//! @brief Builds large models, with many components and connections, into a system
+//! @details The system is kept in bulk construction (see ComponentSystem::beginBulkConstruction()) while the builder is used.
+//! Components are added immediately, but connections are only queued. They are resolved, validated and made when finish()
+//! is called, and all connections are attempted even if some of them fail. Names can be taken from the components returned
+//! by addComponent(), as the desired names get unique suffixes if they are already taken.
+//!
+//! Connections that have not been made when the builder is destroyed are discarded, always call finish().
+class HOPSANCORE_DLLAPI ModelBuilder
+{
+public:
+    ModelBuilder(ComponentSystem *pSystem, const size_t expectedNumComponents=0);
+    ~ModelBuilder();
+
+    void reserve(const size_t numComponents, const size_t numConnections);
+
+    Component *addComponent(const HString &rTypeName, const HString &rDesiredName="");
+    void connect(Component *pComponent1, const HString &rPortName1, Component *pComponent2, const HString &rPortName2);
+    void connect(const HString &rComponentName1, const HString &rPortName1, const HString &rComponentName2, const HString &rPortName2);
+    bool finish();
+
+    ComponentSystem *getSystem() const;
+    size_t getNumPendingConnections() const;
+    size_t getNumFailedConnections() const;
+    const HString &getLastError() const;
+
+private:
+    //! @brief A queued connection, the components are either given directly or by name (if the pointer is null)
+    class PendingConnection
+    {
+    public:
+        Component *pComponent1, *pComponent2;
+        HString componentName1, portName1, componentName2, portName2;
+    };
+
+    bool makeConnection(const PendingConnection &rConnection, HString &rError);
+
+    ComponentSystem *mpSystem;
+    std::vector<PendingConnection> mPendingConnections;
+    size_t mNumFailedConnections;
+    HString mLastError;
+};
+
+}
+
+#endif // MODELBUILDER_H
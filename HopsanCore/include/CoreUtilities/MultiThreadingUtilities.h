@@ -47,12 +47,38 @@ namespace hopsan {
 
 size_t HOPSANCORE_DLLAPI determineActualNumberOfThreads(const size_t nDesiredThreads);
 
+//! @brief Load statistics for one thread in a multi-threaded simulation
+class ThreadLoadStatistics
+{
+public:
+    ThreadLoadStatistics() : busyTime(0), idleTime(0) {}
+    double busyTime;    //!< Time spent simulating components (and logging for the master thread) [s]
+    double idleTime;    //!< Time spent waiting for other threads at barriers [s]
+};
+
 }
 
 #if defined(HOPSANCORE_USEMULTITHREADING)
 
 #include <atomic>
 #include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <memory>
+#include <chrono>
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define HOPSANCORE_CPU_RELAX() _mm_pause()
+#define HOPSANCORE_READ_CYCLE_COUNTER() static_cast<unsigned long long>(__rdtsc())
+#else
+#define HOPSANCORE_CPU_RELAX() std::this_thread::yield()
+#define HOPSANCORE_READ_CYCLE_COUNTER() static_cast<unsigned long long>(std::chrono::steady_clock::now().time_since_epoch().count())
+#endif
 
 namespace hopsan {
 
@@ -97,17 +123,203 @@ private:
 };
 
 
+//! @brief Sense-reversing barrier that spins for a limited number of iterations before parking the thread.
+//! @details All threads (including the master) call wait(). The last thread to arrive flips the barrier sense,
+//! which releases the others. Waiting threads first spin (cheap when all cores are available), then block on a
+//! condition variable so that oversubscribed or idle threads do not burn CPU time.
+class HybridBarrier
+{
+public:
+    //! @brief Constructor.
+    //! @note Number of threads must be correct! Wrong value will result in deadlocks or non-synchronized threads.
+    //! @param nThreads Number of threads to by synchronized (including the master thread)
+    //! @param spinBudget Number of spin iterations before a waiting thread is parked, 0 means park directly
+    HybridBarrier(size_t nThreads, size_t spinBudget=defaultSpinBudget)
+    {
+        mnThreads = nThreads;
+        mSpinBudget = spinBudget;
+        mCounter = 0;
+        mnSleepers = 0;
+        mSense = false;
+        mAborted = false;
+    }
+
+    //! @brief Wait until all threads have arrived at the barrier
+    //! @returns False if the barrier has been aborted, else true
+    inline bool wait()
+    {
+        if(mAborted.load())
+        {
+            return false;
+        }
+
+        // The sense can not change until this thread has arrived, so this is the sense of the current phase
+        const bool arrivalSense = mSense.load(std::memory_order_acquire);
+
+        if(mCounter.fetch_add(1, std::memory_order_acq_rel) == mnThreads-1)
+        {
+            // Last thread to arrive, reset counter and release the others
+            mCounter.store(0, std::memory_order_relaxed);
+            mSense.store(!arrivalSense);
+            if(mnSleepers.load() > 0)
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mCondition.notify_all();
+            }
+            return !mAborted.load();
+        }
+
+        for(size_t i=0; i<mSpinBudget; ++i)
+        {
+            if(mSense.load(std::memory_order_acquire) != arrivalSense)
+            {
+                return !mAborted.load();
+            }
+            if(mAborted.load(std::memory_order_relaxed))
+            {
+                return false;
+            }
+            HOPSANCORE_CPU_RELAX();
+        }
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        mnSleepers.fetch_add(1);
+        mCondition.wait(lock, [this, arrivalSense](){ return (mSense.load() != arrivalSense) || mAborted.load(); });
+        mnSleepers.fetch_sub(1);
+        return !mAborted.load();
+    }
+
+    //! @brief Aborts the barrier, all waiting and future calls to wait() will return false
+    inline void abort()
+    {
+        mAborted.store(true);
+        std::lock_guard<std::mutex> lock(mMutex);
+        mCondition.notify_all();
+    }
+
+    //! @brief Returns whether or not the barrier has been aborted
+    inline bool wasAborted() const { return mAborted.load(); }
+
+    //! @brief Default number of spin iterations before parking (in the order of a few microseconds)
+    static const size_t defaultSpinBudget = 4000;
+
+private:
+    size_t mnThreads;
+    size_t mSpinBudget;
+    std::atomic<size_t> mCounter;
+    std::atomic<size_t> mnSleepers;
+    std::atomic<bool> mSense;
+    std::atomic<bool> mAborted;
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+};
+
+
+//! @brief Low overhead profiling of multi-threaded a priori scheduled simulations, with adaptive rescheduling
+//! @details Every thread measures the time it is busy and idle (waiting at barriers) in each phase using the cycle
+//! counter. On every sampleInterval:th step, each component is also timed. The master thread periodically checks
+//! the load imbalance between the threads, and if it exceeds the threshold, the sampled component times are used to
+//! move components from the most to the least loaded threads. If the imbalance persists, the following checks are
+//! skipped for an increasing number of intervals. The master must only call checkBalance() while all other threads
+//! are blocked at a barrier, between their calls to beginWait() and endWait().
+class HOPSANCORE_DLLAPI ThreadLoadProfiler
+{
+public:
+    enum PhaseT {SignalPhase, CPhase, QPhase, LogPhase, NumPhases};
+
+    ThreadLoadProfiler(ComponentSystem *pSystem, std::vector< std::vector<Component*> > &rSplitSignalVector,
+                       std::vector< std::vector<Component*> > &rSplitCVector, std::vector< std::vector<Component*> > &rSplitQVector,
+                       size_t sampleInterval, double rescheduleThreshold, size_t rescheduleCheckInterval);
+
+    //! @brief Returns whether component times should be sampled in the given step
+    inline bool isSampleStep(const size_t step) const
+    {
+        return (mSampleInterval > 0) && (step % mSampleInterval == 0);
+    }
+
+    void simulateComponents(const size_t threadID, const PhaseT phase, std::vector<Component*> &rComponents, const double time, const bool sample);
+
+    //! @brief Called by a thread just before it starts waiting at a barrier
+    inline void beginWait(const size_t threadID)
+    {
+        ThreadData &rData = *mThreadData[threadID];
+        const unsigned long long now = HOPSANCORE_READ_CYCLE_COUNTER();
+        rData.mBusyTicks += now-rData.mLastTick;
+        rData.mWindowBusyTicks[rData.mPhase] += now-rData.mLastTick;
+        rData.mLastTick = now;
+    }
+
+    //! @brief Called by a thread when it has passed a barrier
+    //! @param threadID The calling thread
+    //! @param nextPhase The phase the thread is about to start
+    inline void endWait(const size_t threadID, const PhaseT nextPhase)
+    {
+        ThreadData &rData = *mThreadData[threadID];
+        const unsigned long long now = HOPSANCORE_READ_CYCLE_COUNTER();
+        rData.mIdleTicks += now-rData.mLastTick;
+        rData.mLastTick = now;
+        rData.mPhase = nextPhase;
+    }
+
+    //! @brief Returns whether the load balance should be checked at the given step
+    inline bool isCheckStep(const size_t step) const
+    {
+        return (mRescheduleThreshold > 0) && (mRescheduleCheckInterval > 0) && (step > 0) && (step % mRescheduleCheckInterval == 0);
+    }
+
+    void start();
+    void checkBalance();
+    std::vector<ThreadLoadStatistics> getStatistics() const;
+    size_t getNumReschedules() const;
+
+private:
+    //! @brief Per-thread data, only written by the owning thread (and by the master while the others wait)
+    struct ThreadData
+    {
+        unsigned long long mLastTick;
+        unsigned long long mBusyTicks;
+        unsigned long long mIdleTicks;
+        unsigned long long mWindowBusyTicks[NumPhases];
+        size_t mPhase;
+        size_t mNumSamples;
+        size_t mPhaseOffsets[NumPhases];
+        std::vector<unsigned long long> mComponentTicks;
+        char mPadding[64];  // Keep data of different threads on different cache lines
+    };
+
+    void resetSamples();
+    double getTicksPerSecond() const;
+
+    ComponentSystem *mpSystem;
+    std::vector< std::vector<Component*> > &mrSplitSignalVector;
+    std::vector< std::vector<Component*> > &mrSplitCVector;
+    std::vector< std::vector<Component*> > &mrSplitQVector;
+    std::vector< std::unique_ptr<ThreadData> > mThreadData;
+    size_t mSampleInterval;
+    double mRescheduleThreshold;
+    size_t mRescheduleCheckInterval;
+    size_t mNumReschedules;
+    size_t mNumChecksToSkip;
+    size_t mRescheduleBackoff;
+    unsigned long long mStartTick;
+    std::chrono::steady_clock::time_point mStartTime;
+};
+
+
 HOPSANCORE_DLLAPI void simMaster(ComponentSystem *pSystem, std::vector<Component *> &sVector, std::vector<Component *> &cVector,
                                  std::vector<Component *> &qVector, std::vector<Node *> &nVector, std::vector<double *> &pSimTimes,
                                  double startTime, double timeStep, size_t numSimSteps, BarrierLock *pBarrier_S,
-                                 BarrierLock *pBarrier_C, BarrierLock *pBarrier_Q, BarrierLock *pBarrier_N);
+                                 BarrierLock *pBarrier_C, BarrierLock *pBarrier_Q, BarrierLock *pBarrier_N, ThreadLoadProfiler *pProfiler);
 
 HOPSANCORE_DLLAPI void simSlave(ComponentSystem *pSystem, std::vector<Component*> &sVector, std::vector<Component*> &cVector,
-                                std::vector<Component*> &qVector, std::vector<Node*> &nVector, double startTime,
+                                std::vector<Component*> &qVector, std::vector<Node*> &nVector, size_t threadID, double startTime,
                                 double timeStep, size_t numSimSteps, BarrierLock *pBarrier_S,
-                                BarrierLock *pBarrier_C, BarrierLock *pBarrier_Q, BarrierLock *pBarrier_N);
+                                BarrierLock *pBarrier_C, BarrierLock *pBarrier_Q, BarrierLock *pBarrier_N, ThreadLoadProfiler *pProfiler);
 
-HOPSANCORE_DLLAPI void simWholeSystemInRealtime(double realTimeFactor, volatile bool *pStopSimulation, double *pTime, double timeStep, std::vector<Component *> signalComponentPtrs, std::vector<Component *> cComponentPtrs, std::vector<Component *> qComponentPtrs);
+HOPSANCORE_DLLAPI void simHybridBarrierThread(ComponentSystem *pSystem, std::vector<Component*> &sVector, std::vector<Component*> &cVector,
+                                              std::vector<Component*> &qVector, std::vector<double *> &pSimTimes, size_t threadID,
+                                              double startTime, double timeStep, size_t numSimSteps, HybridBarrier *pBarrier,
+                                              ThreadLoadProfiler *pProfiler);
 
 HOPSANCORE_DLLAPI void simWholeSystems(std::vector<ComponentSystem *> systemPtrs, double stopTime);
 
@@ -186,145 +398,272 @@ HOPSANCORE_DLLAPI void simPoolSlave(TaskPool *pTaskPoolC, TaskPool *pTaskPoolQ,
 /////////////////////////////
 
 
-class ThreadSafeVector
+//! @brief Lock-free work-stealing deque for components (Chase-Lev)
+//! @details The owning thread pushes and pops at the bottom end, other threads steal from the top end. The capacity is
+//! fixed (rounded up to a power of two), which is sufficient since the number of tasks in each phase is known in advance.
+//! Only the owner may call push(), pop() and clear(), steal() may be called from any thread.
+class WorkStealingDeque
 {
 public:
-    ThreadSafeVector(std::vector<Component*> data, size_t maxSize)
+    WorkStealingDeque(size_t capacity)
     {
-        mSize = maxSize;
-        mVector.resize(maxSize);
-        for(size_t i=0; i<data.size(); ++i)
+        mCapacity = 1;
+        while(mCapacity < capacity)
         {
-            mVector[i] = data[i];
+            mCapacity *= 2;
         }
-        firstIdx=0;
-        lastIdx=std::max(size_t(1), data.size())-1;
-        mpMutex = new std::mutex();
+        mMask = mCapacity-1;
+        mpBuffer = new std::atomic<Component*>[mCapacity];
+        for(size_t i=0; i<mCapacity; ++i)
+        {
+            mpBuffer[i].store(0, std::memory_order_relaxed);
+        }
+        mTop.store(0);
+        mBottom.store(0);
     }
 
-
-    Component *tryAndTakeFirst()
+    ~WorkStealingDeque()
     {
-        Component *ret;
-        mpMutex->lock();
+        delete[] mpBuffer;
+    }
 
-        int idx = (firstIdx%mSize+mSize)%mSize;
-        ret = mVector[idx];
-        mVector[idx] = 0;
+    //! @brief Returns the maximum number of components the deque can hold
+    inline size_t capacity() const { return mCapacity; }
 
-        if(firstIdx != lastIdx)
-            ++firstIdx;
+    //! @brief Push a component at the bottom end (owner only)
+    //! @returns False if the deque is full
+    inline bool push(Component *pComp)
+    {
+        const long long b = mBottom.load(std::memory_order_relaxed);
+        const long long t = mTop.load(std::memory_order_acquire);
+        if(b-t >= static_cast<long long>(mCapacity))
+        {
+            return false;
+        }
+        mpBuffer[b & mMask].store(pComp, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        mBottom.store(b+1, std::memory_order_relaxed);
+        return true;
+    }
 
-        mpMutex->unlock();
-        return ret;
+    //! @brief Pop a component from the bottom end (owner only)
+    //! @returns Pointer to the component, or 0 if the deque is empty
+    inline Component *pop()
+    {
+        const long long b = mBottom.load(std::memory_order_relaxed)-1;
+        mBottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        long long t = mTop.load(std::memory_order_relaxed);
+        Component *pComp = 0;
+        if(t <= b)
+        {
+            pComp = mpBuffer[b & mMask].load(std::memory_order_relaxed);
+            if(t == b)
+            {
+                // Last element, race against thieves
+                if(!mTop.compare_exchange_strong(t, t+1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                {
+                    pComp = 0;
+                }
+                mBottom.store(b+1, std::memory_order_relaxed);
+            }
+        }
+        else
+        {
+            mBottom.store(b+1, std::memory_order_relaxed);
+        }
+        return pComp;
     }
 
-    Component *tryAndTakeLast()
+    //! @brief Steal a component from the top end (any thread)
+    //! @returns Pointer to the component, or 0 if the deque is empty or another thread won the race
+    inline Component *steal()
     {
-        Component *ret = 0;
-        if(!mpMutex->try_lock())
-            return 0;
+        long long t = mTop.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const long long b = mBottom.load(std::memory_order_acquire);
+        if(t < b)
+        {
+            Component *pComp = mpBuffer[t & mMask].load(std::memory_order_relaxed);
+            if(mTop.compare_exchange_strong(t, t+1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+                return pComp;
+            }
+        }
+        return 0;
+    }
 
-        int idx = (lastIdx%mSize+mSize)%mSize;
-        ret = mVector[idx];
-        mVector[idx] = 0;
+    //! @brief Returns whether the deque appears empty (exact only when no other thread is accessing it)
+    inline bool empty() const
+    {
+        return mBottom.load(std::memory_order_relaxed) <= mTop.load(std::memory_order_relaxed);
+    }
 
-        if(lastIdx != firstIdx)
-            --lastIdx;
+private:
+    WorkStealingDeque(const WorkStealingDeque &);
+    WorkStealingDeque &operator=(const WorkStealingDeque &);
+
+    // Top and bottom are kept on separate cache lines, thieves only write top and the owner mostly writes bottom
+    std::atomic<long long> mTop;
+    char mPadding[64-sizeof(std::atomic<long long>)];
+    std::atomic<long long> mBottom;
+    size_t mCapacity;
+    size_t mMask;
+    std::atomic<Component*> *mpBuffer;
+};
 
-        mpMutex->unlock();
-        return ret;
-    }
 
-    //! @note NOT THREAD-SAFE
-    size_t size()
+//! @brief Work-stealing scheduler with persistent worker threads
+//! @details Each time step, signal components are simulated by the calling (master) thread. C and Q components are
+//! then executed as stealable tasks, each thread first pushes its own tasks to its deque and then pops from it, stealing
+//! from other threads when it runs out. A component that was stolen stays with the thief for the next time step, so
+//! the load balance carries over between steps. The components of subsystems can be given as tasks of their own, the
+//! subsystems are then logged together with the system. Phases are separated by hybrid barriers. The worker threads are kept
+//! between calls to simulate(), and parked while waiting for work.
+class HOPSANCORE_DLLAPI WorkStealingScheduler
+{
+public:
+    WorkStealingScheduler(size_t nThreads, size_t spinBudget=HybridBarrier::defaultSpinBudget);
+    ~WorkStealingScheduler();
+
+    size_t getNumThreads() const;
+    size_t getSpinBudget() const;
+    size_t getNumStolenTasks() const;
+
+    void simulate(ComponentSystem *pSystem, std::vector<Component*> &rSignalComponents,
+                  const std::vector< std::vector<Component*> > &rCComponents, const std::vector< std::vector<Component*> > &rQComponents,
+                  std::vector<double *> &rSimTimes, const std::vector<ComponentSystem*> &rSubSystems, double startTime, double timeStep, size_t numSimSteps);
+
+private:
+    //! @brief Per-thread state, the deque is accessed by other threads, the rest only by the owner
+    struct ThreadState
     {
-        return mVector.size();
-    }
+        ThreadState() : mNumStolen(0), mRandomState(0) {}
+        std::unique_ptr<WorkStealingDeque> mpDeque;
+        std::vector<Component*> mCTasks;
+        std::vector<Component*> mQTasks;
+        size_t mNumStolen;
+        unsigned int mRandomState;
+    };
+
+    WorkStealingScheduler(const WorkStealingScheduler &);
+    WorkStealingScheduler &operator=(const WorkStealingScheduler &);
+
+    void workerLoop(size_t threadID);
+    void runSteps(size_t threadID);
+    void runPhase(size_t threadID, std::vector<Component*> &rOwnTasks, std::atomic<size_t> &rRemaining, double time);
+    Component *stealTask(size_t threadID);
+
+    size_t mnThreads;
+    size_t mSpinBudget;
+    std::vector<std::thread> mWorkers;
+    std::vector< std::unique_ptr<ThreadState> > mThreadStates;
+    std::unique_ptr<HybridBarrier> mpBarrier;
+
+    // Job description, written by the master before a job is started
+    ComponentSystem *mpSystem;
+    std::vector<Component*> *mpSignalComponents;
+    std::vector<double *> *mpSimTimes;
+    const std::vector<ComponentSystem*> *mpSubSystems;
+    double mStartTime;
+    double mTimeStep;
+    size_t mNumSimSteps;
+    size_t mNumCTasks;
+    size_t mNumQTasks;
+    std::atomic<size_t> mRemainingC;
+    std::atomic<size_t> mRemainingQ;
+
+    // Job start and completion handshake with the worker threads
+    std::mutex mJobMutex;
+    std::condition_variable mJobCondition;
+    size_t mJobGeneration;
+    size_t mnFinishedWorkers;
+    bool mQuit;
+};
+
+
+///////////////////////////////////////////
+// Lock-free exchange with other threads //
+///////////////////////////////////////////
+
 
-    void insertFirst(Component* comp)
+//! @brief Lock-free single-producer single-consumer ring buffer of fixed width frames of doubles
+//! @details Used to exchange data with a simulation thread without blocking it. One thread may call push() and one
+//! (other) thread may call pop(), concurrently. The capacity (in frames) is rounded up to a power of two.
+class SpscRingBuffer
+{
+public:
+    SpscRingBuffer(size_t capacity, size_t frameWidth=1)
     {
-        mpMutex->lock();
-        int idx = (firstIdx%mSize+mSize)%mSize;
-        if(firstIdx == lastIdx && mVector[idx] == 0)
+        mCapacity = 1;
+        while(mCapacity < capacity)
         {
-            mVector[idx] = comp;
+            mCapacity *= 2;
         }
-        else
-        {
-            --firstIdx;
-            idx = (firstIdx%mSize+mSize)%mSize;
-            mVector[idx] = comp;
-        }
-        mpMutex->unlock();
+        mMask = mCapacity-1;
+        mFrameWidth = frameWidth;
+        mpBuffer.reset(new double[mCapacity*mFrameWidth]());
+        mHead.store(0);
+        mTail.store(0);
     }
 
+    //! @brief Returns the maximum number of frames the buffer can hold
+    inline size_t capacity() const { return mCapacity; }
 
-    void insertLast(Component* comp)
+    //! @brief Returns the number of doubles in each frame
+    inline size_t frameWidth() const { return mFrameWidth; }
+
+    //! @brief Returns the number of frames in the buffer (exact only when no other thread is accessing it)
+    inline size_t size() const
     {
-        mpMutex->lock();
-        int idx = (firstIdx%mSize+mSize)%mSize;
-        if(firstIdx == lastIdx && mVector[idx] == 0)
-        {
-            mVector[idx] = comp;
-        }
-        else
+        return mTail.load(std::memory_order_acquire) - mHead.load(std::memory_order_acquire);
+    }
+
+    //! @brief Append a frame (producer only)
+    //! @param [in] pFrame The frame to copy, frameWidth() doubles
+    //! @returns False if the buffer is full
+    inline bool push(const double *pFrame)
+    {
+        const size_t t = mTail.load(std::memory_order_relaxed);
+        if(t - mHead.load(std::memory_order_acquire) >= mCapacity)
         {
-            ++lastIdx;
-            int idx = (lastIdx%mSize+mSize)%mSize;
-            mVector[idx] = comp;
+            return false;
         }
-        mpMutex->unlock();
+        std::copy(pFrame, pFrame+mFrameWidth, &mpBuffer[(t & mMask)*mFrameWidth]);
+        mTail.store(t+1, std::memory_order_release);
+        return true;
     }
 
-    //! @note NOT THREAD-SAFE
-    Component* at(size_t idx)
+    //! @brief Remove the oldest frame (consumer only)
+    //! @param [out] pFrame Where to copy the frame, frameWidth() doubles
+    //! @returns False if the buffer is empty
+    inline bool pop(double *pFrame)
     {
-        return mVector[idx];
+        const size_t h = mHead.load(std::memory_order_relaxed);
+        if(h == mTail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        const double *pSource = &mpBuffer[(h & mMask)*mFrameWidth];
+        std::copy(pSource, pSource+mFrameWidth, pFrame);
+        mHead.store(h+1, std::memory_order_release);
+        return true;
     }
 
 private:
-    int mSize;
-    std::vector<Component*> mVector;
-    int firstIdx, lastIdx;
-    std::mutex *mpMutex;
+    SpscRingBuffer(const SpscRingBuffer &);
+    SpscRingBuffer &operator=(const SpscRingBuffer &);
+
+    // Head is only written by the consumer and tail only by the producer, keep them on separate cache lines
+    alignas(64) std::atomic<size_t> mHead;
+    alignas(64) std::atomic<size_t> mTail;
+    size_t mCapacity;
+    size_t mMask;
+    size_t mFrameWidth;
+    std::unique_ptr<double[]> mpBuffer;
 };
 
 
-HOPSANCORE_DLLAPI void simStealingMaster(ComponentSystem *pSystem,
-                                         std::vector<Component*> &sVector,
-                                         std::vector<ThreadSafeVector*> *cVectors,
-                                         std::vector<ThreadSafeVector*> *qVectors,
-                                         std::vector<double *> &pSimTimes,
-                                         double startTime,
-                                         double timeStep,
-                                         size_t numSimSteps,
-                                         size_t nThreads,
-                                         size_t threadID,
-                                         BarrierLock *pBarrier_S,
-                                         BarrierLock *pBarrier_C,
-                                         BarrierLock *pBarrier_Q,
-                                         BarrierLock *pBarrier_N,
-                                         size_t maxSize);
-
-
-
-
-HOPSANCORE_DLLAPI void simStealingSlave(ComponentSystem *pSystem,
-                                        std::vector<ThreadSafeVector*> *cVectors,
-                                        std::vector<ThreadSafeVector*> *qVectors,
-                                        double startTime,
-                                        double timeStep,
-                                        size_t numSimSteps,
-                                        size_t nThreads,
-                                        size_t threadID,
-                                        BarrierLock *pBarrier_S,
-                                        BarrierLock *pBarrier_C,
-                                        BarrierLock *pBarrier_Q,
-                                        BarrierLock *pBarrier_N,
-                                        size_t maxSize);
-
-
 /////////////////////////////////////////////
 // Parallel for loop algorithm using tasks //
 /////////////////////////////////////////////
@@ -0,0 +1,149 @@
+/*-----------------------------------------------------------------------------
+
+ Copyright 2017 Hopsan Group
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+
+ The full license is available in the file LICENSE.
+ For details about the 'Hopsan Group' or information about Authors and
+ Contributors see the HOPSANGROUP and AUTHORS files that are located in
+ the Hopsan source code root directory.
+
+-----------------------------------------------------------------------------*/
+
+//!
+//! @file   NumHopBytecode.h
+//!
+//! @brief Contains a compiler and evaluator for NumHop scripts using flat register based bytecode
+//!
+//$Id$
+
+#ifndef NUMHOPBYTECODE_H
+#define NUMHOPBYTECODE_H
+
+#include <cstddef>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "HopsanTypes.h"
+
+namespace hopsan {
+
+//! @brief Resolves the names used in a NumHop script when it is compiled
+class NumHopSymbolResolver
+{
+public:
+    virtual ~NumHopSymbolResolver() {}
+    //! @brief Get a pointer to a value that may change between evaluations (read and written on every evaluation)
+    //! @returns The pointer, or nullptr if the name is not a data pointer
+    virtual double *getDataPtr(const HString &rName) = 0;
+    //! @brief Get a value that is constant during evaluation, such as a parameter
+    //! @returns True if the name could be resolved
+    virtual bool getConstantValue(const HString &rName, double &rValue) = 0;
+};
+
+//! @brief A NumHop script compiled to flat bytecode
+//! @details All names are resolved when the script is compiled. Script local variables, temporaries and constants are
+//! stored in one register array owned by the program, data pointers are used directly. Constant sub expressions are
+//! folded, and evaluation does not allocate memory.
+//!
+//! Supported are the operators = + - * / ^ < > and parentheses, and the one and two argument built-in functions.
+//! Scripts assigning parameters (names containing a dot), using the boolean operators | and & or using local variables
+//! before they are assigned are rejected, these must be run by the interpreter.
+class NumHopProgram
+{
+public:
+    NumHopProgram();
+
+    bool compile(const std::vector<std::string> &rExpressions, NumHopSymbolResolver &rResolver);
+    void clear();
+    bool isCompiled() const;
+    double eval();
+
+    size_t getNumInstructions() const;
+    const HString &getLastError() const;
+
+    enum OpCodeT {Copy, Add, Subtract, Multiply, Divide, Power, Negate, Less, Greater, Function1, Function2};
+
+private:
+    //! @brief An operand during compilation, either a compile time constant or a register
+    class Operand
+    {
+    public:
+        Operand() : isConstant(true), value(0), reg(0) {}
+        bool isConstant;
+        double value;
+        int reg;    //!< Index into the register array, or -1-index into the data pointers
+    };
+
+    class CompiledInstruction
+    {
+    public:
+        OpCodeT op;
+        int dst, a, b;
+        size_t function;
+    };
+
+    class Instruction
+    {
+    public:
+        OpCodeT op;
+        double *pDst;
+        const double *pA;
+        const double *pB;
+        double (*pFunction1)(double);
+        double (*pFunction2)(double, double);
+    };
+
+    bool compileExpression(const std::string &rExpression, Operand &rResult);
+    bool parseAssignment(Operand &rResult);
+    bool parseComparison(Operand &rResult);
+    bool parseSum(Operand &rResult);
+    bool parseProduct(Operand &rResult);
+    bool parseUnary(Operand &rResult);
+    bool parsePower(Operand &rResult);
+    bool parsePrimary(Operand &rResult);
+    bool parseName(HString &rName);
+    bool parseNumber(double &rValue);
+    bool readVariable(const HString &rName, Operand &rResult);
+    bool assignVariable(const HString &rName, const Operand &rValue, Operand &rResult);
+    Operand emit(const OpCodeT op, const Operand &rA, const Operand &rB, const size_t function=0);
+    int toRegister(const Operand &rOperand);
+    char peek();
+    bool accept(const char c);
+    bool fail(const HString &rError);
+
+    // Compile state
+    NumHopSymbolResolver *mpResolver;
+    const std::string *mpExpression;
+    size_t mPos;
+    std::vector<CompiledInstruction> mCompiledInstructions;
+    std::vector<double> mInitialRegisters;
+    std::vector<double*> mDataPtrs;
+    std::map<std::string, int> mLocalRegisters;
+    std::map<std::string, double> mLocalConstants;
+    std::set<std::string> mExternalNames;
+
+    // Evaluation state
+    std::vector<Instruction> mInstructions;
+    std::vector<double> mRegisters;
+    const double *mpResult;
+    bool mIsCompiled;
+    HString mLastError;
+};
+
+}
+
+#endif // NUMHOPBYTECODE_H
@@ -51,6 +51,10 @@ public:
     bool interpretNumHopScript(const HString &script, bool doPrintOutput, HString &rOutput);
     bool eval(double &rValue, bool doPrintOutput, HString &rOutput);
 
+    bool compileNumHopScript(const HString &script, HString &rOutput);
+    bool isCompiled() const;
+    double evalCompiled();
+
     HVector<HString> extractVariableNames(const HString &expression) const;
     static HVector<HString> extractNamedValues(const HString &expression);
     static HString replaceNamedValue(const HString& expression, const HString &oldName, const HString& newName);
@@ -0,0 +1,180 @@
+/*-----------------------------------------------------------------------------
+
+ Copyright 2017 Hopsan Group
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+
+ The full license is available in the file LICENSE.
+ For details about the 'Hopsan Group' or information about Authors and
+ Contributors see the HOPSANGROUP and AUTHORS files that are located in
+ the Hopsan source code root directory.
+
+-----------------------------------------------------------------------------*/
+
+
+
+//!
+//! @file   RealtimeRunner.h
+//!
+//! @brief Contains the real-time runner, that simulates a system in step with the wall clock, e.g. for hardware-in-the-loop
+//!
+//$Id$
+
+#ifndef REALTIMERUNNER_H
+#define REALTIMERUNNER_H
+
+#include "CoreUtilities/MultiThreadingUtilities.h"
+
+#if defined(HOPSANCORE_USEMULTITHREADING)
+
+#include "HopsanTypes.h"
+
+namespace hopsan {
+
+// Forward declaration
+class ComponentSystem;
+
+//! @brief Timing statistics from a real-time run
+//! @details Latency is the time from the scheduled start of a step to its actual start. Jitter is the deviation of the time
+//! between the starts of two consecutive steps from the period. Bin i in the histograms counts values in
+//! [i*histogramBinWidth, (i+1)*histogramBinWidth), the last bin also counts all larger values.
+class HOPSANCORE_DLLAPI RealtimeStatistics
+{
+public:
+    RealtimeStatistics();
+
+    size_t numSteps;
+    size_t numOverruns;             //!< Steps that were not finished at the scheduled start of the next step
+    size_t maxConsecutiveOverruns;
+    double maxOverrun;              //!< Largest time that a step finished after the scheduled start of the next step [s]
+    double maxLatency, meanLatency; //!< [s]
+    double maxJitter;               //!< [s]
+    double maxExecutionTime, meanExecutionTime; //!< Time to simulate one step, including input and output exchange [s]
+    size_t numInputFrames;          //!< Number of input frames taken from the input queue
+    size_t numDroppedOutputFrames;  //!< Number of output frames that were dropped since the output queue was full
+    double histogramBinWidth;       //!< [s]
+    std::vector<size_t> latencyHistogram;
+    std::vector<size_t> jitterHistogram;
+};
+
+//! @brief Simulates an initialized system in real time, one step per period of the wall clock
+//! @details Each step is started at an absolute time, t0 + k*period, where the period is the time step divided by the
+//! real-time factor. The thread sleeps until shortly before the start and then spins for the remaining time, which
+//! avoids most of the wake-up latency of the operating system. A step that is not finished at the start of the next
+//! step is counted as an overrun, and the following steps either catch up by starting directly, or the schedule is
+//! moved so that the next step starts one period later (see OverrunPolicyT).
+//!
+//! Inputs and outputs are exchanged with other threads through lock-free ring buffers. Before each step, all queued
+//! input frames are taken and the newest one is written to the input variables. After each step (or each
+//! outputDecimation:th step) a frame with the time followed by the output variables is queued, or dropped if the output
+//! queue is full. One thread may push inputs and one thread may pop outputs while the runner is running.
+//!
+//! On Linux, the simulation thread can be pinned to a CPU and given a SCHED_FIFO priority, and all memory of the process
+//! can be locked with mlockall() during the run. Settings that can not be applied are reported as warnings, or abort the
+//! run if they are required. run() applies the settings to the calling thread, start() runs in a new thread.
+//!
+//! The system must be initialized before a run. Settings, inputs and outputs must not be changed while running.
+class HOPSANCORE_DLLAPI RealtimeRunner
+{
+public:
+    enum OverrunPolicyT {CatchUp, Resynchronize};
+
+    RealtimeRunner(ComponentSystem *pSystem);
+    ~RealtimeRunner();
+
+    void setRealTimeFactor(const double factor);
+    void setCpuAffinity(const int cpu);
+    void setRealtimePriority(const int priority);
+    void setLockMemory(const bool lock);
+    void setRequireRealtimeSettings(const bool require);
+    void setSpinTime(const double spinTime);
+    void setOverrunPolicy(const OverrunPolicyT policy);
+    void setHistogram(const double binWidth, const size_t numBins);
+    void setQueueCapacities(const size_t numInputFrames, const size_t numOutputFrames);
+    void setOutputDecimation(const size_t decimation);
+
+    bool addInput(const HString &rComponentName, const HString &rPortName, const HString &rVariableName);
+    bool addOutput(const HString &rComponentName, const HString &rPortName, const HString &rVariableName);
+    void addInput(double *pVariable);
+    void addOutput(double *pVariable);
+    size_t getNumInputs() const;
+    size_t getNumOutputs() const;
+
+    bool pushInputs(const double *pValues);
+    bool popOutputs(double &rTime, double *pValues);
+
+    bool run(const double stopTime);
+    bool start(const double stopTime);
+    void stop();
+    bool wait();
+    bool isRunning() const;
+
+    size_t getNumSteps() const;
+    size_t getNumOverruns() const;
+    const RealtimeStatistics &getStatistics() const;
+    const HString &getLastError() const;
+
+private:
+    RealtimeRunner(const RealtimeRunner &);
+    RealtimeRunner &operator=(const RealtimeRunner &);
+
+    //! @brief An input or output variable, given by name (resolved when a run starts) or directly by pointer
+    class Variable
+    {
+    public:
+        HString componentName, portName, variableName;
+        double *pVariable;
+    };
+
+    double *findVariable(const HString &rComponentName, const HString &rPortName, const HString &rVariableName);
+    bool resolveVariables(std::vector<Variable> &rVariables);
+    void createQueues();
+    bool applyRealtimeSettings(bool &rLockedMemory);
+    bool simulateInRealtime(const double stopTime);
+    void runThread(const double stopTime);
+
+    ComponentSystem *mpSystem;
+    double mRealTimeFactor;
+    int mCpu;
+    int mPriority;
+    bool mLockMemory;
+    bool mRequireRealtimeSettings;
+    double mSpinTime;
+    OverrunPolicyT mOverrunPolicy;
+    double mHistogramBinWidth;
+    size_t mNumHistogramBins;
+    size_t mInputQueueCapacity, mOutputQueueCapacity;
+    size_t mOutputDecimation;
+
+    std::vector<Variable> mInputs;
+    std::vector<Variable> mOutputs;
+    std::unique_ptr<SpscRingBuffer> mpInputQueue;
+    std::unique_ptr<SpscRingBuffer> mpOutputQueue;
+    std::vector<double> mInputFrame, mOutputFrame, mPopFrame;
+
+    std::thread mThread;
+    std::atomic<bool> mRunning;
+    std::atomic<bool> mStop;
+    std::atomic<size_t> mNumSteps;
+    std::atomic<size_t> mNumOverruns;
+    bool mSuccess;
+    RealtimeStatistics mStatistics;
+    HString mLastError;
+};
+
+}
+
+#endif // HOPSANCORE_USEMULTITHREADING
+
+#endif // REALTIMERUNNER_H
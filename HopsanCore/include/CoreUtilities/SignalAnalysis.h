@@ -0,0 +1,171 @@
+/*-----------------------------------------------------------------------------
+
+ Copyright 2017 Hopsan Group
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+
+ The full license is available in the file LICENSE.
+ For details about the 'Hopsan Group' or information about Authors and
+ Contributors see the HOPSANGROUP and AUTHORS files that are located in
+ the Hopsan source code root directory.
+
+-----------------------------------------------------------------------------*/
+
+
+//!
+//! @file   SignalAnalysis.h
+//!
+//! @brief Contains signal analysis utilities: fast Fourier transforms, spectral estimation, transfer functions, RMS and decimation
+//!
+//$Id$
+
+#ifndef SIGNALANALYSIS_H
+#define SIGNALANALYSIS_H
+
+#include <cstddef>
+#include <complex>
+#include <vector>
+#include "win32dll.h"
+#include "HopsanTypes.h"
+
+namespace hopsan {
+
+//! @brief Complex fast Fourier transform of a fixed size
+//! @details Any size can be transformed. Sizes with only small prime factors use a mixed-radix (4, 2, 3, 5 and other small
+//! primes) Stockham algorithm, that needs no bit reversal and accesses the data with unit stride in the inner loops. Other
+//! sizes are transformed with Bluestein's algorithm, using a power of two transform. Twiddle factors are computed once,
+//! so the object should be reused when transforming many vectors of the same size.
+class HOPSANCORE_DLLAPI ComplexFFT
+{
+public:
+    ComplexFFT(const size_t n=0);
+    ~ComplexFFT();
+
+    void setSize(const size_t n);
+    size_t size() const;
+
+    void forward(std::complex<double> *pData);
+    void inverse(std::complex<double> *pData);
+    void forward(std::vector< std::complex<double> > &rData);
+    void inverse(std::vector< std::complex<double> > &rData);
+
+private:
+    //! @brief One pass of the Stockham algorithm
+    struct Stage
+    {
+        size_t radix;
+        size_t length;      //!< The length of the sub transforms in this pass
+        size_t stride;      //!< The number of interleaved sub transforms
+        size_t twiddleOffset;
+        size_t rootOffset;  //!< Offset to the roots of unity used by the generic radix kernel
+    };
+
+    ComplexFFT(const ComplexFFT &);
+    ComplexFFT &operator=(const ComplexFFT &);
+
+    void transformStockham(std::complex<double> *pData);
+    void transformBluestein(std::complex<double> *pData);
+
+    size_t mSize;
+    std::vector<Stage> mStages;
+    std::vector< std::complex<double> > mTwiddles;
+    std::vector< std::complex<double> > mRoots;
+    std::vector< std::complex<double> > mWork;
+
+    // Bluestein's algorithm
+    ComplexFFT *mpBluesteinFFT;
+    std::vector< std::complex<double> > mChirp;
+    std::vector< std::complex<double> > mChirpSpectrum;
+    std::vector< std::complex<double> > mBluesteinWork;
+};
+
+
+//! @brief Fast Fourier transform of real data, giving the non-negative frequency half of the spectrum
+//! @details An even number of real values is transformed with a complex transform of half the size.
+class HOPSANCORE_DLLAPI RealFFT
+{
+public:
+    RealFFT(const size_t n=0);
+
+    void setSize(const size_t n);
+    size_t size() const;
+    size_t spectrumSize() const;
+
+    void forward(const double *pInput, std::complex<double> *pSpectrum);
+    void forward(const std::vector<double> &rInput, std::vector< std::complex<double> > &rSpectrum);
+
+private:
+    size_t mSize;
+    ComplexFFT mFFT;
+    std::vector< std::complex<double> > mTwiddles;
+    std::vector< std::complex<double> > mWork;
+};
+
+
+//! @brief Spectral estimation using Welch's method, averaging the spectra of overlapping windowed segments
+//! @details With the segment length set to zero, the whole signal is used as one segment. Spectra are one-sided, from zero
+//! to half the sample frequency, and the frequency vectors are in Hz.
+class HOPSANCORE_DLLAPI SpectrumAnalyzer
+{
+public:
+    enum WindowT {Rectangular, Hann, FlatTop};
+    enum ScalingT {PowerSpectralDensity, EnergySpectralDensity, PowerSpectrum, RmsSpectrum};
+
+    SpectrumAnalyzer();
+
+    void setWindow(const WindowT window);
+    void setSegmentLength(const size_t length, const size_t overlap=0);
+    void setRemoveMean(const bool removeMean);
+
+    bool spectrum(const std::vector<double> &rData, const double sampleFrequency, const ScalingT scaling,
+                  std::vector<double> &rFrequency, std::vector<double> &rSpectrum);
+    bool transferFunction(const std::vector<double> &rInput, const std::vector<double> &rOutput, const double sampleFrequency,
+                          std::vector<double> &rFrequency, std::vector< std::complex<double> > &rTransferFunction,
+                          std::vector<double> *pCoherence=0);
+    bool frequencies(const size_t numSamples, const double sampleFrequency, std::vector<double> &rFrequency);
+
+    const HString &getLastError() const;
+
+    static void createWindow(const WindowT window, const size_t n, std::vector<double> &rWindow);
+
+private:
+    bool determineSegments(const size_t dataSize, const double sampleFrequency);
+    bool prepareSegments(const size_t dataSize, const double sampleFrequency);
+    void fillFrequencies(const double sampleFrequency, std::vector<double> &rFrequency) const;
+    void windowSegment(const double *pData, std::vector<double> &rSegment) const;
+
+    WindowT mWindowType;
+    size_t mRequestedSegmentLength;
+    size_t mRequestedOverlap;
+    bool mRemoveMean;
+    size_t mSegmentLength;
+    size_t mSegmentStep;
+    size_t mNumSegments;
+    std::vector<double> mWindow;
+    RealFFT mFFT;
+    std::vector<double> mSegment;
+    std::vector< std::complex<double> > mSpectrum;
+    std::vector< std::complex<double> > mOutputSpectrum;
+    HString mLastError;
+};
+
+HOPSANCORE_DLLAPI void bodeFromTransferFunction(const std::vector< std::complex<double> > &rTransferFunction,
+                                                std::vector<double> &rGain, std::vector<double> &rPhase);
+HOPSANCORE_DLLAPI double rms(const double *pData, const size_t n);
+HOPSANCORE_DLLAPI void movingRms(const std::vector<double> &rData, const size_t windowLength, std::vector<double> &rRms);
+HOPSANCORE_DLLAPI void decimate(const std::vector<double> &rData, const size_t factor, std::vector<double> &rDecimated);
+
+}
+
+#endif // SIGNALANALYSIS_H
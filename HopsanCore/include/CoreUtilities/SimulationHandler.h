@@ -44,7 +44,8 @@ enum ParallelAlgorithmT {APrioriScheduling,
                          TaskPoolAlgorithm,
                          TaskStealingAlgorithm,
                          ForkJoinAlgorithm,
-                         ClusteredForkJoinAlgorithm};
+                         ClusteredForkJoinAlgorithm,
+                         APrioriHybridBarrierScheduling};
 
 // Forward declaration
 class ComponentSystem;
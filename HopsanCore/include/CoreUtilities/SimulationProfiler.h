@@ -0,0 +1,90 @@
+/*-----------------------------------------------------------------------------
+
+ Copyright 2017 Hopsan Group
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+
+ The full license is available in the file LICENSE.
+ For details about the 'Hopsan Group' or information about Authors and
+ Contributors see the HOPSANGROUP and AUTHORS files that are located in
+ the Hopsan source code root directory.
+
+-----------------------------------------------------------------------------*/
+
+//!
+//! @file   SimulationProfiler.h
+//!
+//! @brief Contains the per-component simulation profiler and the profile report
+//!
+//$Id$
+
+#ifndef SIMULATIONPROFILER_H
+#define SIMULATIONPROFILER_H
+
+#include <cstddef>
+#include <vector>
+#include "win32dll.h"
+#include "HopsanTypes.h"
+
+namespace hopsan {
+
+// Forward declaration
+class Component;
+
+//! @brief One entry in a hierarchical simulation profile, a system entry has one child per sub component
+class HOPSANCORE_DLLAPI ProfileEntry
+{
+public:
+    ProfileEntry() : totalTime(0), numCalls(0) {}
+    double getSelfTime() const;
+
+    HString name;
+    HString typeName;
+    double totalTime;   //!< Accumulated wall time, including children [s]
+    size_t numCalls;    //!< Number of simulate calls (time steps)
+    std::vector<ProfileEntry> children;
+};
+
+HOPSANCORE_DLLAPI HString profileReportToJSON(const ProfileEntry &rRoot);
+HOPSANCORE_DLLAPI HString profileReportToCSV(const ProfileEntry &rRoot);
+
+//! @brief Accumulates wall time and number of calls for each component in one system
+//! @details The profiler is only created when profiling is enabled, so simulation without profiling is unaffected
+class SimulationProfiler
+{
+public:
+    SimulationProfiler();
+    void setup(const std::vector<Component*> &rSignalComponents, const std::vector<Component*> &rCComponents,
+               const std::vector<Component*> &rQComponents);
+    void simulateSignalComponents(const double time);
+    void simulateCComponents(const double time);
+    void simulateQComponents(const double time);
+    void addStep(const double stepTime, const double logTime);
+    ProfileEntry getReport(const HString &rName, const HString &rTypeName) const;
+
+private:
+    void simulateComponents(const size_t offset, const size_t numComponents, const double time);
+
+    std::vector<Component*> mComponents;    //!< Signal, C and Q components, in simulation order
+    std::vector<double> mTimes;
+    std::vector<size_t> mNumCalls;
+    size_t mNumSignal, mNumC, mNumQ;
+    double mTotalTime;
+    double mLogTime;
+    size_t mNumSteps;
+};
+
+}
+
+#endif // SIMULATIONPROFILER_H
@@ -0,0 +1,134 @@
+/*-----------------------------------------------------------------------------
+
+ Copyright 2017 Hopsan Group
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+
+ The full license is available in the file LICENSE.
+ For details about the 'Hopsan Group' or information about Authors and
+ Contributors see the HOPSANGROUP and AUTHORS files that are located in
+ the Hopsan source code root directory.
+
+-----------------------------------------------------------------------------*/
+
+//!
+//! @file   SimulationState.h
+//!
+//! @brief Contains helpers for serializing the simulation state of components into a byte buffer
+//!
+//$Id$
+
+#ifndef SIMULATIONSTATE_H
+#define SIMULATIONSTATE_H
+
+#include <cstddef>
+#include <vector>
+#include "win32dll.h"
+
+namespace hopsan {
+
+class Component;
+
+//! @brief Appends binary state data to a byte buffer
+//! @details Values are stored in native byte order, a state can only be restored on the same platform and into the same model
+class HOPSANCORE_DLLAPI StateWriter
+{
+public:
+    StateWriter(std::vector<char> &rBuffer);
+
+    void writeDouble(const double value);
+    void writeDoubles(const double *pValues, const size_t numValues);
+    void writeSize(const size_t value);
+    void writeInt(const int value);
+    void writeBool(const bool value);
+    void writeRaw(const void *pData, const size_t numBytes);
+
+private:
+    std::vector<char> &mrBuffer;
+};
+
+//! @brief Reads binary state data written by a StateWriter
+//! @details If a read goes past the end of the data, the reader is marked as failed and all following reads fail
+class HOPSANCORE_DLLAPI StateReader
+{
+public:
+    StateReader(const std::vector<char> &rBuffer);
+    StateReader(const char *pData, const size_t size);
+
+    bool readDouble(double &rValue);
+    bool readDoubles(double *pValues, const size_t numValues);
+    bool readSize(size_t &rValue);
+    bool readInt(int &rValue);
+    bool readBool(bool &rValue);
+    bool readRaw(void *pData, const size_t numBytes);
+
+    bool atEnd() const;
+    bool hasFailed() const;
+
+private:
+    const char *mpData;
+    size_t mSize;
+    size_t mPosition;
+    bool mFailed;
+};
+
+//! @brief Base class for component utilities with internal state, such as delays, integrators and transfer functions
+//! @details Objects constructed within a StateObjectRegistrationScope register themselves with the component of the scope.
+//! This covers members of components created by HopsanEssentials::createComponent() and objects created in initialize().
+//! Their state is then included in the component state by the default implementation of Component::saveState() and
+//! Component::restoreState(). Other objects must be registered with Component::registerStateObject() to be included.
+class HOPSANCORE_DLLAPI ComponentStateObject
+{
+public:
+    ComponentStateObject();
+    ComponentStateObject(const ComponentStateObject &rOther);
+    virtual ~ComponentStateObject();
+    ComponentStateObject &operator=(const ComponentStateObject &rOther);
+
+    //! @brief Write the internal state to a state buffer
+    virtual void saveState(StateWriter &rWriter) const = 0;
+    //! @brief Restore the internal state from a state buffer
+    //! @returns false if the state could not be read
+    virtual bool restoreState(StateReader &rReader) = 0;
+
+private:
+    friend class Component;
+    Component *mpOwner;
+};
+
+//! @brief Makes state objects constructed in this thread register with a component, while the scope exists
+//! @details A scope created without a component binds to the first component constructed while it exists. Scopes nest, the
+//! previous scope is active again when a scope is destroyed. Outside of all scopes, state objects are not registered.
+class HOPSANCORE_DLLAPI StateObjectRegistrationScope
+{
+public:
+    StateObjectRegistrationScope(Component *pComponent=0);
+    ~StateObjectRegistrationScope();
+
+    static Component *getCurrentComponent();
+    static void componentConstructed(Component *pComponent);
+    static void componentDestroyed(Component *pComponent);
+
+private:
+    StateObjectRegistrationScope(const StateObjectRegistrationScope &);
+    StateObjectRegistrationScope &operator=(const StateObjectRegistrationScope &);
+
+    StateObjectRegistrationScope *mpPrevious;
+    Component *mpComponent;
+    bool mWaitingForComponent;
+};
+
+}
+
+#endif // SIMULATIONSTATE_H
@@ -93,6 +93,63 @@ HString findUniqueName(const ContainerT &rContainer, HString name)
     return name.c_str();
 }
 
+//! @brief Help function for create a unique name among names from one STL Container, remembering the suffixes already taken
+//! @details Gives the same name as findUniqueName() above, but the suffix search for each base name continues from where it
+//! previously ended, instead of from _1. This keeps adding many components with the same base name linear instead of quadratic.
+//! @param [in] rContainer The container with taken names
+//! @param [in] name The desired name
+//! @param [in,out] rSuffixCounters Map from base name to the lowest suffix that may be free, all lower suffixes must be taken.
+//! The caller must lower the counter if a name with a lower suffix is removed from the container
+template<typename ContainerT, typename CounterMapT>
+HString findUniqueName(const ContainerT &rContainer, HString name, CounterMapT &rSuffixCounters)
+{
+    // New name must not be empty, empty name is "reserved" to be used in the API to indicate that we want to manipulate the current root system
+    if (name.empty())
+    {
+        name = "noName";
+    }
+
+    // Make sure name is sane
+    santizeName(name);
+
+    if (rContainer.find(name) == rContainer.end())
+    {
+        return name;
+    }
+
+    // Strip any suffix, in the same way as findUniqueName() above
+    size_t foundpos = name.rfind('_');
+    if ((foundpos != HString::npos) && (foundpos+1 < name.size()))
+    {
+        unsigned char nr = name.at(foundpos+1);
+        if ((nr >= 48) && (nr <= 57))
+        {
+            name.erase(foundpos, HString::npos);
+        }
+    }
+
+    size_t &rCtr = rSuffixCounters[name];
+    if (rCtr == 0)
+    {
+        rCtr = 1;
+    }
+    HString newName;
+    while (true)
+    {
+        std::stringstream suffix;
+        suffix << rCtr;
+        newName = name;
+        newName.append("_").append(suffix.str().c_str());
+        if (rContainer.find(newName) == rContainer.end())
+        {
+            break;
+        }
+        ++rCtr;
+    }
+
+    return newName;
+}
+
 //inline bool contains(const HString &rString, const HString &rPattern)
 //{
 //    return rString.find(rPattern) != HString::npos;
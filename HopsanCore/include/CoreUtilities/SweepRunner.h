@@ -0,0 +1,136 @@
+/*-----------------------------------------------------------------------------
+
+ Copyright 2017 Hopsan Group
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+
+ The full license is available in the file LICENSE.
+ For details about the 'Hopsan Group' or information about Authors and
+ Contributors see the HOPSANGROUP and AUTHORS files that are located in
+ the Hopsan source code root directory.
+
+-----------------------------------------------------------------------------*/
+
+
+//!
+//! @file   SweepRunner.h
+//!
+//! @brief Contains the parameter sweep runner, that simulates many parameter cases of one model in parallel
+//!
+//$Id$
+
+#ifndef SWEEPRUNNER_H
+#define SWEEPRUNNER_H
+
+#include <cstddef>
+#include <vector>
+#include "win32dll.h"
+#include "HopsanTypes.h"
+#include "CoreUtilities/MultiThreadingUtilities.h"
+
+namespace hopsan {
+
+// Forward declaration
+class Component;
+class ComponentSystem;
+class HopsanEssentials;
+class Port;
+
+//! @brief The result of one case in a parameter sweep
+class HOPSANCORE_DLLAPI SweepCaseResult
+{
+public:
+    SweepCaseResult() : success(false) {}
+
+    bool success;
+    HString errorMessage;
+    std::vector<double> time;                   //!< The logged time vector (only the final time unless time series are kept)
+    std::vector< std::vector<double> > values;  //!< One vector per result variable, with the same length as time
+};
+
+//! @brief Runs a parameter sweep, simulating one model with many parameter cases
+//! @details The model file is parsed once and one independent instance of the model is created per worker thread. Each worker
+//! takes the next unsimulated case, applies its parameter values to its own instance, simulates it and extracts the requested
+//! result variables. The instances are kept between runs.
+//!
+//! Parameter names are given as in CSV parameter exports: "Component#Parameter", "Component#Port#Variable" for start values,
+//! "self#Parameter" for root system parameters and "Subsystem$Component#Parameter" in subsystems. Result variables are given
+//! as "Component#Port#Variable" or "Subsystem$Component#Port#Variable", or as a root system alias.
+class HOPSANCORE_DLLAPI SweepRunner
+{
+public:
+    SweepRunner(HopsanEssentials *pHopsanEssentials);
+    ~SweepRunner();
+
+    bool loadModel(const HString &rFilePath);
+    void setSimulationTime(const double startTime, const double timeStep, const double stopTime);
+    void setNumLogSamples(const size_t numLogSamples);
+    void setKeepTimeSeries(const bool keep);
+
+    void setParameterNames(const std::vector<HString> &rNames);
+    const std::vector<HString> &getParameterNames() const;
+    bool addCase(const std::vector<HString> &rValues);
+    bool loadParameterTable(const HString &rFilePath);
+    void clearCases();
+    size_t getNumCases() const;
+    const std::vector<HString> &getCaseValues(const size_t caseIdx) const;
+
+    void setResultVariables(const std::vector<HString> &rVariables);
+    const std::vector<HString> &getResultVariables() const;
+
+    bool run(const size_t nDesiredThreads=0);
+    const SweepCaseResult &getResult(const size_t caseIdx) const;
+    size_t getNumFailedCases() const;
+    const HString &getLastError() const;
+
+private:
+    //! @brief One model instance, with the parameters and variables of the sweep resolved
+    class Instance
+    {
+    public:
+        ComponentSystem *pSystem;
+        std::vector<Component*> parameterComponents;
+        std::vector<HString> parameterNames;
+        std::vector<Port*> resultPorts;
+        std::vector<int> resultDataIds;
+    };
+
+    bool createInstances(const size_t numInstances);
+    bool resolveInstance(Instance &rInstance);
+    void clearInstances();
+    void runCases(Instance *pInstance);
+    void runCase(Instance &rInstance, const size_t caseIdx);
+
+    HopsanEssentials *mpHopsanEssentials;
+    HString mModelFilePath;
+    double mStartTime, mTimeStep, mStopTime;
+    size_t mNumLogSamples;
+    bool mKeepTimeSeries;
+
+    std::vector<HString> mParameterNames;
+    std::vector< std::vector<HString> > mCases;
+    std::vector<HString> mResultVariables;
+    std::vector<SweepCaseResult> mResults;
+    std::vector<Instance> mInstances;
+#if defined(HOPSANCORE_USEMULTITHREADING)
+    std::atomic<size_t> mNextCase;
+#else
+    size_t mNextCase;
+#endif
+    HString mLastError;
+};
+
+}
+
+#endif // SWEEPRUNNER_H
@@ -33,6 +33,8 @@
 #define NODE_H_INCLUDED
 
 #include <vector>
+#include <stdexcept>
+#include <algorithm>
 #include "HopsanTypes.h"
 #include "CoreUtilities/ClassFactory.hpp"
 #include "win32dll.h"
@@ -62,6 +64,89 @@ public:
     size_t id;
 };
 
+//! @brief Storage for the data variables in a node
+//! @details The values are kept in an internal vector until the node is packed into the node data arena of its owner
+//! system, after that the values live in the (contiguous) arena memory instead. Values are copied automatically
+//! when switching between the internal and the external storage.
+class NodeDataVector
+{
+public:
+    NodeDataVector() : mpData(0), mUsesExternalStorage(false) {}
+
+    inline double &operator[](const size_t i) { return mpData[i]; }
+    inline const double &operator[](const size_t i) const { return mpData[i]; }
+
+    //! @brief Bounds checked element access
+    double &at(const size_t i)
+    {
+        if (i >= size())
+        {
+            throw std::out_of_range("NodeDataVector::at()");
+        }
+        return mpData[i];
+    }
+
+    const double &at(const size_t i) const
+    {
+        if (i >= size())
+        {
+            throw std::out_of_range("NodeDataVector::at()");
+        }
+        return mpData[i];
+    }
+
+    inline size_t size() const { return mValues.size(); }
+    inline bool empty() const { return mValues.empty(); }
+    inline double *data() { return mpData; }
+    inline const double *data() const { return mpData; }
+    inline double *begin() { return mpData; }
+    inline double *end() { return mpData+size(); }
+    inline const double *begin() const { return mpData; }
+    inline const double *end() const { return mpData+size(); }
+
+    //! @brief Resize the storage, this will release any external storage
+    void resize(const size_t n, const double value=0.0)
+    {
+        releaseExternalStorage();
+        mValues.resize(n, value);
+        mpData = mValues.empty() ? 0 : &mValues[0];
+    }
+
+    void clear()
+    {
+        resize(0);
+    }
+
+    //! @brief Move the values into external memory, that must be at least size() long and outlive this object (or the binding)
+    void useExternalStorage(double *pExternal)
+    {
+        std::copy(begin(), end(), pExternal);
+        mpData = pExternal;
+        mUsesExternalStorage = true;
+    }
+
+    //! @brief Copy the values back from external memory and use the internal storage again
+    void releaseExternalStorage()
+    {
+        if (mUsesExternalStorage)
+        {
+            std::copy(mpData, mpData+size(), mValues.begin());
+            mpData = mValues.empty() ? 0 : &mValues[0];
+            mUsesExternalStorage = false;
+        }
+    }
+
+    inline bool usesExternalStorage() const { return mUsesExternalStorage; }
+
+private:
+    NodeDataVector(const NodeDataVector &) = delete;
+    NodeDataVector &operator=(const NodeDataVector &) = delete;
+
+    std::vector<double> mValues;
+    double *mpData;
+    bool mUsesExternalStorage;
+};
+
 class HOPSANCORE_DLLAPI Node
 {
     friend class Port;
@@ -108,6 +193,9 @@ public:
     virtual bool getSignalQuantityModifyable(const size_t dataId=0) const;
 
     void logData(const size_t logSlot);
+    bool isLogging() const;
+    const std::vector<double> *getLogDataVariablePtr(const size_t dataId) const;
+    size_t getLogDataDecimation(const size_t dataId) const;
 
     int getNumberOfPortsByType(const int type) const;
     size_t getNumConnectedPorts() const;
@@ -127,6 +215,7 @@ protected:
     virtual void copySignalQuantityAndUnitTo(Node *pOtherNode) const;
     virtual void setTLMNodeDataValuesTo(Node *pOtherNode) const;
 
+    void setupLogPlan();
     void preAllocateLogSpace(const size_t nLogSlots);
 
     double *getDataPtr(const size_t data_type);
@@ -134,7 +223,7 @@ protected:
     // Protected member variables
     HString mNiceName;
     std::vector<NodeDataDescription> mDataDescriptions;
-    std::vector<double> mDataValues;
+    NodeDataVector mDataValues;
 
 private:
     // Private member functions
@@ -149,7 +238,9 @@ private:
     ComponentSystem *mpOwnerSystem;
 
     // Log specific variables
-    std::vector<std::vector<double> > mDataStorage;
+    std::vector<std::vector<double> > mDataStorage;     //!< One (decimated) log vector per logged data variable
+    std::vector<size_t> mLoggedDataIds;                 //!< The data id of each logged variable (same order as mDataStorage)
+    std::vector<size_t> mLogDecimations;                //!< The decimation factor of each logged variable (same order as mDataStorage)
     bool mDoLog;
 };
 
@@ -218,21 +218,21 @@ public:
 
 inline void readHydraulicPort_pq(Port *pPort, double &p, double &q)
 {
-    const std::vector<double> &rData = pPort->getNodeDataVector();
+    const NodeDataVector &rData = pPort->getNodeDataVector();
     q = rData[NodeHydraulic::Flow];
     p = rData[NodeHydraulic::Pressure];
 }
 
 inline void readHydraulicPort_cZc(Port *pPort, double &c, double &Zc)
 {
-    const std::vector<double> &rData = pPort->getNodeDataVector();
+    const NodeDataVector &rData = pPort->getNodeDataVector();
     c = rData[NodeHydraulic::WaveVariable];
     Zc = rData[NodeHydraulic::CharImpedance];
 }
 
 inline void readHydraulicPort_all(Port *pPort, double &p, double &q, double &c, double &Zc)
 {
-    const std::vector<double> &rData = pPort->getNodeDataVector();
+    const NodeDataVector &rData = pPort->getNodeDataVector();
     q = rData[NodeHydraulic::Flow];
     p = rData[NodeHydraulic::Pressure];
     c = rData[NodeHydraulic::WaveVariable];
@@ -241,7 +241,7 @@ inline void readHydraulicPort_all(Port *pPort, double &p, double &q, double &c,
 
 inline void readHydraulicPort_all(Port *pPort, HydraulicNodeDataValueStructT &rValues)
 {
-    const std::vector<double> &rData = pPort->getNodeDataVector();
+    const NodeDataVector &rData = pPort->getNodeDataVector();
     rValues.q = rData[NodeHydraulic::Flow];
     rValues.p = rData[NodeHydraulic::Pressure];
     rValues.c = rData[NodeHydraulic::WaveVariable];
@@ -258,7 +258,7 @@ inline void getHydraulicPortNodeDataPointers(Port *pPort, HydraulicNodeDataPoint
 
 inline void getHydraulicMultiPortValues_pq(Port *pMainPort, const size_t subPortIdx, std::vector<HydraulicNodeDataValueStructT> &rValues)
 {
-    const std::vector<double> &rData = pMainPort->getNodeDataVector(subPortIdx);
+    const NodeDataVector &rData = pMainPort->getNodeDataVector(subPortIdx);
     rValues[subPortIdx].q = rData[NodeHydraulic::Flow];
     rValues[subPortIdx].p = rData[NodeHydraulic::Pressure];
 //    rValues[subPortIdx].c = rData[NodeHydraulic::WaveVariable];
@@ -267,7 +267,7 @@ inline void getHydraulicMultiPortValues_pq(Port *pMainPort, const size_t subPort
 
 inline void getHydraulicMultiPortValues_cZc(Port *pMainPort, const size_t subPortIdx, std::vector<HydraulicNodeDataValueStructT> &rValues)
 {
-    const std::vector<double> &rData = pMainPort->getNodeDataVector(subPortIdx);
+    const NodeDataVector &rData = pMainPort->getNodeDataVector(subPortIdx);
 //    rValues[subPortIdx].q = rData[NodeHydraulic::Flow];
 //    rValues[subPortIdx].p = rData[NodeHydraulic::Pressure];
     rValues[subPortIdx].c = rData[NodeHydraulic::WaveVariable];
@@ -276,7 +276,7 @@ inline void getHydraulicMultiPortValues_cZc(Port *pMainPort, const size_t subPor
 
 inline void readHydraulicMultiPortValues_all(Port *pMainPort, const size_t subPortIdx, std::vector<HydraulicNodeDataValueStructT> &rValues)
 {
-    const std::vector<double> &rData = pMainPort->getNodeDataVector(subPortIdx);
+    const NodeDataVector &rData = pMainPort->getNodeDataVector(subPortIdx);
     rValues[subPortIdx].q = rData[NodeHydraulic::Flow];
     rValues[subPortIdx].p = rData[NodeHydraulic::Pressure];
     rValues[subPortIdx].c = rData[NodeHydraulic::WaveVariable];
@@ -287,7 +287,7 @@ inline void readHydraulicMultiPortValues_all(Port *pMainPort, std::vector<Hydrau
 {
     for (size_t i=0; i<pMainPort->getNumPorts(); ++i)
     {
-        const std::vector<double> &rData = pMainPort->getNodeDataVector(i);
+        const NodeDataVector &rData = pMainPort->getNodeDataVector(i);
         rValues[i].q = rData[NodeHydraulic::Flow];
         rValues[i].p = rData[NodeHydraulic::Pressure];
         rValues[i].c = rData[NodeHydraulic::WaveVariable];
@@ -317,35 +317,35 @@ inline void getHydraulicMultiPortNodeDataPointers(Port *pMainPort, std::vector<H
 
 inline void writeHydraulicPort_pq(Port *pPort, const double p, const double q)
 {
-    std::vector<double> &rData = pPort->getNodeDataVector();
+    NodeDataVector &rData = pPort->getNodeDataVector();
     rData[NodeHydraulic::Flow] = q;
     rData[NodeHydraulic::Pressure] = p;
 }
 
 inline void writeHydraulicMultiPort_pq(Port *pPort, const size_t subPortIdx, const double p, const double q)
 {
-    std::vector<double> &rData = pPort->getNodeDataVector(subPortIdx);
+    NodeDataVector &rData = pPort->getNodeDataVector(subPortIdx);
     rData[NodeHydraulic::Flow] = q;
     rData[NodeHydraulic::Pressure] = p;
 }
 
 inline void writeHydraulicPort_cZc(Port *pPort, const double c, const double Zc)
 {
-    std::vector<double> &rData = pPort->getNodeDataVector();
+    NodeDataVector &rData = pPort->getNodeDataVector();
     rData[NodeHydraulic::WaveVariable] = c;
     rData[NodeHydraulic::CharImpedance] = Zc;
 }
 
 inline void writeHydraulicMultiPort_cZc(Port *pPort, const size_t subPortIdx, const double c, const double Zc)
 {
-    std::vector<double> &rData = pPort->getNodeDataVector(subPortIdx);
+    NodeDataVector &rData = pPort->getNodeDataVector(subPortIdx);
     rData[NodeHydraulic::WaveVariable] = c;
     rData[NodeHydraulic::CharImpedance] = Zc;
 }
 
 inline void writeHydraulicPort_all(Port *pPort, const double p, const double q, const double c, const double Zc)
 {
-    std::vector<double> &rData = pPort->getNodeDataVector();
+    NodeDataVector &rData = pPort->getNodeDataVector();
     rData[NodeHydraulic::Flow] = q;
     rData[NodeHydraulic::Pressure] = p;
     rData[NodeHydraulic::WaveVariable] = c;
@@ -354,7 +354,7 @@ inline void writeHydraulicPort_all(Port *pPort, const double p, const double q,
 
 inline void writeHydraulicPort_all(Port *pPort, const HydraulicNodeDataValueStructT &rValues)
 {
-    std::vector<double> &rData = pPort->getNodeDataVector();
+    NodeDataVector &rData = pPort->getNodeDataVector();
     rData[NodeHydraulic::Flow] = rValues.q;
     rData[NodeHydraulic::Pressure] = rValues.p;
     rData[NodeHydraulic::WaveVariable] = rValues.c;
@@ -450,7 +450,7 @@ public:
 
 inline void readMechanicPort_vfx(Port *pPort, double &v, double &f, double &x)
 {
-    const std::vector<double> &rData = pPort->getNodeDataVector();
+    const NodeDataVector &rData = pPort->getNodeDataVector();
     v = rData[NodeMechanic::Velocity];
     f = rData[NodeMechanic::Force];
     x = rData[NodeMechanic::Position];
@@ -458,14 +458,14 @@ inline void readMechanicPort_vfx(Port *pPort, double &v, double &f, double &x)
 
 inline void readMechanicPort_cZc(Port *pPort, double &c, double &Zc)
 {
-    const std::vector<double> &rData = pPort->getNodeDataVector();
+    const NodeDataVector &rData = pPort->getNodeDataVector();
     c = rData[NodeMechanic::WaveVariable];
     Zc = rData[NodeMechanic::CharImpedance];
 }
 
 inline void readMechanicPort_all(Port *pPort, double &v, double &f, double &x, double &c, double &Zc, double &me)
 {
-    const std::vector<double> &rData = pPort->getNodeDataVector();
+    const NodeDataVector &rData = pPort->getNodeDataVector();
     v = rData[NodeMechanic::Velocity];
     f = rData[NodeMechanic::Force];
     x = rData[NodeMechanic::Position];
@@ -476,7 +476,7 @@ inline void readMechanicPort_all(Port *pPort, double &v, double &f, double &x, d
 
 inline void readMechanicPort_all(Port *pPort, MechanicNodeDataValueStructT &rValues)
 {
-    const std::vector<double> &rData = pPort->getNodeDataVector();
+    const NodeDataVector &rData = pPort->getNodeDataVector();
     rValues.v = rData[NodeMechanic::Velocity];
     rValues.f = rData[NodeMechanic::Force];
     rValues.x = rData[NodeMechanic::Position];
@@ -487,7 +487,7 @@ inline void readMechanicPort_all(Port *pPort, MechanicNodeDataValueStructT &rVal
 
 inline void writeMechanicPort_vfx(Port *pPort, const double v, const double f, const double x)
 {
-    std::vector<double> &rData = pPort->getNodeDataVector();
+    NodeDataVector &rData = pPort->getNodeDataVector();
     rData[NodeMechanic::Velocity] = v;
     rData[NodeMechanic::Force] = f;
     rData[NodeMechanic::Position] = x;
@@ -495,14 +495,14 @@ inline void writeMechanicPort_vfx(Port *pPort, const double v, const double f, c
 
 inline void writeMechanicPort_cZc(Port *pPort, const double c, const double Zc)
 {
-    std::vector<double> &rData = pPort->getNodeDataVector();
+    NodeDataVector &rData = pPort->getNodeDataVector();
     rData[NodeMechanic::WaveVariable] = c;
     rData[NodeMechanic::CharImpedance] = Zc;
 }
 
 inline void writeMechanicPort_all(Port *pPort, const double v, const double f, const double x, const double c, const double Zc, const double me)
 {
-    std::vector<double> &rData = pPort->getNodeDataVector();
+    NodeDataVector &rData = pPort->getNodeDataVector();
     rData[NodeMechanic::Velocity] = v;
     rData[NodeMechanic::Force] = f;
     rData[NodeMechanic::Position] = x;
@@ -513,7 +513,7 @@ inline void writeMechanicPort_all(Port *pPort, const double v, const double f, c
 
 inline void writeMechanicPort_all(Port *pPort, const MechanicNodeDataValueStructT &rValues)
 {
-    std::vector<double> &rData = pPort->getNodeDataVector();
+    NodeDataVector &rData = pPort->getNodeDataVector();
     rData[NodeMechanic::Velocity] = rValues.v;
     rData[NodeMechanic::Force] = rValues.f;
     rData[NodeMechanic::Position] = rValues.x;
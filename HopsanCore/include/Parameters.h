@@ -41,11 +41,14 @@ namespace hopsan {
 
 //Forward declaration
 class Component;
+class ComponentSystem;
 class ParameterEvaluatorHandler;
+class ParameterHandle;
 
 class HOPSANCORE_DLLAPI ParameterEvaluator
 {
     friend class ParameterEvaluatorHandler;
+    friend class ParameterHandle;
 public:
     ParameterEvaluator(const HString &rName, const HString &rValue, const HString &rDescription, const HString &rQuantity, const HString &rUnit,
                        const HString &rType, const bool internal=false, void* pDataPtr=0, ParameterEvaluatorHandler* pParameterEvalHandler=0);
@@ -74,10 +77,13 @@ public:
 
 protected:
     void resolveSignPrefix(HString &rSignPrefix) const;
-    void splitSignPrefix(const HString &rString, HString &rPrefix, HString &rValue);
+    void splitSignPrefix(const HString &rString, HString &rPrefix, HString &rValue) const;
+    void updateValueText() const;
 
     HString mParameterName;
-    HString mParameterValue;
+    mutable HString mParameterValue;
+    mutable bool mValueTextOutdated;    //!< The value has been set through a ParameterHandle, mParameterValue must be regenerated
+    double mHandleValue;                //!< The value last set through a ParameterHandle
     HString mDescription;
     HString mUnit;
     HString mQuantity;
@@ -127,13 +133,63 @@ public:
     bool parameterTriggersReconfiguration(const HString &rParameterName);
 
     Component *getComponent() const;
+    ParameterHandle getParameterHandle(const HString &rName);
 
 protected:
+
     Component* mComponent;
     std::vector<ParameterEvaluator*> mParameters;
     std::vector<ParameterEvaluator*> mParametersNeedEvaluation; //! @todo Use this vector to ensure parameters are valid at simulation time e.g. if a used system parameter is deleted before simulation
 };
 
+
+//! @brief A pre-resolved handle to a numeric parameter, for fast repeated value changes
+//! @details The parameter and all parameters that depend on it (directly or through system parameters in subsystems)
+//! are looked up once when the handle is created. set() then writes the value directly to the parameter data, without
+//! parsing any strings. Dependent parameters that are plain references to the parameter (e.g. "m" or "-m") are written
+//! directly as well, only dependent expressions are re-evaluated. The value text of the parameter is regenerated
+//! lazily, the first time it is needed.
+//!
+//! If any parameter value text in the component or in the system hierarchy below it is changed through the string
+//! interface, or if parameters or sub components are added, removed or renamed there, the dependencies are collected
+//! again on the next set() (see Component::getParameterGeneration()). The handle must not be used after the handle
+//! parameter itself has been removed.
+class HOPSANCORE_DLLAPI ParameterHandle
+{
+    friend class ParameterEvaluatorHandler;
+public:
+    ParameterHandle();
+
+    bool isValid() const;
+    bool set(const double value);
+    double get() const;
+    const HString &getName() const;
+    size_t getNumDependents() const;
+
+private:
+    //! @brief One dependent parameter, updated in the order they are stored
+    class DependentStep
+    {
+    public:
+        ParameterEvaluator *pParameter;
+        int source;     //!< Index of the step this parameter refers to, -1 for the handle parameter itself
+        double sign;
+        bool isAlias;   //!< True if the value is sign*(source value), false if the parameter must be evaluated
+    };
+
+    bool rebuild();
+    bool collectDependents(ComponentSystem *pSystem, const HString &rName, const int source, const bool sourceIsAlias);
+    bool addDependent(ParameterEvaluator *pParameter, const HString &rName, const int source, const bool sourceIsAlias);
+    bool isOutdated() const;
+
+    Component *mpComponent;
+    ParameterEvaluator *mpParameter;
+    enum {DoubleType, IntegerType, BoolType} mType;
+    std::vector<DependentStep> mSteps;
+    std::vector<double> mStepValues;
+    size_t mGeneration;
+};
+
 }
 
 #endif // PARAMETERS_H
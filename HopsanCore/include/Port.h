@@ -111,12 +111,12 @@ namespace hopsan {
         ///@{
         //! @brief Returns a reference to the Node data in the port
         //! @returns A reference to the node data vector
-        inline std::vector<double> &getNodeDataVector()
+        inline NodeDataVector &getNodeDataVector()
         {
             return mpNode->mDataValues;
         }
 
-        inline const std::vector<double> &getNodeDataVector() const
+        inline const NodeDataVector &getNodeDataVector() const
         {
             return mpNode->mDataValues;
         }
@@ -126,13 +126,13 @@ namespace hopsan {
         //! @brief Returns a reference to the Node data in the port
         //! @param[in] subPortIdx The index of a multiport subport to access
         //! @returns A reference to the node data vector
-        virtual inline std::vector<double> &getNodeDataVector(const size_t subPortIdx)
+        virtual inline NodeDataVector &getNodeDataVector(const size_t subPortIdx)
         {
             HOPSAN_UNUSED(subPortIdx);
             return getNodeDataVector();
         }
 
-        virtual inline const std::vector<double> &getNodeDataVector(const size_t subPortIdx) const
+        virtual inline const NodeDataVector &getNodeDataVector(const size_t subPortIdx) const
         {
             HOPSAN_UNUSED(subPortIdx);
             return getNodeDataVector();
@@ -145,7 +145,7 @@ namespace hopsan {
         virtual Node *getNodePtr(const size_t subPortIdx=0);
         virtual const Node *getNodePtr(const size_t subPortIdx=0) const;
         virtual double *getNodeDataPtr(const size_t idx, const size_t subPortIdx=0) const;
-        virtual std::vector<double> *getDataVectorPtr(const size_t subPortIdx=0);
+        virtual NodeDataVector *getDataVectorPtr(const size_t subPortIdx=0);
 
         virtual size_t getNumDataVariables() const;
         virtual const std::vector<NodeDataDescription>* getNodeDataDescriptions(const size_t subPortIdx=0) const;
@@ -162,10 +162,14 @@ namespace hopsan {
 
         virtual bool haveLogData(const size_t subPortIdx=0);
         virtual std::vector<double> *getLogTimeVectorPtr(const size_t subPortIdx=0);
-        virtual std::vector<std::vector<double> > *getLogDataVectorPtr(size_t subPortIdx=0);
-        virtual const std::vector<std::vector<double> > *getLogDataVectorPtr(size_t subPortIdx=0) const;
+        virtual const std::vector<double> *getLogDataVariablePtr(const size_t dataId, const size_t subPortIdx=0) const;
+        virtual size_t getLogDataDecimation(const size_t dataId, const size_t subPortIdx=0) const;
         virtual void setEnableLogging(const bool enableLog);
         bool isLoggingEnabled() const;
+        void setEnableVariableLogging(const size_t dataId, const bool enableLog);
+        bool isVariableLoggingEnabled(const size_t dataId) const;
+        void setVariableLogDecimation(const size_t dataId, const size_t decimation);
+        size_t getVariableLogDecimation(const size_t dataId) const;
 
         virtual bool isConnected() const;
         virtual bool isConnectedTo(Port *pOtherPort);
@@ -232,6 +236,7 @@ namespace hopsan {
         Node *mpNode;
         Node *mpStartNode;
         std::map<HString, size_t> mVariableAliasMap;
+        std::vector<size_t> mVariableLogDecimations;
         bool mConnectionRequired;
 
         const HString mEmptyString;
@@ -294,12 +299,12 @@ namespace hopsan {
         //! @brief Returns a reference to the Node data in the port
         //! @param[in] subPortIdx The index of a multiport subport to access
         //! @returns A reference to the node data vector
-        inline std::vector<double> &getNodeDataVector(const size_t subPortIdx)
+        inline NodeDataVector &getNodeDataVector(const size_t subPortIdx)
         {
             return mSubPortsVector[subPortIdx]->getNodeDataVector();
         }
 
-        inline const std::vector<double> &getNodeDataVector(const size_t subPortIdx) const
+        inline const NodeDataVector &getNodeDataVector(const size_t subPortIdx) const
         {
             return mSubPortsVector[subPortIdx]->getNodeDataVector();
         }
@@ -307,7 +312,7 @@ namespace hopsan {
 
         const Node *getNodePtr(const size_t subPortIdx=0) const;
         double *getNodeDataPtr(const size_t idx, const size_t subPortIdx) const;
-        std::vector<double> *getDataVectorPtr(const size_t subPortIdx=0);
+        NodeDataVector *getDataVectorPtr(const size_t subPortIdx=0);
 
         const std::vector<NodeDataDescription>* getNodeDataDescriptions(const size_t subPortIdx=0) const;
         const NodeDataDescription* getNodeDataDescription(const size_t dataid, const size_t subPortIdx=0) const;
@@ -315,8 +320,8 @@ namespace hopsan {
 
         bool haveLogData(const size_t subPortIdx=0);
         std::vector<double> *getLogTimeVectorPtr(const size_t subPortIdx=0);
-        std::vector<std::vector<double> > *getLogDataVectorPtr(const size_t subPortIdx=0);
-        const std::vector<std::vector<double> > *getLogDataVectorPtr(size_t subPortIdx=0) const;
+        const std::vector<double> *getLogDataVariablePtr(const size_t dataId, const size_t subPortIdx=0) const;
+        size_t getLogDataDecimation(const size_t dataId, const size_t subPortIdx=0) const;
         virtual void setEnableLogging(const bool enableLog);
 
         double getStartValue(const size_t idx, const size_t subPortIdx=0);
@@ -82,10 +82,15 @@ Component::Component()
 
     mpSystemParent = 0;
     mModelHierarchyDepth = 0;
+    mParameterGeneration = 0;
 
     mpParameters = new ParameterEvaluatorHandler(this);
 
     mSearchPaths.clear();
+
+    // State objects (delays, integrators and such) constructed as members of the derived component will register with this
+    // component, if it is created within a registration scope (as by HopsanEssentials::createComponent())
+    StateObjectRegistrationScope::componentConstructed(this);
 }
 
 
@@ -94,6 +99,9 @@ bool Component::initialize(const double startT, const double stopT)
 {
     HOPSAN_UNUSED(stopT)
     mTime = startT;
+
+    // State objects created during initialize() should also register with this component
+    StateObjectRegistrationScope scope(this);
     initialize();
 
     return true;        //Always return true, because we cannot know if it was successful or not (yet)
@@ -142,6 +150,33 @@ bool Component::setParameterValue(const HString &rName, const HString &rValue, b
 }
 
 
+//! @brief Get a pre-resolved handle to a numeric parameter, for fast repeated value changes
+//! @see ParameterHandle
+ParameterHandle Component::getParameterHandle(const HString &rName)
+{
+    return mpParameters->getParameterHandle(rName);
+}
+
+//! @brief Returns a counter that changes whenever parameters in this component, or in any sub component below it, are changed through the string interface, added, removed or renamed
+//! @details Adding or removing sub components changes the counter as well. It is used by ParameterHandle to detect when its dependencies must be collected again.
+size_t Component::getParameterGeneration() const
+{
+    return mParameterGeneration;
+}
+
+//! @brief Increment the parameter generation counter of this component and all its parent systems
+//! @see getParameterGeneration()
+void Component::incrementParameterGeneration()
+{
+    Component *pComponent = this;
+    while (pComponent)
+    {
+        ++pComponent->mParameterGeneration;
+        pComponent = pComponent->getSystemParent();
+    }
+}
+
+
 void Component::evaluateParameters()
 {
     mpParameters->evaluateParameters();
@@ -1694,6 +1729,13 @@ Component::~Component()
 
     // Delete any registered parameters (Constants and start values)
     delete mpParameters;
+
+    // Detach any state objects that are still registered, they must not unregister from a deleted component
+    for (size_t i=0; i<mStateObjects.size(); ++i)
+    {
+        mStateObjects[i]->mpOwner = 0;
+    }
+    StateObjectRegistrationScope::componentDestroyed(this);
 }
 
 //! @brief Configures a component by setting up ports, variables, constants and other resources
@@ -1858,3 +1900,100 @@ double Component::getStateVariableSecondDerivative(int)
     return 0;
 }
 
+
+//! @brief Write the internal simulation state of the component
+//! @details The default implementation writes the simulation time, the state of all registered state objects (delays,
+//! integrators, transfer functions and such) and all registered state variables. Node data is not included, it is saved by the
+//! system that owns the nodes. Components that keep additional state must register it with registerStateVariable()
+//! or override both this function and restoreState().
+//! @param[in] rWriter The writer to append the state to
+void Component::saveState(StateWriter &rWriter) const
+{
+    rWriter.writeDouble(mTime);
+    rWriter.writeSize(mStateObjects.size());
+    for (size_t i=0; i<mStateObjects.size(); ++i)
+    {
+        mStateObjects[i]->saveState(rWriter);
+    }
+    rWriter.writeSize(mStateVariables.size());
+    for (size_t i=0; i<mStateVariables.size(); ++i)
+    {
+        rWriter.writeDouble(*mStateVariables[i]);
+    }
+}
+
+//! @brief Restore the internal simulation state of the component
+//! @param[in] rReader The reader to read the state from, the state must have been written by saveState() of the same component
+//! @returns true if successful, false if the state does not match the component
+bool Component::restoreState(StateReader &rReader)
+{
+    size_t numObjects=0, numVariables=0;
+    if (!rReader.readDouble(mTime) || !rReader.readSize(numObjects) || (numObjects != mStateObjects.size()))
+    {
+        return false;
+    }
+    for (size_t i=0; i<mStateObjects.size(); ++i)
+    {
+        if (!mStateObjects[i]->restoreState(rReader))
+        {
+            return false;
+        }
+    }
+    if (!rReader.readSize(numVariables) || (numVariables != mStateVariables.size()))
+    {
+        return false;
+    }
+    for (size_t i=0; i<mStateVariables.size(); ++i)
+    {
+        if (!rReader.readDouble(*mStateVariables[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//! @brief Register a member variable that is part of the simulation state of the component
+//! @details Registered variables are included by saveState() and restoreState(). Use this for state that is kept in plain
+//! member variables, such as values from the previous time step.
+//! @ingroup ComponentSetup
+//! @param[in] rVariable Reference to the variable
+void Component::registerStateVariable(double &rVariable)
+{
+    if (std::find(mStateVariables.begin(), mStateVariables.end(), &rVariable) == mStateVariables.end())
+    {
+        mStateVariables.push_back(&rVariable);
+    }
+}
+
+//! @brief Register a state object (delay, integrator or such) with this component
+//! @details Objects constructed as members of a component created by HopsanEssentials::createComponent(), or during
+//! initialize(), are registered automatically
+//! @param[in] pObject Pointer to the object
+void Component::registerStateObject(ComponentStateObject *pObject)
+{
+    if (pObject->mpOwner && (pObject->mpOwner != this))
+    {
+        pObject->mpOwner->unRegisterStateObject(pObject);
+    }
+    if (std::find(mStateObjects.begin(), mStateObjects.end(), pObject) == mStateObjects.end())
+    {
+        mStateObjects.push_back(pObject);
+    }
+    pObject->mpOwner = this;
+}
+
+//! @brief Unregister a state object from this component
+//! @param[in] pObject Pointer to the object
+void Component::unRegisterStateObject(ComponentStateObject *pObject)
+{
+    std::vector<ComponentStateObject*>::iterator it = std::find(mStateObjects.begin(), mStateObjects.end(), pObject);
+    if (it != mStateObjects.end())
+    {
+        mStateObjects.erase(it);
+    }
+    if (pObject->mpOwner == this)
+    {
+        pObject->mpOwner = 0;
+    }
+}
@@ -36,8 +36,12 @@
 #include <cstdlib>
 #include <iostream>
 #include <algorithm>
+#include <iterator>
 #include <map>
 #include <time.h>
+#include <set>
+#include <unordered_map>
+#include <stdint.h>
 
 #include "ComponentSystem.h"
 #include "HopsanEssentials.h"
@@ -45,6 +49,8 @@
 #include "CoreUtilities/HopsanCoreMessageHandler.h"
 #include "CoreUtilities/StringUtilities.h"
 #include "CoreUtilities/MultiThreadingUtilities.h"
+#include "CoreUtilities/RealtimeRunner.h"
+#include "CoreUtilities/LogSink.h"
 #include "CoreUtilities/HmfLoader.h"
 #include "CoreUtilities/NumHopHelper.h"
 #include "CoreUtilities/ConnectionAssistant.h"
@@ -88,6 +94,9 @@ HighResClock::time_point HighResClock::now()
 #endif // multithreading
 
 namespace {
+//! @brief Format version of in-memory simulation state snapshots, increase when the state layout changes
+const int SimulationStateFormatVersion = 1;
+
 //! @brief Figure out whether or not a vector contains a certain "object", exact comparison
 //! @param[in] rVector Vector of objects
 //! @param[in] rObj Object to find
@@ -105,23 +114,142 @@ bool vectorContains(const std::vector<T> &rVector, const T &rObj)
     }
     return false;
 }
+
+//! @brief Find the strongly connected components (Tarjan) that form loops in a dependency graph
+//! @details Only components with more than one vertex, or a single vertex depending on itself, are returned.
+//! The search is iterative, so that long dependency chains do not overflow the call stack.
+//! @param[in] rEdges The outgoing edges of each vertex
+//! @param[in] rInclude Only vertices (and edges between vertices) marked true are searched
+//! @param[out] rLoops The vertices in each loop, in ascending order
+static void findDependencyLoops(const std::vector< std::vector<size_t> > &rEdges, const std::vector<bool> &rInclude, std::vector< std::vector<size_t> > &rLoops)
+{
+    const size_t numVertices = rEdges.size();
+    const size_t unvisited = std::numeric_limits<size_t>::max();
+    std::vector<size_t> index(numVertices, unvisited), lowlink(numVertices, 0);
+    std::vector<bool> onStack(numVertices, false);
+    std::vector<size_t> stack;
+    std::vector< std::pair<size_t, size_t> > callStack; // Vertex and next edge to visit
+    size_t nextIndex = 0;
+
+    for (size_t root=0; root<numVertices; ++root)
+    {
+        if (!rInclude[root] || index[root] != unvisited)
+        {
+            continue;
+        }
+        index[root] = lowlink[root] = nextIndex++;
+        stack.push_back(root);
+        onStack[root] = true;
+        callStack.push_back(std::make_pair(root, size_t(0)));
+
+        while (!callStack.empty())
+        {
+            const size_t v = callStack.back().first;
+            if (callStack.back().second < rEdges[v].size())
+            {
+                const size_t w = rEdges[v][callStack.back().second++];
+                if (!rInclude[w])
+                {
+                    continue;
+                }
+                if (index[w] == unvisited)
+                {
+                    index[w] = lowlink[w] = nextIndex++;
+                    stack.push_back(w);
+                    onStack[w] = true;
+                    callStack.push_back(std::make_pair(w, size_t(0)));
+                }
+                else if (onStack[w])
+                {
+                    lowlink[v] = std::min(lowlink[v], index[w]);
+                }
+            }
+            else
+            {
+                callStack.pop_back();
+                if (!callStack.empty())
+                {
+                    const size_t u = callStack.back().first;
+                    lowlink[u] = std::min(lowlink[u], lowlink[v]);
+                }
+                if (lowlink[v] == index[v])
+                {
+                    std::vector<size_t> loop;
+                    size_t w;
+                    do
+                    {
+                        w = stack.back();
+                        stack.pop_back();
+                        onStack[w] = false;
+                        loop.push_back(w);
+                    } while (w != v);
+
+                    if (loop.size() > 1 || std::find(rEdges[v].begin(), rEdges[v].end(), v) != rEdges[v].end())
+                    {
+                        std::sort(loop.begin(), loop.end());
+                        rLoops.push_back(loop);
+                    }
+                }
+            }
+        }
+    }
+}
+
+#if (__cplusplus >= 201103L) && !defined(_WIN32)
+//! @brief Returns the time between two time stamps in milliseconds, including whole seconds
+double elapsedMilliseconds(const timespec &rT0, const timespec &rT1)
+{
+    return double(rT1.tv_sec-rT0.tv_sec)*1000.0 + double(rT1.tv_nsec-rT0.tv_nsec)/1000000.0;
+}
+#endif
 } // anon namespace
 
 namespace hopsan {
 
 class ComponentSystemMultiThreadPrivates {
 public:
+    ComponentSystemMultiThreadPrivates()
+    {
+#if defined(HOPSANCORE_USEMULTITHREADING)
+        mBarrierSpinBudget = HybridBarrier::defaultSpinBudget;
+#else
+        mBarrierSpinBudget = 0;
+#endif
+        mProfilingSampleInterval = 16;
+        mRescheduleImbalanceThreshold = 0.2;
+        mRescheduleCheckInterval = 1024;
+        mNumAdaptiveReschedules = 0;
+    }
+
     std::vector<double *> mvTimePtrs;
     std::vector< std::vector<Component*> > mSplitCVector;
     std::vector< std::vector<Component*> > mSplitQVector;
     std::vector< std::vector<Component*> > mSplitSignalVector;
     std::vector< std::vector<Node*> > mSplitNodeVector;
+    size_t mBarrierSpinBudget;
+    size_t mProfilingSampleInterval;
+    double mRescheduleImbalanceThreshold;
+    size_t mRescheduleCheckInterval;
+    size_t mNumAdaptiveReschedules;
+    std::vector<ThreadLoadStatistics> mThreadLoadStatistics;
+    std::vector<ComponentSystem*> mExpandedSubsystems;
+    std::vector<Component*> mExpandedSignalTasks;
 #if defined(HOPSANCORE_USEMULTITHREADING)
     std::mutex mStopMutex;
+    std::unique_ptr<WorkStealingScheduler> mpWorkStealingScheduler;
+    std::unique_ptr<RealtimeRunner> mpRealtimeRunner;
 #endif
 
 };
 
+//! @brief Book keeping used while a system is constructed in bulk
+//! @details Removed sub nodes are left as null entries in mSubNodePtrs, found through the index, so that removing them is
+//! constant time. The null entries are removed when the bulk construction ends, keeping the order of the remaining nodes.
+class ComponentSystemBulkConstruction {
+public:
+    std::unordered_map<Node*, size_t> mSubNodeIndex;
+};
+
 
 //Constructor
 ComponentSystem::ComponentSystem() : Component(), mAliasHandler(this)
@@ -137,6 +265,12 @@ ComponentSystem::ComponentSystem() : Component(), mAliasHandler(this)
     mRequestedLogStartTime = 0;
     mpMultiThreadPrivates = new ComponentSystemMultiThreadPrivates;
     mpNumHopHelper = 0;
+    mpLogSink = 0;
+    mLogSinkChunkNumSamples = 0;
+    mpLogStreamer = 0;
+    mLogIsStreamed = false;
+    mpSimulationProfiler = 0;
+    mpBulkConstruction = 0;
 
     // Prevent creation of components, system parameters and system ports named "self"
     // that would collide with embedded scripts
@@ -156,9 +290,20 @@ ComponentSystem::ComponentSystem() : Component(), mAliasHandler(this)
 
 ComponentSystem::~ComponentSystem()
 {
+#if defined(HOPSANCORE_USEMULTITHREADING)
+    // A running real-time simulation must be stopped before the contents are removed
+    if (mpMultiThreadPrivates->mpRealtimeRunner)
+    {
+        mpMultiThreadPrivates->mpRealtimeRunner->stop();
+        mpMultiThreadPrivates->mpRealtimeRunner.reset();
+    }
+#endif
     // Clear the contents of the system
     clear();
+    delete mpBulkConstruction;
     delete mpMultiThreadPrivates;
+    delete mpLogStreamer;
+    delete mpSimulationProfiler;
 }
 
 void ComponentSystem::configure()
@@ -202,10 +347,45 @@ size_t ComponentSystem::getNumLogSamples() const
 //! @return Number of available logged data samples in storage
 size_t ComponentSystem::getNumActuallyLoggedSamples() const
 {
+    // Streamed samples are not kept in storage
+    if (mLogIsStreamed)
+    {
+        return 0;
+    }
     // This assumes that the logCtr has been incremented after each saved log step
     return mLogCtr;
 }
 
+//! @brief Stream log data to a log sink during simulation instead of storing it in memory
+//! @details The sink receives the logged variables of this system and all its subsystems, sampled at the log times of
+//! this system. Memory usage is bounded by the chunk size regardless of the number of log samples. Logged data will not
+//! be available through the ports when streaming. The sink must outlive the simulation, it is not owned by the system.
+//! @param [in] pSink The log sink, 0 disables streaming
+//! @param [in] chunkNumSamples The number of samples to collect before writing, 0 means choose automatically
+void ComponentSystem::setLogSink(LogSink *pSink, const size_t chunkNumSamples)
+{
+    mpLogSink = pSink;
+    mLogSinkChunkNumSamples = chunkNumSamples;
+}
+
+LogSink *ComponentSystem::getLogSink() const
+{
+    return mpLogSink;
+}
+
+//! @brief Check if log data from this system is streamed to a log sink (by this system or a parent system)
+bool ComponentSystem::isLogStreamed() const
+{
+    for (const ComponentSystem *pSystem = this; pSystem != 0; pSystem = pSystem->getSystemParent())
+    {
+        if (pSystem->mpLogSink)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 
 //! @brief Set the stop simulation flag to abort the initialization or simulation loops
 //! @param[in] rReason An optional HString describing the reason for the stop
@@ -506,6 +686,61 @@ HString ComponentSystem::reserveUniqueName(const HString &rDesiredName, const Un
 void ComponentSystem::unReserveUniqueName(const HString &rName)
 {
     mTakenNames.erase(rName);
+
+    // If the name has a numeric suffix it may be free for reuse, make sure that the suffix search for its base name finds it again
+    size_t foundpos = rName.rfind('_');
+    if (foundpos != HString::npos)
+    {
+        TakenNameSuffixMapT::iterator it = mTakenNameSuffixes.find(rName.substr(0, foundpos));
+        if (it != mTakenNameSuffixes.end())
+        {
+            bool isOK;
+            long int suffix = rName.substr(foundpos+1).toLongInt(&isOK);
+            if (isOK && (suffix > 0) && (size_t(suffix) < it->second))
+            {
+                it->second = size_t(suffix);
+            }
+        }
+    }
+}
+
+//! @brief Prepares the system for adding and connecting a large number of components
+//! @details While in bulk construction, removing sub nodes (which happens twice for each connection) is constant time instead of
+//! linear in the number of nodes, and successful connections are not reported with debug messages. Call endBulkConstruction()
+//! before the system is used for anything else than adding, connecting and removing components. checkModelBeforeSimulation()
+//! and initialize() end the bulk construction if it is still active.
+//! @param [in] expectedNumComponents The number of components that are expected to be added, used to reserve storage
+void ComponentSystem::beginBulkConstruction(const size_t expectedNumComponents)
+{
+    if (!mpBulkConstruction)
+    {
+        mpBulkConstruction = new ComponentSystemBulkConstruction;
+        for (size_t n=0; n<mSubNodePtrs.size(); ++n)
+        {
+            mpBulkConstruction->mSubNodeIndex[mSubNodePtrs[n]] = n;
+        }
+    }
+
+    // Most components have one or two ports, reserve for two dummy nodes per component
+    mSubNodePtrs.reserve(mSubNodePtrs.size()+2*expectedNumComponents);
+    mpBulkConstruction->mSubNodeIndex.reserve(mpBulkConstruction->mSubNodeIndex.size()+2*expectedNumComponents);
+}
+
+//! @brief Ends bulk construction, started by beginBulkConstruction()
+void ComponentSystem::endBulkConstruction()
+{
+    if (mpBulkConstruction)
+    {
+        mSubNodePtrs.erase(std::remove(mSubNodePtrs.begin(), mSubNodePtrs.end(), static_cast<Node*>(0)), mSubNodePtrs.end());
+        delete mpBulkConstruction;
+        mpBulkConstruction = 0;
+    }
+}
+
+//! @brief Check if the system is in bulk construction, see beginBulkConstruction()
+bool ComponentSystem::isInBulkConstruction() const
+{
+    return (mpBulkConstruction != 0);
 }
 
 void ComponentSystem::addSubComponentPtrToStorage(Component* pComponent)
@@ -530,6 +765,7 @@ void ComponentSystem::addSubComponentPtrToStorage(Component* pComponent)
     }
 
     mSubComponentMap.insert(pair<HString, Component*>(pComponent->getName(), pComponent));
+    incrementParameterGeneration();
 }
 
 void ComponentSystem::removeSubComponentPtrFromStorage(Component* pComponent)
@@ -537,53 +773,35 @@ void ComponentSystem::removeSubComponentPtrFromStorage(Component* pComponent)
     SubComponentMapT::iterator it = mSubComponentMap.find(pComponent->getName());
     if (it != mSubComponentMap.end())
     {
-        vector<Component*>::iterator cit; //Component iterator
+        vector<Component*> *pStorage = 0;
         switch (it->second->getTypeCQS())
         {
         case Component::CType :
-            for (cit = mComponentCptrs.begin(); cit != mComponentCptrs.end(); ++cit)
-            {
-                if ( *cit == pComponent )
-                {
-                    mComponentCptrs.erase(cit);
-                    break;
-                }
-            }
+            pStorage = &mComponentCptrs;
             break;
         case Component::QType :
-            for (cit = mComponentQptrs.begin(); cit != mComponentQptrs.end(); ++cit)
-            {
-                if ( *cit == pComponent )
-                {
-                    mComponentQptrs.erase(cit);
-                    break;
-                }
-            }
+            pStorage = &mComponentQptrs;
             break;
         case Component::SType :
-            for (cit = mComponentSignalptrs.begin(); cit != mComponentSignalptrs.end(); ++cit)
-            {
-                if ( *cit == pComponent )
-                {
-                    mComponentSignalptrs.erase(cit);
-                    break;
-                }
-            }
+            pStorage = &mComponentSignalptrs;
             break;
         case Component::UndefinedCQSType :
-            for (cit = mComponentUndefinedptrs.begin(); cit != mComponentUndefinedptrs.end(); ++cit)
-            {
-                if ( *cit == pComponent )
-                {
-                    mComponentUndefinedptrs.erase(cit);
-                    break;
-                }
-            }
+            pStorage = &mComponentUndefinedptrs;
             break;
         default :
             addFatalMessage("In removeSubComponentPtrFromStorage(): Component is not of CType, QType, SType or UndefinedCQSType.");
         }
+        if (pStorage)
+        {
+            // Search from the back, the most recently added components are the most likely to be removed (and clear() removes them in reverse order)
+            vector<Component*>::reverse_iterator cit = std::find(pStorage->rbegin(), pStorage->rend(), pComponent);
+            if (cit != pStorage->rend())
+            {
+                pStorage->erase(std::next(cit).base());
+            }
+        }
         mSubComponentMap.erase(it);
+        incrementParameterGeneration();
     }
     else
     {
@@ -594,11 +812,36 @@ void ComponentSystem::removeSubComponentPtrFromStorage(Component* pComponent)
 //! @brief Clear all the contents of a system (deleting any remaining components and connections)
 void ComponentSystem::clear()
 {
-    // Remove and delete every subcomponent, one by one
+    // Remove and delete every subcomponent, one by one. The components are removed in reverse order from the storage vectors,
+    // and node removal is constant time during bulk construction, so that clearing large systems is linear in the number of components.
+    // An ongoing bulk construction is kept
+    const bool wasInBulkConstruction = isInBulkConstruction();
+    beginBulkConstruction();
+    // All sub nodes will be removed, the logged nodes are collected again when log space is allocated
+    mLoggedNodePtrs.clear();
+    vector<Component*>* storages[] = {&mComponentUndefinedptrs, &mComponentSignalptrs, &mComponentQptrs, &mComponentCptrs};
+    for (vector<Component*> *pStorage : storages)
+    {
+        while (!pStorage->empty())
+        {
+            const size_t numBefore = pStorage->size();
+            removeSubComponent(pStorage->back(), true);
+            if (pStorage->size() == numBefore)
+            {
+                // Not a registered sub component (should not happen), just forget it
+                pStorage->pop_back();
+            }
+        }
+    }
+    // Disabled components are not in the storage vectors during simulation
     while (!mSubComponentMap.empty())
     {
         removeSubComponent((*mSubComponentMap.begin()).second, true);
     }
+    if (!wasInBulkConstruction)
+    {
+        endBulkConstruction();
+    }
 
     // Remove the numhop storage if present
     if (mpNumHopHelper)
@@ -608,169 +851,126 @@ void ComponentSystem::clear()
     }
 }
 
-#define USENEWSORTCODE
 //! @brief Sorts a component vector
-//! Components are sorted so that they are always simulated after the components they receive signals from. Algebraic loops can be detected, in that case this function does nothing.
+//! @details Components are sorted so that they are always simulated after the components they receive signals from.
+//! The dependencies are sorted topologically in linear time. The order is the same as if the vector was swept repeatedly,
+//! appending each component whose dependencies have already been appended: a component ends up in the first sweep
+//! where all its dependencies precede it, and the original order is kept within a sweep.
+//! If there are algebraic loops the components in each loop are reported, and the vector is left unchanged.
+//! @param[in,out] rComponentVector The components to sort
+//! @returns False if the components could not be sorted due to algebraic loops
 bool ComponentSystem::sortComponentVector(std::vector<Component*> &rComponentVector)
 {
-    std::vector<Component*> newComponentVector;
-
-#ifndef USENEWSORTCODE
-    bool didSomething = true;
-    while(didSomething)
-    {
-        didSomething = false;
-        std::vector<Component*>::iterator it;
-        //Loop through the unsorted signal component vector
-        for(it=rComponentVector.begin(); it!=rComponentVector.end(); ++it)
+    const size_t numComponents = rComponentVector.size();
+    std::unordered_map<const Component*, size_t> componentIndex;
+    componentIndex.reserve(numComponents);
+    for(size_t c=0; c<numComponents; ++c)
+    {
+        componentIndex[rComponentVector[c]] = c;
+    }
+
+    // Build the dependency graph, with edges from each required component to the components depending on it
+    std::vector< std::vector<size_t> > dependents(numComponents);
+    std::vector<size_t> numDependencies(numComponents, 0);
+    std::vector<size_t> required;
+    for(size_t c=0; c<numComponents; ++c)
+    {
+        Component* pComp = rComponentVector[c];
+        const bool isSubsystem = (pComp->getTypeName() == HOPSAN_BUILTIN_TYPENAME_SUBSYSTEM) ||
+                                 (pComp->getTypeName() == HOPSAN_BUILTIN_TYPENAME_CONDITIONALSUBSYSTEM);
+        required.clear();
+        std::vector<Port*> portVector = pComp->getPortPtrVector();
+        for(size_t p=0; p<portVector.size(); ++p)
         {
-            // A pointer to an unsorted component
-            Component* pUnsrtComp = (*it);
-            //Ignore components that are already added to the new vector
-            if(!vectorContains<Component*>(newComponentVector, pUnsrtComp))
+            Port *pPort = portVector[p];
+            const SortHintEnumT sortHint = isSubsystem ? pPort->getInternalSortHint() : pPort->getSortHint();
+            if ( (sortHint != Destination) || !pPort->isConnected() )
+            {
+                continue;
+            }
+            // Ask each node for the component writing to it
+            for(size_t s=0; s<pPort->getNumPorts(); ++s)
             {
-                bool readyToAdd=true;
-                std::vector<Port*>::iterator itp;
-                std::vector<Port*> portVector = (*it)->getPortPtrVector();
-                // Ask each read port for its node, then ask the node for its write port component
-                for(itp=portVector.begin(); itp!=portVector.end(); ++itp)
+                Port *pSourcePort = pPort->getNodePtr(s)->getSortOrderSourcePort();
+                Component *pRequiredComponent = pSourcePort ? pSourcePort->getComponent() : 0;
+                if (!pRequiredComponent)
                 {
-                    // Take the port pointer (To make code easier to read)
-                    Port *pPort = (*itp);
-                    Component* pRequiredComponent=0;
-
-                    bool isReadPort = pPort->getPortType() == ReadPortType || pPort->getPortType() == ReadMultiportType ||
-                            ( (pUnsrtComp->getTypeName() == SUBSYSTEMTYPENAME) && (pPort->getInternalPortType() == ReadPortType)) ||
-                            ( (pUnsrtComp->getTypeName() == CONDITIONALTYPENAME) && (pPort->getInternalPortType() == ReadPortType));
-                    if ( isReadPort && pPort->isConnected() )
-                    {
-                        pRequiredComponent = pPort->getNodePtr()->getWritePortComponentPtr();
-                    }
-                    if(pRequiredComponent && (pRequiredComponent->getTypeName() != "SignalUnitDelay"))
+                    continue;
+                }
+                // A component inside a subsystem is represented by the subsystem, if it is of the same type
+                if (pRequiredComponent->mpSystemParent != this)
+                {
+                    pRequiredComponent = pRequiredComponent->mpSystemParent;
+                    if (!pRequiredComponent || (pRequiredComponent->getTypeCQS() != pPort->getComponent()->getTypeCQS()))
                     {
-                        if(pRequiredComponent->mpSystemParent == this)
-                        {
-                            if(!vectorContains<Component*>(newComponentVector, pRequiredComponent) &&
-                                    vectorContains<Component*>(rComponentVector, pRequiredComponent)
-                                    /*requiredComponent->getTypeCQS() == pPort->getComponent()->getTypeCQS()*//*Component::S*/)
-                            {
-                                readyToAdd = false;     //Depending on normal component which has not yet been added
-                            }
-                        }
-                        else
-                        {
-                            if(!vectorContains<Component*>(newComponentVector, pRequiredComponent->mpSystemParent) &&
-                                    (pRequiredComponent->mpSystemParent->getTypeCQS() == pPort->getComponent()->getTypeCQS()) &&
-                                    vectorContains<Component*>(rComponentVector,pRequiredComponent->mpSystemParent))
-                            {
-                                readyToAdd = false;     //Depending on subsystem component which has not yet been added
-                            }
-                        }
+                        continue;
                     }
                 }
-                // Add the component if all required write port components was already added
-                if(readyToAdd)
+                std::unordered_map<const Component*, size_t>::const_iterator it = componentIndex.find(pRequiredComponent);
+                if (it != componentIndex.end())
                 {
-                    newComponentVector.push_back(pUnsrtComp);
-                    didSomething = true;
+                    required.push_back(it->second);
                 }
             }
         }
+        std::sort(required.begin(), required.end());
+        required.erase(std::unique(required.begin(), required.end()), required.end());
+        for(size_t r=0; r<required.size(); ++r)
+        {
+            dependents[required[r]].push_back(c);
+        }
+        numDependencies[c] = required.size();
     }
 
-    if(newComponentVector.size() == rComponentVector.size())   //All components moved to new vector = success!
+    // Topological sort (Kahn), while determining in which sweep each component would have been added
+    std::vector<size_t> sweep(numComponents, 0);
+    std::vector<size_t> ready;
+    for(size_t c=0; c<numComponents; ++c)
     {
-        rComponentVector = newComponentVector;
-        if(newComponentVector.size() > 0 && newComponentVector[0]->getTypeCQS() == SType)
+        if (numDependencies[c] == 0)
         {
-            HString ss;
-            std::vector<Component*>::iterator it;
-            for(it=newComponentVector.begin(); it!=newComponentVector.end(); ++it)
-            {
-                ss += (*it)->getName()+"\n";                                                                                               //DEBUG
-            }
-            addDebugMessage("Sorted components successfully!\nSignal components will be simulated in the following order:\n" + ss);
+            ready.push_back(c);
         }
     }
-    else    //Something went wrong, all components were not moved. This is likely due to an algebraic loop.
+    size_t numSorted = 0;
+    size_t maxSweep = 0;
+    while (!ready.empty())
     {
-        addErrorMessage("Initialize: Algebraic loops was found, signal components could not be sorted.");
-        if(!newComponentVector.empty())
+        const size_t r = ready.back();
+        ready.pop_back();
+        ++numSorted;
+        maxSweep = std::max(maxSweep, sweep[r]);
+        for(size_t d=0; d<dependents[r].size(); ++d)
         {
-            addInfoMessage("Last component that was successfully sorted: " + newComponentVector.back()->getName());
-        }
-        addInfoMessage("Initialize: Hint: Use unit delay components to resolve loops.");
-        return false;
-    }
-#else
-    bool didSomething = true;
-    while(didSomething) {
-        didSomething = false;
-
-        // Loop through the unsorted component vector
-        for(size_t c=0; c<rComponentVector.size(); ++c) {
-            // A pointer to an unsorted component
-            Component* pUnsrtComp = rComponentVector[c];
-            //Ignore components that are already added to the new vector
-            if(!vectorContains<Component*>(newComponentVector, pUnsrtComp)) {
-                bool readyToAdd=true;
-                std::vector<Port*> portVector = pUnsrtComp->getPortPtrVector();
-                // Ask each read port for its node, then ask the node for its write port component
-                for(size_t p=0; p<portVector.size(); ++p) {
-                    // Take the port pointer (To make code easier to read)
-                    Port *pPort = portVector[p];
-                    std::vector<Component*> pRequiredComponents;
-
-                    SortHintEnumT sortHint = pPort->getSortHint();
-                    if ((pUnsrtComp->getTypeName() == HOPSAN_BUILTIN_TYPENAME_SUBSYSTEM) ||
-                        (pUnsrtComp->getTypeName() == HOPSAN_BUILTIN_TYPENAME_CONDITIONALSUBSYSTEM)) {
-                        sortHint = pPort->getInternalSortHint();
-                    }
-
-                    if ( (sortHint == Destination) && pPort->isConnected() ) {
-                        std::vector<Port *> sourcePorts;
-                        for(int s=0; s<pPort->getNumPorts(); ++s) {
-                            sourcePorts.push_back(pPort->getNodePtr(s)->getSortOrderSourcePort());
-                        }
-                        for(size_t p=0; p<sourcePorts.size(); ++p) {
-                            if (sourcePorts[p] && sourcePorts[p]->getComponent()) {
-                                pRequiredComponents.push_back(sourcePorts[p]->getComponent());
-                            }
-                        }
-                    }
-                    if(!pRequiredComponents.empty()) {
-                        for(size_t r=0; r<pRequiredComponents.size(); ++r) {
-                            Component *pRequiredComponent = pRequiredComponents[r];
-                            if(pRequiredComponent->mpSystemParent == this) {
-                                if(!vectorContains<Component*>(newComponentVector, pRequiredComponent) &&
-                                        vectorContains<Component*>(rComponentVector,pRequiredComponent)) {
-                                    readyToAdd = false;     //Depending on normal component which has not yet been added
-                                    break;
-                                }
-                            }
-                            else {
-                                if(!vectorContains<Component*>(newComponentVector, pRequiredComponent->mpSystemParent) &&
-                                        (pRequiredComponent->mpSystemParent->getTypeCQS() == pPort->getComponent()->getTypeCQS()) &&
-                                        vectorContains<Component*>(rComponentVector,pRequiredComponent->mpSystemParent)) {
-                                    readyToAdd = false;     //Depending on subsystem component which has not yet been added
-                                    break;
-                                }
-                            }
-                        }
-                    }
-                }
-                // Add the component if all required write port components was already added
-                if(readyToAdd) {
-                    newComponentVector.push_back(pUnsrtComp);
-                    didSomething = true;
-                }
+            const size_t c = dependents[r][d];
+            // A required component later in the vector is added in the next sweep at the earliest
+            sweep[c] = std::max(sweep[c], (r > c) ? sweep[r]+1 : sweep[r]);
+            if (--numDependencies[c] == 0)
+            {
+                ready.push_back(c);
             }
         }
     }
 
-    if(newComponentVector.size() == rComponentVector.size())   //All components moved to new vector = success!
+    if (numSorted == numComponents)
     {
-        if(newComponentVector.size() > 0 && newComponentVector[0]->getTypeCQS() == SType)
+        // Order by sweep, keeping the original order within each sweep (counting sort)
+        std::vector<size_t> sweepStart(maxSweep+2, 0);
+        for(size_t c=0; c<numComponents; ++c)
+        {
+            ++sweepStart[sweep[c]+1];
+        }
+        for(size_t s=1; s<sweepStart.size(); ++s)
+        {
+            sweepStart[s] += sweepStart[s-1];
+        }
+        std::vector<Component*> newComponentVector(numComponents);
+        for(size_t c=0; c<numComponents; ++c)
+        {
+            newComponentVector[sweepStart[sweep[c]]++] = rComponentVector[c];
+        }
+
+        if(numComponents > 0 && newComponentVector[0]->getTypeCQS() == SType)
         {
             HString names;
             for(size_t c=0; c<newComponentVector.size(); ++c)
@@ -781,17 +981,44 @@ bool ComponentSystem::sortComponentVector(std::vector<Component*> &rComponentVec
         }
         rComponentVector.swap(newComponentVector);
     }
-    else    //Something went wrong, all components were not moved. This is likely due to an algebraic loop.
+    else    //Something went wrong, all components could not be sorted due to algebraic loops
     {
         addErrorMessage("Initialize: Algebraic loops was found, signal components could not be sorted.");
-        if(!newComponentVector.empty())
+
+        // Components that could not be sorted are part of a loop, or depend on one
+        std::vector<bool> isUnsorted(numComponents);
+        for(size_t c=0; c<numComponents; ++c)
+        {
+            isUnsorted[c] = (numDependencies[c] > 0);
+        }
+        std::vector< std::vector<size_t> > loops;
+        findDependencyLoops(dependents, isUnsorted, loops);
+
+        const size_t maxReportedLoops = 10, maxReportedNames = 20;
+        for(size_t l=0; l<loops.size() && l<maxReportedLoops; ++l)
+        {
+            HString names;
+            for(size_t n=0; n<loops[l].size() && n<maxReportedNames; ++n)
+            {
+                if (n > 0)
+                {
+                    names += ", ";
+                }
+                names += rComponentVector[loops[l][n]]->getName();
+            }
+            if (loops[l].size() > maxReportedNames)
+            {
+                names += ", ... ("+to_hstring(loops[l].size())+" components)";
+            }
+            addErrorMessage("Initialize: Algebraic loop between: "+names);
+        }
+        if (loops.size() > maxReportedLoops)
         {
-            addInfoMessage("Last component that was successfully sorted: " + newComponentVector.back()->getName());
+            addInfoMessage("Initialize: "+to_hstring(loops.size()-maxReportedLoops)+" more algebraic loops were found");
         }
         addInfoMessage("Initialize: Hint: Use unit delay components to resolve loops.");
         return false;
     }
-#endif
 
     return true;
 }
@@ -811,7 +1038,7 @@ HString ComponentSystem::determineUniquePortName(const HString &rPortname)
 //! @todo the determineUniquePortNAme and ComponentName looks VERY similar maybe we could use the same function for both
 HString ComponentSystem::determineUniqueComponentName(const HString &rName) const
 {
-    return findUniqueName<TakenNamesMapT>(mTakenNames, rName);
+    return findUniqueName(mTakenNames, rName, mTakenNameSuffixes);
 }
 
 bool ComponentSystem::hasReservedUniqueName(const HString &rName) const
@@ -919,25 +1146,184 @@ void ComponentSystem::addSubNode(Node* pNode)
     }
     mSubNodePtrs.push_back(pNode);
     pNode->mpOwnerSystem = this;
+    if (mpBulkConstruction)
+    {
+        mpBulkConstruction->mSubNodeIndex[pNode] = mSubNodePtrs.size()-1;
+    }
 }
 
 
 //! @brief Removes a previously added node
 void ComponentSystem::removeSubNode(Node* pNode)
 {
+    if (mpBulkConstruction)
+    {
+        std::unordered_map<Node*, size_t>::iterator iit = mpBulkConstruction->mSubNodeIndex.find(pNode);
+        if (iit != mpBulkConstruction->mSubNodeIndex.end())
+        {
+            pNode->mDataValues.releaseExternalStorage();
+            pNode->mpOwnerSystem = 0;
+            mSubNodePtrs[iit->second] = 0;
+            mpBulkConstruction->mSubNodeIndex.erase(iit);
+            mLoggedNodePtrs.erase(std::remove(mLoggedNodePtrs.begin(), mLoggedNodePtrs.end(), pNode), mLoggedNodePtrs.end());
+        }
+        return;
+    }
+
     vector<Node*>::iterator it;
     for (it=mSubNodePtrs.begin(); it!=mSubNodePtrs.end(); ++it)
     {
         if (*it == pNode)
         {
+            // Move the node data out of the arena, the arena may be repacked or released while the node lives on
+            pNode->mDataValues.releaseExternalStorage();
             pNode->mpOwnerSystem = 0;
             mSubNodePtrs.erase(it);
+            mLoggedNodePtrs.erase(std::remove(mLoggedNodePtrs.begin(), mLoggedNodePtrs.end(), pNode), mLoggedNodePtrs.end());
             break;
         }
     }
 }
 
 
+//! @brief Check if the data of all sub nodes are stored in the node data arena of this system
+//! @details Nodes without data values are never placed in the arena, so they are skipped
+bool ComponentSystem::isNodeDataArenaPacked() const
+{
+    for (size_t n=0; n<mSubNodePtrs.size(); ++n)
+    {
+        if ((mSubNodePtrs[n]->mDataValues.size() > 0) && !mSubNodePtrs[n]->mDataValues.usesExternalStorage())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+//! @brief Pack the node data of all sub nodes into the node data arena, grouped in simulation order
+void ComponentSystem::packNodeDataArena()
+{
+    std::vector< std::vector<Component*> > groups(1);
+    groups[0].insert(groups[0].end(), mComponentSignalptrs.begin(), mComponentSignalptrs.end());
+    groups[0].insert(groups[0].end(), mComponentCptrs.begin(), mComponentCptrs.end());
+    groups[0].insert(groups[0].end(), mComponentQptrs.begin(), mComponentQptrs.end());
+    packNodeDataArena(groups);
+}
+
+
+//! @brief Pack the node data of all sub nodes into one contiguous and cache line aligned block of memory
+//! @details Nodes are placed in the order they are first touched by the components in each group, each group starts
+//! on a new cache line so that groups simulated by different threads do not share cache lines. Nodes not touched by
+//! any component in the groups are placed last. Any pointers to node data obtained before calling this are invalidated.
+//! @param[in] rComponentGroups The component groups, typically one group per simulation thread
+void ComponentSystem::packNodeDataArena(const std::vector< std::vector<Component*> > &rComponentGroups)
+{
+    std::vector< std::vector<Node*> > nodeGroups(rComponentGroups.size());
+    for (size_t g=0; g<rComponentGroups.size(); ++g)
+    {
+        for (size_t c=0; c<rComponentGroups[g].size(); ++c)
+        {
+            std::vector<Port*> ports = rComponentGroups[g][c]->getPortPtrVector();
+            for (size_t p=0; p<ports.size(); ++p)
+            {
+                for (size_t sp=0; sp<ports[p]->getNumPorts(); ++sp)
+                {
+                    Node *pNode = ports[p]->getNodePtr(sp);
+                    if (pNode)
+                    {
+                        nodeGroups[g].push_back(pNode);
+                    }
+                }
+            }
+        }
+    }
+    packNodeDataArena(nodeGroups);
+}
+
+
+//! @brief Pack the node data of all sub nodes into one contiguous and cache line aligned block of memory
+//! @details Nodes are placed in group order, each group starts on a new cache line. A node that appears in more than
+//! one group is placed in the first one. Nodes not in any group are placed last. Any pointers to node data obtained
+//! before calling this are invalidated.
+//! @param[in] rNodeGroups The node groups, typically the nodes owned by each simulation thread
+void ComponentSystem::packNodeDataArena(const std::vector< std::vector<Node*> > &rNodeGroups)
+{
+    const size_t doublesPerCacheLine = 64/sizeof(double);
+
+    // Determine the placement order, only nodes owned by this system are placed in its arena
+    std::vector<Node*> orderedNodes;
+    std::vector<size_t> groupStarts;
+    std::set<Node*> placedNodes;
+    orderedNodes.reserve(mSubNodePtrs.size());
+    for (size_t g=0; g<rNodeGroups.size(); ++g)
+    {
+        groupStarts.push_back(orderedNodes.size());
+        for (size_t n=0; n<rNodeGroups[g].size(); ++n)
+        {
+            Node *pNode = rNodeGroups[g][n];
+            if ((pNode->getOwnerSystem() == this) && placedNodes.insert(pNode).second)
+            {
+                orderedNodes.push_back(pNode);
+            }
+        }
+    }
+    groupStarts.push_back(orderedNodes.size());
+    for (size_t n=0; n<mSubNodePtrs.size(); ++n)
+    {
+        if (placedNodes.insert(mSubNodePtrs[n]).second)
+        {
+            orderedNodes.push_back(mSubNodePtrs[n]);
+        }
+    }
+
+    // Calculate the offset of each node, rounding every group start up to a cache line boundary
+    std::vector<size_t> offsets(orderedNodes.size());
+    size_t arenaSize = 0;
+    size_t g = 0;
+    for (size_t n=0; n<orderedNodes.size(); ++n)
+    {
+        while ((g < groupStarts.size()) && (groupStarts[g] == n))
+        {
+            arenaSize = (arenaSize+doublesPerCacheLine-1)/doublesPerCacheLine*doublesPerCacheLine;
+            ++g;
+        }
+        offsets[n] = arenaSize;
+        arenaSize += orderedNodes[n]->mDataValues.size();
+    }
+
+    // Move the data back to the nodes before the old arena is replaced
+    unpackNodeDataArena();
+    std::vector<double>().swap(mNodeDataArena);
+    if (arenaSize == 0)
+    {
+        return;
+    }
+
+    // Allocate one extra cache line so that the first element can be aligned
+    mNodeDataArena.resize(arenaSize+doublesPerCacheLine, 0.0);
+    const size_t misalignment = (reinterpret_cast<uintptr_t>(&mNodeDataArena[0]) % 64)/sizeof(double);
+    double *pAlignedStart = &mNodeDataArena[0] + (doublesPerCacheLine-misalignment)%doublesPerCacheLine;
+    for (size_t n=0; n<orderedNodes.size(); ++n)
+    {
+        if (!orderedNodes[n]->mDataValues.empty())
+        {
+            orderedNodes[n]->mDataValues.useExternalStorage(pAlignedStart+offsets[n]);
+        }
+    }
+}
+
+
+//! @brief Move the node data of all sub nodes out of the node data arena, back into the nodes themselves
+void ComponentSystem::unpackNodeDataArena()
+{
+    for (size_t n=0; n<mSubNodePtrs.size(); ++n)
+    {
+        mSubNodePtrs[n]->mDataValues.releaseExternalStorage();
+    }
+}
+
+
 //! @brief preAllocates log space (to speed up later access for log writing)
 void ComponentSystem::preAllocateLogSpace()
 {
@@ -946,14 +1332,27 @@ void ComponentSystem::preAllocateLogSpace()
     //    this->setLogSettingsNSamples(nSamples, startT, stopT, mTimestep);
     //! @todo Fix /Peter
     mLogCtr = 0;
+    mLoggedNodePtrs.clear();
+    mLogIsStreamed = false;
+    delete mpLogStreamer;
+    mpLogStreamer = 0;
     if (mEnableLogData)
     {
         try
         {
-            mTimeStorage.resize(mnLogSlots, 0);
+            // When log data is streamed, no log memory is allocated, only the log plans are set up
+            mLogIsStreamed = isLogStreamed();
+            if (mLogIsStreamed)
+            {
+                std::vector<double>().swap(mTimeStorage);
+            }
+            else
+            {
+                mTimeStorage.resize(mnLogSlots, 0);
+            }
 
-            // Allocate log data memory for subnodes
-            //! @todo we should have an other vector with those nodes that should be logged, if we make individual nodes possible to disable logging
+            // Allocate log data memory for subnodes, only enabled variables in nodes with logging enabled get memory
+            // The nodes that will actually log something are collected in mLoggedNodePtrs
             vector<Node*>::iterator it;
             for (it=mSubNodePtrs.begin(); it!=mSubNodePtrs.end(); ++it)
             {
@@ -976,11 +1375,22 @@ void ComponentSystem::preAllocateLogSpace()
                     else
                     {
                         (*it)->setDoLogIfEnabled(true);
-                        (*it)->preAllocateLogSpace(mnLogSlots);
-                    }
-                    success = true;
-                }
-                catch (exception &e)
+                        if (mLogIsStreamed)
+                        {
+                            (*it)->setupLogPlan();
+                        }
+                        else
+                        {
+                            (*it)->preAllocateLogSpace(mnLogSlots);
+                        }
+                        if ((*it)->isLogging())
+                        {
+                            mLoggedNodePtrs.push_back(*it);
+                        }
+                    }
+                    success = true;
+                }
+                catch (exception &e)
                 {
                     //cout << "preAllocateLogSpace: Standard exception: " << e.what() << endl;
                     addErrorMessage("Failed to allocate log data memory, try reducing the amount of log data", "FailedMemoryAllocation");
@@ -1007,17 +1417,35 @@ void ComponentSystem::preAllocateLogSpace()
 
 void ComponentSystem::logTimeAndNodes(const size_t simStep)
 {
-    if (mEnableLogData)
+    // Real-time simulations may continue past the last planned log sample
+    if (mEnableLogData && (mLogCtr < mLogTheseTimeSteps.size()))
     {
         if (mLogTheseTimeSteps[mLogCtr] ==  simStep)
         {
-            mTimeStorage[mLogCtr] = mTime;   //We log the "real"  simulation time for the sample
-
-            //! @todo we should have an other vector with those nodes that should be logged, if we make individual nodes possible to disable logging
-            vector<Node*>::iterator it;
-            for (it=mSubNodePtrs.begin(); it!=mSubNodePtrs.end(); ++it)
+            if (mpLogStreamer)
+            {
+                double *pSample = mpLogStreamer->nextSample();
+                pSample[0] = mTime;
+                for (size_t v=0; v<mStreamedLogValuePtrs.size(); ++v)
+                {
+                    pSample[v+1] = *mStreamedLogValuePtrs[v];
+                }
+                mpLogStreamer->commitSample();
+                if (mpLogStreamer->hasFailed())
+                {
+                    stopSimulation("Failed to write streamed log data: "+mpLogStreamer->getLastError());
+                }
+            }
+            // Subsystems are sampled by the streaming parent system
+            else if (!mLogIsStreamed)
             {
-                (*it)->logData(mLogCtr);
+                mTimeStorage[mLogCtr] = mTime;   //We log the "real"  simulation time for the sample
+
+                vector<Node*>::iterator it;
+                for (it=mLoggedNodePtrs.begin(); it!=mLoggedNodePtrs.end(); ++it)
+                {
+                    (*it)->logData(mLogCtr);
+                }
             }
             ++mLogCtr;
         }
@@ -1025,6 +1453,88 @@ void ComponentSystem::logTimeAndNodes(const size_t simStep)
 }
 
 
+//! @brief Start streaming log data to the log sink
+//! @details Must be called after all subsystems have been initialized, so that their log plans are set up
+//! @returns True if the log sink could be opened
+bool ComponentSystem::startLogStreaming()
+{
+    std::vector<LogSinkVariable> variables(1);
+    variables[0].variableName = "Time";
+    variables[0].unit = "s";
+    variables[0].quantity = "Time";
+    mStreamedLogValuePtrs.clear();
+    collectStreamedLogVariables("", variables, mStreamedLogValuePtrs);
+
+    mpLogStreamer = new LogStreamer(mpLogSink, variables.size(), mLogSinkChunkNumSamples);
+    if (!mpLogStreamer->start(variables))
+    {
+        addErrorMessage("Failed to open log sink: "+mpLogStreamer->getLastError());
+        delete mpLogStreamer;
+        mpLogStreamer = 0;
+        return false;
+    }
+    addDebugMessage("Streaming "+to_hstring(variables.size())+" log variables");
+    return true;
+}
+
+//! @brief Collect the logged variables of this system and its subsystems, for streaming
+//! @param [in] rSystemHierarchy The dot separated names of the parent systems
+//! @param [in,out] rVariables The variable descriptions are appended here
+//! @param [in,out] rValuePtrs Pointers to the variable values are appended here (in the same order)
+void ComponentSystem::collectStreamedLogVariables(const HString &rSystemHierarchy, std::vector<LogSinkVariable> &rVariables, std::vector<const double*> &rValuePtrs)
+{
+    std::vector<Component*> components = getSubComponents();
+    for (size_t c=0; c<components.size(); ++c)
+    {
+        Component *pComponent = components[c];
+        if (pComponent->isDisabled())
+        {
+            continue;
+        }
+        if (pComponent->isComponentSystem())
+        {
+            ComponentSystem *pSubSystem = static_cast<ComponentSystem*>(pComponent);
+            if (pSubSystem->mEnableLogData)
+            {
+                const HString subHierarchy = rSystemHierarchy.empty() ? pSubSystem->getName() : rSystemHierarchy+"."+pSubSystem->getName();
+                pSubSystem->collectStreamedLogVariables(subHierarchy, rVariables, rValuePtrs);
+            }
+            continue;
+        }
+
+        std::vector<Port*> ports = pComponent->getPortPtrVector();
+        for (size_t p=0; p<ports.size(); ++p)
+        {
+            Port *pPort = ports[p];
+            Node *pNode = pPort->getNodePtr();
+            if (pPort->isMultiPort() || !pPort->isLoggingEnabled() || !pNode || !pNode->isLogging())
+            {
+                continue;
+            }
+            for (size_t j=0; j<pNode->mLoggedDataIds.size(); ++j)
+            {
+                const size_t id = pNode->mLoggedDataIds[j];
+                const NodeDataDescription *pDescription = pNode->getDataDescription(id);
+                if (!pPort->isVariableLoggingEnabled(id) || !pDescription)
+                {
+                    continue;
+                }
+                LogSinkVariable variable;
+                variable.systemHierarchy = rSystemHierarchy;
+                variable.componentName = pComponent->getName();
+                variable.portName = pPort->getName();
+                variable.variableName = pDescription->name;
+                variable.alias = pPort->getVariableAlias(id);
+                variable.unit = pDescription->unit;
+                variable.quantity = pDescription->quantity;
+                rVariables.push_back(variable);
+                rValuePtrs.push_back(&pNode->mDataValues[id]);
+            }
+        }
+    }
+}
+
+
 //! @brief Rename a system parameter
 bool ComponentSystem::renameParameter(const HString &rOldName, const HString &rNewName)
 {
@@ -1451,7 +1961,10 @@ bool ComponentSystem::connect(Port *pPort1, Port *pPort2)
         mpSystemParent->determineCQSType();
     }
 
-    addDebugMessage("Connected: {"+pComp1->getName()+"::"+pPort1->getName()+"} and {"+pComp2->getName()+"::"+pPort2->getName()+"}", "succesfulconnect");
+    if (!mpBulkConstruction)
+    {
+        addDebugMessage("Connected: {"+pComp1->getName()+"::"+pPort1->getName()+"} and {"+pComp2->getName()+"::"+pPort2->getName()+"}", "succesfulconnect");
+    }
     return true;
 }
 
@@ -1783,6 +2296,9 @@ void ComponentSystem::setKeepValuesAsStartValues(bool tf)
 //! @returns true if everything is OK, else false (simulation not permitted)
 bool ComponentSystem::checkModelBeforeSimulation()
 {
+    // Removes the null sub node entries that are left during bulk construction
+    endBulkConstruction();
+
     // Make sure that there are no components or systems with an undefined cqs_type present
     if (mComponentUndefinedptrs.size() > 0)
     {
@@ -1942,6 +2458,13 @@ bool ComponentSystem::checkModelBeforeSimulation()
         addWarningMessage(ss.str().c_str());
     }
 
+    // Pack the node data already here, external code (such as FMU wrappers) may fetch node data pointers between
+    // this check and initialize, and they must remain valid
+    if (!isNodeDataArenaPacked())
+    {
+        packNodeDataArena();
+    }
+
     return true;
 }
 
@@ -2187,6 +2710,9 @@ bool ComponentSystem::initialize(const double startT, const double stopT)
     //cout << "Initializing SubSystem: " << this->mName << endl;
     addCoreLogMessage("ComponentSystem::initialize() in "+getName());
 
+    // Removes the null sub node entries that are left during bulk construction
+    endBulkConstruction();
+
     //Move all disabled components to temporary vectors
     for(size_t i=0; i<mComponentCptrs.size();)
     {
@@ -2272,6 +2798,18 @@ bool ComponentSystem::initialize(const double startT, const double stopT)
     sortComponentVector(mComponentCptrs);
     sortComponentVector(mComponentQptrs);
 
+    // Pack node data contiguously (in simulation order) unless that has already been done, since the model was last changed
+    if (!isNodeDataArenaPacked())
+    {
+        packNodeDataArena();
+    }
+
+    // Restart profiling with the current (sorted) components, this also enables profiling in subsystems added after it was enabled
+    if (mpSimulationProfiler)
+    {
+        setProfilingEnabled(true);
+    }
+
     // run top-level system initialization functions
     if (this->isTopLevelSystem())
     {
@@ -2378,6 +2916,15 @@ bool ComponentSystem::initialize(const double startT, const double stopT)
         return false;
     }
 
+    // Start streaming log data (if this is the outermost streaming system), all subsystems have set up their log plans by now
+    if (mpLogSink && mLogIsStreamed && !(getSystemParent() && getSystemParent()->isLogStreamed()))
+    {
+        if (!startLogStreaming())
+        {
+            return false;
+        }
+    }
+
     // Log the start values
     logTimeAndNodes(mTotalTakenSimulationSteps);
 
@@ -2395,6 +2942,9 @@ void ComponentSystem::simulateMultiThreaded(const double startT, const double st
     ss << nThreads;
     HString threadStr = ss.str().c_str();
 
+    mpMultiThreadPrivates->mThreadLoadStatistics.clear();
+    mpMultiThreadPrivates->mNumAdaptiveReschedules = 0;
+
     if(!noChanges)
     {
         if(algorithm != TaskStealingAlgorithm)
@@ -2403,6 +2953,8 @@ void ComponentSystem::simulateMultiThreaded(const double startT, const double st
             mpMultiThreadPrivates->mSplitQVector.clear();
             mpMultiThreadPrivates->mSplitSignalVector.clear();
             mpMultiThreadPrivates->mSplitNodeVector.clear();
+            mpMultiThreadPrivates->mExpandedSubsystems.clear();
+            mpMultiThreadPrivates->mExpandedSignalTasks.clear();
 
             simulateAndMeasureTime(100);                                //Measure time
             sortComponentVectorsByMeasuredTime();                       //Sort component vectors
@@ -2420,10 +2972,13 @@ void ComponentSystem::simulateMultiThreaded(const double startT, const double st
                 addDebugMessage("Time for "+mComponentSignalptrs.at(s)->getName()+": "+to_hstring(mComponentSignalptrs.at(s)->getMeasuredTime()));
             }
 
-            distributeCcomponents(mpMultiThreadPrivates->mSplitCVector, nThreads);              //Distribute components and nodes
-            distributeQcomponents(mpMultiThreadPrivates->mSplitQVector, nThreads);
+            partitionCQcomponents(mpMultiThreadPrivates->mSplitCVector, mpMultiThreadPrivates->mSplitQVector, nThreads);   //Distribute components and nodes
             distributeSignalcomponents(mpMultiThreadPrivates->mSplitSignalVector, nThreads);
-            distributeNodePointers(mpMultiThreadPrivates->mSplitNodeVector, nThreads);
+            assignNodeOwnership(mpMultiThreadPrivates->mSplitNodeVector, mpMultiThreadPrivates->mSplitSignalVector,
+                                mpMultiThreadPrivates->mSplitCVector, mpMultiThreadPrivates->mSplitQVector);
+
+            // Regroup the node data so that the nodes owned by one thread share cache lines only with each other
+            packNodeDataArena(mpMultiThreadPrivates->mSplitNodeVector);
 
             // Re-initialize the system to reset values and timers
             //! @note This only work for top level systems where the simulateMultiThreaded will not be called more than once
@@ -2440,24 +2995,35 @@ void ComponentSystem::simulateMultiThreaded(const double startT, const double st
             mpMultiThreadPrivates->mSplitQVector.resize(nThreads);
             mpMultiThreadPrivates->mSplitSignalVector.resize(nThreads);
 
-            for(size_t c=0; c<mComponentCptrs.size();)
+            // Subsystems are expanded into their components, so that large subsystems are simulated by several threads
+            std::vector<Component*> expandedC, expandedQ;
+            mpMultiThreadPrivates->mExpandedSignalTasks.clear();
+            mpMultiThreadPrivates->mExpandedSubsystems.clear();
+            collectExpandedTasks(mpMultiThreadPrivates->mExpandedSignalTasks, expandedC, expandedQ, mpMultiThreadPrivates->mExpandedSubsystems);
+            if(!mpMultiThreadPrivates->mExpandedSubsystems.empty())
+            {
+                addDebugMessage("Expanded "+to_hstring(mpMultiThreadPrivates->mExpandedSubsystems.size())+" subsystems into "+
+                                to_hstring(expandedC.size()+expandedQ.size())+" C and Q tasks");
+            }
+
+            for(size_t c=0; c<expandedC.size();)
             {
                 for(size_t t=0; t<nThreads; ++t)
                 {
-                    if(c>mComponentCptrs.size()-1)
+                    if(c>expandedC.size()-1)
                         break;
-                    mpMultiThreadPrivates->mSplitCVector[t].push_back(mComponentCptrs[c]);
+                    mpMultiThreadPrivates->mSplitCVector[t].push_back(expandedC[c]);
                     ++c;
                 }
             }
 
-            for(size_t q=0; q<mComponentQptrs.size();)
+            for(size_t q=0; q<expandedQ.size();)
             {
                 for(size_t t=0; t<nThreads; ++t)
                 {
-                    if(q>mComponentQptrs.size()-1)
+                    if(q>expandedQ.size()-1)
                         break;
-                    mpMultiThreadPrivates->mSplitQVector[t].push_back(mComponentQptrs[q]);
+                    mpMultiThreadPrivates->mSplitQVector[t].push_back(expandedQ[q]);
                     ++q;
                 }
             }
@@ -2475,6 +3041,10 @@ void ComponentSystem::simulateMultiThreaded(const double startT, const double st
         addInfoMessage("Using a priori scheduling algorithm with "+threadStr+" threads.");
 
         mpMultiThreadPrivates->mvTimePtrs.push_back(&mTime);
+        ThreadLoadProfiler profiler(this, mpMultiThreadPrivates->mSplitSignalVector, mpMultiThreadPrivates->mSplitCVector, mpMultiThreadPrivates->mSplitQVector,
+                                    mpMultiThreadPrivates->mProfilingSampleInterval, mpMultiThreadPrivates->mRescheduleImbalanceThreshold,
+                                    mpMultiThreadPrivates->mRescheduleCheckInterval);
+        profiler.start();
         BarrierLock *pBarrierLock_S = new BarrierLock(nThreads);    //Create synchronization barriers
         BarrierLock *pBarrierLock_C = new BarrierLock(nThreads);
         BarrierLock *pBarrierLock_Q = new BarrierLock(nThreads);
@@ -2495,7 +3065,8 @@ void ComponentSystem::simulateMultiThreaded(const double startT, const double st
                             pBarrierLock_S,
                             pBarrierLock_C,
                             pBarrierLock_Q,
-                            pBarrierLock_N);
+                            pBarrierLock_N,
+                            &profiler);
 
         for (size_t t=1; t<nThreads; ++t)
         {
@@ -2505,19 +3076,22 @@ void ComponentSystem::simulateMultiThreaded(const double startT, const double st
                                 std::ref(mpMultiThreadPrivates->mSplitCVector[t]),
                                 std::ref(mpMultiThreadPrivates->mSplitQVector[t]),          //Create slave threads
                                 std::ref(mpMultiThreadPrivates->mSplitNodeVector[t]),
+                                t,
                                 mTime,
                                 mTimestep,
                                 nSteps,
                                 pBarrierLock_S,
                                 pBarrierLock_C,
                                 pBarrierLock_Q,
-                                pBarrierLock_N);
+                                pBarrierLock_N,
+                                &profiler);
         }
 
         for (size_t i = 0; i<nThreads; ++i)                 //Wait for all tasks to finish
         {
             tt[i].join();
         }
+        storeThreadLoadStatistics(profiler);
 
         delete[] tt;
         delete(pBarrierLock_S);
@@ -2611,78 +3185,69 @@ void ComponentSystem::simulateMultiThreaded(const double startT, const double st
     }
     else if(algorithm == TaskStealingAlgorithm)
     {
-        addInfoMessage("Using task-stealing algorithm with "+threadStr+" threads.");
-
-        mpMultiThreadPrivates->mvTimePtrs.push_back(&mTime);
-        BarrierLock *pBarrierLock_S = new BarrierLock(nThreads);    //Create synchronization barriers
-        BarrierLock *pBarrierLock_C = new BarrierLock(nThreads);
-        BarrierLock *pBarrierLock_Q = new BarrierLock(nThreads);
-        BarrierLock *pBarrierLock_N = new BarrierLock(nThreads);
-
-        size_t maxSize = mComponentCptrs.size()+mComponentQptrs.size()+mComponentSignalptrs.size();
-
-        std::vector<ThreadSafeVector *> *pVectorsC = new std::vector<ThreadSafeVector *>();
-        for(size_t i=0; i<mpMultiThreadPrivates->mSplitCVector.size(); ++i)
+        // The worker threads are kept between simulations, as long as the number of threads and spin budget are unchanged
+        std::unique_ptr<WorkStealingScheduler> &rpScheduler = mpMultiThreadPrivates->mpWorkStealingScheduler;
+        if(!rpScheduler || (rpScheduler->getNumThreads() != nThreads) || (rpScheduler->getSpinBudget() != mpMultiThreadPrivates->mBarrierSpinBudget))
         {
-            pVectorsC->push_back(new ThreadSafeVector(mpMultiThreadPrivates->mSplitCVector[i], maxSize));
+            rpScheduler.reset(new WorkStealingScheduler(nThreads, mpMultiThreadPrivates->mBarrierSpinBudget));
         }
 
-        std::vector<ThreadSafeVector *> *pVectorsQ = new std::vector<ThreadSafeVector *>();
-        for(size_t i=0; i<mpMultiThreadPrivates->mSplitQVector.size(); ++i)
+        addInfoMessage("Using task-stealing algorithm (work-stealing deques, spin budget "+to_hstring(mpMultiThreadPrivates->mBarrierSpinBudget)+") with "+threadStr+" threads.");
+
+        // The time of the expanded subsystems is updated together with the time of this system
+        mpMultiThreadPrivates->mvTimePtrs.clear();
+        mpMultiThreadPrivates->mvTimePtrs.push_back(&mTime);
+        for(size_t i=0; i<mpMultiThreadPrivates->mExpandedSubsystems.size(); ++i)
         {
-            pVectorsQ->push_back(new ThreadSafeVector(mpMultiThreadPrivates->mSplitQVector[i], maxSize));
+            mpMultiThreadPrivates->mvTimePtrs.push_back(&mpMultiThreadPrivates->mExpandedSubsystems[i]->mTime);
         }
+        std::vector<Component*> &rSignalTasks = mpMultiThreadPrivates->mExpandedSubsystems.empty() ? mComponentSignalptrs : mpMultiThreadPrivates->mExpandedSignalTasks;
+        rpScheduler->simulate(this,
+                              rSignalTasks,
+                              mpMultiThreadPrivates->mSplitCVector,
+                              mpMultiThreadPrivates->mSplitQVector,
+                              mpMultiThreadPrivates->mvTimePtrs,
+                              mpMultiThreadPrivates->mExpandedSubsystems,
+                              mTime,
+                              mTimestep,
+                              nSteps);
 
-        std::thread *tt = new std::thread[nThreads];
-
-        tt[0] = std::thread(simStealingMaster,
-                            this,
-                            std::ref(mComponentSignalptrs),
-                            pVectorsC,
-                            pVectorsQ,             //Create master thread
-                            std::ref(mpMultiThreadPrivates->mvTimePtrs),
-                            mTime,
-                            mTimestep,
-                            nSteps,
-                            nThreads,
-                            0,
-                            pBarrierLock_S,
-                            pBarrierLock_C,
-                            pBarrierLock_Q,
-                            pBarrierLock_N,
-                            maxSize);
-
+        addDebugMessage("Number of stolen tasks: "+to_hstring(rpScheduler->getNumStolenTasks()));
+    }
+    else if(algorithm == APrioriHybridBarrierScheduling)
+    {
+        addInfoMessage("Using a priori scheduling algorithm (hybrid barrier, spin budget "+to_hstring(mpMultiThreadPrivates->mBarrierSpinBudget)+") with "+threadStr+" threads.");
 
-        for (size_t t=1; t<nThreads; ++t)
+        mpMultiThreadPrivates->mvTimePtrs.push_back(&mTime);
+        HybridBarrier barrier(nThreads, mpMultiThreadPrivates->mBarrierSpinBudget);
+        ThreadLoadProfiler profiler(this, mpMultiThreadPrivates->mSplitSignalVector, mpMultiThreadPrivates->mSplitCVector, mpMultiThreadPrivates->mSplitQVector,
+                                    mpMultiThreadPrivates->mProfilingSampleInterval, mpMultiThreadPrivates->mRescheduleImbalanceThreshold,
+                                    mpMultiThreadPrivates->mRescheduleCheckInterval);
+        profiler.start();
+
+        std::vector<std::thread> threads;
+        threads.reserve(nThreads);
+        for (size_t t=0; t<nThreads; ++t)
         {
-            tt[t] = std::thread(simStealingSlave,
-                                this,
-                                pVectorsC,
-                                pVectorsQ,
-                                mTime,
-                                mTimestep,
-                                nSteps,
-                                nThreads,
-                                t,
-                                pBarrierLock_S,
-                                pBarrierLock_C,
-                                pBarrierLock_Q,
-                                pBarrierLock_N,
-                                maxSize);
+            threads.push_back(std::thread(simHybridBarrierThread,
+                                          this,
+                                          std::ref(mpMultiThreadPrivates->mSplitSignalVector[t]),
+                                          std::ref(mpMultiThreadPrivates->mSplitCVector[t]),
+                                          std::ref(mpMultiThreadPrivates->mSplitQVector[t]),
+                                          std::ref(mpMultiThreadPrivates->mvTimePtrs),
+                                          t,
+                                          mTime,
+                                          mTimestep,
+                                          nSteps,
+                                          &barrier,
+                                          &profiler));
         }
 
-        for (size_t i = 0; i<nThreads; ++i)                 //Wait for all tasks to finish
+        for (size_t i = 0; i<nThreads; ++i)                 //Wait for all threads to finish
         {
-            tt[i].join();
+            threads[i].join();
         }
-
-        delete[] tt;                                           //Clean up
-        delete(pBarrierLock_S);
-        delete(pBarrierLock_C);
-        delete(pBarrierLock_Q);
-        delete(pBarrierLock_N);
-        delete(pVectorsC);
-        delete(pVectorsQ);
+        storeThreadLoadStatistics(profiler);
     }
     else if(algorithm == ForkJoinAlgorithm)
     {
@@ -3087,179 +3652,1097 @@ void ComponentSystem::distributeNodePointers(vector< vector<Node*> > &rSplitNode
     }
 }
 
-void ComponentSystem::reschedule(size_t nThreads)
-{
-    mpMultiThreadPrivates->mSplitCVector.clear();
-    mpMultiThreadPrivates->mSplitQVector.clear();
-    mpMultiThreadPrivates->mSplitSignalVector.clear();
-    mpMultiThreadPrivates->mSplitNodeVector.clear();
+namespace {
 
-    simulateAndMeasureTime(10);                                //Measure time
-    sortComponentVectorsByMeasuredTime();                       //Sort component vectors
+//! @brief Relative load imbalance allowed per phase when partitioning, in addition to what greedy load balancing gives
+const double partitionImbalanceTolerance = 0.05;
 
-    distributeCcomponents(mpMultiThreadPrivates->mSplitCVector, nThreads);              //Distribute components and nodes
-    distributeQcomponents(mpMultiThreadPrivates->mSplitQVector, nThreads);
-    distributeSignalcomponents(mpMultiThreadPrivates->mSplitSignalVector, nThreads);
-    distributeNodePointers(mpMultiThreadPrivates->mSplitNodeVector, nThreads);
-}
+//! @brief Maximum number of refinement passes when partitioning
+const size_t partitionMaxRefinementPasses = 10;
 
-#endif
+//! @brief Maximum number of components tried as swap partner for each component in a refinement pass
+const size_t partitionMaxSwapCandidates = 32;
 
-//! @brief Helper function that simulates all components and measure their average time requirements.
-//! @param steps How many steps to simulate
-bool ComponentSystem::simulateAndMeasureTime(const size_t nSteps)
+//! @brief Helper class for partitioning C and Q components over threads
+//! @details The components are vertices in a hypergraph where each node is a hyperedge connecting the components
+//! that share it. The measured times of C and Q components are balanced separately since they run in different
+//! phases. The cut (the number of nodes used by more than one thread) is first kept low by a greedy assignment that
+//! prefers threads already using the nodes of a component, and then reduced further by moving and swapping
+//! components as long as the load limit of each phase is respected.
+class ComponentPartitioner
 {
-#if (__cplusplus >= 201103L)
-    // Reset all measured times first
-    for(size_t s=0; s<mComponentSignalptrs.size(); ++s)
-        mComponentSignalptrs[s]->setMeasuredTime(0);
-    for(size_t c=0; c<mComponentCptrs.size(); ++c)
-        mComponentCptrs[c]->setMeasuredTime(0);
-    for(size_t q=0; q<mComponentQptrs.size(); ++q)
-        mComponentQptrs[q]->setMeasuredTime(0);
-
-
-        // Measure time for each component during specified amount of steps
-    double time;
-
-    for(size_t s=0; s<mComponentSignalptrs.size(); ++s)
-    {
-        time = mTime; // Init time
-#ifdef _WIN32
-        HighResClock::time_point t0 = HighResClock::now();
-#else
-        timespec t0;
-        clock_gettime(CLOCK_REALTIME, &t0);
-#endif
-        time += mTimestep*nSteps;
-        mComponentSignalptrs[s]->simulate(time);
-#ifdef _WIN32
-        HighResClock::time_point t1 = HighResClock::now();
-        HighResClock::duration dt = t1-t0;
-        mComponentSignalptrs[s]->setMeasuredTime(dt.count()/1000000.0);
-#else
-        timespec t1;
-        clock_gettime(CLOCK_REALTIME, &t1);
-        mComponentSignalptrs[s]->setMeasuredTime(double(t1.tv_nsec-t0.tv_nsec)/1000000.0);
-#endif
-    }
+public:
+    //! @param rCComponents The C components
+    //! @param rQComponents The Q components
+    //! @param rNodeComponents For each node, the components connected to it
+    //! @param nThreads The number of threads to partition for
+    ComponentPartitioner(const std::vector<Component*> &rCComponents, const std::vector<Component*> &rQComponents,
+                         const std::vector< std::vector<Component*> > &rNodeComponents, const size_t nThreads)
+    {
+        mnThreads = std::max(size_t(1), nThreads);
+        mNumMoves = 0;
+        mNumSwaps = 0;
+        mInitialCutSize = 0;
+        mInitialAssignmentInGraphOrder = false;
+
+        std::map<Component*, size_t> vertexMap;
+        addVertices(rCComponents, 0, vertexMap);
+        addVertices(rQComponents, 1, vertexMap);
+
+        // Only nodes shared by at least two of the components can be cut
+        mVertexNodes.resize(mVertices.size());
+        for (size_t n=0; n<rNodeComponents.size(); ++n)
+        {
+            std::vector<size_t> nodeVertices;
+            for (size_t c=0; c<rNodeComponents[n].size(); ++c)
+            {
+                std::map<Component*, size_t>::iterator it = vertexMap.find(rNodeComponents[n][c]);
+                if ((it != vertexMap.end()) && !vectorContains(nodeVertices, it->second))
+                {
+                    nodeVertices.push_back(it->second);
+                }
+            }
+            if (nodeVertices.size() > 1)
+            {
+                for (size_t v=0; v<nodeVertices.size(); ++v)
+                {
+                    mVertexNodes[nodeVertices[v]].push_back(mNodeVertices.size());
+                }
+                mNodeVertices.push_back(nodeVertices);
+            }
+        }
 
-    for(size_t c=0; c<mComponentCptrs.size(); ++c)
-    {
-        time=mTime; // Reset time
-#ifdef _WIN32
-        HighResClock::time_point t0 = HighResClock::now();
-#else
-        timespec t0;
-        clock_gettime(CLOCK_REALTIME, &t0);
-#endif
-        time += mTimestep*nSteps;
-        mComponentCptrs[c]->simulate(time);
-#ifdef _WIN32
-        HighResClock::time_point t1 = HighResClock::now();
-        HighResClock::duration dt = t1-t0;
-        mComponentCptrs[c]->setMeasuredTime(dt.count()/1000000.0);
-#else
-        timespec t1;
-        clock_gettime(CLOCK_REALTIME, &t1);
-        mComponentCptrs[c]->setMeasuredTime(double(t1.tv_nsec-t0.tv_nsec)/1000000.0);
-#endif
+        mThread.assign(mVertices.size(), mnThreads);
+        mNodeThreadCount.assign(mNodeVertices.size()*mnThreads, 0);
+        mLoad.assign(2*mnThreads, 0.0);
     }
 
-    for(size_t q=0; q<mComponentQptrs.size(); ++q)
+    void partition()
     {
-        time=mTime; // Reset time
-#ifdef _WIN32
-        HighResClock::time_point t0 = HighResClock::now();
-#else
-        timespec t0;
-        clock_gettime(CLOCK_REALTIME, &t0);
-#endif
-        time += mTimestep*nSteps;
-        mComponentQptrs[q]->simulate(time);
-
-#ifdef _WIN32
-        HighResClock::time_point t1 = HighResClock::now();
-        HighResClock::duration dt = t1-t0;
-        mComponentQptrs[q]->setMeasuredTime(dt.count()/1000000.0);
-#else
-        timespec t1;
-        clock_gettime(CLOCK_REALTIME, &t1);
-        mComponentQptrs[q]->setMeasuredTime(double(t1.tv_nsec-t0.tv_nsec)/1000000.0);
-#endif
-    }
+        // Heaviest components first, as in greedy load balancing
+        std::vector<size_t> order(mVertices.size());
+        for (size_t v=0; v<order.size(); ++v)
+        {
+            order[v] = v;
+        }
+        std::stable_sort(order.begin(), order.end(), CostGreater(mCost));
 
-    return true;
-#else
-    this->addErrorMessage("Measuring simulation time requires C++11 support.");
-    return false;
-#endif
-}
+        calculateLoadLimits(order);
 
+        // Prefer contiguous regions of the graph, fall back to greedy assignment if that exceeds the load limits
+        mInitialAssignmentInGraphOrder = assignInGraphOrder();
+        if (!mInitialAssignmentInGraphOrder)
+        {
+            assignGreedily(order);
+        }
+        mInitialCutSize = getCutSize();
 
-//! @brief Returns the total sum of the measured time of the components in the system
-double ComponentSystem::getTotalMeasuredTime()
-{
-    double time = 0;
-#if (__cplusplus >= 201103L)
-    for(size_t s=0; s<mComponentSignalptrs.size(); ++s)
-    {
-        time += mComponentSignalptrs[s]->getMeasuredTime();
+        if (mnThreads > 1)
+        {
+            for (size_t pass=0; pass<partitionMaxRefinementPasses; ++pass)
+            {
+                if (!refine())
+                {
+                    break;
+                }
+            }
+        }
     }
-    for(size_t c=0; c<mComponentCptrs.size(); ++c)
+
+    //! @brief Returns the thread of vertex v (C components first, then Q components)
+    size_t getThread(const size_t v) const
     {
-        time += mComponentCptrs[c]->getMeasuredTime();
+        return mThread[v];
     }
-    for(size_t q=0; q<mComponentQptrs.size(); ++q)
+
+    //! @brief Returns the measured time of the components in one phase (0=C, 1=Q) on one thread
+    double getLoad(const size_t phase, const size_t t) const
     {
-        time += mComponentQptrs[q]->getMeasuredTime();
+        return mLoad[phase*mnThreads+t];
     }
-#else
-    this->addErrorMessage("Measuring simulation time requires C++11 support.");
-#endif
-    return time;
-}
 
-
-//! @brief Helper function that sorts C- and Q- component vectors by simulation time for each component.
-//! @todo This function uses bubblesort. Maybe change to something faster.
-void ComponentSystem::sortComponentVectorsByMeasuredTime()
-{
-#if (__cplusplus >= 201103L)
-    //Sort the components from longest to shortest time requirement
-    size_t i, j;
-    bool flag = true;
-    Component *tempC;
-    for(i = 1; (i < mComponentCptrs.size()) && flag; ++i)
+    //! @brief Returns the number of shared nodes that are used by more than one thread
+    size_t getCutSize() const
     {
-        flag = false;
-        for (j=0; j < (mComponentCptrs.size()-1); ++j)
+        size_t cutSize = 0;
+        for (size_t n=0; n<mNodeVertices.size(); ++n)
         {
-            if (mComponentCptrs[j+1]->getMeasuredTime() > mComponentCptrs[j]->getMeasuredTime())
+            size_t nThreadsUsingNode = 0;
+            for (size_t t=0; t<mnThreads; ++t)
+            {
+                if (mNodeThreadCount[n*mnThreads+t] > 0)
+                {
+                    ++nThreadsUsingNode;
+                }
+            }
+            if (nThreadsUsingNode > 1)
             {
-                tempC = mComponentCptrs[j];             //Swap elements
-                mComponentCptrs[j] = mComponentCptrs[j+1];
-                mComponentCptrs[j+1] = tempC;
-                flag = true;               //Indicates that a swap occurred
+                ++cutSize;
             }
         }
+        return cutSize;
     }
-    flag = true;
-    Component *tempQ;
-    for(i = 1; (i < mComponentQptrs.size()) && flag; ++i)
+
+    size_t getNumSharedNodes() const { return mNodeVertices.size(); }
+    size_t getInitialCutSize() const { return mInitialCutSize; }
+    //! @brief Returns the name of the initial assignment, before refinement
+    const char *getInitialAssignmentName() const { return mInitialAssignmentInGraphOrder ? "breadth-first" : "greedy"; }
+    size_t getNumMoves() const { return mNumMoves; }
+    size_t getNumSwaps() const { return mNumSwaps; }
+
+private:
+    class CostGreater
+    {
+    public:
+        CostGreater(const std::vector<double> &rCost) : mrCost(rCost) {}
+        bool operator()(const size_t a, const size_t b) const { return mrCost[a] > mrCost[b]; }
+    private:
+        const std::vector<double> &mrCost;
+    };
+
+    class CostLess
+    {
+    public:
+        CostLess(const std::vector<double> &rCost) : mrCost(rCost) {}
+        bool operator()(const size_t a, const size_t b) const { return mrCost[a] < mrCost[b]; }
+        bool operator()(const size_t a, const double cost) const { return mrCost[a] < cost; }
+    private:
+        const std::vector<double> &mrCost;
+    };
+
+    void addVertices(const std::vector<Component*> &rComponents, const size_t phase, std::map<Component*, size_t> &rVertexMap)
+    {
+        // Use unit cost if no time has been measured, then the number of components is balanced instead
+        double totalTime = 0;
+        for (size_t c=0; c<rComponents.size(); ++c)
+        {
+            totalTime += rComponents[c]->getMeasuredTime();
+        }
+        for (size_t c=0; c<rComponents.size(); ++c)
+        {
+            rVertexMap.insert(std::pair<Component*, size_t>(rComponents[c], mVertices.size()));
+            mVertices.push_back(rComponents[c]);
+            mPhase.push_back(phase);
+            mCost.push_back((totalTime > 0) ? std::max(0.0, rComponents[c]->getMeasuredTime()) : 1.0);
+        }
+    }
+
+    //! @brief Assign contiguous ranges of a breadth-first ordering of the graph to the threads, separately per phase
+    //! @returns False (and leaves all vertices unassigned) if the resulting load exceeds the limit of a phase
+    bool assignInGraphOrder()
+    {
+        const std::vector<size_t> order = calcBreadthFirstOrder();
+        double totalLoad[2] = {0, 0};
+        for (size_t v=0; v<mVertices.size(); ++v)
+        {
+            totalLoad[mPhase[v]] += mCost[v];
+        }
+
+        // A vertex goes to the thread whose share of the phase load contains the middle of the vertex
+        double accumulatedLoad[2] = {0, 0};
+        for (size_t i=0; i<order.size(); ++i)
+        {
+            const size_t v = order[i];
+            const size_t phase = mPhase[v];
+            const double share = totalLoad[phase]/double(mnThreads);
+            const double position = accumulatedLoad[phase]+0.5*mCost[v];
+            const size_t t = (share > 0) ? std::min(mnThreads-1, size_t(position/share)) : 0;
+            assign(v, t);
+            accumulatedLoad[phase] += mCost[v];
+        }
+
+        for (size_t t=0; t<mnThreads; ++t)
+        {
+            if ((getLoad(0, t) > mLoadLimit[0]) || (getLoad(1, t) > mLoadLimit[1]))
+            {
+                for (size_t v=0; v<mVertices.size(); ++v)
+                {
+                    unassign(v);
+                }
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //! @brief Assign the heaviest vertex first to the thread using most of its nodes, among the threads where it fits
+    void assignGreedily(const std::vector<size_t> &rOrder)
+    {
+        for (size_t i=0; i<rOrder.size(); ++i)
+        {
+            const size_t v = rOrder[i];
+            const size_t phase = mPhase[v];
+            size_t bestThread = mnThreads;
+            size_t bestAffinity = 0;
+            size_t leastLoadedThread = 0;
+            for (size_t t=0; t<mnThreads; ++t)
+            {
+                if (getLoad(phase, t) < getLoad(phase, leastLoadedThread))
+                {
+                    leastLoadedThread = t;
+                }
+                if (getLoad(phase, t)+mCost[v] > mLoadLimit[phase])
+                {
+                    continue;
+                }
+                const size_t affinity = calcAffinity(v, t);
+                if ((bestThread == mnThreads) || (affinity > bestAffinity) ||
+                    ((affinity == bestAffinity) && (getLoad(phase, t) < getLoad(phase, bestThread))))
+                {
+                    bestThread = t;
+                    bestAffinity = affinity;
+                }
+            }
+            assign(v, (bestThread == mnThreads) ? leastLoadedThread : bestThread);
+        }
+    }
+
+    //! @brief Returns the vertices in breadth-first order, starting each connected part from a vertex far from its first vertex
+    std::vector<size_t> calcBreadthFirstOrder() const
+    {
+        std::vector<size_t> order, probe;
+        order.reserve(mVertices.size());
+        std::vector<size_t> visited(mVertices.size(), 0), probeVisited(mVertices.size(), 0);
+        for (size_t v=0; v<mVertices.size(); ++v)
+        {
+            if (visited[v])
+            {
+                continue;
+            }
+            // The last vertex reached from v is used as start, that gives longer and narrower levels
+            probe.clear();
+            breadthFirstSearch(v, v+1, probeVisited, probe);
+            breadthFirstSearch(probe.back(), 1, visited, order);
+        }
+        return order;
+    }
+
+    //! @brief Appends the vertices reachable from start to rOrder, vertices are marked as visited by setting them to mark
+    void breadthFirstSearch(const size_t start, const size_t mark, std::vector<size_t> &rVisited, std::vector<size_t> &rOrder) const
+    {
+        size_t next = rOrder.size();
+        rOrder.push_back(start);
+        rVisited[start] = mark;
+        while (next < rOrder.size())
+        {
+            const size_t v = rOrder[next++];
+            for (size_t i=0; i<mVertexNodes[v].size(); ++i)
+            {
+                const std::vector<size_t> &rNeighbours = mNodeVertices[mVertexNodes[v][i]];
+                for (size_t j=0; j<rNeighbours.size(); ++j)
+                {
+                    if (rVisited[rNeighbours[j]] != mark)
+                    {
+                        rVisited[rNeighbours[j]] = mark;
+                        rOrder.push_back(rNeighbours[j]);
+                    }
+                }
+            }
+        }
+    }
+
+    //! @brief Limit each phase to the makespan of greedy load balancing, or the tolerance above the average if that is larger
+    void calculateLoadLimits(const std::vector<size_t> &rOrder)
+    {
+        for (size_t phase=0; phase<2; ++phase)
+        {
+            std::vector<double> greedyLoad(mnThreads, 0.0);
+            double totalLoad = 0;
+            for (size_t i=0; i<rOrder.size(); ++i)
+            {
+                if (mPhase[rOrder[i]] == phase)
+                {
+                    *std::min_element(greedyLoad.begin(), greedyLoad.end()) += mCost[rOrder[i]];
+                    totalLoad += mCost[rOrder[i]];
+                }
+            }
+            const double greedyMakespan = *std::max_element(greedyLoad.begin(), greedyLoad.end());
+            mLoadLimit[phase] = std::max(greedyMakespan, (1.0+partitionImbalanceTolerance)*totalLoad/double(mnThreads));
+            // Avoid rejecting assignments because of round-off
+            mLoadLimit[phase] *= (1.0+1e-12);
+        }
+    }
+
+    //! @brief Sort the vertices of each phase and thread by cost, used as swap candidates during a refinement pass
+    //! @details Vertices that move during the pass are not updated here, entries are skipped if the thread no longer matches
+    void sortThreadVertices()
+    {
+        mThreadVertices.assign(2*mnThreads, std::vector<size_t>());
+        for (size_t v=0; v<mVertices.size(); ++v)
+        {
+            mThreadVertices[mPhase[v]*mnThreads+mThread[v]].push_back(v);
+        }
+        for (size_t i=0; i<mThreadVertices.size(); ++i)
+        {
+            std::stable_sort(mThreadVertices[i].begin(), mThreadVertices[i].end(), CostLess(mCost));
+        }
+    }
+
+    //! @brief One refinement pass, moves components with positive gain, or swaps them when a move alone would exceed the load limit
+    //! @returns True if the cut was reduced
+    bool refine()
+    {
+        bool improved = false;
+        sortThreadVertices();
+        for (size_t v=0; v<mVertices.size(); ++v)
+        {
+            const size_t from = mThread[v];
+            const size_t phase = mPhase[v];
+            int bestGain = 0;
+            size_t bestThread = mnThreads;
+            for (size_t t=0; t<mnThreads; ++t)
+            {
+                if (t == from)
+                {
+                    continue;
+                }
+                const int gain = calcMoveGain(v, t);
+                if (gain > bestGain)
+                {
+                    bestGain = gain;
+                    bestThread = t;
+                }
+            }
+            if (bestThread == mnThreads)
+            {
+                continue;
+            }
+
+            if (getLoad(phase, bestThread)+mCost[v] <= mLoadLimit[phase])
+            {
+                unassign(v);
+                assign(v, bestThread);
+                ++mNumMoves;
+                improved = true;
+                continue;
+            }
+
+            // Try to swap with a component of the same phase on the target thread, only components with a cost that
+            // keeps both threads within the load limit are tried
+            const double minCost = getLoad(phase, bestThread)+mCost[v]-mLoadLimit[phase];
+            const double maxCost = mLoadLimit[phase]-getLoad(phase, from)+mCost[v];
+            const std::vector<size_t> &rCandidates = mThreadVertices[phase*mnThreads+bestThread];
+            std::vector<size_t>::const_iterator it = std::lower_bound(rCandidates.begin(), rCandidates.end(), minCost, CostLess(mCost));
+            for (size_t numTried=0; (it != rCandidates.end()) && (mCost[*it] <= maxCost) && (numTried < partitionMaxSwapCandidates); ++it)
+            {
+                const size_t u = *it;
+                if (mThread[u] != bestThread)
+                {
+                    continue;
+                }
+                ++numTried;
+                if ((getLoad(phase, from)-mCost[v]+mCost[u] > mLoadLimit[phase]) ||
+                    (getLoad(phase, bestThread)-mCost[u]+mCost[v] > mLoadLimit[phase]))
+                {
+                    continue;
+                }
+                unassign(v);
+                assign(v, bestThread);
+                if (bestGain + calcMoveGain(u, from) > 0)
+                {
+                    unassign(u);
+                    assign(u, from);
+                    ++mNumSwaps;
+                    improved = true;
+                    break;
+                }
+                unassign(v);
+                assign(v, from);
+            }
+        }
+        return improved;
+    }
+
+    //! @brief Returns the reduction in cut size if vertex v is moved to thread t
+    int calcMoveGain(const size_t v, const size_t t) const
+    {
+        const size_t from = mThread[v];
+        int gain = 0;
+        for (size_t i=0; i<mVertexNodes[v].size(); ++i)
+        {
+            const size_t n = mVertexNodes[v][i];
+            if (mNodeThreadCount[n*mnThreads+from] == 1)
+            {
+                ++gain;
+            }
+            if (mNodeThreadCount[n*mnThreads+t] == 0)
+            {
+                --gain;
+            }
+        }
+        return gain;
+    }
+
+    //! @brief Returns the number of nodes of vertex v that are already used by thread t
+    size_t calcAffinity(const size_t v, const size_t t) const
+    {
+        size_t affinity = 0;
+        for (size_t i=0; i<mVertexNodes[v].size(); ++i)
+        {
+            if (mNodeThreadCount[mVertexNodes[v][i]*mnThreads+t] > 0)
+            {
+                ++affinity;
+            }
+        }
+        return affinity;
+    }
+
+    void assign(const size_t v, const size_t t)
+    {
+        mThread[v] = t;
+        mLoad[mPhase[v]*mnThreads+t] += mCost[v];
+        for (size_t i=0; i<mVertexNodes[v].size(); ++i)
+        {
+            ++mNodeThreadCount[mVertexNodes[v][i]*mnThreads+t];
+        }
+    }
+
+    void unassign(const size_t v)
+    {
+        const size_t t = mThread[v];
+        mLoad[mPhase[v]*mnThreads+t] -= mCost[v];
+        for (size_t i=0; i<mVertexNodes[v].size(); ++i)
+        {
+            --mNodeThreadCount[mVertexNodes[v][i]*mnThreads+t];
+        }
+        mThread[v] = mnThreads;
+    }
+
+    size_t mnThreads;
+    std::vector<Component*> mVertices;
+    std::vector<size_t> mPhase;
+    std::vector<double> mCost;
+    std::vector< std::vector<size_t> > mVertexNodes;
+    std::vector< std::vector<size_t> > mNodeVertices;
+    std::vector<size_t> mThread;
+    std::vector<size_t> mNodeThreadCount;
+    std::vector<double> mLoad;
+    std::vector< std::vector<size_t> > mThreadVertices;
+    double mLoadLimit[2];
+    size_t mNumMoves, mNumSwaps, mInitialCutSize;
+    bool mInitialAssignmentInGraphOrder;
+};
+
+//! @brief Check if any signal component in a system, or in its subsystems, has a port on one of the given nodes
+bool signalComponentsUseNodes(ComponentSystem *pSystem, const std::vector<const Node*> &rNodes)
+{
+    const std::vector<Component*> subComponents = pSystem->getSubComponents();
+    for (size_t c=0; c<subComponents.size(); ++c)
+    {
+        Component *pComponent = subComponents[c];
+        if (pComponent->isComponentSystem())
+        {
+            if (signalComponentsUseNodes(static_cast<ComponentSystem*>(pComponent), rNodes))
+            {
+                return true;
+            }
+            continue;
+        }
+        if (pComponent->getTypeCQS() != Component::SType)
+        {
+            continue;
+        }
+        std::vector<Port*> ports = pComponent->getPortPtrVector();
+        for (size_t p=0; p<ports.size(); ++p)
+        {
+            const size_t numSubPorts = ports[p]->isMultiPort() ? ports[p]->getNumPorts() : 1;
+            for (size_t s=0; s<numSubPorts; ++s)
+            {
+                const Node *pNode = ports[p]->getNodePtr(s);
+                if (pNode && (std::find(rNodes.begin(), rNodes.end(), pNode) != rNodes.end()))
+                {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+} // anon namespace
+
+
+//! @brief Check if a subcomponent is a subsystem that can be simulated as its components, in the phases of this system
+//! @details The components of a C- or Q-type subsystem can be spread over the C and Q phases of this system, if the subsystem
+//! simulates one step per step of this system. Its signal components are then simulated after the signal components of this
+//! system, instead of at the start of the subsystem step in the C or Q phase. Subsystems with signal connections to anything
+//! but signal components in this system are not expanded, since the order in which such signals are written and read could
+//! change. Neither are Q-type subsystems with signal components (e.g. sensors) on the nodes at their ports, those would read
+//! the wave variables written by the C components of this system one step late.
+//! @param pComponent The subcomponent to check
+//! @returns True if the subsystem can be expanded
+bool ComponentSystem::isExpandableSubsystem(Component *pComponent) const
+{
+    if (!pComponent->isComponentSystem())
+    {
+        return false;
+    }
+    ComponentSystem *pSubsystem = static_cast<ComponentSystem*>(pComponent);
+    if ((pSubsystem->getTypeCQS() != CType) && (pSubsystem->getTypeCQS() != QType))
+    {
+        return false;
+    }
+    // A subsystem with a different time step takes several (or no) steps per step of this system
+    if (std::fabs(pSubsystem->getTimestep()-mTimestep) > 1e-9*mTimestep)
+    {
+        return false;
+    }
+    if (pSubsystem->isProfilingEnabled())
+    {
+        return false;
+    }
+
+    std::vector<Port*> ports = pSubsystem->getPortPtrVector();
+    for (size_t p=0; p<ports.size(); ++p)
+    {
+        if (ports[p]->getNodeType() != "NodeSignal")
+        {
+            continue;
+        }
+        std::vector<Port*> connectedPorts = ports[p]->getConnectedPorts();
+        for (size_t c=0; c<connectedPorts.size(); ++c)
+        {
+            Component *pOther = connectedPorts[c]->getComponent();
+            const bool isInside = (pOther->getSystemParent() == pSubsystem);
+            const bool isOwnSystemPort = (pOther == this);
+            if (!isInside && !isOwnSystemPort && (pOther->getTypeCQS() != SType))
+            {
+                return false;
+            }
+        }
+    }
+
+    // In a serial simulation, the signal components of a Q-type subsystem run after the C phase of this system
+    if (pSubsystem->getTypeCQS() == QType)
+    {
+        std::vector<const Node*> portNodes;
+        for (size_t p=0; p<ports.size(); ++p)
+        {
+            if ((ports[p]->getNodeType() != "NodeSignal") && ports[p]->getNodePtr())
+            {
+                portNodes.push_back(ports[p]->getNodePtr());
+            }
+        }
+        if (!portNodes.empty() && signalComponentsUseNodes(pSubsystem, portNodes))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+//! @brief Helper function that collects the components to simulate in each phase, with subsystems expanded into their components
+//! @details Subsystems that can be expanded (see isExpandableSubsystem()) are replaced by their own components, recursively, so
+//! that a model made of a few large subsystems gives many independent tasks. The signal components of an expanded subsystem
+//! are appended after the signal components of this system, in their sorted order. This gives the same results as the serial
+//! simulation only because isExpandableSubsystem() rejects subsystems whose signal components would see different node values.
+//! @param rSignalTasks Signal components, in simulation order
+//! @param rCTasks C-type components and subsystems
+//! @param rQTasks Q-type components and subsystems
+//! @param rExpandedSystems The expanded subsystems, their time must be updated and their nodes logged after each step
+void ComponentSystem::collectExpandedTasks(std::vector<Component*> &rSignalTasks, std::vector<Component*> &rCTasks, std::vector<Component*> &rQTasks,
+                                           std::vector<ComponentSystem*> &rExpandedSystems)
+{
+    rSignalTasks.insert(rSignalTasks.end(), mComponentSignalptrs.begin(), mComponentSignalptrs.end());
+
+    std::vector<ComponentSystem*> expandedHere;
+    const std::vector<Component*> *cqVectors[] = {&mComponentCptrs, &mComponentQptrs};
+    std::vector<Component*> *cqTasks[] = {&rCTasks, &rQTasks};
+    for (size_t v=0; v<2; ++v)
+    {
+        for (size_t i=0; i<cqVectors[v]->size(); ++i)
+        {
+            Component *pComponent = (*cqVectors[v])[i];
+            if (isExpandableSubsystem(pComponent))
+            {
+                expandedHere.push_back(static_cast<ComponentSystem*>(pComponent));
+            }
+            else
+            {
+                cqTasks[v]->push_back(pComponent);
+            }
+        }
+    }
+
+    // Expanded in the order they would have been simulated, so that their signal components keep that order
+    for (size_t i=0; i<expandedHere.size(); ++i)
+    {
+        rExpandedSystems.push_back(expandedHere[i]);
+        expandedHere[i]->collectExpandedTasks(rSignalTasks, rCTasks, rQTasks, rExpandedSystems);
+    }
+}
+
+
+//! @brief Helper function that distributes C and Q components over one vector per thread, based on measured time and connectivity
+//! The measured time of C and Q components is balanced per phase, while components that share nodes are kept on the same
+//! thread as far as possible, so that less node data has to move between the caches of different cores.
+//! @param rSplitCVector Reference to vector with vectors of C components (one vector per thread)
+//! @param rSplitQVector Reference to vector with vectors of Q components (one vector per thread)
+//! @param nThreads Number of simulation threads
+void ComponentSystem::partitionCQcomponents(vector< vector<Component*> > &rSplitCVector, vector< vector<Component*> > &rSplitQVector, size_t nThreads)
+{
+    vector< vector<Component*> > nodeComponents(mSubNodePtrs.size());
+    for(size_t n=0; n<mSubNodePtrs.size(); ++n)
+    {
+        for(size_t p=0; p<mSubNodePtrs[n]->mConnectedPorts.size(); ++p)
+        {
+            nodeComponents[n].push_back(mSubNodePtrs[n]->mConnectedPorts[p]->getComponent());
+        }
+    }
+
+    ComponentPartitioner partitioner(mComponentCptrs, mComponentQptrs, nodeComponents, nThreads);
+    partitioner.partition();
+
+    // The inner vectors are cleared rather than replaced, since running threads may hold references to them
+    rSplitCVector.resize(nThreads);
+    rSplitQVector.resize(nThreads);
+    for(size_t t=0; t<nThreads; ++t)
+    {
+        rSplitCVector[t].clear();
+        rSplitQVector[t].clear();
+    }
+    for(size_t c=0; c<mComponentCptrs.size(); ++c)
+    {
+        rSplitCVector[partitioner.getThread(c)].push_back(mComponentCptrs[c]);
+    }
+    for(size_t q=0; q<mComponentQptrs.size(); ++q)
+    {
+        rSplitQVector[partitioner.getThread(mComponentCptrs.size()+q)].push_back(mComponentQptrs[q]);
+    }
+
+    addDebugMessage("Partitioned C and Q components over "+to_hstring(nThreads)+" threads, cut size: "+to_hstring(partitioner.getCutSize())+
+                    " of "+to_hstring(partitioner.getNumSharedNodes())+" shared nodes ("+HString(partitioner.getInitialAssignmentName())+" assignment: "+to_hstring(partitioner.getInitialCutSize())+
+                    ", moves: "+to_hstring(partitioner.getNumMoves())+", swaps: "+to_hstring(partitioner.getNumSwaps())+")", "partition");
+    for(size_t t=0; t<nThreads; ++t)
+    {
+        addDebugMessage("Creating C-type thread vector, measured time = " + to_hstring(partitioner.getLoad(0, t)*1000) + " ms", "cvector");
+    }
+    for(size_t t=0; t<nThreads; ++t)
+    {
+        addDebugMessage("Creating Q-type thread vector, measured time = " + to_hstring(partitioner.getLoad(1, t)*1000) + " ms", "qvector");
+    }
+
+    //Finally we sort each component vector, so that
+    //signal components are simulated in correct order:
+    for(size_t t=0; t<nThreads; ++t)
+    {
+        sortComponentVector(rSplitCVector[t]);
+        sortComponentVector(rSplitQVector[t]);
+    }
+}
+
+
+//! @brief Helper function that assigns each node to the thread whose components use it the most
+//! The node vectors are used as node data arena groups, so that the data of each node is placed together with the data of
+//! the other nodes owned by the same thread. Nodes not used by any component are distributed equally.
+//! @param rSplitNodeVector Reference to vector with vectors of node pointers (one vector per thread)
+//! @param rSplitSignalVector Vector with vectors of signal components (one vector per thread)
+//! @param rSplitCVector Vector with vectors of C components (one vector per thread)
+//! @param rSplitQVector Vector with vectors of Q components (one vector per thread)
+void ComponentSystem::assignNodeOwnership(vector< vector<Node*> > &rSplitNodeVector, const vector< vector<Component*> > &rSplitSignalVector,
+                                          const vector< vector<Component*> > &rSplitCVector, const vector< vector<Component*> > &rSplitQVector)
+{
+    const size_t nThreads = std::max(size_t(1), std::max(rSplitCVector.size(), std::max(rSplitQVector.size(), rSplitSignalVector.size())));
+    std::map<Component*, size_t> threadMap;
+    const vector< vector<Component*> > *splitVectors[] = {&rSplitSignalVector, &rSplitCVector, &rSplitQVector};
+    for(size_t s=0; s<3; ++s)
+    {
+        for(size_t t=0; t<splitVectors[s]->size(); ++t)
+        {
+            for(size_t c=0; c<(*splitVectors[s])[t].size(); ++c)
+            {
+                threadMap[(*splitVectors[s])[t][c]] = t;
+            }
+        }
+    }
+
+    rSplitNodeVector.resize(nThreads);
+    for(size_t t=0; t<nThreads; ++t)
+    {
+        rSplitNodeVector[t].clear();
+    }
+    size_t cutSize=0, crossCoreBytes=0;
+    vector<size_t> nodeUsers(nThreads);
+    for(size_t n=0; n<mSubNodePtrs.size(); ++n)
+    {
+        Node *pNode = mSubNodePtrs[n];
+        std::fill(nodeUsers.begin(), nodeUsers.end(), 0);
+        for(size_t p=0; p<pNode->mConnectedPorts.size(); ++p)
+        {
+            std::map<Component*, size_t>::iterator it = threadMap.find(pNode->mConnectedPorts[p]->getComponent());
+            if(it != threadMap.end())
+            {
+                ++nodeUsers[it->second];
+            }
+        }
+
+        size_t owner=0, nThreadsUsingNode=0;
+        for(size_t t=0; t<nThreads; ++t)
+        {
+            if(nodeUsers[t] > 0)
+            {
+                ++nThreadsUsingNode;
+            }
+            if(nodeUsers[t] > nodeUsers[owner])
+            {
+                owner = t;
+            }
+        }
+
+        if(nThreadsUsingNode == 0)
+        {
+            for(size_t t=1; t<nThreads; ++t)
+            {
+                if(rSplitNodeVector[t].size() < rSplitNodeVector[owner].size())
+                {
+                    owner = t;
+                }
+            }
+        }
+        else if(nThreadsUsingNode > 1)
+        {
+            // Each time step, the data of a cut node is written on one core and read on the others
+            ++cutSize;
+            crossCoreBytes += (nThreadsUsingNode-1)*pNode->getNumDataVariables()*sizeof(double);
+        }
+        rSplitNodeVector[owner].push_back(pNode);
+    }
+
+    for(size_t t=0; t<nThreads; ++t)
+    {
+        addDebugMessage("Thread "+to_hstring(t)+" owns "+to_hstring(rSplitNodeVector[t].size())+" nodes", "nvector");
+    }
+    addDebugMessage("Node cut size: "+to_hstring(cutSize)+" of "+to_hstring(mSubNodePtrs.size())+" nodes are used by more than one thread, "+
+                    "estimated cross-core node traffic: "+to_hstring(crossCoreBytes)+" bytes per time step", "nvector");
+}
+
+
+//! @brief Redistribute the components and nodes over the simulation threads, based on their measured times
+//! @details When called during a simulation, from the master thread while the other threads wait, the per-thread vectors
+//! are refilled in place so that references held by the simulation threads stay valid. The node data arena is not repacked
+//! since components keep pointers into it.
+//! @param nThreads Number of simulation threads
+//! @param measureTime If true, the component times are measured by simulating 10 steps first, otherwise the current measured times are used
+void ComponentSystem::reschedule(size_t nThreads, bool measureTime)
+{
+    // The partitioned vectors contain the subsystems themselves
+    mpMultiThreadPrivates->mExpandedSubsystems.clear();
+    mpMultiThreadPrivates->mExpandedSignalTasks.clear();
+
+    if(measureTime)
+    {
+        mpMultiThreadPrivates->mSplitCVector.clear();
+        mpMultiThreadPrivates->mSplitQVector.clear();
+        mpMultiThreadPrivates->mSplitSignalVector.clear();
+        mpMultiThreadPrivates->mSplitNodeVector.clear();
+
+        simulateAndMeasureTime(10);                                //Measure time
+    }
+    else
+    {
+        mpMultiThreadPrivates->mSplitSignalVector.resize(nThreads);
+        for(size_t t=0; t<nThreads; ++t)
+        {
+            mpMultiThreadPrivates->mSplitSignalVector[t].clear();
+        }
+    }
+    sortComponentVectorsByMeasuredTime();                       //Sort component vectors
+
+    partitionCQcomponents(mpMultiThreadPrivates->mSplitCVector, mpMultiThreadPrivates->mSplitQVector, nThreads);   //Distribute components and nodes
+    distributeSignalcomponents(mpMultiThreadPrivates->mSplitSignalVector, nThreads);
+    assignNodeOwnership(mpMultiThreadPrivates->mSplitNodeVector, mpMultiThreadPrivates->mSplitSignalVector,
+                        mpMultiThreadPrivates->mSplitCVector, mpMultiThreadPrivates->mSplitQVector);
+}
+
+
+//! @brief Move C and Q components from the most to the least loaded thread, based on their measured times
+//! @details Used during multi-threaded simulations instead of a full reschedule, only the components that cause the
+//! imbalance are moved. Must be called from the master thread while the other threads wait, the per-thread vectors are
+//! changed in place. Signal components are not moved, since their order between threads matters.
+//! @param maxMovesPerPhase The maximum number of components to move in each of the C and Q phases
+//! @returns The number of moved components
+size_t ComponentSystem::rebalanceThreads(const size_t maxMovesPerPhase)
+{
+    size_t numMoved = 0;
+    vector< vector<Component*> > *splitVectors[] = {&mpMultiThreadPrivates->mSplitCVector, &mpMultiThreadPrivates->mSplitQVector};
+    for(size_t p=0; p<2; ++p)
+    {
+        vector< vector<Component*> > &rSplitVector = *splitVectors[p];
+        const size_t nThreads = rSplitVector.size();
+        if(nThreads < 2)
+        {
+            continue;
+        }
+        vector<double> load(nThreads, 0.0);
+        for(size_t t=0; t<nThreads; ++t)
+        {
+            for(size_t c=0; c<rSplitVector[t].size(); ++c)
+            {
+                load[t] += rSplitVector[t][c]->getMeasuredTime();
+            }
+        }
+
+        vector<bool> changed(nThreads, false);
+        for(size_t m=0; m<maxMovesPerPhase; ++m)
+        {
+            const size_t from = size_t(std::max_element(load.begin(), load.end())-load.begin());
+            const size_t to = size_t(std::min_element(load.begin(), load.end())-load.begin());
+            const double difference = load[from]-load[to];
+
+            // Any component cheaper than the difference lowers the maximum, the one closest to half of it balances the pair best
+            size_t best = rSplitVector[from].size();
+            for(size_t c=0; c<rSplitVector[from].size(); ++c)
+            {
+                const double time = rSplitVector[from][c]->getMeasuredTime();
+                if((time > 0) && (time < difference) && ((best == rSplitVector[from].size()) ||
+                   (fabs(difference-2*time) < fabs(difference-2*rSplitVector[from][best]->getMeasuredTime()))))
+                {
+                    best = c;
+                }
+            }
+            if(best == rSplitVector[from].size())
+            {
+                break;
+            }
+
+            Component *pComponent = rSplitVector[from][best];
+            rSplitVector[from].erase(rSplitVector[from].begin()+best);
+            rSplitVector[to].push_back(pComponent);
+            load[from] -= pComponent->getMeasuredTime();
+            load[to] += pComponent->getMeasuredTime();
+            changed[from] = true;
+            changed[to] = true;
+            ++numMoved;
+        }
+
+        for(size_t t=0; t<nThreads; ++t)
+        {
+            if(changed[t])
+            {
+                sortComponentVector(rSplitVector[t]);
+            }
+        }
+    }
+
+    if(numMoved > 0)
+    {
+        assignNodeOwnership(mpMultiThreadPrivates->mSplitNodeVector, mpMultiThreadPrivates->mSplitSignalVector,
+                            mpMultiThreadPrivates->mSplitCVector, mpMultiThreadPrivates->mSplitQVector);
+    }
+    return numMoved;
+}
+
+
+//! @brief Saves the thread load statistics from a multi-threaded simulation, so that they can be retrieved afterwards
+void ComponentSystem::storeThreadLoadStatistics(const ThreadLoadProfiler &rProfiler)
+{
+    mpMultiThreadPrivates->mThreadLoadStatistics = rProfiler.getStatistics();
+    mpMultiThreadPrivates->mNumAdaptiveReschedules = rProfiler.getNumReschedules();
+    for(size_t t=0; t<mpMultiThreadPrivates->mThreadLoadStatistics.size(); ++t)
+    {
+        const ThreadLoadStatistics &rStats = mpMultiThreadPrivates->mThreadLoadStatistics[t];
+        addDebugMessage("Thread "+to_hstring(t)+" busy: "+to_hstring(rStats.busyTime)+" s, idle: "+to_hstring(rStats.idleTime)+" s", "threadload");
+    }
+    if(rProfiler.getNumReschedules() > 0)
     {
-        flag = false;
-        for (j=0; j < (mComponentQptrs.size()-1); ++j)
-        {
-            if (mComponentQptrs[j+1]->getMeasuredTime() > mComponentQptrs[j]->getMeasuredTime())
-            {
-                tempQ = mComponentQptrs[j];             //Swap elements
-                mComponentQptrs[j] = mComponentQptrs[j+1];
-                mComponentQptrs[j+1] = tempQ;
-                flag = true;               //Indicates that a swap occurred
-            }
-        }
+        addDebugMessage("Components were rescheduled "+to_hstring(rProfiler.getNumReschedules())+" times during simulation", "threadload");
+    }
+}
+
+#endif
+
+//! @brief Set the number of spin iterations a thread waits at a barrier before it is parked
+//! @details Used by the APrioriHybridBarrierScheduling and TaskStealingAlgorithm algorithms. A large budget gives the lowest synchronization
+//! latency when all threads have dedicated cores, a small budget avoids wasting CPU time when cores are oversubscribed.
+//! @param[in] spinBudget The number of spin iterations, 0 means that waiting threads are parked immediately
+void ComponentSystem::setBarrierSpinBudget(const size_t spinBudget)
+{
+    mpMultiThreadPrivates->mBarrierSpinBudget = spinBudget;
+}
+
+//! @brief Returns the number of spin iterations a thread waits at a barrier before it is parked
+size_t ComponentSystem::getBarrierSpinBudget() const
+{
+    return mpMultiThreadPrivates->mBarrierSpinBudget;
+}
+
+//! @brief Set how often the time of each component is sampled during a priori scheduled multi-threaded simulations
+//! @param[in] sampleInterval Components are timed every sampleInterval:th step, 0 disables sampling and adaptive rescheduling
+void ComponentSystem::setProfilingSampleInterval(const size_t sampleInterval)
+{
+    mpMultiThreadPrivates->mProfilingSampleInterval = sampleInterval;
+}
+
+//! @brief Returns how often the time of each component is sampled during multi-threaded simulations
+size_t ComponentSystem::getProfilingSampleInterval() const
+{
+    return mpMultiThreadPrivates->mProfilingSampleInterval;
+}
+
+//! @brief Set when the components are rescheduled during a priori scheduled multi-threaded simulations
+//! @details The load balance is checked every checkInterval:th step. The imbalance is the time spent by the slowest thread in
+//! each phase, relative to the average thread. If it exceeds the threshold, the components are redistributed using their sampled times.
+//! @param[in] threshold Relative imbalance that triggers rescheduling (0.2 means 20 %), 0 disables adaptive rescheduling
+//! @param[in] checkInterval Number of steps between each check
+void ComponentSystem::setRescheduleImbalanceThreshold(const double threshold, const size_t checkInterval)
+{
+    mpMultiThreadPrivates->mRescheduleImbalanceThreshold = threshold;
+    mpMultiThreadPrivates->mRescheduleCheckInterval = checkInterval;
+}
+
+//! @brief Returns the relative thread load imbalance that triggers rescheduling during multi-threaded simulations
+double ComponentSystem::getRescheduleImbalanceThreshold() const
+{
+    return mpMultiThreadPrivates->mRescheduleImbalanceThreshold;
+}
+
+//! @brief Returns the busy and idle time of each thread in the last a priori scheduled multi-threaded simulation
+std::vector<ThreadLoadStatistics> ComponentSystem::getThreadLoadStatistics() const
+{
+    return mpMultiThreadPrivates->mThreadLoadStatistics;
+}
+
+//! @brief Returns the number of times the components were rescheduled during the last multi-threaded simulation
+size_t ComponentSystem::getNumAdaptiveReschedules() const
+{
+    return mpMultiThreadPrivates->mNumAdaptiveReschedules;
+}
+
+//! @brief Returns the number of subsystems (at any depth) that were expanded into their components in the last task-stealing simulation
+size_t ComponentSystem::getNumExpandedSubsystems() const
+{
+    return mpMultiThreadPrivates->mExpandedSubsystems.size();
+}
+
+//! @brief Helper function that simulates all components and measure their average time requirements.
+//! @param steps How many steps to simulate
+bool ComponentSystem::simulateAndMeasureTime(const size_t nSteps)
+{
+#if (__cplusplus >= 201103L)
+    // Reset all measured times first
+    for(size_t s=0; s<mComponentSignalptrs.size(); ++s)
+        mComponentSignalptrs[s]->setMeasuredTime(0);
+    for(size_t c=0; c<mComponentCptrs.size(); ++c)
+        mComponentCptrs[c]->setMeasuredTime(0);
+    for(size_t q=0; q<mComponentQptrs.size(); ++q)
+        mComponentQptrs[q]->setMeasuredTime(0);
+
+
+        // Measure time for each component during specified amount of steps
+    double time;
+
+    for(size_t s=0; s<mComponentSignalptrs.size(); ++s)
+    {
+        time = mTime; // Init time
+#ifdef _WIN32
+        HighResClock::time_point t0 = HighResClock::now();
+#else
+        timespec t0;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+#endif
+        time += mTimestep*nSteps;
+        mComponentSignalptrs[s]->simulate(time);
+#ifdef _WIN32
+        HighResClock::time_point t1 = HighResClock::now();
+        HighResClock::duration dt = t1-t0;
+        mComponentSignalptrs[s]->setMeasuredTime(dt.count()/1000000.0);
+#else
+        timespec t1;
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        mComponentSignalptrs[s]->setMeasuredTime(elapsedMilliseconds(t0, t1));
+#endif
+    }
+
+    for(size_t c=0; c<mComponentCptrs.size(); ++c)
+    {
+        time=mTime; // Reset time
+#ifdef _WIN32
+        HighResClock::time_point t0 = HighResClock::now();
+#else
+        timespec t0;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+#endif
+        time += mTimestep*nSteps;
+        mComponentCptrs[c]->simulate(time);
+#ifdef _WIN32
+        HighResClock::time_point t1 = HighResClock::now();
+        HighResClock::duration dt = t1-t0;
+        mComponentCptrs[c]->setMeasuredTime(dt.count()/1000000.0);
+#else
+        timespec t1;
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        mComponentCptrs[c]->setMeasuredTime(elapsedMilliseconds(t0, t1));
+#endif
+    }
+
+    for(size_t q=0; q<mComponentQptrs.size(); ++q)
+    {
+        time=mTime; // Reset time
+#ifdef _WIN32
+        HighResClock::time_point t0 = HighResClock::now();
+#else
+        timespec t0;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+#endif
+        time += mTimestep*nSteps;
+        mComponentQptrs[q]->simulate(time);
+
+#ifdef _WIN32
+        HighResClock::time_point t1 = HighResClock::now();
+        HighResClock::duration dt = t1-t0;
+        mComponentQptrs[q]->setMeasuredTime(dt.count()/1000000.0);
+#else
+        timespec t1;
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        mComponentQptrs[q]->setMeasuredTime(elapsedMilliseconds(t0, t1));
+#endif
+    }
+
+    return true;
+#else
+    this->addErrorMessage("Measuring simulation time requires C++11 support.");
+    return false;
+#endif
+}
+
+
+//! @brief Returns the total sum of the measured time of the components in the system
+double ComponentSystem::getTotalMeasuredTime()
+{
+    double time = 0;
+#if (__cplusplus >= 201103L)
+    for(size_t s=0; s<mComponentSignalptrs.size(); ++s)
+    {
+        time += mComponentSignalptrs[s]->getMeasuredTime();
+    }
+    for(size_t c=0; c<mComponentCptrs.size(); ++c)
+    {
+        time += mComponentCptrs[c]->getMeasuredTime();
+    }
+    for(size_t q=0; q<mComponentQptrs.size(); ++q)
+    {
+        time += mComponentQptrs[q]->getMeasuredTime();
     }
+#else
+    this->addErrorMessage("Measuring simulation time requires C++11 support.");
+#endif
+    return time;
+}
+
+
+//! @brief Helper function that sorts C- and Q- component vectors by simulation time for each component.
+//! Components with equal time keep their relative order.
+void ComponentSystem::sortComponentVectorsByMeasuredTime()
+{
+#if (__cplusplus >= 201103L)
+    //Sort the components from longest to shortest time requirement
+    std::stable_sort(mComponentCptrs.begin(), mComponentCptrs.end(), [](const Component *pA, const Component *pB) {
+        return pA->getMeasuredTime() > pB->getMeasuredTime();
+    });
+    std::stable_sort(mComponentQptrs.begin(), mComponentQptrs.end(), [](const Component *pA, const Component *pB) {
+        return pA->getMeasuredTime() > pB->getMeasuredTime();
+    });
 #else
     this->addErrorMessage("Cannot sort! Measuring simulation time requires C++11 support.");
 #endif
@@ -3343,6 +4826,12 @@ void ComponentSystem::distributeNodePointers(vector< vector<Node*> > &/*rSplitNo
 //! @param[in] stopT Simulate from current time until stop time
 void ComponentSystem::simulate(const double stopT)
 {
+    if (mpSimulationProfiler)
+    {
+        simulateProfiled(stopT);
+        return;
+    }
+
     // Round to nearest, we may not get exactly the stop time that we want
     size_t numSimulationSteps = calcNumSimSteps(mTime, stopT); //Here mTime is the last time step since it is not updated yet
 
@@ -3381,11 +4870,219 @@ void ComponentSystem::simulate(const double stopT)
     }
 }
 
+//! @brief Write the simulation state of the system, its nodes and all sub components
+//! @details The state contains the simulation time, step and log counters, all node data owned by this system and the
+//! internal state of all sub components (recursively)
+//! @param[in] rWriter The writer to append the state to
+void ComponentSystem::saveState(StateWriter &rWriter) const
+{
+    Component::saveState(rWriter);
+    rWriter.writeSize(mTotalTakenSimulationSteps);
+    rWriter.writeSize(mLogCtr);
+
+    rWriter.writeSize(mSubNodePtrs.size());
+    for (size_t n=0; n<mSubNodePtrs.size(); ++n)
+    {
+        const NodeDataVector &rData = mSubNodePtrs[n]->mDataValues;
+        rWriter.writeSize(rData.size());
+        rWriter.writeDoubles(rData.data(), rData.size());
+    }
+
+    rWriter.writeSize(mSubComponentMap.size());
+    SubComponentMapT::const_iterator it;
+    for (it=mSubComponentMap.begin(); it!=mSubComponentMap.end(); ++it)
+    {
+        it->second->saveState(rWriter);
+    }
+}
+
+//! @brief Restore the simulation state of the system, its nodes and all sub components
+//! @param[in] rReader The reader to read the state from
+//! @returns true if successful, false if the state does not match the model structure
+bool ComponentSystem::restoreState(StateReader &rReader)
+{
+    size_t totalSteps=0, logCtr=0, numNodes=0, numComponents=0;
+    if (!Component::restoreState(rReader) || !rReader.readSize(totalSteps) || !rReader.readSize(logCtr) ||
+        !rReader.readSize(numNodes) || (numNodes != mSubNodePtrs.size()))
+    {
+        return false;
+    }
+    mTotalTakenSimulationSteps = totalSteps;
+    mLogCtr = logCtr;
+
+    for (size_t n=0; n<mSubNodePtrs.size(); ++n)
+    {
+        NodeDataVector &rData = mSubNodePtrs[n]->mDataValues;
+        size_t numValues=0;
+        if (!rReader.readSize(numValues) || (numValues != rData.size()) || !rReader.readDoubles(rData.data(), rData.size()))
+        {
+            return false;
+        }
+    }
+
+    if (!rReader.readSize(numComponents) || (numComponents != mSubComponentMap.size()))
+    {
+        return false;
+    }
+    SubComponentMapT::iterator it;
+    for (it=mSubComponentMap.begin(); it!=mSubComponentMap.end(); ++it)
+    {
+        if (!it->second->restoreState(rReader))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//! @brief Take an in-memory snapshot of the complete simulation state
+//! @details The snapshot can be restored with restoreSimulationState() to continue simulating from this point, for example
+//! to branch several simulations from a common warm-up. It can only be restored into the same, initialized, model.
+//! Logged data is not part of the snapshot, samples logged after a restore overwrite the samples logged after the snapshot was taken.
+//! @param[out] rState The buffer to store the state in, any previous contents are replaced
+void ComponentSystem::saveSimulationState(std::vector<char> &rState) const
+{
+    rState.clear();
+    StateWriter writer(rState);
+    writer.writeInt(SimulationStateFormatVersion);
+    saveState(writer);
+}
+
+//! @brief Restore the simulation state from an in-memory snapshot taken with saveSimulationState()
+//! @details When log data is streamed to a log sink, samples that have already been streamed can not be taken back.
+//! Samples produced after the restore are appended to the stream.
+//! @param[in] rState The snapshot to restore
+//! @returns true if successful, false if the snapshot does not match the model (the simulation state is then undefined)
+bool ComponentSystem::restoreSimulationState(const std::vector<char> &rState)
+{
+    StateReader reader(rState);
+    int version=0;
+    if (!reader.readInt(version) || (version != SimulationStateFormatVersion))
+    {
+        addErrorMessage("Could not restore simulation state, unsupported state format");
+        return false;
+    }
+    if (!restoreState(reader) || !reader.atEnd())
+    {
+        addErrorMessage("Could not restore simulation state, the state does not match the model structure");
+        return false;
+    }
+    if (mpLogStreamer)
+    {
+        addWarningMessage("Simulation state restored while streaming log data, already streamed samples are kept");
+    }
+    mStopSimulation = false;
+    return true;
+}
+
+//! @brief Simulate function for single-threaded simulations with profiling, same as simulate() but every component call is timed
+//! @param[in] stopT Simulate from current time until stop time
+void ComponentSystem::simulateProfiled(const double stopT)
+{
+    typedef std::chrono::steady_clock ProfileClock;
+
+    // Round to nearest, we may not get exactly the stop time that we want
+    size_t numSimulationSteps = calcNumSimSteps(mTime, stopT); //Here mTime is the last time step since it is not updated yet
+
+    //Simulate
+    for (size_t i=0; i<numSimulationSteps; ++i)
+    {
+        if (mStopSimulation) {
+            break;
+        }
+
+        const ProfileClock::time_point stepStart = ProfileClock::now();
+        mTime += mTimestep;
+
+        mpSimulationProfiler->simulateSignalComponents(mTime);
+        mpSimulationProfiler->simulateCComponents(mTime);
+        mpSimulationProfiler->simulateQComponents(mTime);
+
+        ++mTotalTakenSimulationSteps;
+
+        const ProfileClock::time_point logStart = ProfileClock::now();
+        logTimeAndNodes(mTotalTakenSimulationSteps);
+        const ProfileClock::time_point stepEnd = ProfileClock::now();
+
+        mpSimulationProfiler->addStep(std::chrono::duration<double>(stepEnd-stepStart).count(),
+                                      std::chrono::duration<double>(stepEnd-logStart).count());
+    }
+}
+
+//! @brief Enable or disable profiling of this system and all subsystems
+//! @details When enabled, the wall time and number of calls of each component is accumulated during single-threaded simulation.
+//! Enabling profiling (or initializing the system) clears the profile from any previous simulation. When disabled, simulation
+//! runs exactly as without profiling support.
+//! @param[in] enabled True to enable profiling
+void ComponentSystem::setProfilingEnabled(const bool enabled)
+{
+    if (enabled)
+    {
+        if (!mpSimulationProfiler)
+        {
+            mpSimulationProfiler = new SimulationProfiler();
+        }
+        mpSimulationProfiler->setup(mComponentSignalptrs, mComponentCptrs, mComponentQptrs);
+    }
+    else
+    {
+        delete mpSimulationProfiler;
+        mpSimulationProfiler = 0;
+    }
+
+    const std::vector<Component*> *componentVectors[] = {&mComponentSignalptrs, &mComponentCptrs, &mComponentQptrs};
+    for (size_t v=0; v<3; ++v)
+    {
+        for (size_t i=0; i<componentVectors[v]->size(); ++i)
+        {
+            if ((*componentVectors[v])[i]->isComponentSystem())
+            {
+                static_cast<ComponentSystem*>((*componentVectors[v])[i])->setProfilingEnabled(enabled);
+            }
+        }
+    }
+}
+
+//! @brief Check if profiling is enabled
+bool ComponentSystem::isProfilingEnabled() const
+{
+    return (mpSimulationProfiler != 0);
+}
+
+//! @brief Returns the profile of the last simulation, with one child entry per sub component and one for logging
+//! @details Subsystems are expanded recursively. The report is empty if profiling is not enabled.
+ProfileEntry ComponentSystem::getProfileReport() const
+{
+    if (!mpSimulationProfiler)
+    {
+        ProfileEntry empty;
+        empty.name = getName();
+        empty.typeName = getTypeName();
+        return empty;
+    }
+    return mpSimulationProfiler->getReport(getName(), getTypeName());
+}
+
+//! @brief Start simulating the (initialized) system in real time in a separate thread, until stopSimulation() is called
+//! @details Use a RealtimeRunner directly for CPU pinning, real-time priority, statistics and input/output exchange
+//! @param [in] realTimeFactor The simulated time per wall clock time
+//! @returns False if a real-time simulation is already running
 bool ComponentSystem::startRealtimeSimulation(double realTimeFactor)
 {
 #if defined(HOPSANCORE_USEMULTITHREADING)
-    std::thread rtThread(simWholeSystemInRealtime, realTimeFactor, &mStopSimulation, &mTime, mTimestep, mComponentSignalptrs, mComponentCptrs, mComponentQptrs);
-    rtThread.detach();
+    std::unique_ptr<RealtimeRunner> &rpRunner = mpMultiThreadPrivates->mpRealtimeRunner;
+    if (rpRunner && rpRunner->isRunning())
+    {
+        addErrorMessage("A real-time simulation is already running");
+        return false;
+    }
+    rpRunner.reset(new RealtimeRunner(this));
+    rpRunner->setRealTimeFactor(realTimeFactor);
+    if (!rpRunner->start(std::numeric_limits<double>::infinity()))
+    {
+        addErrorMessage(rpRunner->getLastError());
+        return false;
+    }
     return true;
 #else
     stopSimulation("Real-time simulation requires C++11 or above.");
@@ -3434,6 +5131,17 @@ void ComponentSystem::finalize()
         mComponentSignalptrs.push_back(mDisabledSptrs.at(i));
     }
     mDisabledSptrs.clear();
+
+    // Write any remaining streamed log data and close the log sink
+    if (mpLogStreamer)
+    {
+        if (!mpLogStreamer->finish())
+        {
+            addErrorMessage("Failed to write streamed log data: "+mpLogStreamer->getLastError());
+        }
+        delete mpLogStreamer;
+        mpLogStreamer = 0;
+    }
 }
 
 ////! @brief This function will set the number of log data slots for preallocation and logDt based on a skip factor to the sample time
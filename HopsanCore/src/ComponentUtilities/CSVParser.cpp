@@ -35,80 +35,687 @@
 
 #include "ComponentUtilities/CSVParser.h"
 #include <cstdlib>
+#include <algorithm>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <sys/stat.h>
+#include <sys/types.h>
 
 #ifdef _WIN32
 #include "windows.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #endif
 
+namespace {
 
-using namespace hopsan;
+//! @brief Exact powers of ten, used by the fast number conversion
+const double gExactPowersOfTen[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
 
-CSVParserNG::CSVParserNG(const char separator_char, size_t linesToSkip)
+//! @brief Convert a field to double using strtod, replacing decimal comma if needed
+bool slowStringToDouble(const char *pBegin, const char *pEnd, const bool replaceDecimalComma, double &rValue)
 {
-    mpCsvParser = new indcsvp::IndexingCSVParser();
-    mpCsvParser->setSeparatorChar(separator_char);
-    mpCsvParser->setNumLinesToSkip(linesToSkip);
+    std::string field(pBegin, pEnd);
+    if (replaceDecimalComma) {
+        std::replace(field.begin(), field.end(), ',', '.');
+    }
+    const char *pStart = field.c_str();
+    char *pStop;
+    rValue = strtod(pStart, &pStop);
+    while ((*pStop == ' ') || (*pStop == '\t')) {
+        ++pStop;
+    }
+    return (pStop != pStart) && (*pStop == '\0');
 }
 
-CSVParserNG::~CSVParserNG()
+//! @brief Convert a field to double
+//! @details Decimal numbers with at most 15 significant digits and a small exponent are converted exactly with one
+//! multiplication or division (the result is correctly rounded), other numbers fall back to strtod
+bool stringToDouble(const char *pBegin, const char *pEnd, const bool replaceDecimalComma, double &rValue)
 {
-    mpCsvParser->closeFile();
-    delete mpCsvParser;
+    const char *p = pBegin;
+    while ((p < pEnd) && ((*p == ' ') || (*p == '\t'))) {
+        ++p;
+    }
+    bool negative = false;
+    if ((p < pEnd) && ((*p == '-') || (*p == '+'))) {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    unsigned long long mantissa = 0;
+    int numDigits = 0;
+    int exponent = 0;
+    bool haveDigits = false;
+    while ((p < pEnd) && (*p >= '0') && (*p <= '9')) {
+        if ((numDigits > 0) || (*p != '0')) {
+            mantissa = mantissa*10 + (*p - '0');
+            ++numDigits;
+        }
+        haveDigits = true;
+        ++p;
+    }
+    if ((p < pEnd) && ((*p == '.') || (replaceDecimalComma && (*p == ',')))) {
+        ++p;
+        while ((p < pEnd) && (*p >= '0') && (*p <= '9')) {
+            if ((numDigits > 0) || (*p != '0')) {
+                mantissa = mantissa*10 + (*p - '0');
+                ++numDigits;
+            }
+            --exponent;
+            haveDigits = true;
+            ++p;
+        }
+    }
+    if (haveDigits && (p < pEnd) && ((*p == 'e') || (*p == 'E'))) {
+        ++p;
+        bool negativeExp = false;
+        if ((p < pEnd) && ((*p == '-') || (*p == '+'))) {
+            negativeExp = (*p == '-');
+            ++p;
+        }
+        int exp = 0;
+        bool haveExpDigits = false;
+        while ((p < pEnd) && (*p >= '0') && (*p <= '9')) {
+            if (exp < 10000) {
+                exp = exp*10 + (*p - '0');
+            }
+            haveExpDigits = true;
+            ++p;
+        }
+        if (!haveExpDigits) {
+            return false;
+        }
+        exponent += negativeExp ? -exp : exp;
+    }
+    while ((p < pEnd) && ((*p == ' ') || (*p == '\t'))) {
+        ++p;
+    }
+
+    if (!haveDigits || (p != pEnd) || (numDigits > 15) || (exponent < -22) || (exponent > 22)) {
+        // Not a plain decimal number (or not exactly convertible), let strtod decide
+        return slowStringToDouble(pBegin, pEnd, replaceDecimalComma, rValue);
+    }
+
+    double value = double(mantissa);
+    if (exponent < 0) {
+        value /= gExactPowersOfTen[-exponent];
+    }
+    else {
+        value *= gExactPowersOfTen[exponent];
+    }
+    rValue = negative ? -value : value;
+    return true;
 }
 
-bool CSVParserNG::openText(HString text)
+//! @brief Convert a field to long int using strtol
+bool stringToLong(const char *pBegin, const char *pEnd, long int &rValue)
 {
-#if defined(_WIN32)
-    char tmpfilebuff[L_tmpnam];
-    errno_t rc = tmpnam_s(tmpfilebuff, L_tmpnam);
-    if (rc != 0) {
-        mErrorString = "Could not create temporary file name";
-        return false;
+    std::string field(pBegin, pEnd);
+    const char *pStart = field.c_str();
+    char *pStop;
+    rValue = strtol(pStart, &pStop, 10);
+    while ((*pStop == ' ') || (*pStop == '\t')) {
+        ++pStop;
     }
+    return (pStop != pStart) && (*pStop == '\0');
+}
+
+//! @brief The largest amount of memory used by the cache of indexed files and parsed columns
+const size_t gMaxCachedBytes = size_t(256) << 20;
 
-    HString tmpfilename;
-    // tmpnam_s should give an absolute path C:\something, if second char is not :
-    // then assume its a relative path (this happens with MinGW-w64 4.9.4)
-    if (tmpfilebuff[1] != ':') {
-        char tempdirbuff[MAX_PATH+1];
-        GetTempPathA(MAX_PATH+1, tempdirbuff);
-        tmpfilename = HString(tempdirbuff)+tmpfilebuff;
+//! @brief The index of a CSV text, the start of each data row and its number of columns
+//! @details For files, the index and fully parsed columns are shared through the cache
+class CSVIndexData
+{
+public:
+    std::vector<size_t> mRowStarts;
+    std::vector<unsigned int> mRowNumCols;
+
+    bool getCachedColumn(const size_t columnIdx, const size_t startRow, const size_t numRows, std::vector<double> &rColumn)
+    {
+        std::lock_guard<std::mutex> lock(mColumnMutex);
+        std::map<size_t, std::vector<double> >::const_iterator it = mParsedColumns.find(columnIdx);
+        if (it == mParsedColumns.end()) {
+            return false;
+        }
+        rColumn.assign(it->second.begin()+startRow, it->second.begin()+startRow+numRows);
+        return true;
     }
-    else {
-        tmpfilename = HString(tmpfilebuff);
+
+    //! @brief Cache a parsed column, unless the index and its cached columns would then use more than the cache limit
+    void cacheColumn(const size_t columnIdx, const std::vector<double> &rColumn)
+    {
+        std::lock_guard<std::mutex> lock(mColumnMutex);
+        const size_t numColumnBytes = rColumn.size()*sizeof(double);
+        if ((mParsedColumns.count(columnIdx) == 0) && (getIndexBytes()+mNumColumnBytes+numColumnBytes <= gMaxCachedBytes)) {
+            mParsedColumns[columnIdx] = rColumn;
+            mNumColumnBytes += numColumnBytes;
+        }
     }
 
-    FILE* pTempfile = fopen(tmpfilename.c_str(), "w+b");
+    //! @brief The memory used by the index and the cached columns, in bytes
+    size_t getNumBytes()
+    {
+        std::lock_guard<std::mutex> lock(mColumnMutex);
+        return getIndexBytes()+mNumColumnBytes;
+    }
+
+private:
+    size_t getIndexBytes() const
+    {
+        return mRowStarts.capacity()*sizeof(size_t) + mRowNumCols.capacity()*sizeof(unsigned int);
+    }
+
+    std::mutex mColumnMutex;
+    std::map<size_t, std::vector<double> > mParsedColumns;
+    size_t mNumColumnBytes = 0;
+};
+
+//! @brief Identifies an indexed file, the index is only valid for the same file contents and parser settings
+//! @details The modification time has the best resolution the platform provides (nanoseconds on Linux and macOS, 100 ns on
+//! Windows). The file id (inode or file index) detects files that are replaced by another file with the same time and size.
+struct CSVIndexKey
+{
+    std::string mPath;
+    long long mModificationTime;
+    unsigned long long mFileId;
+    size_t mFileSize;
+    char mSeparatorChar;
+    char mCommentChar;
+    size_t mNumLinesToSkip;
+
+    bool operator==(const CSVIndexKey &rOther) const
+    {
+        return (mPath == rOther.mPath) && (mModificationTime == rOther.mModificationTime) && (mFileId == rOther.mFileId) &&
+               (mFileSize == rOther.mFileSize) && (mSeparatorChar == rOther.mSeparatorChar) && (mCommentChar == rOther.mCommentChar) &&
+               (mNumLinesToSkip == rOther.mNumLinesToSkip);
+    }
+};
+
+//! @brief Process wide cache of indexed files and their parsed columns
+class CSVIndexCache
+{
+public:
+    static CSVIndexCache &instance()
+    {
+        static CSVIndexCache cache;
+        return cache;
+    }
+
+    std::shared_ptr<CSVIndexData> find(const CSVIndexKey &rKey)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (std::list<Entry>::iterator it=mEntries.begin(); it!=mEntries.end(); ++it) {
+            if (it->first == rKey) {
+                // Move to front, the least recently used entry is last
+                mEntries.splice(mEntries.begin(), mEntries, it);
+                return mEntries.front().second;
+            }
+        }
+        return std::shared_ptr<CSVIndexData>();
+    }
+
+    void insert(const CSVIndexKey &rKey, std::shared_ptr<CSVIndexData> pData)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        // An older index of the same file is no longer valid
+        for (std::list<Entry>::iterator it=mEntries.begin(); it!=mEntries.end();) {
+            if (it->first.mPath == rKey.mPath) {
+                it = mEntries.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+        mEntries.push_front(Entry(rKey, pData));
+        while (mEntries.size() > maxNumEntries) {
+            mEntries.pop_back();
+        }
+        trimLocked();
+    }
+
+    //! @brief Remove the least recently used entries until the cache uses at most gMaxCachedBytes, the most recent entry is kept
+    void trim()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        trimLocked();
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mEntries.clear();
+    }
+
+private:
+    void trimLocked()
+    {
+        size_t numBytes = 0;
+        for (std::list<Entry>::iterator it=mEntries.begin(); it!=mEntries.end();) {
+            numBytes += it->second->getNumBytes();
+            if ((numBytes > gMaxCachedBytes) && (it != mEntries.begin())) {
+                it = mEntries.erase(it, mEntries.end());
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+    typedef std::pair<CSVIndexKey, std::shared_ptr<CSVIndexData> > Entry;
+    static const size_t maxNumEntries = 16;
+    std::mutex mMutex;
+    std::list<Entry> mEntries;
+};
+
+//! @brief Rows per thread, below this a column is parsed in the calling thread
+const size_t gMinRowsPerParseThread = 100000;
+
+}
+
+namespace hopsan {
+
+//! @brief CSV parser that indexes and parses directly over a memory buffer, a copy of a text or a memory mapped file
+class CSVMemoryParser
+{
+public:
+    CSVMemoryParser(const char separatorChar, const size_t linesToSkip) :
+        mpData(0), mSize(0), mModificationTime(0), mFileId(0), mSeparatorChar(separatorChar), mCommentChar('\0'), mNumLinesToSkip(linesToSkip)
+    {
+#ifdef _WIN32
+        mFileHandle = INVALID_HANDLE_VALUE;
+        mMappingHandle = NULL;
+#endif
+    }
+
+    ~CSVMemoryParser()
+    {
+        close();
+    }
+
+    bool openText(const HString &rText)
+    {
+        close();
+        mText.assign(rText.c_str(), rText.size());
+        mpData = mText.data();
+        mSize = mText.size();
+        return true;
+    }
+
+    bool openFile(const HString &rFilepath, HString &rErrorString)
+    {
+        close();
+        struct stat fileStat;
+        if (stat(rFilepath.c_str(), &fileStat) != 0) {
+            rErrorString = "Could not open file: "+rFilepath;
+            return false;
+        }
+        mPath = rFilepath.c_str();
+#if defined(__APPLE__)
+        mModificationTime = (long long)fileStat.st_mtimespec.tv_sec*1000000000LL + fileStat.st_mtimespec.tv_nsec;
+#elif defined(_WIN32)
+        mModificationTime = (long long)fileStat.st_mtime;
 #else
-    char tmpfilebuff[18] = "hopsan-csv-XXXXXX";
-    int fd = mkstemp(tmpfilebuff);
-    HString tmpfilename(tmpfilebuff);
-    if (fd == -1) {
-        mErrorString = "Could not create temporary file";
-        return false;
+        mModificationTime = (long long)fileStat.st_mtim.tv_sec*1000000000LL + fileStat.st_mtim.tv_nsec;
+#endif
+        mFileId = (unsigned long long)fileStat.st_ino;
+        mSize = size_t(fileStat.st_size);
+        if (mSize == 0) {
+            return true;
+        }
+
+#ifdef _WIN32
+        mFileHandle = CreateFileA(rFilepath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (mFileHandle != INVALID_HANDLE_VALUE) {
+            // stat() only gives seconds and no file id on Windows
+            BY_HANDLE_FILE_INFORMATION fileInfo;
+            if (GetFileInformationByHandle(mFileHandle, &fileInfo)) {
+                mModificationTime = (long long)(((unsigned long long)fileInfo.ftLastWriteTime.dwHighDateTime << 32) | fileInfo.ftLastWriteTime.dwLowDateTime);
+                mFileId = ((unsigned long long)fileInfo.nFileIndexHigh << 32) | fileInfo.nFileIndexLow;
+            }
+            mMappingHandle = CreateFileMappingA(mFileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (mMappingHandle != NULL) {
+                mpData = static_cast<const char*>(MapViewOfFile(mMappingHandle, FILE_MAP_READ, 0, 0, 0));
+            }
+        }
+#else
+        int fd = open(rFilepath.c_str(), O_RDONLY);
+        if (fd != -1) {
+            void *pMapped = mmap(0, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (pMapped != MAP_FAILED) {
+                mpData = static_cast<const char*>(pMapped);
+                madvise(pMapped, mSize, MADV_SEQUENTIAL);
+            }
+            // The mapping remains valid after the file is closed
+            ::close(fd);
+        }
+#endif
+        if (mpData == 0) {
+            rErrorString = "Could not memory map file: "+rFilepath;
+            close();
+            return false;
+        }
+        return true;
     }
-    FILE* pTempfile = fdopen(fd, "r+b");
-    // Unlink the file, but it will remain until the file is closed (and then be automatically removed)
-    remove(tmpfilebuff);
+
+    void close()
+    {
+#ifdef _WIN32
+        if (mpData && mPath.size()) {
+            UnmapViewOfFile(mpData);
+        }
+        if (mMappingHandle != NULL) {
+            CloseHandle(mMappingHandle);
+            mMappingHandle = NULL;
+        }
+        if (mFileHandle != INVALID_HANDLE_VALUE) {
+            CloseHandle(mFileHandle);
+            mFileHandle = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (mpData && mPath.size()) {
+            munmap(const_cast<char*>(mpData), mSize);
+        }
 #endif
+        mpData = 0;
+        mSize = 0;
+        mText.clear();
+        mPath.clear();
+        mModificationTime = 0;
+        mFileId = 0;
+        mpIndex.reset();
+    }
 
-    if (pTempfile == 0) {
-        mErrorString = HString("Could not open temporary file: ")+tmpfilename+" for writing";
-        return false;
+    void setSeparatorChar(const char sep) {mSeparatorChar = sep;}
+    void setCommentChar(const char commentChar) {mCommentChar = commentChar;}
+    void setNumLinesToSkip(const size_t linesToSkip) {mNumLinesToSkip = linesToSkip;}
+
+    char autoSetSeparatorChar(const std::vector<char> &rAlternatives)
+    {
+        // Use the first alternative found on the first data line
+        const size_t start = skipToData();
+        for (size_t i=start; (i<mSize) && (mpData[i] != '\n') && (mpData[i] != '\r'); ++i) {
+            if (std::find(rAlternatives.begin(), rAlternatives.end(), mpData[i]) != rAlternatives.end()) {
+                mSeparatorChar = mpData[i];
+                break;
+            }
+        }
+        return mSeparatorChar;
+    }
+
+    void indexFile()
+    {
+        CSVIndexKey key;
+        if (!mPath.empty()) {
+            key.mPath = mPath;
+            key.mModificationTime = mModificationTime;
+            key.mFileId = mFileId;
+            key.mFileSize = mSize;
+            key.mSeparatorChar = mSeparatorChar;
+            key.mCommentChar = mCommentChar;
+            key.mNumLinesToSkip = mNumLinesToSkip;
+            mpIndex = CSVIndexCache::instance().find(key);
+            if (mpIndex) {
+                return;
+            }
+        }
+
+        mpIndex = std::make_shared<CSVIndexData>();
+        size_t i = skipToData();
+        while (i < mSize) {
+            const size_t rowStart = i;
+            unsigned int numCols = 1;
+            while ((i < mSize) && (mpData[i] != '\n') && (mpData[i] != '\r')) {
+                if (mpData[i] == mSeparatorChar) {
+                    ++numCols;
+                }
+                ++i;
+            }
+            // Empty lines are not data rows
+            if (i > rowStart) {
+                mpIndex->mRowStarts.push_back(rowStart);
+                mpIndex->mRowNumCols.push_back(numCols);
+            }
+            i = skipLineEnd(i);
+        }
+
+        if (!mPath.empty()) {
+            CSVIndexCache::instance().insert(key, mpIndex);
+        }
+    }
+
+    size_t numRows() const
+    {
+        return mpIndex ? mpIndex->mRowStarts.size() : 0;
+    }
+
+    size_t numCols(const size_t row) const
+    {
+        return (row < numRows()) ? mpIndex->mRowNumCols[row] : 0;
+    }
+
+    void minMaxNumCols(size_t &rMin, size_t &rMax) const
+    {
+        rMin = 0;
+        rMax = 0;
+        if (numRows() > 0) {
+            std::vector<unsigned int>::const_iterator minmax[2];
+            minmax[0] = std::min_element(mpIndex->mRowNumCols.begin(), mpIndex->mRowNumCols.end());
+            minmax[1] = std::max_element(mpIndex->mRowNumCols.begin(), mpIndex->mRowNumCols.end());
+            rMin = *minmax[0];
+            rMax = *minmax[1];
+        }
+    }
+
+    bool allRowsHaveSameNumCols() const
+    {
+        size_t minCols, maxCols;
+        minMaxNumCols(minCols, maxCols);
+        return (minCols == maxCols);
+    }
+
+    bool getRow(const size_t row, std::vector<double> &rRow) const
+    {
+        rRow.resize(numCols(row));
+        const char *pEnd = mpData + findLineEnd(mpIndex->mRowStarts[row]);
+        const char *pField = mpData + mpIndex->mRowStarts[row];
+        for (size_t c=0; c<rRow.size(); ++c) {
+            const char *pFieldEnd = std::find(pField, pEnd, mSeparatorChar);
+            if (!stringToDouble(pField, pFieldEnd, replaceDecimalComma(), rRow[c])) {
+                return false;
+            }
+            pField = pFieldEnd+1;
+        }
+        return true;
     }
-    fwrite(text.c_str(), sizeof(char), text.size(), pTempfile);
-    rewind(pTempfile);
 
-    return takeOwnershipOfFile(pTempfile);
+    bool getRow(const size_t row, std::vector<long int> &rRow) const
+    {
+        rRow.resize(numCols(row));
+        const char *pEnd = mpData + findLineEnd(mpIndex->mRowStarts[row]);
+        const char *pField = mpData + mpIndex->mRowStarts[row];
+        for (size_t c=0; c<rRow.size(); ++c) {
+            const char *pFieldEnd = std::find(pField, pEnd, mSeparatorChar);
+            if (!stringToLong(pField, pFieldEnd, rRow[c])) {
+                return false;
+            }
+            pField = pFieldEnd+1;
+        }
+        return true;
+    }
+
+    bool getColumnRowRange(const size_t columnIdx, const size_t startRow, const size_t numRows, std::vector<double> &rColumn)
+    {
+        if ((startRow > this->numRows()) || (numRows > this->numRows()-startRow)) {
+            return false;
+        }
+        if (!mPath.empty() && mpIndex->getCachedColumn(columnIdx, startRow, numRows, rColumn)) {
+            return true;
+        }
+
+        // Whole columns of files are cached, partial ranges are parsed on every call
+        const bool wholeColumn = !mPath.empty() && (startRow == 0) && (numRows == this->numRows());
+        rColumn.resize(numRows);
+
+        size_t numThreads = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), numRows/gMinRowsPerParseThread);
+        bool isOK = true;
+        if (numThreads <= 1) {
+            isOK = parseColumnChunk(columnIdx, startRow, numRows, rColumn.data());
+        }
+        else {
+            const size_t chunkSize = numRows/numThreads;
+            std::vector<std::thread> threads;
+            std::vector<char> chunkOK(numThreads, 0);
+            for (size_t t=0; t<numThreads; ++t) {
+                const size_t chunkStart = t*chunkSize;
+                const size_t chunkRows = (t == numThreads-1) ? numRows-chunkStart : chunkSize;
+                threads.push_back(std::thread([this, &chunkOK, &rColumn, t, columnIdx, startRow, chunkStart, chunkRows](){
+                    chunkOK[t] = parseColumnChunk(columnIdx, startRow+chunkStart, chunkRows, rColumn.data()+chunkStart);
+                }));
+            }
+            for (size_t t=0; t<numThreads; ++t) {
+                threads[t].join();
+                isOK = isOK && chunkOK[t];
+            }
+        }
+
+        if (isOK && wholeColumn) {
+            mpIndex->cacheColumn(columnIdx, rColumn);
+            CSVIndexCache::instance().trim();
+        }
+        return isOK;
+    }
+
+private:
+    bool replaceDecimalComma() const
+    {
+        return (mSeparatorChar != ',');
+    }
+
+    size_t skipLineEnd(size_t i) const
+    {
+        if ((i < mSize) && (mpData[i] == '\r')) {
+            ++i;
+        }
+        if ((i < mSize) && (mpData[i] == '\n')) {
+            ++i;
+        }
+        return i;
+    }
+
+    size_t findLineEnd(size_t i) const
+    {
+        while ((i < mSize) && (mpData[i] != '\n') && (mpData[i] != '\r')) {
+            ++i;
+        }
+        return i;
+    }
+
+    //! @brief Skip the lines to skip and then lines starting with the comment character
+    size_t skipToData() const
+    {
+        size_t i=0;
+        for (size_t l=0; (l<mNumLinesToSkip) && (i<mSize); ++l) {
+            i = skipLineEnd(findLineEnd(i));
+        }
+        while ((mCommentChar != '\0') && (i < mSize) && (mpData[i] == mCommentChar)) {
+            i = skipLineEnd(findLineEnd(i));
+        }
+        return i;
+    }
+
+    bool parseColumnChunk(const size_t columnIdx, const size_t startRow, const size_t numRows, double *pValues) const
+    {
+        const bool replaceComma = replaceDecimalComma();
+        for (size_t r=0; r<numRows; ++r) {
+            const size_t row = startRow+r;
+            if (columnIdx >= mpIndex->mRowNumCols[row]) {
+                return false;
+            }
+            const char *pEnd = mpData + findLineEnd(mpIndex->mRowStarts[row]);
+            const char *pField = mpData + mpIndex->mRowStarts[row];
+            for (size_t c=0; c<columnIdx; ++c) {
+                pField = std::find(pField, pEnd, mSeparatorChar)+1;
+            }
+            const char *pFieldEnd = std::find(pField, pEnd, mSeparatorChar);
+            if (!stringToDouble(pField, pFieldEnd, replaceComma, pValues[r])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const char *mpData;
+    size_t mSize;
+    std::string mText;
+    std::string mPath;
+    long long mModificationTime;
+    unsigned long long mFileId;
+#ifdef _WIN32
+    HANDLE mFileHandle;
+    HANDLE mMappingHandle;
+#endif
+    char mSeparatorChar;
+    char mCommentChar;
+    size_t mNumLinesToSkip;
+    std::shared_ptr<CSVIndexData> mpIndex;
+};
+
+}
+
+
+using namespace hopsan;
+
+CSVParserNG::CSVParserNG(const char separator_char, size_t linesToSkip)
+{
+    mpCsvParser = new indcsvp::IndexingCSVParser();
+    mpCsvParser->setSeparatorChar(separator_char);
+    mpCsvParser->setNumLinesToSkip(linesToSkip);
+    mpMemoryParser = new CSVMemoryParser(separator_char, linesToSkip);
+    mUseMemoryParser = false;
+}
+
+CSVParserNG::~CSVParserNG()
+{
+    mpCsvParser->closeFile();
+    delete mpCsvParser;
+    delete mpMemoryParser;
+}
+
+bool CSVParserNG::openText(HString text)
+{
+    // Index directly over a copy of the text
+    mpCsvParser->closeFile();
+    mUseMemoryParser = mpMemoryParser->openText(text);
+    return mUseMemoryParser;
 }
 
 bool CSVParserNG::openFile(const HString &rFilepath)
 {
-    return mpCsvParser->openFile(rFilepath.c_str());
+    mpCsvParser->closeFile();
+    mUseMemoryParser = mpMemoryParser->openFile(rFilepath, mErrorString);
+    if (!mUseMemoryParser) {
+        // Fall back to reading through stdio if the file could not be memory mapped
+        if (!mpCsvParser->openFile(rFilepath.c_str())) {
+            return false;
+        }
+        mErrorString.clear();
+    }
+    return true;
 }
 
 bool CSVParserNG::takeOwnershipOfFile(FILE* pFile)
 {
+    mpMemoryParser->close();
+    mUseMemoryParser = false;
     mpCsvParser->takeOwnershipOfFile(pFile);
     return true;
 }
@@ -116,51 +723,78 @@ bool CSVParserNG::takeOwnershipOfFile(FILE* pFile)
 void CSVParserNG::closeFile()
 {
     mpCsvParser->closeFile();
+    mpMemoryParser->close();
+    mUseMemoryParser = false;
 }
 
 void CSVParserNG::setCommentChar(char commentChar)
 {
     mpCsvParser->setCommentChar(commentChar);
+    mpMemoryParser->setCommentChar(commentChar);
 }
 
 void CSVParserNG::setLinesToSkip(size_t linesToSkip)
 {
     mpCsvParser->setNumLinesToSkip(linesToSkip);
+    mpMemoryParser->setNumLinesToSkip(linesToSkip);
 }
 
 void CSVParserNG::setFieldSeparator(const char sep)
 {
     mpCsvParser->setSeparatorChar(sep);
+    mpMemoryParser->setSeparatorChar(sep);
 }
 
 char CSVParserNG::autoSetFieldSeparator(std::vector<char> &rAlternatives)
 {
-    return mpCsvParser->autoSetSeparatorChar(rAlternatives);
+    if (mUseMemoryParser)
+    {
+        const char sep = mpMemoryParser->autoSetSeparatorChar(rAlternatives);
+        mpCsvParser->setSeparatorChar(sep);
+        return sep;
+    }
+    const char sep = mpCsvParser->autoSetSeparatorChar(rAlternatives);
+    mpMemoryParser->setSeparatorChar(sep);
+    return sep;
 }
 
 void CSVParserNG::indexFile()
 {
-    mpCsvParser->indexFile();
+    if (mUseMemoryParser)
+    {
+        mpMemoryParser->indexFile();
+    }
+    else
+    {
+        mpCsvParser->indexFile();
+    }
 }
 
 size_t CSVParserNG::getNumDataRows() const
 {
-    return mpCsvParser->numRows();
+    return mUseMemoryParser ? mpMemoryParser->numRows() : mpCsvParser->numRows();
 }
 
 size_t CSVParserNG::getNumDataCols(const size_t row) const
 {
-    return mpCsvParser->numCols(row);
+    return mUseMemoryParser ? mpMemoryParser->numCols(row) : mpCsvParser->numCols(row);
 }
 
 bool CSVParserNG::allRowsHaveSameNumCols() const
 {
-    return mpCsvParser->allRowsHaveSameNumCols();
+    return mUseMemoryParser ? mpMemoryParser->allRowsHaveSameNumCols() : mpCsvParser->allRowsHaveSameNumCols();
 }
 
 void CSVParserNG::getMinMaxNumCols(size_t &rMin, size_t &rMax) const
 {
-    return mpCsvParser->minMaxNumCols(rMin, rMax);
+    if (mUseMemoryParser)
+    {
+        mpMemoryParser->minMaxNumCols(rMin, rMax);
+    }
+    else
+    {
+        mpCsvParser->minMaxNumCols(rMin, rMax);
+    }
 }
 
 HString CSVParserNG::getErrorString() const
@@ -168,10 +802,20 @@ HString CSVParserNG::getErrorString() const
     return mErrorString;
 }
 
+//! @brief Clear the process wide cache of indexed files and parsed columns
+void CSVParserNG::clearCache()
+{
+    CSVIndexCache::instance().clear();
+}
+
 bool CSVParserNG::copyRow(const size_t rowIdx, std::vector<double> &rRow)
 {
-    if (rowIdx < mpCsvParser->numRows())
+    if (rowIdx < getNumDataRows())
     {
+        if (mUseMemoryParser)
+        {
+            return mpMemoryParser->getRow(rowIdx, rRow);
+        }
         return mpCsvParser->getIndexedRowAs<double>(rowIdx, rRow);
         //! @todo convert decimal separator
     }
@@ -184,8 +828,12 @@ bool CSVParserNG::copyRow(const size_t rowIdx, std::vector<double> &rRow)
 
 bool CSVParserNG::copyRow(const size_t rowIdx, std::vector<long int> &rRow)
 {
-    if (rowIdx < mpCsvParser->numRows())
+    if (rowIdx < getNumDataRows())
     {
+        if (mUseMemoryParser)
+        {
+            return mpMemoryParser->getRow(rowIdx, rRow);
+        }
         return mpCsvParser->getIndexedRowAs<long int>(rowIdx, rRow);
     }
     else
@@ -197,9 +845,9 @@ bool CSVParserNG::copyRow(const size_t rowIdx, std::vector<long int> &rRow)
 
 bool CSVParserNG::copyColumn(const size_t columnIdx, std::vector<double> &rColumn)
 {
-    if (mpCsvParser->numRows() > 0)
+    if (getNumDataRows() > 0)
     {
-        return copyRangeFromColumn(columnIdx, 0, mpCsvParser->numRows(), rColumn);
+        return copyRangeFromColumn(columnIdx, 0, getNumDataRows(), rColumn);
     }
     else
     {
@@ -213,8 +861,12 @@ bool CSVParserNG::copyRangeFromColumn(const size_t columnIdx, const size_t start
     rColumn.clear();
 
     //! @todo assumes that all rows have same num cols
-    if (columnIdx < mpCsvParser->numCols(startRow))
+    if (columnIdx < getNumDataCols(startRow))
     {
+        if (mUseMemoryParser)
+        {
+            return mpMemoryParser->getColumnRowRange(columnIdx, startRow, numRows, rColumn);
+        }
         return mpCsvParser->getIndexedColumnRowRangeAs<double>(columnIdx, startRow, numRows, rColumn);
     }
     else
@@ -226,14 +878,15 @@ bool CSVParserNG::copyRangeFromColumn(const size_t columnIdx, const size_t start
 
 bool CSVParserNG::copyEveryNthFromColumn(const size_t columnIdx, const size_t stepSize, std::vector<double> &rColumn)
 {
-    return copyEveryNthFromColumnRange(columnIdx, 0, mpCsvParser->numRows(), stepSize, rColumn);
+    return copyEveryNthFromColumnRange(columnIdx, 0, getNumDataRows(), stepSize, rColumn);
 }
 
 bool CSVParserNG::copyEveryNthFromColumnRange(const size_t columnIdx, const size_t startRow, const size_t numRows, const size_t stepSize, std::vector<double> &rColumn)
 {
     rColumn.clear();
     std::vector<double> wholeColRange;
-    bool rc = mpCsvParser->getIndexedColumnRowRangeAs<double>(columnIdx, startRow, numRows, wholeColRange);
+    bool rc = mUseMemoryParser ? mpMemoryParser->getColumnRowRange(columnIdx, startRow, numRows, wholeColRange) :
+                                 mpCsvParser->getIndexedColumnRowRangeAs<double>(columnIdx, startRow, numRows, wholeColRange);
     if (rc)
     {
         rColumn.reserve(numRows/stepSize);
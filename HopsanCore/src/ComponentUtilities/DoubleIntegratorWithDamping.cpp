@@ -104,3 +104,24 @@ double DoubleIntegratorWithDamping::valueSecond()
 {
     return mDelayY;
 }
+
+
+//! @brief Write the integrator state to a state buffer
+void DoubleIntegratorWithDamping::saveState(StateWriter &rWriter) const
+{
+    rWriter.writeDouble(mDelayU);
+    rWriter.writeDouble(mDelayY);
+    rWriter.writeDouble(mDelaySY);
+    rWriter.writeDouble(mDelayUbackup);
+    rWriter.writeDouble(mDelayYbackup);
+    rWriter.writeDouble(mDelaySYbackup);
+    rWriter.writeDouble(mW0);
+}
+
+//! @brief Restore the integrator state from a state buffer
+bool DoubleIntegratorWithDamping::restoreState(StateReader &rReader)
+{
+    return rReader.readDouble(mDelayU) && rReader.readDouble(mDelayY) && rReader.readDouble(mDelaySY) &&
+           rReader.readDouble(mDelayUbackup) && rReader.readDouble(mDelayYbackup) && rReader.readDouble(mDelaySYbackup) &&
+           rReader.readDouble(mW0);
+}
@@ -171,3 +171,28 @@ double DoubleIntegratorWithDampingAndCoulombFriction::valueSecond()
 {
     return mDelayY;
 }
+
+
+//! @brief Write the integrator state to a state buffer
+void DoubleIntegratorWithDampingAndCoulombFriction::saveState(StateWriter &rWriter) const
+{
+    rWriter.writeDouble(mDelayU);
+    rWriter.writeDouble(mDelayY);
+    rWriter.writeDouble(mDelaySY);
+    rWriter.writeDouble(mDelayUbackup);
+    rWriter.writeDouble(mDelayYbackup);
+    rWriter.writeDouble(mDelaySYbackup);
+    rWriter.writeDouble(mW0);
+    rWriter.writeDouble(mUs);
+    rWriter.writeDouble(mUk);
+    rWriter.writeInt(movement);
+}
+
+//! @brief Restore the integrator state from a state buffer
+bool DoubleIntegratorWithDampingAndCoulombFriction::restoreState(StateReader &rReader)
+{
+    return rReader.readDouble(mDelayU) && rReader.readDouble(mDelayY) && rReader.readDouble(mDelaySY) &&
+           rReader.readDouble(mDelayUbackup) && rReader.readDouble(mDelayYbackup) && rReader.readDouble(mDelaySYbackup) &&
+           rReader.readDouble(mW0) && rReader.readDouble(mUs) && rReader.readDouble(mUk) &&
+           rReader.readInt(movement);
+}
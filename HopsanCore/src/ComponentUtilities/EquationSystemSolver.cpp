@@ -62,6 +62,189 @@ using namespace hopsan;
 //! \f$U*b = y\f$ and \f$L*y = x\f$
 //!
 
+namespace {
+
+// Fully unrolling the fixed-size loops is what makes the fixed-size solver fast, compilers do not do it by default for N > 3
+#if defined(__clang__)
+#define HOPSAN_UNROLL_LOOP _Pragma("unroll")
+#elif defined(__GNUC__) && (__GNUC__ >= 8)
+#define HOPSAN_UNROLL_LOOP _Pragma("GCC unroll 8")
+#else
+#define HOPSAN_UNROLL_LOOP
+#endif
+
+//! @brief Find pivot element in column jcol of a row-major NxN matrix and swap rows, same algorithm as hopsan::pivot
+template<int N>
+inline bool fixedSizePivot(double *a, int *order, const int jcol)
+{
+    int ipvt = jcol;
+    double big = fabs(a[ipvt*N+ipvt]);
+    HOPSAN_UNROLL_LOOP
+    for (int i=ipvt+1; i<N; ++i)
+    {
+        const double anext = fabs(a[i*N+jcol]);
+        if (anext > big)
+        {
+            big = anext;
+            ipvt = i;
+        }
+    }
+
+    if (!(fabs(big) > 0))
+    {
+        return false;
+    }
+
+    if (ipvt != jcol)
+    {
+        HOPSAN_UNROLL_LOOP
+        for (int k=0; k<N; ++k)
+        {
+            const double tmp = a[jcol*N+k];
+            a[jcol*N+k] = a[ipvt*N+k];
+            a[ipvt*N+k] = tmp;
+        }
+        const int tmp = order[jcol];
+        order[jcol] = order[ipvt];
+        order[ipvt] = tmp;
+    }
+    return true;
+}
+
+//! @brief LU-decomposition of a contiguous row-major NxN matrix with partial pivoting, same algorithm as hopsan::ludcmp
+//! @details All loop bounds are known at compile time, so small systems are fully unrolled by the compiler.
+//! The operations are carried out in the same order as in hopsan::ludcmp, so the results are identical.
+template<int N>
+inline bool fixedSizeLUDecomposition(double *a, int *order)
+{
+    HOPSAN_UNROLL_LOOP
+    for (int i=0; i<N; ++i)
+    {
+        order[i] = i;
+    }
+
+    if (!fixedSizePivot<N>(a, order, 0))
+    {
+        return false;
+    }
+
+    double diag = 1.0/a[0];
+    HOPSAN_UNROLL_LOOP
+    for (int i=1; i<N; ++i)
+    {
+        a[i] *= diag;
+    }
+
+    HOPSAN_UNROLL_LOOP
+    for (int j=1; j<N-1; ++j)
+    {
+        // Column of L's
+        HOPSAN_UNROLL_LOOP
+        for (int i=j; i<N; ++i)
+        {
+            double sum = 0.0;
+            HOPSAN_UNROLL_LOOP
+            for (int k=0; k<j; ++k)
+            {
+                sum += a[i*N+k]*a[k*N+j];
+            }
+            a[i*N+j] -= sum;
+        }
+        if (!fixedSizePivot<N>(a, order, j))
+        {
+            return false;
+        }
+        // Row of U's
+        diag = 1.0/a[j*N+j];
+        HOPSAN_UNROLL_LOOP
+        for (int k=j+1; k<N; ++k)
+        {
+            double sum = 0.0;
+            HOPSAN_UNROLL_LOOP
+            for (int i=0; i<j; ++i)
+            {
+                sum += a[j*N+i]*a[i*N+k];
+            }
+            a[j*N+k] = (a[j*N+k]-sum)*diag;
+        }
+    }
+
+    // Last element in L
+    double sum = 0.0;
+    HOPSAN_UNROLL_LOOP
+    for (int k=0; k<N-1; ++k)
+    {
+        sum += a[(N-1)*N+k]*a[k*N+N-1];
+    }
+    a[(N-1)*N+N-1] -= sum;
+
+    return true;
+}
+
+//! @brief Copy the Jacobian to contiguous storage and LU-decompose it
+template<int N>
+bool fixedSizeFactorize(const Matrix &rJacobian, double *pLU, int *pOrder)
+{
+    HOPSAN_UNROLL_LOOP
+    for (int i=0; i<N; ++i)
+    {
+        const double *pRow = rJacobian[i];
+        HOPSAN_UNROLL_LOOP
+        for (int j=0; j<N; ++j)
+        {
+            pLU[i*N+j] = pRow[j];
+        }
+    }
+    return fixedSizeLUDecomposition<N>(pLU, pOrder);
+}
+
+//! @brief Solve using a LU-decomposition from fixedSizeFactorize, same algorithm as hopsan::solvlu
+template<int N>
+void fixedSizeSolve(const double *a, const int *order, const Vec &rB, Vec &rX)
+{
+    double x[N];
+    HOPSAN_UNROLL_LOOP
+    for (int i=0; i<N; ++i)
+    {
+        x[i] = rB[order[i]];
+    }
+
+    // Forward substitution
+    x[0] /= a[0];
+    HOPSAN_UNROLL_LOOP
+    for (int i=1; i<N; ++i)
+    {
+        double sum = 0.0;
+        HOPSAN_UNROLL_LOOP
+        for (int j=0; j<i; ++j)
+        {
+            sum += a[i*N+j]*x[j];
+        }
+        x[i] = (x[i]-sum)/a[i*N+i];
+    }
+
+    // Back substitution, x[N-1] is already done
+    HOPSAN_UNROLL_LOOP
+    for (int i=N-2; i>=0; --i)
+    {
+        double sum = 0.0;
+        HOPSAN_UNROLL_LOOP
+        for (int j=i+1; j<N; ++j)
+        {
+            sum += a[i*N+j]*x[j];
+        }
+        x[i] -= sum;
+    }
+
+    HOPSAN_UNROLL_LOOP
+    for (int i=0; i<N; ++i)
+    {
+        rX[i] = x[i];
+    }
+}
+
+}
+
 //! @brief Constructor for equation system solver utility
 //! @param pParentComponent Pointer to parent component
 //! @param n Number of states
@@ -79,6 +262,27 @@ EquationSystemSolver::EquationSystemSolver(Component *pParentComponent, int n)
     mpOrder = new int[n];                   //Used to keep track of the order of the equations
     mpDeltaStateVar = new Vec(n);           //Difference between nwe state variables and the previous ones
     mSingular = false;                      //Tells whether or not the Jacobian is singular
+
+    mpJacobian = nullptr;
+    mpEquations = nullptr;
+    mpVariables = nullptr;
+
+    // Small systems are solved with fixed-size code on contiguous storage
+    mpLU = nullptr;
+    mReuseFactorization = false;
+    switch (n)
+    {
+    case 1: mpFixedFactorize = &fixedSizeFactorize<1>; mpFixedSolve = &fixedSizeSolve<1>; break;
+    case 2: mpFixedFactorize = &fixedSizeFactorize<2>; mpFixedSolve = &fixedSizeSolve<2>; break;
+    case 3: mpFixedFactorize = &fixedSizeFactorize<3>; mpFixedSolve = &fixedSizeSolve<3>; break;
+    case 4: mpFixedFactorize = &fixedSizeFactorize<4>; mpFixedSolve = &fixedSizeSolve<4>; break;
+    case 5: mpFixedFactorize = &fixedSizeFactorize<5>; mpFixedSolve = &fixedSizeSolve<5>; break;
+    case 6: mpFixedFactorize = &fixedSizeFactorize<6>; mpFixedSolve = &fixedSizeSolve<6>; break;
+    case 7: mpFixedFactorize = &fixedSizeFactorize<7>; mpFixedSolve = &fixedSizeSolve<7>; break;
+    case 8: mpFixedFactorize = &fixedSizeFactorize<8>; mpFixedSolve = &fixedSizeSolve<8>; break;
+    default: mpFixedFactorize = nullptr; mpFixedSolve = nullptr;
+    }
+    static_assert(MaxFixedSystemSize == 8, "Update the fixed-size solver selection when changing MaxFixedSystemSize");
 }
 
 
@@ -89,42 +293,97 @@ EquationSystemSolver::EquationSystemSolver(Component *pParentComponent, int n)
 //! @param pEquations Pointer to vector with equations (RHS)
 //! @param pVariables Pointer to vector with state variables
 EquationSystemSolver::EquationSystemSolver(Component *pParentComponent, int n, Matrix *pJacobian, Vec *pEquations, Vec *pVariables)
+    : EquationSystemSolver(pParentComponent, n)
 {
-    mpParentComponent = pParentComponent;
-
-    // Weights for equations, used when running several iterations
-    mSystemEquationWeight[0]=1;
-    mSystemEquationWeight[1]=0.67;
-    mSystemEquationWeight[2]=0.5;
-    mSystemEquationWeight[3]=0.5;
-
-    mnVars = n;
-    mpOrder = new int[n];                   //Used to keep track of the order of the equations
-    mpDeltaStateVar = new Vec(n);           //Difference between nwe state variables and the previous ones
-    mSingular = false;                      //Tells whether or not the Jacobian is singular
-
     mpJacobian = pJacobian;
     mpEquations = pEquations;
     mpVariables = pVariables;
 }
 
 
-//! @brief Solves a system of equations
-//! @param jacobian Jacobian matrix
+EquationSystemSolver::~EquationSystemSolver()
+{
+    delete[] mpOrder;
+    delete mpDeltaStateVar;
+    delete mpLU;
+}
+
+
+//! @brief Reuse the LU-decomposition from the first iteration in later iterations of the same time step
+//! @details This turns the Newton-Raphson iterations into chord iterations, which converge slower but avoid refactorizing
+//! the Jacobian. It only affects solve(jacobian, equations, variables, iteration) with iteration > 1. The Jacobian
+//! passed to the solver is no longer overwritten by its LU-decomposition.
+//! @param reuse True to reuse the factorization
+void EquationSystemSolver::setReuseFactorization(bool reuse)
+{
+    mReuseFactorization = reuse;
+    if (reuse && !mpFixedFactorize && !mpLU)
+    {
+        mpLU = new Matrix(mnVars, mnVars);
+    }
+}
+
+
+//! @brief Factorizes the Jacobian (unless the previous factorization should be reused) and solves for the state variable change
+//! @param jacobian Jacobian matrix, overwritten by its LU-decomposition for large systems unless factorizations are reused
 //! @param equations Vector of system equations
-//! @param variables Vector of state variables
-//! @param iteration How many times the solver has been executed before in the same time step
-void EquationSystemSolver::solve(Matrix &jacobian, Vec &equations, Vec &variables, int iteration)
+//! @param reuseFactorization Reuse the previous factorization
+void EquationSystemSolver::calculateDelta(Matrix &jacobian, Vec &equations, bool reuseFactorization)
 {
+    bool factorizationOK = true;
+    if (mpFixedFactorize)
+    {
+        if (!reuseFactorization)
+        {
+            factorizationOK = mpFixedFactorize(jacobian, mFixedLU, mpOrder);
+        }
+    }
+    else if (mpLU)
+    {
+        if (!reuseFactorization)
+        {
+            for (int i=0; i<mnVars; ++i)
+            {
+                for (int j=0; j<mnVars; ++j)
+                {
+                    (*mpLU)[i][j] = jacobian[i][j];
+                }
+            }
+            factorizationOK = ludcmp(*mpLU, mpOrder);
+        }
+    }
+    else
+    {
+        factorizationOK = ludcmp(jacobian, mpOrder);
+    }
+
     //Stop simulation if LU decomposition failed due to singularity
-    if(!ludcmp(jacobian, mpOrder) && mpParentComponent)
+    if(!factorizationOK && mpParentComponent)
     {
         mpParentComponent->addErrorMessage("Unable to perform LU-decomposition: Jacobian matrix is probably singular.");
         mpParentComponent->stopSimulation();
     }
 
     //Solve system using L and U matrices
-    solvlu(jacobian,equations,*mpDeltaStateVar,mpOrder);
+    if (mpFixedSolve)
+    {
+        mpFixedSolve(mFixedLU, mpOrder, equations, *mpDeltaStateVar);
+    }
+    else
+    {
+        solvlu(mpLU ? *mpLU : jacobian, equations, *mpDeltaStateVar, mpOrder);
+    }
+}
+
+
+//! @brief Solves a system of equations
+//! @param jacobian Jacobian matrix
+//! @param equations Vector of system equations
+//! @param variables Vector of state variables
+//! @param iteration How many times the solver has been executed before in the same time step
+void EquationSystemSolver::solve(Matrix &jacobian, Vec &equations, Vec &variables, int iteration)
+{
+    calculateDelta(jacobian, equations, mReuseFactorization && (iteration > 1));
 
     //Calculate new system variables
     for(int i=0; i<mnVars; ++i)
@@ -141,15 +400,7 @@ void EquationSystemSolver::solve(Matrix &jacobian, Vec &equations, Vec &variable
 //! @param variables Vector of state variables
 void EquationSystemSolver::solve(Matrix &jacobian, Vec &equations, Vec &variables)
 {
-    //Stop simulation if LU decomposition failed due to singularity
-    if(!ludcmp(jacobian, mpOrder) && mpParentComponent)
-    {
-        mpParentComponent->addErrorMessage("Unable to perform LU-decomposition: Jacobian matrix is probably singular.");
-        mpParentComponent->stopSimulation();
-    }
-
-    //Solve system using L and U matrices
-    solvlu(jacobian,equations,*mpDeltaStateVar,mpOrder);
+    calculateDelta(jacobian, equations, false);
 
     //Calculate new system variables
     for(int i=0; i<mnVars; ++i)
@@ -164,15 +415,7 @@ void EquationSystemSolver::solve(Matrix &jacobian, Vec &equations, Vec &variable
 //! @brief Solves a system of equations. Requires pre-defined pointers to jacobian, equations and state variables.
 void EquationSystemSolver::solve()
 {
-    //Stop simulation if LU decomposition failed due to singularity
-    if(!ludcmp(*mpJacobian, mpOrder) && mpParentComponent)
-    {
-        mpParentComponent->addErrorMessage("Unable to perform LU-decomposition: Jacobian matrix is probably singular.");
-        mpParentComponent->stopSimulation();
-    }
-
-    //Solve system using L and U matrices
-    solvlu(*mpJacobian,*mpEquations,*mpDeltaStateVar,mpOrder);
+    calculateDelta(*mpJacobian, *mpEquations, false);
 
     //Calculate new system variables
     for(int i=0; i<mnVars; ++i)
@@ -622,7 +865,8 @@ static int kinsolJacobianCallback(N_Vector y, N_Vector f, SUNMatrix J, void *use
 }
 
 
-class KinsolSolver::Impl
+//! @brief The state vector is the initial guess for the next solve, it is part of the simulation state of the component
+class KinsolSolver::Impl : public ComponentStateObject
 {
 public:
     Impl(Component *pParentComponent, double tol, int n, SolverTypeEnum solverType=NewtonIteration);
@@ -632,7 +876,11 @@ public:
     void setState(int i, double value);
     void setTolerance(double value);
 
+    void saveState(StateWriter &rWriter) const;
+    bool restoreState(StateReader &rReader);
+
     Component *mpComponent;
+    int mN;
     void *mem;
     N_Vector y;
     N_Vector scale;
@@ -645,6 +893,7 @@ public:
 
 KinsolSolver::Impl::Impl(Component *pComponent, double tol, int n, SolverTypeEnum type)
     : mpComponent(pComponent),
+      mN(n),
       mSolverTime(pComponent->getTime()),
       mType(type)
 {
@@ -659,6 +908,7 @@ KinsolSolver::Impl::Impl(Component *pComponent, double tol, int n, SolverTypeEnu
     y = N_VNew_Serial(n);
     scale = N_VNew_Serial(n);
     N_VConst(1, scale);
+    mpComponent->registerStateObject(this);
 
     // Create solver memory
     mem = KINCreate();
@@ -793,6 +1043,18 @@ void KinsolSolver::Impl::setTolerance(double value)
 
 
 
+void KinsolSolver::Impl::saveState(StateWriter &rWriter) const
+{
+    rWriter.writeDoubles(NV_DATA_S(y), size_t(mN));
+}
+
+bool KinsolSolver::Impl::restoreState(StateReader &rReader)
+{
+    return rReader.readDoubles(NV_DATA_S(y), size_t(mN));
+}
+
+
+
 KinsolSolver::KinsolSolver(Component *pComponent, double tol, int n, SolverTypeEnum type=NewtonIteration) : impl(new Impl(pComponent, tol, n, type)) {}
 
 KinsolSolver::~KinsolSolver()
@@ -221,6 +221,27 @@ bool FirstOrderTransferFunction::isSaturated() const
     return mIsSaturated;
 }
 
+//! @brief Write the transfer function state to a state buffer
+void FirstOrderTransferFunction::saveState(StateWriter &rWriter) const
+{
+    rWriter.writeDouble(mValue);
+    rWriter.writeDouble(mDelayedU);
+    rWriter.writeDouble(mDelayedY);
+    rWriter.writeDoubles(mCoeffU, 2);
+    rWriter.writeDoubles(mCoeffY, 2);
+    rWriter.writeDouble(mMin);
+    rWriter.writeDouble(mMax);
+    rWriter.writeBool(mIsSaturated);
+}
+
+//! @brief Restore the transfer function state from a state buffer
+bool FirstOrderTransferFunction::restoreState(StateReader &rReader)
+{
+    return rReader.readDouble(mValue) && rReader.readDouble(mDelayedU) && rReader.readDouble(mDelayedY) &&
+           rReader.readDoubles(mCoeffU, 2) && rReader.readDoubles(mCoeffY, 2) && rReader.readDouble(mMin) &&
+           rReader.readDouble(mMax) && rReader.readBool(mIsSaturated);
+}
+
 
 
 
@@ -339,6 +360,31 @@ double FirstOrderTransferFunctionVariable::value()
 }
 
 
+//! @brief Write the transfer function state to a state buffer
+void FirstOrderTransferFunctionVariable::saveState(StateWriter &rWriter) const
+{
+    rWriter.writeDouble(mValue);
+    rWriter.writeDouble(mDelayU);
+    rWriter.writeDouble(mDelayY);
+    rWriter.writeDoubles(mNum, 2);
+    rWriter.writeDoubles(mDen, 2);
+    rWriter.writeDoubles(mCoeffU, 2);
+    rWriter.writeDoubles(mCoeffY, 2);
+    rWriter.writeDouble(mMin);
+    rWriter.writeDouble(mMax);
+    rWriter.writeDouble(mPrevTimeStep);
+}
+
+//! @brief Restore the transfer function state from a state buffer
+bool FirstOrderTransferFunctionVariable::restoreState(StateReader &rReader)
+{
+    return rReader.readDouble(mValue) && rReader.readDouble(mDelayU) && rReader.readDouble(mDelayY) &&
+           rReader.readDoubles(mNum, 2) && rReader.readDoubles(mDen, 2) && rReader.readDoubles(mCoeffU, 2) &&
+           rReader.readDoubles(mCoeffY, 2) && rReader.readDouble(mMin) && rReader.readDouble(mMax) &&
+           rReader.readDouble(mPrevTimeStep);
+}
+
+
 //! @class hopsan::FirstOrderLowPassFilter
 //! @ingroup ComponentUtilityClasses
 //! @brief The FirstOrderLowpassFilter utility is derived from the FirstOrderTransferFunction and extends it with functions useful when creating low-pass filters of the first order
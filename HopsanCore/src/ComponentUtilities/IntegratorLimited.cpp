@@ -126,3 +126,20 @@ double IntegratorLimited::value()
 {
     return mDelayY;
 }
+
+
+//! @brief Write the integrator state to a state buffer
+void IntegratorLimited::saveState(StateWriter &rWriter) const
+{
+    rWriter.writeDouble(mDelayU);
+    rWriter.writeDouble(mDelayY);
+    rWriter.writeDouble(mMin);
+    rWriter.writeDouble(mMax);
+}
+
+//! @brief Restore the integrator state from a state buffer
+bool IntegratorLimited::restoreState(StateReader &rReader)
+{
+    return rReader.readDouble(mDelayU) && rReader.readDouble(mDelayY) && rReader.readDouble(mMin) &&
+           rReader.readDouble(mMax);
+}
@@ -244,6 +244,30 @@ bool SecondOrderTransferFunction::isSaturated() const
     return mIsSaturated;
 }
 
+//! @brief Write the transfer function state to a state buffer
+void SecondOrderTransferFunction::saveState(StateWriter &rWriter) const
+{
+    rWriter.writeDouble(mValue);
+    rWriter.writeDouble(mDelayedU);
+    rWriter.writeDouble(mDelayed2U);
+    rWriter.writeDouble(mDelayedY);
+    rWriter.writeDouble(mDelayed2Y);
+    rWriter.writeDoubles(mCoeffU, 3);
+    rWriter.writeDoubles(mCoeffY, 3);
+    rWriter.writeDouble(mMin);
+    rWriter.writeDouble(mMax);
+    rWriter.writeBool(mIsSaturated);
+}
+
+//! @brief Restore the transfer function state from a state buffer
+bool SecondOrderTransferFunction::restoreState(StateReader &rReader)
+{
+    return rReader.readDouble(mValue) && rReader.readDouble(mDelayedU) && rReader.readDouble(mDelayed2U) &&
+           rReader.readDouble(mDelayedY) && rReader.readDouble(mDelayed2Y) && rReader.readDoubles(mCoeffU, 3) &&
+           rReader.readDoubles(mCoeffY, 3) && rReader.readDouble(mMin) && rReader.readDouble(mMax) &&
+           rReader.readBool(mIsSaturated);
+}
+
 
 
 
@@ -364,3 +388,28 @@ void SecondOrderTransferFunctionVariable::recalculateCoefficients()
     mCoeffY[1] = 2.0*mDen[0]*(*mpTimeStep)*(*mpTimeStep) - 8.0*mDen[2];
     mCoeffY[2] = mDen[0]*(*mpTimeStep)*(*mpTimeStep) - 2.0*mDen[1]*(*mpTimeStep) + 4.0*mDen[2];
 }
+
+
+//! @brief Write the transfer function state to a state buffer
+void SecondOrderTransferFunctionVariable::saveState(StateWriter &rWriter) const
+{
+    rWriter.writeDouble(mValue);
+    rWriter.writeDoubles(mDelayU, 2);
+    rWriter.writeDoubles(mDelayY, 2);
+    rWriter.writeDoubles(mDen, 3);
+    rWriter.writeDoubles(mNum, 3);
+    rWriter.writeDoubles(mCoeffU, 3);
+    rWriter.writeDoubles(mCoeffY, 3);
+    rWriter.writeDouble(mMin);
+    rWriter.writeDouble(mMax);
+    rWriter.writeDouble(mPrevTimeStep);
+}
+
+//! @brief Restore the transfer function state from a state buffer
+bool SecondOrderTransferFunctionVariable::restoreState(StateReader &rReader)
+{
+    return rReader.readDouble(mValue) && rReader.readDoubles(mDelayU, 2) && rReader.readDoubles(mDelayY, 2) &&
+           rReader.readDoubles(mDen, 3) && rReader.readDoubles(mNum, 3) && rReader.readDoubles(mCoeffU, 3) &&
+           rReader.readDoubles(mCoeffY, 3) && rReader.readDouble(mMin) && rReader.readDouble(mMax) &&
+           rReader.readDouble(mPrevTimeStep);
+}
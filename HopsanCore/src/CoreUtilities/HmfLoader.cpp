@@ -1055,6 +1055,46 @@ ComponentSystem* hopsan::loadHopsanModelFile(const HString &rFilePath, HopsanEss
 }
 
 
+//! @brief This function is used to create several independent instances of a model, the HMF file is only read and parsed once
+//! @param [in] rFilePath The path to the HMF file
+//! @param [in] pHopsanEssentials Pointer to the HopsanEssentials object
+//! @param [in] numInstances The number of instances to create
+//! @param [out] rInstances The created root systems are appended to this vector
+//! @param [out] rStartTime The start time stored in the model
+//! @param [out] rStopTime The stop time stored in the model
+//! @returns The number of successfully created instances
+size_t hopsan::loadHopsanModelFileInstances(const HString &rFilePath, HopsanEssentials* pHopsanEssentials, const size_t numInstances,
+                                            std::vector<ComponentSystem*> &rInstances, double &rStartTime, double &rStopTime)
+{
+    addCoreLogMessage("hopsan::loadHopsanModelFileInstances("+rFilePath+")");
+    size_t numCreated = 0;
+    try
+    {
+        rapidxml::file<> hmfFile(rFilePath.c_str());
+        rapidxml::xml_document<> doc;
+        doc.parse<0>(hmfFile.data());
+
+        for (size_t i=0; i<numInstances; ++i)
+        {
+            ComponentSystem *pSystem = loadHopsanModelFileActual(doc, rFilePath, pHopsanEssentials, rStartTime, rStopTime);
+            if (!pSystem)
+            {
+                break;
+            }
+            rInstances.push_back(pSystem);
+            ++numCreated;
+        }
+    }
+    catch(std::exception &e)
+    {
+        addCoreLogMessage("hopsan::loadHopsanModelFileInstances(): Unable to open file.");
+        pHopsanEssentials->getCoreMessageHandler()->addErrorMessage("Could not open file: "+rFilePath);
+        cout << "Could not open file, throws: " << e.what() << endl;
+    }
+    return numCreated;
+}
+
+
 //! @brief This function is used to load a HMF file from model string.
 //! @param [in] xmlModel The xml representation of the model
 //! @returns A pointer to the rootsystem of the loaded model
@@ -0,0 +1,329 @@
+/*-----------------------------------------------------------------------------
+
+ Copyright 2017 Hopsan Group
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+
+ The full license is available in the file LICENSE.
+ For details about the 'Hopsan Group' or information about Authors and
+ Contributors see the HOPSANGROUP and AUTHORS files that are located in
+ the Hopsan source code root directory.
+
+-----------------------------------------------------------------------------*/
+
+//!
+//! @file   LogSink.cpp
+//!
+//! @brief Contains the log sink interface and helpers for streaming log data to disk during simulation
+//!
+//$Id$
+
+#include "CoreUtilities/LogSink.h"
+
+#include <iomanip>
+
+using namespace hopsan;
+
+namespace {
+const size_t numChunkBuffers = 3;
+}
+
+//! @brief Returns the full variable name, on the form System$Component#Port#Variable
+//! @param [in] systemSeparator The character used to separate system names
+HString LogSinkVariable::getFullName(const char systemSeparator) const
+{
+    HString fullName;
+    if (!systemHierarchy.empty())
+    {
+        HString systems = systemHierarchy;
+        systems.replace(".", HString(systemSeparator));
+        fullName = systems + systemSeparator;
+    }
+    if (!componentName.empty())
+    {
+        fullName += componentName + "#";
+        if (!portName.empty())
+        {
+            fullName += portName + "#";
+        }
+    }
+    return fullName + variableName;
+}
+
+
+LogSink::~LogSink()
+{
+    // Nothing special, but needed since we have virtual functions
+}
+
+const HString &LogSink::getLastError() const
+{
+    return mLastError;
+}
+
+
+CSVLogSink::CSVLogSink(const HString &rFilePath) :
+    mFilePath(rFilePath), mNumVariables(0) {}
+
+bool CSVLogSink::open(const std::vector<LogSinkVariable> &rVariables)
+{
+    mFile.open(mFilePath.c_str());
+    if (!mFile.good())
+    {
+        mLastError = "Could not open: "+mFilePath+" for writing";
+        return false;
+    }
+
+    mNumVariables = rVariables.size();
+    for (size_t v=0; v<rVariables.size(); ++v)
+    {
+        mFile << (v>0 ? "," : "") << rVariables[v].getFullName().c_str();
+    }
+    mFile << "\n";
+    mFile << std::scientific << std::setprecision(std::numeric_limits<double>::digits10+1);
+    return mFile.good();
+}
+
+bool CSVLogSink::write(const double *pSamples, const size_t numSamples)
+{
+    for (size_t s=0; s<numSamples; ++s)
+    {
+        const double *pRow = pSamples+s*mNumVariables;
+        mFile << pRow[0];
+        for (size_t v=1; v<mNumVariables; ++v)
+        {
+            mFile << "," << pRow[v];
+        }
+        mFile << "\n";
+    }
+    if (!mFile.good())
+    {
+        mLastError = "Failed to write to: "+mFilePath;
+        return false;
+    }
+    return true;
+}
+
+bool CSVLogSink::close()
+{
+    mFile.close();
+    return !mFile.fail();
+}
+
+
+RawLogSink::RawLogSink(const HString &rFilePath) :
+    mFilePath(rFilePath), mNumVariables(0) {}
+
+bool RawLogSink::open(const std::vector<LogSinkVariable> &rVariables)
+{
+    mFile.open(mFilePath.c_str(), std::ios::out | std::ios::binary);
+    if (!mFile.good())
+    {
+        mLastError = "Could not open: "+mFilePath+" for writing";
+        return false;
+    }
+
+    mNumVariables = rVariables.size();
+    mFile << "HOPSANRAWLOG 1\n" << mNumVariables << "\n";
+    for (size_t v=0; v<rVariables.size(); ++v)
+    {
+        mFile << rVariables[v].getFullName().c_str() << "," << rVariables[v].alias.c_str() << ","
+              << rVariables[v].unit.c_str() << "," << rVariables[v].quantity.c_str() << "\n";
+    }
+    mFile << "\n";
+    return mFile.good();
+}
+
+bool RawLogSink::write(const double *pSamples, const size_t numSamples)
+{
+    mFile.write(reinterpret_cast<const char*>(pSamples), std::streamsize(numSamples*mNumVariables*sizeof(double)));
+    if (!mFile.good())
+    {
+        mLastError = "Failed to write to: "+mFilePath;
+        return false;
+    }
+    return true;
+}
+
+bool RawLogSink::close()
+{
+    mFile.close();
+    return !mFile.fail();
+}
+
+
+//! @brief Constructor
+//! @param [in] pSink The sink that will receive the samples, it is not owned by the streamer
+//! @param [in] numVariables The number of values in each sample (including time)
+//! @param [in] chunkNumSamples The number of samples per chunk, 0 means choose based on defaultChunkBytes
+LogStreamer::LogStreamer(LogSink *pSink, const size_t numVariables, const size_t chunkNumSamples) :
+    mpSink(pSink),
+    mNumVariables(numVariables),
+    mChunkNumSamples(chunkNumSamples),
+    mNumSamplesInChunk(0),
+    mpCurrentBuffer(0),
+    mStarted(false),
+#if defined(HOPSANCORE_USEMULTITHREADING)
+    mStopWriter(false),
+#endif
+    mFailed(false)
+{
+    if (mChunkNumSamples == 0)
+    {
+        mChunkNumSamples = std::max(size_t(1), defaultChunkBytes/(std::max(mNumVariables, size_t(1))*sizeof(double)));
+    }
+}
+
+LogStreamer::~LogStreamer()
+{
+    finish();
+}
+
+//! @brief Open the sink, allocate the chunk buffers and start the writer
+//! @param [in] rVariables The variable descriptions, one per value in each sample
+//! @returns True if the sink could be opened
+bool LogStreamer::start(const std::vector<LogSinkVariable> &rVariables)
+{
+    if (!mpSink->open(rVariables))
+    {
+        mFailed = true;
+        return false;
+    }
+
+    mBuffers.resize(numChunkBuffers, std::vector<double>(mChunkNumSamples*mNumVariables));
+    mpCurrentBuffer = &mBuffers[0];
+    mNumSamplesInChunk = 0;
+#if defined(HOPSANCORE_USEMULTITHREADING)
+    for (size_t b=1; b<mBuffers.size(); ++b)
+    {
+        mFreeBuffers.push_back(&mBuffers[b]);
+    }
+    mStopWriter = false;
+    mWriterThread = std::thread(&LogStreamer::writerLoop, this);
+#endif
+    mStarted = true;
+    return true;
+}
+
+//! @brief Mark the row returned by nextSample() as complete, hands the chunk over for writing when it is full
+void LogStreamer::commitSample()
+{
+    ++mNumSamplesInChunk;
+    if (mNumSamplesInChunk == mChunkNumSamples)
+    {
+#if defined(HOPSANCORE_USEMULTITHREADING)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mWriteQueue.push_back(std::make_pair(mpCurrentBuffer, mNumSamplesInChunk));
+        }
+        mCondition.notify_all();
+#else
+        writeChunk(mpCurrentBuffer, mNumSamplesInChunk);
+#endif
+        mNumSamplesInChunk = 0;
+        acquireBuffer();
+    }
+}
+
+//! @brief Write any remaining samples, stop the writer and close the sink
+//! @returns True if all data was successfully written
+bool LogStreamer::finish()
+{
+    if (!mStarted)
+    {
+        return !mFailed;
+    }
+    mStarted = false;
+
+#if defined(HOPSANCORE_USEMULTITHREADING)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mNumSamplesInChunk > 0)
+        {
+            mWriteQueue.push_back(std::make_pair(mpCurrentBuffer, mNumSamplesInChunk));
+        }
+        mStopWriter = true;
+    }
+    mCondition.notify_all();
+    mWriterThread.join();
+#else
+    if (mNumSamplesInChunk > 0)
+    {
+        writeChunk(mpCurrentBuffer, mNumSamplesInChunk);
+    }
+#endif
+    mNumSamplesInChunk = 0;
+
+    if (!mpSink->close())
+    {
+        mFailed = true;
+    }
+    return !mFailed;
+}
+
+bool LogStreamer::hasFailed() const
+{
+    return mFailed;
+}
+
+HString LogStreamer::getLastError() const
+{
+    return mpSink->getLastError();
+}
+
+void LogStreamer::writeChunk(std::vector<double> *pBuffer, const size_t numSamples)
+{
+    // Keep consuming chunks after a failure so that the simulation thread is never blocked, but do not write them
+    if (!mFailed && !mpSink->write(pBuffer->data(), numSamples))
+    {
+        mFailed = true;
+    }
+}
+
+#if defined(HOPSANCORE_USEMULTITHREADING)
+void LogStreamer::acquireBuffer()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCondition.wait(lock, [this]{return !mFreeBuffers.empty();});
+    mpCurrentBuffer = mFreeBuffers.back();
+    mFreeBuffers.pop_back();
+}
+
+void LogStreamer::writerLoop()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true)
+    {
+        mCondition.wait(lock, [this]{return mStopWriter || !mWriteQueue.empty();});
+        if (mWriteQueue.empty())
+        {
+            // Stop requested and nothing left to write
+            break;
+        }
+
+        std::pair<std::vector<double>*, size_t> chunk = mWriteQueue.front();
+        mWriteQueue.pop_front();
+        lock.unlock();
+        writeChunk(chunk.first, chunk.second);
+        lock.lock();
+        mFreeBuffers.push_back(chunk.first);
+        mCondition.notify_all();
+    }
+}
+#else
+void LogStreamer::acquireBuffer()
+{
+    // The same buffer is reused since chunks are written directly
+}
+#endif
@@ -0,0 +1,216 @@
+/*-----------------------------------------------------------------------------
+
+ Copyright 2017 Hopsan Group
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+
+ The full license is available in the file LICENSE.
+ For details about the 'Hopsan Group' or information about Authors and
+ Contributors see the HOPSANGROUP and AUTHORS files that are located in
+ the Hopsan source code root directory.
+
+-----------------------------------------------------------------------------*/
+
+
+
+//!
+//! @file   ModelBuilder.cpp
+//!
+//! @brief Contains the model builder, used to construct large models programmatically
+//!
+//$Id$
+
+#include "CoreUtilities/ModelBuilder.h"
+#include "HopsanEssentials.h"
+#include "ComponentSystem.h"
+#include "Port.h"
+#include "ComponentUtilities/num2string.hpp"
+
+using namespace hopsan;
+
+//! @brief Constructor, puts the system in bulk construction
+//! @param [in] pSystem The system to build the model in
+//! @param [in] expectedNumComponents The number of components that are expected to be added, used to reserve storage
+ModelBuilder::ModelBuilder(ComponentSystem *pSystem, const size_t expectedNumComponents)
+{
+    mpSystem = pSystem;
+    mNumFailedConnections = 0;
+    mpSystem->beginBulkConstruction(expectedNumComponents);
+}
+
+//! @brief Destructor, ends the bulk construction of the system, pending connections are discarded
+ModelBuilder::~ModelBuilder()
+{
+    mpSystem->endBulkConstruction();
+}
+
+//! @brief Reserve storage for the components and connections that will be added
+//! @param [in] numComponents The number of components
+//! @param [in] numConnections The number of connections
+void ModelBuilder::reserve(const size_t numComponents, const size_t numConnections)
+{
+    mpSystem->beginBulkConstruction(numComponents);
+    mPendingConnections.reserve(mPendingConnections.size()+numConnections);
+}
+
+//! @brief Create a component and add it to the system
+//! @param [in] rTypeName The type name of the component
+//! @param [in] rDesiredName The desired name of the component, a unique suffix is added if it is taken. If empty the type name is used
+//! @returns A pointer to the added component, or 0 if the component could not be created
+Component *ModelBuilder::addComponent(const HString &rTypeName, const HString &rDesiredName)
+{
+    // The builder may be used again after finish()
+    mpSystem->beginBulkConstruction();
+
+    Component *pComponent = mpSystem->getHopsanEssentials()->createComponent(rTypeName);
+    if (!pComponent)
+    {
+        mLastError = "Could not create component of type: "+rTypeName;
+        return 0;
+    }
+    if (!rDesiredName.empty())
+    {
+        pComponent->setName(rDesiredName);
+    }
+    mpSystem->addComponent(pComponent);
+    return pComponent;
+}
+
+//! @brief Queue a connection between two ports, the connection is made by finish()
+//! @param [in] pComponent1 The first component, or the system itself to connect to a system port
+//! @param [in] rPortName1 The name of the port on the first component
+//! @param [in] pComponent2 The second component, or the system itself to connect to a system port
+//! @param [in] rPortName2 The name of the port on the second component
+void ModelBuilder::connect(Component *pComponent1, const HString &rPortName1, Component *pComponent2, const HString &rPortName2)
+{
+    PendingConnection connection;
+    connection.pComponent1 = pComponent1;
+    connection.pComponent2 = pComponent2;
+    connection.portName1 = rPortName1;
+    connection.portName2 = rPortName2;
+    mPendingConnections.push_back(connection);
+}
+
+//! @brief Queue a connection between two ports, given by component names, the connection is made by finish()
+//! @param [in] rComponentName1 The name of the first component, or of a system port
+//! @param [in] rPortName1 The name of the port on the first component
+//! @param [in] rComponentName2 The name of the second component, or of a system port
+//! @param [in] rPortName2 The name of the port on the second component
+void ModelBuilder::connect(const HString &rComponentName1, const HString &rPortName1, const HString &rComponentName2, const HString &rPortName2)
+{
+    PendingConnection connection;
+    connection.pComponent1 = 0;
+    connection.pComponent2 = 0;
+    connection.componentName1 = rComponentName1;
+    connection.portName1 = rPortName1;
+    connection.componentName2 = rComponentName2;
+    connection.portName2 = rPortName2;
+    mPendingConnections.push_back(connection);
+}
+
+//! @brief Make all queued connections and end the bulk construction of the system
+//! @details All connections are attempted, also after a failure. Each failure is reported to the message handler.
+//! @returns True if all connections were made, else false (see getNumFailedConnections() and getLastError())
+bool ModelBuilder::finish()
+{
+    size_t numFailed = 0;
+    HString firstError, error;
+    for (size_t c=0; c<mPendingConnections.size(); ++c)
+    {
+        if (!makeConnection(mPendingConnections[c], error))
+        {
+            if (numFailed == 0)
+            {
+                firstError = error;
+            }
+            ++numFailed;
+        }
+    }
+    const size_t numConnections = mPendingConnections.size();
+    std::vector<PendingConnection>().swap(mPendingConnections);
+    mNumFailedConnections += numFailed;
+
+    mpSystem->endBulkConstruction();
+
+    if (numFailed > 0)
+    {
+        mLastError = to_hstring(numFailed)+" of "+to_hstring(numConnections)+" connections failed, the first failure was: "+firstError;
+        return false;
+    }
+    return true;
+}
+
+//! @brief Returns the system that the model is built in
+ComponentSystem *ModelBuilder::getSystem() const
+{
+    return mpSystem;
+}
+
+//! @brief Returns the number of queued connections that have not been made yet
+size_t ModelBuilder::getNumPendingConnections() const
+{
+    return mPendingConnections.size();
+}
+
+//! @brief Returns the total number of connections that have failed in finish()
+size_t ModelBuilder::getNumFailedConnections() const
+{
+    return mNumFailedConnections;
+}
+
+//! @brief Returns the last error, from addComponent() or a summary of the failed connections in finish()
+const HString &ModelBuilder::getLastError() const
+{
+    return mLastError;
+}
+
+//! @brief Resolve the components and ports of a queued connection and connect them
+//! @param [in] rConnection The connection to make
+//! @param [out] rError A description of the failure, if the connection failed
+//! @returns True if the connection was made, else false
+bool ModelBuilder::makeConnection(const PendingConnection &rConnection, HString &rError)
+{
+    Component *pComponents[2] = {rConnection.pComponent1, rConnection.pComponent2};
+    const HString *pComponentNames[2] = {&rConnection.componentName1, &rConnection.componentName2};
+    const HString *pPortNames[2] = {&rConnection.portName1, &rConnection.portName2};
+    Port *pPorts[2] = {0, 0};
+    for (size_t i=0; i<2; ++i)
+    {
+        if (!pComponents[i])
+        {
+            pComponents[i] = mpSystem->getSubComponentOrThisIfSysPort(*pComponentNames[i]);
+            if (!pComponents[i])
+            {
+                rError = "Component: '"+*pComponentNames[i]+"' can not be found when attempting connect";
+                mpSystem->addErrorMessage(rError, "connectwithoutcomponent");
+                return false;
+            }
+        }
+        pPorts[i] = pComponents[i]->getPort(*pPortNames[i]);
+        if (!pPorts[i])
+        {
+            rError = "Component: '"+pComponents[i]->getName()+"' does not have a port named '"+*pPortNames[i]+"'";
+            mpSystem->addErrorMessage(rError, "portdoesnotexist");
+            return false;
+        }
+    }
+
+    if (!mpSystem->connect(pPorts[0], pPorts[1]))
+    {
+        rError = "Could not connect: {"+pComponents[0]->getName()+"::"+pPorts[0]->getName()+"} and {"+
+                 pComponents[1]->getName()+"::"+pPorts[1]->getName()+"}";
+        return false;
+    }
+    return true;
+}
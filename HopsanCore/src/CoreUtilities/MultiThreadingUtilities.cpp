@@ -25,6 +25,7 @@
 //$Id$
 
 #include <sstream>
+#include <algorithm>
 #include <cassert>
 #include <limits>
 #include <cmath>
@@ -45,9 +46,16 @@
 
 #include "CoreUtilities/MultiThreadingUtilities.h"
 #include "ComponentSystem.h"
+#include "ComponentUtilities/num2string.hpp"
 
 namespace hopsan {
 
+//! @brief Maximum number of C and Q components that are moved between threads each time the load is rebalanced
+const size_t maxRebalanceMovesPerPhase = 4;
+
+//! @brief Maximum number of load balance checks that are skipped while an imbalance persists
+const size_t maxRescheduleBackoff = 64;
+
 //! @brief Helper function that decides how many thread to use.
 //! User specifies desired amount, but it is limited by how many cores the processor has.
 //! @param [in] nDesiredThreads How many threads the user wants
@@ -86,6 +94,226 @@ size_t determineActualNumberOfThreads(const size_t nDesiredThreads)
 
 #if defined(HOPSANCORE_USEMULTITHREADING)
 
+//! @brief Simulate a vector of components, through the profiler if profiling is enabled
+inline void simulateComponents(ThreadLoadProfiler *pProfiler, const size_t threadID, const ThreadLoadProfiler::PhaseT phase,
+                               std::vector<Component*> &rComponents, const double time, const bool sample)
+{
+    if(pProfiler)
+    {
+        pProfiler->simulateComponents(threadID, phase, rComponents, time, sample);
+    }
+    else
+    {
+        for(size_t i=0; i<rComponents.size(); ++i)
+        {
+            rComponents[i]->simulate(time);
+        }
+    }
+}
+
+
+//! @brief Constructor
+//! @param pSystem Pointer to the component system being simulated
+//! @param rSplitSignalVector Signal components, one vector per thread
+//! @param rSplitCVector C-type components, one vector per thread
+//! @param rSplitQVector Q-type components, one vector per thread
+//! @param sampleInterval Component times are sampled every sampleInterval:th step, 0 disables sampling and rescheduling
+//! @param rescheduleThreshold Relative load imbalance that triggers rescheduling, 0 disables rescheduling
+//! @param rescheduleCheckInterval Number of steps between each check of the load balance
+ThreadLoadProfiler::ThreadLoadProfiler(ComponentSystem *pSystem, std::vector< std::vector<Component*> > &rSplitSignalVector,
+                                       std::vector< std::vector<Component*> > &rSplitCVector, std::vector< std::vector<Component*> > &rSplitQVector,
+                                       size_t sampleInterval, double rescheduleThreshold, size_t rescheduleCheckInterval) :
+    mpSystem(pSystem),
+    mrSplitSignalVector(rSplitSignalVector),
+    mrSplitCVector(rSplitCVector),
+    mrSplitQVector(rSplitQVector),
+    mSampleInterval(sampleInterval),
+    mRescheduleThreshold((sampleInterval > 0) ? rescheduleThreshold : 0),
+    mRescheduleCheckInterval(rescheduleCheckInterval),
+    mNumReschedules(0),
+    mNumChecksToSkip(0),
+    mRescheduleBackoff(0),
+    mStartTick(0)
+{
+    const size_t nThreads = std::max(rSplitSignalVector.size(), std::max(rSplitCVector.size(), rSplitQVector.size()));
+    for(size_t t=0; t<nThreads; ++t)
+    {
+        mThreadData.push_back(std::unique_ptr<ThreadData>(new ThreadData()));
+    }
+}
+
+//! @brief Simulate components, timing each component if sample is true
+//! @param threadID The calling thread
+//! @param phase The phase (signal, C or Q) that the components belong to
+//! @param rComponents The components of this thread in this phase
+//! @param time The simulation time
+//! @param sample Whether each component should be timed
+void ThreadLoadProfiler::simulateComponents(const size_t threadID, const PhaseT phase, std::vector<Component*> &rComponents, const double time, const bool sample)
+{
+    if(!sample)
+    {
+        for(size_t i=0; i<rComponents.size(); ++i)
+        {
+            rComponents[i]->simulate(time);
+        }
+        return;
+    }
+
+    ThreadData &rData = *mThreadData[threadID];
+    unsigned long long *pTicks = &rData.mComponentTicks[rData.mPhaseOffsets[phase]];
+    unsigned long long t0 = HOPSANCORE_READ_CYCLE_COUNTER();
+    for(size_t i=0; i<rComponents.size(); ++i)
+    {
+        rComponents[i]->simulate(time);
+        const unsigned long long t1 = HOPSANCORE_READ_CYCLE_COUNTER();
+        pTicks[i] += t1-t0;
+        t0 = t1;
+    }
+    if(phase == SignalPhase)
+    {
+        ++rData.mNumSamples;
+    }
+}
+
+//! @brief Reset all counters, call just before the simulation threads are started
+void ThreadLoadProfiler::start()
+{
+    mStartTime = std::chrono::steady_clock::now();
+    mStartTick = HOPSANCORE_READ_CYCLE_COUNTER();
+    for(size_t t=0; t<mThreadData.size(); ++t)
+    {
+        ThreadData &rData = *mThreadData[t];
+        rData.mLastTick = mStartTick;
+        rData.mBusyTicks = 0;
+        rData.mIdleTicks = 0;
+        rData.mPhase = LogPhase;
+    }
+    resetSamples();
+}
+
+//! @brief Check the load balance in the last check interval, and reschedule the components if the imbalance is too large
+//! @note Must only be called by the master thread, while all other threads are blocked at a barrier
+void ThreadLoadProfiler::checkBalance()
+{
+    const size_t nThreads = mThreadData.size();
+
+    if(mNumChecksToSkip > 0)
+    {
+        --mNumChecksToSkip;
+        resetSamples();
+        return;
+    }
+
+    // The imbalance is the time lost waiting for the slowest thread, relative to the average, summed over the parallel phases
+    double sumMax=0, sumAverage=0;
+    const PhaseT phases[] = {SignalPhase, CPhase, QPhase};
+    for(size_t p=0; p<3; ++p)
+    {
+        double maxTicks=0, sumTicks=0;
+        for(size_t t=0; t<nThreads; ++t)
+        {
+            const double ticks = double(mThreadData[t]->mWindowBusyTicks[phases[p]]);
+            maxTicks = std::max(maxTicks, ticks);
+            sumTicks += ticks;
+        }
+        sumMax += maxTicks;
+        sumAverage += sumTicks/double(nThreads);
+    }
+    const double imbalance = (sumAverage > 0) ? sumMax/sumAverage-1.0 : 0.0;
+
+    if((imbalance > mRescheduleThreshold) && (mThreadData[0]->mNumSamples > 0))
+    {
+        // Use the sampled average time per step [ms] as measured time for each component
+        const double ticksPerMs = getTicksPerSecond()/1000.0;
+        for(size_t t=0; t<nThreads; ++t)
+        {
+            const ThreadData &rData = *mThreadData[t];
+            const std::vector<Component*> *splitVectors[] = {&mrSplitSignalVector[t], &mrSplitCVector[t], &mrSplitQVector[t]};
+            for(size_t p=0; p<3; ++p)
+            {
+                for(size_t i=0; i<splitVectors[p]->size(); ++i)
+                {
+                    const double ticks = double(rData.mComponentTicks[rData.mPhaseOffsets[phases[p]]+i]);
+                    (*splitVectors[p])[i]->setMeasuredTime(ticks/double(rData.mNumSamples)/ticksPerMs);
+                }
+            }
+        }
+
+        // Only the components that cause the imbalance are moved, a full repartition at the barrier would stall all threads
+        const size_t numMoved = mpSystem->rebalanceThreads(maxRebalanceMovesPerPhase);
+        if(numMoved > 0)
+        {
+            mpSystem->addDebugMessage("Thread load imbalance "+to_hstring(imbalance*100.0)+" % exceeds "+to_hstring(mRescheduleThreshold*100.0)+
+                                      " %, moved "+to_hstring(numMoved)+" components", "reschedule");
+            ++mNumReschedules;
+        }
+
+        // If the imbalance remains (e.g. caused by signal components or a single heavy component), check less often
+        mNumChecksToSkip = mRescheduleBackoff;
+        mRescheduleBackoff = std::min(std::max(size_t(1), 2*mRescheduleBackoff), maxRescheduleBackoff);
+    }
+    else
+    {
+        mRescheduleBackoff = 0;
+    }
+
+    resetSamples();
+}
+
+//! @brief Returns the busy and idle time for each thread, since start() was called
+std::vector<ThreadLoadStatistics> ThreadLoadProfiler::getStatistics() const
+{
+    const double ticksPerSecond = getTicksPerSecond();
+    std::vector<ThreadLoadStatistics> statistics(mThreadData.size());
+    for(size_t t=0; t<mThreadData.size(); ++t)
+    {
+        statistics[t].busyTime = double(mThreadData[t]->mBusyTicks)/ticksPerSecond;
+        statistics[t].idleTime = double(mThreadData[t]->mIdleTicks)/ticksPerSecond;
+    }
+    return statistics;
+}
+
+//! @brief Returns the number of times the components have been rescheduled
+size_t ThreadLoadProfiler::getNumReschedules() const
+{
+    return mNumReschedules;
+}
+
+//! @brief Clear the component samples and the busy time of the current check interval, and adapt to the current component distribution
+void ThreadLoadProfiler::resetSamples()
+{
+    for(size_t t=0; t<mThreadData.size(); ++t)
+    {
+        ThreadData &rData = *mThreadData[t];
+        const size_t nS = (t < mrSplitSignalVector.size()) ? mrSplitSignalVector[t].size() : 0;
+        const size_t nC = (t < mrSplitCVector.size()) ? mrSplitCVector[t].size() : 0;
+        const size_t nQ = (t < mrSplitQVector.size()) ? mrSplitQVector[t].size() : 0;
+        rData.mPhaseOffsets[SignalPhase] = 0;
+        rData.mPhaseOffsets[CPhase] = nS;
+        rData.mPhaseOffsets[QPhase] = nS+nC;
+        rData.mPhaseOffsets[LogPhase] = nS+nC+nQ;
+        rData.mComponentTicks.assign(nS+nC+nQ, 0);
+        rData.mNumSamples = 0;
+        for(size_t p=0; p<NumPhases; ++p)
+        {
+            rData.mWindowBusyTicks[p] = 0;
+        }
+    }
+}
+
+//! @brief Returns the cycle counter frequency, calibrated against the steady clock since start() was called
+double ThreadLoadProfiler::getTicksPerSecond() const
+{
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-mStartTime).count();
+    const double ticks = double(HOPSANCORE_READ_CYCLE_COUNTER()-mStartTick);
+    if((seconds <= 0) || (ticks <= 0))
+    {
+        return 1e9;
+    }
+    return ticks/seconds;
+}
+
+
 //! @brief Constructor for slave simulation thread function.
 //! @param pSystem Pointer to top level component system
 //! @param sVector Vector with signal components executed from this thread
@@ -99,18 +327,21 @@ size_t determineActualNumberOfThreads(const size_t nDesiredThreads)
 //! @param *pBarrier_C Pointer to barrier before C-type components
 //! @param *pBarrier_Q Pointer to barrier before Q-type components
 //! @param *pBarrier_N Pointer to barrier before node logging
+//! @param pProfiler Pointer to the thread load profiler, or 0 if profiling is disabled
 void simSlave(ComponentSystem *pSystem,
               std::vector<Component*> &sVector,
               std::vector<Component*> &cVector,
               std::vector<Component*> &qVector,
               std::vector<Node*> &nVector,
+              size_t threadID,
               double startTime,
               double timeStep,
               size_t numSimSteps,
               BarrierLock *pBarrier_S,
               BarrierLock *pBarrier_C,
               BarrierLock *pBarrier_Q,
-              BarrierLock *pBarrier_N)
+              BarrierLock *pBarrier_N,
+              ThreadLoadProfiler *pProfiler)
 {
     (void)nVector;
 
@@ -119,46 +350,46 @@ void simSlave(ComponentSystem *pSystem,
     for(size_t i=0; i<numSimSteps; ++i)
     {
         time += timeStep;
+        const bool sample = pProfiler && pProfiler->isSampleStep(i);
 
         //! Signal Components !//
 
+        if(pProfiler) pProfiler->beginWait(threadID);
         pBarrier_S->increment();
         while(pBarrier_S->isLocked()){}                         //Wait at S barrier
+        if(pProfiler) pProfiler->endWait(threadID, ThreadLoadProfiler::SignalPhase);
         if(pSystem->wasSimulationAborted()) break;
 
-        for(size_t i=0; i<sVector.size(); ++i)
-        {
-            sVector[i]->simulate(time);
-        }
+        simulateComponents(pProfiler, threadID, ThreadLoadProfiler::SignalPhase, sVector, time, sample);
 
 
         //! C Components !//
 
+        if(pProfiler) pProfiler->beginWait(threadID);
         pBarrier_C->increment();
         while(pBarrier_C->isLocked()){}                         //Wait at C barrier
+        if(pProfiler) pProfiler->endWait(threadID, ThreadLoadProfiler::CPhase);
         if(pSystem->wasSimulationAborted()) break;
 
-        for(size_t i=0; i<cVector.size(); ++i)
-        {
-            cVector[i]->simulate(time);
-        }
+        simulateComponents(pProfiler, threadID, ThreadLoadProfiler::CPhase, cVector, time, sample);
 
 
         //! Q Components !//
 
+        if(pProfiler) pProfiler->beginWait(threadID);
         pBarrier_Q->increment();
         while(pBarrier_Q->isLocked()){}                         //Wait at Q barrier
+        if(pProfiler) pProfiler->endWait(threadID, ThreadLoadProfiler::QPhase);
         if(pSystem->wasSimulationAborted()) break;
 
-        for(size_t i=0; i<qVector.size(); ++i)
-        {
-            qVector[i]->simulate(time);
-        }
+        simulateComponents(pProfiler, threadID, ThreadLoadProfiler::QPhase, qVector, time, sample);
 
         //! Log Nodes !//
 
+        if(pProfiler) pProfiler->beginWait(threadID);
         pBarrier_N->increment();
         while(pBarrier_N->isLocked()){}                         //Wait at N barrier
+        if(pProfiler) pProfiler->endWait(threadID, ThreadLoadProfiler::LogPhase);
         if(pSystem->wasSimulationAborted()) break;
         //! @todo Temporary hack by Peter, after rewriting how node data and time is logged this no longer works, now master thread loags all nodes, need to come up with something smart
         //            for(size_t i=0; i<mVectorN.size(); ++i)
@@ -184,10 +415,11 @@ void simSlave(ComponentSystem *pSystem,
 //! @param *pBarrier_C Pointer to barrier before C-type components
 //! @param *pBarrier_Q Pointer to barrier before Q-type components
 //! @param *pBarrier_N Pointer to barrier before node logging
+//! @param pProfiler Pointer to the thread load profiler, or 0 if profiling is disabled
 void simMaster(ComponentSystem *pSystem, std::vector<Component *> &sVector, std::vector<Component *> &cVector,
                std::vector<Component *> &qVector, std::vector<Node *> &nVector, std::vector<double *> &pSimTimes, double startTime, double timeStep,
                size_t numSimSteps, BarrierLock *pBarrier_S, BarrierLock *pBarrier_C,
-               BarrierLock *pBarrier_Q, BarrierLock *pBarrier_N)
+               BarrierLock *pBarrier_Q, BarrierLock *pBarrier_N, ThreadLoadProfiler *pProfiler)
 {
     (void)nVector;
 
@@ -196,9 +428,11 @@ void simMaster(ComponentSystem *pSystem, std::vector<Component *> &sVector, std:
     for(size_t s=0; s<numSimSteps; ++s)
     {
         time += timeStep;
+        const bool sample = pProfiler && pProfiler->isSampleStep(s);
 
         //! Signal Components !//
         bool stop=false;
+        if(pProfiler) pProfiler->beginWait(0);
         while(!pBarrier_S->allArrived())   //Wait for all other threads to arrive at signal barrier
         {
             if(pSystem->wasSimulationAborted())
@@ -216,16 +450,20 @@ void simMaster(ComponentSystem *pSystem, std::vector<Component *> &sVector, std:
             pBarrier_N->unlock();
             break;
         }
+        // All other threads are blocked here, so this is where the components can be rescheduled
+        if(pProfiler && pProfiler->isCheckStep(s))
+        {
+            pProfiler->checkBalance();
+        }
         pBarrier_C->lock();                    //Lock next barrier (must be done before unlocking this one, to prevent deadlocks)
         pBarrier_S->unlock();                  //Unlock signal barrier
+        if(pProfiler) pProfiler->endWait(0, ThreadLoadProfiler::SignalPhase);
 
-        for(size_t i=0; i<sVector.size(); ++i)
-        {
-            sVector[i]->simulate(time);
-        }
+        simulateComponents(pProfiler, 0, ThreadLoadProfiler::SignalPhase, sVector, time, sample);
 
         //! C Components !//
         stop=false;
+        if(pProfiler) pProfiler->beginWait(0);
         while(!pBarrier_C->allArrived())   //C barrier
         {
             if(pSystem->wasSimulationAborted())
@@ -244,14 +482,13 @@ void simMaster(ComponentSystem *pSystem, std::vector<Component *> &sVector, std:
         }
         pBarrier_Q->lock();
         pBarrier_C->unlock();
+        if(pProfiler) pProfiler->endWait(0, ThreadLoadProfiler::CPhase);
 
-        for(size_t i=0; i<cVector.size(); ++i)
-        {
-            cVector[i]->simulate(time);
-        }
+        simulateComponents(pProfiler, 0, ThreadLoadProfiler::CPhase, cVector, time, sample);
 
         //! Q Components !//
         stop=false;
+        if(pProfiler) pProfiler->beginWait(0);
         while(!pBarrier_Q->allArrived()) //Q barrier
         {
             if(pSystem->wasSimulationAborted())
@@ -270,16 +507,16 @@ void simMaster(ComponentSystem *pSystem, std::vector<Component *> &sVector, std:
         }
         pBarrier_N->lock();
         pBarrier_Q->unlock();
-        for(size_t i=0; i<qVector.size(); ++i)
-        {
-            qVector[i]->simulate(time);
-        }
+        if(pProfiler) pProfiler->endWait(0, ThreadLoadProfiler::QPhase);
+
+        simulateComponents(pProfiler, 0, ThreadLoadProfiler::QPhase, qVector, time, sample);
 
         for(size_t i=0; i<pSimTimes.size(); ++i)
             *pSimTimes[i] = time;     //Update time in component system, so that progress bar can use it
 
         //! Log Nodes !//
         stop=false;
+        if(pProfiler) pProfiler->beginWait(0);
         while(!pBarrier_N->allArrived()) //N barrier
         {
             if(pSystem->wasSimulationAborted())
@@ -299,6 +536,7 @@ void simMaster(ComponentSystem *pSystem, std::vector<Component *> &sVector, std:
         }
         pBarrier_S->lock();
         pBarrier_N->unlock();
+        if(pProfiler) pProfiler->endWait(0, ThreadLoadProfiler::LogPhase);
 
         //! @todo Temporary hack by Peter, after rewriting how node data and time is logged this no longer works, now master thread loags all nodes, need to come up with something smart
         //            for(size_t i=0; i<mVectorN.size(); ++i)
@@ -310,6 +548,88 @@ void simMaster(ComponentSystem *pSystem, std::vector<Component *> &sVector, std:
 }
 
 
+//! @brief Simulation thread function for a priori scheduling using a hybrid (spin-then-park) barrier.
+//! @details The same function is used for all threads, thread 0 acts as master and is responsible for
+//! updating the simulation time, logging and for aborting the barrier if the simulation is stopped.
+//! @param pSystem Pointer to the top level component system
+//! @param sVector Vector with signal components executed from this thread
+//! @param cVector Vector with C-type components executed from this thread
+//! @param qVector Vector with Q-type components executed from this thread
+//! @param pSimTimes Pointers to the simulation time variables in the component systems (only used by master)
+//! @param threadID Index of this thread, 0 is master
+//! @param startTime Start time of simulation
+//! @param timeStep Step time of simulation
+//! @param numSimSteps Number of steps to simulate
+//! @param pBarrier Pointer to the barrier shared by all threads
+//! @param pProfiler Pointer to the thread load profiler, or 0 if profiling is disabled
+void simHybridBarrierThread(ComponentSystem *pSystem, std::vector<Component*> &sVector, std::vector<Component*> &cVector,
+                            std::vector<Component*> &qVector, std::vector<double *> &pSimTimes, size_t threadID,
+                            double startTime, double timeStep, size_t numSimSteps, HybridBarrier *pBarrier,
+                            ThreadLoadProfiler *pProfiler)
+{
+    const bool isMaster = (threadID == 0);
+    double time = startTime;
+
+    // Master checks for abort before each barrier, all threads break when the barrier is aborted
+    auto syncPhase = [&](ThreadLoadProfiler::PhaseT nextPhase) -> bool
+    {
+        if(isMaster && pSystem->wasSimulationAborted())
+        {
+            pBarrier->abort();
+            return false;
+        }
+        if(pProfiler) pProfiler->beginWait(threadID);
+        const bool ok = pBarrier->wait();
+        if(pProfiler) pProfiler->endWait(threadID, nextPhase);
+        return ok;
+    };
+
+    for(size_t s=0; s<numSimSteps; ++s)
+    {
+        time += timeStep;
+        const bool sample = pProfiler && pProfiler->isSampleStep(s);
+
+        //! Signal Components !//
+        if(!syncPhase(ThreadLoadProfiler::SignalPhase)) break;
+        simulateComponents(pProfiler, threadID, ThreadLoadProfiler::SignalPhase, sVector, time, sample);
+
+        //! C Components !//
+        if(!syncPhase(ThreadLoadProfiler::CPhase)) break;
+        simulateComponents(pProfiler, threadID, ThreadLoadProfiler::CPhase, cVector, time, sample);
+
+        //! Q Components !//
+        if(!syncPhase(ThreadLoadProfiler::QPhase)) break;
+        simulateComponents(pProfiler, threadID, ThreadLoadProfiler::QPhase, qVector, time, sample);
+
+        //! Log Nodes !//
+        if(!syncPhase(ThreadLoadProfiler::LogPhase)) break;
+        if(isMaster)
+        {
+            for(size_t i=0; i<pSimTimes.size(); ++i)
+            {
+                *pSimTimes[i] = time;     //Update time in component system, so that progress bar can use it
+            }
+            pSystem->logTimeAndNodes(s+1);
+        }
+
+        //! Reschedule !//
+        if(pProfiler && pProfiler->isCheckStep(s+1))
+        {
+            // Other threads are blocked between the two waits while the master checks the balance
+            pProfiler->beginWait(threadID);
+            bool ok = pBarrier->wait();
+            if(ok && isMaster)
+            {
+                pProfiler->checkBalance();
+            }
+            ok = ok && pBarrier->wait();
+            pProfiler->endWait(threadID, ThreadLoadProfiler::LogPhase);
+            if(!ok) break;
+        }
+    }
+}
+
+
 //! @brief Function for slave simulation threads using a task pool
 void simPoolSlave(TaskPool *pTaskPoolC, TaskPool *pTaskPoolQ, std::atomic<double> *pTime, std::atomic<bool> *pStop)
 {
@@ -345,257 +665,311 @@ void simPoolSlave(TaskPool *pTaskPoolC, TaskPool *pTaskPoolQ, std::atomic<double
 }
 
 
-//! @brief Function for master simulation thread, that is responsible for synchronizing the simulation
-void simStealingMaster(ComponentSystem *pSystem,
-                       std::vector<Component *> &sVector,
-                       std::vector<ThreadSafeVector *> *cVectors,
-                       std::vector<ThreadSafeVector *> *qVectors,
-                       std::vector<double *> &pSimTimes,
-                       double startTime,
-                       double timeStep,
-                       size_t numSimSteps,
-                       size_t nThreads,
-                       size_t threadID,
-                       BarrierLock *pBarrier_S,
-                       BarrierLock *pBarrier_C,
-                       BarrierLock *pBarrier_Q,
-                       BarrierLock *pBarrier_N,
-                       size_t maxSize)
+//! @brief Constructor, starts the persistent worker threads
+//! @param nThreads Number of threads to use, including the thread calling simulate()
+//! @param spinBudget Number of spin iterations before a thread waiting at a phase barrier is parked
+WorkStealingScheduler::WorkStealingScheduler(size_t nThreads, size_t spinBudget)
 {
-    ThreadSafeVector *pTemp;
-    Component *pComp;
+    mnThreads = std::max(size_t(1), nThreads);
+    mSpinBudget = spinBudget;
+    mpSystem = 0;
+    mpSignalComponents = 0;
+    mpSimTimes = 0;
+    mpSubSystems = 0;
+    mStartTime = 0;
+    mTimeStep = 0;
+    mNumSimSteps = 0;
+    mNumCTasks = 0;
+    mNumQTasks = 0;
+    mRemainingC.store(0);
+    mRemainingQ.store(0);
+    mJobGeneration = 0;
+    mnFinishedWorkers = 0;
+    mQuit = false;
+
+    for(size_t t=0; t<mnThreads; ++t)
+    {
+        mThreadStates.push_back(std::unique_ptr<ThreadState>(new ThreadState()));
+        mThreadStates.back()->mpDeque.reset(new WorkStealingDeque(1));
+        mThreadStates.back()->mRandomState = static_cast<unsigned int>(2654435761u*(t+1));
+    }
 
-    double time = startTime;
-    std::vector<ThreadSafeVector*> *pUnFinishedVectorsC = cVectors;
-    std::vector<ThreadSafeVector*> *pUnFinishedVectorsQ = qVectors;
-    ThreadSafeVector *pFinishedVectorC = new ThreadSafeVector(std::vector<Component*>(), maxSize);
-    ThreadSafeVector *pFinishedVectorQ = new ThreadSafeVector(std::vector<Component*>(), maxSize);
+    for(size_t t=1; t<mnThreads; ++t)
+    {
+        mWorkers.push_back(std::thread(&WorkStealingScheduler::workerLoop, this, t));
+    }
+}
 
-    for(size_t s=0; s<numSimSteps; ++s)
+//! @brief Destructor, stops and joins the worker threads
+WorkStealingScheduler::~WorkStealingScheduler()
+{
     {
-        if(pSystem->wasSimulationAborted()) break;
+        std::lock_guard<std::mutex> lock(mJobMutex);
+        mQuit = true;
+    }
+    mJobCondition.notify_all();
+    for(size_t i=0; i<mWorkers.size(); ++i)
+    {
+        mWorkers[i].join();
+    }
+}
 
-        time += timeStep;
+//! @brief Returns the number of threads used, including the thread calling simulate()
+size_t WorkStealingScheduler::getNumThreads() const
+{
+    return mnThreads;
+}
 
-        //! Signal Components !//
+//! @brief Returns the number of spin iterations before a thread waiting at a phase barrier is parked
+size_t WorkStealingScheduler::getSpinBudget() const
+{
+    return mSpinBudget;
+}
 
-        while(!pBarrier_S->allArrived()) {}
-        pBarrier_C->lock();
-        pBarrier_S->unlock();
+//! @brief Returns the number of tasks that were stolen during the last call to simulate()
+size_t WorkStealingScheduler::getNumStolenTasks() const
+{
+    size_t nStolen=0;
+    for(size_t t=0; t<mThreadStates.size(); ++t)
+    {
+        nStolen += mThreadStates[t]->mNumStolen;
+    }
+    return nStolen;
+}
 
-        //Simulate signal components
-        for(size_t i=0; i<sVector.size(); ++i)
+//! @brief Simulates a number of time steps using the worker threads, returns when all steps are done or the simulation is aborted
+//! @param pSystem Pointer to the component system
+//! @param rSignalComponents Signal components, simulated in order by the calling thread
+//! @param rCComponents Initial distribution of C-type components, one vector per thread
+//! @param rQComponents Initial distribution of Q-type components, one vector per thread
+//! @param rSimTimes Time variables to update after each step
+//! @param rSubSystems Subsystems whose components are included in the tasks, logged after each step together with the system
+//! @param startTime Start time of simulation
+//! @param timeStep Step time of simulation
+//! @param numSimSteps Number of simulation steps to run
+void WorkStealingScheduler::simulate(ComponentSystem *pSystem, std::vector<Component *> &rSignalComponents,
+                                     const std::vector<std::vector<Component *> > &rCComponents, const std::vector<std::vector<Component *> > &rQComponents,
+                                     std::vector<double *> &rSimTimes, const std::vector<ComponentSystem *> &rSubSystems,
+                                     double startTime, double timeStep, size_t numSimSteps)
+{
+    mpSystem = pSystem;
+    mpSignalComponents = &rSignalComponents;
+    mpSimTimes = &rSimTimes;
+    mpSubSystems = &rSubSystems;
+    mStartTime = startTime;
+    mTimeStep = timeStep;
+    mNumSimSteps = numSimSteps;
+
+    mNumCTasks = 0;
+    mNumQTasks = 0;
+    for(size_t t=0; t<mnThreads; ++t)
+    {
+        ThreadState &rState = *mThreadStates[t];
+        rState.mCTasks.clear();
+        rState.mQTasks.clear();
+        rState.mNumStolen = 0;
+    }
+    // If there are more distribution vectors than threads, the extra ones are assigned round-robin
+    for(size_t i=0; i<rCComponents.size(); ++i)
+    {
+        std::vector<Component*> &rTasks = mThreadStates[i%mnThreads]->mCTasks;
+        rTasks.insert(rTasks.end(), rCComponents[i].begin(), rCComponents[i].end());
+        mNumCTasks += rCComponents[i].size();
+    }
+    for(size_t i=0; i<rQComponents.size(); ++i)
+    {
+        std::vector<Component*> &rTasks = mThreadStates[i%mnThreads]->mQTasks;
+        rTasks.insert(rTasks.end(), rQComponents[i].begin(), rQComponents[i].end());
+        mNumQTasks += rQComponents[i].size();
+    }
+
+    // Any thread may end up with all tasks of a phase, so each deque must be able to hold them
+    const size_t requiredCapacity = std::max(mNumCTasks, mNumQTasks);
+    for(size_t t=0; t<mnThreads; ++t)
+    {
+        if(mThreadStates[t]->mpDeque->capacity() < requiredCapacity)
         {
-            sVector[i]->simulate(time);
+            mThreadStates[t]->mpDeque.reset(new WorkStealingDeque(requiredCapacity));
         }
+    }
 
-        //! C Components !//
-
-        while(!pBarrier_C->allArrived()) {}    //C barrier
-        pBarrier_Q->lock();
-        pBarrier_C->unlock();
+    // A new barrier is needed since an aborted barrier can not be reused
+    mpBarrier.reset(new HybridBarrier(mnThreads, mSpinBudget));
 
-        //SIMULATE C
+    // Start the workers, and take part as thread 0
+    {
+        std::lock_guard<std::mutex> lock(mJobMutex);
+        mnFinishedWorkers = 0;
+        ++mJobGeneration;
+    }
+    mJobCondition.notify_all();
 
-        //Switch Q vectors
-        pTemp = pUnFinishedVectorsQ->at(threadID);
-        pUnFinishedVectorsQ->at(threadID) = pFinishedVectorQ;
-        pFinishedVectorQ = pTemp;
+    runSteps(0);
 
-        //Simulate own components
-        pComp = pUnFinishedVectorsC->at(threadID)->tryAndTakeFirst();
-        while(pComp)
-        {
-            pComp->simulate(time);
-            pFinishedVectorC->insertFirst(pComp);
-            pComp = pUnFinishedVectorsC->at(threadID)->tryAndTakeFirst();
-        }
+    std::unique_lock<std::mutex> lock(mJobMutex);
+    mJobCondition.wait(lock, [this](){ return mnFinishedWorkers == mWorkers.size(); });
+}
 
-        //Steal components
-        //if(int(time/timeStep/5+threadID)%nThreads == 0)
+//! @brief Loop for the persistent worker threads, waits for a job, runs it and reports back
+void WorkStealingScheduler::workerLoop(size_t threadID)
+{
+    size_t handledGeneration = 0;
+    while(true)
+    {
         {
-            for(size_t i=0; i<nThreads-1; ++i)
+            std::unique_lock<std::mutex> lock(mJobMutex);
+            mJobCondition.wait(lock, [this, handledGeneration](){ return mQuit || (mJobGeneration != handledGeneration); });
+            if(mQuit)
             {
-                int j = (threadID+1+i)%nThreads;
-                pComp = pUnFinishedVectorsC->at(j)->tryAndTakeLast();
-                if(pComp)
-                {
-                    pComp->simulate(time);
-                    pFinishedVectorC->insertLast(pComp);
-                    break;
-                }
+                return;
             }
+            handledGeneration = mJobGeneration;
         }
 
-        //! Q Components !//
-
-        while(!pBarrier_Q->allArrived()) {}    //Q barrier
-        pBarrier_N->lock();
-        pBarrier_Q->unlock();
-
-        //SIMULATE Q
-
-        //Switch C vectors
-        pTemp = pUnFinishedVectorsC->at(threadID);
-        pUnFinishedVectorsC->at(threadID) = pFinishedVectorC;
-        pFinishedVectorC = pTemp;
+        runSteps(threadID);
 
-        //Simulate own components
-        pComp = pUnFinishedVectorsQ->at(threadID)->tryAndTakeFirst();
-        while(pComp)
         {
-            pComp->simulate(time);
-            pFinishedVectorQ->insertFirst(pComp);
-            pComp = pUnFinishedVectorsQ->at(threadID)->tryAndTakeFirst();
-        }
-
-        //Steal components
-        //if(int(time/timeStep/5+mThreadID)%nThreads == 0)
-        {
-            for(size_t i=0; i<nThreads-1; ++i)
-            {
-                int j = (threadID+1+i)%nThreads;
-                pComp = pUnFinishedVectorsQ->at(j)->tryAndTakeLast();
-                if(pComp)
-                {
-                    pComp->simulate(time);
-                    pFinishedVectorQ->insertLast(pComp);
-                    break;
-                }
-            }
+            std::lock_guard<std::mutex> lock(mJobMutex);
+            ++mnFinishedWorkers;
         }
-
-        for(size_t i=0; i<pSimTimes.size(); ++i)
-            *pSimTimes[i] = time;
-
-        //! Log Nodes !//
-
-        while(!pBarrier_N->allArrived()) {}    //N barrier
-        pBarrier_S->lock();
-        pBarrier_N->unlock();
-
-        pSystem->logTimeAndNodes(s+1);
+        mJobCondition.notify_all();
     }
 }
 
-void simStealingSlave(ComponentSystem *pSystem,
-                      std::vector<ThreadSafeVector *> *cVectors,
-                      std::vector<ThreadSafeVector *> *qVectors,
-                      double startTime,
-                      double timeStep,
-                      size_t numSimSteps,
-                      size_t nThreads,
-                      size_t threadID,
-                      BarrierLock *pBarrier_S,
-                      BarrierLock *pBarrier_C,
-                      BarrierLock *pBarrier_Q,
-                      BarrierLock *pBarrier_N,
-                      size_t maxSize)
-
+//! @brief Runs all time steps of the current job from one thread
+void WorkStealingScheduler::runSteps(size_t threadID)
 {
-    double time = startTime;;
-    std::vector<ThreadSafeVector*> *pUnFinishedVectorsC = cVectors;
-    std::vector<ThreadSafeVector*> *pUnFinishedVectorsQ = qVectors;
-    //! @todo memory leak, never deleted, however, dont delete in destructor, that will cause double free corruption since this object is copied when new tasks are created
-    ThreadSafeVector *pFinishedVectorC = new ThreadSafeVector(std::vector<Component*>(), maxSize);
-    ThreadSafeVector *pFinishedVectorQ = new ThreadSafeVector(std::vector<Component*>(), maxSize);
-
-
-    ThreadSafeVector *pTemp;
-    Component *pComp;
+    const bool isMaster = (threadID == 0);
+    ThreadState &rState = *mThreadStates[threadID];
+    HybridBarrier *pBarrier = mpBarrier.get();
+    double time = mStartTime;
 
-    for(size_t i=0; i<numSimSteps; ++i)
+    // Master checks for abort before each barrier, all threads break when the barrier is aborted
+    auto syncPhase = [&]() -> bool
     {
-        if(pSystem->wasSimulationAborted()) break;
+        if(isMaster && mpSystem->wasSimulationAborted())
+        {
+            pBarrier->abort();
+            return false;
+        }
+        return pBarrier->wait();
+    };
 
-        time += timeStep;
+    for(size_t s=0; s<mNumSimSteps; ++s)
+    {
+        time += mTimeStep;
 
         //! Signal Components !//
-
-        pBarrier_S->increment();
-        while(pBarrier_S->isLocked()){}                         //Wait at S barrier
+        if(isMaster)
+        {
+            for(size_t i=0; i<mpSignalComponents->size(); ++i)
+            {
+                (*mpSignalComponents)[i]->simulate(time);
+            }
+            mRemainingC.store(mNumCTasks);
+        }
 
         //! C Components !//
-
-        pBarrier_C->increment();
-        while(pBarrier_C->isLocked()){}                         //Wait at C barrier
-
-        //C-COMPONENTS
-
-        //Switch Q vectors
-        pTemp = pUnFinishedVectorsQ->at(threadID);
-        pUnFinishedVectorsQ->at(threadID) = pFinishedVectorQ;
-        pFinishedVectorQ = pTemp;
-
-        //Simulate own components
-        pComp = pUnFinishedVectorsC->at(threadID)->tryAndTakeFirst();
-        while(pComp)
+        if(!syncPhase()) break;
+        runPhase(threadID, rState.mCTasks, mRemainingC, time);
+        if(isMaster)
         {
-            pComp->simulate(time);
-            pFinishedVectorC->insertFirst(pComp);
-            pComp = pUnFinishedVectorsC->at(threadID)->tryAndTakeFirst();
+            // No thread reads the Q counter until after the next barrier
+            mRemainingQ.store(mNumQTasks);
         }
 
-        //Steal components
-        //if(int(time/timeStep/5+mThreadID)%mnThreads == 0)
+        //! Q Components !//
+        if(!syncPhase()) break;
+        runPhase(threadID, rState.mQTasks, mRemainingQ, time);
+
+        //! Log Nodes !//
+        if(!syncPhase()) break;
+        if(isMaster)
         {
-            for(size_t i=0; i<nThreads-1; ++i)
+            for(size_t i=0; i<mpSimTimes->size(); ++i)
             {
-                int j = (threadID+1+i)%nThreads;
-                pComp = pUnFinishedVectorsC->at(j)->tryAndTakeLast();
-                if(pComp)
-                {
-                    pComp->simulate(time);
-                    pFinishedVectorC->insertLast(pComp);
-                    break;
-                }
+                *(*mpSimTimes)[i] = time;     //Update time in component system, so that progress bar can use it
+            }
+            mpSystem->logTimeAndNodes(s+1);
+            for(size_t i=0; i<mpSubSystems->size(); ++i)
+            {
+                (*mpSubSystems)[i]->logTimeAndNodes(s+1);
             }
         }
+    }
+}
 
-        //! Q Components !//
-
-        pBarrier_Q->increment();
-        while(pBarrier_Q->isLocked()){}                         //Wait at Q barrier
+//! @brief Executes one phase from one thread, until all tasks in the phase (on all threads) are done
+//! @param threadID The calling thread
+//! @param rOwnTasks The tasks this thread starts with, replaced by the tasks it actually executed
+//! @param rRemaining Number of tasks in the phase that are not yet done
+//! @param time The simulation time
+void WorkStealingScheduler::runPhase(size_t threadID, std::vector<Component *> &rOwnTasks, std::atomic<size_t> &rRemaining, double time)
+{
+    ThreadState &rState = *mThreadStates[threadID];
+    WorkStealingDeque *pDeque = rState.mpDeque.get();
 
-        //Q-COMPONENTS
+    // Push in reverse order so that own tasks are popped in the original order, thieves take from the other end
+    for(size_t i=rOwnTasks.size(); i>0; --i)
+    {
+        pDeque->push(rOwnTasks[i-1]);
+    }
+    rOwnTasks.clear();
 
-        //Switch C vectors
-        pTemp = pUnFinishedVectorsC->at(threadID);
-        pUnFinishedVectorsC->at(threadID) = pFinishedVectorC;
-        pFinishedVectorC = pTemp;
+    while(rRemaining.load(std::memory_order_acquire) > 0)
+    {
+        Component *pComp = pDeque->pop();
+        if(!pComp)
+        {
+            pComp = stealTask(threadID);
+            if(pComp)
+            {
+                ++rState.mNumStolen;
+            }
+        }
 
-        //Simulate own components
-        pComp = pUnFinishedVectorsQ->at(threadID)->tryAndTakeFirst();
-        while(pComp)
+        if(pComp)
         {
             pComp->simulate(time);
-            pFinishedVectorQ->insertFirst(pComp);
-            pComp = pUnFinishedVectorsQ->at(threadID)->tryAndTakeFirst();
+            rOwnTasks.push_back(pComp);
+            rRemaining.fetch_sub(1, std::memory_order_acq_rel);
         }
-
-        //Steal components
-        //if(int(time/timeStep/5+mThreadID)%mnThreads == 0)
+        else
         {
-            for(size_t i=0; i<nThreads-1; ++i)
-            {
-                int j = (threadID+1+i)%nThreads;
-                pComp = pUnFinishedVectorsQ->at(j)->tryAndTakeLast();
-                if(pComp)
-                {
-                    pComp->simulate(time);
-                    pFinishedVectorQ->insertLast(pComp);
-                    break;
-                }
-            }
+            HOPSANCORE_CPU_RELAX();
         }
+    }
+}
 
-        //! Log Nodes !//
+//! @brief Try to steal one task from another thread, victims are visited starting from a random thread
+//! @returns Pointer to the stolen component, or 0 if nothing could be stolen
+Component *WorkStealingScheduler::stealTask(size_t threadID)
+{
+    if(mnThreads < 2)
+    {
+        return 0;
+    }
 
-        pBarrier_N->increment();
-        while(pBarrier_N->isLocked()){}                         //Wait at N barrier
+    // Xorshift, only used to spread the thieves over the victims
+    unsigned int &rRandom = mThreadStates[threadID]->mRandomState;
+    rRandom ^= rRandom << 13;
+    rRandom ^= rRandom >> 17;
+    rRandom ^= rRandom << 5;
+
+    const size_t first = rRandom % (mnThreads-1);
+    for(size_t i=0; i<mnThreads-1; ++i)
+    {
+        const size_t victim = (threadID+1+(first+i)%(mnThreads-1))%mnThreads;
+        Component *pComp = mThreadStates[victim]->mpDeque->steal();
+        if(pComp)
+        {
+            return pComp;
+        }
     }
+    return 0;
 }
 
+
 void simOneComponentOneStep(Component *pComp, double stopTime)
 {
     pComp->simulate(stopTime);
@@ -624,41 +998,6 @@ void simWholeSystems(std::vector<ComponentSystem *> systemPtrs, double stopTime)
     }
 }
 
-//! @brief Function for simulating whole systems multi-threaded
-//! @param systemPtrs Vector with pointers to the systems to simulate
-//! @param stopTime Stop time of simulation
-void simWholeSystemInRealtime(double realTimeFactor, volatile bool *pStopSimulation, double *pTime, double timeStep, std::vector<Component*> signalComponentPtrs, std::vector<Component*> cComponentPtrs, std::vector<Component*> qComponentPtrs)
-{
-#if (__cplusplus >= 201103L)
-    auto wallTime = std::chrono::steady_clock::now();
-
-    while(!(*pStopSimulation)) {
-        *pTime += timeStep; //mTime is updated here before the simulation,
-        //mTime is the current time during the simulateOneTimestep
-
-        //Signal components
-        for(const auto &sComponent : signalComponentPtrs) {
-            sComponent->simulate(*pTime);
-        }
-
-        //C components
-        for(const auto &cComponent : cComponentPtrs) {
-            cComponent->simulate(*pTime);
-        }
-
-        //Q components
-        for(const auto &qComponent : qComponentPtrs) {
-            qComponent->simulate(*pTime);
-        }
-
-        wallTime += std::chrono::microseconds(int(1000000*timeStep/realTimeFactor));
-        std::this_thread::sleep_until(wallTime);
-    }
-#else
-    return;
-#endif
-}
-
 #endif //Multithreading
 
 }
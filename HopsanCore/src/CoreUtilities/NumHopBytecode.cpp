@@ -0,0 +1,646 @@
+/*-----------------------------------------------------------------------------
+
+ Copyright 2017 Hopsan Group
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+
+ The full license is available in the file LICENSE.
+ For details about the 'Hopsan Group' or information about Authors and
+ Contributors see the HOPSANGROUP and AUTHORS files that are located in
+ the Hopsan source code root directory.
+
+-----------------------------------------------------------------------------*/
+
+//!
+//! @file   NumHopBytecode.cpp
+//!
+//! @brief Contains a compiler and evaluator for NumHop scripts using flat register based bytecode
+//!
+//$Id$
+
+#include "CoreUtilities/NumHopBytecode.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+using namespace hopsan;
+
+namespace {
+
+double nhAbs(double x) {return std::fabs(x);}
+double nhAcos(double x) {return std::acos(x);}
+double nhAsin(double x) {return std::asin(x);}
+double nhAtan(double x) {return std::atan(x);}
+double nhCeil(double x) {return std::ceil(x);}
+double nhCos(double x) {return std::cos(x);}
+double nhCosh(double x) {return std::cosh(x);}
+double nhExp(double x) {return std::exp(x);}
+double nhFloor(double x) {return std::floor(x);}
+double nhLog(double x) {return std::log(x);}
+double nhLog10(double x) {return std::log10(x);}
+double nhSin(double x) {return std::sin(x);}
+double nhSinh(double x) {return std::sinh(x);}
+double nhSqrt(double x) {return std::sqrt(x);}
+double nhTan(double x) {return std::tan(x);}
+double nhTanh(double x) {return std::tanh(x);}
+double nhAtan2(double y, double x) {return std::atan2(y, x);}
+double nhPow(double x, double y) {return std::pow(x, y);}
+double nhFmod(double x, double y) {return std::fmod(x, y);}
+double nhMin(double x, double y) {return std::min(x, y);}
+double nhMax(double x, double y) {return std::max(x, y);}
+
+//! @brief The built-in functions, the same subset of cmath as supported by the NumHop interpreter
+struct BuiltInFunction
+{
+    const char *name;
+    double (*pFunction1)(double);
+    double (*pFunction2)(double, double);
+};
+
+const BuiltInFunction builtInFunctions[] = {
+    {"abs", nhAbs, nullptr}, {"acos", nhAcos, nullptr}, {"asin", nhAsin, nullptr}, {"atan", nhAtan, nullptr},
+    {"ceil", nhCeil, nullptr}, {"cos", nhCos, nullptr}, {"cosh", nhCosh, nullptr}, {"exp", nhExp, nullptr},
+    {"floor", nhFloor, nullptr}, {"log", nhLog, nullptr}, {"log10", nhLog10, nullptr}, {"sin", nhSin, nullptr},
+    {"sinh", nhSinh, nullptr}, {"sqrt", nhSqrt, nullptr}, {"tan", nhTan, nullptr}, {"tanh", nhTanh, nullptr},
+    {"atan2", nullptr, nhAtan2}, {"pow", nullptr, nhPow}, {"fmod", nullptr, nhFmod}, {"min", nullptr, nhMin},
+    {"max", nullptr, nhMax}};
+const size_t numBuiltInFunctions = sizeof(builtInFunctions)/sizeof(BuiltInFunction);
+
+double evalOperation(const NumHopProgram::OpCodeT op, const double a, const double b, const size_t function)
+{
+    switch (op)
+    {
+    case NumHopProgram::Copy : return a;
+    case NumHopProgram::Add : return a+b;
+    case NumHopProgram::Subtract : return a-b;
+    case NumHopProgram::Multiply : return a*b;
+    case NumHopProgram::Divide : return a/b;
+    case NumHopProgram::Power : return std::pow(a, b);
+    case NumHopProgram::Negate : return -a;
+    case NumHopProgram::Less : return (a < b) ? 1.0 : 0.0;
+    case NumHopProgram::Greater : return (a > b) ? 1.0 : 0.0;
+    case NumHopProgram::Function1 : return builtInFunctions[function].pFunction1(a);
+    case NumHopProgram::Function2 : return builtInFunctions[function].pFunction2(a, b);
+    }
+    return 0;
+}
+
+}
+
+NumHopProgram::NumHopProgram() :
+    mpResolver(nullptr),
+    mpExpression(nullptr),
+    mPos(0),
+    mpResult(nullptr),
+    mIsCompiled(false)
+{
+}
+
+//! @brief Compile script expressions
+//! @param [in] rExpressions The expressions (script rows without comments), rows may contain several expressions separated by ;
+//! @param [in] rResolver Resolves data pointers and constant values, only used during compilation
+//! @returns True if the whole script could be compiled, otherwise the program is left empty and getLastError() tells why
+bool NumHopProgram::compile(const std::vector<std::string> &rExpressions, NumHopSymbolResolver &rResolver)
+{
+    clear();
+    mLastError.clear();
+    mpResolver = &rResolver;
+
+    bool haveExpression = false;
+    Operand result;
+    for (size_t r=0; r<rExpressions.size(); ++r)
+    {
+        size_t start = 0;
+        while (start <= rExpressions[r].size())
+        {
+            size_t end = std::min(rExpressions[r].find(';', start), rExpressions[r].size());
+            const std::string expression = rExpressions[r].substr(start, end-start);
+            start = end+1;
+            if (expression.find_first_not_of(" \t\r\n") == std::string::npos)
+            {
+                continue;
+            }
+            if (!compileExpression(expression, result))
+            {
+                clear();
+                mpResolver = nullptr;
+                return false;
+            }
+            haveExpression = true;
+        }
+    }
+    mpResolver = nullptr;
+    if (!haveExpression)
+    {
+        clear();
+        mLastError = "Nothing to compile";
+        return false;
+    }
+    const int resultRegister = toRegister(result);
+
+    // The register array will not be resized any more, so pointers to it can now be resolved
+    mRegisters = mInitialRegisters;
+    std::vector<double*> ptrs(mRegisters.size());
+    for (size_t r=0; r<mRegisters.size(); ++r)
+    {
+        ptrs[r] = &mRegisters[r];
+    }
+    struct Resolve
+    {
+        static double *ptr(const int reg, std::vector<double*> &rRegisterPtrs, std::vector<double*> &rDataPtrs)
+        {
+            return (reg >= 0) ? rRegisterPtrs[size_t(reg)] : rDataPtrs[size_t(-1-reg)];
+        }
+    };
+    mInstructions.resize(mCompiledInstructions.size());
+    for (size_t i=0; i<mCompiledInstructions.size(); ++i)
+    {
+        const CompiledInstruction &rCI = mCompiledInstructions[i];
+        Instruction &rI = mInstructions[i];
+        rI.op = rCI.op;
+        rI.pDst = Resolve::ptr(rCI.dst, ptrs, mDataPtrs);
+        rI.pA = Resolve::ptr(rCI.a, ptrs, mDataPtrs);
+        rI.pB = Resolve::ptr(rCI.b, ptrs, mDataPtrs);
+        rI.pFunction1 = builtInFunctions[rCI.function].pFunction1;
+        rI.pFunction2 = builtInFunctions[rCI.function].pFunction2;
+    }
+    mpResult = Resolve::ptr(resultRegister, ptrs, mDataPtrs);
+    mIsCompiled = true;
+    return true;
+}
+
+void NumHopProgram::clear()
+{
+    mCompiledInstructions.clear();
+    mInitialRegisters.clear();
+    mDataPtrs.clear();
+    mLocalRegisters.clear();
+    mLocalConstants.clear();
+    mExternalNames.clear();
+    mInstructions.clear();
+    mRegisters.clear();
+    mpResult = nullptr;
+    mIsCompiled = false;
+}
+
+bool NumHopProgram::isCompiled() const
+{
+    return mIsCompiled;
+}
+
+//! @brief Evaluate the compiled script
+//! @returns The value of the last expression in the script
+double NumHopProgram::eval()
+{
+    const Instruction *pEnd = mInstructions.data()+mInstructions.size();
+    for (const Instruction *pI = mInstructions.data(); pI != pEnd; ++pI)
+    {
+        switch (pI->op)
+        {
+        case Copy : *pI->pDst = *pI->pA; break;
+        case Add : *pI->pDst = *pI->pA + *pI->pB; break;
+        case Subtract : *pI->pDst = *pI->pA - *pI->pB; break;
+        case Multiply : *pI->pDst = *pI->pA * *pI->pB; break;
+        case Divide : *pI->pDst = *pI->pA / *pI->pB; break;
+        case Power : *pI->pDst = std::pow(*pI->pA, *pI->pB); break;
+        case Negate : *pI->pDst = -*pI->pA; break;
+        case Less : *pI->pDst = (*pI->pA < *pI->pB) ? 1.0 : 0.0; break;
+        case Greater : *pI->pDst = (*pI->pA > *pI->pB) ? 1.0 : 0.0; break;
+        case Function1 : *pI->pDst = pI->pFunction1(*pI->pA); break;
+        case Function2 : *pI->pDst = pI->pFunction2(*pI->pA, *pI->pB); break;
+        }
+    }
+    return mpResult ? *mpResult : 0;
+}
+
+size_t NumHopProgram::getNumInstructions() const
+{
+    return mInstructions.size();
+}
+
+const HString &NumHopProgram::getLastError() const
+{
+    return mLastError;
+}
+
+bool NumHopProgram::compileExpression(const std::string &rExpression, Operand &rResult)
+{
+    mpExpression = &rExpression;
+    mPos = 0;
+    if (!parseAssignment(rResult))
+    {
+        return false;
+    }
+    if (peek() != '\0')
+    {
+        return fail(HString("Unexpected character: ")+HString(peek()));
+    }
+    return true;
+}
+
+bool NumHopProgram::parseAssignment(Operand &rResult)
+{
+    const size_t startPos = mPos;
+    HString name;
+    if (parseName(name) && accept('='))
+    {
+        Operand value;
+        if (!parseAssignment(value))
+        {
+            return false;
+        }
+        return assignVariable(name, value, rResult);
+    }
+    mPos = startPos;
+    return parseComparison(rResult);
+}
+
+bool NumHopProgram::parseComparison(Operand &rResult)
+{
+    if (!parseSum(rResult))
+    {
+        return false;
+    }
+    while (true)
+    {
+        const char c = peek();
+        if (c == '<' || c == '>')
+        {
+            ++mPos;
+            Operand rhs;
+            if (!parseSum(rhs))
+            {
+                return false;
+            }
+            rResult = emit((c == '<') ? Less : Greater, rResult, rhs);
+        }
+        else if (c == '|' || c == '&')
+        {
+            return fail(HString("The boolean operator ")+HString(c)+" is not supported by the compiler");
+        }
+        else
+        {
+            return true;
+        }
+    }
+}
+
+bool NumHopProgram::parseSum(Operand &rResult)
+{
+    if (!parseProduct(rResult))
+    {
+        return false;
+    }
+    while (true)
+    {
+        const char c = peek();
+        if (c != '+' && c != '-')
+        {
+            return true;
+        }
+        ++mPos;
+        Operand rhs;
+        if (!parseProduct(rhs))
+        {
+            return false;
+        }
+        rResult = emit((c == '+') ? Add : Subtract, rResult, rhs);
+    }
+}
+
+bool NumHopProgram::parseProduct(Operand &rResult)
+{
+    if (!parseUnary(rResult))
+    {
+        return false;
+    }
+    while (true)
+    {
+        const char c = peek();
+        if (c != '*' && c != '/')
+        {
+            return true;
+        }
+        ++mPos;
+        Operand rhs;
+        if (!parseUnary(rhs))
+        {
+            return false;
+        }
+        rResult = emit((c == '*') ? Multiply : Divide, rResult, rhs);
+    }
+}
+
+bool NumHopProgram::parseUnary(Operand &rResult)
+{
+    if (accept('-'))
+    {
+        Operand value;
+        if (!parseUnary(value))
+        {
+            return false;
+        }
+        rResult = emit(Negate, value, value);
+        return true;
+    }
+    if (accept('+'))
+    {
+        return parseUnary(rResult);
+    }
+    return parsePower(rResult);
+}
+
+bool NumHopProgram::parsePower(Operand &rResult)
+{
+    if (!parsePrimary(rResult))
+    {
+        return false;
+    }
+    if (accept('^'))
+    {
+        // Right associative, a^b^c = a^(b^c)
+        Operand exponent;
+        if (!parseUnary(exponent))
+        {
+            return false;
+        }
+        rResult = emit(Power, rResult, exponent);
+    }
+    return true;
+}
+
+bool NumHopProgram::parsePrimary(Operand &rResult)
+{
+    const char c = peek();
+    if (c == '(')
+    {
+        ++mPos;
+        if (!parseComparison(rResult))
+        {
+            return false;
+        }
+        return accept(')') || fail("Missing )");
+    }
+    if (std::isdigit(static_cast<unsigned char>(c)) || c == '.')
+    {
+        rResult = Operand();
+        return parseNumber(rResult.value);
+    }
+
+    HString name;
+    if (!parseName(name))
+    {
+        return fail((c == '\0') ? HString("Unexpected end of expression") : HString("Unexpected character: ")+HString(c));
+    }
+    if (!accept('('))
+    {
+        return readVariable(name, rResult);
+    }
+
+    size_t function = 0;
+    while (function < numBuiltInFunctions && name != builtInFunctions[function].name)
+    {
+        ++function;
+    }
+    if (function == numBuiltInFunctions)
+    {
+        return fail("Unknown function: "+name);
+    }
+    Operand arg1, arg2;
+    if (!parseComparison(arg1))
+    {
+        return false;
+    }
+    if (builtInFunctions[function].pFunction2)
+    {
+        if (!accept(','))
+        {
+            return fail("Function "+name+" takes two arguments");
+        }
+        if (!parseComparison(arg2))
+        {
+            return false;
+        }
+        rResult = emit(Function2, arg1, arg2, function);
+    }
+    else
+    {
+        rResult = emit(Function1, arg1, arg1, function);
+    }
+    return accept(')') || fail("Missing ) after arguments to "+name);
+}
+
+bool NumHopProgram::parseName(HString &rName)
+{
+    const char c = peek();
+    if (!std::isalpha(static_cast<unsigned char>(c)) && c != '_')
+    {
+        return false;
+    }
+    const size_t start = mPos;
+    while (mPos < mpExpression->size())
+    {
+        const char n = (*mpExpression)[mPos];
+        if (!std::isalnum(static_cast<unsigned char>(n)) && n != '_' && n != '.')
+        {
+            break;
+        }
+        ++mPos;
+    }
+    rName = mpExpression->substr(start, mPos-start).c_str();
+    return true;
+}
+
+bool NumHopProgram::parseNumber(double &rValue)
+{
+    const char *pStart = mpExpression->c_str()+mPos;
+    char *pEnd;
+    rValue = std::strtod(pStart, &pEnd);
+    if (pEnd == pStart)
+    {
+        return fail("Invalid number");
+    }
+    mPos += size_t(pEnd-pStart);
+    return true;
+}
+
+bool NumHopProgram::readVariable(const HString &rName, Operand &rResult)
+{
+    rResult = Operand();
+    double *pData = mpResolver->getDataPtr(rName);
+    if (pData)
+    {
+        rResult.isConstant = false;
+        std::vector<double*>::iterator it = std::find(mDataPtrs.begin(), mDataPtrs.end(), pData);
+        if (it == mDataPtrs.end())
+        {
+            it = mDataPtrs.insert(mDataPtrs.end(), pData);
+        }
+        rResult.reg = -1-int(it-mDataPtrs.begin());
+        return true;
+    }
+
+    const std::string name = rName.c_str();
+    std::map<std::string, double>::const_iterator cit = mLocalConstants.find(name);
+    if (cit != mLocalConstants.end())
+    {
+        rResult.value = cit->second;
+        return true;
+    }
+    std::map<std::string, int>::const_iterator rit = mLocalRegisters.find(name);
+    if (rit != mLocalRegisters.end())
+    {
+        rResult.isConstant = false;
+        rResult.reg = rit->second;
+        return true;
+    }
+
+    // Anything else must be a parameter, its value can not change during evaluation
+    if (mpResolver->getConstantValue(rName, rResult.value))
+    {
+        mExternalNames.insert(name);
+        return true;
+    }
+    return fail("Unknown variable: "+rName);
+}
+
+bool NumHopProgram::assignVariable(const HString &rName, const Operand &rValue, Operand &rResult)
+{
+    double *pData = mpResolver->getDataPtr(rName);
+    if (!pData)
+    {
+        if (rName.find('.') != HString::npos)
+        {
+            return fail("Assigning "+rName+" is not supported by the compiler");
+        }
+        if (mExternalNames.count(rName.c_str()))
+        {
+            return fail(rName+" is used both as a parameter and as a local variable");
+        }
+    }
+
+    // Local variables that are assigned constants do not need a register
+    const std::string name = rName.c_str();
+    if (!pData && rValue.isConstant)
+    {
+        mLocalConstants[name] = rValue.value;
+        mLocalRegisters.erase(name);
+        rResult = rValue;
+        return true;
+    }
+
+    Operand target;
+    target.isConstant = false;
+    if (pData)
+    {
+        readVariable(rName, target);
+    }
+    else if (mLocalRegisters.count(name))
+    {
+        target.reg = mLocalRegisters[name];
+    }
+    else
+    {
+        // Not yet assigned (or was constant), give the local variable a register of its own
+        mLocalConstants.erase(name);
+        target.reg = int(mInitialRegisters.size());
+        mInitialRegisters.push_back(0);
+        mLocalRegisters[name] = target.reg;
+    }
+
+    // Let the instruction computing the value write directly to the target, if the value is a temporary
+    bool isTemporary = !rValue.isConstant && rValue.reg >= 0 && !mCompiledInstructions.empty() &&
+                       mCompiledInstructions.back().dst == rValue.reg;
+    for (std::map<std::string, int>::const_iterator it=mLocalRegisters.begin(); isTemporary && it!=mLocalRegisters.end(); ++it)
+    {
+        isTemporary = (it->second != rValue.reg);
+    }
+    if (isTemporary)
+    {
+        mCompiledInstructions.back().dst = target.reg;
+    }
+    else
+    {
+        CompiledInstruction copy;
+        copy.op = Copy;
+        copy.dst = target.reg;
+        copy.a = copy.b = toRegister(rValue);
+        copy.function = 0;
+        mCompiledInstructions.push_back(copy);
+    }
+    rResult = target;
+    return true;
+}
+
+NumHopProgram::Operand NumHopProgram::emit(const OpCodeT op, const Operand &rA, const Operand &rB, const size_t function)
+{
+    Operand result;
+    if (rA.isConstant && rB.isConstant)
+    {
+        result.value = evalOperation(op, rA.value, rB.value, function);
+        return result;
+    }
+
+    CompiledInstruction instruction;
+    instruction.op = op;
+    instruction.a = toRegister(rA);
+    instruction.b = toRegister(rB);
+    instruction.function = function;
+    instruction.dst = int(mInitialRegisters.size());
+    mInitialRegisters.push_back(0);
+    mCompiledInstructions.push_back(instruction);
+
+    result.isConstant = false;
+    result.reg = instruction.dst;
+    return result;
+}
+
+//! @brief Get the register of an operand, constants are given a register holding their value
+int NumHopProgram::toRegister(const Operand &rOperand)
+{
+    if (!rOperand.isConstant)
+    {
+        return rOperand.reg;
+    }
+    mInitialRegisters.push_back(rOperand.value);
+    return int(mInitialRegisters.size())-1;
+}
+
+//! @brief Skip white space and return the next character, or '\0' at the end of the expression
+char NumHopProgram::peek()
+{
+    while (mPos < mpExpression->size() && std::isspace(static_cast<unsigned char>((*mpExpression)[mPos])))
+    {
+        ++mPos;
+    }
+    return (mPos < mpExpression->size()) ? (*mpExpression)[mPos] : '\0';
+}
+
+bool NumHopProgram::accept(const char c)
+{
+    if (peek() == c)
+    {
+        ++mPos;
+        return true;
+    }
+    return false;
+}
+
+bool NumHopProgram::fail(const HString &rError)
+{
+    mLastError = rError+" in: "+HString(mpExpression->c_str());
+    return false;
+}
@@ -27,6 +27,7 @@
 #define _USE_MATH_DEFINES
 #include <cmath>
 #include "CoreUtilities/NumHopHelper.h"
+#include "CoreUtilities/NumHopBytecode.h"
 #include "ComponentSystem.h"
 #include "CoreUtilities/StringUtilities.h"
 #include "ComponentUtilities/num2string.hpp"
@@ -74,6 +75,16 @@ public:
         return -1;
     }
 
+    double *getRegisteredPtr(const HString &name) const
+    {
+        std::map<HString, double*>::const_iterator it = mRegisteredDataPtrs.find(name.c_str());
+        if (it != mRegisteredDataPtrs.end())
+        {
+            return it->second;
+        }
+        return 0;
+    }
+
     void registerDataPointer(const HString &name, double *pData)
     {
         mRegisteredDataPtrs.insert(std::pair<HString,double*>(name, pData));
@@ -309,6 +320,36 @@ private:
     Component *mpComponent;
 };
 
+//! @brief Resolves names for the bytecode compiler, registered data pointers are live values, everything else is a constant
+class HopsanCompileResolver : public NumHopSymbolResolver
+{
+public:
+    HopsanCompileResolver(HopsanParameterAccessBase *pHopsanAccess) : mpHopsanAccess(pHopsanAccess) {}
+
+    double *getDataPtr(const HString &rName)
+    {
+        return mpHopsanAccess ? mpHopsanAccess->getRegisteredPtr(rName) : 0;
+    }
+
+    bool getConstantValue(const HString &rName, double &rValue)
+    {
+        if (rName == "pi")
+        {
+            rValue = M_PI;
+            return true;
+        }
+        bool found = false;
+        if (mpHopsanAccess)
+        {
+            rValue = mpHopsanAccess->externalValue(rName.c_str(), found);
+        }
+        return found;
+    }
+
+private:
+    HopsanParameterAccessBase *mpHopsanAccess;
+};
+
 namespace hopsan {
 
 class NumHopHelperPrivate
@@ -318,6 +359,7 @@ public:
     numhop::VariableStorage mVarStorage;
     HopsanParameterAccessBase *mpHopsanAccess;
     std::list<numhop::Expression> mExpressions;
+    NumHopProgram mProgram;
 };
 
 }
@@ -346,6 +388,7 @@ void NumHopHelper::setSystem(ComponentSystem *pSystem)
 {
     mpSystem = pSystem;
 
+    mpPrivate->mProgram.clear();
     if (mpPrivate->mpHopsanAccess)
     {
         delete mpPrivate->mpHopsanAccess;
@@ -359,6 +402,7 @@ void NumHopHelper::setComponent(Component *pComponent)
 {
     mpComponent = pComponent;
 
+    mpPrivate->mProgram.clear();
     if (mpPrivate->mpHopsanAccess)
     {
         delete mpPrivate->mpHopsanAccess;
@@ -421,6 +465,40 @@ bool NumHopHelper::interpretNumHopScript(const HString &script, bool doPrintOutp
     return allOK;
 }
 
+//! @brief Compile a script to bytecode, for fast repeated evaluation with evalCompiled()
+//! @details Registered data pointers are read and written on every evaluation, any other external value (parameters)
+//! is resolved once here. Scripts that can not be compiled (for example if they assign parameters) must be evaluated
+//! with interpretNumHopScript() and eval() instead.
+//! @param [in] script The script to compile
+//! @param [out] rOutput The reason if compilation failed
+//! @returns True if the script was compiled
+bool NumHopHelper::compileNumHopScript(const HString &script, HString &rOutput)
+{
+    list<string> rows;
+    numhop::extractExpressionRows(script.c_str(), '#', rows);
+    std::vector<string> expressions(rows.begin(), rows.end());
+
+    HopsanCompileResolver resolver(mpPrivate->mpHopsanAccess);
+    if (!mpPrivate->mProgram.compile(expressions, resolver))
+    {
+        rOutput = mpPrivate->mProgram.getLastError();
+        return false;
+    }
+    return true;
+}
+
+bool NumHopHelper::isCompiled() const
+{
+    return mpPrivate->mProgram.isCompiled();
+}
+
+//! @brief Evaluate the script compiled by compileNumHopScript()
+//! @returns The value of the last expression
+double NumHopHelper::evalCompiled()
+{
+    return mpPrivate->mProgram.eval();
+}
+
 bool NumHopHelper::eval(double &rValue, bool doPrintOutput, HString &rOutput)
 {
     bool allOK=!mpPrivate->mExpressions.empty();
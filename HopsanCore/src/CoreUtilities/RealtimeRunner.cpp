@@ -0,0 +1,639 @@
+/*-----------------------------------------------------------------------------
+
+ Copyright 2017 Hopsan Group
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+
+ The full license is available in the file LICENSE.
+ For details about the 'Hopsan Group' or information about Authors and
+ Contributors see the HOPSANGROUP and AUTHORS files that are located in
+ the Hopsan source code root directory.
+
+-----------------------------------------------------------------------------*/
+
+
+
+//!
+//! @file   RealtimeRunner.cpp
+//!
+//! @brief Contains the real-time runner, that simulates a system in step with the wall clock, e.g. for hardware-in-the-loop
+//!
+//$Id$
+
+#include "CoreUtilities/RealtimeRunner.h"
+
+#if defined(HOPSANCORE_USEMULTITHREADING)
+
+#include "ComponentSystem.h"
+#include "Port.h"
+
+#include <cmath>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+using namespace hopsan;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+inline double toSeconds(const Clock::duration &rDuration)
+{
+    return std::chrono::duration<double>(rDuration).count();
+}
+
+inline Clock::duration fromSeconds(const double seconds)
+{
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+//! @brief Count a value in a histogram, values above the last bin are counted in the last bin
+inline void addToHistogram(std::vector<size_t> &rHistogram, const double binWidth, const double value)
+{
+    if (rHistogram.empty())
+    {
+        return;
+    }
+    size_t bin = rHistogram.size()-1;
+    if (value < binWidth*double(bin))
+    {
+        bin = (value > 0) ? std::min(size_t(value/binWidth), bin) : 0;
+    }
+    ++rHistogram[bin];
+}
+
+}
+
+RealtimeStatistics::RealtimeStatistics()
+{
+    numSteps = 0;
+    numOverruns = 0;
+    maxConsecutiveOverruns = 0;
+    maxOverrun = 0;
+    maxLatency = 0;
+    meanLatency = 0;
+    maxJitter = 0;
+    maxExecutionTime = 0;
+    meanExecutionTime = 0;
+    numInputFrames = 0;
+    numDroppedOutputFrames = 0;
+    histogramBinWidth = 0;
+}
+
+//! @brief Constructor
+//! @param [in] pSystem The system to simulate, it must be initialized before a run is started
+RealtimeRunner::RealtimeRunner(ComponentSystem *pSystem)
+{
+    mpSystem = pSystem;
+    mRealTimeFactor = 1;
+    mCpu = -1;
+    mPriority = 0;
+    mLockMemory = false;
+    mRequireRealtimeSettings = false;
+    mSpinTime = 100e-6;
+    mOverrunPolicy = CatchUp;
+    mHistogramBinWidth = 10e-6;
+    mNumHistogramBins = 100;
+    mInputQueueCapacity = 1024;
+    mOutputQueueCapacity = 65536;
+    mOutputDecimation = 1;
+    mRunning.store(false);
+    mStop.store(false);
+    mNumSteps.store(0);
+    mNumOverruns.store(0);
+    mSuccess = true;
+}
+
+//! @brief Destructor, stops the run and waits for the simulation thread
+RealtimeRunner::~RealtimeRunner()
+{
+    stop();
+    wait();
+}
+
+//! @brief Set the real-time factor, the simulated time per wall clock time (default 1)
+void RealtimeRunner::setRealTimeFactor(const double factor)
+{
+    mRealTimeFactor = factor;
+}
+
+//! @brief Pin the simulation thread to a CPU (Linux only), -1 (default) means no pinning
+void RealtimeRunner::setCpuAffinity(const int cpu)
+{
+    mCpu = cpu;
+}
+
+//! @brief Give the simulation thread a SCHED_FIFO priority (Linux only, 1-99), 0 (default) keeps normal scheduling
+void RealtimeRunner::setRealtimePriority(const int priority)
+{
+    mPriority = priority;
+}
+
+//! @brief Lock all memory of the process with mlockall() during the run, to avoid page faults (Linux only)
+void RealtimeRunner::setLockMemory(const bool lock)
+{
+    mLockMemory = lock;
+}
+
+//! @brief If required, a run is aborted if the CPU affinity, priority or memory locking can not be applied, else a warning is given
+void RealtimeRunner::setRequireRealtimeSettings(const bool require)
+{
+    mRequireRealtimeSettings = require;
+}
+
+//! @brief Set the final part of the time to the start of each step that is spent spinning instead of sleeping (default 100 us)
+//! @details Should be larger than the typical wake-up latency of the operating system. Zero means only sleeping.
+void RealtimeRunner::setSpinTime(const double spinTime)
+{
+    mSpinTime = std::max(spinTime, 0.0);
+}
+
+//! @brief Set what to do after an overrun, catch up (default) or move the schedule
+void RealtimeRunner::setOverrunPolicy(const OverrunPolicyT policy)
+{
+    mOverrunPolicy = policy;
+}
+
+//! @brief Set the bin width [s] and number of bins of the latency and jitter histograms (default 10 us and 100 bins)
+void RealtimeRunner::setHistogram(const double binWidth, const size_t numBins)
+{
+    mHistogramBinWidth = binWidth;
+    mNumHistogramBins = numBins;
+}
+
+//! @brief Set the number of frames that the input and output queues can hold (rounded up to a power of two)
+void RealtimeRunner::setQueueCapacities(const size_t numInputFrames, const size_t numOutputFrames)
+{
+    mInputQueueCapacity = std::max(numInputFrames, size_t(1));
+    mOutputQueueCapacity = std::max(numOutputFrames, size_t(1));
+    createQueues();
+}
+
+//! @brief Set how often output frames are queued, every decimation:th step (default 1)
+void RealtimeRunner::setOutputDecimation(const size_t decimation)
+{
+    mOutputDecimation = std::max(decimation, size_t(1));
+}
+
+//! @brief Add an input variable, written with the newest input frame before each step
+//! @param [in] rComponentName The name of the component
+//! @param [in] rPortName The name of the port
+//! @param [in] rVariableName The name of the variable, e.g. "Value"
+//! @returns False if the variable could not be found (see getLastError())
+bool RealtimeRunner::addInput(const HString &rComponentName, const HString &rPortName, const HString &rVariableName)
+{
+    if (!findVariable(rComponentName, rPortName, rVariableName))
+    {
+        return false;
+    }
+    Variable variable;
+    variable.componentName = rComponentName;
+    variable.portName = rPortName;
+    variable.variableName = rVariableName;
+    variable.pVariable = 0;
+    mInputs.push_back(variable);
+    createQueues();
+    return true;
+}
+
+//! @brief Add an output variable, queued after each step
+//! @param [in] rComponentName The name of the component
+//! @param [in] rPortName The name of the port
+//! @param [in] rVariableName The name of the variable, e.g. "Value"
+//! @returns False if the variable could not be found (see getLastError())
+bool RealtimeRunner::addOutput(const HString &rComponentName, const HString &rPortName, const HString &rVariableName)
+{
+    if (!findVariable(rComponentName, rPortName, rVariableName))
+    {
+        return false;
+    }
+    Variable variable;
+    variable.componentName = rComponentName;
+    variable.portName = rPortName;
+    variable.variableName = rVariableName;
+    variable.pVariable = 0;
+    mOutputs.push_back(variable);
+    createQueues();
+    return true;
+}
+
+//! @brief Add an input variable by pointer, the pointer must remain valid during runs
+void RealtimeRunner::addInput(double *pVariable)
+{
+    Variable variable;
+    variable.pVariable = pVariable;
+    mInputs.push_back(variable);
+    createQueues();
+}
+
+//! @brief Add an output variable by pointer, the pointer must remain valid during runs
+void RealtimeRunner::addOutput(double *pVariable)
+{
+    Variable variable;
+    variable.pVariable = pVariable;
+    mOutputs.push_back(variable);
+    createQueues();
+}
+
+size_t RealtimeRunner::getNumInputs() const
+{
+    return mInputs.size();
+}
+
+size_t RealtimeRunner::getNumOutputs() const
+{
+    return mOutputs.size();
+}
+
+//! @brief Queue an input frame (from one producer thread)
+//! @param [in] pValues One value for each input, in the order they were added
+//! @returns False if the input queue is full, or if there are no inputs
+bool RealtimeRunner::pushInputs(const double *pValues)
+{
+    if (!mpInputQueue)
+    {
+        return false;
+    }
+    return mpInputQueue->push(pValues);
+}
+
+//! @brief Take the oldest output frame (from one consumer thread)
+//! @param [out] rTime The simulation time of the frame
+//! @param [out] pValues One value for each output, in the order they were added
+//! @returns False if the output queue is empty, or if there are no outputs
+bool RealtimeRunner::popOutputs(double &rTime, double *pValues)
+{
+    if (!mpOutputQueue || !mpOutputQueue->pop(mPopFrame.data()))
+    {
+        return false;
+    }
+    rTime = mPopFrame[0];
+    std::copy(mPopFrame.begin()+1, mPopFrame.end(), pValues);
+    return true;
+}
+
+//! @brief Simulate in real time in the calling thread, until the stop time or until stopped
+//! @param [in] stopTime The simulation time to stop at, may be infinite
+//! @returns False if the run could not be started (see getLastError())
+bool RealtimeRunner::run(const double stopTime)
+{
+    if (mRunning.load())
+    {
+        mLastError = "The real-time runner is already running";
+        return false;
+    }
+    mStop.store(false);
+    mRunning.store(true);
+    mSuccess = simulateInRealtime(stopTime);
+    mRunning.store(false);
+    return mSuccess;
+}
+
+//! @brief Start simulating in real time in a new thread, until the stop time or until stopped
+//! @param [in] stopTime The simulation time to stop at, may be infinite
+//! @returns False if already running
+bool RealtimeRunner::start(const double stopTime)
+{
+    if (mRunning.load())
+    {
+        mLastError = "The real-time runner is already running";
+        return false;
+    }
+    wait();
+    mStop.store(false);
+    mRunning.store(true);
+    mThread = std::thread(&RealtimeRunner::runThread, this, stopTime);
+    return true;
+}
+
+//! @brief Stop the run, after the current step
+void RealtimeRunner::stop()
+{
+    mStop.store(true);
+}
+
+//! @brief Wait for a run started with start() to finish
+//! @returns False if the run failed (see getLastError())
+bool RealtimeRunner::wait()
+{
+    if (mThread.joinable())
+    {
+        mThread.join();
+    }
+    return mSuccess;
+}
+
+bool RealtimeRunner::isRunning() const
+{
+    return mRunning.load();
+}
+
+//! @brief Returns the number of steps taken in the current or last run, may be called while running
+size_t RealtimeRunner::getNumSteps() const
+{
+    return mNumSteps.load(std::memory_order_relaxed);
+}
+
+//! @brief Returns the number of overruns in the current or last run, may be called while running
+size_t RealtimeRunner::getNumOverruns() const
+{
+    return mNumOverruns.load(std::memory_order_relaxed);
+}
+
+//! @brief Returns the statistics of the last run, must not be called while running
+const RealtimeStatistics &RealtimeRunner::getStatistics() const
+{
+    return mStatistics;
+}
+
+const HString &RealtimeRunner::getLastError() const
+{
+    return mLastError;
+}
+
+double *RealtimeRunner::findVariable(const HString &rComponentName, const HString &rPortName, const HString &rVariableName)
+{
+    Component *pComponent = mpSystem->getSubComponent(rComponentName);
+    if (!pComponent)
+    {
+        mLastError = "No component named: "+rComponentName;
+        return 0;
+    }
+    Port *pPort = pComponent->getPort(rPortName);
+    if (!pPort)
+    {
+        mLastError = "Component: "+rComponentName+" has no port named: "+rPortName;
+        return 0;
+    }
+    const int dataId = pPort->getNodeDataIdFromName(rVariableName);
+    if (dataId < 0)
+    {
+        mLastError = "Port: "+rComponentName+"#"+rPortName+" has no variable named: "+rVariableName;
+        return 0;
+    }
+    return pPort->getNodeDataPtr(size_t(dataId));
+}
+
+//! @brief Resolve the variables given by name, node data may have moved since they were added
+bool RealtimeRunner::resolveVariables(std::vector<Variable> &rVariables)
+{
+    for (size_t i=0; i<rVariables.size(); ++i)
+    {
+        if (!rVariables[i].componentName.empty())
+        {
+            rVariables[i].pVariable = findVariable(rVariables[i].componentName, rVariables[i].portName, rVariables[i].variableName);
+            if (!rVariables[i].pVariable)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void RealtimeRunner::createQueues()
+{
+    mpInputQueue.reset(mInputs.empty() ? 0 : new SpscRingBuffer(mInputQueueCapacity, mInputs.size()));
+    mInputFrame.assign(mInputs.size(), 0);
+    mpOutputQueue.reset(mOutputs.empty() ? 0 : new SpscRingBuffer(mOutputQueueCapacity, mOutputs.size()+1));
+    mOutputFrame.assign(mOutputs.size()+1, 0);
+    mPopFrame.assign(mOutputs.size()+1, 0);
+}
+
+//! @brief Apply the CPU affinity and priority to the calling thread, and lock the memory
+//! @param [out] rLockedMemory True if the memory was locked
+//! @returns False if any setting could not be applied (see getLastError())
+bool RealtimeRunner::applyRealtimeSettings(bool &rLockedMemory)
+{
+    rLockedMemory = false;
+    HString errors;
+#if defined(__linux__)
+    if (mLockMemory)
+    {
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0)
+        {
+            rLockedMemory = true;
+        }
+        else
+        {
+            errors += HString("Could not lock memory: ")+strerror(errno)+". ";
+        }
+    }
+    if (mCpu >= 0)
+    {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        int rc = EINVAL;
+        if (mCpu < CPU_SETSIZE)
+        {
+            CPU_SET(mCpu, &cpuSet);
+            rc = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+        }
+        if (rc != 0)
+        {
+            errors += "Could not pin the simulation thread to CPU "+HString(mCpu)+": "+strerror(rc)+". ";
+        }
+    }
+    if (mPriority > 0)
+    {
+        sched_param param;
+        param.sched_priority = mPriority;
+        const int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (rc != 0)
+        {
+            errors += "Could not set SCHED_FIFO priority "+HString(mPriority)+": "+strerror(rc)+". ";
+        }
+    }
+#else
+    if (mLockMemory || (mCpu >= 0) || (mPriority > 0))
+    {
+        errors = "CPU affinity, real-time priority and memory locking are only supported on Linux. ";
+    }
+#endif
+    if (!errors.empty())
+    {
+        mLastError = errors;
+        return false;
+    }
+    return true;
+}
+
+//! @brief The real-time simulation loop
+//! @returns False if the run could not be started
+bool RealtimeRunner::simulateInRealtime(const double stopTime)
+{
+    mStatistics = RealtimeStatistics();
+    mStatistics.histogramBinWidth = mHistogramBinWidth;
+    mStatistics.latencyHistogram.assign(mNumHistogramBins, 0);
+    mStatistics.jitterHistogram.assign(mNumHistogramBins, 0);
+    mNumSteps.store(0);
+    mNumOverruns.store(0);
+
+    const double timestep = mpSystem->getTimestep();
+    if (!(timestep > 0) || !(mRealTimeFactor > 0))
+    {
+        mLastError = "The time step and real-time factor must be positive";
+        return false;
+    }
+    if (!resolveVariables(mInputs) || !resolveVariables(mOutputs))
+    {
+        return false;
+    }
+
+    bool lockedMemory;
+    if (!applyRealtimeSettings(lockedMemory))
+    {
+        if (mRequireRealtimeSettings)
+        {
+#if defined(__linux__)
+            if (lockedMemory)
+            {
+                munlockall();
+            }
+#endif
+            return false;
+        }
+        mpSystem->addWarningMessage("Real-time settings: "+mLastError);
+    }
+
+    // The start of each step is computed from the start of the schedule, so that rounding errors do not accumulate
+    const double period = timestep/mRealTimeFactor;
+    const Clock::duration spinTime = fromSeconds(mSpinTime);
+    Clock::time_point scheduleStart = Clock::now();
+    Clock::time_point previousStepStart = scheduleStart;
+    size_t scheduleStep = 0;
+    size_t numSteps = 0;
+    size_t consecutiveOverruns = 0;
+    double sumLatency = 0;
+    double sumExecutionTime = 0;
+
+    while (!mStop.load(std::memory_order_relaxed) && !mpSystem->wasSimulationAborted() && (mpSystem->getTime() < stopTime-0.5*timestep))
+    {
+        // Sleep until shortly before the start of the step, then spin for the rest
+        const Clock::time_point release = scheduleStart + fromSeconds(double(scheduleStep)*period);
+        if (release-Clock::now() > spinTime)
+        {
+            std::this_thread::sleep_until(release-spinTime);
+        }
+        Clock::time_point stepStart = Clock::now();
+        while (stepStart < release)
+        {
+            HOPSANCORE_CPU_RELAX();
+            stepStart = Clock::now();
+        }
+
+        // Take all queued input frames, the newest one is used
+        if (mpInputQueue)
+        {
+            bool haveInput = false;
+            while (mpInputQueue->pop(mInputFrame.data()))
+            {
+                haveInput = true;
+                ++mStatistics.numInputFrames;
+            }
+            if (haveInput)
+            {
+                for (size_t i=0; i<mInputs.size(); ++i)
+                {
+                    *mInputs[i].pVariable = mInputFrame[i];
+                }
+            }
+        }
+
+        mpSystem->simulate(mpSystem->getTime()+timestep);
+        ++numSteps;
+
+        if (mpOutputQueue && (numSteps % mOutputDecimation == 0))
+        {
+            mOutputFrame[0] = mpSystem->getTime();
+            for (size_t i=0; i<mOutputs.size(); ++i)
+            {
+                mOutputFrame[i+1] = *mOutputs[i].pVariable;
+            }
+            if (!mpOutputQueue->push(mOutputFrame.data()))
+            {
+                ++mStatistics.numDroppedOutputFrames;
+            }
+        }
+
+        const Clock::time_point stepEnd = Clock::now();
+
+        // Statistics
+        const double latency = toSeconds(stepStart-release);
+        const double executionTime = toSeconds(stepEnd-stepStart);
+        sumLatency += latency;
+        sumExecutionTime += executionTime;
+        mStatistics.maxLatency = std::max(mStatistics.maxLatency, latency);
+        mStatistics.maxExecutionTime = std::max(mStatistics.maxExecutionTime, executionTime);
+        addToHistogram(mStatistics.latencyHistogram, mHistogramBinWidth, latency);
+        if (numSteps > 1)
+        {
+            const double jitter = std::fabs(toSeconds(stepStart-previousStepStart)-period);
+            mStatistics.maxJitter = std::max(mStatistics.maxJitter, jitter);
+            addToHistogram(mStatistics.jitterHistogram, mHistogramBinWidth, jitter);
+        }
+        previousStepStart = stepStart;
+
+        // Overrun if the step was not finished at the start of the next step
+        ++scheduleStep;
+        const Clock::time_point nextRelease = scheduleStart + fromSeconds(double(scheduleStep)*period);
+        if (stepEnd > nextRelease)
+        {
+            ++mStatistics.numOverruns;
+            ++consecutiveOverruns;
+            mStatistics.maxConsecutiveOverruns = std::max(mStatistics.maxConsecutiveOverruns, consecutiveOverruns);
+            mStatistics.maxOverrun = std::max(mStatistics.maxOverrun, toSeconds(stepEnd-nextRelease));
+            mNumOverruns.store(mStatistics.numOverruns, std::memory_order_relaxed);
+            if (mOverrunPolicy == Resynchronize)
+            {
+                // Restart the schedule, the next step starts directly
+                scheduleStart = stepEnd;
+                scheduleStep = 0;
+            }
+        }
+        else
+        {
+            consecutiveOverruns = 0;
+        }
+        mNumSteps.store(numSteps, std::memory_order_relaxed);
+    }
+
+    mStatistics.numSteps = numSteps;
+    if (numSteps > 0)
+    {
+        mStatistics.meanLatency = sumLatency/double(numSteps);
+        mStatistics.meanExecutionTime = sumExecutionTime/double(numSteps);
+    }
+
+#if defined(__linux__)
+    if (lockedMemory)
+    {
+        munlockall();
+    }
+#endif
+    return true;
+}
+
+void RealtimeRunner::runThread(const double stopTime)
+{
+    mSuccess = simulateInRealtime(stopTime);
+    mRunning.store(false);
+}
+
+#endif // HOPSANCORE_USEMULTITHREADING
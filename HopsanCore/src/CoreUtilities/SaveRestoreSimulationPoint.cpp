@@ -31,37 +31,70 @@
 #include <vector>
 #include <fstream>
 #include <cstring>
+#include <stdint.h>
 
 using namespace hopsan;
 
 /*
+ * File head (format version >= 2, files without it are version 1)
+ *
+ * DataIdentifier   FormatVersion
+ * 2-byte           4-byte
+ *
  * Port head
  *
  * DataIdentifier   FullNameLength  NumDataElements (double)
- * 2-byte           2-byte          2-byte
+ * 2-byte           4-byte          4-byte              (2-byte lengths in version 1)
  *
  *
  *
  * */
 
+#define FORMATIDENTIFIER 0x01
 #define TIMEIDENTIFIER 0x02
 #define PORTIDENTIFIER 0x03
 
+#define SIMULATIONPOINTFORMATVERSION 2
+
+void writeIdentifier(uint16_t identifier, std::ofstream &rFile)
+{
+    rFile.write(reinterpret_cast<char*>(&identifier), sizeof(uint16_t));
+}
+
+void writeLength(size_t length, std::ofstream &rFile)
+{
+    uint32_t length32 = uint32_t(length);
+    rFile.write(reinterpret_cast<char*>(&length32), sizeof(uint32_t));
+}
+
+size_t readLength(std::ifstream &rFile, const int formatVersion)
+{
+    // Version 1 used 2-byte length fields, limiting names to 65535 characters
+    if (formatVersion < 2)
+    {
+        uint16_t length16=0;
+        rFile.read(reinterpret_cast<char*>(&length16), sizeof(uint16_t));
+        return length16;
+    }
+    uint32_t length32=0;
+    rFile.read(reinterpret_cast<char*>(&length32), sizeof(uint32_t));
+    return length32;
+}
+
 void writePortData(Port *pPort, const HString &namePrefix, std::ofstream &rFile)
 {
     // Generate full name
     HString fullName = namePrefix+pPort->getName();
-    std::vector<double> *pDataVector = pPort->getDataVectorPtr();
+    NodeDataVector *pDataVector = pPort->getDataVectorPtr();
     // OK great, if we have a data vector, lets dump it to file
     if (pDataVector)
     {
         // Write port identifier
-        size_t identifier = PORTIDENTIFIER;
-        rFile.write(reinterpret_cast<char*>(&identifier), 2);
+        writeIdentifier(PORTIDENTIFIER, rFile);
         size_t namelen = fullName.size();
-        rFile.write(reinterpret_cast<char*>(&namelen), 2);
+        writeLength(namelen, rFile);
         size_t datalen = pDataVector->size();
-        rFile.write(reinterpret_cast<char*>(&datalen), 2);
+        writeLength(datalen, rFile);
         rFile.write(fullName.c_str(), namelen);
         rFile.write(reinterpret_cast<char*>(pDataVector->data()), datalen*sizeof(double));
     }
@@ -69,25 +102,34 @@ void writePortData(Port *pPort, const HString &namePrefix, std::ofstream &rFile)
 
 void writeTimeData(double time, std::ofstream &rFile)
 {
-    // Write port identifier
-    size_t identifier = TIMEIDENTIFIER;
-    rFile.write(reinterpret_cast<char*>(&identifier), 2);
+    // Write time identifier
+    writeIdentifier(TIMEIDENTIFIER, rFile);
     rFile.write(reinterpret_cast<char*>(&time), sizeof(double));
 }
 
 size_t readIdentifier(std::ifstream &rFile)
 {
-    size_t identifier=0;
-    rFile.read(reinterpret_cast<char*>(&identifier), 2);
+    uint16_t identifier=0;
+    rFile.read(reinterpret_cast<char*>(&identifier), sizeof(uint16_t));
     return identifier;
 }
 
-void readPortData(std::ifstream &rFile, ComponentSystem *pRootSystem)
+int readFormatVersion(std::ifstream &rFile)
+{
+    uint32_t version=0;
+    rFile.read(reinterpret_cast<char*>(&version), sizeof(uint32_t));
+    return int(version);
+}
+
+void readPortData(std::ifstream &rFile, ComponentSystem *pRootSystem, const int formatVersion)
 {
     // Read rest of header
-    size_t namelength=0, datalength=0;
-    rFile.read(reinterpret_cast<char*>(&namelength), 2);
-    rFile.read(reinterpret_cast<char*>(&datalength), 2);
+    size_t namelength = readLength(rFile, formatVersion);
+    size_t datalength = readLength(rFile, formatVersion);
+    if (!rFile.good())
+    {
+        return;
+    }
 
     // Read full name
     char *pNameBuffer = new char[namelength+1];
@@ -100,6 +142,11 @@ void readPortData(std::ifstream &rFile, ComponentSystem *pRootSystem)
     // Read data
     double *pDataBuffer = new double[datalength];
     rFile.read(reinterpret_cast<char*>(pDataBuffer), datalength*sizeof(double));
+    if (!rFile.good())
+    {
+        delete[] pDataBuffer;
+        return;
+    }
 
     // Parse fullName and find port to write into
     ComponentSystem *pSystem=pRootSystem;
@@ -116,9 +163,9 @@ void readPortData(std::ifstream &rFile, ComponentSystem *pRootSystem)
             if (pComponent)
             {
                 Port* pPort = pComponent->getPort(pname);
-                if (pPort)
+                NodeDataVector *pData = pPort ? pPort->getDataVectorPtr() : 0;
+                if (pData)
                 {
-                    std::vector<double> *pData = pPort->getDataVectorPtr();
                     for (size_t d=0; d<std::min(datalength, pData->size()); ++d)
                     {
                         pData->at(d) = pDataBuffer[d];
@@ -145,7 +192,7 @@ void readPortData(std::ifstream &rFile, ComponentSystem *pRootSystem)
         }
     }
 
-    //! @todo need lots of error handling in code above
+    delete[] pDataBuffer;
 }
 
 double readTimeData(std::ifstream &rFile)
@@ -183,9 +230,11 @@ void saveSimulationPointInternal(ComponentSystem *pRootSystem, const HString &na
 void hopsan::saveSimulationPoint(HString fileName, ComponentSystem *pRootSystem)
 {
     std::ofstream file;
-    file.open(fileName.c_str());
+    file.open(fileName.c_str(), std::ios::out | std::ios::binary);
     if (file.is_open())
     {
+        writeIdentifier(FORMATIDENTIFIER, file);
+        writeLength(SIMULATIONPOINTFORMATVERSION, file);
         saveSimulationPointInternal(pRootSystem, "/", file);
     }
     file.close();
@@ -194,22 +243,33 @@ void hopsan::saveSimulationPoint(HString fileName, ComponentSystem *pRootSystem)
 void hopsan::restoreSimulationPoint(HString fileName, ComponentSystem *pRootSystem, double &rTimeOffset)
 {
     std::ifstream file;
-    file.open(fileName.c_str());
+    file.open(fileName.c_str(), std::ios::in | std::ios::binary);
     if (file.is_open())
     {
-        while (!file.eof())
+        // Files without a format identifier were written with version 1
+        int formatVersion=1;
+        while (file.good())
         {
             // Read identifier from next package
             size_t id = readIdentifier(file);
+            if (!file.good())
+            {
+                break;
+            }
             switch (id)
             {
+            case FORMATIDENTIFIER:
+                formatVersion = readFormatVersion(file);
+                break;
             case TIMEIDENTIFIER:
                 rTimeOffset = readTimeData(file);
                 break;
             case PORTIDENTIFIER:
-                readPortData(file, pRootSystem);
+                readPortData(file, pRootSystem, formatVersion);
                 break;
             default:
+                // Unknown package, the rest of the file can not be parsed
+                file.setstate(std::ios::failbit);
                 break;
             }
         }
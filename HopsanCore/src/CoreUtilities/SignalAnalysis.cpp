@@ -0,0 +1,915 @@
+/*-----------------------------------------------------------------------------
+
+ Copyright 2017 Hopsan Group
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+
+ The full license is available in the file LICENSE.
+ For details about the 'Hopsan Group' or information about Authors and
+ Contributors see the HOPSANGROUP and AUTHORS files that are located in
+ the Hopsan source code root directory.
+
+-----------------------------------------------------------------------------*/
+
+
+//!
+//! @file   SignalAnalysis.cpp
+//!
+//! @brief Contains signal analysis utilities: fast Fourier transforms, spectral estimation, transfer functions, RMS and decimation
+//!
+//$Id$
+
+#include "CoreUtilities/SignalAnalysis.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace hopsan;
+
+namespace {
+
+typedef std::complex<double> ComplexT;
+
+const double pi = 3.14159265358979323846;
+
+//! @brief The largest prime factor handled by the generic mixed-radix kernel, larger factors use Bluestein's algorithm
+const size_t maxGenericRadix = 64;
+
+//! @brief Complex multiplication, without the inf/nan special case handling of std::complex that prevents vectorization
+inline ComplexT mul(const ComplexT &a, const ComplexT &b)
+{
+    return ComplexT(a.real()*b.real()-a.imag()*b.imag(), a.real()*b.imag()+a.imag()*b.real());
+}
+
+//! @brief Multiplication by -i
+inline ComplexT mulMinusI(const ComplexT &a)
+{
+    return ComplexT(a.imag(), -a.real());
+}
+
+//! @brief The root of unity exp(-2*pi*i*k/n), the exponent is reduced first to keep the precision for large n
+inline ComplexT unitRoot(const size_t k, const size_t n)
+{
+    const double angle = -2.0*pi*double(k%n)/double(n);
+    return ComplexT(std::cos(angle), std::sin(angle));
+}
+
+//! @brief Split n into radix 4, 2 and odd prime factors
+//! @returns False if n has a prime factor larger than maxGenericRadix
+bool factorize(size_t n, std::vector<size_t> &rFactors)
+{
+    rFactors.clear();
+    while (n%4 == 0)
+    {
+        rFactors.push_back(4);
+        n /= 4;
+    }
+    if (n%2 == 0)
+    {
+        rFactors.push_back(2);
+        n /= 2;
+    }
+    for (size_t f=3; f<=maxGenericRadix && n>1; f+=2)
+    {
+        while (n%f == 0)
+        {
+            rFactors.push_back(f);
+            n /= f;
+        }
+    }
+    return (n == 1);
+}
+
+// The Stockham passes below compute, for each of the m butterflies p and each of the s interleaved sub transforms q,
+// the radix r DFT of x[q+s*(p+k*m)], k=0..r-1, multiply output j with the twiddle factor exp(-2*pi*i*p*j/(r*m))
+// and store it in y[q+s*(r*p+j)]
+
+void stockhamRadix2(const ComplexT *x, ComplexT *y, const size_t m, const size_t s, const ComplexT *w)
+{
+    for (size_t p=0; p<m; ++p)
+    {
+        const ComplexT w1 = w[p];
+        const ComplexT *x0 = x+s*p;
+        const ComplexT *x1 = x+s*(p+m);
+        ComplexT *y0 = y+s*(2*p);
+        ComplexT *y1 = y+s*(2*p+1);
+        for (size_t q=0; q<s; ++q)
+        {
+            const ComplexT a0 = x0[q], a1 = x1[q];
+            y0[q] = a0+a1;
+            y1[q] = mul(a0-a1, w1);
+        }
+    }
+}
+
+void stockhamRadix3(const ComplexT *x, ComplexT *y, const size_t m, const size_t s, const ComplexT *w)
+{
+    const double sin60 = 0.86602540378443864676;
+    for (size_t p=0; p<m; ++p)
+    {
+        const ComplexT w1 = w[2*p], w2 = w[2*p+1];
+        const ComplexT *x0 = x+s*p;
+        const ComplexT *x1 = x+s*(p+m);
+        const ComplexT *x2 = x+s*(p+2*m);
+        ComplexT *y0 = y+s*(3*p);
+        for (size_t q=0; q<s; ++q)
+        {
+            const ComplexT a0 = x0[q], a1 = x1[q], a2 = x2[q];
+            const ComplexT t = a0-0.5*(a1+a2);
+            const ComplexT u = mulMinusI(sin60*(a1-a2));
+            y0[q] = a0+a1+a2;
+            y0[q+s] = mul(t+u, w1);
+            y0[q+2*s] = mul(t-u, w2);
+        }
+    }
+}
+
+void stockhamRadix4(const ComplexT *x, ComplexT *y, const size_t m, const size_t s, const ComplexT *w)
+{
+    for (size_t p=0; p<m; ++p)
+    {
+        const ComplexT w1 = w[3*p], w2 = w[3*p+1], w3 = w[3*p+2];
+        const ComplexT *x0 = x+s*p;
+        const ComplexT *x1 = x+s*(p+m);
+        const ComplexT *x2 = x+s*(p+2*m);
+        const ComplexT *x3 = x+s*(p+3*m);
+        ComplexT *y0 = y+s*(4*p);
+        for (size_t q=0; q<s; ++q)
+        {
+            const ComplexT a0 = x0[q], a1 = x1[q], a2 = x2[q], a3 = x3[q];
+            const ComplexT t0 = a0+a2, t1 = a0-a2;
+            const ComplexT t2 = a1+a3, t3 = mulMinusI(a1-a3);
+            y0[q] = t0+t2;
+            y0[q+s] = mul(t1+t3, w1);
+            y0[q+2*s] = mul(t0-t2, w2);
+            y0[q+3*s] = mul(t1-t3, w3);
+        }
+    }
+}
+
+void stockhamRadix5(const ComplexT *x, ComplexT *y, const size_t m, const size_t s, const ComplexT *w)
+{
+    const double c1 = 0.30901699437494742410, c2 = -0.80901699437494742410;
+    const double s1 = 0.95105651629515357212, s2 = 0.58778525229247312917;
+    for (size_t p=0; p<m; ++p)
+    {
+        const ComplexT w1 = w[4*p], w2 = w[4*p+1], w3 = w[4*p+2], w4 = w[4*p+3];
+        const ComplexT *x0 = x+s*p;
+        const ComplexT *x1 = x+s*(p+m);
+        const ComplexT *x2 = x+s*(p+2*m);
+        const ComplexT *x3 = x+s*(p+3*m);
+        const ComplexT *x4 = x+s*(p+4*m);
+        ComplexT *y0 = y+s*(5*p);
+        for (size_t q=0; q<s; ++q)
+        {
+            const ComplexT a0 = x0[q], a1 = x1[q], a2 = x2[q], a3 = x3[q], a4 = x4[q];
+            const ComplexT b1 = a1+a4, b2 = a2+a3;
+            const ComplexT d1 = a1-a4, d2 = a2-a3;
+            const ComplexT t1 = a0+c1*b1+c2*b2;
+            const ComplexT t2 = a0+c2*b1+c1*b2;
+            const ComplexT u1 = mulMinusI(s1*d1+s2*d2);
+            const ComplexT u2 = mulMinusI(s2*d1-s1*d2);
+            y0[q] = a0+b1+b2;
+            y0[q+s] = mul(t1+u1, w1);
+            y0[q+2*s] = mul(t2+u2, w2);
+            y0[q+3*s] = mul(t2-u2, w3);
+            y0[q+4*s] = mul(t1-u1, w4);
+        }
+    }
+}
+
+void stockhamGeneric(const ComplexT *x, ComplexT *y, const size_t r, const size_t m, const size_t s, const ComplexT *w, const ComplexT *roots)
+{
+    ComplexT a[maxGenericRadix];
+    for (size_t p=0; p<m; ++p)
+    {
+        const ComplexT *wp = w+(r-1)*p;
+        for (size_t q=0; q<s; ++q)
+        {
+            for (size_t k=0; k<r; ++k)
+            {
+                a[k] = x[q+s*(p+k*m)];
+            }
+            for (size_t j=0; j<r; ++j)
+            {
+                ComplexT sum = a[0];
+                size_t jk = 0;
+                for (size_t k=1; k<r; ++k)
+                {
+                    jk += j;
+                    if (jk >= r)
+                    {
+                        jk -= r;
+                    }
+                    sum += mul(a[k], roots[jk]);
+                }
+                y[q+s*(r*p+j)] = (j == 0) ? sum : mul(sum, wp[j-1]);
+            }
+        }
+    }
+}
+
+}
+
+
+//! @brief Constructor
+//! @param [in] n The transform size
+ComplexFFT::ComplexFFT(const size_t n) : mSize(0), mpBluesteinFFT(0)
+{
+    setSize(n);
+}
+
+ComplexFFT::~ComplexFFT()
+{
+    delete mpBluesteinFFT;
+}
+
+//! @brief Set the transform size and compute the factorization and twiddle factors
+//! @param [in] n The transform size
+void ComplexFFT::setSize(const size_t n)
+{
+    if (n == mSize)
+    {
+        return;
+    }
+
+    mSize = n;
+    mStages.clear();
+    mTwiddles.clear();
+    mRoots.clear();
+    mWork.clear();
+    delete mpBluesteinFFT;
+    mpBluesteinFFT = 0;
+    mChirp.clear();
+    mChirpSpectrum.clear();
+    mBluesteinWork.clear();
+
+    // The transform of size 0 or 1 is the identity
+    if (n <= 1)
+    {
+        return;
+    }
+
+    std::vector<size_t> factors;
+    if (factorize(n, factors))
+    {
+        size_t length = n;
+        size_t stride = 1;
+        for (size_t f=0; f<factors.size(); ++f)
+        {
+            Stage stage;
+            stage.radix = factors[f];
+            stage.length = length;
+            stage.stride = stride;
+            stage.twiddleOffset = mTwiddles.size();
+            stage.rootOffset = mRoots.size();
+            mStages.push_back(stage);
+
+            const size_t m = length/stage.radix;
+            for (size_t p=0; p<m; ++p)
+            {
+                for (size_t j=1; j<stage.radix; ++j)
+                {
+                    mTwiddles.push_back(unitRoot(p*j, length));
+                }
+            }
+            if (stage.radix > 5)
+            {
+                for (size_t j=0; j<stage.radix; ++j)
+                {
+                    mRoots.push_back(unitRoot(j, stage.radix));
+                }
+            }
+
+            length = m;
+            stride *= stage.radix;
+        }
+        mWork.resize(n);
+    }
+    else
+    {
+        // Bluestein's algorithm, the transform is written as a convolution with a chirp, that is computed with a power of two transform
+        size_t m = 1;
+        while (m < 2*n-1)
+        {
+            m *= 2;
+        }
+        mpBluesteinFFT = new ComplexFFT(m);
+        mChirp.resize(n);
+        for (size_t k=0; k<n; ++k)
+        {
+            // exp(-pi*i*k^2/n)
+            mChirp[k] = unitRoot((static_cast<unsigned long long>(k)*k)%(2*n), 2*n);
+        }
+        mChirpSpectrum.assign(m, ComplexT(0,0));
+        mChirpSpectrum[0] = std::conj(mChirp[0]);
+        for (size_t k=1; k<n; ++k)
+        {
+            mChirpSpectrum[k] = std::conj(mChirp[k]);
+            mChirpSpectrum[m-k] = std::conj(mChirp[k]);
+        }
+        mpBluesteinFFT->forward(&mChirpSpectrum[0]);
+        mBluesteinWork.resize(m);
+    }
+}
+
+//! @brief Returns the transform size
+size_t ComplexFFT::size() const
+{
+    return mSize;
+}
+
+//! @brief Forward transform in place, X[k] = sum x[j]*exp(-2*pi*i*j*k/n)
+//! @param [in,out] pData Pointer to size() values
+void ComplexFFT::forward(std::complex<double> *pData)
+{
+    if (mSize <= 1)
+    {
+        return;
+    }
+    if (mpBluesteinFFT)
+    {
+        transformBluestein(pData);
+    }
+    else
+    {
+        transformStockham(pData);
+    }
+}
+
+//! @brief Inverse transform in place, without the 1/n scaling
+//! @param [in,out] pData Pointer to size() values
+void ComplexFFT::inverse(std::complex<double> *pData)
+{
+    for (size_t i=0; i<mSize; ++i)
+    {
+        pData[i] = std::conj(pData[i]);
+    }
+    forward(pData);
+    for (size_t i=0; i<mSize; ++i)
+    {
+        pData[i] = std::conj(pData[i]);
+    }
+}
+
+//! @brief Forward transform in place, the transform size is changed to the size of the vector if needed
+void ComplexFFT::forward(std::vector< std::complex<double> > &rData)
+{
+    setSize(rData.size());
+    if (!rData.empty())
+    {
+        forward(&rData[0]);
+    }
+}
+
+//! @brief Inverse transform in place without the 1/n scaling, the transform size is changed to the size of the vector if needed
+void ComplexFFT::inverse(std::vector< std::complex<double> > &rData)
+{
+    setSize(rData.size());
+    if (!rData.empty())
+    {
+        inverse(&rData[0]);
+    }
+}
+
+void ComplexFFT::transformStockham(std::complex<double> *pData)
+{
+    ComplexT *pX = pData;
+    ComplexT *pY = &mWork[0];
+    for (size_t i=0; i<mStages.size(); ++i)
+    {
+        const Stage &stage = mStages[i];
+        const size_t m = stage.length/stage.radix;
+        const ComplexT *pTwiddles = &mTwiddles[stage.twiddleOffset];
+        switch (stage.radix)
+        {
+        case 2:
+            stockhamRadix2(pX, pY, m, stage.stride, pTwiddles);
+            break;
+        case 3:
+            stockhamRadix3(pX, pY, m, stage.stride, pTwiddles);
+            break;
+        case 4:
+            stockhamRadix4(pX, pY, m, stage.stride, pTwiddles);
+            break;
+        case 5:
+            stockhamRadix5(pX, pY, m, stage.stride, pTwiddles);
+            break;
+        default:
+            stockhamGeneric(pX, pY, stage.radix, m, stage.stride, pTwiddles, &mRoots[stage.rootOffset]);
+        }
+        std::swap(pX, pY);
+    }
+    if (pX != pData)
+    {
+        std::copy(pX, pX+mSize, pData);
+    }
+}
+
+void ComplexFFT::transformBluestein(std::complex<double> *pData)
+{
+    const size_t m = mBluesteinWork.size();
+    for (size_t k=0; k<mSize; ++k)
+    {
+        mBluesteinWork[k] = mul(pData[k], mChirp[k]);
+    }
+    std::fill(mBluesteinWork.begin()+mSize, mBluesteinWork.end(), ComplexT(0,0));
+
+    mpBluesteinFFT->forward(&mBluesteinWork[0]);
+    for (size_t k=0; k<m; ++k)
+    {
+        mBluesteinWork[k] = mul(mBluesteinWork[k], mChirpSpectrum[k]);
+    }
+    mpBluesteinFFT->inverse(&mBluesteinWork[0]);
+
+    const double scale = 1.0/double(m);
+    for (size_t k=0; k<mSize; ++k)
+    {
+        pData[k] = scale*mul(mBluesteinWork[k], mChirp[k]);
+    }
+}
+
+
+//! @brief Constructor
+//! @param [in] n The number of real input values
+RealFFT::RealFFT(const size_t n) : mSize(0)
+{
+    setSize(n);
+}
+
+//! @brief Set the number of real input values
+void RealFFT::setSize(const size_t n)
+{
+    mSize = n;
+    mTwiddles.clear();
+    if (n%2 == 0)
+    {
+        const size_t half = n/2;
+        mFFT.setSize(half);
+        mWork.resize(half);
+        if (half > 0)
+        {
+            mTwiddles.resize(half+1);
+            for (size_t k=0; k<=half; ++k)
+            {
+                mTwiddles[k] = unitRoot(k, n);
+            }
+        }
+    }
+    else
+    {
+        mFFT.setSize(n);
+        mWork.resize(n);
+    }
+}
+
+//! @brief Returns the number of real input values
+size_t RealFFT::size() const
+{
+    return mSize;
+}
+
+//! @brief Returns the number of spectrum values, n/2+1
+size_t RealFFT::spectrumSize() const
+{
+    return (mSize == 0) ? 0 : mSize/2+1;
+}
+
+//! @brief Transform real data
+//! @param [in] pInput Pointer to size() real values
+//! @param [out] pSpectrum Pointer to spectrumSize() values, the transform for frequency index 0 to n/2
+void RealFFT::forward(const double *pInput, std::complex<double> *pSpectrum)
+{
+    if (mSize == 0)
+    {
+        return;
+    }
+
+    if (mSize%2 != 0)
+    {
+        for (size_t k=0; k<mSize; ++k)
+        {
+            mWork[k] = ComplexT(pInput[k], 0);
+        }
+        mFFT.forward(&mWork[0]);
+        std::copy(mWork.begin(), mWork.begin()+spectrumSize(), pSpectrum);
+        return;
+    }
+
+    // Transform even and odd samples as the real and imaginary parts of a half size complex vector,
+    // then separate the two spectra using their conjugate symmetry and combine them
+    const size_t half = mSize/2;
+    for (size_t k=0; k<half; ++k)
+    {
+        mWork[k] = ComplexT(pInput[2*k], pInput[2*k+1]);
+    }
+    mFFT.forward(&mWork[0]);
+    for (size_t k=0; k<=half; ++k)
+    {
+        const ComplexT z = mWork[(k == half) ? 0 : k];
+        const ComplexT zc = std::conj(mWork[(k == 0) ? 0 : half-k]);
+        const ComplexT even = 0.5*(z+zc);
+        const ComplexT odd = mulMinusI(0.5*(z-zc));
+        pSpectrum[k] = even+mul(mTwiddles[k], odd);
+    }
+}
+
+//! @brief Transform real data, the transform size is changed to the size of the input if needed
+void RealFFT::forward(const std::vector<double> &rInput, std::vector< std::complex<double> > &rSpectrum)
+{
+    if (rInput.size() != mSize)
+    {
+        setSize(rInput.size());
+    }
+    rSpectrum.resize(spectrumSize());
+    if (!rInput.empty())
+    {
+        forward(&rInput[0], &rSpectrum[0]);
+    }
+}
+
+
+SpectrumAnalyzer::SpectrumAnalyzer()
+    : mWindowType(Hann), mRequestedSegmentLength(0), mRequestedOverlap(0), mRemoveMean(false),
+      mSegmentLength(0), mSegmentStep(0), mNumSegments(0)
+{
+}
+
+//! @brief Set the window function applied to each segment
+void SpectrumAnalyzer::setWindow(const WindowT window)
+{
+    mWindowType = window;
+    mWindow.clear();
+}
+
+//! @brief Set the segment length and overlap in samples
+//! @param [in] length The segment length, 0 means that the whole signal is used as one segment
+//! @param [in] overlap The number of samples shared by consecutive segments, typically half the segment length
+void SpectrumAnalyzer::setSegmentLength(const size_t length, const size_t overlap)
+{
+    mRequestedSegmentLength = length;
+    mRequestedOverlap = overlap;
+}
+
+//! @brief Set whether the mean value of each segment is removed before it is windowed
+void SpectrumAnalyzer::setRemoveMean(const bool removeMean)
+{
+    mRemoveMean = removeMean;
+}
+
+//! @brief Estimate the one-sided spectrum of a signal
+//! @param [in] rData The signal samples
+//! @param [in] sampleFrequency The sample frequency in Hz
+//! @param [in] scaling The type of spectrum, power spectral density (unit^2/Hz), energy spectral density (unit^2*s/Hz),
+//! power spectrum (unit^2) or RMS spectrum (unit), the last two gives the power and RMS value of sinusoids
+//! @param [out] rFrequency The frequencies in Hz
+//! @param [out] rSpectrum The spectrum
+//! @returns False if the arguments are invalid, see getLastError()
+bool SpectrumAnalyzer::spectrum(const std::vector<double> &rData, const double sampleFrequency, const ScalingT scaling,
+                                std::vector<double> &rFrequency, std::vector<double> &rSpectrum)
+{
+    if (!prepareSegments(rData.size(), sampleFrequency))
+    {
+        return false;
+    }
+
+    const size_t numBins = mFFT.spectrumSize();
+    rSpectrum.assign(numBins, 0.0);
+    for (size_t s=0; s<mNumSegments; ++s)
+    {
+        windowSegment(&rData[s*mSegmentStep], mSegment);
+        mFFT.forward(&mSegment[0], &mSpectrum[0]);
+        for (size_t k=0; k<numBins; ++k)
+        {
+            rSpectrum[k] += mSpectrum[k].real()*mSpectrum[k].real() + mSpectrum[k].imag()*mSpectrum[k].imag();
+        }
+    }
+
+    double windowSum=0, windowSquareSum=0;
+    for (size_t i=0; i<mSegmentLength; ++i)
+    {
+        windowSum += mWindow[i];
+        windowSquareSum += mWindow[i]*mWindow[i];
+    }
+
+    double scale;
+    if (scaling == PowerSpectrum || scaling == RmsSpectrum)
+    {
+        scale = 1.0/(windowSum*windowSum*double(mNumSegments));
+    }
+    else
+    {
+        scale = 1.0/(sampleFrequency*windowSquareSum*double(mNumSegments));
+        if (scaling == EnergySpectralDensity)
+        {
+            scale *= double(rData.size())/sampleFrequency;
+        }
+    }
+
+    for (size_t k=0; k<numBins; ++k)
+    {
+        // The negative frequencies are folded onto the positive ones, DC and the Nyquist frequency have no mirror
+        const bool hasMirror = (k > 0) && (2*k != mSegmentLength);
+        rSpectrum[k] *= hasMirror ? 2*scale : scale;
+        if (scaling == RmsSpectrum)
+        {
+            rSpectrum[k] = std::sqrt(rSpectrum[k]);
+        }
+    }
+    fillFrequencies(sampleFrequency, rFrequency);
+    return true;
+}
+
+//! @brief Estimate the transfer function from input to output, as the cross spectrum divided by the input spectrum (H1 estimate)
+//! @param [in] rInput The input signal samples
+//! @param [in] rOutput The output signal samples, the same number as the input
+//! @param [in] sampleFrequency The sample frequency in Hz
+//! @param [out] rFrequency The frequencies in Hz
+//! @param [out] rTransferFunction The complex transfer function, zero where the input has no energy
+//! @param [out] pCoherence Optional, the magnitude squared coherence, a value close to one means that the output is explained by the input
+//! @returns False if the arguments are invalid, see getLastError()
+bool SpectrumAnalyzer::transferFunction(const std::vector<double> &rInput, const std::vector<double> &rOutput, const double sampleFrequency,
+                                        std::vector<double> &rFrequency, std::vector< std::complex<double> > &rTransferFunction,
+                                        std::vector<double> *pCoherence)
+{
+    if (rInput.size() != rOutput.size())
+    {
+        mLastError = "The input and output signals must have the same number of samples";
+        return false;
+    }
+    if (!prepareSegments(rInput.size(), sampleFrequency))
+    {
+        return false;
+    }
+
+    const size_t numBins = mFFT.spectrumSize();
+    std::vector<double> inputPower(numBins, 0.0), outputPower(numBins, 0.0);
+    rTransferFunction.assign(numBins, ComplexT(0,0));
+    mOutputSpectrum.resize(numBins);
+    for (size_t s=0; s<mNumSegments; ++s)
+    {
+        windowSegment(&rInput[s*mSegmentStep], mSegment);
+        mFFT.forward(&mSegment[0], &mSpectrum[0]);
+        windowSegment(&rOutput[s*mSegmentStep], mSegment);
+        mFFT.forward(&mSegment[0], &mOutputSpectrum[0]);
+        for (size_t k=0; k<numBins; ++k)
+        {
+            inputPower[k] += std::norm(mSpectrum[k]);
+            outputPower[k] += std::norm(mOutputSpectrum[k]);
+            rTransferFunction[k] += mul(std::conj(mSpectrum[k]), mOutputSpectrum[k]);
+        }
+    }
+
+    if (pCoherence)
+    {
+        pCoherence->assign(numBins, 0.0);
+    }
+    for (size_t k=0; k<numBins; ++k)
+    {
+        const ComplexT crossPower = rTransferFunction[k];
+        rTransferFunction[k] = (inputPower[k] > 0) ? crossPower/inputPower[k] : ComplexT(0,0);
+        if (pCoherence && inputPower[k] > 0 && outputPower[k] > 0)
+        {
+            (*pCoherence)[k] = std::norm(crossPower)/(inputPower[k]*outputPower[k]);
+        }
+    }
+    fillFrequencies(sampleFrequency, rFrequency);
+    return true;
+}
+
+//! @brief Get the frequencies of the spectrum of a signal, without transforming any data
+//! @param [in] numSamples The number of signal samples
+//! @param [in] sampleFrequency The sample frequency in Hz
+//! @param [out] rFrequency The frequencies in Hz, the same as spectrum() and transferFunction() give for the same number of samples
+//! @returns False if the arguments are invalid, see getLastError()
+bool SpectrumAnalyzer::frequencies(const size_t numSamples, const double sampleFrequency, std::vector<double> &rFrequency)
+{
+    if (!determineSegments(numSamples, sampleFrequency))
+    {
+        return false;
+    }
+    fillFrequencies(sampleFrequency, rFrequency);
+    return true;
+}
+
+//! @brief Returns the last error message
+const HString &SpectrumAnalyzer::getLastError() const
+{
+    return mLastError;
+}
+
+//! @brief Create a periodic window function, suitable for spectral analysis
+//! @param [in] window The window type, the flat top window uses the coefficients from ISO 18431-2
+//! @param [in] n The window length
+//! @param [out] rWindow The window weights
+void SpectrumAnalyzer::createWindow(const WindowT window, const size_t n, std::vector<double> &rWindow)
+{
+    rWindow.resize(n);
+    for (size_t i=0; i<n; ++i)
+    {
+        const double x = 2.0*pi*double(i)/double(n);
+        switch (window)
+        {
+        case Hann:
+            rWindow[i] = 0.5*(1.0-std::cos(x));
+            break;
+        case FlatTop:
+            rWindow[i] = 1.0 - 1.933*std::cos(x) + 1.286*std::cos(2*x) - 0.388*std::cos(3*x) + 0.0322*std::cos(4*x);
+            break;
+        default:
+            rWindow[i] = 1.0;
+        }
+    }
+}
+
+//! @brief Determine the segment length, step and number of segments for a signal of a given length
+bool SpectrumAnalyzer::determineSegments(const size_t dataSize, const double sampleFrequency)
+{
+    if (!(sampleFrequency > 0))
+    {
+        mLastError = "The sample frequency must be positive";
+        return false;
+    }
+    if (dataSize < 2)
+    {
+        mLastError = "At least two samples are required";
+        return false;
+    }
+
+    mSegmentLength = mRequestedSegmentLength;
+    if (mSegmentLength == 0 || mSegmentLength > dataSize)
+    {
+        mSegmentLength = dataSize;
+    }
+    if (mRequestedOverlap >= mSegmentLength)
+    {
+        mLastError = "The segment overlap must be shorter than the segment length";
+        return false;
+    }
+    mSegmentStep = mSegmentLength-mRequestedOverlap;
+    mNumSegments = (dataSize-mSegmentLength)/mSegmentStep + 1;
+    return true;
+}
+
+bool SpectrumAnalyzer::prepareSegments(const size_t dataSize, const double sampleFrequency)
+{
+    if (!determineSegments(dataSize, sampleFrequency))
+    {
+        return false;
+    }
+
+    if (mWindow.size() != mSegmentLength)
+    {
+        createWindow(mWindowType, mSegmentLength, mWindow);
+    }
+    if (mFFT.size() != mSegmentLength)
+    {
+        mFFT.setSize(mSegmentLength);
+    }
+    mSegment.resize(mSegmentLength);
+    mSpectrum.resize(mFFT.spectrumSize());
+    return true;
+}
+
+//! @brief The frequencies of the one-sided spectrum, bin k is at k*fs/(segment length)
+void SpectrumAnalyzer::fillFrequencies(const double sampleFrequency, std::vector<double> &rFrequency) const
+{
+    rFrequency.resize(mSegmentLength/2+1);
+    for (size_t k=0; k<rFrequency.size(); ++k)
+    {
+        rFrequency[k] = double(k)*sampleFrequency/double(mSegmentLength);
+    }
+}
+
+void SpectrumAnalyzer::windowSegment(const double *pData, std::vector<double> &rSegment) const
+{
+    double mean = 0;
+    if (mRemoveMean)
+    {
+        for (size_t i=0; i<mSegmentLength; ++i)
+        {
+            mean += pData[i];
+        }
+        mean /= double(mSegmentLength);
+    }
+    for (size_t i=0; i<mSegmentLength; ++i)
+    {
+        rSegment[i] = (pData[i]-mean)*mWindow[i];
+    }
+}
+
+
+//! @brief Compute the Bode diagram from a transfer function
+//! @param [in] rTransferFunction The complex transfer function
+//! @param [out] rGain The gain (not in dB)
+//! @param [out] rPhase The phase in radians, unwrapped to be continuous
+void hopsan::bodeFromTransferFunction(const std::vector< std::complex<double> > &rTransferFunction,
+                                      std::vector<double> &rGain, std::vector<double> &rPhase)
+{
+    const size_t n = rTransferFunction.size();
+    rGain.resize(n);
+    rPhase.resize(n);
+    double correction = 0;
+    double previous = 0;
+    for (size_t i=0; i<n; ++i)
+    {
+        const double phase = std::arg(rTransferFunction[i]);
+        if (i > 0)
+        {
+            if (phase-previous > pi)
+            {
+                correction -= 2*pi;
+            }
+            else if (phase-previous < -pi)
+            {
+                correction += 2*pi;
+            }
+        }
+        previous = phase;
+        rGain[i] = std::abs(rTransferFunction[i]);
+        rPhase[i] = phase+correction;
+    }
+}
+
+//! @brief Returns the root mean square value of n samples
+double hopsan::rms(const double *pData, const size_t n)
+{
+    if (n == 0)
+    {
+        return 0;
+    }
+    double sum=0;
+    for (size_t i=0; i<n; ++i)
+    {
+        sum += pData[i]*pData[i];
+    }
+    return std::sqrt(sum/double(n));
+}
+
+//! @brief Compute the moving root mean square value
+//! @param [in] rData The signal samples
+//! @param [in] windowLength The number of samples in the window, ending at each sample (fewer at the beginning)
+//! @param [out] rRms The RMS values, one per sample
+void hopsan::movingRms(const std::vector<double> &rData, const size_t windowLength, std::vector<double> &rRms)
+{
+    const size_t n = rData.size();
+    const size_t length = std::max<size_t>(windowLength, 1);
+    rRms.resize(n);
+    double sum=0;
+    for (size_t i=0; i<n; ++i)
+    {
+        sum += rData[i]*rData[i];
+        if (i >= length)
+        {
+            sum -= rData[i-length]*rData[i-length];
+            // Recompute the sum once per window length, so that rounding errors do not accumulate
+            if (i%length == 0)
+            {
+                sum = 0;
+                for (size_t j=i+1-length; j<=i; ++j)
+                {
+                    sum += rData[j]*rData[j];
+                }
+            }
+        }
+        rRms[i] = std::sqrt(std::max(sum, 0.0)/double(std::min(i+1, length)));
+    }
+}
+
+//! @brief Reduce the sample rate by an integer factor
+//! @details Each output sample is the mean of a block of input samples, which also acts as an anti-aliasing filter.
+//! Samples in an incomplete last block are discarded.
+//! @param [in] rData The signal samples
+//! @param [in] factor The decimation factor
+//! @param [out] rDecimated The decimated samples
+void hopsan::decimate(const std::vector<double> &rData, const size_t factor, std::vector<double> &rDecimated)
+{
+    if (factor <= 1)
+    {
+        rDecimated = rData;
+        return;
+    }
+    const size_t n = rData.size()/factor;
+    rDecimated.resize(n);
+    for (size_t i=0; i<n; ++i)
+    {
+        double sum=0;
+        const double *pBlock = &rData[i*factor];
+        for (size_t j=0; j<factor; ++j)
+        {
+            sum += pBlock[j];
+        }
+        rDecimated[i] = sum/double(factor);
+    }
+}
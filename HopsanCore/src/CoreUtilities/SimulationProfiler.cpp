@@ -0,0 +1,209 @@
+/*-----------------------------------------------------------------------------
+
+ Copyright 2017 Hopsan Group
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+
+ The full license is available in the file LICENSE.
+ For details about the 'Hopsan Group' or information about Authors and
+ Contributors see the HOPSANGROUP and AUTHORS files that are located in
+ the Hopsan source code root directory.
+
+-----------------------------------------------------------------------------*/
+
+//!
+//! @file   SimulationProfiler.cpp
+//!
+//! @brief Contains the per-component simulation profiler and the profile report
+//!
+//$Id$
+
+#include "CoreUtilities/SimulationProfiler.h"
+#include "ComponentSystem.h"
+#include "ComponentUtilities/num2string.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+using namespace hopsan;
+
+namespace {
+
+typedef std::chrono::steady_clock ProfileClock;
+
+HString escapeJSON(const HString &rString)
+{
+    HString escaped;
+    for (size_t i=0; i<rString.size(); ++i)
+    {
+        const char c = rString[i];
+        if (c == '"' || c == '\\')
+        {
+            escaped.append('\\');
+        }
+        escaped.append(c);
+    }
+    return escaped;
+}
+
+void appendJSON(const ProfileEntry &rEntry, const HString &rIndent, HString &rJSON)
+{
+    rJSON += rIndent+"{\"name\": \""+escapeJSON(rEntry.name)+"\", \"type\": \""+escapeJSON(rEntry.typeName)+"\", ";
+    rJSON += "\"calls\": "+to_hstring(rEntry.numCalls)+", \"totalTime\": "+to_hstring(rEntry.totalTime)+", ";
+    rJSON += "\"selfTime\": "+to_hstring(rEntry.getSelfTime());
+    if (!rEntry.children.empty())
+    {
+        rJSON += ", \"children\": [\n";
+        for (size_t c=0; c<rEntry.children.size(); ++c)
+        {
+            appendJSON(rEntry.children[c], rIndent+"  ", rJSON);
+            rJSON += (c+1 < rEntry.children.size()) ? ",\n" : "\n";
+        }
+        rJSON += rIndent+"]";
+    }
+    rJSON += "}";
+}
+
+void appendCSV(const ProfileEntry &rEntry, const HString &rParentPath, HString &rCSV)
+{
+    // The path is a folded stack (names separated by ;) as used by flame graph tools
+    const HString path = rParentPath.empty() ? rEntry.name : rParentPath+";"+rEntry.name;
+    rCSV += path+","+rEntry.typeName+","+to_hstring(rEntry.numCalls)+","+to_hstring(rEntry.totalTime)+","+to_hstring(rEntry.getSelfTime())+"\n";
+    for (size_t c=0; c<rEntry.children.size(); ++c)
+    {
+        appendCSV(rEntry.children[c], path, rCSV);
+    }
+}
+
+}
+
+//! @brief Returns the time spent in this entry itself, excluding its children [s]
+double ProfileEntry::getSelfTime() const
+{
+    double childTime = 0;
+    for (size_t c=0; c<children.size(); ++c)
+    {
+        childTime += children[c].totalTime;
+    }
+    return std::max(totalTime-childTime, 0.0);
+}
+
+//! @brief Returns the profile report as a JSON object, with nested children arrays
+HString hopsan::profileReportToJSON(const ProfileEntry &rRoot)
+{
+    HString json;
+    appendJSON(rRoot, "", json);
+    json += "\n";
+    return json;
+}
+
+//! @brief Returns the profile report as CSV, one row per entry with the path given as a folded stack
+HString hopsan::profileReportToCSV(const ProfileEntry &rRoot)
+{
+    HString csv = "path,type,calls,totalTime,selfTime\n";
+    appendCSV(rRoot, "", csv);
+    return csv;
+}
+
+
+SimulationProfiler::SimulationProfiler() :
+    mNumSignal(0), mNumC(0), mNumQ(0), mTotalTime(0), mLogTime(0), mNumSteps(0) {}
+
+//! @brief Clear all accumulated data and set up for the given components, must be called whenever the component vectors change
+void SimulationProfiler::setup(const std::vector<Component*> &rSignalComponents, const std::vector<Component*> &rCComponents,
+                               const std::vector<Component*> &rQComponents)
+{
+    mComponents.clear();
+    mComponents.insert(mComponents.end(), rSignalComponents.begin(), rSignalComponents.end());
+    mComponents.insert(mComponents.end(), rCComponents.begin(), rCComponents.end());
+    mComponents.insert(mComponents.end(), rQComponents.begin(), rQComponents.end());
+    mNumSignal = rSignalComponents.size();
+    mNumC = rCComponents.size();
+    mNumQ = rQComponents.size();
+    mTimes.assign(mComponents.size(), 0.0);
+    mNumCalls.assign(mComponents.size(), 0);
+    mTotalTime = 0;
+    mLogTime = 0;
+    mNumSteps = 0;
+}
+
+void SimulationProfiler::simulateSignalComponents(const double time)
+{
+    simulateComponents(0, mNumSignal, time);
+}
+
+void SimulationProfiler::simulateCComponents(const double time)
+{
+    simulateComponents(mNumSignal, mNumC, time);
+}
+
+void SimulationProfiler::simulateQComponents(const double time)
+{
+    simulateComponents(mNumSignal+mNumC, mNumQ, time);
+}
+
+//! @brief Add the time of one whole time step (including logging) and of the logging in that step [s]
+void SimulationProfiler::addStep(const double stepTime, const double logTime)
+{
+    mTotalTime += stepTime;
+    mLogTime += logTime;
+    ++mNumSteps;
+}
+
+//! @brief Returns the profile of the system, with subsystems expanded recursively
+//! @param [in] rName The system name
+//! @param [in] rTypeName The system type name
+ProfileEntry SimulationProfiler::getReport(const HString &rName, const HString &rTypeName) const
+{
+    ProfileEntry report;
+    report.name = rName;
+    report.typeName = rTypeName;
+    report.totalTime = mTotalTime;
+    report.numCalls = mNumSteps;
+
+    for (size_t i=0; i<mComponents.size(); ++i)
+    {
+        ProfileEntry entry;
+        if (mComponents[i]->isComponentSystem())
+        {
+            entry = static_cast<ComponentSystem*>(mComponents[i])->getProfileReport();
+        }
+        entry.name = mComponents[i]->getName();
+        entry.typeName = mComponents[i]->getTypeName();
+        entry.totalTime = mTimes[i];
+        entry.numCalls = mNumCalls[i];
+        report.children.push_back(entry);
+    }
+
+    ProfileEntry logEntry;
+    logEntry.name = "(logging)";
+    logEntry.totalTime = mLogTime;
+    logEntry.numCalls = mNumSteps;
+    report.children.push_back(logEntry);
+
+    return report;
+}
+
+void SimulationProfiler::simulateComponents(const size_t offset, const size_t numComponents, const double time)
+{
+    ProfileClock::time_point t0 = ProfileClock::now();
+    for (size_t i=offset; i<offset+numComponents; ++i)
+    {
+        mComponents[i]->simulate(time);
+        const ProfileClock::time_point t1 = ProfileClock::now();
+        mTimes[i] += std::chrono::duration<double>(t1-t0).count();
+        ++mNumCalls[i];
+        t0 = t1;
+    }
+}
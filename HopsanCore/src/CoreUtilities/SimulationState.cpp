@@ -0,0 +1,233 @@
+/*-----------------------------------------------------------------------------
+
+ Copyright 2017 Hopsan Group
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+
+ The full license is available in the file LICENSE.
+ For details about the 'Hopsan Group' or information about Authors and
+ Contributors see the HOPSANGROUP and AUTHORS files that are located in
+ the Hopsan source code root directory.
+
+-----------------------------------------------------------------------------*/
+
+//!
+//! @file   SimulationState.cpp
+//!
+//! @brief Contains helpers for serializing the simulation state of components into a byte buffer
+//!
+//$Id$
+
+#include "CoreUtilities/SimulationState.h"
+#include "Component.h"
+
+#include <cstring>
+
+using namespace hopsan;
+
+namespace {
+//! @brief The innermost registration scope in this thread
+thread_local StateObjectRegistrationScope *gpCurrentScope = 0;
+}
+
+StateWriter::StateWriter(std::vector<char> &rBuffer) :
+    mrBuffer(rBuffer) {}
+
+void StateWriter::writeDouble(const double value)
+{
+    writeRaw(&value, sizeof(double));
+}
+
+void StateWriter::writeDoubles(const double *pValues, const size_t numValues)
+{
+    writeRaw(pValues, numValues*sizeof(double));
+}
+
+void StateWriter::writeSize(const size_t value)
+{
+    // Always use 64 bits so that the layout does not depend on the size of size_t
+    const unsigned long long value64 = value;
+    writeRaw(&value64, sizeof(value64));
+}
+
+void StateWriter::writeInt(const int value)
+{
+    writeRaw(&value, sizeof(int));
+}
+
+void StateWriter::writeBool(const bool value)
+{
+    const char c = value ? 1 : 0;
+    writeRaw(&c, 1);
+}
+
+void StateWriter::writeRaw(const void *pData, const size_t numBytes)
+{
+    if (numBytes > 0)
+    {
+        const size_t offset = mrBuffer.size();
+        mrBuffer.resize(offset+numBytes);
+        memcpy(&mrBuffer[offset], pData, numBytes);
+    }
+}
+
+
+StateReader::StateReader(const std::vector<char> &rBuffer) :
+    mpData(rBuffer.empty() ? 0 : &rBuffer[0]), mSize(rBuffer.size()), mPosition(0), mFailed(false) {}
+
+StateReader::StateReader(const char *pData, const size_t size) :
+    mpData(pData), mSize(size), mPosition(0), mFailed(false) {}
+
+bool StateReader::readDouble(double &rValue)
+{
+    return readRaw(&rValue, sizeof(double));
+}
+
+bool StateReader::readDoubles(double *pValues, const size_t numValues)
+{
+    return readRaw(pValues, numValues*sizeof(double));
+}
+
+bool StateReader::readSize(size_t &rValue)
+{
+    unsigned long long value64=0;
+    if (readRaw(&value64, sizeof(value64)))
+    {
+        rValue = size_t(value64);
+        return true;
+    }
+    return false;
+}
+
+bool StateReader::readInt(int &rValue)
+{
+    return readRaw(&rValue, sizeof(int));
+}
+
+bool StateReader::readBool(bool &rValue)
+{
+    char c=0;
+    if (readRaw(&c, 1))
+    {
+        rValue = (c != 0);
+        return true;
+    }
+    return false;
+}
+
+bool StateReader::readRaw(void *pData, const size_t numBytes)
+{
+    if (mFailed || (numBytes > mSize-mPosition))
+    {
+        mFailed = true;
+        return false;
+    }
+    if (numBytes > 0)
+    {
+        memcpy(pData, mpData+mPosition, numBytes);
+        mPosition += numBytes;
+    }
+    return true;
+}
+
+//! @brief Check if all data has been read
+bool StateReader::atEnd() const
+{
+    return (mPosition == mSize);
+}
+
+bool StateReader::hasFailed() const
+{
+    return mFailed;
+}
+
+
+ComponentStateObject::ComponentStateObject()
+{
+    mpOwner = 0;
+    Component *pComponent = StateObjectRegistrationScope::getCurrentComponent();
+    if (pComponent)
+    {
+        pComponent->registerStateObject(this);
+    }
+}
+
+//! @brief Copy constructor, the copy is registered with the component of the current scope (if any), not with the owner of the original
+ComponentStateObject::ComponentStateObject(const ComponentStateObject &/*rOther*/)
+{
+    mpOwner = 0;
+    Component *pComponent = StateObjectRegistrationScope::getCurrentComponent();
+    if (pComponent)
+    {
+        pComponent->registerStateObject(this);
+    }
+}
+
+ComponentStateObject::~ComponentStateObject()
+{
+    if (mpOwner)
+    {
+        mpOwner->unRegisterStateObject(this);
+    }
+}
+
+//! @brief Assignment operator, the registration of this object is kept
+ComponentStateObject &ComponentStateObject::operator=(const ComponentStateObject &/*rOther*/)
+{
+    return *this;
+}
+
+//! @brief Constructor, makes this the current scope
+//! @param[in] pComponent The component to register state objects with, if 0 the first component constructed in the scope is used
+StateObjectRegistrationScope::StateObjectRegistrationScope(Component *pComponent)
+{
+    mpPrevious = gpCurrentScope;
+    mpComponent = pComponent;
+    mWaitingForComponent = (pComponent == 0);
+    gpCurrentScope = this;
+}
+
+//! @brief Destructor, makes the previous scope current again
+StateObjectRegistrationScope::~StateObjectRegistrationScope()
+{
+    gpCurrentScope = mpPrevious;
+}
+
+//! @brief Returns the component that state objects constructed now should register with, or 0 if none
+Component *StateObjectRegistrationScope::getCurrentComponent()
+{
+    return gpCurrentScope ? gpCurrentScope->mpComponent : 0;
+}
+
+//! @brief Called by the Component constructor, binds the current scope if it is waiting for a component
+void StateObjectRegistrationScope::componentConstructed(Component *pComponent)
+{
+    if (gpCurrentScope && gpCurrentScope->mWaitingForComponent)
+    {
+        gpCurrentScope->mpComponent = pComponent;
+        gpCurrentScope->mWaitingForComponent = false;
+    }
+}
+
+//! @brief Called by the Component destructor, no state objects are registered with the component after this
+void StateObjectRegistrationScope::componentDestroyed(Component *pComponent)
+{
+    for (StateObjectRegistrationScope *pScope=gpCurrentScope; pScope; pScope=pScope->mpPrevious)
+    {
+        if (pScope->mpComponent == pComponent)
+        {
+            pScope->mpComponent = 0;
+        }
+    }
+}
@@ -0,0 +1,536 @@
+/*-----------------------------------------------------------------------------
+
+ Copyright 2017 Hopsan Group
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+
+ The full license is available in the file LICENSE.
+ For details about the 'Hopsan Group' or information about Authors and
+ Contributors see the HOPSANGROUP and AUTHORS files that are located in
+ the Hopsan source code root directory.
+
+-----------------------------------------------------------------------------*/
+
+
+//!
+//! @file   SweepRunner.cpp
+//!
+//! @brief Contains the parameter sweep runner, that simulates many parameter cases of one model in parallel
+//!
+//$Id$
+
+#include "CoreUtilities/SweepRunner.h"
+#include "CoreUtilities/HmfLoader.h"
+#include "HopsanEssentials.h"
+#include "ComponentSystem.h"
+#include "Port.h"
+#include "ComponentUtilities/num2string.hpp"
+
+#include <fstream>
+#include <string>
+
+using namespace hopsan;
+
+namespace {
+
+//! @brief Find the component from a full name such as "Subsystem$Component", "self" or "Subsystem$self" means the system itself
+Component *findComponent(ComponentSystem *pRootSystem, const HString &rFullName)
+{
+    HVector<HString> names = rFullName.split('$');
+    ComponentSystem *pSystem = pRootSystem;
+    for (size_t i=0; i+1<names.size(); ++i)
+    {
+        pSystem = pSystem->getSubComponentSystem(names[i]);
+        if (!pSystem)
+        {
+            return 0;
+        }
+    }
+    if (names.empty() || names.last().empty() || names.last() == "self")
+    {
+        return pSystem;
+    }
+    return pSystem->getSubComponent(names.last());
+}
+
+//! @brief Remove leading and trailing white space
+HString trimmed(const std::string &rString)
+{
+    const size_t first = rString.find_first_not_of(" \t");
+    if (first == std::string::npos)
+    {
+        return HString();
+    }
+    const size_t last = rString.find_last_not_of(" \t");
+    return HString(rString.substr(first, last-first+1).c_str());
+}
+
+}
+
+
+//! @brief Constructor
+//! @param [in] pHopsanEssentials The HopsanEssentials object used to create the model instances
+SweepRunner::SweepRunner(HopsanEssentials *pHopsanEssentials) :
+    mpHopsanEssentials(pHopsanEssentials),
+    mStartTime(0),
+    mTimeStep(0),
+    mStopTime(0),
+    mNumLogSamples(0),
+    mKeepTimeSeries(true),
+    mNextCase(0)
+{
+}
+
+SweepRunner::~SweepRunner()
+{
+    clearInstances();
+}
+
+//! @brief Set the model to sweep, the simulation time is taken from the model unless set with setSimulationTime()
+//! @param [in] rFilePath Path to the HMF file
+//! @returns True if the model could be loaded
+bool SweepRunner::loadModel(const HString &rFilePath)
+{
+    clearInstances();
+    mModelFilePath = rFilePath;
+    // Load the first instance now, to check the model and get its simulation time
+    if (!createInstances(1))
+    {
+        clearInstances();
+        mModelFilePath.clear();
+        return false;
+    }
+    return true;
+}
+
+//! @brief Set the simulation time used for all cases
+//! @param [in] startTime The start time
+//! @param [in] timeStep The time step, 0 means use the time step in the model
+//! @param [in] stopTime The stop time
+void SweepRunner::setSimulationTime(const double startTime, const double timeStep, const double stopTime)
+{
+    mStartTime = startTime;
+    mTimeStep = timeStep;
+    mStopTime = stopTime;
+}
+
+//! @brief Set the number of log samples for all cases, 0 means use the number in the model
+void SweepRunner::setNumLogSamples(const size_t numLogSamples)
+{
+    mNumLogSamples = numLogSamples;
+}
+
+//! @brief Set whether all logged samples of the result variables should be kept, or only their final values
+//! @details Keeping only the final values limits memory usage in sweeps with very many cases
+void SweepRunner::setKeepTimeSeries(const bool keep)
+{
+    mKeepTimeSeries = keep;
+}
+
+//! @brief Set the names of the parameters to sweep, this clears all cases
+void SweepRunner::setParameterNames(const std::vector<HString> &rNames)
+{
+    mParameterNames = rNames;
+    clearCases();
+}
+
+const std::vector<HString> &SweepRunner::getParameterNames() const
+{
+    return mParameterNames;
+}
+
+//! @brief Add a case to simulate
+//! @param [in] rValues One value (or expression) for each parameter name
+//! @returns False if the number of values does not match the number of parameter names
+bool SweepRunner::addCase(const std::vector<HString> &rValues)
+{
+    if (rValues.size() != mParameterNames.size())
+    {
+        mLastError = "Case "+to_hstring(mCases.size())+" has "+to_hstring(rValues.size())+" values, expected "+to_hstring(mParameterNames.size());
+        return false;
+    }
+    mCases.push_back(rValues);
+    return true;
+}
+
+//! @brief Load parameter names and cases from a CSV file
+//! @details The first row contains the parameter names, each following row is one case. Empty lines and lines starting with # are ignored.
+//! @param [in] rFilePath Path to the CSV file
+//! @returns True if the file could be read and all rows had one value per parameter
+bool SweepRunner::loadParameterTable(const HString &rFilePath)
+{
+    std::ifstream file(rFilePath.c_str());
+    if (!file.is_open())
+    {
+        mLastError = "Could not open: "+rFilePath;
+        return false;
+    }
+
+    bool haveHeader = false;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        // Handle files with Windows line endings
+        if (!line.empty() && line[line.size()-1] == '\r')
+        {
+            line.erase(line.size()-1);
+        }
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+
+        std::vector<HString> row;
+        size_t start = 0;
+        while (true)
+        {
+            const size_t end = line.find(',', start);
+            row.push_back(trimmed(line.substr(start, (end == std::string::npos) ? std::string::npos : end-start)));
+            if (end == std::string::npos)
+            {
+                break;
+            }
+            start = end+1;
+        }
+
+        if (!haveHeader)
+        {
+            setParameterNames(row);
+            haveHeader = true;
+        }
+        else if (!addCase(row))
+        {
+            return false;
+        }
+    }
+
+    if (!haveHeader)
+    {
+        mLastError = "No parameter names found in: "+rFilePath;
+        return false;
+    }
+    return true;
+}
+
+void SweepRunner::clearCases()
+{
+    mCases.clear();
+    mResults.clear();
+}
+
+size_t SweepRunner::getNumCases() const
+{
+    return mCases.size();
+}
+
+const std::vector<HString> &SweepRunner::getCaseValues(const size_t caseIdx) const
+{
+    return mCases[caseIdx];
+}
+
+//! @brief Set the variables to extract from each case, all other logging is disabled in the model instances
+void SweepRunner::setResultVariables(const std::vector<HString> &rVariables)
+{
+    mResultVariables = rVariables;
+}
+
+const std::vector<HString> &SweepRunner::getResultVariables() const
+{
+    return mResultVariables;
+}
+
+//! @brief Simulate all cases
+//! @param [in] nDesiredThreads The number of worker threads (and model instances), 0 means auto-detect
+//! @returns False if the sweep could not be started, failed cases are reported in their results
+bool SweepRunner::run(const size_t nDesiredThreads)
+{
+    if (mModelFilePath.empty())
+    {
+        mLastError = "No model is loaded";
+        return false;
+    }
+
+    size_t nThreads = 1;
+#if defined(HOPSANCORE_USEMULTITHREADING)
+    nThreads = std::max(size_t(1), std::min(determineActualNumberOfThreads(nDesiredThreads), mCases.size()));
+#endif
+    if (!createInstances(nThreads))
+    {
+        return false;
+    }
+    for (size_t i=0; i<mInstances.size(); ++i)
+    {
+        if (!resolveInstance(mInstances[i]))
+        {
+            return false;
+        }
+    }
+
+    mResults.assign(mCases.size(), SweepCaseResult());
+    mNextCase = 0;
+#if defined(HOPSANCORE_USEMULTITHREADING)
+    std::vector<std::thread> workers;
+    for (size_t t=1; t<nThreads; ++t)
+    {
+        workers.push_back(std::thread(&SweepRunner::runCases, this, &mInstances[t]));
+    }
+    runCases(&mInstances[0]);
+    for (size_t t=0; t<workers.size(); ++t)
+    {
+        workers[t].join();
+    }
+#else
+    runCases(&mInstances[0]);
+#endif
+    return true;
+}
+
+//! @brief Returns the result of a case, valid after run()
+const SweepCaseResult &SweepRunner::getResult(const size_t caseIdx) const
+{
+    return mResults[caseIdx];
+}
+
+//! @brief Returns the number of cases that failed in the last run
+size_t SweepRunner::getNumFailedCases() const
+{
+    size_t numFailed = 0;
+    for (size_t c=0; c<mResults.size(); ++c)
+    {
+        if (!mResults[c].success)
+        {
+            ++numFailed;
+        }
+    }
+    return numFailed;
+}
+
+const HString &SweepRunner::getLastError() const
+{
+    return mLastError;
+}
+
+//! @brief Make sure that at least the given number of model instances exist
+bool SweepRunner::createInstances(const size_t numInstances)
+{
+    if (mInstances.size() >= numInstances)
+    {
+        return true;
+    }
+
+    std::vector<ComponentSystem*> systems;
+    double startTime, stopTime;
+    const size_t numToCreate = numInstances-mInstances.size();
+    const size_t numCreated = loadHopsanModelFileInstances(mModelFilePath, mpHopsanEssentials, numToCreate, systems, startTime, stopTime);
+    const bool isFirst = mInstances.empty();
+    for (size_t i=0; i<systems.size(); ++i)
+    {
+        Instance instance;
+        instance.pSystem = systems[i];
+        mInstances.push_back(instance);
+    }
+    if (numCreated != numToCreate)
+    {
+        mLastError = "Failed to load model: "+mModelFilePath;
+        return false;
+    }
+
+    if (isFirst)
+    {
+        mStartTime = startTime;
+        mStopTime = stopTime;
+        mTimeStep = 0;
+    }
+    for (size_t i=mInstances.size()-numCreated; i<mInstances.size(); ++i)
+    {
+        if (!mInstances[i].pSystem->checkModelBeforeSimulation())
+        {
+            mLastError = "Model check failed for: "+mModelFilePath;
+            return false;
+        }
+    }
+    return true;
+}
+
+//! @brief Look up the parameters and result variables in an instance, and enable logging only for the result variables
+bool SweepRunner::resolveInstance(Instance &rInstance)
+{
+    ComponentSystem *pSystem = rInstance.pSystem;
+
+    rInstance.parameterComponents.clear();
+    rInstance.parameterNames.clear();
+    for (size_t p=0; p<mParameterNames.size(); ++p)
+    {
+        // The component name is everything before the first #, the rest is the parameter name
+        const size_t hashPos = mParameterNames[p].find('#');
+        Component *pComponent = 0;
+        if (hashPos != HString::npos)
+        {
+            pComponent = findComponent(pSystem, mParameterNames[p].substr(0, hashPos));
+        }
+        if (!pComponent)
+        {
+            mLastError = "Could not find component for parameter: "+mParameterNames[p];
+            return false;
+        }
+        rInstance.parameterComponents.push_back(pComponent);
+        rInstance.parameterNames.push_back(mParameterNames[p].substr(hashPos+1));
+    }
+
+    rInstance.resultPorts.clear();
+    rInstance.resultDataIds.clear();
+    for (size_t v=0; v<mResultVariables.size(); ++v)
+    {
+        Port *pPort = 0;
+        int dataId = -1;
+        HVector<HString> nameParts = mResultVariables[v].split('#');
+        if (nameParts.size() == 1 && pSystem->getAliasHandler().hasAlias(nameParts[0]))
+        {
+            HString componentName, portName;
+            pSystem->getAliasHandler().getVariableFromAlias(nameParts[0], componentName, portName, dataId);
+            Component *pComponent = pSystem->getSubComponent(componentName);
+            pPort = pComponent ? pComponent->getPort(portName) : 0;
+        }
+        else if (nameParts.size() == 3)
+        {
+            Component *pComponent = findComponent(pSystem, nameParts[0]);
+            pPort = pComponent ? pComponent->getPort(nameParts[1]) : 0;
+            dataId = pPort ? pPort->getNodeDataIdFromName(nameParts[2]) : -1;
+        }
+        if (!pPort || dataId < 0)
+        {
+            mLastError = "Could not find result variable: "+mResultVariables[v];
+            return false;
+        }
+        rInstance.resultPorts.push_back(pPort);
+        rInstance.resultDataIds.push_back(dataId);
+    }
+
+    // Only log what is requested, everything else would just be thrown away
+    std::vector<ComponentSystem*> systems(1, pSystem);
+    while (!systems.empty())
+    {
+        ComponentSystem *pCurrent = systems.back();
+        systems.pop_back();
+        std::vector<HString> names = pCurrent->getSubComponentNames();
+        for (size_t c=0; c<names.size(); ++c)
+        {
+            Component *pComponent = pCurrent->getSubComponent(names[c]);
+            if (pComponent->isComponentSystem())
+            {
+                systems.push_back(static_cast<ComponentSystem*>(pComponent));
+            }
+            std::vector<Port*> ports = pComponent->getPortPtrVector();
+            for (size_t p=0; p<ports.size(); ++p)
+            {
+                ports[p]->setEnableLogging(false);
+            }
+        }
+    }
+    for (size_t v=0; v<rInstance.resultPorts.size(); ++v)
+    {
+        Port *pPort = rInstance.resultPorts[v];
+        if (!pPort->isLoggingEnabled())
+        {
+            pPort->setEnableLogging(true);
+            for (size_t d=0; d<pPort->getNumDataVariables(); ++d)
+            {
+                pPort->setEnableVariableLogging(d, false);
+            }
+        }
+        pPort->setEnableVariableLogging(size_t(rInstance.resultDataIds[v]), true);
+    }
+    return true;
+}
+
+void SweepRunner::clearInstances()
+{
+    for (size_t i=0; i<mInstances.size(); ++i)
+    {
+        mpHopsanEssentials->removeComponent(mInstances[i].pSystem);
+    }
+    mInstances.clear();
+}
+
+//! @brief Worker function, simulates cases in the given instance until there are no cases left
+void SweepRunner::runCases(Instance *pInstance)
+{
+    size_t caseIdx = mNextCase++;
+    while (caseIdx < mCases.size())
+    {
+        runCase(*pInstance, caseIdx);
+        caseIdx = mNextCase++;
+    }
+}
+
+//! @brief Apply the parameters of a case to an instance, simulate it and store the results
+void SweepRunner::runCase(Instance &rInstance, const size_t caseIdx)
+{
+    ComponentSystem *pSystem = rInstance.pSystem;
+    SweepCaseResult &rResult = mResults[caseIdx];
+    const std::vector<HString> &rValues = mCases[caseIdx];
+
+    for (size_t p=0; p<rValues.size(); ++p)
+    {
+        if (!rInstance.parameterComponents[p]->setParameterValue(rInstance.parameterNames[p], rValues[p]))
+        {
+            rResult.errorMessage = "Failed to set parameter: "+mParameterNames[p]+" = "+rValues[p];
+            return;
+        }
+    }
+    if (mTimeStep > 0)
+    {
+        pSystem->setDesiredTimestep(mTimeStep);
+    }
+    if (mNumLogSamples > 0)
+    {
+        pSystem->setNumLogSamples(mNumLogSamples);
+    }
+
+    if (!pSystem->initialize(mStartTime, mStopTime))
+    {
+        pSystem->finalize();
+        rResult.errorMessage = "Initialize failed";
+        return;
+    }
+    pSystem->simulate(mStopTime);
+    pSystem->finalize();
+    if (pSystem->wasSimulationAborted())
+    {
+        rResult.errorMessage = "Simulation was aborted";
+        return;
+    }
+
+    const size_t numSamples = pSystem->getNumActuallyLoggedSamples();
+    const size_t firstSample = (mKeepTimeSeries || numSamples == 0) ? 0 : numSamples-1;
+    const std::vector<double> *pTime = pSystem->getLogTimeVector();
+    rResult.time.assign(pTime->begin()+firstSample, pTime->begin()+numSamples);
+    rResult.values.resize(rInstance.resultPorts.size());
+    for (size_t v=0; v<rInstance.resultPorts.size(); ++v)
+    {
+        Port *pPort = rInstance.resultPorts[v];
+        const size_t dataId = size_t(rInstance.resultDataIds[v]);
+        const std::vector<double> *pLogData = pPort->getLogDataVariablePtr(dataId);
+        const size_t decimation = pPort->getLogDataDecimation(dataId);
+        rResult.values[v].clear();
+        if (pLogData && decimation > 0)
+        {
+            for (size_t t=firstSample; t<numSamples; ++t)
+            {
+                rResult.values[v].push_back((*pLogData)[t/decimation]);
+            }
+        }
+    }
+    rResult.success = true;
+}
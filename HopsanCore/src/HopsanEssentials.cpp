@@ -225,6 +225,8 @@ bool HopsanEssentials::isCoreDebugCompiled() const
 Component* HopsanEssentials::createComponent(const HString &rTypeName)
 {
     addCoreLogMessage(rTypeName+"::createComponent");
+    // State objects constructed as members of the new component, or during configure(), register with it
+    StateObjectRegistrationScope stateObjectScope;
     Component* pComp = mpComponentFactory->createInstance(rTypeName);
     if (pComp)
     {
@@ -57,6 +57,25 @@ bool anyPortWantsLogging(std::vector<hopsan::Port*>& ports)
     }
     return false;
 }
+
+//! @brief Determine the decimation factor to use for a data variable, based on the settings in the connected ports
+//! @returns The smallest decimation factor among the ports that want logging, 0 if the variable should not be logged
+size_t determineLogDecimation(std::vector<hopsan::Port*>& ports, const size_t dataId)
+{
+    size_t decimation = 0;
+    for (size_t p=0; p<ports.size(); ++p)
+    {
+        if (ports[p]->isLoggingEnabled())
+        {
+            const size_t portDecimation = ports[p]->getVariableLogDecimation(dataId);
+            if ((portDecimation > 0) && ((decimation == 0) || (portDecimation < decimation)))
+            {
+                decimation = portDecimation;
+            }
+        }
+    }
+    return decimation;
+}
 }
 
 using namespace std;
@@ -258,28 +277,112 @@ void Node::setTLMNodeDataValuesTo(Node* /*pOtherNode*/) const
 }
 
 
+//! @brief Determine which data variables to log (and their decimation) without allocating any log memory
+//! @details Only data variables that are enabled for logging in at least one connected port are logged. If no variable
+//! should be logged, logging is disabled for the entire node.
+void Node::setupLogPlan()
+{
+    mDataStorage.clear();
+    mLoggedDataIds.clear();
+    mLogDecimations.clear();
+
+    if (mDoLog)
+    {
+        for (size_t i=0; i<mDataValues.size(); ++i)
+        {
+            const size_t decimation = determineLogDecimation(mConnectedPorts, i);
+            if (decimation > 0)
+            {
+                mLoggedDataIds.push_back(i);
+                mLogDecimations.push_back(decimation);
+            }
+        }
+        mDataStorage.resize(mLoggedDataIds.size());
+        mDoLog = !mLoggedDataIds.empty();
+    }
+}
+
+
 //! @brief Pre allocate memory for the needed amount of log data
+//! @details Variables with a decimation factor n only get memory for every n:th log slot, see setupLogPlan()
 void Node::preAllocateLogSpace(const size_t nLogSlots)
 {
+    setupLogPlan();
+
     // Don't try to allocate if we are not going to log
     if (mDoLog)
     {
-        mDataStorage.resize(nLogSlots, vector<double>(mDataValues.size()));
+        for (size_t j=0; j<mLoggedDataIds.size(); ++j)
+        {
+            mDataStorage[j].resize((nLogSlots+mLogDecimations[j]-1)/mLogDecimations[j], 0.0);
+        }
     }
 }
 
 
-//! @brief Copy current data vector into log storage at given logslot
+//! @brief Copy the logged data variables into log storage at given logslot
 //! @warning No bounds check is done
 void Node::logData(const size_t logSlot)
 {
     if (mDoLog)
     {
-        mDataStorage[logSlot] = mDataValues;
+        for (size_t j=0; j<mLoggedDataIds.size(); ++j)
+        {
+            const size_t decimation = mLogDecimations[j];
+            if (decimation == 1)
+            {
+                mDataStorage[j][logSlot] = mDataValues[mLoggedDataIds[j]];
+            }
+            else if (logSlot % decimation == 0)
+            {
+                mDataStorage[j][logSlot/decimation] = mDataValues[mLoggedDataIds[j]];
+            }
+        }
     }
 }
 
 
+//! @brief Check if this node is logging any data
+bool Node::isLogging() const
+{
+    return mDoLog;
+}
+
+
+//! @brief Get the log data for one data variable
+//! @details The log vector has one element per decimation factor log slots, see getLogDataDecimation()
+//! @param [in] dataId The data variable id
+//! @returns A pointer to the log data vector, or 0 if the variable is not logged
+const std::vector<double> *Node::getLogDataVariablePtr(const size_t dataId) const
+{
+    for (size_t j=0; j<mLoggedDataIds.size(); ++j)
+    {
+        if (mLoggedDataIds[j] == dataId)
+        {
+            return &mDataStorage[j];
+        }
+    }
+    return 0;
+}
+
+
+//! @brief Get the log decimation factor for one data variable
+//! @details Log slot t of the owner system log time vector corresponds to element t/decimation in the log data vector
+//! @param [in] dataId The data variable id
+//! @returns The decimation factor, or 0 if the variable is not logged
+size_t Node::getLogDataDecimation(const size_t dataId) const
+{
+    for (size_t j=0; j<mLoggedDataIds.size(); ++j)
+    {
+        if (mLoggedDataIds[j] == dataId)
+        {
+            return mLogDecimations[j];
+        }
+    }
+    return 0;
+}
+
+
 //! @brief Returns a pointer to the component with the write port in the node.
 //! If connection is ok, any node can only have one write port. If no write port exists, a null pointer is returned.
 Component *Node::getWritePortComponentPtr() const
@@ -378,6 +481,8 @@ void Node::setDoLogIfEnabled(bool doLog)
     {
         mDoLog = false;
         mDataStorage.clear();
+        mLoggedDataIds.clear();
+        mLogDecimations.clear();
     }
 }
 
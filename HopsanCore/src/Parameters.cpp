@@ -39,6 +39,7 @@
 #include "ComponentUtilities/num2string.hpp"
 //#include "Quantities.h"
 #include <cassert>
+#include <cctype>
 #include <sstream>
 #include <algorithm>
 #include <iostream>
@@ -46,6 +47,37 @@
 using namespace hopsan;
 using namespace std;
 
+namespace {
+
+bool isNameChar(const char c)
+{
+    return isalnum(static_cast<unsigned char>(c)) || (c == '_') || (c == '.') || (c == '#');
+}
+
+//! @brief Check if a parameter value text refers to a name (as a whole word)
+bool referencesName(const HString &rText, const HString &rName)
+{
+    if (rText.isNummeric())
+    {
+        return false;
+    }
+    size_t pos = rText.find(rName);
+    while (pos != HString::npos)
+    {
+        const size_t end = pos+rName.size();
+        const bool startOK = (pos == 0) || !isNameChar(rText[pos-1]);
+        const bool endOK = (end >= rText.size()) || !isNameChar(rText[end]);
+        if (startOK && endOK)
+        {
+            return true;
+        }
+        pos = rText.find(rName, pos+1);
+    }
+    return false;
+}
+
+}
+
 //! @class hopsan::Parameter
 //! @brief The Parameter class implements the parameter used in the container class Parameters
 //!
@@ -66,6 +98,8 @@ ParameterEvaluator::ParameterEvaluator(const HString &rName, const HString &rVal
                                        const HString &rType, const bool internal, void* pDataPtr, ParameterEvaluatorHandler* pParameterEvalHandler)
 {
     mDepthCounter=0;
+    mValueTextOutdated = false;
+    mHandleValue = 0;
     mParameterName = rName;
     mParameterValue = rValue;
     mDescription = rDescription;
@@ -91,6 +125,7 @@ void* ParameterEvaluator::getDataPtr()
 bool ParameterEvaluator::setParameter(const HString &rValue, const HString &rDescription, const HString &rQuantity, const HString &rUnit, const HString &rType, ParameterEvaluator **pNeedEvaluation, bool internal, bool force)
 {
     bool success;
+    updateValueText();
     HString oldValue = mParameterValue;
     HString oldDescription = mDescription;
     HString oldUnit = mUnit;
@@ -142,8 +177,13 @@ bool ParameterEvaluator::setParameterValue(const HString &rValue, ParameterEvalu
 {
     bool success=false;
 
+    updateValueText();
     HString oldValue = mParameterValue;
     mParameterValue = rValue;
+    if (mpParameterEvaluatorHandler && mpParameterEvaluatorHandler->getComponent())
+    {
+        mpParameterEvaluatorHandler->getComponent()->incrementParameterGeneration();
+    }
     HString evalResult = rValue;
     success = evaluate(evalResult);
     if(!success && !force)
@@ -221,6 +261,7 @@ bool ParameterEvaluator::refreshParameterValueText()
             return false;
         }
         mParameterValue = ss.str().c_str();
+        mValueTextOutdated = false;
         return true;
     }
     return false;
@@ -247,6 +288,8 @@ bool ParameterEvaluator::evaluate(HString &rResult)
     #define max_depth 250
 #endif
 
+    updateValueText();
+
     ++mDepthCounter;
     if (mDepthCounter > max_depth)
     {
@@ -442,6 +485,7 @@ const HString &ParameterEvaluator::getName() const
 
 const HString &ParameterEvaluator::getValue() const
 {
+    updateValueText();
     return mParameterValue;
 }
 
@@ -503,7 +547,7 @@ void ParameterEvaluator::resolveSignPrefix(HString &rSignPrefix) const
     }
 }
 
-void ParameterEvaluator::splitSignPrefix(const HString &rString, HString &rPrefix, HString &rValue)
+void ParameterEvaluator::splitSignPrefix(const HString &rString, HString &rPrefix, HString &rValue) const
 {
     rPrefix.clear();
     size_t n=0;
@@ -523,6 +567,23 @@ void ParameterEvaluator::splitSignPrefix(const HString &rString, HString &rPrefi
     rValue = rString.substr(n);
 }
 
+//! @brief Regenerate the value text if the value has been set through a ParameterHandle
+void ParameterEvaluator::updateValueText() const
+{
+    if (mValueTextOutdated)
+    {
+        mValueTextOutdated = false;
+        if (mType == "bool")
+        {
+            mParameterValue = (mHandleValue != 0) ? "true" : "false";
+        }
+        else
+        {
+            mParameterValue = to_hstring(mHandleValue);
+        }
+    }
+}
+
 //! @class hopsan::Parameters
 //! @brief The Parameters class implements the parameters used in both Components and ComponentSystems
 //!
@@ -574,6 +635,10 @@ bool ParameterEvaluatorHandler::addParameter(const HString &rName, const HString
             if(success || force)
             {
                 mParameters.push_back(newParameter);
+                if (mComponent)
+                {
+                    mComponent->incrementParameterGeneration();
+                }
                 success = true;
             }
             else
@@ -610,6 +675,10 @@ void ParameterEvaluatorHandler::deleteParameter(const HString &rName)
 
             delete *parIt;
             mParameters.erase(parIt);
+            if (mComponent)
+            {
+                mComponent->incrementParameterGeneration();
+            }
 
             // We can return now, since there should never be multiple parameters with same name
             return;
@@ -629,6 +698,10 @@ bool ParameterEvaluatorHandler::renameParameter(const HString &rOldName, const H
             if( rOldName == (*parIt)->getName() )
             {
                 (*parIt)->mParameterName = rNewName;
+                if (mComponent)
+                {
+                    mComponent->incrementParameterGeneration();
+                }
                 return true;
             }
         }
@@ -890,3 +963,277 @@ Component *ParameterEvaluatorHandler::getComponent() const
     return mComponent;
 }
 
+//! @brief Get a pre-resolved handle to a double, integer or bool parameter
+//! @param [in] rName The name of the parameter
+//! @returns The handle, check isValid() before using it
+ParameterHandle ParameterEvaluatorHandler::getParameterHandle(const HString &rName)
+{
+    ParameterHandle handle;
+    for(size_t i=0; i<mParameters.size(); ++i)
+    {
+        if(mParameters[i]->getName() == rName)
+        {
+            handle.mpComponent = mComponent;
+            handle.mpParameter = mParameters[i];
+            if (!handle.rebuild())
+            {
+                handle.mpParameter = 0;
+            }
+            break;
+        }
+    }
+    return handle;
+}
+
+
+//! @class hopsan::ParameterHandle
+//! @brief A pre-resolved handle to a numeric parameter, see ParameterEvaluatorHandler::getParameterHandle()
+
+ParameterHandle::ParameterHandle()
+{
+    mpComponent = 0;
+    mpParameter = 0;
+    mType = DoubleType;
+    mGeneration = 0;
+}
+
+//! @brief Check if the handle refers to a parameter
+bool ParameterHandle::isValid() const
+{
+    return (mpParameter != 0);
+}
+
+//! @brief Set a new parameter value and update all dependent parameters
+//! @param [in] value The new value, it is truncated for integer parameters and compared to zero for bool parameters
+//! @returns true if the value and all dependent parameters could be set, otherwise false
+bool ParameterHandle::set(const double value)
+{
+    if (!mpParameter)
+    {
+        return false;
+    }
+    if (isOutdated() && !rebuild())
+    {
+        return false;
+    }
+
+    double v = value;
+    void *pData = mpParameter->mpData;
+    if (mType == DoubleType)
+    {
+        if (pData)
+        {
+            *static_cast<double*>(pData) = v;
+        }
+    }
+    else if (mType == IntegerType)
+    {
+        v = double(int(value));
+        if (pData)
+        {
+            *static_cast<int*>(pData) = int(value);
+        }
+    }
+    else
+    {
+        v = (value != 0) ? 1.0 : 0.0;
+        if (pData)
+        {
+            *static_cast<bool*>(pData) = (value != 0);
+        }
+    }
+    mpParameter->mHandleValue = v;
+    mpParameter->mValueTextOutdated = true;
+
+    bool success = true;
+    for (size_t s=0; s<mSteps.size(); ++s)
+    {
+        DependentStep &rStep = mSteps[s];
+        if (rStep.isAlias)
+        {
+            const double sourceValue = (rStep.source < 0) ? v : mStepValues[size_t(rStep.source)];
+            mStepValues[s] = rStep.sign*sourceValue;
+            if (rStep.pParameter->mpData)
+            {
+                *static_cast<double*>(rStep.pParameter->mpData) = mStepValues[s];
+            }
+        }
+        else
+        {
+            success = rStep.pParameter->evaluate() && success;
+        }
+    }
+    return success;
+}
+
+//! @brief Get the current (evaluated) parameter value
+double ParameterHandle::get() const
+{
+    if (!mpParameter)
+    {
+        return 0;
+    }
+    if (mpParameter->mValueTextOutdated)
+    {
+        return mpParameter->mHandleValue;
+    }
+
+    void *pData = mpParameter->mpData;
+    if (pData)
+    {
+        if (mType == DoubleType)
+        {
+            return *static_cast<double*>(pData);
+        }
+        else if (mType == IntegerType)
+        {
+            return double(*static_cast<int*>(pData));
+        }
+        return *static_cast<bool*>(pData) ? 1.0 : 0.0;
+    }
+
+    // System parameters have no data variable, evaluate the value text instead
+    HString result;
+    mpParameter->evaluate(result);
+    if (mType == BoolType)
+    {
+        return (result == "true" || result == "1") ? 1.0 : 0.0;
+    }
+    bool isOK;
+    const double value = result.toDouble(&isOK);
+    return isOK ? value : 0;
+}
+
+const HString &ParameterHandle::getName() const
+{
+    static const HString emptyName;
+    return mpParameter ? mpParameter->getName() : emptyName;
+}
+
+//! @brief Returns the number of parameters that are updated when the value is set
+size_t ParameterHandle::getNumDependents() const
+{
+    return mSteps.size();
+}
+
+//! @brief Collect the parameters that depend on the handle parameter
+//! @returns false if the parameter can not be handled, e.g. if it is not numeric or triggers reconfiguration
+bool ParameterHandle::rebuild()
+{
+    mSteps.clear();
+    mStepValues.clear();
+    mGeneration = mpComponent->getParameterGeneration();
+
+    const HString &rType = mpParameter->getType();
+    if (rType == "double")
+    {
+        mType = DoubleType;
+    }
+    else if (rType == "integer")
+    {
+        mType = IntegerType;
+    }
+    else if (rType == "bool")
+    {
+        mType = BoolType;
+    }
+    else
+    {
+        return false;
+    }
+    if (mpParameter->triggersReconfiguration())
+    {
+        return false;
+    }
+
+    // Parameters in the same component may refer to this one with the self. prefix
+    bool success = true;
+    const HString selfName = "self."+mpParameter->getName();
+    const std::vector<ParameterEvaluator*> *pParameters = mpComponent->getParametersVectorPtr();
+    for (size_t p=0; p<pParameters->size(); ++p)
+    {
+        ParameterEvaluator *pParameter = (*pParameters)[p];
+        if ((pParameter != mpParameter) && referencesName(pParameter->getValue(), selfName))
+        {
+            success = addDependent(pParameter, selfName, -1, false) && success;
+        }
+    }
+
+    // System parameters may be referred to by parameters anywhere in the system hierarchy below
+    if (mpComponent->isComponentSystem())
+    {
+        success = collectDependents(static_cast<ComponentSystem*>(mpComponent), mpParameter->getName(), -1, (mType != BoolType)) && success;
+    }
+    return success;
+}
+
+//! @brief Recursively collect the parameters of the sub components of a system that refer to a name
+//! @param [in] pSystem The system in which the name is resolved
+//! @param [in] rName The name to look for
+//! @param [in] source The index of the step that the name refers to, -1 for the handle parameter
+//! @param [in] sourceIsAlias If the value of the source is known without evaluation
+bool ParameterHandle::collectDependents(ComponentSystem *pSystem, const HString &rName, const int source, const bool sourceIsAlias)
+{
+    bool success = true;
+    const std::vector<Component*> subComponents = pSystem->getSubComponents();
+    for (size_t c=0; c<subComponents.size(); ++c)
+    {
+        Component *pComponent = subComponents[c];
+        const std::vector<ParameterEvaluator*> *pParameters = pComponent->getParametersVectorPtr();
+        for (size_t p=0; p<pParameters->size(); ++p)
+        {
+            ParameterEvaluator *pParameter = (*pParameters)[p];
+            if (!referencesName(pParameter->getValue(), rName))
+            {
+                continue;
+            }
+            success = addDependent(pParameter, rName, source, sourceIsAlias) && success;
+
+            // A subsystem parameter referring to the name is in turn a system parameter that others may refer to
+            if (pComponent->isComponentSystem())
+            {
+                const int step = int(mSteps.size())-1;
+                const bool isAlias = mSteps.back().isAlias;
+                success = collectDependents(static_cast<ComponentSystem*>(pComponent), pParameter->getName(), step, isAlias) && success;
+            }
+        }
+
+        // The name is also visible inside subsystems, unless they have a parameter with the same name
+        if (pComponent->isComponentSystem() && !pComponent->hasParameter(rName))
+        {
+            success = collectDependents(static_cast<ComponentSystem*>(pComponent), rName, source, sourceIsAlias) && success;
+        }
+    }
+    return success;
+}
+
+//! @brief Add a dependent parameter, plain (optionally negated) references to a double value are marked as aliases
+bool ParameterHandle::addDependent(ParameterEvaluator *pParameter, const HString &rName, const int source, const bool sourceIsAlias)
+{
+    DependentStep step;
+    step.pParameter = pParameter;
+    step.source = source;
+    step.sign = 1.0;
+    step.isAlias = false;
+    if (sourceIsAlias && (pParameter->getType() == "double"))
+    {
+        HString signPrefix, valueWithoutSign;
+        pParameter->splitSignPrefix(pParameter->getValue(), signPrefix, valueWithoutSign);
+        if (valueWithoutSign == rName)
+        {
+            pParameter->resolveSignPrefix(signPrefix);
+            step.sign = signPrefix.empty() ? 1.0 : -1.0;
+            step.isAlias = true;
+        }
+    }
+    mSteps.push_back(step);
+    mStepValues.push_back(0);
+    return !pParameter->triggersReconfiguration();
+}
+
+//! @brief Check if any parameter in the component or the hierarchy below it has changed since the dependencies were collected
+bool ParameterHandle::isOutdated() const
+{
+    return (mpComponent->getParameterGeneration() != mGeneration);
+}
+
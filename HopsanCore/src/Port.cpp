@@ -424,7 +424,7 @@ bool Port::haveLogData(const size_t subPortIdx)
     if (mpNode)
     {
         // Here we assume that timevector DOES exist. If simulation code is correct it should exist
-        return !mpNode->mDataStorage.empty();
+        return mpNode->isLogging();
     }
     return false;
 }
@@ -439,6 +439,50 @@ bool Port::isLoggingEnabled() const
     return mEnableLogging;
 }
 
+//! @brief Enable or disable logging of an individual data variable
+//! @details Only has effect if logging is enabled for the port, see setEnableLogging()
+//! @param [in] dataId The data variable id
+//! @param [in] enableLog True to log the variable, false to not allocate any log memory for it
+void Port::setEnableVariableLogging(const size_t dataId, const bool enableLog)
+{
+    setVariableLogDecimation(dataId, enableLog ? 1 : 0);
+}
+
+bool Port::isVariableLoggingEnabled(const size_t dataId) const
+{
+    return getVariableLogDecimation(dataId) > 0;
+}
+
+//! @brief Set the log decimation factor for an individual data variable
+//! @details With decimation n, only every n:th log sample is stored for this variable
+//! @param [in] dataId The data variable id
+//! @param [in] decimation The decimation factor, 0 disables logging of the variable
+void Port::setVariableLogDecimation(const size_t dataId, const size_t decimation)
+{
+    if (dataId >= mVariableLogDecimations.size())
+    {
+        // Nothing to store if default value is requested
+        if (decimation == 1)
+        {
+            return;
+        }
+        mVariableLogDecimations.resize(dataId+1, 1);
+    }
+    mVariableLogDecimations[dataId] = decimation;
+}
+
+//! @brief Get the log decimation factor for an individual data variable
+//! @param [in] dataId The data variable id
+//! @returns The decimation factor, 0 if logging of the variable is disabled
+size_t Port::getVariableLogDecimation(const size_t dataId) const
+{
+    if (dataId < mVariableLogDecimations.size())
+    {
+        return mVariableLogDecimations[dataId];
+    }
+    return 1;
+}
+
 //! @brief Get all node data descriptions
 //! @param [in] subPortIdx Ignored on non multi ports
 //! @returns A const pointer to the internal node vector with node data descriptions
@@ -569,24 +613,31 @@ vector<double> *Port::getLogTimeVectorPtr(const size_t subPortIdx)
     return 0; //Nothing found return 0
 }
 
+//! @brief Get the log data for one data variable
+//! @param [in] dataId The data variable id
 //! @param [in] subPortIdx Ignored on non multi ports
-vector<vector<double> > *Port::getLogDataVectorPtr(size_t subPortIdx)
+//! @returns Pointer to the log data vector, 0 if the variable is not logged
+//! @note Element t/getLogDataDecimation() in the vector corresponds to log slot t in the log time vector
+const std::vector<double> *Port::getLogDataVariablePtr(const size_t dataId, const size_t subPortIdx) const
 {
-    // TODO use const cast maybe
     HOPSAN_UNUSED(subPortIdx)
     if (mpNode != 0) {
-        return &(mpNode->mDataStorage);
+        return mpNode->getLogDataVariablePtr(dataId);
     }
     else {
         return 0;
     }
 }
 
-const std::vector<std::vector<double> > *Port::getLogDataVectorPtr(size_t subPortIdx) const
+//! @brief Get the log decimation factor for one data variable
+//! @param [in] dataId The data variable id
+//! @param [in] subPortIdx Ignored on non multi ports
+//! @returns The decimation factor, 0 if the variable is not logged
+size_t Port::getLogDataDecimation(const size_t dataId, const size_t subPortIdx) const
 {
     HOPSAN_UNUSED(subPortIdx)
     if (mpNode != 0) {
-        return &(mpNode->mDataStorage);
+        return mpNode->getLogDataDecimation(dataId);
     }
     else {
         return 0;
@@ -599,7 +650,7 @@ bool Port::isInterfacePort() const
 }
 
 //! @param [in] subPortIdx Ignored on non multi ports
-vector<double> *Port::getDataVectorPtr(const size_t subPortIdx)
+NodeDataVector *Port::getDataVectorPtr(const size_t subPortIdx)
 {
     HOPSAN_UNUSED(subPortIdx)
     if(mpNode != 0)
@@ -1139,19 +1190,18 @@ std::vector<double> *MultiPort::getLogTimeVectorPtr(const size_t subPortIdx)
     return 0;
 }
 
-std::vector<std::vector<double> > *MultiPort::getLogDataVectorPtr(const size_t subPortIdx)
+const std::vector<double> *MultiPort::getLogDataVariablePtr(const size_t dataId, const size_t subPortIdx) const
 {
-    if (isConnected())
-    {
-        return mSubPortsVector[subPortIdx]->getLogDataVectorPtr();
+    if (isConnected()) {
+        return mSubPortsVector[subPortIdx]->getLogDataVariablePtr(dataId);
     }
     return 0;
 }
 
-const std::vector<std::vector<double> > *MultiPort::getLogDataVectorPtr(size_t subPortIdx) const
+size_t MultiPort::getLogDataDecimation(const size_t dataId, const size_t subPortIdx) const
 {
     if (isConnected()) {
-        return mSubPortsVector[subPortIdx]->getLogDataVectorPtr();
+        return mSubPortsVector[subPortIdx]->getLogDataDecimation(dataId);
     }
     return 0;
 }
@@ -1163,7 +1213,7 @@ void MultiPort::setEnableLogging(const bool enableLog)
 }
 
 
-std::vector<double> *MultiPort::getDataVectorPtr(const size_t subPortIdx)
+NodeDataVector *MultiPort::getDataVectorPtr(const size_t subPortIdx)
 {
     if (isConnected())
     {
@@ -901,20 +901,26 @@ void CoreSystemAccess::getPlotData(const QString compname, const QString portnam
         dataId = pPort->getNodeDataIdFromName(dataname.toStdString().c_str());
         if (dataId > -1)
         {
-            std::vector< std::vector<double> > *pData = pPort->getLogDataVectorPtr();
+            const std::vector<double> *pData = pPort->getLogDataVariablePtr(dataId);
+            const size_t decimation = pPort->getLogDataDecimation(dataId);
             rpTimeVector = pPort->getLogTimeVectorPtr();
+            if (!pData)
+            {
+                rData.clear();
+                return;
+            }
 
             // Instead of pData.size() lets ask for latest logsample, this way we can avoid coping log slots that have not bee written and contains junk
             // This is useful when a simulation has been aborted
             size_t nElements;
             if (pPort->getNodePtr())
             {
-                nElements = qMin(pPort->getNodePtr()->getOwnerSystem()->getNumActuallyLoggedSamples(), pData->size());
+                nElements = qMin(pPort->getNodePtr()->getOwnerSystem()->getNumActuallyLoggedSamples(), pData->size()*decimation);
             }
             else
             {
                 // this should never happen i think
-                nElements = qMin(pData->size(), rpTimeVector->size());
+                nElements = qMin(pData->size()*decimation, rpTimeVector->size());
             }
             //size_t nElements = min(pPort->getNodegetComponent()->getSystemParent()->getNumActuallyLoggedSamples(), pData->size());
             //qDebug() << "pData.size(): " << pData->size() << " nElements: " << nElements;
@@ -923,7 +929,8 @@ void CoreSystemAccess::getPlotData(const QString compname, const QString portnam
             rData.resize(nElements); //Allocate memory for data
             for (size_t i=0; i<nElements; ++i)
             {
-                rData[i] = pData->at(i).at(dataId);
+                // Decimated variables are held constant between their samples
+                rData[i] = (*pData)[i/decimation];
             }
         }
     }
@@ -971,7 +978,7 @@ bool CoreSystemAccess::getLastNodeData(const QString compname, const QString por
 
         if (dataId >= 0)
         {
-            std::vector<double> *pData = pPort->getDataVectorPtr();
+            hopsan::NodeDataVector *pData = pPort->getDataVectorPtr();
             rData = pData->at(dataId);
             return true;
         }
@@ -4274,6 +4274,9 @@ void HcomHandler::executeGetCommand(const QString cmd)
         case hopsan::ClusteredForkJoinAlgorithm :
             output.append("clustered fork-join scheduling");
             break;
+        case hopsan::APrioriHybridBarrierScheduling :
+            output.append("a priori scheduling (hybrid barrier)");
+            break;
         default :
             output.append("unknown ("+QString::number(getConfigPtr()->getParallelAlgorithm())+")");
             break;
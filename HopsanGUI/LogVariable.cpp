@@ -38,6 +38,7 @@
 #include "Utilities/GUIUtilities.h"
 #include "LogDataGeneration.h"
 #include "MessageHandler.h"
+#include "CoreUtilities/SignalAnalysis.h"
 
 #include <limits>
 #include <algorithm>
@@ -707,6 +708,30 @@ bool VectorVariable::isAutoremovalAllowed() const
     return mAllowAutoRemove;
 }
 
+//! @brief Returns the HopsanCore spectrum analysis window corresponding to a windowing function
+static hopsan::SpectrumAnalyzer::WindowT toAnalyzerWindow(const WindowingFunctionEnumT windowingFunction)
+{
+    switch (windowingFunction)
+    {
+    case HannWindow:
+        return hopsan::SpectrumAnalyzer::Hann;
+    case FlatTopWindow:
+        return hopsan::SpectrumAnalyzer::FlatTop;
+    default:
+        return hopsan::SpectrumAnalyzer::Rectangular;
+    }
+}
+
+//! @brief Returns the sample frequency of equidistant samples
+static double sampleFrequency(const QVector<double> &rTime)
+{
+    if ((rTime.size() < 2) || !(rTime.last() > rTime.first()))
+    {
+        return 0;
+    }
+    return double(rTime.size()-1)/(rTime.last()-rTime.first());
+}
+
 SharedVectorVariableT VectorVariable::toFrequencySpectrum(const SharedVectorVariableT pTime, const FrequencySpectrumEnumT type, const WindowingFunctionEnumT windowingFunction, double minTime, double maxTime)
 {
     if(pTime)
@@ -727,66 +752,35 @@ SharedVectorVariableT VectorVariable::toFrequencySpectrum(const SharedVectorVari
         //Limit data to specified range
         limitVectorToRange(time, data, minTime, maxTime);
 
-        //Shift time vector so that time starts at zero (does not matter for the frequency, but is required for computations below)
-        if(!time.isEmpty() && time[0] != 0) {
-            double offest = time[0];
-            for(int i=0; i<time.size(); ++i) {
-                time[i] -= offest;
-            }
+        // The power and energy spectra are densities, the RMS spectrum gives the RMS value of sinusoids
+        hopsan::SpectrumAnalyzer::ScalingT scaling = hopsan::SpectrumAnalyzer::PowerSpectralDensity;
+        if(type == EnergySpectrum) {
+            scaling = hopsan::SpectrumAnalyzer::EnergySpectralDensity;
+        }
+        else if(type == RMSSpectrum) {
+            scaling = hopsan::SpectrumAnalyzer::RmsSpectrum;
         }
 
-        // Vector size has to be an even potential of 2.
-        // Calculate largest potential that is smaller than or equal to the vector size.
-#ifndef Q_OS_OSX
-        const int n = pow(2, int(log2(data.size()))); // This is odd.... /magse
-#else
-        const int n = (int)round(ldexp(2.0, int(log2(data.size()))));
-#endif
-        if(n != data.size())     // Vector is not an exact potential, so reduce it
+        // The whole signal is transformed as one windowed segment, any number of samples is supported
+        hopsan::SpectrumAnalyzer analyzer;
+        analyzer.setWindow(toAnalyzerWindow(windowingFunction));
+        std::vector<double> frequency, spectrum;
+        if (!analyzer.spectrum(data.toStdVector(), sampleFrequency(time), scaling, frequency, spectrum))
         {
-            QString oldString, newString;
-            oldString.setNum(data.size());
-            newString.setNum(n);
-            resampleVector(data, n);
-            resampleVector(time, n);
+            gpMessageHandler->addErrorMessage(QString("Could not compute the frequency spectrum: %1").arg(analyzer.getLastError().c_str()));
+            return SharedVectorVariableT();
         }
 
-        //Apply window function
-        double Ca, Cb;
-        windowFunction(data, windowingFunction, Ca, Cb);
-
-        // Create a complex vector
-        QVector< std::complex<double> > vComplex = realToComplex(data);
-
-        // Apply the fourier transform
-        FFT(vComplex);
-
-        // Scalar multiply complex vector with its conjugate, and divide it with its size
-        // Also build frequency vector
+        // Skip f=0, but include the Nyquist frequency
         DataVectorT freq, mag;
-        freq.reserve(n/2);
-        mag.reserve(n/2);
-        const double maxt = time.last();
-
-        // FFT is symmetric, so only use first half
-        // Also skip f=0, but include n/2 (nyquist)
-        double fs = time.size()/maxt;     //Sampling frequency
-        for(int i=1; i<=n/2; ++i)
+        freq.reserve(int(frequency.size()));
+        mag.reserve(int(spectrum.size()));
+        for(size_t k=1; k<frequency.size(); ++k)
         {
-            double tempMag;
-            if(type == RMSSpectrum) {
-                tempMag = M_SQRT2*abs(vComplex[i])/(n*Ca);
-            }
-            else if(type == PowerSpectrum) {
-                tempMag = real(vComplex[i]*conj(vComplex[i]))/(n*Cb*fs*Ca*Ca);
-            }
-            else if(type == EnergySpectrum) {
-                tempMag = real(vComplex[i]*conj(vComplex[i]))*maxt/(n*Cb*fs*Ca*Ca);
-            }
-            mag.append(tempMag);
+            mag.append(spectrum[k]);
 
             // Build freq vector, Hopsan uses rad/s as base unit for frequency
-            freq.append(2.0*M_PI*(double(i)/maxt));
+            freq.append(2.0*M_PI*frequency[k]);
         }
 
         SharedVariableDescriptionT pDesc(new VariableDescription());
@@ -1758,7 +1752,7 @@ void createBodeVariables(const SharedVectorVariableT pInput, const SharedVectorV
 
     //Limit vectors by min and max time
     QVector<double> vTimeIn = pInput->getSharedTimeOrFrequencyVector()->getDataVectorCopy();
-    QVector<double> vTimeOut = pInput->getSharedTimeOrFrequencyVector()->getDataVectorCopy();
+    QVector<double> vTimeOut = pOutput->getSharedTimeOrFrequencyVector()->getDataVectorCopy();
     limitVectorToRange(vTimeIn, vRealIn, minTime, maxTime);
     limitVectorToRange(vTimeOut, vRealOut, minTime, maxTime);
 
@@ -1769,102 +1763,38 @@ void createBodeVariables(const SharedVectorVariableT pInput, const SharedVectorV
         return;
     }
 
-    // Reduce vector size if they are not equal to an even potential of 2, and inform user
-#ifndef Q_OS_OSX
-        int n = pow(2, int(log2(vRealOut.size()))); // Odd.... /magse
-#else
-        int n = (int)round(ldexp(2.0, int(log2(vRealOut.size()))));
-#endif
-    if(n != vRealOut.size())     //Vector is not an exact potential, so reduce it
-    {
-        QString oldString, newString;
-        oldString.setNum(vRealOut.size());
-        newString.setNum(n);
-        //QMessageBox::information(gpMainWindowWidget, QWidget::tr("Wrong Vector Size"), "Size of data vector must be an even power of 2. Number of log samples was reduced from " + oldString + " to " + newString + ".");
-        resampleVector(vRealOut, n);
-        resampleVector(vRealIn, n);
-    }
-
-    //Apply window function
-    double Ca, Cb;  //Not used in  Bode plots
-    windowFunction(vRealIn, windowType, Ca, Cb);
-    windowFunction(vRealOut, windowType, Ca, Cb);
-
-    //Create complex vectors
-    QVector< std::complex<double> > vCompIn = realToComplex(vRealIn);
-    QVector< std::complex<double> > vCompOut = realToComplex(vRealOut);
-
-    //Apply the fourier transforms
-    FFT(vCompOut);
-    FFT(vCompIn);
-
-    // Calculate the transfer function G and then the bode vectors
-    QVector< std::complex<double> > G;
-    QVector<double> vRe, vIm, vImNeg, vBodeGain, vBodePhase, vBodePhaseUncorrected, freq;
-    // Reserve memory
-    G.reserve(vCompIn.size()/2);
-    vRe.reserve(vCompIn.size()/2);
-    vIm.reserve(vCompIn.size()/2);
-    vImNeg.reserve(vCompIn.size()/2);
-    vBodeGain.reserve(vCompIn.size()/2);
-    vBodePhase.reserve(vCompIn.size()/2);
-    vBodePhaseUncorrected.reserve(vCompIn.size()/2);
-    freq.reserve(vCompIn.size()/2);
-
-    double phaseCorrection=0;
-    for(int i=0; i<vCompIn.size()/2; ++i)
-    {
-        if(vCompIn[i] == std::complex<double>(0,0))        //Check for division by zero
-        {
-            G.append(G[i-1]);    //!< @warning This is not a good solution, and what if i=0?
-        }
-        else
-        {
-            G.append(vCompOut[i]/vCompIn[i]);                  //G(iw) = FFT(Y(iw))/FFT(X(iw))
-        }
-
-        if(i>0)
-        {
-            vRe.append(G[i].real());
-            vIm.append(G[i].imag());
-            vImNeg.append(-G[i].imag());
-            vBodeGain.append( std::abs(G[i]) );                         // Gain: abs(G) = sqrt(R^2 + X^2)
-            vBodePhaseUncorrected.append( rad2deg(std::arg(G[i])) );    // Phase: arg(G) = arctan(X/R) in deg
-
-            // Correct the phase plot to make it continuous (because atan2 is limited from -180 to +180)
-            if(vBodePhaseUncorrected.size() > 1)
-            {
-                //! @todo there is a risk here that the skip from +-180 to -+180 is missed if the value lies below (abs) 170
-                if( (vBodePhaseUncorrected.last() > 170) && (vBodePhaseUncorrected[vBodePhaseUncorrected.size()-2] < -170) )
-                {
-                    phaseCorrection -= 360;
-                }
-                else if( (vBodePhaseUncorrected.last() < -170) && (vBodePhaseUncorrected[vBodePhaseUncorrected.size()-2] > 170) )
-                {
-                    phaseCorrection += 360;
-                }
-            }
-            vBodePhase.append(deg2rad(vBodePhaseUncorrected.last() + phaseCorrection));
-        }
+    // Estimate the transfer function from the whole signals, as one windowed segment
+    hopsan::SpectrumAnalyzer analyzer;
+    analyzer.setWindow(toAnalyzerWindow(windowType));
+    std::vector<double> frequency, gain, phase;
+    std::vector< std::complex<double> > transferFunction;
+    if (!analyzer.transferFunction(vRealIn.toStdVector(), vRealOut.toStdVector(), sampleFrequency(vTimeIn), frequency, transferFunction))
+    {
+        QMessageBox::warning(gpMainWindowWidget, QWidget::tr("Transfer Function"), QString(analyzer.getLastError().c_str()));
+        return;
     }
+    hopsan::bodeFromTransferFunction(transferFunction, gain, phase);
 
-    // Build the frequency vector
-    const double stoptime = pInput->getSharedTimeOrFrequencyVector()->last();
-    // We skip f=0
-    for(int i=1; i<G.size(); ++i)
+    // Build the Nyquist and Bode vectors, we skip f=0
+    QVector<double> vRe, vIm, vImNeg, vBodeGain, vBodePhase, freq;
+    vRe.reserve(int(transferFunction.size()));
+    vIm.reserve(int(transferFunction.size()));
+    vImNeg.reserve(int(transferFunction.size()));
+    for(size_t k=1; k<transferFunction.size(); ++k)
     {
-        freq.append(double(i)/stoptime);
-        // Abort if we reach the desired max frequency
-        if(freq.last() >= Fmax)
+        vRe.append(transferFunction[k].real());
+        vIm.append(transferFunction[k].imag());
+        vImNeg.append(-transferFunction[k].imag());
+
+        // The Bode diagram ends at the first frequency that reaches the desired max frequency
+        if(freq.isEmpty() || freq.last() < Fmax)
         {
-            // Truncate the output vectors if we aborted due to Fmax
-            vBodeGain.resize(freq.size());
-            vBodePhase.resize(freq.size());
-            break;
+            freq.append(frequency[k]);
+            vBodeGain.append(gain[k]);      // Gain: abs(G) = sqrt(R^2 + X^2)
+            vBodePhase.append(phase[k]);    // Phase: arg(G) in rad, unwrapped to be continuous
         }
     }
 
-
     // Create the output variables for nyquist plots
     //! @todo add description to description, (what was the data based on)
     SharedVariableDescriptionT pNyquistDesc(new VariableDescription()); pNyquistDesc->mDataName = "Nyquist";
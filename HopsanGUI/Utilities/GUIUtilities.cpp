@@ -57,6 +57,7 @@
 #include "Configuration.h"
 #include "DesktopHandler.h"
 #include "CoreUtilities/HmfLoader.h"
+#include "CoreUtilities/SignalAnalysis.h"
 #include "Widgets/LibraryWidget.h"
 #include "MessageHandler.h"
 
@@ -429,82 +430,12 @@ void windowFunction(QVector<double> &data, WindowingFunctionEnumT function, doub
 
 
 //! @brief Forward fast fourier transform
-//! Transforms given vector into its fourier transform.
-//! Even elements in the vector represents real numbers, and odd imaginary numbers.
-//! Original source:
-//! V. Myrnyy, A Simple and Efficient FFT Implementation in C++, Dr.Dobbs, 2007
-//! http://drdobbs.com/cpp/199500857
+//! Transforms given vector into its fourier transform, using the mixed-radix transform in HopsanCore so that any size is supported.
 //! @param data Vector with data
 void FFT(QVector< complex<double> > &data)
 {
-    unsigned long n = data.size();
-
-    qDebug() << "FFT of vector with size " << n;
-
-    unsigned long mmax, m, j, istep, i;
-    double wtemp, wr, wpr, wpi, wi, theta;
-    double tempr, tempi;
-
-    // Reverse-binary reindexing
-    j=1;
-    for (i=0; i<n; ++i)
-    {
-        if (j>i)
-        {
-#if __cplusplus >= 201103L // magse Värre än så. swap har flyttat från <algorithm> till <utility> i C++11
-            swap(data[j-1],  data[i]);
-#else
-            swap(data[j-1].real(), data[i].real());     // Even numbers
-            swap(data[j-1].imag(), data[i].imag());     // Odd numbers
-#endif
-        }
-        m = n>>1;
-        while (m>=2 && j>m)
-        {
-            j -= m;
-            m >>= 1;    //m = m/2
-        }
-        j += m;
-    };
-
-    // Here begins the Danielson-Lanczos section
-    mmax=1;
-    while (n>mmax)
-    {
-        istep = mmax<<1;
-        theta = -(M_PI/mmax);
-        wtemp = sin(0.5*theta);
-        wpr = -2.0*wtemp*wtemp;
-        wpi = sin(theta);
-        wr = 1.0;
-        wi = 0.0;
-        for (m=0; m < mmax; m++)
-        {
-            for (i=m; i < n; i += istep)
-            {
-                j=i+mmax;
-                tempr = wr*data[j].real() - wi*data[j].imag();
-                tempi = wr*data[j].imag() + wi*data[j].real();
-
-#if __cplusplus >= 201103L
-                data[j].real(data[i].real() - tempr);
-                data[j].imag(data[i].imag() - tempi);
-                data[i].real(data[i].real() + tempr);
-                data[i].imag(data[i].imag() + tempi);
-#else
-                data[j].real() = data[i].real() - tempr;
-                data[j].imag() = data[i].imag() - tempi;
-                data[i].real() += tempr;
-                data[i].imag() += tempi;
-#endif
-            }
-            wtemp=wr;
-            wr += wr*wpr - wi*wpi;
-            wi += wi*wpr + wtemp*wpi;
-        }
-        mmax=istep;
-    }
-    qDebug () << "FFT successful!";
+    hopsan::ComplexFFT fft(data.size());
+    fft.forward(data.data());
 }
 
 
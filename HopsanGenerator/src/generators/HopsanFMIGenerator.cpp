@@ -611,6 +611,8 @@ bool HopsanFMIGenerator::generateModelDescriptionXmlFile(ComponentSystem *pSyste
         mdWriter.writeStartElement("CoSimulation");
         mdWriter.writeAttribute("modelIdentifier", modelName);
         mdWriter.writeAttribute("canHandleVariableCommunicationStepSize", "true");
+        mdWriter.writeAttribute("canGetAndSetFMUstate", "true");
+        mdWriter.writeAttribute("canSerializeFMUstate", "true");
         mdWriter.writeEndElement(); //CoSimulation
 
 
@@ -754,6 +756,8 @@ bool HopsanFMIGenerator::generateModelDescriptionXmlFile(ComponentSystem *pSyste
         mdWriter.writeAttribute("modelIdentifier", modelName);
         mdWriter.writeAttribute("providesIntermediateUpdate", "false");
         mdWriter.writeAttribute("canHandleVariableCommunicationStepSize", "true");
+        mdWriter.writeAttribute("canGetAndSetFMUState", "true");
+        mdWriter.writeAttribute("canSerializeFMUState", "true");
         mdWriter.writeAttribute("hasEventMode", "false");
         mdWriter.writeEndElement(); //CoSimulation
 
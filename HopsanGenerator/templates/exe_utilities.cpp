@@ -147,17 +147,18 @@ void saveResults(ComponentSystem *pSys, const string &rFileName, const SaveResul
                             {
                                 // Only write something if data has been logged (skip ports that are not logged)
                                 // We assume that the data vector has been cleared
-                                if (pPort->getLogDataVectorPtr()->size() > 0)
+                                const vector<double> *pLogData = pPort->getLogDataVariablePtr(v);
+                                if (pLogData != 0)
                                 {
                                     *pFile << fullname.c_str();
                                     if(descriptions == NameAliasUnit) {
                                         *pFile << "," << pPort->getVariableAlias(v).c_str() << "," << pVars->at(v).unit.c_str();
                                     }
                                     //! @todo what about time vector
-                                    vector< vector<double> > *pLogData = pPort->getLogDataVectorPtr();
+                                    const size_t decimation = pPort->getLogDataDecimation(v);
                                     for (size_t t=0; t<pSys->getNumActuallyLoggedSamples(); ++t)
                                     {
-                                        *pFile << "," << std::scientific << (*pLogData)[t][v];
+                                        *pFile << "," << std::scientific << (*pLogData)[t/decimation];
                                     }
                                     *pFile << endl;
                                 }
@@ -9,6 +9,7 @@
 #include <stdio.h>
 #include <string>
 #include <string.h>
+#include <vector>
 
 enum fmuStateT { Started, Instantiated, Initializing, Initialized };
 fmuStateT state = Started;
@@ -388,25 +389,47 @@ fmi2Status fmi2SetString(fmi2Component c,
     return fmi2Error;
 }
 
+// The FMU state is the complete Hopsan simulation state (time, node data and component internal state) in a byte buffer
+typedef std::vector<char> fmuStateBuffer;
+
 fmi2Status fmi2GetFMUstate (fmi2Component c, fmi2FMUstate* FMUstate)
 {
-    UNUSED(c);
-    UNUSED(FMUstate);
-    return fmi2Error;
+    fmuContext *fmu = (fmuContext*)c;
+    if(fmu == NULL || FMUstate == NULL) {
+        return fmi2Error;
+    }
+
+    // Reuse the state buffer if the master passes in a previously allocated state
+    fmuStateBuffer *pState = (fmuStateBuffer*)(*FMUstate);
+    if(pState == NULL) {
+        pState = new fmuStateBuffer();
+    }
+    fmu->pSystem->saveSimulationState(*pState);
+    *FMUstate = (fmi2FMUstate)pState;
+    return fmi2OK;
 }
 
 fmi2Status fmi2SetFMUstate (fmi2Component c, fmi2FMUstate FMUstate)
 {
-    UNUSED(c);
-    UNUSED(FMUstate);
-    return fmi2Error;
+    fmuContext *fmu = (fmuContext*)c;
+    if(fmu == NULL || FMUstate == NULL) {
+        return fmi2Error;
+    }
+
+    bool ok = fmu->pSystem->restoreSimulationState(*(fmuStateBuffer*)FMUstate);
+    get_all_hopsan_messages(fmu);
+    return ok ? fmi2OK : fmi2Error;
 }
 
 fmi2Status fmi2FreeFMUstate(fmi2Component c, fmi2FMUstate* FMUstate)
 {
     UNUSED(c);
-    UNUSED(FMUstate);
-    return fmi2Error;
+    if(FMUstate == NULL) {
+        return fmi2OK;
+    }
+    delete (fmuStateBuffer*)(*FMUstate);
+    *FMUstate = NULL;
+    return fmi2OK;
 }
 
 fmi2Status fmi2SerializedFMUstateSize(fmi2Component c,
@@ -414,19 +437,28 @@ fmi2Status fmi2SerializedFMUstateSize(fmi2Component c,
                                       size_t *size)
 {
     UNUSED(c);
-    UNUSED(FMUstate);
-    UNUSED(size);
-    return fmi2Error;
+    if(FMUstate == NULL || size == NULL) {
+        return fmi2Error;
+    }
+    *size = ((fmuStateBuffer*)FMUstate)->size();
+    return fmi2OK;
 }
 
 fmi2Status fmi2SerializeFMUstate (fmi2Component c, fmi2FMUstate FMUstate,
                                  fmi2Byte serializedState[], size_t size)
 {
     UNUSED(c);
-    UNUSED(FMUstate);
-    UNUSED(serializedState);
-    UNUSED(size);
-    return fmi2Error;
+    if(FMUstate == NULL) {
+        return fmi2Error;
+    }
+    const fmuStateBuffer *pState = (fmuStateBuffer*)FMUstate;
+    if(size < pState->size()) {
+        return fmi2Error;
+    }
+    if(!pState->empty()) {
+        memcpy(serializedState, &(*pState)[0], pState->size());
+    }
+    return fmi2OK;
 }
 
 fmi2Status fmi2DeSerializeFMUstate (fmi2Component c,
@@ -434,10 +466,18 @@ fmi2Status fmi2DeSerializeFMUstate (fmi2Component c,
                                    size_t size, fmi2FMUstate* FMUstate)
 {
     UNUSED(c);
-    UNUSED(serializedState);
-    UNUSED(size);
-    UNUSED(FMUstate);
-    return fmi2Error;
+    if(FMUstate == NULL || (serializedState == NULL && size > 0)) {
+        return fmi2Error;
+    }
+
+    // The state is validated against the model when it is set
+    fmuStateBuffer *pState = (fmuStateBuffer*)(*FMUstate);
+    if(pState == NULL) {
+        pState = new fmuStateBuffer();
+    }
+    pState->assign(serializedState, serializedState+size);
+    *FMUstate = (fmi2FMUstate)pState;
+    return fmi2OK;
 }
 
 fmi2Status fmi2GetDirectionalDerivative(fmi2Component c,
@@ -9,6 +9,7 @@
 #include <stdio.h>
 #include <string>
 #include <string.h>
+#include <vector>
 
 enum fmuStateT { Started, Instantiated, Initializing, Initialized };
 fmuStateT state = Started;
@@ -714,34 +715,86 @@ fmi3Status fmi3GetVariableDependencies(fmi3Instance, fmi3ValueReference, size_t[
     return fmi3Discard;
 }
 
-fmi3Status fmi3GetFMUState(fmi3Instance, fmi3FMUState*)
+// The FMU state is the complete Hopsan simulation state (time, node data and component internal state) in a byte buffer
+typedef std::vector<char> fmuStateBuffer;
+
+fmi3Status fmi3GetFMUState(fmi3Instance instance, fmi3FMUState* FMUState)
 {
-    return fmi3Discard;
+    fmuContext *fmu = (fmuContext*)instance;
+    if(fmu == NULL || FMUState == NULL) {
+        return fmi3Error;
+    }
+
+    // Reuse the state buffer if the importer passes in a previously allocated state
+    fmuStateBuffer *pState = (fmuStateBuffer*)(*FMUState);
+    if(pState == NULL) {
+        pState = new fmuStateBuffer();
+    }
+    fmu->pSystem->saveSimulationState(*pState);
+    *FMUState = (fmi3FMUState)pState;
+    return fmi3OK;
 }
 
-fmi3Status fmi3SetFMUState(fmi3Instance, fmi3FMUState)
+fmi3Status fmi3SetFMUState(fmi3Instance instance, fmi3FMUState FMUState)
 {
-    return fmi3Discard;
+    fmuContext *fmu = (fmuContext*)instance;
+    if(fmu == NULL || FMUState == NULL) {
+        return fmi3Error;
+    }
+
+    bool ok = fmu->pSystem->restoreSimulationState(*(fmuStateBuffer*)FMUState);
+    get_all_hopsan_messages(fmu);
+    return ok ? fmi3OK : fmi3Error;
 }
 
-fmi3Status fmi3FreeFMUState(fmi3Instance, fmi3FMUState*)
+fmi3Status fmi3FreeFMUState(fmi3Instance, fmi3FMUState* FMUState)
 {
-    return fmi3Discard;
+    if(FMUState == NULL) {
+        return fmi3OK;
+    }
+    delete (fmuStateBuffer*)(*FMUState);
+    *FMUState = NULL;
+    return fmi3OK;
 }
 
-fmi3Status fmi3SerializedFMUStateSize(fmi3Instance, fmi3FMUState, size_t*)
+fmi3Status fmi3SerializedFMUStateSize(fmi3Instance, fmi3FMUState FMUState, size_t* size)
 {
-    return fmi3Discard;
+    if(FMUState == NULL || size == NULL) {
+        return fmi3Error;
+    }
+    *size = ((fmuStateBuffer*)FMUState)->size();
+    return fmi3OK;
 }
 
-fmi3Status fmi3SerializeFMUState(fmi3Instance, fmi3FMUState, fmi3Byte[], size_t)
+fmi3Status fmi3SerializeFMUState(fmi3Instance, fmi3FMUState FMUState, fmi3Byte serializedState[], size_t size)
 {
-    return fmi3Discard;
+    if(FMUState == NULL) {
+        return fmi3Error;
+    }
+    const fmuStateBuffer *pState = (fmuStateBuffer*)FMUState;
+    if(size < pState->size()) {
+        return fmi3Error;
+    }
+    if(!pState->empty()) {
+        memcpy(serializedState, &(*pState)[0], pState->size());
+    }
+    return fmi3OK;
 }
 
-fmi3Status fmi3DeserializeFMUState(fmi3Instance, const fmi3Byte[], size_t, fmi3FMUState*)
+fmi3Status fmi3DeserializeFMUState(fmi3Instance, const fmi3Byte serializedState[], size_t size, fmi3FMUState* FMUState)
 {
-    return fmi3Discard;
+    if(FMUState == NULL || (serializedState == NULL && size > 0)) {
+        return fmi3Error;
+    }
+
+    // The state is validated against the model when it is set
+    fmuStateBuffer *pState = (fmuStateBuffer*)(*FMUState);
+    if(pState == NULL) {
+        pState = new fmuStateBuffer();
+    }
+    pState->assign(serializedState, serializedState+size);
+    *FMUState = (fmi3FMUState)pState;
+    return fmi3OK;
 }
 
 fmi3Status fmi3GetDirectionalDerivative(fmi3Instance, const fmi3ValueReference[], size_t,
@@ -38,6 +38,9 @@ win32 {
     DEFINES += OPS_DLLEXPORT
     DEFINES -= UNICODE
 }
+unix {
+    LIBS += -pthread
+}
 
 # -------------------------------------------------
 # Project files
@@ -49,6 +52,7 @@ SOURCES += \
     src/OpsWorkerComplexRF.cpp \
     src/OpsWorkerNelderMead.cpp \
     src/OpsEvaluator.cpp \
+    src/OpsAsyncEvaluator.cpp \
     src/OpsWorkerParticleSwarm.cpp \
     src/OpsWorkerComplexRFP.cpp \
     src/OpsWorkerParamterSweep.cpp \
@@ -65,6 +69,7 @@ HEADERS += \
     include/OpsWorkerComplexRF.h \
     include/OpsWorkerNelderMead.h \
     include/OpsEvaluator.h \
+    include/OpsAsyncEvaluator.h \
     include/OpsWorkerParticleSwarm.h \
     include/OpsWorkerComplexRFP.h \
     include/OpsWorkerParameterSweep.h \
@@ -0,0 +1,96 @@
+/*-----------------------------------------------------------------------------
+
+ Copyright 2017 Hopsan Group
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+
+ The full license is available in the file LICENSE.
+ For details about the 'Hopsan Group' or information about Authors and
+ Contributors see the HOPSANGROUP and AUTHORS files that are located in
+ the Hopsan source code root directory.
+
+-----------------------------------------------------------------------------*/
+
+//!
+//! @file   OpsAsyncEvaluator.h
+//!
+//! @brief Contains the optimization evaluator class with a thread pool for asynchronous candidate evaluation
+//!
+//$Id$
+
+#ifndef OPSASYNCEVALUATOR_H
+#define OPSASYNCEVALUATOR_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#include "OpsEvaluator.h"
+
+namespace Ops {
+
+//! @brief Evaluator with a pool of threads, one for each pre-loaded copy of the model
+//! @details Candidates are queued and evaluated by the first free thread, so one slow candidate does not keep the other
+//! threads idle. Sub classes implement evaluateCandidateWithModel(), which is called from the pool threads with the index
+//! of the model copy to use. With only one model copy, candidates are evaluated directly in the calling thread.
+//! The pool threads are stopped when all started candidates have been collected, so they do not outlive the evaluations. All
+//! started candidates must be waited for before the evaluator is destroyed.
+class OPS_DLLAPI AsyncEvaluator : public Evaluator
+{
+public:
+    AsyncEvaluator(size_t numModels);
+    ~AsyncEvaluator();
+
+    void evaluateCandidate(size_t idx);
+    void evaluateAllCandidates();
+    size_t getNumberOfParallelEvaluations();
+    void startCandidateEvaluation(size_t idx);
+    bool waitForCandidateEvaluation(size_t &rIdx);
+
+    size_t getNumberOfEvaluations();
+    double getEvaluationsPerSecond();
+    void resetStatistics();
+
+protected:
+    //! @brief Evaluate a candidate and set its objective value, called from the pool threads
+    //! @param idx Index of the candidate to evaluate
+    //! @param modelIdx Index of the model copy to use, only one candidate at a time is evaluated with each model copy
+    virtual void evaluateCandidateWithModel(size_t idx, size_t modelIdx) = 0;
+
+private:
+    void startThreads();
+    void stopThreads();
+    void candidateCollected(std::unique_lock<std::mutex> &rLock);
+    void threadLoop(size_t modelIdx);
+    void countEvaluation();
+
+    size_t mNumModels;
+    std::vector<std::thread> mThreads;
+    std::mutex mMutex;
+    std::condition_variable mWorkCondition, mDoneCondition;
+    std::deque<size_t> mQueuedCandidates, mDoneCandidates;
+    size_t mNumStarted;
+    bool mStopThreads;
+
+    size_t mNumEvaluations;
+    bool mHaveStartTime;
+    std::chrono::steady_clock::time_point mStartTime;
+};
+
+}
+
+#endif // OPSASYNCEVALUATOR_H
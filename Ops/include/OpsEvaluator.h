@@ -56,6 +56,9 @@ public:
     virtual void evaluateAllPoints();               //Can be re-implemented
     virtual void evaluateCandidate(size_t idx);        //Must be re-implemented
     virtual void evaluateAllCandidates();           //Can be re-implemented
+    virtual size_t getNumberOfParallelEvaluations();            //Can be re-implemented
+    virtual void startCandidateEvaluation(size_t idx);          //Can be re-implemented
+    virtual bool waitForCandidateEvaluation(size_t &rIdx);      //Can be re-implemented
     void evaluateAllPointsWithSurrogateModel();
     bool evaluateAllCandidatesWithSurrogateModel();
     void evaluateCandidateWithSurrogateModel(size_t idx);
@@ -81,6 +84,8 @@ private:
     bool mSurrogateModelExist;
     size_t mSurrogateModelEvaluations;
     bool mSurrogateModelInitialized;
+
+    std::deque<size_t> mFinishedCandidates;
 };
 
 }
@@ -117,6 +117,8 @@ public:
     void setTolerance(double value);
     void setSamplingMethod(SamplingT dist);
     void setUseSurrogateModel(size_t interval);
+    void setUseAsynchronousEvaluation(bool value);
+    bool getUseAsynchronousEvaluation() const;
 
     size_t getNumberOfCandidates();
     size_t getNumberOfPoints();
@@ -148,6 +150,7 @@ protected:
     std::vector<std::pair<size_t,size_t>> mIgnoredWhenSampling;
     bool mUseSurrogateModel;
     size_t mNumSurrogateModelUpdateInterval;
+    bool mUseAsynchronousEvaluation;
 };
 
 }
@@ -76,6 +76,10 @@ private:
 
     bool multiRetract();
 
+    void runAsynchronous();
+    void startAsyncReflection(size_t i);
+    void startAsyncRetraction(size_t i);
+
     Candidate *mpFailedCandidate;
 
     double mAlphaMin, mAlphaMax;
@@ -86,6 +90,12 @@ private:
     //Method 3 members
     size_t mnPredictions, mnRetractions;
     size_t mDistCount, mDirCount, mIterCount;
+
+    //Asynchronous evaluation members
+    std::vector<size_t> mAsyncTargets;
+    std::vector<size_t> mAsyncRetractions;
+    std::vector< std::vector<double> > mAsyncCentroids;
+    std::vector<bool> mAsyncInFlight;
 };
 
 }
@@ -47,6 +47,10 @@ public:
 
     virtual void initialize();
     virtual void run();
+
+private:
+    void runAsynchronous();
+    void generateCandidate(size_t i);
 };
 
 }
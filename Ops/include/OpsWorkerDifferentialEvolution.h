@@ -55,6 +55,8 @@ protected:
     double mCR, mF;
     void getRandomIds(size_t notId, size_t &id1, size_t &id2, size_t &id3, size_t &id4);
     bool isCandidateFeasible(int id);
+    void generateCandidate(size_t p);
+    void runAsynchronous();
 };
 
 }
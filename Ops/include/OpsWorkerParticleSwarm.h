@@ -76,6 +76,8 @@ protected:
 
 private:
     void moveParticle(int p);
+    void runAsynchronous();
+    bool updateInertiaWeight();
 protected:
     double mRandomFactor;
 
@@ -0,0 +1,234 @@
+/*-----------------------------------------------------------------------------
+
+ Copyright 2017 Hopsan Group
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+
+ The full license is available in the file LICENSE.
+ For details about the 'Hopsan Group' or information about Authors and
+ Contributors see the HOPSANGROUP and AUTHORS files that are located in
+ the Hopsan source code root directory.
+
+-----------------------------------------------------------------------------*/
+
+//!
+//! @file   OpsAsyncEvaluator.cpp
+//!
+//! @brief Contains the optimization evaluator class with a thread pool for asynchronous candidate evaluation
+//!
+//$Id$
+
+#include "OpsAsyncEvaluator.h"
+#include "OpsWorker.h"
+
+#include <algorithm>
+
+using namespace Ops;
+
+//! @brief Constructor
+//! @param numModels Number of model copies, one thread is used for each
+AsyncEvaluator::AsyncEvaluator(size_t numModels)
+    : Evaluator()
+{
+    mNumModels = std::max(numModels, size_t(1));
+    mNumStarted = 0;
+    mStopThreads = false;
+    mNumEvaluations = 0;
+    mHaveStartTime = false;
+}
+
+AsyncEvaluator::~AsyncEvaluator()
+{
+    stopThreads();
+}
+
+
+//! @brief Evaluates one candidate and waits for the result
+//! @details Other candidates that finish meanwhile are kept, they are returned by waitForCandidateEvaluation()
+void AsyncEvaluator::evaluateCandidate(size_t idx)
+{
+    startCandidateEvaluation(idx);
+    std::unique_lock<std::mutex> lock(mMutex);
+    std::deque<size_t>::iterator it;
+    mDoneCondition.wait(lock, [this, idx, &it]{
+        it = std::find(mDoneCandidates.begin(), mDoneCandidates.end(), idx);
+        return it != mDoneCandidates.end();
+    });
+    mDoneCandidates.erase(it);
+    candidateCollected(lock);
+}
+
+
+//! @brief Evaluates all candidates, distributed over all model copies
+void AsyncEvaluator::evaluateAllCandidates()
+{
+    for(size_t i=0; i<mpWorker->getNumberOfCandidates() && !mpWorker->aborted(); ++i)
+    {
+        startCandidateEvaluation(i);
+    }
+    size_t doneIdx;
+    while(waitForCandidateEvaluation(doneIdx)) {}
+}
+
+
+size_t AsyncEvaluator::getNumberOfParallelEvaluations()
+{
+    return mNumModels;
+}
+
+
+void AsyncEvaluator::startCandidateEvaluation(size_t idx)
+{
+    if(!mHaveStartTime)
+    {
+        mStartTime = std::chrono::steady_clock::now();
+        mHaveStartTime = true;
+    }
+
+    if(mNumModels == 1)
+    {
+        evaluateCandidateWithModel(idx, 0);
+        countEvaluation();
+        std::lock_guard<std::mutex> lock(mMutex);
+        mDoneCandidates.push_back(idx);
+        ++mNumStarted;
+        return;
+    }
+
+    if(mThreads.empty())
+    {
+        startThreads();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQueuedCandidates.push_back(idx);
+        ++mNumStarted;
+    }
+    mWorkCondition.notify_one();
+}
+
+
+bool AsyncEvaluator::waitForCandidateEvaluation(size_t &rIdx)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    if(mNumStarted == 0)
+    {
+        return false;
+    }
+    mDoneCondition.wait(lock, [this]{return !mDoneCandidates.empty();});
+    rIdx = mDoneCandidates.front();
+    mDoneCandidates.pop_front();
+    candidateCollected(lock);
+    return true;
+}
+
+
+//! @brief Returns the number of evaluations since the evaluator was created or the statistics were reset
+size_t AsyncEvaluator::getNumberOfEvaluations()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mNumEvaluations;
+}
+
+
+//! @brief Returns the average number of evaluations per second (wall-clock), since the first evaluation was started
+double AsyncEvaluator::getEvaluationsPerSecond()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if(!mHaveStartTime)
+    {
+        return 0;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-mStartTime).count();
+    return (seconds > 0) ? double(mNumEvaluations)/seconds : 0;
+}
+
+
+void AsyncEvaluator::resetStatistics()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mNumEvaluations = 0;
+    mHaveStartTime = false;
+}
+
+
+void AsyncEvaluator::startThreads()
+{
+    mStopThreads = false;
+    for(size_t m=0; m<mNumModels; ++m)
+    {
+        mThreads.push_back(std::thread(&AsyncEvaluator::threadLoop, this, m));
+    }
+}
+
+
+//! @brief Lets the pool threads finish their current candidates, discards the queued ones and joins the threads
+void AsyncEvaluator::stopThreads()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopThreads = true;
+    }
+    mWorkCondition.notify_all();
+    for(size_t t=0; t<mThreads.size(); ++t)
+    {
+        mThreads[t].join();
+    }
+    mThreads.clear();
+}
+
+
+void AsyncEvaluator::threadLoop(size_t modelIdx)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    while(true)
+    {
+        mWorkCondition.wait(lock, [this]{return mStopThreads || !mQueuedCandidates.empty();});
+        if(mStopThreads)
+        {
+            break;
+        }
+        size_t idx = mQueuedCandidates.front();
+        mQueuedCandidates.pop_front();
+
+        lock.unlock();
+        evaluateCandidateWithModel(idx, modelIdx);
+        lock.lock();
+
+        ++mNumEvaluations;
+        mDoneCandidates.push_back(idx);
+        mDoneCondition.notify_all();
+    }
+}
+
+
+//! @brief Book keeping for a collected candidate, the pool threads are stopped when no started candidate remains
+//! @details The threads call evaluateCandidateWithModel() of the sub class, so they must not be running when the sub class
+//! is destroyed. The lock is released if the threads are stopped.
+void AsyncEvaluator::candidateCollected(std::unique_lock<std::mutex> &rLock)
+{
+    --mNumStarted;
+    if(mNumStarted == 0 && !mThreads.empty())
+    {
+        rLock.unlock();
+        stopThreads();
+    }
+}
+
+
+void AsyncEvaluator::countEvaluation()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    ++mNumEvaluations;
+}
@@ -128,6 +128,39 @@ void Evaluator::evaluateAllCandidates()
 }
 
 
+//! @brief Returns the number of candidates that can be evaluated at the same time
+size_t Evaluator::getNumberOfParallelEvaluations()
+{
+    return 1;
+}
+
+
+//! @brief Starts evaluation of a candidate, the default implementation evaluates it directly
+//! @details Used by algorithms with asynchronous evaluation, the candidate point must not be changed until the candidate
+//! has been returned by waitForCandidateEvaluation()
+//! @param idx Index of the candidate to evaluate
+void Evaluator::startCandidateEvaluation(size_t idx)
+{
+    evaluateCandidate(idx);
+    mFinishedCandidates.push_back(idx);
+}
+
+
+//! @brief Waits for any started candidate to be evaluated
+//! @param [out] rIdx Index of the evaluated candidate
+//! @returns False if there were no started candidates left
+bool Evaluator::waitForCandidateEvaluation(size_t &rIdx)
+{
+    if(mFinishedCandidates.empty())
+    {
+        return false;
+    }
+    rIdx = mFinishedCandidates.front();
+    mFinishedCandidates.pop_front();
+    return true;
+}
+
+
 bool Evaluator::evaluateAllCandidatesWithSurrogateModel()
 {
     if(!mpWorker->mUseSurrogateModel) {
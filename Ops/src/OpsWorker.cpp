@@ -67,6 +67,7 @@ Worker::Worker(Evaluator *pEvaluator, MessageHandler *pMessageHandler)
     mDistribution = SamplingRandom;
     mUseSurrogateModel = false;
     mNumSurrogateModelUpdateInterval = 20;
+    mUseAsynchronousEvaluation = false;
 
     mpEvaluator->setWorker(this);
 }
@@ -348,6 +349,19 @@ void Worker::setUseSurrogateModel(size_t interval)
     mNumSurrogateModelUpdateInterval = interval;
 }
 
+//! @brief Enables steady-state (asynchronous) evaluation, in algorithms that support it
+//! @details New candidates are generated and started as soon as any previous candidate has been evaluated, instead of
+//! waiting for a whole generation. Supported by differential evolution, particle swarm, Complex-RFP and controlled random search.
+void Worker::setUseAsynchronousEvaluation(bool value)
+{
+    mUseAsynchronousEvaluation = value;
+}
+
+bool Worker::getUseAsynchronousEvaluation() const
+{
+    return mUseAsynchronousEvaluation;
+}
+
 size_t Worker::getNumberOfCandidates()
 {
     return mNumCandidates;
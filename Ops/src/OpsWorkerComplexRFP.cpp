@@ -88,53 +88,60 @@ void WorkerComplexRFP::run()
 
     //Run optimization loop
     mIterationCounter=0;
-    for(; mIterationCounter<mnMaxIterations && !mpMessageHandler->aborted(); ++mIterationCounter)
+    if(mUseAsynchronousEvaluation)
     {
-        //Check convergence
-        if(checkForConvergence()) break;
-
-        //Increase all objective values (forgetting principle)
-        //applyForgettingFactor();
+        runAsynchronous();
+    }
+    else
+    {
+        for(; mIterationCounter<mnMaxIterations && !mpMessageHandler->aborted(); ++mIterationCounter)
+        {
+            //Check convergence
+            if(checkForConvergence()) break;
 
-        //Identify best and worst point
-        calculateBestAndWorstId();
+            //Increase all objective values (forgetting principle)
+            //applyForgettingFactor();
 
-        //Find geometrical center
-        findCentroidPoint();
+            //Identify best and worst point
+            calculateBestAndWorstId();
 
-        //Pick candidates (depending on algorithm)
-        pickCandidateParticles();
+            //Find geometrical center
+            findCentroidPoint();
 
-        //Evaluate candidates
-        mpEvaluator->evaluateAllCandidatesWithSurrogateModel();
+            //Pick candidates (depending on algorithm)
+            pickCandidateParticles();
 
-        //Examine outcome of evaluation (depending on algorithm)
-        examineCandidateParticles();
+            //Evaluate candidates
+            mpEvaluator->evaluateAllCandidatesWithSurrogateModel();
 
-        //Identify best and worst point
-        calculateBestAndWorstId();
+            //Examine outcome of evaluation (depending on algorithm)
+            examineCandidateParticles();
 
-        mpMessageHandler->stepCompleted(mIterationCounter);
+            //Identify best and worst point
+            calculateBestAndWorstId();
 
-        //Retract towards centroid if last reflection failed
-        mRetractionCounter = 0;
-        bool doBreak = false;
-        while(mWorstId == mpFailedCandidate->idx && mIterationCounter<mnMaxIterations && !mpMessageHandler->aborted())
-        {
             mpMessageHandler->stepCompleted(mIterationCounter);
 
-            if(multiRetract())
+            //Retract towards centroid if last reflection failed
+            mRetractionCounter = 0;
+            bool doBreak = false;
+            while(mWorstId == mpFailedCandidate->idx && mIterationCounter<mnMaxIterations && !mpMessageHandler->aborted())
             {
-                doBreak = true;
-                break;
+                mpMessageHandler->stepCompleted(mIterationCounter);
+
+                if(multiRetract())
+                {
+                    doBreak = true;
+                    break;
+                }
             }
-        }
 
-        if(doBreak)
-        {
-            break;
+            if(doBreak)
+            {
+                break;
+            }
+            mpMessageHandler->stepCompleted(mIterationCounter);
         }
-        mpMessageHandler->stepCompleted(mIterationCounter);
     }
 
 
@@ -414,6 +421,139 @@ void WorkerComplexRFP::examineCandidateParticles()
     }
 }
 
+//! @brief Steady-state version of the multi-direction method
+//! @details Each candidate slot reflects one of the worst points that is not already targeted by another slot. When a
+//! candidate has been evaluated it replaces its target point. If the target is still the worst point the slot retracts
+//! towards the centroid and best point, otherwise it picks a new target. New candidates are started as soon as a slot is
+//! free, so no evaluation waits for the slowest one. One iteration corresponds to as many evaluations as there are candidates.
+void WorkerComplexRFP::runAsynchronous()
+{
+    mAsyncTargets.assign(mNumCandidates, 0);
+    mAsyncRetractions.assign(mNumCandidates, 0);
+    mAsyncCentroids.assign(mNumCandidates, std::vector<double>());
+    mAsyncInFlight.assign(mNumCandidates, false);
+
+    for(size_t i=0; i<mNumCandidates; ++i)
+    {
+        startAsyncReflection(i);
+    }
+
+    size_t nEvaluations=0;
+    bool stop=false;
+    size_t i;
+    while(mpEvaluator->waitForCandidateEvaluation(i))
+    {
+        mAsyncInFlight[i] = false;
+        size_t target = mAsyncTargets[i];
+
+        //Increase all objective values (forgetting principle)
+        applyForgettingFactor();
+
+        mPoints[target] = mCandidatePoints[i];
+        mObjectives[target] = mCandidateObjectives[i];
+        mpMessageHandler->pointChanged(target);
+        mpMessageHandler->objectiveChanged(target);
+        calculateBestAndWorstId();
+
+        ++nEvaluations;
+        if(!stop && nEvaluations % mNumCandidates == 0)
+        {
+            if(checkForConvergence())
+            {
+                stop = true;
+            }
+            else
+            {
+                mpMessageHandler->stepCompleted(mIterationCounter);
+                ++mIterationCounter;
+            }
+        }
+        stop = stop || mIterationCounter >= mnMaxIterations || mpMessageHandler->aborted();
+
+        if(stop)
+        {
+            continue;
+        }
+
+        //Retract towards centroid if the point is still the worst
+        if(mWorstId == target)
+        {
+            startAsyncRetraction(i);
+        }
+        else
+        {
+            startAsyncReflection(i);
+        }
+    }
+}
+
+
+//! @brief Reflects the worst point that is not already targeted by another candidate, and starts evaluating it
+//! @param i Index of the candidate slot
+void WorkerComplexRFP::startAsyncReflection(size_t i)
+{
+    std::vector<size_t> ids = getIdsSortedFromWorstToBest();
+    size_t target = ids[0];
+    for(size_t k=0; k<ids.size(); ++k)
+    {
+        bool targeted=false;
+        for(size_t s=0; s<mNumCandidates; ++s)
+        {
+            if(mAsyncInFlight[s] && mAsyncTargets[s] == ids[k])
+            {
+                targeted=true;
+                break;
+            }
+        }
+        if(!targeted)
+        {
+            target = ids[k];
+            break;
+        }
+    }
+
+    size_t worstId = mWorstId;
+    mWorstId = target;
+    findCentroidPoint();
+    mWorstId = worstId;
+
+    mAsyncTargets[i] = target;
+    mAsyncRetractions[i] = 0;
+    mAsyncCentroids[i] = mCentroidPoint;
+    mCandidatePoints[i] = reflect(mPoints[target], mCentroidPoint, mAlpha);
+    mpMessageHandler->candidateChanged(i);
+
+    mAsyncInFlight[i] = true;
+    mpEvaluator->startCandidateEvaluation(i);
+}
+
+
+//! @brief Retracts the target point of a candidate slot towards its centroid and the best point, and starts evaluating it
+//! @param i Index of the candidate slot
+void WorkerComplexRFP::startAsyncRetraction(size_t i)
+{
+    const std::vector<double> &rOldPoint = mPoints[mAsyncTargets[i]];
+    const std::vector<double> &rCentroid = mAsyncCentroids[i];
+    size_t count = mAsyncRetractions[i];
+
+    double a1 = 1.0-exp(-double(count)/5.0);
+    double maxDiff = getMaxPercentalParameterDiff()*10/(9.0+count);
+    for(size_t j=0; j<mNumParameters; ++j)
+    {
+        double best = mPoints[mBestId][j];
+        double r = opsRand();
+        mCandidatePoints[i][j] = (rCentroid[j]*(1.0-a1) + best*a1 + rOldPoint[j])/2.0 + mRandomFactor*(mParameterMax[j]-mParameterMin[j])*maxDiff*(r-0.5);
+        mCandidatePoints[i][j] = std::min(mCandidatePoints[i][j], mParameterMax[j]);
+        mCandidatePoints[i][j] = std::max(mCandidatePoints[i][j], mParameterMin[j]);
+    }
+    mpMessageHandler->candidateChanged(i);
+
+    ++mAsyncRetractions[i];
+    mAsyncInFlight[i] = true;
+    mpEvaluator->startCandidateEvaluation(i);
+}
+
+
 bool WorkerComplexRFP::multiRetract()
 {
     //Check the already evaluated iteration points (if any)
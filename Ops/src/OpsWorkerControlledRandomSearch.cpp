@@ -58,74 +58,48 @@ void WorkerControlledRandomSearch::run()
 
     //Run optimization loop
     mIterationCounter=0;
-    for(; mIterationCounter<mnMaxIterations && !mpMessageHandler->aborted(); ++mIterationCounter)
+    if(mUseAsynchronousEvaluation)
     {
-        //Check convergence
-        if(checkForConvergence()) break;
-
-        //Calculate best and worst point
-        calculateBestAndWorstId();
-
-        for(size_t i=0; i<mNumCandidates; ++i)
+        runAsynchronous();
+    }
+    else
+    {
+        for(; mIterationCounter<mnMaxIterations && !mpMessageHandler->aborted(); ++mIterationCounter)
         {
+            //Check convergence
+            if(checkForConvergence()) break;
 
-            std::vector<size_t> chosenIdx;
-            std::vector< std::vector<double> > chosenPoints;
-            chosenIdx.push_back(mBestId);
-            chosenIdx.push_back(mWorstId);
-            chosenPoints.push_back(mPoints[mBestId]);
-            for(size_t j=0; j<mNumParameters-1; ++j)
+            //Calculate best and worst point
+            calculateBestAndWorstId();
+
+            for(size_t i=0; i<mNumCandidates; ++i)
             {
-                size_t idx = opsRand();
-                while(inVector(chosenIdx,idx))
-                {
-                    idx = round(opsRand()*(mNumPoints-1));
-                }
-                chosenIdx.push_back(idx);
-                chosenPoints.push_back(mPoints[idx]);
+                generateCandidate(i);
             }
 
-            //Find geometrical center
-            findCentroidPoint(chosenPoints);
-
-            //Reflect worst point
-            mCandidatePoints[i] = reflect(mPoints[mWorstId], mCentroidPoint, 1.0);
-            mpMessageHandler->candidateChanged(0);
-
-            //Check if constraints are violated, if so, do new reflection
-            //bool constraintsViolated=false;
-            for(size_t p=0; p<mNumParameters; ++p)
+            mpEvaluator->evaluateAllCandidates();
+            double bestObj = 1e100;
+            int bestId = -1;
+            for(size_t i=0; i<mNumCandidates; ++i)
             {
-                if(mCandidatePoints[i][p] < mParameterMin[p] ||
-                        mCandidatePoints[i][p] > mParameterMax[p])
+                if(mCandidateObjectives[i] < bestObj)
                 {
-                    --i;
+                    bestObj = mCandidateObjectives[i];
+                    bestId = i;
                 }
             }
-        }
 
-        mpEvaluator->evaluateAllCandidates();
-        double bestObj = 1e100;
-        int bestId = -1;
-        for(size_t i=0; i<mNumCandidates; ++i)
-        {
-            if(mCandidateObjectives[i] < bestObj)
+            //Check if new point is better; if so, keep it
+            if(mCandidateObjectives[bestId] < mObjectives[mWorstId])
             {
-                bestObj = mCandidateObjectives[i];
-                bestId = i;
+                mPoints[mWorstId] = mCandidatePoints[bestId];
+                mObjectives[mWorstId] = mCandidateObjectives[bestId];
+                mpMessageHandler->pointChanged(mWorstId);
+                mpMessageHandler->objectiveChanged(mWorstId);
             }
-        }
 
-        //Check if new point is better; if so, keep it
-        if(mCandidateObjectives[bestId] < mObjectives[mWorstId])
-        {
-            mPoints[mWorstId] = mCandidatePoints[bestId];
-            mObjectives[mWorstId] = mCandidateObjectives[bestId];
-            mpMessageHandler->pointChanged(mWorstId);
-            mpMessageHandler->objectiveChanged(mWorstId);
+            mpMessageHandler->stepCompleted(mIterationCounter);
         }
-
-        mpMessageHandler->stepCompleted(mIterationCounter);
     }
 
 
@@ -147,3 +121,99 @@ void WorkerControlledRandomSearch::run()
 
     return;
 }
+
+
+//! @brief Steady-state controlled random search
+//! @details All candidates are evaluated at the same time. When a candidate has been evaluated it replaces the worst point
+//! if it is better, and a new candidate is generated and started directly. One iteration corresponds to as many evaluations
+//! as there are candidates.
+void WorkerControlledRandomSearch::runAsynchronous()
+{
+    for(size_t i=0; i<mNumCandidates; ++i)
+    {
+        generateCandidate(i);
+        mpEvaluator->startCandidateEvaluation(i);
+    }
+
+    size_t nEvaluations=0;
+    bool stop=false;
+    size_t i;
+    while(mpEvaluator->waitForCandidateEvaluation(i))
+    {
+        //Check if new point is better; if so, keep it
+        calculateBestAndWorstId();
+        if(mCandidateObjectives[i] < mObjectives[mWorstId])
+        {
+            mPoints[mWorstId] = mCandidatePoints[i];
+            mObjectives[mWorstId] = mCandidateObjectives[i];
+            mpMessageHandler->pointChanged(mWorstId);
+            mpMessageHandler->objectiveChanged(mWorstId);
+            calculateBestAndWorstId();
+        }
+
+        ++nEvaluations;
+        if(!stop && nEvaluations % mNumCandidates == 0)
+        {
+            if(checkForConvergence())
+            {
+                stop = true;
+            }
+            else
+            {
+                mpMessageHandler->stepCompleted(mIterationCounter);
+                ++mIterationCounter;
+            }
+        }
+        stop = stop || mIterationCounter >= mnMaxIterations || mpMessageHandler->aborted();
+
+        if(!stop)
+        {
+            generateCandidate(i);
+            mpEvaluator->startCandidateEvaluation(i);
+        }
+    }
+}
+
+
+//! @brief Generates a new candidate by reflecting the worst point through the centroid of the best and some random points
+//! @param i Index of the candidate
+void WorkerControlledRandomSearch::generateCandidate(size_t i)
+{
+    bool constraintsViolated=true;
+    while(constraintsViolated)
+    {
+        std::vector<size_t> chosenIdx;
+        std::vector< std::vector<double> > chosenPoints;
+        chosenIdx.push_back(mBestId);
+        chosenIdx.push_back(mWorstId);
+        chosenPoints.push_back(mPoints[mBestId]);
+        for(size_t j=0; j<mNumParameters-1; ++j)
+        {
+            size_t idx = opsRand();
+            while(inVector(chosenIdx,idx))
+            {
+                idx = round(opsRand()*(mNumPoints-1));
+            }
+            chosenIdx.push_back(idx);
+            chosenPoints.push_back(mPoints[idx]);
+        }
+
+        //Find geometrical center
+        findCentroidPoint(chosenPoints);
+
+        //Reflect worst point
+        mCandidatePoints[i] = reflect(mPoints[mWorstId], mCentroidPoint, 1.0);
+        mpMessageHandler->candidateChanged(i);
+
+        //Check if constraints are violated, if so, do new reflection
+        constraintsViolated=false;
+        for(size_t p=0; p<mNumParameters; ++p)
+        {
+            if(mCandidatePoints[i][p] < mParameterMin[p] ||
+                    mCandidatePoints[i][p] > mParameterMax[p])
+            {
+                constraintsViolated=true;
+            }
+        }
+    }
+}
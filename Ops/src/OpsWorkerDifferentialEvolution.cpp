@@ -97,50 +97,38 @@ void WorkerDifferentialEvolution::run()
     mpMessageHandler->objectivesChanged();
 
     mIterationCounter=0;
-    for(; mIterationCounter<mnMaxIterations && !mpMessageHandler->aborted(); ++mIterationCounter)
+    if(mUseAsynchronousEvaluation)
     {
-        for(size_t p=0; p<mNumPoints; ++p)
+        runAsynchronous();
+    }
+    else
+    {
+        for(; mIterationCounter<mnMaxIterations && !mpMessageHandler->aborted(); ++mIterationCounter)
         {
-            bool feasible=false;
-            while(!feasible)
+            for(size_t p=0; p<mNumPoints; ++p)
             {
-                size_t a,b,c,R;
-                getRandomIds(p,a,b,c,R);
-
-                mCandidatePoints[p] = mPoints[p];
-                for(size_t i=0; i<mNumParameters; ++i)
-                {
-                    double r = opsRand();
-                    if(r < mCR || i == R)
-                    {
-                        double A = mPoints[a][i];
-                        double B = mPoints[b][i];
-                        double C = mPoints[c][i];
-                        mCandidatePoints[p][i] = A + mF * (B - C);
-                    }
-                }
-                feasible = isCandidateFeasible(p);
+                generateCandidate(p);
             }
-        }
 
-        mpEvaluator->evaluateAllCandidatesWithSurrogateModel();
-        mpMessageHandler->candidatesChanged();
+            mpEvaluator->evaluateAllCandidatesWithSurrogateModel();
+            mpMessageHandler->candidatesChanged();
 
-        for(size_t p=0; p<mNumPoints; ++p)
-        {
-            if(mCandidateObjectives[p] < mObjectives[p])
+            for(size_t p=0; p<mNumPoints; ++p)
             {
-                mPoints[p] = mCandidatePoints[p];
-                mObjectives[p] = mCandidateObjectives[p];
+                if(mCandidateObjectives[p] < mObjectives[p])
+                {
+                    mPoints[p] = mCandidatePoints[p];
+                    mObjectives[p] = mCandidateObjectives[p];
+                }
             }
-        }
-        mpMessageHandler->pointsChanged();
-        mpMessageHandler->objectivesChanged();
+            mpMessageHandler->pointsChanged();
+            mpMessageHandler->objectivesChanged();
 
-        //Check convergence
-        if(checkForConvergence()) break;      //Use complex method, it's the same principle
+            //Check convergence
+            if(checkForConvergence()) break;      //Use complex method, it's the same principle
 
-        mpMessageHandler->stepCompleted(mIterationCounter);
+            mpMessageHandler->stepCompleted(mIterationCounter);
+        }
     }
 
     if(mpMessageHandler->aborted())
@@ -163,6 +151,82 @@ void WorkerDifferentialEvolution::run()
 }
 
 
+//! @brief Steady-state differential evolution
+//! @details Every point has its own candidate. When a candidate has been evaluated it replaces its point if it is better,
+//! and a new trial candidate for that point is started directly, using the current population. One iteration corresponds
+//! to as many evaluations as there are points.
+void WorkerDifferentialEvolution::runAsynchronous()
+{
+    for(size_t p=0; p<mNumPoints; ++p)
+    {
+        generateCandidate(p);
+        mpEvaluator->startCandidateEvaluation(p);
+    }
+
+    size_t nEvaluations=0;
+    bool stop=false;
+    size_t p;
+    while(mpEvaluator->waitForCandidateEvaluation(p))
+    {
+        if(mCandidateObjectives[p] < mObjectives[p])
+        {
+            mPoints[p] = mCandidatePoints[p];
+            mObjectives[p] = mCandidateObjectives[p];
+            mpMessageHandler->pointChanged(p);
+            mpMessageHandler->objectiveChanged(p);
+        }
+
+        ++nEvaluations;
+        if(!stop && nEvaluations % mNumPoints == 0)
+        {
+            if(checkForConvergence())
+            {
+                stop = true;
+            }
+            else
+            {
+                mpMessageHandler->stepCompleted(mIterationCounter);
+                ++mIterationCounter;
+            }
+        }
+        stop = stop || mIterationCounter >= mnMaxIterations || mpMessageHandler->aborted();
+
+        if(!stop)
+        {
+            generateCandidate(p);
+            mpEvaluator->startCandidateEvaluation(p);
+        }
+    }
+}
+
+
+//! @brief Generates a new feasible trial candidate for a point, by mutation and crossover
+//! @param p Index of the point (and candidate)
+void WorkerDifferentialEvolution::generateCandidate(size_t p)
+{
+    bool feasible=false;
+    while(!feasible)
+    {
+        size_t a,b,c,R;
+        getRandomIds(p,a,b,c,R);
+
+        mCandidatePoints[p] = mPoints[p];
+        for(size_t i=0; i<mNumParameters; ++i)
+        {
+            double r = opsRand();
+            if(r < mCR || i == R)
+            {
+                double A = mPoints[a][i];
+                double B = mPoints[b][i];
+                double C = mPoints[c][i];
+                mCandidatePoints[p][i] = A + mF * (B - C);
+            }
+        }
+        feasible = isCandidateFeasible(p);
+    }
+}
+
+
 void WorkerDifferentialEvolution::setCrossoverProbability(double value)
 {
     mCR = value;
@@ -102,55 +102,59 @@ void WorkerParticleSwarm::run()
 
 
     mIterationCounter=0;
-    for(; mIterationCounter<mnMaxIterations && !mpMessageHandler->aborted(); ++mIterationCounter)
+    if(mUseAsynchronousEvaluation)
     {
-        //Update weight (linearly decreasing)
-        if(mInertiaStrategy == InertiaConstant)
-        {
-            mOmega = mOmega1;
-        }
-        else if(mInertiaStrategy == InertiaLinearDecreasing)
-        {
-            mOmega = mOmega1 + (mOmega2-mOmega1)*mIterationCounter/mnMaxIterations;
-        }
-        else
+        if(!updateInertiaWeight())
         {
             mpMessageHandler->printMessage("Unknown inertia strategy, aborting.");
             return;
         }
+        runAsynchronous();
+    }
+    else
+    {
+        for(; mIterationCounter<mnMaxIterations && !mpMessageHandler->aborted(); ++mIterationCounter)
+        {
+            //Update weight (linearly decreasing)
+            if(!updateInertiaWeight())
+            {
+                mpMessageHandler->printMessage("Unknown inertia strategy, aborting.");
+                return;
+            }
 
-        //Move particles
-        moveParticles();
-        mpMessageHandler->pointsChanged();
+            //Move particles
+            moveParticles();
+            mpMessageHandler->pointsChanged();
 
-        //Evaluate objective values
-        bool usedSurrogateModel = mpEvaluator->evaluateAllCandidatesWithSurrogateModel();
-        mpMessageHandler->objectivesChanged();
+            //Evaluate objective values
+            bool usedSurrogateModel = mpEvaluator->evaluateAllCandidatesWithSurrogateModel();
+            mpMessageHandler->objectivesChanged();
 
-        if(!usedSurrogateModel) {
-            //Calculate best known positions
-            for(size_t p=0; p<mNumPoints; ++p)
-            {
-                if(mCandidateObjectives[p] < mObjectives[p])
+            if(!usedSurrogateModel) {
+                //Calculate best known positions
+                for(size_t p=0; p<mNumPoints; ++p)
                 {
-                    mPoints[p] = mCandidatePoints[p];
-                    mObjectives[p] = mCandidateObjectives[p];
+                    if(mCandidateObjectives[p] < mObjectives[p])
+                    {
+                        mPoints[p] = mCandidatePoints[p];
+                        mObjectives[p] = mCandidateObjectives[p];
+                    }
                 }
-            }
 
-            //Calculate best known global position
-            calculateBestAndWorstId();
-            if(mObjectives[mBestId] < mBestObjective)
-            {
-                mBestObjective = mObjectives[mBestId];
-                mBestPoint = mPoints[mBestId];
+                //Calculate best known global position
+                calculateBestAndWorstId();
+                if(mObjectives[mBestId] < mBestObjective)
+                {
+                    mBestObjective = mObjectives[mBestId];
+                    mBestPoint = mPoints[mBestId];
+                }
             }
-        }
 
-        //Check convergence
-        if(checkForConvergence()) break;      //Use complex method, it's the same principle
+            //Check convergence
+            if(checkForConvergence()) break;      //Use complex method, it's the same principle
 
-        mpMessageHandler->stepCompleted(mIterationCounter);
+            mpMessageHandler->stepCompleted(mIterationCounter);
+        }
     }
 
     if(mpMessageHandler->aborted())
@@ -173,6 +177,82 @@ void WorkerParticleSwarm::run()
 }
 
 
+//! @brief Steady-state particle swarm optimization
+//! @details Each particle is moved and started again as soon as it has been evaluated, using the best known global position
+//! at that time. One iteration corresponds to as many evaluations as there are particles.
+void WorkerParticleSwarm::runAsynchronous()
+{
+    for(size_t p=0; p<mNumPoints; ++p)
+    {
+        moveParticle(p);
+        mpEvaluator->startCandidateEvaluation(p);
+    }
+
+    size_t nEvaluations=0;
+    bool stop=false;
+    size_t p;
+    while(mpEvaluator->waitForCandidateEvaluation(p))
+    {
+        //Update best known position of this particle, and the global best position
+        if(mCandidateObjectives[p] < mObjectives[p])
+        {
+            mPoints[p] = mCandidatePoints[p];
+            mObjectives[p] = mCandidateObjectives[p];
+            mpMessageHandler->pointChanged(p);
+            mpMessageHandler->objectiveChanged(p);
+        }
+        if(mObjectives[p] < mBestObjective)
+        {
+            mBestObjective = mObjectives[p];
+            mBestPoint = mPoints[p];
+        }
+
+        ++nEvaluations;
+        if(!stop && nEvaluations % mNumPoints == 0)
+        {
+            if(checkForConvergence())
+            {
+                stop = true;
+            }
+            else
+            {
+                mpMessageHandler->stepCompleted(mIterationCounter);
+                ++mIterationCounter;
+                updateInertiaWeight();
+            }
+        }
+        stop = stop || mIterationCounter >= mnMaxIterations || mpMessageHandler->aborted();
+
+        if(!stop)
+        {
+            moveParticle(p);
+            mpEvaluator->startCandidateEvaluation(p);
+        }
+    }
+    calculateBestAndWorstId();
+}
+
+
+//! @brief Updates the inertia weight for the current iteration
+//! @returns False if the inertia strategy is unknown
+bool WorkerParticleSwarm::updateInertiaWeight()
+{
+    if(mInertiaStrategy == InertiaConstant)
+    {
+        mOmega = mOmega1;
+    }
+    else if(mInertiaStrategy == InertiaLinearDecreasing)
+    {
+        mOmega = mOmega1 + (mOmega2-mOmega1)*mIterationCounter/mnMaxIterations;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+
 void WorkerParticleSwarm::setNumberOfPoints(size_t value)
 {
     Worker::setNumberOfPoints(value);
@@ -15,6 +15,28 @@ class hopsan:
     def loadModel(self, path):
         self.hdll.loadModel(path.encode())
 
+    def newModel(self, name):
+        return self.hdll.newModel(name.encode()) == 0
+
+    def reserveModel(self, numComponents, numConnections):
+        import ctypes
+        self.hdll.reserveModel.argtypes = [ctypes.c_size_t, ctypes.c_size_t]
+        self.hdll.reserveModel(numComponents, numConnections)
+
+    def addComponent(self, typeName, name=""):
+        import ctypes
+        buf = ctypes.create_string_buffer(1024)
+        self.hdll.addComponent.argtypes = [ctypes.c_char_p, ctypes.c_char_p, ctypes.c_char_p, ctypes.c_size_t]
+        if self.hdll.addComponent(typeName.encode(), name.encode(), buf, 1024) != 0:
+            return None
+        return buf.value.decode()
+
+    def connectPorts(self, component1, port1, component2, port2):
+        self.hdll.connectPorts(component1.encode(), port1.encode(), component2.encode(), port2.encode())
+
+    def finishModel(self):
+        return self.hdll.finishModel() == 0
+
     def simulate(self):
         self.hdll.simulate()
 
@@ -56,3 +78,17 @@ class hopsan:
         import ctypes
         self.hdll.setNumberOfLogSamples.argtypes = [ctypes.c_int]
         self.hdll.setNumberOfLogSamples(value)
+
+    def setProfilingEnabled(self, enabled):
+        self.hdll.setProfilingEnabled(1 if enabled else 0)
+
+    def getProfileReport(self):
+        import ctypes
+        import json
+        self.hdll.getProfileReportSize.restype = ctypes.c_size_t
+        size = self.hdll.getProfileReportSize()
+        buf = ctypes.create_string_buffer(size)
+        self.hdll.getProfileReport.argtypes = [ctypes.c_char_p, ctypes.c_size_t]
+        if self.hdll.getProfileReport(buf, size) != 0:
+            return None
+        return json.loads(buf.value.decode())
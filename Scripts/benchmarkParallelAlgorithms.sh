@@ -0,0 +1,60 @@
+#!/bin/bash
+# $Id$
+
+# Shell script for benchmarking the parallel simulation algorithms on the multi-core benchmark models
+# Reports simulation step throughput and consumed CPU-seconds for each model, algorithm and thread count
+#
+# Usage: Scripts/benchmarkParallelAlgorithms.sh [numThreads] [algorithms] [stopTime]
+#   numThreads  Comma separated list of thread counts (default: 2,4)
+#   algorithms  Comma separated list of algorithms (default: apriori,hybridbarrier)
+#   stopTime    Simulation stop time (default: use time in .hmf)
+#
+# Run from the Hopsan root directory after building, results are printed as CSV
+# Set HOPSAN_BENCH_PERF=1 to also record L1 data cache and last level cache load misses using "perf stat"
+
+threadsList=${1:-2,4}
+algorithmsList=${2:-apriori,hybridbarrier}
+stopTime=$3
+
+rootDir=$(pwd)
+if [ -x bin/hopsancli_d ]; then
+  cmd="${rootDir}/bin/hopsancli_d"
+elif [ -x bin/hopsancli ]; then
+  cmd="${rootDir}/bin/hopsancli"
+else
+  echo "Error: hopsancli not found"
+  exit 1
+fi
+
+simArg=""
+if [ -n "${stopTime}" ]; then
+  simArg="-s ${stopTime}"
+fi
+
+perfCmd=""
+if [ "${HOPSAN_BENCH_PERF}" = "1" ]; then
+  perfCmd="perf stat -x , -e L1-dcache-load-misses,LLC-load-misses"
+fi
+
+echo "model,algorithm,threads,steps,wallTime,cpuTime,stepsPerSecond,cpuSecondsPerWallSecond,l1Misses,llcMisses"
+for model in "${rootDir}/Models/Benchmark Models"/Multicore-test-*.hmf; do
+  modelName=$(basename "${model}" .hmf)
+  for algorithm in ${algorithmsList//,/ }; do
+    for threads in ${threadsList//,/ }; do
+      output=$(${perfCmd} ${cmd} -m "${model}" ${simArg} -p ${threads} --parallelAlgorithm ${algorithm} -l 0 --silent 2>&1)
+      if [[ $? -ne 0 ]]; then
+        echo "${modelName},${algorithm},${threads},failed,,,,,,"
+        continue
+      fi
+      # "Simulating: start to stop with Ts: step     Please Wait!"
+      steps=$(echo "${output}" | awk '/^Simulating:/ {printf "%d", ($4-$2)/$7 + 0.5}')
+      wallTime=$(echo "${output}" | awk -F': ' '/^SimulationTime:/ {print $2}')
+      cpuTime=$(echo "${output}" | awk -F': ' '/^SimulationCPUTime:/ {print $2}')
+      rates=$(awk -v n="${steps}" -v w="${wallTime}" -v c="${cpuTime}" 'BEGIN {if (w > 0) printf "%.1f,%.2f", n/w, c/w; else printf ","}')
+      # perf stat -x prints "count,unit,event,..." lines to stderr
+      l1Misses=$(echo "${output}" | awk -F, '$3 ~ /^L1-dcache-load-misses/ {print $1}')
+      llcMisses=$(echo "${output}" | awk -F, '$3 ~ /^LLC-load-misses/ {print $1}')
+      echo "${modelName},${algorithm},${threads},${steps},${wallTime},${cpuTime},${rates},${l1Misses},${llcMisses}"
+    done
+  done
+done
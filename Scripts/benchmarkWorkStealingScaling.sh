@@ -0,0 +1,15 @@
+#!/bin/bash
+# $Id$
+
+# Shell script for benchmarking how the task-stealing algorithm scales compared to a priori scheduling and the task pool
+# Runs the Multicore-test-* benchmark models with 2 to 64 threads, using benchmarkParallelAlgorithms.sh
+#
+# Usage: Scripts/benchmarkWorkStealingScaling.sh [stopTime]
+#   stopTime    Simulation stop time (default: use time in .hmf)
+#
+# Run from the Hopsan root directory after building, results are printed as CSV
+# Note! The number of threads is limited to the number of cores, rows above the core count repeat the largest run
+
+scriptDir=$(dirname "$0")
+echo "# Cores: $(getconf _NPROCESSORS_ONLN)"
+"${scriptDir}/benchmarkParallelAlgorithms.sh" 2,4,8,16,32,64 apriori,taskpool,taskstealing "$1"
@@ -33,6 +33,7 @@
 #include "hopsangenerator.h"
 #include "GeneratorTypes.h"
 #include <assert.h>
+#include <cmath>
 #include <iostream>
 
 #ifndef DEFAULT_LIBRARY_ROOT
@@ -60,6 +61,7 @@ const std::string defaultLibraryFilePath = "";
 
 constexpr bool gAllwaysShowMessages = false;
 void generatorMessageCallback(const char* msg, const char type, void* pObject);
+void fmuLogger(void* pEnvironment, const char* instanceName, int status, const char* category, const char* message, ...);
 
 void removeDir(QString path)
 {
@@ -437,11 +439,11 @@ private slots:
         pSystem->connect(pPort1, pPort2);
         pSystem->initialize(0, 100);
         pSystem->simulate(0.01);
-        std::vector<double> *pInData = pPort1->getDataVectorPtr();
-        std::vector<double> *pOutData = pPort3->getDataVectorPtr();
+        NodeDataVector *pInData = pPort1->getDataVectorPtr();
+        NodeDataVector *pOutData = pPort3->getDataVectorPtr();
         bool ok = true;
         for(size_t i=0; i<pInData->size(); ++i) {
-            if(pInData[i] != pOutData[i]) {
+            if((*pInData)[i] != (*pOutData)[i]) {
                 ok = false;
             }
         }
@@ -460,6 +462,178 @@ private slots:
 #endif
     }
 
+    void Generator_FMU_Import_Benchmark()
+    {
+        // Measures the per-step cost of the FMI wrapper (value transfers and doStep) on the exported FMUs
+        ComponentSystem * pSystem = mHopsanCore.createComponentSystem();
+        Component *pFmuComponent = mHopsanCore.createComponent("FMIWrapper");
+        pSystem->addComponent(pFmuComponent);
+
+        QFETCH(HString, fmuPath);
+        pFmuComponent->setParameterValue("path", fmuPath, true);
+        QVERIFY2(pFmuComponent->hasParameter("loggingOn"), "Failed to import FMU");
+        Component *pSourceComponent = mHopsanCore.createComponent("SignalSineWave");
+        pSystem->addComponent(pSourceComponent);
+        Port *pPort2 = pFmuComponent->getPort("in1_out_y");
+        QVERIFY2(pPort2 != nullptr, "Input port is missing from imported FMU");
+        pSystem->connect(pSourceComponent->getPort("out"), pPort2);
+        pSystem->setDesiredTimestep(0.001);
+        QVERIFY2(pSystem->checkModelBeforeSimulation(), "Model check failed");
+        QVERIFY2(pSystem->initialize(0, 1e9), "Failed to initialize model with imported FMU");
+
+        // Each iteration takes 1000 steps
+        QBENCHMARK {
+            pSystem->simulate(pSystem->getTime()+1.0);
+        }
+        pSystem->finalize();
+    }
+
+    void Generator_FMU_Import_Benchmark_data() {
+        Generator_FMU_Import_data();
+    }
+
+    void Generator_FMU_State()
+    {
+#if defined(__APPLE__) || !defined(HOPSANCOMPILED64BIT)
+        QSKIP("FMU state test requires a 64-bit FMU 2.0 export");
+#else
+        // Uses the FMU exported by Generator_FMU_Export
+        const QString stagePath = qcwd+"/fmu2 64/fmu-stage";
+
+        // Check capability flags and find input and output value references in the model description
+        QFile mdFile(stagePath+"/modelDescription.xml");
+        QVERIFY2(mdFile.open(QFile::ReadOnly | QFile::Text), "Could not open exported modelDescription.xml");
+        QXmlStreamReader md(&mdFile);
+        bool canGetAndSet=false, canSerialize=false;
+        std::vector<unsigned int> inputRefs, outputRefs;
+        while (!md.atEnd()) {
+            if (md.readNext() != QXmlStreamReader::StartElement) {
+                continue;
+            }
+            if (md.name() == QString("CoSimulation")) {
+                canGetAndSet = (md.attributes().value("canGetAndSetFMUstate") == QString("true"));
+                canSerialize = (md.attributes().value("canSerializeFMUstate") == QString("true"));
+            }
+            else if (md.name() == QString("ScalarVariable")) {
+                const unsigned int vr = md.attributes().value("valueReference").toUInt();
+                const QString causality = md.attributes().value("causality").toString();
+                if (causality == "input") {
+                    inputRefs.push_back(vr);
+                }
+                else if (causality == "output") {
+                    outputRefs.push_back(vr);
+                }
+            }
+        }
+        QVERIFY2(canGetAndSet, "canGetAndSetFMUstate is not set in modelDescription.xml");
+        QVERIFY2(canSerialize, "canSerializeFMUstate is not set in modelDescription.xml");
+        QVERIFY2(!outputRefs.empty(), "Exported FMU has no outputs");
+
+#ifdef _WIN32
+        QLibrary fmuLib(stagePath+"/binaries/win64/unittestmodel_export.dll");
+#else
+        QLibrary fmuLib(stagePath+"/binaries/linux64/unittestmodel_export.so");
+#endif
+        QVERIFY2(fmuLib.load(), qPrintable(fmuLib.errorString()));
+
+        // Minimal FMI 2.0 co-simulation declarations, to avoid depending on the FMI headers
+        typedef void* Fmi2Component;
+        typedef void* Fmi2State;
+        typedef void (*Fmi2Logger)(void*, const char*, int, const char*, const char*, ...);
+        struct Fmi2Callbacks { Fmi2Logger logger; void* (*allocate)(size_t, size_t); void (*free)(void*);
+                               void (*stepFinished)(void*, int); void* environment; };
+        typedef Fmi2Component (*InstantiateT)(const char*, int, const char*, const char*, const Fmi2Callbacks*, int, int);
+        typedef int (*SetupExperimentT)(Fmi2Component, int, double, double, int, double);
+        typedef int (*ComponentT)(Fmi2Component);
+        typedef void (*FreeInstanceT)(Fmi2Component);
+        typedef int (*RealT)(Fmi2Component, const unsigned int[], size_t, double[]);
+        typedef int (*SetRealT)(Fmi2Component, const unsigned int[], size_t, const double[]);
+        typedef int (*DoStepT)(Fmi2Component, double, double, int);
+        typedef int (*GetStateT)(Fmi2Component, Fmi2State*);
+        typedef int (*SetStateT)(Fmi2Component, Fmi2State);
+        typedef int (*StateSizeT)(Fmi2Component, Fmi2State, size_t*);
+        typedef int (*SerializeT)(Fmi2Component, Fmi2State, char[], size_t);
+        typedef int (*DeSerializeT)(Fmi2Component, const char[], size_t, Fmi2State*);
+
+        InstantiateT instantiate = (InstantiateT)fmuLib.resolve("fmi2Instantiate");
+        SetupExperimentT setupExperiment = (SetupExperimentT)fmuLib.resolve("fmi2SetupExperiment");
+        ComponentT enterInitializationMode = (ComponentT)fmuLib.resolve("fmi2EnterInitializationMode");
+        ComponentT exitInitializationMode = (ComponentT)fmuLib.resolve("fmi2ExitInitializationMode");
+        ComponentT terminate = (ComponentT)fmuLib.resolve("fmi2Terminate");
+        FreeInstanceT freeInstance = (FreeInstanceT)fmuLib.resolve("fmi2FreeInstance");
+        RealT getReal = (RealT)fmuLib.resolve("fmi2GetReal");
+        SetRealT setReal = (SetRealT)fmuLib.resolve("fmi2SetReal");
+        DoStepT doStep = (DoStepT)fmuLib.resolve("fmi2DoStep");
+        GetStateT getState = (GetStateT)fmuLib.resolve("fmi2GetFMUstate");
+        SetStateT setState = (SetStateT)fmuLib.resolve("fmi2SetFMUstate");
+        GetStateT freeState = (GetStateT)fmuLib.resolve("fmi2FreeFMUstate");
+        StateSizeT stateSize = (StateSizeT)fmuLib.resolve("fmi2SerializedFMUstateSize");
+        SerializeT serialize = (SerializeT)fmuLib.resolve("fmi2SerializeFMUstate");
+        DeSerializeT deSerialize = (DeSerializeT)fmuLib.resolve("fmi2DeSerializeFMUstate");
+        QVERIFY2(instantiate && setupExperiment && enterInitializationMode && exitInitializationMode && terminate && freeInstance &&
+                 getReal && setReal && doStep && getState && setState && freeState && stateSize && serialize && deSerialize,
+                 "Failed to resolve FMI 2.0 functions in exported FMU");
+
+        Fmi2Callbacks callbacks = {&fmuLogger, nullptr, nullptr, nullptr, nullptr};
+        const QString resources = "file:///"+stagePath+"/resources";
+        Fmi2Component c = instantiate("state", 1, "", resources.toStdString().c_str(), &callbacks, 0, 0);
+        QVERIFY2(c != nullptr, "Failed to instantiate exported FMU");
+        QCOMPARE(setupExperiment(c, 0, 0, 0.0, 0, 0.0), 0);
+        QCOMPARE(enterInitializationMode(c), 0);
+        QCOMPARE(exitInitializationMode(c), 0);
+
+        // Simulate with time-varying inputs, returns the outputs after each step
+        const double h=0.01;
+        auto simulateSteps = [&](double t0, int nSteps) {
+            std::vector<double> results;
+            std::vector<double> inputs(inputRefs.size()), outputs(outputRefs.size());
+            for (int s=0; s<nSteps; ++s) {
+                const double t = t0+s*h;
+                for (size_t i=0; i<inputs.size(); ++i) {
+                    inputs[i] = sin(t*(i+1));
+                }
+                setReal(c, inputRefs.data(), inputRefs.size(), inputs.data());
+                doStep(c, t, h, 1);
+                getReal(c, outputRefs.data(), outputRefs.size(), outputs.data());
+                results.insert(results.end(), outputs.begin(), outputs.end());
+            }
+            return results;
+        };
+
+        simulateSteps(0.0, 100);
+        Fmi2State state = nullptr;
+        QCOMPARE(getState(c, &state), 0);
+        size_t size=0;
+        QCOMPARE(stateSize(c, state, &size), 0);
+        QVERIFY(size > 0);
+        std::vector<char> serialized(size);
+        QCOMPARE(serialize(c, state, serialized.data(), serialized.size()), 0);
+        const std::vector<double> expected = simulateSteps(1.0, 100);
+
+        // Roll back to the in-memory state and repeat the steps
+        QCOMPARE(setState(c, state), 0);
+        QVERIFY2(simulateSteps(1.0, 100) == expected, "Results after restoring FMU state differ");
+
+        // Roll back to the serialized state and repeat the steps
+        Fmi2State deserialized = nullptr;
+        QCOMPARE(deSerialize(c, serialized.data(), serialized.size(), &deserialized), 0);
+        QCOMPARE(setState(c, deserialized), 0);
+        QVERIFY2(simulateSteps(1.0, 100) == expected, "Results after restoring serialized FMU state differ");
+
+        // A truncated state must be rejected
+        Fmi2State truncated = nullptr;
+        QCOMPARE(deSerialize(c, serialized.data(), serialized.size()/2, &truncated), 0);
+        QVERIFY(setState(c, truncated) != 0);
+
+        QCOMPARE(freeState(c, &state), 0);
+        QCOMPARE(freeState(c, &deserialized), 0);
+        QCOMPARE(freeState(c, &truncated), 0);
+        QVERIFY(state == nullptr);
+        terminate(c);
+        freeInstance(c);
+#endif
+    }
+
     void Generator_Simulink_Export()
     {
         QFETCH(ComponentSystem*, system);
@@ -825,6 +999,15 @@ void generatorMessageCallback(const char* msg, const char type, void* pObject)
     }
 }
 
+void fmuLogger(void* pEnvironment, const char* instanceName, int status, const char* category, const char* message, ...)
+{
+    Q_UNUSED(pEnvironment)
+    Q_UNUSED(status)
+    if (gAllwaysShowMessages) {
+        std::cout << instanceName << " " << category << ": " << message << std::endl;
+    }
+}
+
 
 QTEST_APPLESS_MAIN(GeneratorTests)
 
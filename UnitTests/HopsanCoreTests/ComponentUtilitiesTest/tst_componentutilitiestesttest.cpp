@@ -26,6 +26,11 @@
 #include <QtTest>
 
 #include "ComponentUtilities.h"
+#include "HopsanEssentials.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
 
 using namespace hopsan;
 
@@ -615,6 +620,367 @@ private Q_SLOTS:
         QTest::newRow("plo2 4") << ploData2 << "notExist" << "y" << true << -1 << 2 << 40.0;
 
     }
+
+    void csvParser()
+    {
+        QFETCH( QString, csvData);
+        QFETCH( QString, separator);
+        QFETCH( int, linesToSkip);
+        QFETCH( int, expectedNumRows);
+        QFETCH( int, column);
+        QFETCH( bool, expectCopyOK);
+        QFETCH( double, expectedLastValue);
+
+        CSVParserNG parser(separator.at(0).toLatin1(), size_t(linesToSkip));
+        parser.setCommentChar('#');
+        QVERIFY(parser.openText(qPrintable(csvData)));
+        parser.indexFile();
+        QCOMPARE(int(parser.getNumDataRows()), expectedNumRows);
+        std::vector<double> values;
+        bool copyOK = parser.copyColumn(size_t(column), values);
+        QCOMPARE(copyOK, expectCopyOK);
+        if (copyOK) {
+            QCOMPARE(int(values.size()), expectedNumRows);
+            QCOMPARE(values.back(), expectedLastValue);
+        }
+    }
+
+    void csvParser_data()
+    {
+        QTest::addColumn< QString >("csvData");
+        QTest::addColumn< QString >("separator");
+        QTest::addColumn< int >("linesToSkip");
+        QTest::addColumn< int >("expectedNumRows");
+        QTest::addColumn< int >("column");
+        QTest::addColumn< bool >("expectCopyOK");
+        QTest::addColumn< double >("expectedLastValue");
+
+        QString csvData1 = "time,x\n0,1.5\n1,-2.5e2\n2,0.125\n";
+        QString csvData2 = "# comment\r\n0;1,5\r\n1;2,25\r\n\r\n2;3,75";
+        QString csvData3 = "0,1\n1,nope\n";
+        QString csvData4 = "0\t1,5\n1\t-2,25e1\n";
+        QString csvData5 = "0,1,5\n1,2,25\n";
+
+        QTest::newRow("csv1 0") << csvData1 << "," << 1 << 3 << 0 << true << 2.0;
+        QTest::newRow("csv1 1") << csvData1 << "," << 1 << 3 << 1 << true << 0.125;
+        QTest::newRow("csv1 2") << csvData1 << "," << 1 << 3 << 2 << false << 0.0;
+        QTest::newRow("csv2 0") << csvData2 << ";" << 0 << 3 << 1 << true << 3.75;
+        QTest::newRow("csv3 0") << csvData3 << "," << 0 << 2 << 1 << false << 0.0;
+        // A decimal comma is only accepted when ',' is not the separator
+        QTest::newRow("csv4 0") << csvData4 << "\t" << 0 << 2 << 1 << true << -22.5;
+        QTest::newRow("csv5 1") << csvData5 << "," << 0 << 2 << 1 << true << 2.0;
+        QTest::newRow("csv5 2") << csvData5 << "," << 0 << 2 << 2 << true << 25.0;
+    }
+
+    void csvParserFileCache()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString path = dir.path()+"/data.csv";
+        QFile file(path);
+        QVERIFY(file.open(QFile::WriteOnly | QFile::Text));
+        for (int i=0; i<1000; ++i) {
+            file.write(QString("%1,%2\n").arg(i).arg(i*0.5).toLatin1());
+        }
+        file.close();
+
+        // Parse twice, the second time the column comes from the cache
+        for (int i=0; i<2; ++i) {
+            CSVParserNG parser;
+            QVERIFY(parser.openFile(qPrintable(path)));
+            parser.indexFile();
+            std::vector<double> values;
+            QVERIFY(parser.copyColumn(1, values));
+            QCOMPARE(int(values.size()), 1000);
+            QCOMPARE(values.back(), 499.5);
+            parser.closeFile();
+        }
+
+        // A changed file must be parsed again
+        QVERIFY(file.open(QFile::WriteOnly | QFile::Text));
+        file.write("0,7\n1,8\n");
+        file.close();
+        CSVParserNG parser;
+        QVERIFY(parser.openFile(qPrintable(path)));
+        parser.indexFile();
+        std::vector<double> values;
+        QVERIFY(parser.copyColumn(1, values));
+        QCOMPARE(int(values.size()), 2);
+        QCOMPARE(values.back(), 8.0);
+        parser.closeFile();
+
+        // A rewrite with the same size within the same second must also be parsed again
+        const QDateTime modified(QDate(2020, 1, 1), QTime(12, 0, 0, 100));
+        QVERIFY(file.setFileTime(modified, QFileDevice::FileModificationTime));
+        QVERIFY(parser.openFile(qPrintable(path)));
+        parser.indexFile();
+        parser.closeFile();
+        QVERIFY(file.open(QFile::WriteOnly | QFile::Text));
+        file.write("0,7\n1,9\n");
+        file.close();
+        QVERIFY(file.setFileTime(modified.addMSecs(500), QFileDevice::FileModificationTime));
+        QVERIFY(parser.openFile(qPrintable(path)));
+        parser.indexFile();
+        QVERIFY(parser.copyColumn(1, values));
+        QCOMPARE(values.back(), 9.0);
+        parser.closeFile();
+
+        // A file replaced by another one with the same size and modification time must also be parsed again
+        const QString otherPath = dir.path()+"/other.csv";
+        QFile otherFile(otherPath);
+        QVERIFY(otherFile.open(QFile::WriteOnly | QFile::Text));
+        otherFile.write("0,7\n1,6\n");
+        otherFile.close();
+        QVERIFY(otherFile.setFileTime(modified.addMSecs(500), QFileDevice::FileModificationTime));
+        QVERIFY(QFile::remove(path));
+        QVERIFY(QFile::rename(otherPath, path));
+        QVERIFY(parser.openFile(qPrintable(path)));
+        parser.indexFile();
+        QVERIFY(parser.copyColumn(1, values));
+        QCOMPARE(values.back(), 6.0);
+        parser.closeFile();
+        CSVParserNG::clearCache();
+    }
+
+    void csvParserParallelColumn()
+    {
+        // Columns of at least 100000 rows per thread are parsed in parallel, use enough rows for several threads
+        // and an uneven last chunk
+        const size_t numRows = 412345;
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString path = dir.path()+"/large.csv";
+        QFile file(path);
+        QVERIFY(file.open(QFile::WriteOnly | QFile::Text));
+        QByteArray data;
+        for (size_t i=0; i<numRows; ++i) {
+            const double value = ((i%2 == 0) ? 1.0 : -1.0)*double(i)*1.25e-3;
+            data += QByteArray::number(qulonglong(i)) + ',' + QByteArray::number(value, 'g', 17) + '\n';
+        }
+        file.write(data);
+        file.close();
+
+        CSVParserNG::clearCache();
+        CSVParserNG parser;
+        QVERIFY(parser.openFile(qPrintable(path)));
+        QVERIFY(parser.getErrorString().empty());
+        parser.indexFile();
+        QCOMPARE(parser.getNumDataRows(), numRows);
+
+        // Serial reference, parsed in ranges below the parallel threshold (ranges are not cached)
+        std::vector<double> serial;
+        const size_t rangeSize = 50000;
+        for (size_t start=0; start<numRows; start+=rangeSize) {
+            std::vector<double> range;
+            QVERIFY(parser.copyRangeFromColumn(1, start, std::min(rangeSize, numRows-start), range));
+            serial.insert(serial.end(), range.begin(), range.end());
+        }
+
+        std::vector<double> parallel;
+        QVERIFY(parser.copyColumn(1, parallel));
+        QCOMPARE(parallel.size(), numRows);
+        QVERIFY(parallel == serial);
+        QCOMPARE(parallel.back(), double(numRows-1)*1.25e-3);
+        parser.closeFile();
+        CSVParserNG::clearCache();
+    }
+
+    void Save_Restore_State()
+    {
+        QFETCH(int, delaySteps);
+        QFETCH(double, wc);
+
+        Delay delay;
+        delay.initialize(delaySteps, 0.0);
+        FirstOrderLowPassFilter filter;
+        filter.initialize(0.001, wc);
+        for (int i=0; i<100; ++i)
+        {
+            filter.update(delay.update(sin(i*0.1)));
+        }
+
+        std::vector<char> state;
+        StateWriter writer(state);
+        delay.saveState(writer);
+        filter.saveState(writer);
+
+        std::vector<double> expected;
+        for (int i=100; i<200; ++i)
+        {
+            expected.push_back(filter.update(delay.update(sin(i*0.1))));
+        }
+
+        // Restore into fresh objects, the delay buffer must be reallocated to the saved size
+        Delay restoredDelay;
+        restoredDelay.initialize(1, 0.0);
+        FirstOrderLowPassFilter restoredFilter;
+        StateReader reader(state);
+        QVERIFY2(restoredDelay.restoreState(reader), "Failed to restore delay state");
+        QVERIFY2(restoredFilter.restoreState(reader), "Failed to restore transfer function state");
+        QVERIFY2(reader.atEnd(), "Not all state data was read");
+        QCOMPARE(restoredDelay.getSize(), size_t(delaySteps));
+        for (int i=100; i<200; ++i)
+        {
+            QCOMPARE(restoredFilter.update(restoredDelay.update(sin(i*0.1))), expected[size_t(i-100)]);
+        }
+
+        // Reading past the end must fail
+        QVERIFY(!restoredDelay.restoreState(reader));
+        QVERIFY(reader.hasFailed());
+    }
+
+    void Save_Restore_State_data()
+    {
+        QTest::addColumn<int>("delaySteps");
+        QTest::addColumn<double>("wc");
+
+        QTest::newRow("0") << 1 << 10.0;
+        QTest::newRow("1") << 7 << 100.0;
+        QTest::newRow("2") << 64 << 1000.0;
+    }
+
+    void State_Object_Registration()
+    {
+        // A component constructed outside of a registration scope does not collect state objects created later
+        HopsanEssentials hopsanCore;
+        Component *pDirect = ComponentSystem::Creator();
+        std::vector<char> before, after;
+        StateWriter beforeWriter(before);
+        pDirect->saveState(beforeWriter);
+        Delay unrelated;
+        unrelated.initialize(10, 1.0);
+        StateWriter afterWriter(after);
+        pDirect->saveState(afterWriter);
+        QCOMPARE(after.size(), before.size());
+        hopsanCore.removeComponent(pDirect);
+
+        // Within a scope, state objects register with the first component constructed in it, until the component is destroyed
+        {
+            StateObjectRegistrationScope scope;
+            QVERIFY(!StateObjectRegistrationScope::getCurrentComponent());
+            Component *pSystem = ComponentSystem::Creator();
+            QCOMPARE(StateObjectRegistrationScope::getCurrentComponent(), pSystem);
+            Component *pInner = ComponentSystem::Creator();
+            QCOMPARE(StateObjectRegistrationScope::getCurrentComponent(), pSystem);
+            {
+                StateObjectRegistrationScope innerScope(pInner);
+                QCOMPARE(StateObjectRegistrationScope::getCurrentComponent(), pInner);
+            }
+            QCOMPARE(StateObjectRegistrationScope::getCurrentComponent(), pSystem);
+            hopsanCore.removeComponent(pInner);
+            hopsanCore.removeComponent(pSystem);
+            QVERIFY(!StateObjectRegistrationScope::getCurrentComponent());
+        }
+        QVERIFY(!StateObjectRegistrationScope::getCurrentComponent());
+    }
+
+    void EquationSystemSolver_Fixed_Size()
+    {
+        QFETCH(int, n);
+
+        // The solver (fixed-size for n <= 8) must give exactly the same result as the generic LU-decomposition
+        std::mt19937 generator(static_cast<unsigned>(n));
+        std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+        EquationSystemSolver solver(nullptr, n);
+        Matrix jacobian(n,n), reference(n,n);
+        Vec equations(n), variables(n), expected(n), delta(n);
+        std::vector<int> order(static_cast<size_t>(n));
+        for (int rep=0; rep<100; ++rep)
+        {
+            for (int i=0; i<n; ++i)
+            {
+                equations[i] = distribution(generator);
+                variables[i] = distribution(generator);
+                for (int j=0; j<n; ++j)
+                {
+                    // Every second system is not diagonally dominant, to exercise the pivoting
+                    jacobian[i][j] = distribution(generator) + ((i == j && rep%2 == 0) ? n : 0);
+                    reference[i][j] = jacobian[i][j];
+                }
+            }
+            QVERIFY(ludcmp(reference, order.data()));
+            solvlu(reference, equations, delta, order.data());
+            for (int i=0; i<n; ++i)
+            {
+                expected[i] = variables[i] - delta[i];
+            }
+
+            solver.solve(jacobian, equations, variables);
+            for (int i=0; i<n; ++i)
+            {
+                QCOMPARE(variables[i], expected[i]);
+            }
+        }
+    }
+
+    void EquationSystemSolver_Fixed_Size_data()
+    {
+        QTest::addColumn<int>("n");
+        for (int n=1; n<=13; ++n)
+        {
+            QTest::newRow(QString::number(n).toLatin1().constData()) << n;
+        }
+    }
+
+    void EquationSystemSolver_Reuse_Factorization()
+    {
+        QFETCH(int, n);
+
+        std::mt19937 generator(static_cast<unsigned>(n));
+        std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+        Matrix jacobian1(n,n), jacobian2(n,n), reference(n,n);
+        Vec equations1(n), equations2(n), variables(n), expected(n), delta(n);
+        std::vector<int> order(static_cast<size_t>(n));
+        for (int i=0; i<n; ++i)
+        {
+            equations1[i] = distribution(generator);
+            equations2[i] = distribution(generator);
+            variables[i] = distribution(generator);
+            for (int j=0; j<n; ++j)
+            {
+                jacobian1[i][j] = distribution(generator) + ((i == j) ? n : 0);
+                jacobian2[i][j] = distribution(generator) + ((i == j) ? n : 0);
+                reference[i][j] = jacobian1[i][j];
+            }
+        }
+        QVERIFY(ludcmp(reference, order.data()));
+
+        EquationSystemSolver solver(nullptr, n);
+        solver.setReuseFactorization(true);
+
+        // The first iteration factorizes the Jacobian
+        solvlu(reference, equations1, delta, order.data());
+        for (int i=0; i<n; ++i)
+        {
+            expected[i] = variables[i] - delta[i];
+        }
+        solver.solve(jacobian1, equations1, variables, 1);
+        for (int i=0; i<n; ++i)
+        {
+            QCOMPARE(variables[i], expected[i]);
+        }
+
+        // The second iteration must use the factorization of the first Jacobian, not the new one
+        solvlu(reference, equations2, delta, order.data());
+        for (int i=0; i<n; ++i)
+        {
+            expected[i] = variables[i] - 0.67*delta[i];
+        }
+        solver.solve(jacobian2, equations2, variables, 2);
+        for (int i=0; i<n; ++i)
+        {
+            QCOMPARE(variables[i], expected[i]);
+        }
+    }
+
+    void EquationSystemSolver_Reuse_Factorization_data()
+    {
+        QTest::addColumn<int>("n");
+        QTest::newRow("2") << 2;
+        QTest::newRow("5") << 5;
+        QTest::newRow("8") << 8;
+        QTest::newRow("13") << 13;
+    }
 };
 
 
@@ -1,5 +1,6 @@
 TEMPLATE = subdirs
 SUBDIRS = HStringTest HVectorTest SimulationTest \
+    NumHopTest \
     LookupTableTest \
     UtilitiesTest \
     ComponentUtilitiesTest
@@ -27,6 +27,7 @@
 #include <QPointF>
 #include <QtTest>
 #include <QTextStream>
+#include <algorithm>
 
 
 #include "ComponentUtilities/LookupTable.h"
@@ -114,6 +115,12 @@ private Q_SLOTS:
     void lookup2D_data();
     void lookup3D();
     void lookup3D_data();
+    void lookupCachedAndBatch();
+    void lookupCachedAndBatch_data();
+    void benchmark1D();
+    void benchmark1D_data();
+    void benchmark2D();
+    void benchmark2D_data();
 };
 
 LookupTableTest::LookupTableTest()
@@ -252,6 +259,175 @@ void LookupTableTest::lookup3D()
     }
 }
 
+void LookupTableTest::lookupCachedAndBatch()
+{
+    QFETCH(QVector<double>, indexData);
+    QFETCH(bool, equidistant);
+
+    // One table for batch lookup and one for sequential single lookups, both remembering the last interval
+    LookupTable1D lookup1d, reference1d;
+    QVector<double> valueData;
+    for (int i=0; i<indexData.size(); ++i)
+    {
+        valueData << sin(0.1*i)+0.01*i;
+    }
+    lookup1d.getIndexDataRef() = indexData.toStdVector();
+    lookup1d.getValueDataRef() = valueData.toStdVector();
+    QVERIFY(lookup1d.isDataOK());
+    QCOMPARE(lookup1d.isIndexEquidistant(0), equidistant);
+    reference1d.getIndexDataRef() = indexData.toStdVector();
+    reference1d.getValueDataRef() = valueData.toStdVector();
+    QVERIFY(reference1d.isDataOK());
+
+    // Smooth sweep back and forth across the range, plus random jumps, including exact index points and out of range
+    const double first = indexData.first(), last = indexData.last();
+    std::vector<double> x, y(4000);
+    for (size_t i=0; i<2000; ++i)
+    {
+        x.push_back(first-1.0 + (last-first+2.0)*0.5*(1.0-cos(i*0.01)));
+    }
+    for (size_t i=0; i<2000; ++i)
+    {
+        x.push_back((i%2) ? indexData[rand() % indexData.size()] : first + (last-first)*double(rand())/RAND_MAX);
+    }
+
+    lookup1d.interpolate(x.data(), y.data(), x.size());
+    for (size_t i=0; i<x.size(); ++i)
+    {
+        // Independent reference, a plain binary search for the interval (index[idx], index[idx+1]] containing x
+        double expected;
+        if (x[i] < first)
+        {
+            expected = valueData.first();
+        }
+        else if (x[i] >= last)
+        {
+            expected = valueData.last();
+        }
+        else
+        {
+            const int upper = int(std::lower_bound(indexData.begin(), indexData.end(), x[i]) - indexData.begin());
+            const int idx = std::max(upper-1, 0);
+            expected = valueData[idx] + (x[i] - indexData[idx])*(valueData[idx+1] - valueData[idx])/(indexData[idx+1] - indexData[idx]);
+        }
+        QVERIFY2(y[i] == expected, QString("Batch interpolate returned the wrong result at %1: %2!=%3").arg(x[i]).arg(y[i]).arg(expected).toLatin1());
+        QVERIFY2(reference1d.interpolate(x[i]) == expected, QString("Cached interpolate returned the wrong result at %1").arg(x[i]).toLatin1());
+    }
+}
+
+void LookupTableTest::lookupCachedAndBatch_data()
+{
+    QTest::addColumn< QVector<double> >("indexData");
+    QTest::addColumn< bool >("equidistant");
+
+    QVector<double> indexVec;
+    for (int i=0; i<500; ++i)
+    {
+        indexVec << -3.0+0.1*i;
+    }
+    QTest::newRow("equidistant") << indexVec << true;
+
+    indexVec.clear();
+    double x=-3.0;
+    for (int i=0; i<500; ++i)
+    {
+        indexVec << x;
+        x += 0.01+0.001*(rand() % 100);
+    }
+    QTest::newRow("nonequidistant") << indexVec << false;
+}
+
+void LookupTableTest::benchmark1D()
+{
+    QFETCH(bool, equidistant);
+    QFETCH(bool, batch);
+
+    LookupTable1D lookup1d;
+    std::vector<double> &rIndex = lookup1d.getIndexDataRef();
+    std::vector<double> &rValue = lookup1d.getValueDataRef();
+    double x=0;
+    for (int i=0; i<10000; ++i)
+    {
+        rIndex.push_back(x);
+        rValue.push_back(sin(x));
+        x += equidistant ? 0.01 : 0.005+0.0001*(rand() % 100);
+    }
+    QVERIFY(lookup1d.isDataOK());
+
+    // Smoothly varying input, as from a simulation
+    std::vector<double> in(100000), out(in.size());
+    for (size_t i=0; i<in.size(); ++i)
+    {
+        in[i] = rIndex.back()*0.5*(1.0+sin(i*1e-4));
+    }
+
+    if (batch)
+    {
+        QBENCHMARK
+        {
+            lookup1d.interpolate(in.data(), out.data(), in.size());
+        }
+    }
+    else
+    {
+        QBENCHMARK
+        {
+            for (size_t i=0; i<in.size(); ++i)
+            {
+                out[i] = lookup1d.interpolate(in[i]);
+            }
+        }
+    }
+}
+
+void LookupTableTest::benchmark1D_data()
+{
+    QTest::addColumn< bool >("equidistant");
+    QTest::addColumn< bool >("batch");
+    QTest::newRow("equidistant") << true << false;
+    QTest::newRow("equidistant_batch") << true << true;
+    QTest::newRow("nonequidistant") << false << false;
+    QTest::newRow("nonequidistant_batch") << false << true;
+}
+
+void LookupTableTest::benchmark2D()
+{
+    QFETCH(bool, equidistant);
+
+    LookupTable2D lookup2d;
+    double x=0;
+    for (int i=0; i<500; ++i)
+    {
+        lookup2d.getIndexDataRef(0).push_back(x);
+        lookup2d.getIndexDataRef(1).push_back(x);
+        x += equidistant ? 0.01 : 0.005+0.0001*(rand() % 100);
+    }
+    for (int i=0; i<500*500; ++i)
+    {
+        lookup2d.getValueDataRef().push_back(sin(0.001*i));
+    }
+    QVERIFY(lookup2d.isDataOK());
+
+    std::vector<double> r(100000), c(r.size()), out(r.size());
+    for (size_t i=0; i<r.size(); ++i)
+    {
+        r[i] = x*0.5*(1.0+sin(i*1e-4));
+        c[i] = x*0.5*(1.0+cos(i*1e-4));
+    }
+
+    QBENCHMARK
+    {
+        lookup2d.interpolate(r.data(), c.data(), out.data(), r.size());
+    }
+}
+
+void LookupTableTest::benchmark2D_data()
+{
+    QTest::addColumn< bool >("equidistant");
+    QTest::newRow("equidistant") << true;
+    QTest::newRow("nonequidistant") << false;
+}
+
 void LookupTableTest::lookup1D_data()
 {
     QTest::addColumn< QVector<double> >("indexData");
@@ -0,0 +1,26 @@
+QT       += testlib
+QT       -= gui
+
+#Determine debug extension
+include( ../../../Common.prf )
+
+TARGET = tst_numhoptest$${DEBUG_EXT}
+CONFIG   += console
+CONFIG   -= app_bundle
+DESTDIR = $${PWD}/../../../bin
+
+TEMPLATE = app
+
+
+INCLUDEPATH += $${PWD}/../../../HopsanCore/include/
+LIBS += -L$${PWD}/../../../bin -lhopsancore$${DEBUG_EXT}
+DEFINES *= HOPSANCORE_DLLIMPORT
+
+unix{
+QMAKE_LFLAGS *= -Wl,-rpath,\'\$$ORIGIN/./\'
+
+}
+
+SOURCES += \
+    tst_numhoptest.cpp
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
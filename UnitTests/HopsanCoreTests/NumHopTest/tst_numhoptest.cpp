@@ -0,0 +1,184 @@
+/*-----------------------------------------------------------------------------
+
+ Copyright 2017 Hopsan Group
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+
+ The full license is available in the file LICENSE.
+ For details about the 'Hopsan Group' or information about Authors and
+ Contributors see the HOPSANGROUP and AUTHORS files that are located in
+ the Hopsan source code root directory.
+
+-----------------------------------------------------------------------------*/
+
+#include <QtTest>
+#include <cmath>
+#include "HopsanEssentials.h"
+#include "CoreUtilities/NumHopHelper.h"
+
+using namespace hopsan;
+
+Q_DECLARE_METATYPE(HString);
+
+class NumHopTests : public QObject
+{
+    Q_OBJECT
+
+private:
+    HopsanEssentials mHopsanCore;
+    ComponentSystem *mpSystem = nullptr;
+    double mIn = 0, mOut = 0;
+
+    //! @brief Set up a helper for a component with "in" and "out" registered
+    void setupHelper(NumHopHelper &rHelper)
+    {
+        rHelper.setComponent(mpSystem);
+        rHelper.registerDataPtr("in", &mIn);
+        rHelper.registerDataPtr("out", &mOut);
+    }
+
+private Q_SLOTS:
+    void init()
+    {
+        mpSystem = mHopsanCore.createComponentSystem();
+        QVERIFY(mpSystem);
+    }
+
+    void cleanup()
+    {
+        mHopsanCore.removeComponent(mpSystem);
+    }
+
+    void NumHop_Compiled_Matches_Interpreted()
+    {
+        QFETCH(HString, script);
+
+        NumHopHelper interpreted, compiled;
+        setupHelper(interpreted);
+        setupHelper(compiled);
+        HString output;
+        QVERIFY2(interpreted.interpretNumHopScript(script, false, output), output.c_str());
+        QVERIFY2(compiled.compileNumHopScript(script, output), output.c_str());
+        QVERIFY(compiled.isCompiled());
+
+        for (int i=-20; i<=20; ++i)
+        {
+            mIn = 0.25*i;
+            mOut = 0;
+            double expected;
+            QVERIFY(interpreted.eval(expected, false, output));
+            const double expectedOut = mOut;
+
+            mOut = 0;
+            const double value = compiled.evalCompiled();
+            QVERIFY2(std::fabs(value-expected) <= 1e-12*std::max(1.0, std::fabs(expected)), script.c_str());
+            QVERIFY2(std::fabs(mOut-expectedOut) <= 1e-12*std::max(1.0, std::fabs(expectedOut)), script.c_str());
+        }
+    }
+
+    void NumHop_Compiled_Matches_Interpreted_data()
+    {
+        QTest::addColumn<HString>("script");
+        QTest::newRow("0") << HString("b=2\na = 2 * b\nout = a * in +3");
+        QTest::newRow("1") << HString("# Comment\nx = in*2; out = pi - x^2");
+        QTest::newRow("2") << HString("out = sin(in)*max(in, 0.5) - atan2(in, 2) + abs(in)/3");
+        QTest::newRow("3") << HString("out = (in > 0.5) - (in < 1)");
+        QTest::newRow("4") << HString("a = in\na = a*a + 1\nout = 2^a + a/(1+a)");
+        QTest::newRow("5") << HString("out = 1 + 2*3 - 4/8");
+    }
+
+    void NumHop_Not_Compiled()
+    {
+        QFETCH(HString, script);
+
+        NumHopHelper helper;
+        setupHelper(helper);
+        HString output;
+        QVERIFY(!helper.compileNumHopScript(script, output));
+        QVERIFY(!helper.isCompiled());
+        QVERIFY(!output.empty());
+    }
+
+    void NumHop_Not_Compiled_data()
+    {
+        QTest::addColumn<HString>("script");
+        QTest::newRow("AssignParameter") << HString("self.x = in");
+        QTest::newRow("BooleanOperator") << HString("out = in | 1");
+        QTest::newRow("UnknownVariable") << HString("out = in + unknown");
+        QTest::newRow("UnknownFunction") << HString("out = foo(in)");
+        QTest::newRow("Syntax") << HString("out = (in + 1");
+    }
+
+    void NumHop_Compiled_Benchmark()
+    {
+        QFETCH(bool, compiledEval);
+
+        const HString script = "b=2\na = 2 * b\nout = a * in +3";
+        const size_t numEvals = 10000;
+
+        NumHopHelper interpreted, compiled;
+        setupHelper(interpreted);
+        setupHelper(compiled);
+        HString output;
+        QVERIFY(interpreted.interpretNumHopScript(script, false, output));
+        QVERIFY(compiled.compileNumHopScript(script, output));
+
+        double sum = 0, compiledSum = 0;
+        for (size_t i=0; i<numEvals; ++i)
+        {
+            mIn = double(i);
+            double value;
+            interpreted.eval(value, false, output);
+            sum += mOut;
+            compiled.evalCompiled();
+            compiledSum += mOut;
+        }
+        QCOMPARE(compiledSum, sum);
+
+        if (compiledEval)
+        {
+            QBENCHMARK
+            {
+                for (size_t i=0; i<numEvals; ++i)
+                {
+                    mIn = double(i);
+                    compiled.evalCompiled();
+                }
+            }
+        }
+        else
+        {
+            QBENCHMARK
+            {
+                for (size_t i=0; i<numEvals; ++i)
+                {
+                    mIn = double(i);
+                    double value;
+                    interpreted.eval(value, false, output);
+                }
+            }
+        }
+    }
+
+    void NumHop_Compiled_Benchmark_data()
+    {
+        QTest::addColumn<bool>("compiledEval");
+        QTest::newRow("interpreted") << false;
+        QTest::newRow("compiled") << true;
+    }
+};
+
+QTEST_APPLESS_MAIN(NumHopTests)
+
+#include "tst_numhoptest.moc"
@@ -28,9 +28,15 @@
 #include "HopsanCoreVersion.h"
 #include "CoreUtilities/HopsanCoreMessageHandler.h"
 #include "CoreUtilities/HmfLoader.h"
+#include "CoreUtilities/MultiThreadingUtilities.h"
+#include "CoreUtilities/SweepRunner.h"
+#include "CoreUtilities/ModelBuilder.h"
+#include "CoreUtilities/RealtimeRunner.h"
 
 #include <assert.h>
 #include <algorithm>
+#include <functional>
+#include <map>
 
 #ifndef DEFAULT_LIBRARY_ROOT
 #define DEFAULT_LIBRARY_ROOT "../componentLibraries/defaultLibrary"
@@ -985,6 +991,31 @@ private slots:
         QTest::newRow("0") << HString("TestStep") << HString("NewName");
     }
 
+    void System_Unique_Names_After_Removal()
+    {
+        // Suffixes of removed components are reused, before new suffixes are taken
+        ComponentSystem* pSystem = mHopsanCore.createComponentSystem();
+        std::vector<Component*> gains;
+        for (size_t g=0; g<4; ++g)
+        {
+            Component* pGain = mHopsanCore.createComponent("SignalGain");
+            pSystem->addComponent(pGain);
+            gains.push_back(pGain);
+        }
+        QCOMPARE(QString(gains[0]->getName().c_str()), QString("SignalGain"));
+        QCOMPARE(QString(gains[3]->getName().c_str()), QString("SignalGain_3"));
+
+        pSystem->removeSubComponent(gains[1], true);
+        Component* pGain = mHopsanCore.createComponent("SignalGain");
+        pSystem->addComponent(pGain);
+        QCOMPARE(QString(pGain->getName().c_str()), QString("SignalGain_1"));
+        pGain = mHopsanCore.createComponent("SignalGain");
+        pSystem->addComponent(pGain);
+        QCOMPARE(QString(pGain->getName().c_str()), QString("SignalGain_4"));
+
+        mHopsanCore.removeComponent(pSystem);
+    }
+
     void System_Disconnect_Connect()
     {
         QFETCH(QString, fullPortName1);
@@ -1078,18 +1109,897 @@ private slots:
         QVERIFY2(mpSystemFromFile->getLogTimeVector()->size() == 2048, "Failed to simulate system!");
         QVERIFY2(mpSystemFromFile->getNumActuallyLoggedSamples() == 2048, "Failed to simulate system!");
 
-        std::vector<double> multiResults1 = mpSystemFromFile->getSubComponent("TestStep")->getPort("out")->getLogDataVectorPtr()->at(0);
-        std::vector<double> multiResults2 = mpSystemFromFile->getSubComponent("TestStep")->getPort("out")->getLogDataVectorPtr()->at(511);
-        std::vector<double> multiResults3 = mpSystemFromFile->getSubComponent("TestStep")->getPort("out")->getLogDataVectorPtr()->at(1023);
+        double multiResults1 = mpSystemFromFile->getSubComponent("TestStep")->getPort("out")->getLogDataVariablePtr(0)->at(0);
+        double multiResults2 = mpSystemFromFile->getSubComponent("TestStep")->getPort("out")->getLogDataVariablePtr(0)->at(511);
+        double multiResults3 = mpSystemFromFile->getSubComponent("TestStep")->getPort("out")->getLogDataVariablePtr(0)->at(1023);
         mpSystemFromFile->simulate(10.0);
-        std::vector<double> singleResults1 = mpSystemFromFile->getSubComponent("TestStep")->getPort("out")->getLogDataVectorPtr()->at(0);
-        std::vector<double> singleResults2 = mpSystemFromFile->getSubComponent("TestStep")->getPort("out")->getLogDataVectorPtr()->at(511);
-        std::vector<double> singleResults3 = mpSystemFromFile->getSubComponent("TestStep")->getPort("out")->getLogDataVectorPtr()->at(1023);
+        double singleResults1 = mpSystemFromFile->getSubComponent("TestStep")->getPort("out")->getLogDataVariablePtr(0)->at(0);
+        double singleResults2 = mpSystemFromFile->getSubComponent("TestStep")->getPort("out")->getLogDataVariablePtr(0)->at(511);
+        double singleResults3 = mpSystemFromFile->getSubComponent("TestStep")->getPort("out")->getLogDataVariablePtr(0)->at(1023);
         QVERIFY2(multiResults1 == singleResults1, "Single-threaded and multi-threaded simulation gave different results!");
         QVERIFY2(multiResults2 == singleResults2, "Single-threaded and multi-threaded simulation gave different results!");
         QVERIFY2(multiResults3 == singleResults3, "Single-threaded and multi-threaded simulation gave different results!");
     }
 
+    void System_Simulate_Multicore_TaskStealing()
+    {
+        Port* pPort = mpSystemFromFile->getSubComponent("TestTank")->getPort("P1");
+        const int pressureId = pPort->getNodeDataIdFromName("Pressure");
+        QVERIFY(pressureId >= 0);
+
+        QVERIFY(mpSystemFromFile->initialize(0, 10.0));
+        mpSystemFromFile->simulate(10.0);
+        const std::vector<double> singleResults = *pPort->getLogDataVariablePtr(size_t(pressureId));
+        mpSystemFromFile->finalize();
+
+        // Simulate twice, the second simulation reuses the worker threads from the first
+        for (int i=0; i<2; ++i)
+        {
+            QVERIFY(mpSystemFromFile->initialize(0, 10.0));
+            mpSystemFromFile->simulateMultiThreaded(0, 10.0, 4, false, hopsan::TaskStealingAlgorithm);
+            QVERIFY2(mpSystemFromFile->getNumActuallyLoggedSamples() == 2048, "Failed to simulate system!");
+            const std::vector<double> multiResults = *pPort->getLogDataVariablePtr(size_t(pressureId));
+            QVERIFY2(multiResults == singleResults, "Single-threaded and work-stealing simulation gave different results!");
+            mpSystemFromFile->finalize();
+        }
+    }
+
+    void System_Simulate_Multicore_TaskStealing_Subsystems()
+    {
+        // Four Q-type subsystems, each a line of orifices and volumes fed by a pressure source in the top level system
+        const size_t numSubsystems = 4;
+        const size_t numVolumes = 50;
+        ComponentSystem* pSystem = mHopsanCore.createComponentSystem();
+        std::vector<Port*> probePorts;
+        for (size_t s=0; s<numSubsystems; ++s)
+        {
+            ComponentSystem* pSubsystem = mHopsanCore.createComponentSystem();
+            pSystem->addComponent(pSubsystem);
+            Port* pSystemPort = pSubsystem->addSystemPort("P1");
+            Port* pPrevious = pSystemPort;
+            for (size_t v=0; v<numVolumes; ++v)
+            {
+                Component* pOrifice = mHopsanCore.createComponent("HydraulicLaminarOrifice");
+                Component* pVolume = mHopsanCore.createComponent("HydraulicVolume");
+                QVERIFY(pOrifice && pVolume);
+                pSubsystem->addComponent(pOrifice);
+                pSubsystem->addComponent(pVolume);
+                QVERIFY(pSubsystem->connect(pPrevious, pOrifice->getPort("P1")));
+                QVERIFY(pSubsystem->connect(pOrifice->getPort("P2"), pVolume->getPort("P1")));
+                pPrevious = pVolume->getPort("P2");
+            }
+            probePorts.push_back(pPrevious);
+            Component* pOrifice = mHopsanCore.createComponent("HydraulicLaminarOrifice");
+            Component* pTank = mHopsanCore.createComponent("HydraulicTankC");
+            pSubsystem->addComponent(pOrifice);
+            pSubsystem->addComponent(pTank);
+            QVERIFY(pSubsystem->connect(pPrevious, pOrifice->getPort("P1")));
+            QVERIFY(pSubsystem->connect(pOrifice->getPort("P2"), pTank->getPort("P1")));
+
+            Component* pSource = mHopsanCore.createComponent("HydraulicPressureSourceC");
+            pSystem->addComponent(pSource);
+            QVERIFY(pSource->setParameterValue("p#Value", HString(std::to_string(1e6*double(s+1)).c_str())));
+            QVERIFY(pSystem->connect(pSource->getPort("P1"), pSystemPort));
+            QCOMPARE(pSubsystem->getTypeCQS(), Component::QType);
+        }
+        const int pressureId = probePorts[0]->getNodeDataIdFromName("Pressure");
+        QVERIFY(pressureId >= 0);
+
+        const double stopTime = 1.0;
+        pSystem->setDesiredTimestep(1e-4);
+        pSystem->setNumLogSamples(256);
+        QVERIFY(pSystem->initialize(0, stopTime));
+        pSystem->simulate(stopTime);
+        std::vector< std::vector<double> > singleResults;
+        for (size_t s=0; s<numSubsystems; ++s)
+        {
+            singleResults.push_back(*probePorts[s]->getLogDataVariablePtr(size_t(pressureId)));
+        }
+        pSystem->finalize();
+        QVERIFY(singleResults[0].back() > 1e5);
+
+        // The subsystems are expanded into their components, giving many more tasks than subsystems
+        QVERIFY(pSystem->initialize(0, stopTime));
+        pSystem->simulateMultiThreaded(0, stopTime, 4, false, hopsan::TaskStealingAlgorithm);
+        QCOMPARE(pSystem->getNumExpandedSubsystems(), numSubsystems);
+        for (size_t s=0; s<numSubsystems; ++s)
+        {
+            QVERIFY2(*probePorts[s]->getLogDataVariablePtr(size_t(pressureId)) == singleResults[s], "Single-threaded and expanded work-stealing simulation gave different results!");
+            QCOMPARE(probePorts[s]->getComponent()->getSystemParent()->getTime(), pSystem->getTime());
+        }
+        pSystem->finalize();
+
+        mHopsanCore.removeComponent(pSystem);
+    }
+
+    void System_Simulate_Multicore_TaskStealing_Subsystem_Sensors_data()
+    {
+        QTest::addColumn<bool>("sensorInSubsystem");
+        QTest::addColumn<size_t>("numExpanded");
+        QTest::newRow("sensor in subsystem") << true << size_t(0);
+        QTest::newRow("sensor in top level system") << false << size_t(1);
+    }
+
+    void System_Simulate_Multicore_TaskStealing_Subsystem_Sensors()
+    {
+        QFETCH(bool, sensorInSubsystem);
+        QFETCH(size_t, numExpanded);
+
+        // A Q-type subsystem fed through a volume (C-type), with a node sensor on the node at the subsystem port
+        ComponentSystem* pSystem = mHopsanCore.createComponentSystem();
+        ComponentSystem* pSubsystem = mHopsanCore.createComponentSystem();
+        pSystem->addComponent(pSubsystem);
+        Port* pSystemPort = pSubsystem->addSystemPort("P1");
+        Port* pPrevious = pSystemPort;
+        for (size_t v=0; v<10; ++v)
+        {
+            Component* pOrifice = mHopsanCore.createComponent("HydraulicLaminarOrifice");
+            Component* pVolume = mHopsanCore.createComponent("HydraulicVolume");
+            QVERIFY(pOrifice && pVolume);
+            pSubsystem->addComponent(pOrifice);
+            pSubsystem->addComponent(pVolume);
+            QVERIFY(pSubsystem->connect(pPrevious, pOrifice->getPort("P1")));
+            QVERIFY(pSubsystem->connect(pOrifice->getPort("P2"), pVolume->getPort("P1")));
+            pPrevious = pVolume->getPort("P2");
+        }
+        Component* pOrifice = mHopsanCore.createComponent("HydraulicLaminarOrifice");
+        Component* pTank = mHopsanCore.createComponent("HydraulicTankC");
+        pSubsystem->addComponent(pOrifice);
+        pSubsystem->addComponent(pTank);
+        QVERIFY(pSubsystem->connect(pPrevious, pOrifice->getPort("P1")));
+        QVERIFY(pSubsystem->connect(pOrifice->getPort("P2"), pTank->getPort("P1")));
+
+        Component* pSource = mHopsanCore.createComponent("HydraulicPressureSourceC");
+        Component* pFeedOrifice = mHopsanCore.createComponent("HydraulicLaminarOrifice");
+        Component* pFeedVolume = mHopsanCore.createComponent("HydraulicVolume");
+        pSystem->addComponent(pSource);
+        pSystem->addComponent(pFeedOrifice);
+        pSystem->addComponent(pFeedVolume);
+        QVERIFY(pSource->setParameterValue("p#Value", "1e6"));
+        QVERIFY(pSystem->connect(pSource->getPort("P1"), pFeedOrifice->getPort("P1")));
+        QVERIFY(pSystem->connect(pFeedOrifice->getPort("P2"), pFeedVolume->getPort("P1")));
+        QVERIFY(pSystem->connect(pFeedVolume->getPort("P2"), pSystemPort));
+        QCOMPARE(pSubsystem->getTypeCQS(), Component::QType);
+
+        // The sensor also reads the wave variable, that the volume writes in the C phase
+        Component* pSensor = mHopsanCore.createComponent("HydraulicNodeSensor");
+        ComponentSystem* pSensorSystem = sensorInSubsystem ? pSubsystem : pSystem;
+        pSensorSystem->addComponent(pSensor);
+        QVERIFY(pSensorSystem->connect(pSystemPort, pSensor->getPort("P1")));
+        Port* pWavePort = pSensor->getPort("c");
+
+        const double stopTime = 0.05;
+        pSystem->setDesiredTimestep(1e-4);
+        pSystem->setNumLogSamples(200);
+        QVERIFY(pSystem->initialize(0, stopTime));
+        pSystem->simulate(stopTime);
+        const std::vector<double> singleResult = *pWavePort->getLogDataVariablePtr(0);
+        pSystem->finalize();
+        QVERIFY(singleResult.back() > 1e5);
+
+        QVERIFY(pSystem->initialize(0, stopTime));
+        pSystem->simulateMultiThreaded(0, stopTime, 4, false, hopsan::TaskStealingAlgorithm);
+        QCOMPARE(pSystem->getNumExpandedSubsystems(), numExpanded);
+        QVERIFY2(*pWavePort->getLogDataVariablePtr(0) == singleResult, "Single-threaded and work-stealing simulation gave different sensor results!");
+        pSystem->finalize();
+
+        mHopsanCore.removeComponent(pSystem);
+    }
+
+    void System_Partition_CQ_Components()
+    {
+        // A line of orifices and volumes, every node is shared by one C and one Q component
+        const size_t numVolumes = 40;
+        const size_t nThreads = 4;
+        ComponentSystem* pSystem = mHopsanCore.createComponentSystem();
+        std::vector< std::pair<Component*, Component*> > sharedNodes;
+        std::vector<Component*> cComponents, qComponents;
+        Component* pPrevious = mHopsanCore.createComponent("HydraulicPressureSourceC");
+        QVERIFY(pPrevious);
+        pSystem->addComponent(pPrevious);
+        cComponents.push_back(pPrevious);
+        for (size_t v=0; v<numVolumes; ++v)
+        {
+            Component* pOrifice = mHopsanCore.createComponent("HydraulicLaminarOrifice");
+            Component* pVolume = mHopsanCore.createComponent("HydraulicVolume");
+            QVERIFY(pOrifice && pVolume);
+            pSystem->addComponent(pOrifice);
+            pSystem->addComponent(pVolume);
+            QVERIFY(pSystem->connect(pPrevious->getPort((pPrevious == cComponents.front()) ? "P1" : "P2"), pOrifice->getPort("P1")));
+            QVERIFY(pSystem->connect(pOrifice->getPort("P2"), pVolume->getPort("P1")));
+            sharedNodes.push_back(std::make_pair(pPrevious, pOrifice));
+            sharedNodes.push_back(std::make_pair(pOrifice, pVolume));
+            qComponents.push_back(pOrifice);
+            cComponents.push_back(pVolume);
+            pPrevious = pVolume;
+            // Uneven measured times, so that the loads have to be balanced
+            pOrifice->setMeasuredTime(1.0);
+            pVolume->setMeasuredTime(1.0+double(v%3));
+        }
+        cComponents.front()->setMeasuredTime(1.0);
+
+        std::vector< std::vector<Component*> > splitC, splitQ;
+        pSystem->partitionCQcomponents(splitC, splitQ, nThreads);
+        QCOMPARE(splitC.size(), nThreads);
+        QCOMPARE(splitQ.size(), nThreads);
+
+        std::map<Component*, size_t> partitionedThread, roundRobinThread;
+        const std::vector< std::vector<Component*> > *splitVectors[] = {&splitC, &splitQ};
+        const std::vector<Component*> *phaseComponents[] = {&cComponents, &qComponents};
+        for (size_t phase=0; phase<2; ++phase)
+        {
+            // Every component is assigned to exactly one thread
+            size_t numAssigned = 0;
+            std::vector<double> load(nThreads, 0.0);
+            for (size_t t=0; t<nThreads; ++t)
+            {
+                for (Component* pComponent : (*splitVectors[phase])[t])
+                {
+                    QVERIFY(partitionedThread.insert(std::make_pair(pComponent, t)).second);
+                    load[t] += pComponent->getMeasuredTime();
+                    ++numAssigned;
+                }
+            }
+            QCOMPARE(numAssigned, phaseComponents[phase]->size());
+
+            // The load limit is the makespan of greedy load balancing, or 5% above the average load if that is larger
+            std::vector<double> costs, greedyLoad(nThreads, 0.0);
+            double totalLoad = 0;
+            for (size_t i=0; i<phaseComponents[phase]->size(); ++i)
+            {
+                Component* pComponent = (*phaseComponents[phase])[i];
+                costs.push_back(pComponent->getMeasuredTime());
+                totalLoad += pComponent->getMeasuredTime();
+                roundRobinThread[pComponent] = i%nThreads;
+            }
+            std::stable_sort(costs.begin(), costs.end(), std::greater<double>());
+            for (double cost : costs)
+            {
+                *std::min_element(greedyLoad.begin(), greedyLoad.end()) += cost;
+            }
+            const double loadLimit = std::max(*std::max_element(greedyLoad.begin(), greedyLoad.end()), 1.05*totalLoad/double(nThreads));
+            for (size_t t=0; t<nThreads; ++t)
+            {
+                QVERIFY2(load[t] <= loadLimit*(1.0+1e-9), QString("Phase %1 thread %2 load %3 exceeds the limit %4").arg(phase).arg(t).arg(load[t]).arg(loadLimit).toLatin1());
+            }
+        }
+
+        size_t partitionedCut = 0, roundRobinCut = 0;
+        for (const std::pair<Component*, Component*> &rNode : sharedNodes)
+        {
+            if (partitionedThread[rNode.first] != partitionedThread[rNode.second])
+            {
+                ++partitionedCut;
+            }
+            if (roundRobinThread[rNode.first] != roundRobinThread[rNode.second])
+            {
+                ++roundRobinCut;
+            }
+        }
+        QVERIFY2(partitionedCut <= roundRobinCut, QString("Partitioned cut %1 is larger than the round-robin cut %2").arg(partitionedCut).arg(roundRobinCut).toLatin1());
+        QVERIFY(partitionedCut < sharedNodes.size()/2);
+
+        mHopsanCore.removeComponent(pSystem);
+    }
+
+    void System_Simulate_Multicore_AdaptiveRescheduling()
+    {
+        Port* pPort = mpSystemFromFile->getSubComponent("TestTank")->getPort("P1");
+        const int pressureId = pPort->getNodeDataIdFromName("Pressure");
+        QVERIFY(pressureId >= 0);
+
+        QVERIFY(mpSystemFromFile->initialize(0, 10.0));
+        mpSystemFromFile->simulate(10.0);
+        const std::vector<double> singleResults = *pPort->getLogDataVariablePtr(size_t(pressureId));
+        mpSystemFromFile->finalize();
+
+        // Sample every step and use a tiny threshold, so that the components are rescheduled during the simulation
+        mpSystemFromFile->setProfilingSampleInterval(1);
+        mpSystemFromFile->setRescheduleImbalanceThreshold(1e-9, 64);
+        const hopsan::ParallelAlgorithmT algorithms[] = {hopsan::APrioriScheduling, hopsan::APrioriHybridBarrierScheduling};
+        for (size_t a=0; a<2; ++a)
+        {
+            QVERIFY(mpSystemFromFile->initialize(0, 10.0));
+            mpSystemFromFile->simulateMultiThreaded(0, 10.0, 4, false, algorithms[a]);
+            QVERIFY2(mpSystemFromFile->getNumActuallyLoggedSamples() == 2048, "Failed to simulate system!");
+            const std::vector<double> multiResults = *pPort->getLogDataVariablePtr(size_t(pressureId));
+            QVERIFY2(multiResults == singleResults, "Single-threaded and rescheduled multi-threaded simulation gave different results!");
+            QVERIFY2(mpSystemFromFile->getThreadLoadStatistics().size() == 4, "Thread load statistics missing");
+            QVERIFY2(mpSystemFromFile->getNumAdaptiveReschedules() > 0, "Components were never rescheduled");
+            mpSystemFromFile->finalize();
+        }
+        mpSystemFromFile->setProfilingSampleInterval(16);
+        mpSystemFromFile->setRescheduleImbalanceThreshold(0.2);
+    }
+
+    void System_Simulate_Profiling()
+    {
+        QVERIFY(!mpSystemFromFile->isProfilingEnabled());
+        mpSystemFromFile->setProfilingEnabled(true);
+        QVERIFY(mpSystemFromFile->initialize(0, 10.0));
+        mpSystemFromFile->simulate(10.0);
+        mpSystemFromFile->finalize();
+
+        const hopsan::ProfileEntry report = mpSystemFromFile->getProfileReport();
+        const size_t numSteps = size_t(10.0/mpSystemFromFile->getTimestep()+0.5);
+        QCOMPARE(report.numCalls, numSteps);
+        QVERIFY(report.totalTime > 0);
+        // One entry per simulated sub component, and one for logging
+        QVERIFY(report.children.size() > 1);
+        QVERIFY(report.children.size() <= mpSystemFromFile->getSubComponentNames().size()+1);
+        QVERIFY(report.children.back().name == "(logging)");
+
+        bool foundTank = false;
+        double childTime = 0;
+        for (size_t c=0; c<report.children.size(); ++c)
+        {
+            childTime += report.children[c].totalTime;
+            if (report.children[c].name == "TestTank")
+            {
+                foundTank = true;
+                QCOMPARE(report.children[c].numCalls, numSteps);
+            }
+        }
+        QVERIFY2(foundTank, "Component missing in profile report");
+        QVERIFY2(childTime <= report.totalTime, "Component times exceed total time");
+        QVERIFY(hopsan::profileReportToJSON(report).find("\"name\": \"TestTank\"") != hopsan::HString::npos);
+
+        mpSystemFromFile->setProfilingEnabled(false);
+        QVERIFY(!mpSystemFromFile->isProfilingEnabled());
+        QVERIFY(mpSystemFromFile->getProfileReport().children.empty());
+    }
+
+    void System_Parameter_Sweep()
+    {
+        hopsan::SweepRunner sweep(&mHopsanCore);
+        QVERIFY2(sweep.loadModel(TEST_DATA_ROOT "unittestmodel.hmf"), sweep.getLastError().c_str());
+        sweep.setSimulationTime(0, 0.001, 1.0);
+
+        std::vector<HString> parameters;
+        parameters.push_back("TestConstant#y#Value");
+        sweep.setParameterNames(parameters);
+        const size_t numCases = 16;
+        for (size_t c=0; c<numCases; ++c)
+        {
+            std::vector<HString> values;
+            values.push_back(std::to_string(c).c_str());
+            QVERIFY(sweep.addCase(values));
+        }
+        std::vector<HString> badValues;
+        badValues.push_back("nonexisting_parameter");
+        QVERIFY(sweep.addCase(badValues));
+
+        std::vector<HString> variables;
+        variables.push_back("TestConstant#y#Value");
+        sweep.setResultVariables(variables);
+
+        // Only the final values
+        sweep.setKeepTimeSeries(false);
+        QVERIFY2(sweep.run(4), sweep.getLastError().c_str());
+        for (size_t c=0; c<numCases; ++c)
+        {
+            const hopsan::SweepCaseResult &rResult = sweep.getResult(c);
+            QVERIFY2(rResult.success, rResult.errorMessage.c_str());
+            QCOMPARE(rResult.values.size(), size_t(1));
+            QCOMPARE(rResult.values[0].size(), size_t(1));
+            QCOMPARE(rResult.values[0].back(), double(c));
+        }
+        QVERIFY(!sweep.getResult(numCases).success);
+        QCOMPARE(sweep.getNumFailedCases(), size_t(1));
+
+        // The full time series, one log sample every ten simulation steps
+        const size_t numSamples = 101;
+        sweep.setKeepTimeSeries(true);
+        sweep.setNumLogSamples(numSamples);
+        QVERIFY2(sweep.run(4), sweep.getLastError().c_str());
+        for (size_t c=0; c<numCases; ++c)
+        {
+            const hopsan::SweepCaseResult &rResult = sweep.getResult(c);
+            QVERIFY2(rResult.success, rResult.errorMessage.c_str());
+            QCOMPARE(rResult.time.size(), numSamples);
+            QCOMPARE(rResult.values.size(), size_t(1));
+            QCOMPARE(rResult.values[0].size(), numSamples);
+            QCOMPARE(rResult.values[0].back(), double(c));
+        }
+    }
+
+    void System_Parameter_Handle()
+    {
+        ComponentSystem* pSubsystem = nullptr;
+        ComponentSystem* pSubsubsystem = nullptr;
+        getSystem("Subsystem", &pSubsystem);
+        getSystem("Subsystem$Subsubsystem", &pSubsubsystem);
+        Component* pGain = pSubsystem->getSubComponent("Gain");
+        QVERIFY(pGain);
+        double* pK = static_cast<double*>(pGain->getParameterDataPtr("k#Value"));
+        QVERIFY(pK);
+
+        // sub_a refers to main_a, subsub_a refers to sub_a and the gain uses sub_a in an expression
+        hopsan::ParameterHandle handle = mpSystemFromFile->getParameterHandle("main_a");
+        QVERIFY(handle.isValid());
+        QVERIFY(handle.getNumDependents() >= 3);
+        QVERIFY(handle.set(3.5));
+        QCOMPARE(handle.get(), 3.5);
+        QCOMPARE(*pK, 5.5);
+
+        HString value;
+        mpSystemFromFile->getParameterValue("main_a", value);
+        QCOMPARE(value.toDouble(nullptr), 3.5);
+        QVERIFY(pSubsubsystem->evaluateParameter("subsub_a", value, "double"));
+        QCOMPARE(value.toDouble(nullptr), 3.5);
+
+        // Changing a dependent parameter through the string interface makes the handle collect the dependencies again
+        QVERIFY(pSubsystem->setParameterValue("sub_a", "2*main_a"));
+        QVERIFY(handle.set(1.0));
+        QCOMPARE(*pK, 4.0);
+
+        // So does a new reference from a parameter that did not depend on the handle parameter before
+        Component* pTestGain = mpSystemFromFile->getSubComponent("TestGain");
+        QVERIFY(pTestGain);
+        double* pTestK = static_cast<double*>(pTestGain->getParameterDataPtr("k#Value"));
+        QVERIFY(pTestK);
+        QVERIFY(pTestGain->setParameterValue("k#Value", "-main_a"));
+        QVERIFY(handle.set(2.0));
+        QCOMPARE(*pTestK, -2.0);
+        QVERIFY(pTestGain->setParameterValue("k#Value", "1"));
+
+        hopsan::ParameterHandle intHandle = mpSystemFromFile->getParameterHandle("main_int_a");
+        QVERIFY(intHandle.isValid());
+        QVERIFY(intHandle.set(3.7));
+        QVERIFY(pSubsystem->evaluateParameter("sub_int_a", value, "integer"));
+        QVERIFY(value == "3");
+
+        QVERIFY(!mpSystemFromFile->getParameterHandle("main_string_a").isValid());
+        QVERIFY(!mpSystemFromFile->getParameterHandle("no_such_parameter").isValid());
+    }
+
+    void System_Parameter_Handle_Benchmark_data()
+    {
+        QTest::addColumn<bool>("useHandle");
+        QTest::newRow("string") << false;
+        QTest::newRow("handle") << true;
+    }
+
+    void System_Parameter_Handle_Benchmark()
+    {
+        QFETCH(bool, useHandle);
+
+        // A flat model with 500 gains, all referring to the same system parameter
+        const size_t numComponents = 500;
+        ComponentSystem* pSystem = mHopsanCore.createComponentSystem();
+        QVERIFY(pSystem->setOrAddSystemParameter("gain", "1", "double"));
+        std::vector<double*> gainPtrs;
+        for (size_t c=0; c<numComponents; ++c)
+        {
+            Component* pComp = mHopsanCore.createComponent("SignalGain");
+            QVERIFY(pComp);
+            pSystem->addComponent(pComp);
+            QVERIFY(pComp->setParameterValue("k#Value", (c%2 == 0) ? "gain" : "-gain"));
+            gainPtrs.push_back(static_cast<double*>(pComp->getParameterDataPtr("k#Value")));
+        }
+
+        hopsan::ParameterHandle handle = pSystem->getParameterHandle("gain");
+        QVERIFY(handle.isValid());
+        QCOMPARE(handle.getNumDependents(), numComponents);
+
+        double value = 0;
+        if (useHandle)
+        {
+            QBENCHMARK
+            {
+                value += 1;
+                handle.set(value);
+            }
+        }
+        else
+        {
+            QBENCHMARK
+            {
+                value += 1;
+                pSystem->setParameterValue("gain", HString(std::to_string(value).c_str()));
+                pSystem->evaluateParametersRecursively();
+            }
+        }
+
+        for (size_t c=0; c<numComponents; ++c)
+        {
+            QCOMPARE(*gainPtrs[c], (c%2 == 0) ? value : -value);
+        }
+
+        mHopsanCore.removeComponent(pSystem);
+    }
+
+    void System_Sort_Signal_Chain_Benchmark()
+    {
+        // A chain of gains fed by a constant, added to the system in reverse order (worst case for sorting)
+        const size_t numGains = 100000;
+        ComponentSystem* pSystem = mHopsanCore.createComponentSystem();
+        std::vector<Component*> gains;
+        for (size_t g=0; g<numGains; ++g)
+        {
+            Component* pGain = mHopsanCore.createComponent("SignalGain");
+            QVERIFY(pGain);
+            pGain->setName(HString("Gain")+HString(std::to_string(g).c_str()));
+            gains.push_back(pGain);
+        }
+        for (size_t g=numGains; g>0; --g)
+        {
+            pSystem->addComponent(gains[g-1]);
+        }
+        Component* pConstant = mHopsanCore.createComponent("SignalConstant");
+        QVERIFY(pConstant);
+        pSystem->addComponent(pConstant);
+        QVERIFY(pSystem->connect(pConstant->getPort("y"), gains[0]->getPort("in")));
+        for (size_t g=1; g<numGains; ++g)
+        {
+            QVERIFY(pSystem->connect(gains[g-1]->getPort("out"), gains[g]->getPort("in")));
+        }
+
+        pSystem->setDesiredTimestep(0.001);
+        QBENCHMARK_ONCE
+        {
+            QVERIFY2(pSystem->initialize(0, 1), "Failed to initialize signal chain");
+        }
+
+        // If sorted correctly, the constant value reaches the end of the chain in one time step
+        pSystem->simulate(0.001);
+        QCOMPARE(*gains.back()->getSafeNodeDataPtr("out", 0), 1.0);
+
+        mHopsanCore.removeComponent(pSystem);
+    }
+
+    void System_Algebraic_Loop_Diagnostics()
+    {
+        // Three gains in a loop, one gain after the loop and one independent gain
+        ComponentSystem* pSystem = mHopsanCore.createComponentSystem();
+        const char* names[] = {"LoopA", "LoopB", "LoopC", "AfterLoop", "Independent"};
+        std::vector<Component*> gains;
+        for (const char* name : names)
+        {
+            Component* pGain = mHopsanCore.createComponent("SignalGain");
+            pGain->setName(name);
+            pSystem->addComponent(pGain);
+            gains.push_back(pGain);
+        }
+        QVERIFY(pSystem->connect(gains[0]->getPort("out"), gains[1]->getPort("in")));
+        QVERIFY(pSystem->connect(gains[1]->getPort("out"), gains[2]->getPort("in")));
+        QVERIFY(pSystem->connect(gains[2]->getPort("out"), gains[0]->getPort("in")));
+        QVERIFY(pSystem->connect(gains[2]->getPort("out"), gains[3]->getPort("in")));
+
+        HopsanCoreMessageHandler* pHandler = mHopsanCore.getCoreMessageHandler();
+        HString message, type, tag;
+        while (pHandler->getNumWaitingMessages() > 0)
+        {
+            pHandler->getMessage(message, type, tag);
+        }
+        QVERIFY2(!pSystem->initialize(0, 1), "A system with an algebraic loop was initialized");
+
+        QStringList loopMessages;
+        while (pHandler->getNumWaitingMessages() > 0)
+        {
+            pHandler->getMessage(message, type, tag);
+            if (QString(message.c_str()).contains("Algebraic loop between"))
+            {
+                loopMessages.append(message.c_str());
+            }
+        }
+        QCOMPARE(loopMessages.size(), 1);
+        QVERIFY2(loopMessages[0].contains("LoopA") && loopMessages[0].contains("LoopB") && loopMessages[0].contains("LoopC"), qPrintable(loopMessages[0]));
+        QVERIFY2(!loopMessages[0].contains("AfterLoop") && !loopMessages[0].contains("Independent"), qPrintable(loopMessages[0]));
+
+        mHopsanCore.removeComponent(pSystem);
+    }
+
+    void Model_Builder_Line_Benchmark()
+    {
+        // A line of gains fed by a constant, built with the model builder and connected by name
+        const size_t numGains = 100000;
+        ComponentSystem* pSystem = mHopsanCore.createComponentSystem();
+        QBENCHMARK_ONCE
+        {
+            ModelBuilder builder(pSystem);
+            builder.reserve(numGains+1, numGains);
+            Component* pConstant = builder.addComponent("SignalConstant", "Source");
+            QVERIFY(pConstant);
+            HString previousName = pConstant->getName();
+            HString previousPort = "y";
+            for (size_t g=0; g<numGains; ++g)
+            {
+                Component* pGain = builder.addComponent("SignalGain", "Gain");
+                QVERIFY(pGain);
+                builder.connect(previousName, previousPort, pGain->getName(), "in");
+                previousName = pGain->getName();
+                previousPort = "out";
+            }
+            QCOMPARE(builder.getNumPendingConnections(), numGains);
+            QVERIFY2(builder.finish(), builder.getLastError().c_str());
+        }
+        QVERIFY(!pSystem->isInBulkConstruction());
+        QCOMPARE(pSystem->getSubComponents().size(), numGains+1);
+
+        // The gains are named Gain, Gain_1, Gain_2 ...
+        Component* pLast = pSystem->getSubComponent(HString("Gain_")+HString(std::to_string(numGains-1).c_str()));
+        QVERIFY(pLast);
+        pSystem->setDesiredTimestep(0.001);
+        QVERIFY2(pSystem->initialize(0, 1), "Failed to initialize line model");
+        pSystem->simulate(0.001);
+        QCOMPARE(*pLast->getSafeNodeDataPtr("out", 0), 1.0);
+
+        mHopsanCore.removeComponent(pSystem);
+    }
+
+    void Model_Builder_Failed_Connections()
+    {
+        // Failed connections are reported when finishing, and the other connections are still made
+        ComponentSystem* pSystem = mHopsanCore.createComponentSystem();
+        {
+            ModelBuilder builder(pSystem);
+            Component* pGain1 = builder.addComponent("SignalGain");
+            Component* pGain2 = builder.addComponent("SignalGain");
+            QVERIFY(pGain1 && pGain2);
+            QVERIFY(!builder.addComponent("NoSuchComponentType"));
+            builder.connect(pGain1, "out", pGain2, "nosuchport");
+            builder.connect("NoSuchComponent", "out", pGain2->getName(), "in");
+            builder.connect(pGain1, "out", pGain2, "in");
+            QVERIFY(!builder.finish());
+            QCOMPARE(builder.getNumFailedConnections(), size_t(2));
+            QVERIFY(QString(builder.getLastError().c_str()).contains("nosuchport"));
+            QVERIFY(pGain1->getPort("out")->isConnectedTo(pGain2->getPort("in")));
+        }
+        mHopsanCore.removeComponent(pSystem);
+    }
+
+    void Model_Builder_Unfinished_Bulk_Construction()
+    {
+        // A system that is simulated without ending the bulk construction (connecting leaves removed sub nodes as null entries)
+        ComponentSystem* pSystem = mHopsanCore.createComponentSystem();
+        pSystem->beginBulkConstruction();
+        Component* pConstant = mHopsanCore.createComponent("SignalConstant");
+        Component* pGain1 = mHopsanCore.createComponent("SignalGain");
+        Component* pGain2 = mHopsanCore.createComponent("SignalGain");
+        QVERIFY(pConstant && pGain1 && pGain2);
+        pSystem->addComponent(pConstant);
+        pSystem->addComponent(pGain1);
+        pSystem->addComponent(pGain2);
+        QVERIFY(pSystem->connect(pConstant->getPort("y"), pGain1->getPort("in")));
+        QVERIFY(pSystem->connect(pGain1->getPort("out"), pGain2->getPort("in")));
+        QVERIFY(pSystem->checkModelBeforeSimulation());
+        QVERIFY(!pSystem->isInBulkConstruction());
+
+        pSystem->beginBulkConstruction();
+        pSystem->setDesiredTimestep(0.001);
+        QVERIFY(pSystem->initialize(0, 1));
+        QVERIFY(!pSystem->isInBulkConstruction());
+        pSystem->simulate(0.001);
+        QCOMPARE(*pGain2->getSafeNodeDataPtr("out", 0), 1.0);
+        pSystem->finalize();
+
+        mHopsanCore.removeComponent(pSystem);
+    }
+
+    void Spsc_Ring_Buffer()
+    {
+        SpscRingBuffer buffer(100, 2);
+        QCOMPARE(buffer.capacity(), size_t(128));
+
+        // Frames arrive complete and in order, from a producer thread to this (consumer) thread
+        const size_t numFrames = 10000;
+        std::thread producer([&buffer, numFrames]() {
+            for (size_t i=0; i<numFrames; )
+            {
+                const double frame[2] = {double(i), -double(i)};
+                if (buffer.push(frame))
+                {
+                    ++i;
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        size_t numReceived = 0;
+        bool inOrder = true;
+        double frame[2];
+        while (numReceived < numFrames)
+        {
+            if (buffer.pop(frame))
+            {
+                inOrder = inOrder && (frame[0] == double(numReceived)) && (frame[1] == -double(numReceived));
+                ++numReceived;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+        producer.join();
+        QVERIFY(inOrder);
+        QCOMPARE(buffer.size(), size_t(0));
+
+        // A full buffer rejects frames
+        for (size_t i=0; i<buffer.capacity(); ++i)
+        {
+            QVERIFY(buffer.push(frame));
+        }
+        QVERIFY(!buffer.push(frame));
+    }
+
+    void Realtime_Runner_Exchange()
+    {
+        // A gain, with its input fed by an external producer thread and its output read by this thread
+        ComponentSystem* pSystem = mHopsanCore.createComponentSystem();
+        Component* pGain = mHopsanCore.createComponent("SignalGain");
+        pSystem->addComponent(pGain);
+        QVERIFY(pGain->setParameterValue("k#Value", "2"));
+        const double timestep = 0.001;
+        const double stopTime = 0.2;
+        pSystem->setDesiredTimestep(timestep);
+        QVERIFY2(pSystem->initialize(0, stopTime), "Failed to initialize realtime model");
+
+        RealtimeRunner runner(pSystem);
+        QVERIFY(!runner.addInput(pGain->getName(), "in", "NoSuchVariable"));
+        QVERIFY(runner.addInput(pGain->getName(), "in", "Value"));
+        QVERIFY(runner.addOutput(pGain->getName(), "out", "Value"));
+        runner.setHistogram(100e-6, 50);
+
+        const size_t numInputs = 10;
+        std::thread producer([&runner, numInputs]() {
+            for (size_t i=1; i<=numInputs; ++i)
+            {
+                const double value = double(i);
+                runner.pushInputs(&value);
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+        });
+        QVERIFY2(runner.start(stopTime), runner.getLastError().c_str());
+        QVERIFY(!runner.start(stopTime));
+        producer.join();
+        QVERIFY(runner.wait());
+        QVERIFY(!runner.isRunning());
+
+        // All steps are taken and every input frame is consumed
+        const RealtimeStatistics &rStatistics = runner.getStatistics();
+        const size_t numSteps = size_t(stopTime/timestep+0.5);
+        QCOMPARE(rStatistics.numSteps, numSteps);
+        QCOMPARE(rStatistics.numInputFrames, numInputs);
+        size_t latencySum=0, jitterSum=0;
+        for (size_t b=0; b<rStatistics.latencyHistogram.size(); ++b)
+        {
+            latencySum += rStatistics.latencyHistogram[b];
+            jitterSum += rStatistics.jitterHistogram[b];
+        }
+        QCOMPARE(latencySum, numSteps);
+        QCOMPARE(jitterSum, numSteps-1);
+
+        // One output frame per step, reflecting the inputs in the order they were produced
+        size_t numOutputs = 0;
+        double time, value, previousTime=0, previousValue=0;
+        bool inOrder = true;
+        while (runner.popOutputs(time, &value))
+        {
+            inOrder = inOrder && (time > previousTime) && (value >= previousValue);
+            previousTime = time;
+            previousValue = value;
+            ++numOutputs;
+        }
+        QCOMPARE(numOutputs, numSteps);
+        QVERIFY(inOrder);
+        QCOMPARE(previousValue, 2.0*double(numInputs));
+        QVERIFY(qAbs(previousTime-stopTime) < timestep*0.5);
+
+        mHopsanCore.removeComponent(pSystem);
+    }
+
+    void Component_Equation_System_Benchmark()
+    {
+        QFETCH(QString, typeName);
+
+        // Simulate one component that solves an equation system of the given size, with interface
+        // components of the opposite CQS type connected to all of its power ports
+        ComponentSystem* pSystem = mHopsanCore.createComponentSystem();
+        Component* pComp = mHopsanCore.createComponent(typeName.toStdString().c_str());
+        QVERIFY2(pComp, qPrintable("Could not create: "+typeName));
+        pSystem->addComponent(pComp);
+        const std::vector<Port*> ports = pComp->getPortPtrVector();
+        for (Port* pPort : ports)
+        {
+            if (pPort->getPortType() == PowerPortType)
+            {
+                HString domain = pPort->getNodeType();
+                domain.replace("Node", "");
+                const HString interfaceType = domain + ((pComp->getTypeCQS() == Component::CType) ? "InterfaceQ" : "InterfaceC");
+                Component* pInterface = mHopsanCore.createComponent(interfaceType);
+                QVERIFY2(pInterface, interfaceType.c_str());
+                pSystem->addComponent(pInterface);
+                QVERIFY(pSystem->connect(pPort, pInterface->getPort("P1")));
+            }
+        }
+
+        const double stopTime = 10.0;
+        pSystem->setDesiredTimestep(1e-4);
+        pSystem->setNumLogSamples(100);
+        QVERIFY2(pSystem->initialize(0, stopTime), qPrintable("Failed to initialize: "+typeName));
+        QBENCHMARK_ONCE
+        {
+            pSystem->simulate(stopTime);
+        }
+        pSystem->finalize();
+        QVERIFY2(pSystem->getTime() > 0, qPrintable("Nothing was simulated: "+typeName));
+
+        mHopsanCore.removeComponent(pSystem);
+    }
+
+    void Component_Equation_System_Benchmark_data()
+    {
+        // Row names give the size of the equation system solved by each component
+        QTest::addColumn<QString>("typeName");
+        QTest::newRow("2 equations") << "AeroPropeller";
+        QTest::newRow("3 equations") << "SignalPID";
+        QTest::newRow("5 equations") << "HydraulicPistonAckumulator";
+        QTest::newRow("6 equations") << "HydraulicMotorJload";
+        QTest::newRow("8 equations") << "HydraulicValve416";
+        QTest::newRow("13 equations") << "AeroAircraft6DOFSS";
+    }
+
+    void System_Save_Restore_State()
+    {
+        Port* pPort = mpSystemFromFile->getSubComponent("TestTank")->getPort("P1");
+        QVERIFY(mpSystemFromFile->initialize(0, 10.0));
+        mpSystemFromFile->simulate(5.0);
+
+        std::vector<char> state;
+        mpSystemFromFile->saveSimulationState(state);
+        QVERIFY2(!state.empty(), "No simulation state was saved");
+
+        mpSystemFromFile->simulate(10.0);
+        const std::vector<double> expected(pPort->getDataVectorPtr()->begin(), pPort->getDataVectorPtr()->end());
+        const double expectedTime = mpSystemFromFile->getTime();
+        const size_t expectedNumSamples = mpSystemFromFile->getNumActuallyLoggedSamples();
+
+        // Continuing from the restored state must give the same result as the uninterrupted simulation
+        QVERIFY2(mpSystemFromFile->restoreSimulationState(state), "Failed to restore simulation state");
+        QVERIFY(qAbs(mpSystemFromFile->getTime()-5.0) < 1e-9);
+        mpSystemFromFile->simulate(10.0);
+        QCOMPARE(mpSystemFromFile->getTime(), expectedTime);
+        QCOMPARE(mpSystemFromFile->getNumActuallyLoggedSamples(), expectedNumSamples);
+        for (size_t i=0; i<expected.size(); ++i)
+        {
+            QCOMPARE((*pPort->getDataVectorPtr())[i], expected[i]);
+        }
+
+        // A truncated state must be rejected
+        state.resize(state.size()/2);
+        QVERIFY2(!mpSystemFromFile->restoreSimulationState(state), "Truncated simulation state was restored");
+    }
+
+    void System_Simulate_Selective_Logging()
+    {
+        Port* pPort = mpSystemFromFile->getSubComponent("TestTank")->getPort("P1");
+        const int pressureId = pPort->getNodeDataIdFromName("Pressure");
+        const int flowId = pPort->getNodeDataIdFromName("Flow");
+        const int temperatureId = pPort->getNodeDataIdFromName("Temperature");
+        QVERIFY(pressureId >= 0 && flowId >= 0 && temperatureId >= 0);
+
+        pPort->setEnableVariableLogging(size_t(flowId), false);
+        pPort->setVariableLogDecimation(size_t(pressureId), 4);
+
+        QVERIFY(mpSystemFromFile->initialize(0, 10.0));
+        mpSystemFromFile->simulate(10.0);
+        QVERIFY2(mpSystemFromFile->getNumActuallyLoggedSamples() == 2048, "Failed to simulate system!");
+
+        QVERIFY2(pPort->getLogDataVariablePtr(size_t(flowId)) == nullptr, "Disabled variable was logged");
+        QVERIFY2(pPort->getLogDataDecimation(size_t(flowId)) == 0, "Disabled variable was logged");
+
+        const std::vector<double> *pPressure = pPort->getLogDataVariablePtr(size_t(pressureId));
+        QVERIFY2(pPressure != nullptr && pPressure->size() == 512, "Decimated variable has wrong log length");
+        QVERIFY2(pPort->getLogDataDecimation(size_t(pressureId)) == 4, "Decimated variable has wrong decimation");
+
+        const std::vector<double> *pTemperature = pPort->getLogDataVariablePtr(size_t(temperatureId));
+        QVERIFY2(pTemperature != nullptr && pTemperature->size() == 2048, "Default variable has wrong log length");
+        QVERIFY2(pPort->getLogDataDecimation(size_t(temperatureId)) == 1, "Default variable has wrong decimation");
+    }
+
     void Component_Set_Parameter()
     {
         QFETCH(QString, compName);
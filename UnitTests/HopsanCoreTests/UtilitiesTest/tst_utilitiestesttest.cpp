@@ -29,6 +29,10 @@
 #include "CoreUtilities/HopsanCoreMessageHandler.h"
 #include "CoreUtilities/StringUtilities.h"
 #include "CoreUtilities/MultiThreadingUtilities.h"
+#include "CoreUtilities/SignalAnalysis.h"
+
+#include <complex>
+#include <vector>
 
 using namespace hopsan;
 
@@ -222,6 +226,188 @@ private Q_SLOTS:
         QTest::newRow("7") << 8;
         QTest::newRow("8") << 9;
     }
+
+    void Fast_Fourier_Transform()
+    {
+        QFETCH(int, n);
+
+        std::vector< std::complex<double> > data(n), transform;
+        for (int i=0; i<n; ++i)
+        {
+            data[i] = std::complex<double>(std::sin(0.3*i*i+1.0), std::cos(0.7*i));
+        }
+        transform = data;
+        ComplexFFT fft(n);
+        fft.forward(transform);
+
+        // Compare with the direct evaluation of the discrete Fourier transform
+        double maxError = 0;
+        for (int k=0; k<n; ++k)
+        {
+            std::complex<double> sum(0,0);
+            for (int j=0; j<n; ++j)
+            {
+                const double angle = -2.0*M_PI*double((size_t(j)*size_t(k))%size_t(n))/double(n);
+                sum += data[j]*std::complex<double>(std::cos(angle), std::sin(angle));
+            }
+            maxError = std::max(maxError, std::abs(sum-transform[k]));
+        }
+        QVERIFY2(maxError < 1e-9*n, QString("Forward transform error %1").arg(maxError).toStdString().c_str());
+
+        fft.inverse(transform);
+        maxError = 0;
+        for (int i=0; i<n; ++i)
+        {
+            maxError = std::max(maxError, std::abs(transform[i]/double(n)-data[i]));
+        }
+        QVERIFY2(maxError < 1e-12, QString("Inverse transform error %1").arg(maxError).toStdString().c_str());
+
+        // The real transform must agree with the complex transform of the real part
+        std::vector<double> realData(n);
+        std::vector< std::complex<double> > complexData(n), realSpectrum;
+        for (int i=0; i<n; ++i)
+        {
+            realData[i] = data[i].real();
+            complexData[i] = data[i].real();
+        }
+        RealFFT realFFT;
+        realFFT.forward(realData, realSpectrum);
+        fft.forward(complexData);
+        QVERIFY(realSpectrum.size() == size_t(n/2+1));
+        maxError = 0;
+        for (size_t k=0; k<realSpectrum.size(); ++k)
+        {
+            maxError = std::max(maxError, std::abs(realSpectrum[k]-complexData[k]));
+        }
+        QVERIFY2(maxError < 1e-9*n, QString("Real transform error %1").arg(maxError).toStdString().c_str());
+    }
+
+    void Fast_Fourier_Transform_data()
+    {
+        QTest::addColumn<int>("n");
+
+        QTest::newRow("0") << 1;
+        QTest::newRow("1") << 2;
+        QTest::newRow("2") << 12;
+        QTest::newRow("3") << 60;
+        QTest::newRow("4") << 97;
+        QTest::newRow("5") << 256;
+        QTest::newRow("6") << 1000;
+        QTest::newRow("7") << 1031;
+        QTest::newRow("8") << 3*7*11*13;
+    }
+
+    void Spectrum_Analyzer()
+    {
+        // A sine with amplitude 2 at 125 Hz, and a constant offset that is removed
+        const double fs = 1000;
+        std::vector<double> signal(100000);
+        for (size_t i=0; i<signal.size(); ++i)
+        {
+            signal[i] = 3.0 + 2.0*std::sin(2.0*M_PI*125.0*double(i)/fs);
+        }
+
+        SpectrumAnalyzer analyzer;
+        analyzer.setSegmentLength(1000, 500);
+        analyzer.setRemoveMean(true);
+        std::vector<double> frequency, spectrum;
+        QVERIFY(analyzer.spectrum(signal, fs, SpectrumAnalyzer::PowerSpectralDensity, frequency, spectrum));
+        QVERIFY(spectrum.size() == 501 && frequency.size() == 501);
+        size_t peak = 0;
+        double power = 0;
+        for (size_t k=0; k<spectrum.size(); ++k)
+        {
+            power += spectrum[k]*(frequency[1]-frequency[0]);
+            if (spectrum[k] > spectrum[peak])
+            {
+                peak = k;
+            }
+        }
+        QCOMPARE(frequency[peak], 125.0);
+        QVERIFY2(std::fabs(power-2.0) < 1e-6, "The integral of the power spectral density must equal the signal variance");
+
+        QVERIFY(analyzer.spectrum(signal, fs, SpectrumAnalyzer::RmsSpectrum, frequency, spectrum));
+        QVERIFY2(std::fabs(spectrum[peak]-M_SQRT2) < 1e-9, "Wrong RMS value of the sine");
+
+        // A gain of 0.5 and a delay of three samples
+        std::vector<double> input(signal.size()), output(signal.size());
+        for (size_t i=0; i<input.size(); ++i)
+        {
+            input[i] = std::sin(0.1*double(i)) + std::sin(0.37*double(i)*double(i));
+            output[i] = (i >= 3) ? 0.5*input[i-3] : 0.0;
+        }
+        analyzer.setRemoveMean(false);
+        std::vector< std::complex<double> > transferFunction;
+        std::vector<double> gain, phase;
+        QVERIFY(analyzer.transferFunction(input, output, fs, frequency, transferFunction));
+        bodeFromTransferFunction(transferFunction, gain, phase);
+        QVERIFY(std::fabs(gain[100]-0.5) < 1e-2);
+        QVERIFY(std::fabs(phase[100]+2.0*M_PI*frequency[100]*3.0/fs) < 1e-2);
+
+        QVERIFY(!analyzer.spectrum(std::vector<double>(1), fs, SpectrumAnalyzer::PowerSpectrum, frequency, spectrum));
+        QVERIFY(!analyzer.getLastError().empty());
+    }
+
+    void Rms_And_Decimation()
+    {
+        std::vector<double> data;
+        for (int i=0; i<10; ++i)
+        {
+            data.push_back((i%2 == 0) ? 3.0 : -3.0);
+        }
+        QCOMPARE(rms(&data[0], data.size()), 3.0);
+
+        std::vector<double> movingValues;
+        movingRms(data, 4, movingValues);
+        QVERIFY(movingValues.size() == data.size());
+        QCOMPARE(movingValues.back(), 3.0);
+
+        std::vector<double> decimated;
+        decimate(data, 3, decimated);
+        QVERIFY(decimated.size() == 3);
+        QCOMPARE(decimated[0], 1.0);
+        QCOMPARE(decimated[1], -1.0);
+    }
+
+    void Fast_Fourier_Transform_Benchmark_data()
+    {
+        QTest::addColumn<bool>("welch");
+        QTest::newRow("fft") << false;
+        QTest::newRow("welch") << true;
+    }
+
+    void Fast_Fourier_Transform_Benchmark()
+    {
+        QFETCH(bool, welch);
+
+        // Ten million samples, 2^7*5^7, as a long logged simulation
+        const size_t n = 10000000;
+        std::vector<double> data(n);
+        for (size_t i=0; i<n; ++i)
+        {
+            data[i] = std::sin(0.001*double(i)) + 0.1*std::sin(0.9*double(i));
+        }
+
+        if (welch)
+        {
+            SpectrumAnalyzer analyzer;
+            analyzer.setSegmentLength(65536, 32768);
+            std::vector<double> frequency, psd;
+            QBENCHMARK
+            {
+                QVERIFY(analyzer.spectrum(data, 1e4, SpectrumAnalyzer::PowerSpectralDensity, frequency, psd));
+            }
+        }
+        else
+        {
+            RealFFT fft(n);
+            std::vector< std::complex<double> > spectrum(fft.spectrumSize());
+            QBENCHMARK
+            {
+                fft.forward(&data[0], &spectrum[0]);
+            }
+        }
+    }
 };
 QTEST_APPLESS_MAIN(UtilitiesTestTest)
 
@@ -0,0 +1,34 @@
+QT       += testlib
+QT       -= gui
+
+#Determine debug extension
+include( ../../Common.prf )
+
+TARGET = tst_remoteworkertest$${DEBUG_EXT}
+CONFIG   += console
+CONFIG   -= app_bundle
+DESTDIR = $${PWD}/../../bin
+
+TEMPLATE = app
+
+# The server and worker are run from the bin directory, with the default library in its install location
+DEFINES += REMOTE_BIN_DIR=\\\"$${PWD}/../../bin/\\\"
+DEFINES += TEST_DATA_ROOT=\\\"$${PWD}/../HopsanCoreTests/SimulationTest/\\\"
+
+#--------------------------------------------------------
+# Depend on the remote client and common libs
+INCLUDEPATH += $${PWD}/../../hopsanremote/libhopsanremoteclient/include
+INCLUDEPATH += $${PWD}/../../hopsanremote/libhopsanremotecommon/include
+LIBS += -L$${PWD}/../../lib -lhopsanremoteclient -lhopsanremotecommon
+#--------------------------------------------------------
+
+#--------------------------------------------------------
+# Set the ZeroMQ paths
+include($${PWD}/../../dependencies/zeromq.pri)
+include($${PWD}/../../dependencies/msgpack.pri)
+#--------------------------------------------------------
+
+LIBS += -pthread
+
+SOURCES += \
+    tst_remoteworkertest.cpp
@@ -0,0 +1,327 @@
+/*-----------------------------------------------------------------------------
+
+ Copyright 2017 Hopsan Group
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+
+ The full license is available in the file LICENSE.
+ For details about the 'Hopsan Group' or information about Authors and
+
+-----------------------------------------------------------------------------*/
+
+#include <QtTest>
+#include <string>
+#include <thread>
+#include <vector>
+#include "hopsanremoteclient/RemoteHopsanClient.h"
+#include "hopsanremotecommon/MessageUtilities.h"
+#include "hopsanremotecommon/ResultEncoding.h"
+#include "zmq.hpp"
+
+#ifndef TEST_DATA_ROOT
+#define TEST_DATA_ROOT "../UnitTests/HopsanCoreTests/SimulationTest/"
+#endif
+
+//! @brief The server base port used by the test, workers use the ports above it
+const int gServerPort = 47300;
+//! @brief The port of the fake worker that only supports the single message result request
+const int gLegacyWorkerPort = 47350;
+
+Q_DECLARE_METATYPE(ResultEncodingEnumT)
+
+//! @brief Answers result requests like a worker without chunked result transfer, until numRequests requests have been handled
+static void runLegacyWorker(zmq::context_t *pContext, const std::vector<ReplymsgResultsVariable> *pVariables, int numRequests)
+{
+    zmq::socket_t socket(*pContext, ZMQ_REP);
+    socket.bind(makeZMQAddress("127.0.0.1", gLegacyWorkerPort));
+    for (int r=0; r<numRequests; ++r)
+    {
+        zmq::message_t request;
+        if (!receiveWithTimeout(socket, 20000, request))
+        {
+            return;
+        }
+        size_t offset=0;
+        bool parseOK;
+        size_t id = getMessageId(request, offset, parseOK);
+        if (parseOK && (id == RequestResults))
+        {
+            sendMessage(socket, ReplyResults, *pVariables);
+        }
+        else
+        {
+            sendMessage(socket, NotAck, "Unhandled message id: "+std::to_string(id));
+        }
+    }
+}
+
+//! @brief Runs hopsanserver and its workers on loopback, the test acts as the client
+class RemoteWorkerTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryDir mDir;
+    QString mBinDir;
+    QProcess mServer;
+    QString mServerOutput;
+    zmq::context_t mContext;
+
+    //! @brief Copy a file, so that the server, worker and default library are in the install layout
+    static bool copyExecutable(const QString &rSource, const QString &rDestination)
+    {
+        return QFile::copy(rSource, rDestination) &&
+               QFile::setPermissions(rDestination, QFile::permissions(rSource));
+    }
+
+    QString readServerOutput()
+    {
+        mServerOutput += QString::fromLocal8Bit(mServer.readAll());
+        return mServerOutput;
+    }
+
+    //! @brief Wait until the server has the expected number of free slots, workers return them asynchronously
+    bool waitForFreeSlots(int numFreeSlots)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        while (timer.elapsed() < 20000)
+        {
+            RemoteHopsanClient client(mContext);
+            client.setShortReceiveTimeout(1000);
+            ServerStatusT status;
+            if (client.connectToServer("127.0.0.1:"+std::to_string(gServerPort)) &&
+                client.requestServerStatus(status) && (status.numFreeSlots == numFreeSlots))
+            {
+                client.disconnect();
+                return true;
+            }
+            client.disconnect();
+            QTest::qWait(100);
+        }
+        return false;
+    }
+
+    //! @brief Start the server with a number of worker slots, of which poolSize are kept as pooled workers
+    bool startServer(int numSlots, int poolSize)
+    {
+        mServer.setWorkingDirectory(mBinDir);
+        mServer.setProcessChannelMode(QProcess::MergedChannels);
+        mServer.start(mBinDir+"hopsanserver", QStringList() << "-p" << QString::number(gServerPort) << "-n" << QString::number(numSlots)
+                                                            << "--poolsize" << QString::number(poolSize));
+        return mServer.waitForStarted() && waitForFreeSlots(numSlots);
+    }
+
+    //! @brief Get a slot for the user, load the test model and check or change a parameter
+    void runClient(const std::string &rUserid, const std::string &rModel, const std::string &rExpectedValue,
+                   const std::string &rNewValue, int &rWorkerPort)
+    {
+        RemoteHopsanClient client(mContext);
+        QVERIFY(client.connectToServer("127.0.0.1:"+std::to_string(gServerPort)));
+        QVERIFY2(client.requestSlot(1, rWorkerPort, rUserid), client.getLastErrorMessage().c_str());
+        QVERIFY(client.connectToWorker(rWorkerPort));
+        QVERIFY2(client.sendModelMessage(rModel), client.getLastErrorMessage().c_str());
+
+        std::string value;
+        QVERIFY(client.sendGetParamMessage("TestConstant#y#Value", value));
+        QCOMPARE(value, rExpectedValue);
+        QVERIFY(client.sendSetParamMessage("TestConstant#y#Value", rNewValue));
+        QVERIFY(client.sendGetParamMessage("TestConstant#y#Value", value));
+        QCOMPARE(value, rNewValue);
+        client.disconnect();
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QVERIFY(mDir.isValid());
+#ifdef REMOTE_BIN_DIR
+        mBinDir = REMOTE_BIN_DIR;
+#else
+        // The server launches ./hopsanserverworker and the worker loads ../componentLibraries/defaultLibrary
+        QDir dir(mDir.path());
+        QVERIFY(dir.mkpath("bin"));
+        QVERIFY(dir.mkpath("componentLibraries/defaultLibrary"));
+        mBinDir = mDir.path()+"/bin/";
+        QVERIFY(copyExecutable(SERVER_EXECUTABLE, mBinDir+"hopsanserver"));
+        QVERIFY(copyExecutable(WORKER_EXECUTABLE, mBinDir+"hopsanserverworker"));
+        QVERIFY(QFile::copy(DEFAULT_LIBRARY_FILE, mDir.path()+"/componentLibraries/defaultLibrary/"+QFileInfo(DEFAULT_LIBRARY_FILE).fileName()));
+#endif
+    }
+
+    void cleanup()
+    {
+        if (mServer.state() != QProcess::NotRunning)
+        {
+            mServer.terminate();
+            if (!mServer.waitForFinished(40000))
+            {
+                mServer.kill();
+                mServer.waitForFinished();
+            }
+        }
+        mServerOutput.clear();
+    }
+
+    void Worker_Pool_Reuse()
+    {
+        QFile modelFile(TEST_DATA_ROOT "unittestmodel.hmf");
+        QVERIFY(modelFile.open(QFile::ReadOnly | QFile::Text));
+        const std::string model = modelFile.readAll().toStdString();
+
+        QVERIFY(startServer(2, 1));
+
+        // The first user changes a parameter, the worker then returns to the pool
+        int firstPort = -1;
+        runClient("first", model, "1", "5", firstPort);
+        if (QTest::currentTestFailed())
+        {
+            qDebug() << readServerOutput();
+            return;
+        }
+        QVERIFY2(waitForFreeSlots(2), qPrintable(readServerOutput()));
+
+        // Another user gets the same pooled worker, the cached model is reused with its original parameter value
+        int secondPort = -1;
+        runClient("second", model, "1", "3", secondPort);
+        if (QTest::currentTestFailed())
+        {
+            qDebug() << readServerOutput();
+            return;
+        }
+        QCOMPARE(secondPort, firstPort);
+        QVERIFY2(waitForFreeSlots(2), qPrintable(readServerOutput()));
+        QVERIFY2(readServerOutput().contains("Returning to worker pool"), qPrintable(mServerOutput));
+        QVERIFY2(mServerOutput.contains("Model was reused from cache"), qPrintable(mServerOutput));
+    }
+
+    void Chunked_Results_data()
+    {
+        QTest::addColumn<ResultEncodingEnumT>("encoding");
+        QTest::newRow("float64") << ResultFloat64;
+        QTest::newRow("float32") << ResultFloat32;
+        QTest::newRow("xorfloat64") << ResultXorFloat64;
+    }
+
+    void Chunked_Results()
+    {
+        QFETCH(ResultEncodingEnumT, encoding);
+
+        QFile modelFile(TEST_DATA_ROOT "unittestmodel.hmf");
+        QVERIFY(modelFile.open(QFile::ReadOnly | QFile::Text));
+        const std::string model = modelFile.readAll().toStdString();
+        QVERIFY(startServer(1, 0));
+
+        RemoteHopsanClient client(mContext);
+        int workerPort = -1;
+        QVERIFY(client.connectToServer("127.0.0.1:"+std::to_string(gServerPort)));
+        QVERIFY2(client.requestSlot(1, workerPort, "chunks"), client.getLastErrorMessage().c_str());
+        QVERIFY(client.connectToWorker(workerPort));
+        QVERIFY2(client.sendModelMessage(model), client.getLastErrorMessage().c_str());
+        double progress = 0;
+        QVERIFY2(client.blockingSimulation(-1, -1, -1, -1, -1, &progress), qPrintable(readServerOutput()));
+
+        // The reference is transferred in one chunk, without loss
+        const std::vector<std::string> filter = {"Time", "TestStep#out#Value", "TestGain#*"};
+        std::vector<ResultVariableT> reference;
+        QVERIFY2(client.requestSimulationResults(filter, 1, ResultFloat64, reference), client.getLastErrorMessage().c_str());
+        QVERIFY(reference.size() >= 3);
+        QCOMPARE(reference[0].name, std::string("Time"));
+        QCOMPARE(reference[0].data.size(), size_t(2048));
+        bool foundGainOutput = false;
+        for (const ResultVariableT &rVar : reference)
+        {
+            QVERIFY2(matchesVariableFilter(rVar.name, rVar.alias, filter), rVar.name.c_str());
+            QCOMPARE(rVar.data.size(), reference[0].data.size());
+            foundGainOutput = foundGainOutput || (rVar.name == "TestGain#out#Value");
+        }
+        QVERIFY(foundGainOutput);
+
+        // Small chunks end in the middle of variables, so each variable is assembled from several chunks
+        const int chunkSamples = 700;
+        client.setMaxResultChunkSamples(chunkSamples);
+        std::vector<ResultVariableT> chunked;
+        QVERIFY2(client.requestSimulationResults(filter, 1, encoding, chunked), client.getLastErrorMessage().c_str());
+        QCOMPARE(chunked.size(), reference.size());
+        for (size_t v=0; v<reference.size(); ++v)
+        {
+            QCOMPARE(chunked[v].name, reference[v].name);
+            QCOMPARE(chunked[v].data.size(), reference[v].data.size());
+            QVERIFY(chunked[v].data.size() > size_t(chunkSamples));
+            for (size_t i=0; i<reference[v].data.size(); ++i)
+            {
+                const double expected = (encoding == ResultFloat32) ? double(float(reference[v].data[i])) : reference[v].data[i];
+                QCOMPARE(chunked[v].data[i], expected);
+            }
+        }
+
+        // Decimation is applied before chunking
+        std::vector<ResultVariableT> decimated;
+        QVERIFY2(client.requestSimulationResults(filter, 3, encoding, decimated), client.getLastErrorMessage().c_str());
+        QCOMPARE(decimated.size(), reference.size());
+        for (size_t v=0; v<reference.size(); ++v)
+        {
+            QCOMPARE(decimated[v].data.size(), (reference[v].data.size()+2)/3);
+            QCOMPARE(decimated[v].data.back(), chunked[v].data[3*(decimated[v].data.size()-1)]);
+        }
+
+        // Requesting all results uses the lossless chunked transfer
+        std::vector<ResultVariableT> all;
+        QVERIFY2(client.requestSimulationResults(all), client.getLastErrorMessage().c_str());
+        QVERIFY(all.size() > reference.size());
+        client.disconnect();
+    }
+
+    void Results_From_Worker_Without_Chunks()
+    {
+        std::vector<ReplymsgResultsVariable> variables(2);
+        variables[0].name = "Time";
+        variables[0].data = {0.0, 0.5, 1.0};
+        variables[1].name = "Gain#out#Value";
+        variables[1].alias = "gain_out";
+        variables[1].data = {1.0, -2.0, 3.0};
+
+        // The chunk request is rejected, then all results are requested in one message
+        // (the worker thread must be joined before any check can return from the test)
+        std::thread worker(runLegacyWorker, &mContext, &variables, 3);
+        RemoteHopsanClient client(mContext);
+        const bool connected = client.connectToServer("127.0.0.1:"+std::to_string(gServerPort)) && client.connectToWorker(gLegacyWorkerPort);
+        std::vector<ResultVariableT> results;
+        const bool gotResults = connected && client.requestSimulationResults(results);
+        const std::string error = client.getLastErrorMessage();
+
+        // There is no fallback when specific variables or an encoding are requested, the chunk request error is kept
+        std::vector<ResultVariableT> filtered;
+        const bool gotFiltered = connected && client.requestSimulationResults({"gain_out"}, 1, ResultFloat64, filtered);
+        const std::string filteredError = client.getLastErrorMessage();
+        client.disconnect();
+        worker.join();
+
+        QVERIFY(connected);
+        QVERIFY2(gotResults, error.c_str());
+        QCOMPARE(results.size(), variables.size());
+        for (size_t v=0; v<variables.size(); ++v)
+        {
+            QCOMPARE(results[v].name, variables[v].name);
+            QCOMPARE(results[v].alias, variables[v].alias);
+            QCOMPARE(results[v].data, variables[v].data);
+        }
+        QVERIFY(!gotFiltered);
+        QVERIFY2(filteredError.find("Unhandled message id") != std::string::npos, filteredError.c_str());
+    }
+};
+
+QTEST_GUILESS_MAIN(RemoteWorkerTest)
+
+#include "tst_remoteworkertest.moc"
@@ -0,0 +1,20 @@
+QT       += testlib
+QT       -= gui
+
+#Determine debug extension
+include( ../../Common.prf )
+
+TARGET = tst_resultencodingtest$${DEBUG_EXT}
+CONFIG   += console
+CONFIG   -= app_bundle
+DESTDIR = $${PWD}/../../bin
+
+TEMPLATE = app
+
+# The encoding does not depend on zmq or msgpack, so it is compiled directly into the test
+INCLUDEPATH += $${PWD}/../../hopsanremote/libhopsanremotecommon/include/
+
+SOURCES += \
+    tst_resultencodingtest.cpp \
+    $${PWD}/../../hopsanremote/libhopsanremotecommon/src/ResultEncoding.cpp
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
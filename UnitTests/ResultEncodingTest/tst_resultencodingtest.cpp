@@ -0,0 +1,175 @@
+/*-----------------------------------------------------------------------------
+
+ Copyright 2017 Hopsan Group
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+
+ The full license is available in the file LICENSE.
+ For details about the 'Hopsan Group' or information about Authors and
+ Contributors see the HOPSANGROUP and AUTHORS files that are located in
+ the Hopsan source code root directory.
+
+-----------------------------------------------------------------------------*/
+
+#include <QtTest>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+#include "hopsanremotecommon/ResultEncoding.h"
+
+Q_DECLARE_METATYPE(std::vector<double>)
+
+class ResultEncodingTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    //! @brief Compare the bit patterns, so that nan and the sign of zero are checked as well
+    static bool sameBits(const double a, const double b)
+    {
+        return memcmp(&a, &b, sizeof(double)) == 0;
+    }
+
+private Q_SLOTS:
+    void Encode_Decode_Round_Trip()
+    {
+        QFETCH(std::vector<double>, data);
+        QFETCH(int, encoding);
+
+        std::string encoded;
+        encodeResultData(data.data(), data.size(), 1, encoding, encoded);
+        std::vector<double> decoded;
+        QVERIFY(decodeResultData(encoded, data.size(), encoding, decoded));
+        QCOMPARE(decoded.size(), data.size());
+        for (size_t i=0; i<data.size(); ++i)
+        {
+            if (encoding == ResultFloat32)
+            {
+                const double expected = double(float(data[i]));
+                QVERIFY2(sameBits(decoded[i], expected) || (std::isnan(decoded[i]) && std::isnan(expected)),
+                         QString("Sample %1: %2 != %3").arg(i).arg(decoded[i]).arg(expected).toLatin1());
+            }
+            else
+            {
+                QVERIFY2(sameBits(decoded[i], data[i]), QString("Sample %1: %2 != %3").arg(i).arg(decoded[i]).arg(data[i]).toLatin1());
+            }
+        }
+
+        // Decoding appends to existing data
+        decoded.assign(1, 42.0);
+        QVERIFY(decodeResultData(encoded, data.size(), encoding, decoded));
+        QCOMPARE(decoded.size(), data.size()+1);
+        QCOMPARE(decoded.front(), 42.0);
+
+        // Truncated data or the wrong number of samples must be rejected
+        if (!encoded.empty())
+        {
+            std::vector<double> rejected;
+            QVERIFY(!decodeResultData(encoded.substr(0, encoded.size()-1), data.size(), encoding, rejected));
+            QVERIFY(!decodeResultData(encoded, data.size()+1, encoding, rejected));
+        }
+    }
+
+    void Encode_Decode_Round_Trip_data()
+    {
+        QTest::addColumn< std::vector<double> >("data");
+        QTest::addColumn<int>("encoding");
+
+        std::vector<double> smooth, constant, special;
+        for (int i=0; i<1000; ++i)
+        {
+            smooth.push_back(std::sin(0.01*i)*1e5 + 1e-3*i);
+            constant.push_back(101325.0);
+        }
+        special.push_back(0.0);
+        special.push_back(-0.0);
+        special.push_back(std::numeric_limits<double>::infinity());
+        special.push_back(-std::numeric_limits<double>::infinity());
+        special.push_back(std::numeric_limits<double>::quiet_NaN());
+        special.push_back(std::numeric_limits<double>::denorm_min());
+        special.push_back(std::numeric_limits<double>::max());
+        special.push_back(-1.0);
+        special.push_back(1.0);
+
+        const int encodings[] = {ResultFloat64, ResultFloat32, ResultXorFloat64};
+        const char *names[] = {"float64", "float32", "xor"};
+        for (int e=0; e<3; ++e)
+        {
+            QTest::newRow(QString("empty_%1").arg(names[e]).toLatin1().constData()) << std::vector<double>() << encodings[e];
+            QTest::newRow(QString("smooth_%1").arg(names[e]).toLatin1().constData()) << smooth << encodings[e];
+            QTest::newRow(QString("constant_%1").arg(names[e]).toLatin1().constData()) << constant << encodings[e];
+            QTest::newRow(QString("special_%1").arg(names[e]).toLatin1().constData()) << special << encodings[e];
+        }
+    }
+
+    void Encoded_Size()
+    {
+        std::vector<double> constant(1000, 101325.0);
+        std::string raw, single, xored;
+        encodeResultData(constant.data(), constant.size(), 1, ResultFloat64, raw);
+        encodeResultData(constant.data(), constant.size(), 1, ResultFloat32, single);
+        encodeResultData(constant.data(), constant.size(), 1, ResultXorFloat64, xored);
+        QCOMPARE(raw.size(), constant.size()*sizeof(double));
+        QCOMPARE(single.size(), constant.size()*sizeof(float));
+        // The first sample is stored in full, the rest are identical to the previous one and only need the header byte
+        QVERIFY(xored.size() <= sizeof(double)+constant.size());
+    }
+
+    void Encode_With_Stride()
+    {
+        std::vector<double> data;
+        for (int i=0; i<30; ++i)
+        {
+            data.push_back(0.5*i);
+        }
+        const int encodings[] = {ResultFloat64, ResultFloat32, ResultXorFloat64};
+        for (int encoding : encodings)
+        {
+            std::string encoded;
+            encodeResultData(data.data(), 10, 3, encoding, encoded);
+            std::vector<double> decoded;
+            QVERIFY(decodeResultData(encoded, 10, encoding, decoded));
+            QCOMPARE(decoded.size(), size_t(10));
+            for (size_t i=0; i<decoded.size(); ++i)
+            {
+                QCOMPARE(decoded[i], data[3*i]);
+            }
+        }
+    }
+
+    void Unknown_Encoding()
+    {
+        QVERIFY(!isValidResultEncoding(-1));
+        QVERIFY(!isValidResultEncoding(3));
+        std::vector<double> decoded;
+        QVERIFY(!decodeResultData(std::string(8, '\0'), 1, 3, decoded));
+    }
+
+    void Variable_Filter()
+    {
+        std::vector<std::string> filter;
+        QVERIFY(matchesVariableFilter("Gain#out#Value", "", filter));
+        filter.push_back("Gain#*");
+        filter.push_back("pressure");
+        QVERIFY(matchesVariableFilter("Gain#out#Value", "", filter));
+        QVERIFY(matchesVariableFilter("Volume#P1#Pressure", "pressure", filter));
+        QVERIFY(!matchesVariableFilter("Volume#P1#Flow", "flow", filter));
+    }
+};
+
+QTEST_APPLESS_MAIN(ResultEncodingTest)
+
+#include "tst_resultencodingtest.moc"
@@ -1,3 +1,9 @@
 TEMPLATE = subdirs
 
-SUBDIRS = HopsanCoreTests SymHopTest GeneratorTest DefaultLibraryXMLTest hopsanclitest
+SUBDIRS = HopsanCoreTests SymHopTest ResultEncodingTest GeneratorTest DefaultLibraryXMLTest hopsanclitest
+
+# The remote worker test needs the HopsanRemote parts, that are only built with ZeroMQ
+include($${PWD}/../dependencies/zeromq-check.pri)
+have_zeromq():!win32 {
+  SUBDIRS += RemoteWorkerTest
+}
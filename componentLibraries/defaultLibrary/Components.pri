@@ -19,6 +19,7 @@ HEADERS +=  \
  $${PWD}/Connectivity/SignalOutputInterface.hpp \ 
  $${PWD}/Connectivity/FMIWrapper.hpp \
  $${PWD}/Connectivity/FMIWrapperQ.hpp \
+ $${PWD}/Connectivity/FMIValueBatch.hpp \
  $${PWD}/Electric/Controllers&Switches/Controllers&Switches.h \ 
  $${PWD}/Electric/Controllers&Switches/ElectricIcontroller.hpp \ 
  $${PWD}/Electric/Controllers&Switches/ElectricPWMdceq.hpp \ 
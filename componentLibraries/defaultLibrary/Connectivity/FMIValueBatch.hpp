@@ -0,0 +1,90 @@
+#ifndef FMIVALUEBATCH_HPP
+#define FMIVALUEBATCH_HPP
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+//!
+//! @file FMIValueBatch.hpp
+//! @brief Contiguous value reference and value arrays for batched FMU get/set calls, used by the FMI wrapper components
+//!
+
+namespace hopsan {
+
+//! @brief Holds the value references of one FMI data type together with the Hopsan variables they are connected to
+//! @details The arrays are built once, at initialization, so that all variables of one type can be transferred
+//! with a single get or set call per time step, instead of one call per variable.
+//! @tparam VR The FMI value reference type
+//! @tparam T The FMI value type
+template<typename VR, typename T>
+class FMIValueBatch
+{
+public:
+    //! @brief Build the arrays from a map (or multimap) of value references and pointers to Hopsan variables
+    template<typename MapT>
+    void assign(const MapT &rVariables)
+    {
+        mValueRefs.clear();
+        mpVariables.clear();
+        for(typename MapT::const_iterator it = rVariables.begin(); it != rVariables.end(); ++it) {
+            mValueRefs.push_back(it->first);
+            mpVariables.push_back(it->second);
+        }
+        mpValues.reset(new T[mValueRefs.size()]());
+    }
+
+    void clear()
+    {
+        mValueRefs.clear();
+        mpVariables.clear();
+        mpValues.reset();
+    }
+
+    inline bool empty() const {return mValueRefs.empty();}
+    inline size_t size() const {return mValueRefs.size();}
+    inline const VR *valueRefs() const {return mValueRefs.data();}
+    inline T *values() {return mpValues.get();}
+
+    //! @brief Copy the Hopsan variables into the value array, using a plain type conversion
+    inline void readVariables()
+    {
+        for(size_t i=0; i<mpVariables.size(); ++i) {
+            mpValues[i] = T(*mpVariables[i]);
+        }
+    }
+
+    //! @brief Copy the Hopsan variables into the value array, rounded to the nearest integer
+    inline void readRoundedVariables()
+    {
+        for(size_t i=0; i<mpVariables.size(); ++i) {
+            mpValues[i] = T(lround(*mpVariables[i]));
+        }
+    }
+
+    //! @brief Copy the Hopsan variables into the value array, as booleans (true if > 0.5)
+    inline void readBooleanVariables()
+    {
+        for(size_t i=0; i<mpVariables.size(); ++i) {
+            mpValues[i] = T((*mpVariables[i]) > 0.5);
+        }
+    }
+
+    //! @brief Copy the value array to the Hopsan variables
+    inline void writeVariables() const
+    {
+        for(size_t i=0; i<mpVariables.size(); ++i) {
+            (*mpVariables[i]) = double(mpValues[i]);
+        }
+    }
+
+private:
+    std::vector<VR> mValueRefs;
+    std::vector<double*> mpVariables;
+    //! @note Not a std::vector, since std::vector<bool> (fmi3Boolean) does not provide contiguous storage
+    std::unique_ptr<T[]> mpValues;
+};
+
+}
+
+#endif // FMIVALUEBATCH_HPP
@@ -16,6 +16,7 @@
 
 #ifdef USEFMI4C
 #include "fmi4c.h"
+#include "FMIValueBatch.hpp"
 #include <cstdarg>
 #endif
 
@@ -220,6 +221,23 @@ private:
     std::map<fmi3ValueReference,int> mUInt16Parameters;
     std::map<fmi3ValueReference,int> mUInt8Parameters;
 
+    //Contiguous value reference and value arrays for batched transfers, built in initialize()
+    FMIValueBatch<fmi3ValueReference,double> mRealInputBatch, mRealOutputBatch;
+    FMIValueBatch<fmi3ValueReference,int> mIntInputBatch, mIntOutputBatch;
+    FMIValueBatch<fmi3ValueReference,fmi1Boolean> mFmi1BoolInputBatch, mFmi1BoolOutputBatch;
+    FMIValueBatch<fmi3ValueReference,fmi2Boolean> mFmi2BoolInputBatch, mFmi2BoolOutputBatch;
+    FMIValueBatch<fmi3ValueReference,fmi3Float64> mFloat64InputBatch, mFloat64OutputBatch;
+    FMIValueBatch<fmi3ValueReference,fmi3Float32> mFloat32InputBatch, mFloat32OutputBatch;
+    FMIValueBatch<fmi3ValueReference,fmi3Int64> mInt64InputBatch, mInt64OutputBatch;
+    FMIValueBatch<fmi3ValueReference,fmi3Int32> mInt32InputBatch, mInt32OutputBatch;
+    FMIValueBatch<fmi3ValueReference,fmi3Int16> mInt16InputBatch, mInt16OutputBatch;
+    FMIValueBatch<fmi3ValueReference,fmi3Int8> mInt8InputBatch, mInt8OutputBatch;
+    FMIValueBatch<fmi3ValueReference,fmi3UInt64> mUInt64InputBatch, mUInt64OutputBatch;
+    FMIValueBatch<fmi3ValueReference,fmi3UInt32> mUInt32InputBatch, mUInt32OutputBatch;
+    FMIValueBatch<fmi3ValueReference,fmi3UInt16> mUInt16InputBatch, mUInt16OutputBatch;
+    FMIValueBatch<fmi3ValueReference,fmi3UInt8> mUInt8InputBatch, mUInt8OutputBatch;
+    FMIValueBatch<fmi3ValueReference,fmi3Boolean> mBooleanInputBatch, mBooleanOutputBatch;
+
     std::vector<Port*> mPorts;
 
     fmiVersion_t mFmiVersion;
@@ -847,6 +865,8 @@ public:
                 return;
             }
             addInfoMessage("Initializing FMU 1.0 import");
+            buildValueBatches();
+
             //Loop through output variables and assign start values
             for(int i=0; i<fmi1_getNumberOfVariables(fmu); ++i) {
                 fmi1VariableHandle *var = fmi1_getVariableByIndex(fmu,i);
@@ -912,6 +932,8 @@ public:
             }
         
             addInfoMessage("Initializing FMU 2.0 import");
+            buildValueBatches();
+
             //Loop through output variables and assign start values
             for(int i=0; i<fmi2_getNumberOfVariables(fmu); ++i) {
                  fmi2VariableHandle *var = fmi2_getVariableByIndex(fmu,i);
@@ -990,6 +1012,8 @@ public:
             }
         
             addInfoMessage("Initializing FMU 3.0 import");
+            buildValueBatches();
+
             //Loop through output variables and assign start values
             for(int i=0; i<fmi3_getNumberOfVariables(fmu); ++i) {
                 fmi3VariableHandle *var = fmi3_getVariableByIndex(fmu,i);
@@ -1151,211 +1175,193 @@ public:
             if(NULL == fmu) {
                 return;
             }
-            
+
             fmi1Status status;
-            
-           //Forward inputs
-            std::map<fmi1ValueReference,double*>::iterator it;
-            for(it = mRealInputs.begin(); it != mRealInputs.end(); it++) {
-                status = fmi1_setReal(fmu, &it->first, 1, it->second);
+
+            //Forward inputs
+            if(!mRealInputBatch.empty()) {
+                mRealInputBatch.readVariables();
+                status = fmi1_setReal(fmu, mRealInputBatch.valueRefs(), mRealInputBatch.size(), mRealInputBatch.values());
             }
-            for(it = mIntInputs.begin(); it != mIntInputs.end(); it++) {
-                int value = (int)lround(*it->second);
-                status = fmi1_setInteger(fmu, &it->first, 1, &value);
+            if(!mIntInputBatch.empty()) {
+                mIntInputBatch.readRoundedVariables();
+                status = fmi1_setInteger(fmu, mIntInputBatch.valueRefs(), mIntInputBatch.size(), mIntInputBatch.values());
             }
-            for(it = mBoolInputs.begin(); it != mBoolInputs.end(); it++) {
-                fmi1Boolean value = fmi1Boolean(*it->second);
-                status = fmi1_setBoolean(fmu, &it->first, 1, &value);
+            if(!mFmi1BoolInputBatch.empty()) {
+                mFmi1BoolInputBatch.readVariables();
+                status = fmi1_setBoolean(fmu, mFmi1BoolInputBatch.valueRefs(), mFmi1BoolInputBatch.size(), mFmi1BoolInputBatch.values());
+            }
+
+            //Take step
+            status = fmi1_doStep(fmu, mTime-mTimestep, mTimestep, fmi1True);
+            if (status != fmi1OK) {
+                stopSimulation("fmi1DoStep() failed, status = "+to_hstring(status));
+                return;
+            }
+
+            //Forward outputs
+            if(!mRealOutputBatch.empty()) {
+                status = fmi1_getReal(fmu, mRealOutputBatch.valueRefs(), mRealOutputBatch.size(), mRealOutputBatch.values());
+                mRealOutputBatch.writeVariables();
+            }
+            if(!mIntOutputBatch.empty()) {
+                status = fmi1_getInteger(fmu, mIntOutputBatch.valueRefs(), mIntOutputBatch.size(), mIntOutputBatch.values());
+                mIntOutputBatch.writeVariables();
+            }
+            if(!mFmi1BoolOutputBatch.empty()) {
+                status = fmi1_getBoolean(fmu, mFmi1BoolOutputBatch.valueRefs(), mFmi1BoolOutputBatch.size(), mFmi1BoolOutputBatch.values());
+                mFmi1BoolOutputBatch.writeVariables();
             }
-     
-             //Take step
-             status = fmi1_doStep(fmu, mTime-mTimestep, mTimestep, fmi1True);
-             if (status != fmi1OK) {
-                 stopSimulation("fmi1DoStep() failed, status = "+to_hstring(status));
-                 return;
-             }
-     
-             //Forward outputs
-             for(it = mRealOutputs.begin(); it != mRealOutputs.end(); it++) {
-                 status = fmi1_getReal(fmu, &it->first, 1, it->second);
-             }
-             for(it = mIntOutputs.begin(); it != mIntOutputs.end(); it++) {
-                 int temp;
-                 status = fmi1_getInteger(fmu, &it->first, 1, &temp);
-                 (*it->second) = temp;
-             }
-             for(it = mBoolOutputs.begin(); it != mBoolOutputs.end(); it++) {
-                 fmi1Boolean temp;
-                 status = fmi1_getBoolean(fmu, &it->first, 1, &temp);
-                 (*it->second) = temp;
-             }
         }
         else if(mFmiVersion == fmiVersion2) {
             if(NULL == fmu) {
                 return;
             }
-            
+
             fmi2Status status;
-            
+
             //Forward inputs
-            std::map<fmi2ValueReference,double*>::iterator it;
-            for(it = mRealInputs.begin(); it != mRealInputs.end(); it++) {
-                status = fmi2_setReal(fmu, &it->first, 1, it->second);
-            }
-            for(it = mIntInputs.begin(); it != mIntInputs.end(); it++) {
-                int value = (int)lround(*it->second);
-                status = fmi2_setInteger(fmu, &it->first, 1, &value);
-            }
-            for(it = mBoolInputs.begin(); it != mBoolInputs.end(); it++) {
-                int value = int(*it->second);
-                status = fmi2_setBoolean(fmu, &it->first, 1, &value);
-            }
-     
-             //Take step
-             status = fmi2_doStep(fmu, mTime-mTimestep, mTimestep, fmi3True);
-             if (status != fmi2OK) {
-                 stopSimulation("fmi2DoStep() failed, status = "+to_hstring(status));
-                 return;
-             }
-     
-             //Forward outputs
-             for(it = mRealOutputs.begin(); it != mRealOutputs.end(); it++) {
-                 status = fmi2_getReal(fmu, &it->first, 1, it->second);
-             }
-             for(it = mIntOutputs.begin(); it != mIntOutputs.end(); it++) {
-                 int temp;
-                 status = fmi2_getInteger(fmu, &it->first, 1, &temp);
-                 (*it->second) = temp;
-             }
-             for(it = mBoolOutputs.begin(); it != mBoolOutputs.end(); it++) {
-                 int temp;
-                 status = fmi2_getBoolean(fmu, &it->first, 1, &temp);
-                 (*it->second) = temp;
-             }
+            if(!mRealInputBatch.empty()) {
+                mRealInputBatch.readVariables();
+                status = fmi2_setReal(fmu, mRealInputBatch.valueRefs(), mRealInputBatch.size(), mRealInputBatch.values());
+            }
+            if(!mIntInputBatch.empty()) {
+                mIntInputBatch.readRoundedVariables();
+                status = fmi2_setInteger(fmu, mIntInputBatch.valueRefs(), mIntInputBatch.size(), mIntInputBatch.values());
+            }
+            if(!mFmi2BoolInputBatch.empty()) {
+                mFmi2BoolInputBatch.readVariables();
+                status = fmi2_setBoolean(fmu, mFmi2BoolInputBatch.valueRefs(), mFmi2BoolInputBatch.size(), mFmi2BoolInputBatch.values());
+            }
+
+            //Take step
+            status = fmi2_doStep(fmu, mTime-mTimestep, mTimestep, fmi3True);
+            if (status != fmi2OK) {
+                stopSimulation("fmi2DoStep() failed, status = "+to_hstring(status));
+                return;
+            }
+
+            //Forward outputs
+            if(!mRealOutputBatch.empty()) {
+                status = fmi2_getReal(fmu, mRealOutputBatch.valueRefs(), mRealOutputBatch.size(), mRealOutputBatch.values());
+                mRealOutputBatch.writeVariables();
+            }
+            if(!mIntOutputBatch.empty()) {
+                status = fmi2_getInteger(fmu, mIntOutputBatch.valueRefs(), mIntOutputBatch.size(), mIntOutputBatch.values());
+                mIntOutputBatch.writeVariables();
+            }
+            if(!mFmi2BoolOutputBatch.empty()) {
+                status = fmi2_getBoolean(fmu, mFmi2BoolOutputBatch.valueRefs(), mFmi2BoolOutputBatch.size(), mFmi2BoolOutputBatch.values());
+                mFmi2BoolOutputBatch.writeVariables();
+            }
         }
         else { //FMI 3
             if(NULL == fmu) {
                 return;
             }
             fmi3Status status;
-            
+
             //Forward inputs
-            std::map<fmi3ValueReference,double*>::iterator itr;
-            for(itr = mFloat64Inputs.begin(); itr != mFloat64Inputs.end(); itr++) {
-                fmi3Float64 value = (fmi3Float64)(*itr->second);
-                status = fmi3_setFloat64(fmu, &itr->first, 1, &value, 1);
-            }
-            for(itr = mFloat32Inputs.begin(); itr != mFloat32Inputs.end(); itr++) {
-                fmi3Float32 value = (fmi3Float32)(*itr->second);
-                status = fmi3_setFloat32(fmu, &itr->first, 1, &value, 1);
-            }
-            std::map<fmi3ValueReference,double*>::iterator itb;
-            for(itb = mBoolInputs.begin(); itb != mBoolInputs.end(); ++itb) {
-                bool value = ((*itb->second) > 0.5);
-                status = fmi3_setBoolean(fmu, &itb->first, 1, &value, 1);
-            }
-            std::map<fmi3ValueReference,double*>::iterator iti;
-            for(iti = mInt64Inputs.begin(); iti != mInt64Inputs.end(); ++iti) {
-                fmi3Int64 value = (fmi3Int64)lround(*iti->second);
-                status = fmi3_setInt64(fmu, &iti->first, 1, &value, 1);
-            }
-            for(iti = mInt32Inputs.begin(); iti != mInt32Inputs.end(); ++iti) {
-                fmi3Int32 value = (fmi3Int32)lround(*iti->second);
-                status = fmi3_setInt32(fmu, &iti->first, 1, &value, 1);
-            }
-            for(iti = mInt16Inputs.begin(); iti != mInt16Inputs.end(); ++iti) {
-                fmi3Int16 value = (fmi3Int16)lround(*iti->second);
-                status = fmi3_setInt16(fmu, &iti->first, 1, &value, 1);
-            }
-            for(iti = mInt8Inputs.begin(); iti != mInt8Inputs.end(); ++iti) {
-                fmi3Int8 value = (fmi3Int8)lround(*iti->second);
-                status = fmi3_setInt8(fmu, &iti->first, 1, &value, 1);
-            }
-            for(iti = mUInt64Inputs.begin(); iti != mUInt64Inputs.end(); ++iti) {
-                fmi3UInt64 value = (fmi3UInt64)lround(*iti->second);
-                status = fmi3_setUInt64(fmu, &iti->first, 1, &value, 1);
-            }
-            for(iti = mUInt32Inputs.begin(); iti != mUInt32Inputs.end(); ++iti) {
-                fmi3UInt32 value = (fmi3UInt32)lround(*iti->second);
-                status = fmi3_setUInt32(fmu, &iti->first, 1, &value, 1);
-            }
-            for(iti = mUInt16Inputs.begin(); iti != mUInt16Inputs.end(); ++iti) {
-                fmi3UInt16 value = (fmi3UInt16)lround(*iti->second);
-                status = fmi3_setUInt16(fmu, &iti->first, 1, &value, 1);
-            }
-            for(iti = mUInt8Inputs.begin(); iti != mUInt8Inputs.end(); ++iti) {
-                fmi3UInt8 value = (fmi3UInt8)lround(*iti->second);
-                status = fmi3_setUInt8(fmu, &iti->first, 1, &value, 1);
-            }
-
-     
-             //Take step
-             bool eventEncountered, terminateSimulation, earlyReturn;
-             double lastT;
-             status = fmi3_doStep(fmu, mTime, mTimestep, fmi3True, &eventEncountered, &terminateSimulation, &earlyReturn, &lastT);
-             if (status != fmi3OK) {
-                 stopSimulation("fmi3DoStep() failed, status = "+to_hstring(status));
-                 return;
-             }
-     
-             //Forward outputs
-             std::map<fmi3ValueReference,double*>::iterator it;
-             for(it = mFloat64Outputs.begin(); it != mFloat64Outputs.end(); it++) {
-                 fmi3Float64 value;
-                 status = fmi3_getFloat64(fmu, &it->first, 1, &value, 1);
-                 (*it->second) = (double)value;
-             }
-             for(it = mFloat32Outputs.begin(); it != mFloat32Outputs.end(); it++) {
-                 fmi3Float32 value;
-                 status = fmi3_getFloat32(fmu, &it->first, 1, &value, 1);
-                 (*it->second) = (double)value;
-             }
-             for(it = mInt64Outputs.begin(); it != mInt64Outputs.end(); it++) {
-                 fmi3Int64 value;
-                 status = fmi3_getInt64(fmu, &it->first, 1, &value, 1);
-                 (*it->second) = (double)value;
-             }
-             for(it = mInt32Outputs.begin(); it != mInt32Outputs.end(); it++) {
-                 fmi3Int32 value;
-                 status = fmi3_getInt32(fmu, &it->first, 1, &value, 1);
-                 (*it->second) = (double)value;
-             }
-             for(it = mInt16Outputs.begin(); it != mInt16Outputs.end(); it++) {
-                 fmi3Int16 value;
-                 status = fmi3_getInt16(fmu, &it->first, 1, &value, 1);
-                 (*it->second) = (double)value;
-             }
-             for(it = mInt8Outputs.begin(); it != mInt8Outputs.end(); it++) {
-                 fmi3Int8 value;
-                 status = fmi3_getInt8(fmu, &it->first, 1, &value, 1);
-                 (*it->second) = (double)value;
-             }
-             for(it = mUInt64Outputs.begin(); it != mUInt64Outputs.end(); it++) {
-                 fmi3UInt64 value;
-                 status = fmi3_getUInt64(fmu, &it->first, 1, &value, 1);
-                 (*it->second) = (double)value;
-             }
-             for(it = mUInt32Outputs.begin(); it != mUInt32Outputs.end(); it++) {
-                 fmi3UInt32 value;
-                 status = fmi3_getUInt32(fmu, &it->first, 1, &value, 1);
-                 (*it->second) = (double)value;
-             }
-             for(it = mUInt16Outputs.begin(); it != mUInt16Outputs.end(); it++) {
-                 fmi3UInt16 value;
-                 status = fmi3_getUInt16(fmu, &it->first, 1, &value, 1);
-                 (*it->second) = (double)value;
-             }
-             for(it = mUInt8Outputs.begin(); it != mUInt8Outputs.end(); it++) {
-                 fmi3UInt8 value;
-                 status = fmi3_getUInt8(fmu, &it->first, 1, &value, 1);
-                 (*it->second) = (double)value;
-             }
-             for(it = mBoolOutputs.begin(); it != mBoolOutputs.end(); it++) {
-                 bool temp;
-                 status = fmi3_getBoolean(fmu, &it->first, 1, &temp, 1);
-                 (*it->second) = temp;
-             }
-         }
+            if(!mFloat64InputBatch.empty()) {
+                mFloat64InputBatch.readVariables();
+                status = fmi3_setFloat64(fmu, mFloat64InputBatch.valueRefs(), mFloat64InputBatch.size(), mFloat64InputBatch.values(), mFloat64InputBatch.size());
+            }
+            if(!mFloat32InputBatch.empty()) {
+                mFloat32InputBatch.readVariables();
+                status = fmi3_setFloat32(fmu, mFloat32InputBatch.valueRefs(), mFloat32InputBatch.size(), mFloat32InputBatch.values(), mFloat32InputBatch.size());
+            }
+            if(!mInt64InputBatch.empty()) {
+                mInt64InputBatch.readRoundedVariables();
+                status = fmi3_setInt64(fmu, mInt64InputBatch.valueRefs(), mInt64InputBatch.size(), mInt64InputBatch.values(), mInt64InputBatch.size());
+            }
+            if(!mInt32InputBatch.empty()) {
+                mInt32InputBatch.readRoundedVariables();
+                status = fmi3_setInt32(fmu, mInt32InputBatch.valueRefs(), mInt32InputBatch.size(), mInt32InputBatch.values(), mInt32InputBatch.size());
+            }
+            if(!mInt16InputBatch.empty()) {
+                mInt16InputBatch.readRoundedVariables();
+                status = fmi3_setInt16(fmu, mInt16InputBatch.valueRefs(), mInt16InputBatch.size(), mInt16InputBatch.values(), mInt16InputBatch.size());
+            }
+            if(!mInt8InputBatch.empty()) {
+                mInt8InputBatch.readRoundedVariables();
+                status = fmi3_setInt8(fmu, mInt8InputBatch.valueRefs(), mInt8InputBatch.size(), mInt8InputBatch.values(), mInt8InputBatch.size());
+            }
+            if(!mUInt64InputBatch.empty()) {
+                mUInt64InputBatch.readRoundedVariables();
+                status = fmi3_setUInt64(fmu, mUInt64InputBatch.valueRefs(), mUInt64InputBatch.size(), mUInt64InputBatch.values(), mUInt64InputBatch.size());
+            }
+            if(!mUInt32InputBatch.empty()) {
+                mUInt32InputBatch.readRoundedVariables();
+                status = fmi3_setUInt32(fmu, mUInt32InputBatch.valueRefs(), mUInt32InputBatch.size(), mUInt32InputBatch.values(), mUInt32InputBatch.size());
+            }
+            if(!mUInt16InputBatch.empty()) {
+                mUInt16InputBatch.readRoundedVariables();
+                status = fmi3_setUInt16(fmu, mUInt16InputBatch.valueRefs(), mUInt16InputBatch.size(), mUInt16InputBatch.values(), mUInt16InputBatch.size());
+            }
+            if(!mUInt8InputBatch.empty()) {
+                mUInt8InputBatch.readRoundedVariables();
+                status = fmi3_setUInt8(fmu, mUInt8InputBatch.valueRefs(), mUInt8InputBatch.size(), mUInt8InputBatch.values(), mUInt8InputBatch.size());
+            }
+            if(!mBooleanInputBatch.empty()) {
+                mBooleanInputBatch.readBooleanVariables();
+                status = fmi3_setBoolean(fmu, mBooleanInputBatch.valueRefs(), mBooleanInputBatch.size(), mBooleanInputBatch.values(), mBooleanInputBatch.size());
+            }
+
+            //Take step
+            bool eventEncountered, terminateSimulation, earlyReturn;
+            double lastT;
+            status = fmi3_doStep(fmu, mTime, mTimestep, fmi3True, &eventEncountered, &terminateSimulation, &earlyReturn, &lastT);
+            if (status != fmi3OK) {
+                stopSimulation("fmi3DoStep() failed, status = "+to_hstring(status));
+                return;
+            }
+
+            //Forward outputs
+            if(!mFloat64OutputBatch.empty()) {
+                status = fmi3_getFloat64(fmu, mFloat64OutputBatch.valueRefs(), mFloat64OutputBatch.size(), mFloat64OutputBatch.values(), mFloat64OutputBatch.size());
+                mFloat64OutputBatch.writeVariables();
+            }
+            if(!mFloat32OutputBatch.empty()) {
+                status = fmi3_getFloat32(fmu, mFloat32OutputBatch.valueRefs(), mFloat32OutputBatch.size(), mFloat32OutputBatch.values(), mFloat32OutputBatch.size());
+                mFloat32OutputBatch.writeVariables();
+            }
+            if(!mInt64OutputBatch.empty()) {
+                status = fmi3_getInt64(fmu, mInt64OutputBatch.valueRefs(), mInt64OutputBatch.size(), mInt64OutputBatch.values(), mInt64OutputBatch.size());
+                mInt64OutputBatch.writeVariables();
+            }
+            if(!mInt32OutputBatch.empty()) {
+                status = fmi3_getInt32(fmu, mInt32OutputBatch.valueRefs(), mInt32OutputBatch.size(), mInt32OutputBatch.values(), mInt32OutputBatch.size());
+                mInt32OutputBatch.writeVariables();
+            }
+            if(!mInt16OutputBatch.empty()) {
+                status = fmi3_getInt16(fmu, mInt16OutputBatch.valueRefs(), mInt16OutputBatch.size(), mInt16OutputBatch.values(), mInt16OutputBatch.size());
+                mInt16OutputBatch.writeVariables();
+            }
+            if(!mInt8OutputBatch.empty()) {
+                status = fmi3_getInt8(fmu, mInt8OutputBatch.valueRefs(), mInt8OutputBatch.size(), mInt8OutputBatch.values(), mInt8OutputBatch.size());
+                mInt8OutputBatch.writeVariables();
+            }
+            if(!mUInt64OutputBatch.empty()) {
+                status = fmi3_getUInt64(fmu, mUInt64OutputBatch.valueRefs(), mUInt64OutputBatch.size(), mUInt64OutputBatch.values(), mUInt64OutputBatch.size());
+                mUInt64OutputBatch.writeVariables();
+            }
+            if(!mUInt32OutputBatch.empty()) {
+                status = fmi3_getUInt32(fmu, mUInt32OutputBatch.valueRefs(), mUInt32OutputBatch.size(), mUInt32OutputBatch.values(), mUInt32OutputBatch.size());
+                mUInt32OutputBatch.writeVariables();
+            }
+            if(!mUInt16OutputBatch.empty()) {
+                status = fmi3_getUInt16(fmu, mUInt16OutputBatch.valueRefs(), mUInt16OutputBatch.size(), mUInt16OutputBatch.values(), mUInt16OutputBatch.size());
+                mUInt16OutputBatch.writeVariables();
+            }
+            if(!mUInt8OutputBatch.empty()) {
+                status = fmi3_getUInt8(fmu, mUInt8OutputBatch.valueRefs(), mUInt8OutputBatch.size(), mUInt8OutputBatch.values(), mUInt8OutputBatch.size());
+                mUInt8OutputBatch.writeVariables();
+            }
+            if(!mBooleanOutputBatch.empty()) {
+                status = fmi3_getBoolean(fmu, mBooleanOutputBatch.valueRefs(), mBooleanOutputBatch.size(), mBooleanOutputBatch.values(), mBooleanOutputBatch.size());
+                mBooleanOutputBatch.writeVariables();
+            }
+        }
     }
 
     void finalize()
@@ -1409,6 +1415,42 @@ public:
     }
 
 
+    //! @brief Build contiguous value reference and value arrays, so that each data type is transferred with a single call per step
+    //! @note Must be called after the variable pointers have been assigned
+    void buildValueBatches()
+    {
+        mRealInputBatch.assign(mRealInputs);
+        mRealOutputBatch.assign(mRealOutputs);
+        mIntInputBatch.assign(mIntInputs);
+        mIntOutputBatch.assign(mIntOutputs);
+        mFmi1BoolInputBatch.assign(mBoolInputs);
+        mFmi1BoolOutputBatch.assign(mBoolOutputs);
+        mFmi2BoolInputBatch.assign(mBoolInputs);
+        mFmi2BoolOutputBatch.assign(mBoolOutputs);
+        mFloat64InputBatch.assign(mFloat64Inputs);
+        mFloat64OutputBatch.assign(mFloat64Outputs);
+        mFloat32InputBatch.assign(mFloat32Inputs);
+        mFloat32OutputBatch.assign(mFloat32Outputs);
+        mInt64InputBatch.assign(mInt64Inputs);
+        mInt64OutputBatch.assign(mInt64Outputs);
+        mInt32InputBatch.assign(mInt32Inputs);
+        mInt32OutputBatch.assign(mInt32Outputs);
+        mInt16InputBatch.assign(mInt16Inputs);
+        mInt16OutputBatch.assign(mInt16Outputs);
+        mInt8InputBatch.assign(mInt8Inputs);
+        mInt8OutputBatch.assign(mInt8Outputs);
+        mUInt64InputBatch.assign(mUInt64Inputs);
+        mUInt64OutputBatch.assign(mUInt64Outputs);
+        mUInt32InputBatch.assign(mUInt32Inputs);
+        mUInt32OutputBatch.assign(mUInt32Outputs);
+        mUInt16InputBatch.assign(mUInt16Inputs);
+        mUInt16OutputBatch.assign(mUInt16Outputs);
+        mUInt8InputBatch.assign(mUInt8Inputs);
+        mUInt8OutputBatch.assign(mUInt8Outputs);
+        mBooleanInputBatch.assign(mBoolInputs);
+        mBooleanOutputBatch.assign(mBoolOutputs);
+    }
+
     //! @brief Replaces all illegal characters in the string with underscores, so that it can be used as a variable name.
     //! @param [in] rName Input string
     //! @returns Input string with illegal characters replaced with underscore
@@ -91,6 +91,11 @@ public:
             addErrorMessage("Error interpreting numhop script: "+output);
             stopSimulation();
         }
+        // Compile the script for fast evaluation, scripts that can not be compiled are interpreted every time step instead
+        else if (!mpNumHop->compileNumHopScript(script.c_str(), output))
+        {
+            addDebugMessage("NumHop script is interpreted: "+output);
+        }
 
         simulateOneTimestep();
     }
@@ -99,6 +104,11 @@ public:
     void simulateOneTimestep()
     {
         // Note! Read and Write to nodes is handled internally in NumHopHelper (due to registered pointers)
+        if (mpNumHop->isCompiled())
+        {
+            mpNumHop->evalCompiled();
+            return;
+        }
 
         HString dummy;
         double dummy2;
@@ -24,6 +24,11 @@ extern "C" {
     HOPSANC_DLLAPI int loadLibrary(const char* path);
     HOPSANC_DLLAPI int getMessage(char* buf, size_t bufSize);
     HOPSANC_DLLAPI int loadModel(const char* path);
+    HOPSANC_DLLAPI int newModel(const char* name);
+    HOPSANC_DLLAPI int reserveModel(size_t numComponents, size_t numConnections);
+    HOPSANC_DLLAPI int addComponent(const char* typeName, const char* name, char* actualName, size_t bufSize);
+    HOPSANC_DLLAPI int connectPorts(const char* component1, const char* port1, const char* component2, const char* port2);
+    HOPSANC_DLLAPI int finishModel();
     HOPSANC_DLLAPI int setParameter(const char* name, const char *value);
     HOPSANC_DLLAPI int setStartTime(double value);
     HOPSANC_DLLAPI int setTimeStep(double value);
@@ -33,6 +38,9 @@ extern "C" {
     HOPSANC_DLLAPI int getTimeVector(double *data);
     HOPSANC_DLLAPI int getDataVector(const char *variable, double *data);
     HOPSANC_DLLAPI size_t getNumberOfLogSamples();
+    HOPSANC_DLLAPI int setProfilingEnabled(int enabled);
+    HOPSANC_DLLAPI size_t getProfileReportSize();
+    HOPSANC_DLLAPI int getProfileReport(char *buf, size_t bufSize);
 
 #ifdef __cplusplus
 }
@@ -6,9 +6,11 @@
 #include "HopsanCore.h"
 #include "HopsanEssentials.h"
 #include "ComponentSystem.h"
+#include "CoreUtilities/ModelBuilder.h"
 #include "ComponentUtilities/num2string.hpp"
 
 static hopsan::ComponentSystem *spCoreComponentSystem = nullptr;
+static hopsan::ModelBuilder *spModelBuilder = nullptr;
 static hopsan::HopsanEssentials gHopsanCore;
 
 static double startTime, stopTime;
@@ -67,6 +69,8 @@ int getMessage(char* buf, size_t bufSize) {
 //! @param [in] Full path to model file
 //! @returns Status (0 = success)
 int loadModel(const char* path) {
+    delete spModelBuilder;
+    spModelBuilder = nullptr;
     if(spCoreComponentSystem) {
         delete spCoreComponentSystem;
     }
@@ -84,6 +88,105 @@ int loadModel(const char* path) {
 }
 
 
+//! @brief Creates a new empty model, to be built with addComponent() and connectPorts() and completed with finishModel()
+//! @param [in] name Name of the model
+//! @returns Status (0 = success)
+int newModel(const char* name) {
+    delete spModelBuilder;
+    spModelBuilder = nullptr;
+    if(spCoreComponentSystem) {
+        delete spCoreComponentSystem;
+    }
+    spCoreComponentSystem = gHopsanCore.createComponentSystem();
+    if(!spCoreComponentSystem) {
+        printMessage("Failed to create model!");
+        printWaitingMessages(gHopsanCore, false, false);
+        return -1;
+    }
+    spCoreComponentSystem->setName(name);
+    spModelBuilder = new hopsan::ModelBuilder(spCoreComponentSystem);
+    printMessage("Created model: "+spCoreComponentSystem->getName());
+    return 0;
+}
+
+
+//! @brief Reserves storage for a model being built, to speed up building large models
+//! @param [in] numComponents Number of components that will be added
+//! @param [in] numConnections Number of connections that will be made
+//! @returns Status (0 = success)
+int reserveModel(size_t numComponents, size_t numConnections) {
+    if(!spModelBuilder) {
+        printMessage("Error: No model is being built, use newModel() first.");
+        return -1;
+    }
+    spModelBuilder->reserve(numComponents, numConnections);
+    return 0;
+}
+
+
+//! @brief Adds a component to the model being built
+//! @param [in] typeName Type name of the component
+//! @param [in] name Desired name of the component, a unique suffix is added if the name is taken (empty means use the type name)
+//! @param [in,out] actualName Buffer where the actual name of the component is stored (may be null)
+//! @param [in] bufSize Buffer size
+//! @returns Status (0 = success)
+int addComponent(const char* typeName, const char* name, char* actualName, size_t bufSize) {
+    if(!spModelBuilder) {
+        printMessage("Error: No model is being built, use newModel() first.");
+        return -1;
+    }
+    hopsan::Component *pComponent = spModelBuilder->addComponent(typeName, name ? name : "");
+    if(!pComponent) {
+        printMessage("Error: "+spModelBuilder->getLastError());
+        printWaitingMessages(gHopsanCore, false, false);
+        return -1;
+    }
+    if(actualName) {
+        const hopsan::HString &rActualName = pComponent->getName();
+        if(bufSize < rActualName.size()+1) {
+            printMessage("Error: Buffer is too small for component name: "+rActualName);
+            return -1;
+        }
+        strcpy(actualName, rActualName.c_str());
+    }
+    return 0;
+}
+
+
+//! @brief Connects two ports in the model being built, the connection is validated and made by finishModel()
+//! @param [in] component1 Name of the first component (or of a system port)
+//! @param [in] port1 Name of the port on the first component
+//! @param [in] component2 Name of the second component (or of a system port)
+//! @param [in] port2 Name of the port on the second component
+//! @returns Status (0 = success)
+int connectPorts(const char* component1, const char* port1, const char* component2, const char* port2) {
+    if(!spModelBuilder) {
+        printMessage("Error: No model is being built, use newModel() first.");
+        return -1;
+    }
+    spModelBuilder->connect(component1, port1, component2, port2);
+    return 0;
+}
+
+
+//! @brief Completes the model being built, making all connections
+//! @returns Status (0 = success)
+int finishModel() {
+    if(!spModelBuilder) {
+        printMessage("Error: No model is being built, use newModel() first.");
+        return -1;
+    }
+    const bool success = spModelBuilder->finish();
+    if(!success) {
+        printMessage("Error: "+spModelBuilder->getLastError());
+    }
+    delete spModelBuilder;
+    spModelBuilder = nullptr;
+    printWaitingMessages(gHopsanCore, false, false);
+    return success ? 0 : -1;
+}
+
+
 //! @brief Provides specified data vector from last simulation
 //! @param [in] variable Variable name ("component.port.variable")
 //! @param [in,out] data Buffer where data vector is stored (must be preallocated to match number of log samples)
@@ -118,9 +221,14 @@ int getDataVector(const char* variable, double *data)
         pSystem->getAliasHandler().getVariableFromAlias(splitVar[0], compName, portName, varId);
         hopsan::Component *pComp = pSystem->getSubComponent(compName);
         hopsan::Port *pPort = pComp->getPort(portName);
-        std::vector< std::vector<double> > *pLogData = pPort->getLogDataVectorPtr();
+        const std::vector<double> *pLogData = pPort->getLogDataVariablePtr(size_t(varId));
+        if(!pLogData) {
+            printMessage("Error: Variable is not logged: "+splitVar[0]);
+            return -1;
+        }
+        const size_t decimation = pPort->getLogDataDecimation(size_t(varId));
         for (size_t t=0; t<pSystem->getNumActuallyLoggedSamples(); ++t) {
-            data[t] = (*pLogData)[t][size_t(varId)];
+            data[t] = (*pLogData)[t/decimation];
         }
         return 0;   //Found alias variable!
     }
@@ -161,9 +269,14 @@ int getDataVector(const char* variable, double *data)
         return -1;
     }
 
-    std::vector< std::vector<double> > *pLogData = pPort->getLogDataVectorPtr();
+    const std::vector<double> *pLogData = pPort->getLogDataVariablePtr(size_t(varId));
+    if(!pLogData) {
+        printMessage("Error: Variable is not logged: "+splitVar[2]);
+        return -1;
+    }
+    const size_t decimation = pPort->getLogDataDecimation(size_t(varId));
     for (size_t t=0; t<spCoreComponentSystem->getNumActuallyLoggedSamples(); ++t) {
-        data[t] = (*pLogData)[t][size_t(varId)];
+        data[t] = (*pLogData)[t/decimation];
     }
     return 0;
 }
@@ -225,6 +338,10 @@ int simulate()
         printMessage("Error: No model is loaded!");
         return -1;
     }
+    if(spModelBuilder) {
+        printMessage("Error: Model is not finished, use finishModel() first.");
+        return -1;
+    }
     printMessage("Checking model... ");
     if (spCoreComponentSystem->checkModelBeforeSimulation()) {
         printMessage("Success!");
@@ -374,6 +491,56 @@ size_t getNumberOfLogSamples()
     return spCoreComponentSystem->getNumActuallyLoggedSamples();
 }
 
+//! @brief Enables or disables profiling of the time spent in each component during simulation
+//! @param [in] enabled Non-zero to enable profiling
+//! @returns Status (0 = success)
+int setProfilingEnabled(int enabled)
+{
+    if(!spCoreComponentSystem) {
+        printMessage("Error: No model is loaded.");
+        return -1;
+    }
+    spCoreComponentSystem->setProfilingEnabled(enabled != 0);
+    return 0;
+}
+
+
+//! @brief Returns the buffer size needed for the profile report from the last simulation (including null termination)
+//! @returns Buffer size
+size_t getProfileReportSize()
+{
+    if(!spCoreComponentSystem) {
+        printMessage("Error: No model is loaded.");
+        return 0;
+    }
+    return hopsan::profileReportToJSON(spCoreComponentSystem->getProfileReport()).size()+1;
+}
+
+
+//! @brief Provides the profile report from the last simulation, as JSON with one nested entry per component
+//! Profiling must be enabled with setProfilingEnabled() before simulating
+//! @param [in,out] buf Buffer where the report is stored (must be at least getProfileReportSize() bytes)
+//! @param [in] bufSize Buffer size
+//! @returns Status (0 = success)
+int getProfileReport(char *buf, size_t bufSize)
+{
+    if(!spCoreComponentSystem) {
+        printMessage("Error: No model is loaded.");
+        return -1;
+    }
+    if(!spCoreComponentSystem->isProfilingEnabled()) {
+        printMessage("Error: Profiling is not enabled.");
+        return -1;
+    }
+    const hopsan::HString report = hopsan::profileReportToJSON(spCoreComponentSystem->getProfileReport());
+    if(bufSize < report.size()+1) {
+        printMessage("Error: Buffer is too small for profile report, "+to_hstring(report.size()+1)+" bytes are needed.");
+        return -1;
+    }
+    strcpy(buf, report.c_str());
+    return 0;
+}
+
 int printWaitingMessages()
 {
     printWaitingMessages(gHopsanCore, false, false);
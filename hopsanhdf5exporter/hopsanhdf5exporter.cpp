@@ -180,3 +180,145 @@ const hopsan::HString &HopsanHDF5Exporter::getLastError()
 }
 
 
+
+
+HopsanHDF5StreamWriter::HopsanHDF5StreamWriter(const hopsan::HString &rFilePath, const hopsan::HString &rModelFileName, const hopsan::HString &rToolName) :
+    mFilePath(rFilePath),
+    mModelFileName(rModelFileName),
+    mToolName(rToolName),
+    mNumWrittenSamples(0) {}
+
+HopsanHDF5StreamWriter::~HopsanHDF5StreamWriter()
+{
+    close();
+}
+
+bool HopsanHDF5StreamWriter::open(const std::vector<LogSinkVariable> &rVariables)
+{
+    try {
+        H5::Exception::dontPrint();
+        mpFile.reset(new H5::H5File(mFilePath.c_str(), H5F_ACC_TRUNC));
+        mNumWrittenSamples = 0;
+
+        time_t rawtime;
+        char timestr[100];
+        time (&rawtime);
+        std::strftime(timestr,sizeof(timestr),"%a %b %d %H:%M:%S %Y",localtime(&rawtime));
+
+        H5::Group root = mpFile->openGroup("/");
+        appendH5Attribute(root, "date", timestr);
+        appendH5Attribute(root, "model", mModelFileName.c_str());
+        appendH5Attribute(root, "tool", mToolName.c_str());
+
+        // Determine the dataset names, and the groups that must be created (one depth at a time)
+        std::set<HString> uniqueGroupPaths;
+        std::vector< std::vector<HString> > datasetNames(rVariables.size());
+        for (size_t i=0; i<rVariables.size(); ++i) {
+            const LogSinkVariable &rVariable = rVariables[i];
+            HString groupPath = "/results/";
+            uniqueGroupPaths.insert(groupPath);
+            HString systemPath;
+            if (!rVariable.systemHierarchy.empty()) {
+                auto sysnames = rVariable.systemHierarchy.split('.');
+                for (size_t s=0; s<sysnames.size(); ++s) {
+                    systemPath.append(sysnames[s]);
+                    uniqueGroupPaths.insert(groupPath+systemPath);
+                    systemPath.append("/");
+                }
+            }
+            groupPath.append(systemPath);
+            if (!rVariable.componentName.empty()) {
+                groupPath.append(rVariable.componentName);
+                uniqueGroupPaths.insert(groupPath);
+                groupPath.append("/");
+                if (!rVariable.portName.empty()) {
+                    groupPath.append(rVariable.portName);
+                    uniqueGroupPaths.insert(groupPath);
+                    groupPath.append("/");
+                }
+            }
+            datasetNames[i].push_back(groupPath+rVariable.variableName);
+            if (!rVariable.alias.empty()) {
+                datasetNames[i].push_back("/results/"+systemPath+rVariable.alias);
+            }
+        }
+        for (const auto &groupPath : uniqueGroupPaths) {
+            mpFile->createGroup(groupPath.c_str());
+        }
+
+        // Create extendible, chunked datasets, starting empty
+        hsize_t dims[1] = {0};
+        hsize_t maxdims[1] = {H5S_UNLIMITED};
+        hsize_t chunkdims[1] = {1024};
+        H5::DataSpace dataspace(1, dims, maxdims);
+        H5::DSetCreatPropList properties;
+        properties.setChunk(1, chunkdims);
+
+        mDataSets.clear();
+        mDataSets.resize(rVariables.size());
+        for (size_t i=0; i<rVariables.size(); ++i) {
+            for (const auto &datasetName : datasetNames[i]) {
+                H5::DataSet dataset = mpFile->createDataSet(datasetName.c_str(), H5::PredType::NATIVE_DOUBLE, dataspace, properties);
+                appendH5Attribute(dataset, "Unit", rVariables[i].unit.c_str());
+                appendH5Attribute(dataset, "Quantity", rVariables[i].quantity.c_str());
+                mDataSets[i].push_back(dataset);
+            }
+        }
+    }
+    catch(H5::Exception &e) {
+        mLastError = HString(e.getCDetailMsg())+" in "+HString(e.getCFuncName());
+        mDataSets.clear();
+        mpFile.reset();
+        return false;
+    }
+    return true;
+}
+
+bool HopsanHDF5StreamWriter::write(const double *pSamples, const size_t numSamples)
+{
+    try {
+        const size_t numVariables = mDataSets.size();
+        hsize_t newSize[1] = {hsize_t(mNumWrittenSamples+numSamples)};
+        hsize_t offset[1] = {hsize_t(mNumWrittenSamples)};
+        hsize_t count[1] = {hsize_t(numSamples)};
+        H5::DataSpace memspace(1, count);
+
+        mColumnBuffer.resize(numSamples);
+        for (size_t i=0; i<numVariables; ++i) {
+            // Samples are stored row wise, gather one column at a time
+            for (size_t s=0; s<numSamples; ++s) {
+                mColumnBuffer[s] = pSamples[s*numVariables+i];
+            }
+            for (auto &dataset : mDataSets[i]) {
+                dataset.extend(newSize);
+                H5::DataSpace filespace = dataset.getSpace();
+                filespace.selectHyperslab(H5S_SELECT_SET, count, offset);
+                dataset.write(mColumnBuffer.data(), H5::PredType::NATIVE_DOUBLE, memspace, filespace);
+            }
+        }
+        mNumWrittenSamples += numSamples;
+    }
+    catch(H5::Exception &e) {
+        mLastError = HString(e.getCDetailMsg())+" in "+HString(e.getCFuncName());
+        return false;
+    }
+    return true;
+}
+
+bool HopsanHDF5StreamWriter::close()
+{
+    if (!mpFile) {
+        return true;
+    }
+    try {
+        mDataSets.clear();
+        mpFile->close();
+        mpFile.reset();
+    }
+    catch(H5::Exception &e) {
+        mLastError = HString(e.getCDetailMsg())+" in "+HString(e.getCFuncName());
+        mpFile.reset();
+        return false;
+    }
+    return true;
+}
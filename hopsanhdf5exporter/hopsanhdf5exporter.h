@@ -2,6 +2,15 @@
 #define HOPSANHDF5EXPORTER_H
 
 #include "HopsanEssentials.h"
+#include "CoreUtilities/LogSink.h"
+
+#include <memory>
+#include <vector>
+
+namespace H5 {
+class H5File;
+class DataSet;
+}
 
 class HopsanHDF5Exporter
 {
@@ -19,4 +28,23 @@ private:
     hopsan::HVector<hopsan::HVector<double> > mDataVectors;
 };
 
+//! @brief Log sink that streams log data into extendible HDF5 datasets during simulation
+//! @details The file layout is the same as the one produced by HopsanHDF5Exporter
+class HopsanHDF5StreamWriter : public hopsan::LogSink
+{
+public:
+    HopsanHDF5StreamWriter(const hopsan::HString &rFilePath, const hopsan::HString &rModelFileName, const hopsan::HString &rToolName);
+    ~HopsanHDF5StreamWriter();
+    bool open(const std::vector<hopsan::LogSinkVariable> &rVariables);
+    bool write(const double *pSamples, const size_t numSamples);
+    bool close();
+
+private:
+    hopsan::HString mFilePath, mModelFileName, mToolName;
+    std::unique_ptr<H5::H5File> mpFile;
+    std::vector< std::vector<H5::DataSet> > mDataSets;
+    std::vector<double> mColumnBuffer;
+    size_t mNumWrittenSamples;
+};
+
 #endif // HOPSANHDF5EXPORTER_H
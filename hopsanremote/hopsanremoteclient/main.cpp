@@ -78,6 +78,9 @@ int main(int argc, char* argv[])
         TCLAP::SwitchArg nonBlockingShell("", "nonblockingshell", "Don't wait for shell script to finish", cmd);
         TCLAP::MultiArg<std::string> shellOptions("", "shellexec", "Command to execute in shell", false, "string", cmd);
         TCLAP::MultiArg<std::string> requestOptions("", "request", "Request file (only from WD)", false, "string", cmd);
+        TCLAP::MultiArg<std::string> resultVariableOptions("", "resultvariable", "Result variable to request (full name or alias, a trailing * matches any suffix), all if not given", false, "string", cmd);
+        TCLAP::ValueArg<int> resultDecimationOption("", "resultdecimation", "Only request every n:th logged sample", false, 1, "Integer (default 1)", cmd);
+        TCLAP::ValueArg<int> resultEncodingOption("", "resultencoding", "Result transfer encoding: 0 = double, 1 = float (lossy), 2 = compressed double", false, 2, "Integer (default 2)", cmd);
         TCLAP::MultiArg<std::string> assetsOptions("a", "asset", "Model assets (files)", false, "string (filepath)", cmd);
         TCLAP::ValueArg<std::string> userOption("u","user","The user identification string",false,"","user:password or user", cmd);
         TCLAP::ValueArg<std::string> hmfPathOption("m","hmf","The Hopsan model file to load",false,"","Path to file", cmd);
@@ -188,8 +191,13 @@ int main(int argc, char* argv[])
                         if (rc)
                         {
                             vector<ResultVariableT> vars;
-                            rc = rhopsan.requestSimulationResults(vars);
-                            cout << PRINTCLIENT << "Results: " << rc << endl;
+                            rc = rhopsan.requestSimulationResults(resultVariableOptions.getValue(), resultDecimationOption.getValue(),
+                                                                  resultEncodingOption.getValue(), vars);
+                            cout << PRINTCLIENT << "Results: " << rc << " Variables: " << vars.size() << endl;
+                            if (!rc)
+                            {
+                                cout << PRINTCLIENT << "Error: " << rhopsan.getLastErrorMessage() << endl;
+                            }
                         }
                         else
                         {
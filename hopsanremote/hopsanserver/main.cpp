@@ -32,6 +32,7 @@
 #include <vector>
 #include <map>
 #include <chrono>
+#include <algorithm>
 
 #include "hopsanremotecommon/Messages.h"
 #include "hopsanremotecommon/MessageUtilities.h"
@@ -73,6 +74,7 @@ public:
     int mNumSlots=0;
     size_t mWorkerPort;
     string mUserid;
+    bool mIsIdle=false;
     steady_clock::time_point mLastAliveReport;
 #ifdef _WIN32
     PROCESS_INFORMATION mPid;
@@ -92,6 +94,7 @@ public:
     string mExternalIP;
     string mAddressServerIPandPort;
     double mAddressReportAge = 60*10;
+    int mWorkerPoolSize = 0;
 };
 
 ServerConfig gServerConfig;
@@ -249,6 +252,17 @@ void waitForWorkerProcess(WorkerInfo &rWI)
 #endif
 }
 
+//! @brief Stop a (pooled) worker process and wait for it
+void terminateWorkerProcess(WorkerInfo &rWI)
+{
+#ifdef _WIN32
+    TerminateProcess(rWI.mPid.hProcess, 1);
+#else
+    kill(rWI.mPid, SIGTERM);
+#endif
+    waitForWorkerProcess(rWI);
+}
+
 static int s_interrupted = 0;
 #ifdef _WIN32
 BOOL WINAPI consoleCtrlHandler( DWORD dwCtrlType )
@@ -276,6 +290,165 @@ static void s_catch_signals(void)
 
 map<int, WorkerInfo> workerMap;
 
+//! @brief Find the lowest worker port (above the control port) that is not used by any running worker
+size_t findFreeWorkerPort()
+{
+    size_t port = gServerConfig.mControlPort+1;
+    bool isUsed = true;
+    while (isUsed)
+    {
+        isUsed = false;
+        for (auto it=workerMap.begin(); it!=workerMap.end(); ++it)
+        {
+            if (it->second.mWorkerPort == port)
+            {
+                isUsed = true;
+                ++port;
+                break;
+            }
+        }
+    }
+    return port;
+}
+
+//! @brief Launch a new worker process
+//! @param[in] numThreads The number of simulation threads for the worker
+//! @param[in] userid The user that the worker is launched for (empty for pre-started pooled workers)
+//! @param[in] startIdle If true, the (pooled) worker waits for an assignment from the server before accepting clients
+//! @param[out] rUid The unique id of the launched worker
+//! @returns True if the worker process was launched
+bool launchWorker(int numThreads, const string &userid, bool startIdle, int &rUid)
+{
+    size_t workerPort = findFreeWorkerPort();
+
+    // Generate unique worker Id
+    int uid = rand();
+    while (workerMap.count(uid) != 0)
+    {
+        uid = rand();
+    }
+
+    // Workers are only reused if we keep a pool
+    string poolArg;
+    if (gServerConfig.mWorkerPoolSize > 0)
+    {
+        poolArg = startIdle ? "--pooled-idle" : "--pooled";
+    }
+
+#ifdef _WIN32
+    PROCESS_INFORMATION processInformation;
+    STARTUPINFO startupInfo;
+    memset(&processInformation, 0, sizeof(processInformation));
+    memset(&startupInfo, 0, sizeof(startupInfo));
+    startupInfo.cb = sizeof(startupInfo);
+
+    string scport = to_string(gServerConfig.mControlPort);
+    string swport = to_string(workerPort);
+    string nthreads = to_string(numThreads);
+    string uidstr = to_string(uid);
+
+    std::string appName("hopsanserverworker.exe");
+    std::string cmdLine("hopsanserverworker "+uidstr+" "+scport+" "+swport+" "+nthreads+" "+poolArg);
+    TCHAR* pTCharCmdLineBuff = new TCHAR[cmdLine.size()+1];
+    strcpy_s(pTCharCmdLineBuff, cmdLine.size()+1, cmdLine.c_str());
+
+    BOOL result = CreateProcess(appName.c_str(), pTCharCmdLineBuff, NULL, NULL, FALSE, NORMAL_PRIORITY_CLASS, NULL, NULL, &startupInfo, &processInformation);
+    delete[] pTCharCmdLineBuff;
+    if (result == 0)
+    {
+        std::cout << PRINTSERVER << nowDateTime() << " Error: Failed to launch worker process!"<<endl;
+        return false;
+    }
+    std::cout << PRINTSERVER << nowDateTime() << " Launched Worker Process, pid: "<< processInformation.dwProcessId << " port: " << workerPort << " uid: " << uid << " nThreads: " << numThreads << endl;
+    workerMap.insert({uid, WorkerInfo(numThreads, workerPort, userid, processInformation)});
+#else
+    char name_buff[64], sport_buff[64], wport_buff[64], thread_buff[64], uid_buff[64], pool_buff[64];
+    // Write name
+    sprintf(name_buff, "%s", "hopsanserverworker");
+    // Write port as char in buffer
+    sprintf(sport_buff, "%d", gServerConfig.mControlPort);
+    sprintf(wport_buff, "%d", int(workerPort));
+    // Write num threads as char in buffer
+    sprintf(thread_buff, "%d", numThreads);
+    // Write id as char in buffer
+    sprintf(uid_buff, "%d", uid);
+    sprintf(pool_buff, "%s", poolArg.c_str());
+
+    char *argv[] = {name_buff, uid_buff, sport_buff, wport_buff, thread_buff, poolArg.empty() ? nullptr : pool_buff, nullptr};
+
+    pid_t pid;
+    int status = posix_spawn(&pid,"./hopsanserverworker",nullptr,nullptr,argv,environ);
+    if (status != 0)
+    {
+        std::cout << PRINTSERVER << nowDateTime() << " Error: Failed to launch worker process!"<<endl;
+        return false;
+    }
+    std::cout << PRINTSERVER << nowDateTime() << " Launched Worker Process, pid: "<< pid << " port: " << workerPort << " uid: " << uid << " nThreads: " << numThreads << endl;
+    workerMap.insert({uid, WorkerInfo(numThreads, workerPort, userid, pid)});
+#endif
+    workerMap.at(uid).mIsIdle = startIdle;
+    rUid = uid;
+    return true;
+}
+
+//! @brief Find an idle pooled worker, preferably one that has served the same user before (its models may be cached)
+//! @details Workers reset their session when they return to the pool, so any idle worker can be used by any user
+map<int, WorkerInfo>::iterator findIdleWorker(const string &rUserid)
+{
+    auto anyIt = workerMap.end();
+    for (auto it=workerMap.begin(); it!=workerMap.end(); ++it)
+    {
+        if (it->second.mIsIdle)
+        {
+            if (it->second.mUserid == rUserid)
+            {
+                return it;
+            }
+            else if (anyIt == workerMap.end())
+            {
+                anyIt = it;
+            }
+        }
+    }
+    return anyIt;
+}
+
+//! @brief Assign an idle pooled worker to a new client
+bool assignIdleWorker(WorkerInfo &rWI, int numThreads, const string &rUserid)
+{
+    bool isAssigned = false;
+    try
+    {
+        zmq::socket_t workerSocket (gContext, ZMQ_REQ);
+        int linger_ms = 1000;
+        workerSocket.setsockopt(ZMQ_LINGER, &linger_ms, sizeof(int));
+        workerSocket.connect(makeZMQAddress("127.0.0.1", rWI.mWorkerPort).c_str());
+
+        CmdmsgAssignWorker msg = {numThreads, rUserid};
+        sendMessage(workerSocket, AssignWorker, msg);
+        std::string nackReason;
+        isAssigned = receiveAckNackMessage(workerSocket, 1000, nackReason);
+        if (!isAssigned)
+        {
+            cout << PRINTSERVER << nowDateTime() << " Error: Worker did not accept assignment: " << nackReason << endl;
+        }
+        workerSocket.disconnect(makeZMQAddress("127.0.0.1", rWI.mWorkerPort).c_str());
+    }
+    catch(zmq::error_t e)
+    {
+        cout << PRINTSERVER << nowDateTime() << " Error: Contacting Worker: " << e.what() << endl;
+    }
+
+    if (isAssigned)
+    {
+        rWI.mIsIdle = false;
+        rWI.mNumSlots = numThreads;
+        rWI.mUserid = rUserid;
+        rWI.mLastAliveReport = steady_clock::now();
+    }
+    return isAssigned;
+}
+
 int main(int argc, char* argv[])
 {
     TCLAP::CmdLine cmd("HopsanServer", ' ', "0.1");
@@ -288,6 +461,7 @@ int main(int argc, char* argv[])
 
     TCLAP::ValueArg<std::string> argDescription("", "description", "Label for this server", false, "", "", cmd);
     TCLAP::ValueArg<std::string> argAddressServerIP("", "addresserver", "IP:port to address server", false, "", "", cmd);
+    TCLAP::ValueArg<int> argWorkerPoolSize("", "poolsize", "The number of idle workers (with libraries loaded) to keep for reuse, 0 launches a new worker for each client. Pooled workers take the lowest free port above port, like other workers", false, 0, "int", cmd);
 
     // Parse the argv array.
     cmd.parse( argc, argv );
@@ -299,6 +473,7 @@ int main(int argc, char* argv[])
     gServerConfig.mExternalIP = argExternalIP.getValue();
     gServerConfig.mAddressServerIPandPort = argAddressServerIP.getValue();
     gServerConfig.mAddressReportAge = argAddressReportAge.getValue()*60;
+    gServerConfig.mWorkerPoolSize = std::max(argWorkerPoolSize.getValue(), 0);
 
     steady_clock::time_point lastStatusRequestTime;
 
@@ -323,6 +498,14 @@ int main(int argc, char* argv[])
 #else
         s_catch_signals();
 #endif
+
+        // Pre-start the worker pool, so that the first clients do not have to wait for libraries to load
+        for (int i=0; i<gServerConfig.mWorkerPoolSize; ++i)
+        {
+            int uid;
+            launchWorker(1, "", true, uid);
+        }
+
         while (true)
         {
             // Wait for next request from client
@@ -348,81 +531,45 @@ int main(int argc, char* argv[])
                     cout << PRINTSERVER << nowDateTime() << " Client (" << requestuserid << ") is requesting: " << requestNumThreads << " slots... " << endl;
                     if (gNumTakenSlots+requestNumThreads <= gServerConfig.mMaxNumSlots)
                     {
-                        size_t workerPort = gServerConfig.mControlPort+gNumTakenSlots+1;
-
-                        // Generate unique worker Id
-                        int uid = rand();
-                        while (workerMap.count(uid) != 0)
+                        // Reuse an idle pooled worker if there is one, libraries (and possibly models) are already loaded
+                        bool assigned = false;
+                        auto idleIt = findIdleWorker(requestuserid);
+                        while (idleIt != workerMap.end())
                         {
-                            uid = rand();
+                            if (assignIdleWorker(idleIt->second, requestNumThreads, requestuserid))
+                            {
+                                cout << PRINTSERVER << nowDateTime() << " Assigned pooled worker: " << idleIt->first << " port: " << idleIt->second.mWorkerPort << " nThreads: " << requestNumThreads << endl;
+                                ReplymsgReplyServerSlots msg = {int(idleIt->second.mWorkerPort)};
+                                sendMessage(socket, ReplyServerSlots, msg);
+                                gNumTakenSlots+=requestNumThreads;
+                                std::cout << PRINTSERVER << nowDateTime() << " Remaining slots: " << gServerConfig.mMaxNumSlots-gNumTakenSlots << endl;
+                                assigned = true;
+                                break;
+                            }
+                            else
+                            {
+                                cout << PRINTSERVER << nowDateTime() << " Pooled worker: " << idleIt->first << " did not accept assignment, terminating it" << endl;
+                                terminateWorkerProcess(idleIt->second);
+                                workerMap.erase(idleIt);
+                                idleIt = findIdleWorker(requestuserid);
+                            }
                         }
 
-#ifdef _WIN32
-                        PROCESS_INFORMATION processInformation;
-                        STARTUPINFO startupInfo;
-                        memset(&processInformation, 0, sizeof(processInformation));
-                        memset(&startupInfo, 0, sizeof(startupInfo));
-                        startupInfo.cb = sizeof(startupInfo);
-
-                        string scport = to_string(gServerConfig.mControlPort);
-                        string swport = to_string(workerPort);
-                        string nthreads = to_string(requestNumThreads);
-                        string uidstr = to_string(uid);
-
-                        std::string appName("hopsanserverworker.exe");
-                        std::string cmdLine("hopsanserverworker "+uidstr+" "+scport+" "+swport+" "+nthreads);
-                        TCHAR* pTCharCmdLineBuff = new TCHAR[cmdLine.size()+1];
-                        strcpy_s(pTCharCmdLineBuff, cmdLine.size()+1, cmdLine.c_str());
-
-                        BOOL result = CreateProcess(appName.c_str(), pTCharCmdLineBuff, NULL, NULL, FALSE, NORMAL_PRIORITY_CLASS, NULL, NULL, &startupInfo, &processInformation);
-                        if (result == 0)
-                        {
-                            std::cout << PRINTSERVER << "Error: Failed to launch worker process!"<<endl;
-                            sendMessage(socket, NotAck, "Failed to launch worker process!");
-                        }
-                        else
-                        {
-                            std::cout << PRINTSERVER << "Launched Worker Process, pid: "<< processInformation.dwProcessId << " port: " << workerPort << " uid: " << uid << " nThreads: " << requestNumThreads  << endl;
-                            workerMap.insert({uid, WorkerInfo(requestNumThreads, workerPort, requestuserid, processInformation)});
-
-                            ReplymsgReplyServerSlots msg = {workerPort};
-                            sendMessage<ReplymsgReplyServerSlots>(socket, ReplyServerSlots, msg);
-                            gNumTakenSlots++;
-                        }
-                        delete pTCharCmdLineBuff;
-
-#else
-                        char name_buff[64], sport_buff[64], wport_buff[64], thread_buff[64], uid_buff[64];
-                        // Write name
-                        sprintf(name_buff, "%s", "hopsanserverworker");
-                        // Write port as char in buffer
-                        sprintf(sport_buff, "%d", gServerConfig.mControlPort);
-                        sprintf(wport_buff, "%d", int(workerPort));
-                        // Write num threads as char in buffer
-                        sprintf(thread_buff, "%d", requestNumThreads);
-                        // Write id as char in buffer
-                        sprintf(uid_buff, "%d", uid);
-
-                        char *argv[] = {name_buff, uid_buff, sport_buff, wport_buff, thread_buff, nullptr};
-
-                        pid_t pid;
-                        int status = posix_spawn(&pid,"./hopsanserverworker",nullptr,nullptr,argv,environ);
-                        if(status == 0)
+                        if (!assigned)
                         {
-                            std::cout << PRINTSERVER << nowDateTime() << " Launched Worker Process, pid: "<< pid << " port: " << workerPort << " uid: " << uid << " nThreads: " << requestNumThreads << endl;
-                            workerMap.insert({uid, WorkerInfo(requestNumThreads, workerPort, requestuserid, pid)});
-
-                            ReplymsgReplyServerSlots msg = {int(workerPort)};
-                            sendMessage(socket, ReplyServerSlots, msg);
-                            gNumTakenSlots+=requestNumThreads;
-                            std::cout << PRINTSERVER << nowDateTime() << " Remaining slots: " << gServerConfig.mMaxNumSlots-gNumTakenSlots << endl;
+                            int uid;
+                            if (launchWorker(requestNumThreads, requestuserid, false, uid))
+                            {
+                                ReplymsgReplyServerSlots msg = {int(workerMap.at(uid).mWorkerPort)};
+                                sendMessage(socket, ReplyServerSlots, msg);
+                                gNumTakenSlots+=requestNumThreads;
+                                std::cout << PRINTSERVER << nowDateTime() << " Remaining slots: " << gServerConfig.mMaxNumSlots-gNumTakenSlots << endl;
+                            }
+                            else
+                            {
+                                sendMessage(socket, NotAck, "Failed to launch worker process!");
+                            }
                         }
-                        else
-                        {
-                            std::cout << PRINTSERVER << nowDateTime() << " Error: Failed to launch worker process!"<<endl;
-                            sendMessage(socket, NotAck, "Failed to launch worker process!");
-                        }
-#endif
                     }
                     else if (gNumTakenSlots == gServerConfig.mMaxNumSlots)
                     {
@@ -462,7 +609,8 @@ int main(int argc, char* argv[])
 //                            pid_t status = waitpid(pid, &stat_loc, WUNTRACED);
 //#endif
                             //! @todo check return codes maybe
-                            int nslots = it->second.mNumSlots;
+                            // Idle (pooled) workers do not hold any slots
+                            int nslots = it->second.mIsIdle ? 0 : it->second.mNumSlots;
                             workerMap.erase(it);
                             gNumTakenSlots -= nslots;
                             std::cout << PRINTSERVER << nowDateTime() << " Open slots: " << gServerConfig.mMaxNumSlots-gNumTakenSlots << endl;
@@ -501,6 +649,46 @@ int main(int argc, char* argv[])
                         cout << PRINTSERVER << nowDateTime() << " Error: Could not parse server id string" << endl;
                     }
                 }
+                else if (msg_id == WorkerIdle)
+                {
+                    bool parseOK;
+                    string id_string = unpackMessage<std::string>(request,offset,parseOK);
+                    if (parseOK)
+                    {
+                        int id = atoi(id_string.c_str());
+                        auto it = workerMap.find(id);
+                        if (it != workerMap.end())
+                        {
+                            int numIdle = 0;
+                            for (auto wit=workerMap.begin(); wit!=workerMap.end(); ++wit)
+                            {
+                                numIdle += wit->second.mIsIdle ? 1 : 0;
+                            }
+
+                            // Keep the worker if the pool is not full, otherwise it will exit and report WorkerFinished
+                            if (!it->second.mIsIdle && (numIdle < gServerConfig.mWorkerPoolSize))
+                            {
+                                sendShortMessage(socket, Ack);
+                                it->second.mIsIdle = true;
+                                it->second.mLastAliveReport = steady_clock::now();
+                                gNumTakenSlots -= it->second.mNumSlots;
+                                cout << PRINTSERVER << nowDateTime() << " Worker " << id_string << " returned to pool, Open slots: " << gServerConfig.mMaxNumSlots-gNumTakenSlots << endl;
+                            }
+                            else
+                            {
+                                sendMessage(socket, NotAck, "Worker pool is full");
+                            }
+                        }
+                        else
+                        {
+                            sendMessage(socket, NotAck, "Wrong worker id specified");
+                        }
+                    }
+                    else
+                    {
+                        cout << PRINTSERVER << nowDateTime() << " Error: Could not parse server id string" << endl;
+                    }
+                }
                 else if (msg_id == RequestServerStatus)
                 {
                     cout << PRINTSERVER << nowDateTime() << " Client is requesting status" << endl;
@@ -510,9 +698,12 @@ int main(int argc, char* argv[])
                     status.isReady = true;
                     for (auto it=workerMap.begin(); it!=workerMap.end(); ++it)
                     {
-                        status.users += it->second.mUserid+", ";
+                        if (!it->second.mIsIdle)
+                        {
+                            status.users += it->second.mUserid+", ";
+                        }
                     }
-                    if (!workerMap.empty())
+                    if (!status.users.empty())
                     {
                         status.users.pop_back();
                         status.users.pop_back();
@@ -560,7 +751,7 @@ int main(int argc, char* argv[])
 
             // Go through all running workers and check if we should try to request status from them, to see if they are still alive
             //! @todo since we are not using the status data here, maybe we should use ping/pong messages instead
-            for (auto it = workerMap.begin(); it!=workerMap.end(); ++it)
+            for (auto it = workerMap.begin(); it!=workerMap.end();)
             {
                 WorkerInfo &wi = it->second;
                 if (duration_cast<duration<double>>(steady_clock::now() - wi.mLastAliveReport).count() > 10*60)
@@ -571,12 +762,14 @@ int main(int argc, char* argv[])
                         cout << PRINTSERVER << nowDateTime() << "Worker: " << it->first << " is not responding!" << std::endl;
                         std::cout << PRINTSERVER << nowDateTime() << "Burying dead worker: " << it->first << endl;
                         waitForWorkerProcess(wi);
-                        int nslots = wi.mNumSlots;
-                        workerMap.erase(it);
+                        int nslots = wi.mIsIdle ? 0 : wi.mNumSlots;
+                        it = workerMap.erase(it);
                         gNumTakenSlots -= nslots ;
                         std::cout << PRINTSERVER << nowDateTime() << "Open slots: " << gServerConfig.mMaxNumSlots-gNumTakenSlots << endl;
+                        continue;
                     }
                 }
+                ++it;
             }
 
             if (s_interrupted)
@@ -586,6 +779,15 @@ int main(int argc, char* argv[])
             }
         }
 
+        // Stop idle pooled workers, workers with clients exit when their clients are done
+        for (auto it=workerMap.begin(); it!=workerMap.end(); ++it)
+        {
+            if (it->second.mIsIdle)
+            {
+                terminateWorkerProcess(it->second);
+            }
+        }
+
         // Tell master server we are closing
         if (argAddressServerIP.isSet())
         {
@@ -34,6 +34,10 @@
 #include <thread>
 #include <atomic>
 #include <array>
+#include <list>
+#include <map>
+#include <functional>
+#include <algorithm>
 
 #include "zmq.hpp"
 
@@ -41,6 +45,7 @@
 #include "hopsanremotecommon/MessageUtilities.h"
 #include "hopsanremotecommon/FileAccess.h"
 #include "hopsanremotecommon/FileReceiver.hpp"
+#include "hopsanremotecommon/ResultEncoding.h"
 
 #include "HopsanEssentials.h"
 #include "CoreUtilities/HopsanCoreMessageHandler.h"
@@ -68,10 +73,10 @@ bool gHaveLoadedComponentLibraries=false;
 typedef struct
 {
     string fullName;
-    vector< vector<double> > *pData = 0;
+    const vector<double> *pData = 0;
     vector< double > *pTimeData = 0;
     size_t dataLength = 0;
-    size_t dataId = 0;
+    size_t dataDecimation = 1;
     string unit;
     string quantity;
     string alias;
@@ -127,18 +132,14 @@ void collectAllModelVariables(ComponentSystem *pSys, vector<ModelVariableInfo_t>
                     continue;
                 }
 
-                //! @todo what about time vector
-                vector< vector<double> > *pLogData = pPort->getLogDataVectorPtr();
-
                 const vector<NodeDataDescription> *pVars = pPort->getNodeDataDescriptions();
                 if (pVars)
                 {
                     for (size_t v=0; v<pVars->size(); ++v)
                     {
-                        // Only write something if data has been logged (skip ports that are not logged)
-                        // We assume that the data vector has been cleared
-                        //! @todo check if log on
-                        if (pLogData->size() > 0)
+                        // Only write something if data has been logged (skip ports and variables that are not logged)
+                        const vector<double> *pLogData = pPort->getLogDataVariablePtr(v);
+                        if (pLogData && pLogData->size() > 0)
                         {
                             const NodeDataDescription *pVarDesc = &(*pVars)[v];
                             ModelVariableInfo_t mvi;
@@ -147,7 +148,7 @@ void collectAllModelVariables(ComponentSystem *pSys, vector<ModelVariableInfo_t>
                             mvi.quantity = pVarDesc->quantity.c_str();
                             mvi.unit = pVarDesc->unit.c_str();
                             mvi.pData = pLogData;
-                            mvi.dataId = pVarDesc->id;
+                            mvi.dataDecimation = pPort->getLogDataDecimation(v);
                             mvi.dataLength = pSys->getNumActuallyLoggedSamples();
                             rvMVI.push_back(mvi);
                         }
@@ -158,6 +159,34 @@ void collectAllModelVariables(ComponentSystem *pSys, vector<ModelVariableInfo_t>
     }
 }
 
+//! @brief Returns the number of samples of a variable when every decimation:th sample is sent
+size_t numDecimatedSamples(const ModelVariableInfo_t &rMvi, const size_t decimation)
+{
+    return (rMvi.dataLength + decimation - 1) / decimation;
+}
+
+//! @brief Copy decimated samples of a variable into a buffer (the buffer is overwritten)
+void copyDecimatedSamples(const ModelVariableInfo_t &rMvi, const size_t decimation, const size_t firstSample, const size_t numSamples, vector<double> &rBuffer)
+{
+    rBuffer.resize(numSamples);
+    for (size_t s=0; s<numSamples; ++s)
+    {
+        const size_t t = (firstSample+s)*decimation;
+        if (rMvi.pData)
+        {
+            rBuffer[s] = (*rMvi.pData)[t/rMvi.dataDecimation];
+        }
+        else if (rMvi.pTimeData)
+        {
+            rBuffer[s] = (*rMvi.pTimeData)[t];
+        }
+        else
+        {
+            rBuffer[s] = 0;
+        }
+    }
+}
+
 void splitStringOnDelimiter(const std::string &rString, const char delim, std::vector<std::string> &rSplitVector)
 {
     rSplitVector.clear();
@@ -273,6 +302,8 @@ string getParameter(ComponentSystem *pSystem, HString &fullname)
 ComponentSystem *gpRootSystem=nullptr;
 double gSimStartTime, gSimStopTime;
 size_t gNumThreads = 1;
+bool gIsPooled = false;
+bool gIsIdle = false;
 SimulationHandler gSimulator;
 FileReceiver gModelAssets;
 std::atomic_bool gIsSimulating(false);
@@ -282,6 +313,7 @@ bool gIsModelLoaded = false;
 bool gWasSimulationOK = false;
 bool gSimulationFinnished = false;
 bool gShellExecExitOK = false;
+string gExecuteInShellOutput;
 double gInitTime;
 double gSimulationTime;
 double gFinilizeTime;
@@ -366,7 +398,7 @@ void waitShellExecThread(pid_t *pPid, std::string *pShellOutput, bool *pExitstat
 
 
 
-void loadComponentLibraries(const std::string &rDir, bool doRecurse)
+void loadComponentLibraries(const std::string &rDir, bool doRecurse, vector<string> *pLoadedFiles=nullptr)
 {
     FileAccess fa;
     if (fa.enterDir(rDir))
@@ -375,7 +407,10 @@ void loadComponentLibraries(const std::string &rDir, bool doRecurse)
         for (string f : soFiles)
         {
             cout << PRINTWORKER << nowDateTime() << " Loading library file: " << f << endl;
-            gHopsanCore.loadExternalComponentLib(f.c_str());
+            if (gHopsanCore.loadExternalComponentLib(f.c_str()) && pLoadedFiles)
+            {
+                pLoadedFiles->push_back(f);
+            }
         }
     }
     else
@@ -384,22 +419,162 @@ void loadComponentLibraries(const std::string &rDir, bool doRecurse)
     }
 }
 
-bool loadModel(string &rModel)
+void loadCommonComponentLibraries()
 {
-    // Load component libraries if not already done
     if (!gHaveLoadedComponentLibraries)
     {
         // Load Hopsan default component library
         loadComponentLibraries("../componentLibraries/defaultLibrary", false);
         // Load common shared libraries
         loadComponentLibraries("./componentLibraries", true);
-        // Load user specific libraries
-        if (!gUserName.empty())
+        gHaveLoadedComponentLibraries=true;
+    }
+}
+
+// ------------------------------
+// Model cache BEGIN
+// ------------------------------
+
+//! @brief A loaded model, kept so that a repeated SetModel with the same hmf does not need to parse it again
+class CachedModel
+{
+public:
+    size_t mHash;
+    string mHmf;
+    string mUserName;
+    ComponentSystem *mpSystem;
+    double mStartTime, mStopTime;
+    //! @brief Original values of parameters changed by the client, restored when the model is reused
+    map<string, string> mChangedParameters;
+};
+
+const size_t gMaxNumCachedModels = 4;
+list<CachedModel> gModelCache;
+//! @brief The library files loaded from the user directories, by user name
+map<string, vector<string> > gLoadedUserLibraries;
+
+//! @brief Remember the original value of a parameter before it is changed, so that it can be restored
+void rememberParameter(const string &rFullName)
+{
+    if (!gModelCache.empty() && (gModelCache.front().mpSystem == gpRootSystem))
+    {
+        map<string, string> &rChanged = gModelCache.front().mChangedParameters;
+        if (rChanged.find(rFullName) == rChanged.end())
         {
-            loadComponentLibraries("./"+gUserName, true);
+            HString fullName = rFullName.c_str();
+            rChanged.insert({rFullName, getParameter(gpRootSystem, fullName)});
         }
+    }
+}
 
-        gHaveLoadedComponentLibraries=true;
+//! @brief Find a previously loaded model with identical hmf, restore its parameters and make it the current model
+bool reuseCachedModel(const string &rModel)
+{
+    const size_t hash = std::hash<string>()(rModel);
+    for (auto it=gModelCache.begin(); it!=gModelCache.end(); ++it)
+    {
+        if ((it->mHash == hash) && (it->mUserName == gUserName) && (it->mHmf == rModel))
+        {
+            for (auto &rParameter : it->mChangedParameters)
+            {
+                HString fullName = rParameter.first.c_str();
+                setParameter(it->mpSystem, fullName, rParameter.second.c_str());
+            }
+            it->mChangedParameters.clear();
+
+            gpRootSystem = it->mpSystem;
+            gSimStartTime = it->mStartTime;
+            gSimStopTime = it->mStopTime;
+            // Move to front, the least recently used model is last
+            gModelCache.splice(gModelCache.begin(), gModelCache, it);
+            return true;
+        }
+    }
+    return false;
+}
+
+void addModelToCache(const string &rModel)
+{
+    CachedModel cm;
+    cm.mHash = std::hash<string>()(rModel);
+    cm.mHmf = rModel;
+    cm.mUserName = gUserName;
+    cm.mpSystem = gpRootSystem;
+    cm.mStartTime = gSimStartTime;
+    cm.mStopTime = gSimStopTime;
+    gModelCache.push_front(cm);
+    while (gModelCache.size() > gMaxNumCachedModels)
+    {
+        delete gModelCache.back().mpSystem;
+        gModelCache.pop_back();
+    }
+}
+
+void clearModelCache()
+{
+    for (auto &rCached : gModelCache)
+    {
+        delete rCached.mpSystem;
+    }
+    gModelCache.clear();
+    gpRootSystem=nullptr;
+    gIsModelLoaded = false;
+}
+
+//! @brief Unload the user specific libraries, cached models of users that had libraries loaded are removed first
+void unloadUserLibraries()
+{
+    for (auto &rUserLibs : gLoadedUserLibraries)
+    {
+        if (!rUserLibs.second.empty())
+        {
+            for (auto it=gModelCache.begin(); it!=gModelCache.end();)
+            {
+                if (it->mUserName == rUserLibs.first)
+                {
+                    if (it->mpSystem == gpRootSystem)
+                    {
+                        gpRootSystem=nullptr;
+                        gIsModelLoaded = false;
+                    }
+                    delete it->mpSystem;
+                    it = gModelCache.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+            for (const string &rLib : rUserLibs.second)
+            {
+                cout << PRINTWORKER << nowDateTime() << " Unloading library file: " << rLib << endl;
+                gHopsanCore.unLoadExternalComponentLib(rLib.c_str());
+            }
+        }
+    }
+    gLoadedUserLibraries.clear();
+}
+
+// ------------------------------
+// Model cache END
+// ------------------------------
+
+bool loadModel(string &rModel)
+{
+    // Load component libraries if not already done
+    loadCommonComponentLibraries();
+    // Load user specific libraries
+    if (!gUserName.empty() && (gLoadedUserLibraries.count(gUserName) == 0))
+    {
+        loadComponentLibraries("./"+gUserName, true, &gLoadedUserLibraries[gUserName]);
+    }
+
+    // Reuse the model if it has been loaded before, only its parameters are restored
+    if (reuseCachedModel(rModel))
+    {
+        cout << PRINTWORKER << nowDateTime() << " Model was reused from cache" << endl;
+        gIsModelLoaded = true;
+        return true;
     }
 
     // Remember number of errors during loading libraries so that we can detect additional errors below when loading the model
@@ -411,13 +586,9 @@ bool loadModel(string &rModel)
         gHopsanCore.getCoreMessageHandler()->printMessagesToStdOut();
     }
 
-    // If a model is already loaded then delete it
-    if (gpRootSystem)
-    {
-        delete gpRootSystem;
-        gpRootSystem=nullptr;
-        gIsModelLoaded = false;
-    }
+    // A model that is already loaded remains in the cache
+    gpRootSystem=nullptr;
+    gIsModelLoaded = false;
 
     //! @todo loadHMFModel will hang (sometimes) if hmf empty
     if (!rModel.empty())
@@ -429,6 +600,7 @@ bool loadModel(string &rModel)
     if (gpRootSystem && (gHopsanCore.getNumErrorMessages()+gHopsanCore.getNumFatalMessages() <= numLibErrors) )
     {
         cout << PRINTWORKER << nowDateTime() << " Model was loaded sucessfully" << endl;
+        addModelToCache(rModel);
         gIsModelLoaded = true;
         return true;
     }
@@ -436,6 +608,8 @@ bool loadModel(string &rModel)
     {
         cout << PRINTWORKER << nowDateTime() << " Error: Could not load the model" << endl;
         gHopsanCore.getCoreMessageHandler()->printMessagesToStdOut();
+        delete gpRootSystem;
+        gpRootSystem=nullptr;
         return false;
     }
 }
@@ -455,7 +629,43 @@ void sendAliveToServer(zmq::socket_t &rSocket)
     receiveWithTimeout(rSocket, 5000, response); // Wait for but ignore replay
 }
 
-string gExecuteInShellOutput;
+//! @brief Tell the server that this pooled worker is free for a new client
+//! @returns True if the server wants to keep this worker, false if it should exit
+bool sendIdleToServer(zmq::socket_t &rSocket)
+{
+    sendMessage(rSocket, WorkerIdle, gWorkerId);
+    zmq::message_t response;
+    if (receiveWithTimeout(rSocket, 5000, response))
+    {
+        size_t offset=0;
+        bool parseOK;
+        size_t id = getMessageId(response, offset, parseOK);
+        return (id == Ack);
+    }
+    return false;
+}
+
+//! @brief Reset the client session so that a pooled worker can be reused by any user
+//! @details Common libraries and cached models are kept, user specific libraries (and models using them) are unloaded
+void resetSession()
+{
+    unloadUserLibraries();
+    gpRootSystem=nullptr;
+    gIsModelLoaded = false;
+    gWasSimulationOK = false;
+    gSimulationFinnished = false;
+    gShellExecExitOK = false;
+    gExecuteInShellOutput.clear();
+    // Discard messages that the previous client did not collect
+    HopsanCoreMessageHandler *pHandler = gHopsanCore.getCoreMessageHandler();
+    while (pHandler->getNumWaitingMessages() > 0)
+    {
+        HString mess, tag, type;
+        pHandler->getMessage(mess, type, tag);
+    }
+    gUserName="anonymous";
+    gModelAssets.setFileDestination("./"+gUserName);
+}
 
 int main(int argc, char* argv[])
 {
@@ -471,10 +681,17 @@ int main(int argc, char* argv[])
     string workerCtrlPort = argv[3];
 
     // Read num threads argument
-    if (argc == 5)
+    if (argc >= 5)
     {
         gNumThreads = size_t(atoi(argv[4]));
     }
+    // A pooled worker is reused by the server for new clients, instead of exiting when its client is done
+    // Pre-started pooled workers wait idle until the server assigns them to a client
+    if (argc >= 6)
+    {
+        gIsPooled = (string(argv[5]) == "--pooled") || (string(argv[5]) == "--pooled-idle");
+        gIsIdle = (string(argv[5]) == "--pooled-idle");
+    }
 
     cout << PRINTWORKER << nowDateTime() << " Listening on port: " << workerCtrlPort << " Using: " << gNumThreads << " threads" << endl;
     cout << PRINTWORKER << nowDateTime() << " Server control port is: " << serverCtrlPort << endl;
@@ -487,6 +704,13 @@ int main(int argc, char* argv[])
     }
     gModelAssets.setFileDestination("./"+gUserName);
 
+    // Pooled workers load libraries before the first client arrives
+    if (gIsPooled)
+    {
+        cout << PRINTWORKER << nowDateTime() << " Started as pooled worker" << endl;
+        loadCommonComponentLibraries();
+    }
+
     // Prepare our context and sockets
     try
     {
@@ -528,7 +752,11 @@ int main(int argc, char* argv[])
                 bool idParseOK;
                 size_t msg_id = getMessageId(request, offset, idParseOK);
                 cout << PRINTWORKER << nowDateTime() << " Received message with length: " << request.size() << " msg_id: " << msg_id << endl;
-                if (msg_id == RequestWorkerStatus)
+                if (gIsIdle && idParseOK && (msg_id != RequestWorkerStatus) && (msg_id != AssignWorker))
+                {
+                    sendMessage(socket, NotAck, "Worker is idle, request a slot from the server");
+                }
+                else if (msg_id == RequestWorkerStatus)
                 {
                     cout << PRINTWORKER << nowDateTime() << " Got status request" << endl;
                     ReplymsgReplyWorkerStatus msg;
@@ -566,6 +794,7 @@ int main(int argc, char* argv[])
                         cout << PRINTWORKER << nowDateTime() << " Client want to set parameter " << msg.name << " " << msg.value << endl;
 
                         // Set parameter
+                        rememberParameter(msg.name);
                         HString fullName = msg.name.c_str();
                         bool rc = setParameter(gpRootSystem, fullName, msg.value.c_str());
                         // Send ack or nack
@@ -893,6 +1122,8 @@ int main(int argc, char* argv[])
                         string varName = unpackMessage<string>(request, offset, parseOK);
                         vector<ModelVariableInfo_t> vMVI;
                         collectAllModelVariables(gpRootSystem, vMVI, "");
+                        vMVI.erase(std::remove_if(vMVI.begin(), vMVI.end(), [&varName](const ModelVariableInfo_t &rMvi)
+                                                  {return !matchesVariableFilter(rMvi.fullName, rMvi.alias, {varName});}), vMVI.end());
                         cout << PRINTWORKER << nowDateTime() << " Client requests variable: " << varName << " Sending: " << vMVI.size() << " variables!" << endl;
 
                         //! @todo Check if simulation finished, ACK Nack
@@ -912,7 +1143,7 @@ int main(int argc, char* argv[])
                             {
                                 for (size_t t=0; t<rMvi.dataLength; ++t)
                                 {
-                                    vars.back().data.push_back((*rMvi.pData)[t][rMvi.dataId]);
+                                    vars.back().data.push_back((*rMvi.pData)[t/rMvi.dataDecimation]);
                                 }
                             }
                             // Copy if a time data variable
@@ -928,6 +1159,86 @@ int main(int argc, char* argv[])
                         sendMessage(socket,ReplyResults,vars);
                     }
                 }
+                else if (msg_id == RequestResultsChunk)
+                {
+                    bool parseOK;
+                    ReqmsgRequestResultsChunk msg = unpackMessage<ReqmsgRequestResultsChunk>(request, offset, parseOK);
+                    if (!parseOK)
+                    {
+                        cout << PRINTWORKER << nowDateTime() << " Error: Could not parse results request" << endl;
+                        sendMessage(socket, NotAck, "Could not parse results request");
+                    }
+                    else if (gIsSimulating)
+                    {
+                        sendMessage(socket, NotAck, "Simulation is still in progress!");
+                    }
+                    else if (!gpRootSystem)
+                    {
+                        sendMessage(socket, NotAck, "No model is loaded");
+                    }
+                    else if (!isValidResultEncoding(msg.encoding))
+                    {
+                        sendMessage(socket, NotAck, "Unknown result encoding: "+to_string(msg.encoding));
+                    }
+                    else
+                    {
+                        vector<ModelVariableInfo_t> vMVI;
+                        collectAllModelVariables(gpRootSystem, vMVI, "");
+                        vMVI.erase(std::remove_if(vMVI.begin(), vMVI.end(), [&msg](const ModelVariableInfo_t &rMvi)
+                                                  {return !matchesVariableFilter(rMvi.fullName, rMvi.alias, msg.variables);}), vMVI.end());
+
+                        const size_t decimation = size_t(std::max(msg.decimation, 1));
+                        const size_t maxSamples = size_t(std::max(msg.maxsamples, 1));
+                        if (msg.variableoffset == 0 && msg.sampleoffset == 0)
+                        {
+                            cout << PRINTWORKER << nowDateTime() << " Client requests " << msg.variables.size() << " variable names, sending: " << vMVI.size()
+                                 << " variables in chunks, decimation: " << decimation << " encoding: " << msg.encoding << endl;
+                        }
+
+                        ReplymsgResultsChunk reply;
+                        reply.numvariables = int(vMVI.size());
+                        reply.encoding = msg.encoding;
+                        size_t v = size_t(std::max(msg.variableoffset, 0));
+                        size_t firstSample = size_t(std::max(msg.sampleoffset, 0));
+                        size_t numSamplesInChunk = 0;
+                        vector<double> buffer;
+                        while (v < vMVI.size() && numSamplesInChunk < maxSamples)
+                        {
+                            const ModelVariableInfo_t &rMvi = vMVI[v];
+                            const size_t totalSamples = numDecimatedSamples(rMvi, decimation);
+                            const size_t numSamples = std::min(totalSamples-std::min(firstSample, totalSamples), maxSamples-numSamplesInChunk);
+
+                            reply.variables.push_back(ReplymsgResultsChunkVariable());
+                            ReplymsgResultsChunkVariable &rVar = reply.variables.back();
+                            rVar.index = int(v);
+                            if (firstSample == 0)
+                            {
+                                rVar.name = rMvi.fullName;
+                                rVar.alias = rMvi.alias;
+                                rVar.quantity = rMvi.quantity;
+                                rVar.unit = rMvi.unit;
+                            }
+                            rVar.totalsamples = int(totalSamples);
+                            rVar.sampleoffset = int(firstSample);
+                            rVar.numsamples = int(numSamples);
+                            copyDecimatedSamples(rMvi, decimation, firstSample, numSamples, buffer);
+                            encodeResultData(buffer.data(), numSamples, 1, msg.encoding, rVar.data);
+
+                            numSamplesInChunk += numSamples;
+                            firstSample += numSamples;
+                            if (firstSample >= totalSamples)
+                            {
+                                ++v;
+                                firstSample = 0;
+                            }
+                        }
+                        reply.nextvariable = int(v);
+                        reply.nextsample = int(firstSample);
+                        reply.islastpart = (v >= vMVI.size());
+
+                        sendMessage(socket, ReplyResultsChunk, reply);
+                    }
+                }
                 else if (msg_id == RequestMessages)
                 {
                     HopsanCoreMessageHandler *pHandler = gHopsanCore.getCoreMessageHandler();
@@ -992,6 +1303,23 @@ int main(int argc, char* argv[])
                         sendMessage(socket, NotAck, "Could not parse user identification");
                     }
                 }
+                else if (msg_id == AssignWorker)
+                {
+                    bool parseOK;
+                    CmdmsgAssignWorker msg = unpackMessage<CmdmsgAssignWorker>(request, offset, parseOK);
+                    if (parseOK && gIsIdle)
+                    {
+                        cout << PRINTWORKER << nowDateTime() << " Assigned to client (" << msg.userid << ") using: " << msg.numThreads << " threads" << endl;
+                        gNumThreads = size_t(msg.numThreads);
+                        gIsIdle = false;
+                        gClientConnected = true;
+                        sendShortMessage(socket, Ack);
+                    }
+                    else
+                    {
+                        sendMessage(socket, NotAck, parseOK ? "Worker is not idle" : "Could not parse worker assignment");
+                    }
+                }
                 else if (msg_id == ClientClosing)
                 {
                     cout << PRINTWORKER << nowDateTime() << " Client said godbye!" << endl;
@@ -1021,7 +1349,7 @@ int main(int argc, char* argv[])
             {
                 // Handle timeout / exception
                 nClientTimeouts++;
-                if (!gShellIsExecuting)
+                if (!gShellIsExecuting && !gIsIdle)
                 {
                     if (double(nClientTimeouts)*double(client_timeout)/60000.0 >= dead_client_timout_min)
                     {
@@ -1042,9 +1370,20 @@ int main(int argc, char* argv[])
             }
 
             // If client have said goodbye and we are no longer simulating or shell executing, then exit
-            if (!gClientConnected && !gIsSimulating && !gShellIsExecuting)
+            // (or return to the pool, if the server wants to keep us)
+            if (!gIsIdle && !gClientConnected && !gIsSimulating && !gShellIsExecuting)
             {
-                keepRunning = false;
+                if (gIsPooled && sendIdleToServer(serverSocket))
+                {
+                    cout << PRINTWORKER << nowDateTime() << " Returning to worker pool" << endl;
+                    resetSession();
+                    gIsIdle = true;
+                    nClientTimeouts = 0;
+                }
+                else
+                {
+                    keepRunning = false;
+                }
             }
 
             if (s_interrupted)
@@ -1057,13 +1396,8 @@ int main(int argc, char* argv[])
         // Notify server about our exit
         sendGoodbyToServer(serverSocket);
 
-        // Delete the model if we have one
-        if (gpRootSystem)
-        {
-            delete gpRootSystem;
-            gpRootSystem=nullptr;
-            gIsModelLoaded = false;
-        }
+        // Delete the loaded models
+        clearModelCache();
     }
     catch(zmq::error_t e)
     {
@@ -54,6 +54,7 @@ public:
     long getLongReceiveTimeout() const;
 
     void setMaxWorkerStatusRequestWaitTime(double seconds);
+    void setMaxResultChunkSamples(int numSamples);
 
     bool connectToAddressServer(std::string address);
     bool addressServerConnected() const;
@@ -93,6 +94,8 @@ public:
     bool requestWorkerStatus(WorkerStatusT &rWorkerStatus);
     bool requestServerStatus(ServerStatusT &rServerStatus);
     bool requestSimulationResults(std::vector<ResultVariableT> &rResultVariables);
+    bool requestSimulationResults(const std::vector<std::string> &rVariableNames, const int decimation, const int encoding,
+                                  std::vector<ResultVariableT> &rResultVariables);
     bool requestMessages();
     bool requestMessages(std::vector<char> &rTypes, std::vector<std::string> &rTags, std::vector<std::string> &rMessages);
     bool requestShellOutput(std::string &rOutput);
@@ -112,10 +115,14 @@ private:
     void deleteWorkerSocket();
     void requestWorkerStatusThread(double *pProgress, bool *pAlive);
     void setLastError(const std::string &rError);
+    bool requestResultChunks(const std::vector<std::string> &rVariableNames, const int decimation, const int encoding,
+                             std::vector<ResultVariableT> &rResultVariables, bool &rFirstRequestRejected);
+    bool requestAllResultsInOneMessage(std::vector<ResultVariableT> &rResultVariables);
 
     double mMaxWorkerStatusRequestWaitTime = 30; //!< The maximum delay between worker status requests in seconds
     long mShortReceiveTimeout = 5000; //!< Receive timeout in ms
     long mLongReceiveTimeout = 30000; //!< Receive timeout in ms
+    int mMaxResultChunkSamples = 1000000; //!< The maximum number of result samples the worker may send in one chunk
     double mMaxNoProgressTime = 30; //!< The maximum allowed time in seconds with no progress before simulation is assumed frozen
     std::string mLastErrorMessage;
     std::string mAddressServerAddress;
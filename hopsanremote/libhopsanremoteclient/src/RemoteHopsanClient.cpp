@@ -28,6 +28,7 @@
 #include "hopsanremotecommon/Messages.h"
 #include "hopsanremotecommon/MessageUtilities.h"
 #include "hopsanremotecommon/FileReceiver.hpp"
+#include "hopsanremotecommon/ResultEncoding.h"
 
 #include "zmq.hpp"
 #include "msgpack.hpp"
@@ -519,16 +520,52 @@ bool RemoteHopsanClient::requestServerStatus(ServerStatusT &rServerStatus)
     return false;
 }
 
+//! @brief Request all logged results, using lossless compressed transfer
+//! @details Workers that do not support the chunked transfer reject it, then all results are requested in one message instead
 bool RemoteHopsanClient::requestSimulationResults(std::vector<ResultVariableT> &rResultVariables)
 {
     std::lock_guard<std::mutex> lock(mWorkerMutex);
 
+    bool firstRequestRejected = false;
+    if (requestResultChunks(std::vector<std::string>(), 1, ResultXorFloat64, rResultVariables, firstRequestRejected))
+    {
+        return true;
+    }
+    if (firstRequestRejected)
+    {
+        const std::string chunkError = mLastErrorMessage;
+        if (requestAllResultsInOneMessage(rResultVariables))
+        {
+            return true;
+        }
+        setLastError(chunkError);
+    }
+    return false;
+}
+
+//! @brief Request logged results, the results are transferred and decoded in chunks
+//! @param[in] rVariableNames Full names or aliases of the variables to request, a trailing * matches any suffix, empty requests all
+//! @param[in] decimation Only transfer every decimation:th logged sample
+//! @param[in] encoding The transfer encoding, one of ResultEncodingEnumT
+//! @param[out] rResultVariables The received variables
+bool RemoteHopsanClient::requestSimulationResults(const std::vector<std::string> &rVariableNames, const int decimation, const int encoding,
+                                                  std::vector<ResultVariableT> &rResultVariables)
+{
+    std::lock_guard<std::mutex> lock(mWorkerMutex);
+
+    bool firstRequestRejected = false;
+    return requestResultChunks(rVariableNames, decimation, encoding, rResultVariables, firstRequestRejected);
+}
+
+//! @brief Request all logged results in one message, supported by all workers
+//! @note The worker mutex must be locked by the caller
+bool RemoteHopsanClient::requestAllResultsInOneMessage(std::vector<ResultVariableT> &rResultVariables)
+{
     sendClientMessage<string>(mpWorkerSocket, RequestResults, "*"); // Request all
 
     zmq::message_t response;
     if (receiveWithTimeout(*mpWorkerSocket, response, mLongReceiveTimeout))
     {
-        //cout << "Response size: " << response.size() << endl;
         size_t offset=0;
         bool parseOK;
         size_t id = getMessageId(response, offset, parseOK);
@@ -551,6 +588,93 @@ bool RemoteHopsanClient::requestSimulationResults(std::vector<ResultVariableT> &
     return false;
 }
 
+//! @brief Request logged results in chunks
+//! @param[out] rFirstRequestRejected Set to true if the worker replied NotAck to the first request, e.g. if it does not support chunked transfer
+//! @note The worker mutex must be locked by the caller
+bool RemoteHopsanClient::requestResultChunks(const std::vector<std::string> &rVariableNames, const int decimation, const int encoding,
+                                             std::vector<ResultVariableT> &rResultVariables, bool &rFirstRequestRejected)
+{
+    rFirstRequestRejected = false;
+    rResultVariables.clear();
+    ReqmsgRequestResultsChunk request;
+    request.variables = rVariableNames;
+    request.decimation = decimation;
+    request.encoding = encoding;
+    request.maxsamples = mMaxResultChunkSamples;
+
+    bool isLastPart = false;
+    while (!isLastPart)
+    {
+        sendClientMessage(mpWorkerSocket, RequestResultsChunk, request);
+
+        zmq::message_t response;
+        if (!receiveWithTimeout(*mpWorkerSocket, response, mLongReceiveTimeout))
+        {
+            setLastError("Timeout while receiving results");
+            return false;
+        }
+
+        size_t offset=0;
+        bool parseOK;
+        size_t id = getMessageId(response, offset, parseOK);
+        if (id == NotAck)
+        {
+            rFirstRequestRejected = (request.variableoffset == 0) && (request.sampleoffset == 0);
+            setLastError(unpackMessage<string>(response, offset, parseOK));
+            return false;
+        }
+        else if (id != ReplyResultsChunk)
+        {
+            setLastError("Got wrong reply");
+            return false;
+        }
+
+        ReplymsgResultsChunk chunk = unpackMessage<ReplymsgResultsChunk>(response, offset, parseOK);
+        if (!parseOK)
+        {
+            setLastError("Could not parse results reply");
+            return false;
+        }
+        rResultVariables.resize(size_t(std::max(chunk.numvariables, 0)));
+
+        // Decode this chunk directly into the result variables
+        for (const ReplymsgResultsChunkVariable &rPart : chunk.variables)
+        {
+            if (rPart.index < 0 || size_t(rPart.index) >= rResultVariables.size())
+            {
+                setLastError("Got results for an unknown variable");
+                return false;
+            }
+            ResultVariableT &rVar = rResultVariables[size_t(rPart.index)];
+            if (rPart.sampleoffset == 0)
+            {
+                rVar.name = rPart.name;
+                rVar.alias = rPart.alias;
+                rVar.quantity = rPart.quantity;
+                rVar.unit = rPart.unit;
+                rVar.data.clear();
+                rVar.data.reserve(size_t(std::max(rPart.totalsamples, 0)));
+            }
+            if (size_t(rPart.sampleoffset) != rVar.data.size() ||
+                !decodeResultData(rPart.data, size_t(std::max(rPart.numsamples, 0)), chunk.encoding, rVar.data))
+            {
+                setLastError("Could not decode results for variable: "+rVar.name);
+                return false;
+            }
+        }
+
+        isLastPart = chunk.islastpart;
+        if (!isLastPart && (chunk.nextvariable == request.variableoffset) && (chunk.nextsample == request.sampleoffset))
+        {
+            setLastError("Result transfer did not make any progress");
+            return false;
+        }
+        request.variableoffset = chunk.nextvariable;
+        request.sampleoffset = chunk.nextsample;
+    }
+    return true;
+}
+
 bool RemoteHopsanClient::requestSlot(int numThreads, int &rControlPort, const std::string userid)
 {
     ReqmsgReqServerSlots msg {numThreads, userid};
@@ -1137,6 +1261,12 @@ void RemoteHopsanClient::setMaxWorkerStatusRequestWaitTime(double seconds)
     mMaxWorkerStatusRequestWaitTime = seconds;
 }
 
+//! @brief Set the maximum number of result samples (for all variables together) that the worker may send in one chunk
+void RemoteHopsanClient::setMaxResultChunkSamples(int numSamples)
+{
+    mMaxResultChunkSamples = std::max(numSamples, 1);
+}
+
 bool RemoteHopsanClient::connectToAddressServer(string address)
 {
     if (addressServerConnected())
@@ -28,6 +28,7 @@
 #define MESSAGES_H
 
 #include <string>
+#include <vector>
 #include "StatusInfoStructs.h"
 #include "DataStructs.h"
 #include "msgpack.hpp"
@@ -79,6 +80,10 @@ enum MessageIdsEnumT {
 
     /* Work in progress (last to avoid breaking compatibility */
     WorkerAlive,
+    WorkerIdle,
+    AssignWorker,
+    RequestResultsChunk,
+    ReplyResultsChunk,
 
 };
 
@@ -177,6 +182,27 @@ public:
     MSGPACK_DEFINE(username, password)
 };
 
+class CmdmsgAssignWorker
+{
+public:
+    int numThreads;
+    std::string userid;
+    MSGPACK_DEFINE(numThreads, userid)
+};
+
+class ReqmsgRequestResultsChunk
+{
+public:
+    std::vector<std::string> variables;  //!< Names or aliases to send, a trailing * matches any suffix, empty means all
+    int decimation = 1;                  //!< Send every n:th logged sample
+    int encoding = 0;                    //!< One of ResultEncodingEnumT
+    int maxsamples = 1000000;            //!< The maximum number of samples (all variables) in one chunk
+    int variableoffset = 0;              //!< The (filtered) variable to continue from
+    int sampleoffset = 0;                //!< The (decimated) sample to continue from
+
+    MSGPACK_DEFINE(variables, decimation, encoding, maxsamples, variableoffset, sampleoffset)
+};
+
 
 // Message structures for messages typically used by Servers
 
@@ -236,6 +262,35 @@ public:
     MSGPACK_DEFINE(name,alias,quantity,unit,data)
 };
 
+class ReplymsgResultsChunkVariable
+{
+public:
+    int index;              //!< The index of the variable among the filtered variables
+    std::string name;       //!< Only set in the first part of a variable
+    std::string alias;
+    std::string quantity;
+    std::string unit;
+    int totalsamples;       //!< The total number of (decimated) samples of the variable
+    int sampleoffset;       //!< The first sample in this part
+    int numsamples;         //!< The number of samples in this part
+    std::string data;       //!< The samples, encoded according to the chunk encoding
+
+    MSGPACK_DEFINE(index, name, alias, quantity, unit, totalsamples, sampleoffset, numsamples, data)
+};
+
+class ReplymsgResultsChunk
+{
+public:
+    int numvariables;       //!< The total number of variables matching the filter
+    int encoding;
+    int nextvariable;       //!< Where to continue in the next request
+    int nextsample;
+    bool islastpart;
+    std::vector<ReplymsgResultsChunkVariable> variables;
+
+    MSGPACK_DEFINE(numvariables, encoding, nextvariable, nextsample, islastpart, variables)
+};
+
 class ReplymsgReplyMessage
 {
 public:
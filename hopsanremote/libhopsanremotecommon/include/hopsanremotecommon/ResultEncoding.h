@@ -0,0 +1,48 @@
+/*-----------------------------------------------------------------------------
+
+ Copyright 2017 Hopsan Group
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+
+ The full license is available in the file LICENSE.
+ For details about the 'Hopsan Group' or information about Authors and
+ Contributors see the HOPSANGROUP and AUTHORS files that are located in
+ the Hopsan source code root directory.
+
+-----------------------------------------------------------------------------*/
+
+//$Id$
+
+#ifndef RESULTENCODING_H
+#define RESULTENCODING_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+//! @brief The encodings that can be used when transferring result data
+enum ResultEncodingEnumT {
+    ResultFloat64=0,    //!< Raw little-endian doubles (lossless)
+    ResultFloat32,      //!< Raw little-endian floats (lossy, half the size)
+    ResultXorFloat64    //!< Each double XORed with the previous one, leading and trailing zero bytes stripped (lossless)
+};
+
+bool isValidResultEncoding(int encoding);
+
+void encodeResultData(const double *pData, const size_t numSamples, const size_t stride, const int encoding, std::string &rEncoded);
+bool decodeResultData(const std::string &rEncoded, const size_t numSamples, const int encoding, std::vector<double> &rData);
+
+bool matchesVariableFilter(const std::string &rName, const std::string &rAlias, const std::vector<std::string> &rFilter);
+
+#endif // RESULTENCODING_H
@@ -15,7 +15,8 @@ DESTDIR = $${PWD}/../../lib
 INCLUDEPATH += $${PWD}/include
 
 SOURCES += \
-    src/FileAccess.cpp
+    src/FileAccess.cpp \
+    src/ResultEncoding.cpp
 
 
 HEADERS += \
@@ -24,4 +25,5 @@ HEADERS += \
     include/hopsanremotecommon/FileReceiver.hpp \
     include/hopsanremotecommon/Messages.h \
     include/hopsanremotecommon/MessageUtilities.h \
+    include/hopsanremotecommon/ResultEncoding.h \
     include/hopsanremotecommon/StatusInfoStructs.h
@@ -0,0 +1,236 @@
+/*-----------------------------------------------------------------------------
+
+ Copyright 2017 Hopsan Group
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+
+
+ The full license is available in the file LICENSE.
+ For details about the 'Hopsan Group' or information about Authors and
+ Contributors see the HOPSANGROUP and AUTHORS files that are located in
+ the Hopsan source code root directory.
+
+-----------------------------------------------------------------------------*/
+
+//$Id$
+
+#include "hopsanremotecommon/ResultEncoding.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+inline uint64_t doubleBits(const double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline double bitsDouble(const uint64_t bits)
+{
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+template<typename T>
+inline void appendLittleEndian(T value, std::string &rOut)
+{
+    for (size_t b=0; b<sizeof(T); ++b)
+    {
+        rOut.push_back(char(value & 0xFF));
+        value >>= 8;
+    }
+}
+
+template<typename T>
+inline T readLittleEndian(const unsigned char *pData)
+{
+    T value = 0;
+    for (size_t b=0; b<sizeof(T); ++b)
+    {
+        value |= T(pData[b]) << (8*b);
+    }
+    return value;
+}
+
+}
+
+bool isValidResultEncoding(int encoding)
+{
+    return (encoding == ResultFloat64) || (encoding == ResultFloat32) || (encoding == ResultXorFloat64);
+}
+
+//! @brief Encode result samples into a byte string
+//! @param[in] pData Pointer to the first sample
+//! @param[in] numSamples The number of samples to encode
+//! @param[in] stride The distance between two encoded samples in pData (used for decimation)
+//! @param[in] encoding The encoding to use, one of ResultEncodingEnumT
+//! @param[out] rEncoded The encoded data is appended to this string
+//! @details In the XOR encoding each sample is stored as one header byte, with the number of stripped trailing zero bytes
+//! in the high nibble and the number of remaining bytes in the low nibble, followed by the remaining bytes. Slowly varying
+//! or constant signals share most of their bits with the previous sample and shrink considerably.
+void encodeResultData(const double *pData, const size_t numSamples, const size_t stride, const int encoding, std::string &rEncoded)
+{
+    if (encoding == ResultFloat32)
+    {
+        rEncoded.reserve(rEncoded.size()+numSamples*sizeof(float));
+        for (size_t i=0; i<numSamples; ++i)
+        {
+            const float value = float(pData[i*stride]);
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            appendLittleEndian(bits, rEncoded);
+        }
+    }
+    else if (encoding == ResultXorFloat64)
+    {
+        rEncoded.reserve(rEncoded.size()+numSamples*3);
+        uint64_t prev = 0;
+        for (size_t i=0; i<numSamples; ++i)
+        {
+            const uint64_t bits = doubleBits(pData[i*stride]);
+            uint64_t x = bits ^ prev;
+            prev = bits;
+
+            unsigned char numTrailing=0;
+            while (x != 0 && (x & 0xFF) == 0)
+            {
+                x >>= 8;
+                ++numTrailing;
+            }
+            unsigned char numBytes=0;
+            for (uint64_t y=x; y!=0; y>>=8)
+            {
+                ++numBytes;
+            }
+
+            rEncoded.push_back(char((numTrailing << 4) | numBytes));
+            for (unsigned char b=0; b<numBytes; ++b)
+            {
+                rEncoded.push_back(char(x & 0xFF));
+                x >>= 8;
+            }
+        }
+    }
+    else
+    {
+        rEncoded.reserve(rEncoded.size()+numSamples*sizeof(double));
+        for (size_t i=0; i<numSamples; ++i)
+        {
+            appendLittleEndian(doubleBits(pData[i*stride]), rEncoded);
+        }
+    }
+}
+
+//! @brief Decode result samples encoded with encodeResultData
+//! @param[in] rEncoded The encoded data
+//! @param[in] numSamples The number of samples in the encoded data
+//! @param[in] encoding The encoding that was used, one of ResultEncodingEnumT
+//! @param[out] rData The decoded samples are appended to this vector
+//! @returns False if the encoded data does not match the number of samples or the encoding is unknown
+bool decodeResultData(const std::string &rEncoded, const size_t numSamples, const int encoding, std::vector<double> &rData)
+{
+    const unsigned char *pBytes = reinterpret_cast<const unsigned char*>(rEncoded.data());
+    const size_t numBytes = rEncoded.size();
+    rData.reserve(rData.size()+numSamples);
+
+    if (encoding == ResultFloat32)
+    {
+        if (numBytes != numSamples*sizeof(float))
+        {
+            return false;
+        }
+        for (size_t i=0; i<numSamples; ++i)
+        {
+            const uint32_t bits = readLittleEndian<uint32_t>(pBytes+i*sizeof(float));
+            float value;
+            memcpy(&value, &bits, sizeof(value));
+            rData.push_back(double(value));
+        }
+    }
+    else if (encoding == ResultXorFloat64)
+    {
+        uint64_t prev = 0;
+        size_t pos = 0;
+        for (size_t i=0; i<numSamples; ++i)
+        {
+            if (pos >= numBytes)
+            {
+                return false;
+            }
+            const unsigned char numTrailing = pBytes[pos] >> 4;
+            const unsigned char numSignificant = pBytes[pos] & 0x0F;
+            ++pos;
+            if (numTrailing+numSignificant > 8 || pos+numSignificant > numBytes)
+            {
+                return false;
+            }
+            uint64_t x = 0;
+            for (unsigned char b=0; b<numSignificant; ++b)
+            {
+                x |= uint64_t(pBytes[pos+b]) << (8*(b+numTrailing));
+            }
+            pos += numSignificant;
+            prev ^= x;
+            rData.push_back(bitsDouble(prev));
+        }
+        return (pos == numBytes);
+    }
+    else if (encoding == ResultFloat64)
+    {
+        if (numBytes != numSamples*sizeof(double))
+        {
+            return false;
+        }
+        for (size_t i=0; i<numSamples; ++i)
+        {
+            rData.push_back(bitsDouble(readLittleEndian<uint64_t>(pBytes+i*sizeof(double))));
+        }
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+//! @brief Check if a variable should be included in a result transfer
+//! @param[in] rName The full name of the variable
+//! @param[in] rAlias The alias of the variable (may be empty)
+//! @param[in] rFilter The requested names or aliases, a trailing * matches any suffix, an empty filter matches everything
+bool matchesVariableFilter(const std::string &rName, const std::string &rAlias, const std::vector<std::string> &rFilter)
+{
+    if (rFilter.empty())
+    {
+        return true;
+    }
+    for (const std::string &rPattern : rFilter)
+    {
+        if (!rPattern.empty() && rPattern.back() == '*')
+        {
+            const size_t n = rPattern.size()-1;
+            if (rName.compare(0, n, rPattern, 0, n) == 0 || (!rAlias.empty() && rAlias.compare(0, n, rPattern, 0, n) == 0))
+            {
+                return true;
+            }
+        }
+        else if (rPattern == rName || (!rAlias.empty() && rPattern == rAlias))
+        {
+            return true;
+        }
+    }
+    return false;
+}